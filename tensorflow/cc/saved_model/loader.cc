@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_pool.h"
 
 namespace tensorflow {
 namespace {
@@ -322,6 +323,10 @@ Status LoadSavedModel(const SessionOptions& session_options,
   if (status.ok()) {
     log_and_count(kLoadAttemptSuccess);
     metrics::SavedModelReadPath().Set(export_dir);
+    if (RestoredTensorPool::Global()->enabled()) {
+      metrics::SavedModelReadMatchedBytes().Set(
+          RestoredTensorPool::Global()->GetStats().matched_bytes);
+    }
   } else {
     log_and_count(kLoadAttemptFail);
   }
@@ -119,6 +119,14 @@ auto* saved_model_found_fingerprint_on_load =
         "Whether or not the fingerprint.pb file was found when loading the "
         "SavedModel.");
 
+// Gauge that contains the number of bytes of restored tensors that matched
+// identical tensors of previously loaded SavedModels and were served by their
+// buffers.
+auto* saved_model_read_matched_bytes = monitoring::Gauge<int64_t, 0>::New(
+    "/tensorflow/core/saved_model/read/matched_bytes",
+    "The number of bytes of restored weights that matched weights of "
+    "previously loaded SavedModels.");
+
 // Distribution of checkpoint write durations.
 auto* checkpoint_write_durations = monitoring::Sampler<1>::New(
     {
@@ -267,6 +275,10 @@ monitoring::GaugeCell<std::string>& SavedModelFoundFingerprintOnLoad() {
   return *saved_model_found_fingerprint_on_load->GetCell();
 }
 
+monitoring::GaugeCell<int64_t>& SavedModelReadMatchedBytes() {
+  return *saved_model_read_matched_bytes->GetCell();
+}
+
 monitoring::SamplerCell& CheckpointReadDuration(absl::string_view api_label) {
   return *checkpoint_read_durations->GetCell(std::string(api_label));
 }
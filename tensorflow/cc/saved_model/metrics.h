@@ -105,6 +105,15 @@ ParseSavedModelPathAndSingleprint(std::string path_and_singleprint);
 // found when loading the SavedModel.
 monitoring::GaugeCell<std::string>& SavedModelFoundFingerprintOnLoad();
 
+// Returns "/tensorflow/core/saved_model/read/matched_bytes" cell, which
+// contains the total number of bytes of restored tensors that matched an
+// identical tensor of a previously loaded SavedModel and were served by its
+// buffer, since process start. This bounds the memory saved by deduplication:
+// matched tensors may still be copied later, e.g. when a variable is assigned,
+// and the count isn't reduced when buffers are released. Only populated when
+// restored tensor deduplication is enabled (see RestoredTensorPool).
+monitoring::GaugeCell<int64_t>& SavedModelReadMatchedBytes();
+
 // Returns "/tensorflow/core/checkpoint/read/read_durations" cell belonging to
 // field `api_label`.
 monitoring::SamplerCell& CheckpointReadDuration(absl::string_view api_label);
@@ -149,6 +149,12 @@ TEST(MetricsTest, TestReadPathAndSingleprint) {
   EXPECT_EQ(singleprint, "singleprint");
 }
 
+TEST(MetricsTest, TestReadMatchedBytes) {
+  EXPECT_EQ(SavedModelReadMatchedBytes().value(), 0);
+  SavedModelReadMatchedBytes().Set(1024);
+  EXPECT_EQ(SavedModelReadMatchedBytes().value(), 1024);
+}
+
 TEST(MetricsTest, TestMakeFingerprintJson) {
   FingerprintDef fingerprint;
   fingerprint.set_saved_model_checksum(1);
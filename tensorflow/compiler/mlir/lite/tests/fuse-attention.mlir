@@ -0,0 +1,76 @@
+// RUN: tf-opt %s -tfl-fuse-attention | FileCheck %s
+
+// CHECK-LABEL: FuseScaledMaskedAttention
+func.func @FuseScaledMaskedAttention(%arg0: tensor<1x8x16x64xf32>, %arg1: tensor<1x8x32x64xf32>, %arg2: tensor<1x8x32x48xf32>, %arg3: tensor<1x1x16x32xf32>) -> tensor<1x8x16x48xf32> {
+  %cst = arith.constant dense<1.250000e-01> : tensor<f32>
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true, asymmetric_quantize_inputs = false} : (tensor<1x8x16x64xf32>, tensor<1x8x32x64xf32>) -> tensor<1x8x16x32xf32>
+  %1 = "tfl.mul"(%0, %cst) {fused_activation_function = "NONE"} : (tensor<1x8x16x32xf32>, tensor<f32>) -> tensor<1x8x16x32xf32>
+  %2 = "tfl.add"(%1, %arg3) {fused_activation_function = "NONE"} : (tensor<1x8x16x32xf32>, tensor<1x1x16x32xf32>) -> tensor<1x8x16x32xf32>
+  %3 = "tfl.softmax"(%2) {beta = 1.000000e+00 : f32} : (tensor<1x8x16x32xf32>) -> tensor<1x8x16x32xf32>
+  %4 = "tfl.batch_matmul"(%3, %arg2) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<1x8x16x32xf32>, tensor<1x8x32x48xf32>) -> tensor<1x8x16x48xf32>
+  func.return %4 : tensor<1x8x16x48xf32>
+  // CHECK: %[[RES:.*]] = "tfl.custom"(%arg0, %arg1, %arg2, %arg3) {custom_code = "FusedAttention", custom_option = #tfl<const_bytes : "0x{{.*}}">} : (tensor<1x8x16x64xf32>, tensor<1x8x32x64xf32>, tensor<1x8x32x48xf32>, tensor<1x1x16x32xf32>) -> tensor<1x8x16x48xf32>
+  // CHECK-NOT: "tfl.softmax"
+  // CHECK: return %[[RES]]
+}
+
+// CHECK-LABEL: FuseTransposedKeyAndDivideByScale
+func.func @FuseTransposedKeyAndDivideByScale(%arg0: tensor<2x4x8x16xf32>, %arg1: tensor<2x4x8x16xf32>, %arg2: tensor<2x4x8x16xf32>) -> tensor<2x4x8x16xf32> {
+  %perm = arith.constant dense<[0, 1, 3, 2]> : tensor<4xi32>
+  %cst = arith.constant dense<4.000000e+00> : tensor<f32>
+  %0 = "tfl.transpose"(%arg1, %perm) : (tensor<2x4x8x16xf32>, tensor<4xi32>) -> tensor<2x4x16x8xf32>
+  %1 = "tfl.batch_matmul"(%arg0, %0) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<2x4x8x16xf32>, tensor<2x4x16x8xf32>) -> tensor<2x4x8x8xf32>
+  %2 = "tfl.div"(%1, %cst) {fused_activation_function = "NONE"} : (tensor<2x4x8x8xf32>, tensor<f32>) -> tensor<2x4x8x8xf32>
+  %3 = "tfl.softmax"(%2) {beta = 1.000000e+00 : f32} : (tensor<2x4x8x8xf32>) -> tensor<2x4x8x8xf32>
+  %4 = "tfl.batch_matmul"(%3, %arg2) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<2x4x8x8xf32>, tensor<2x4x8x16xf32>) -> tensor<2x4x8x16xf32>
+  func.return %4 : tensor<2x4x8x16xf32>
+  // CHECK: %[[RES:.*]] = "tfl.custom"(%arg0, %arg1, %arg2) {custom_code = "FusedAttention"
+  // CHECK-NOT: "tfl.transpose"
+  // CHECK: return %[[RES]]
+}
+
+// CHECK-LABEL: FuseCausalMaskIntoOption
+func.func @FuseCausalMaskIntoOption(%arg0: tensor<1x2x3x4xf32>, %arg1: tensor<1x2x3x4xf32>, %arg2: tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32> {
+  %mask = arith.constant dense<[[0.0, -1.0e+09, -1.0e+09], [0.0, 0.0, -1.0e+09], [0.0, 0.0, 0.0]]> : tensor<3x3xf32>
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true, asymmetric_quantize_inputs = false} : (tensor<1x2x3x4xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x3xf32>
+  %1 = "tfl.add"(%0, %mask) {fused_activation_function = "NONE"} : (tensor<1x2x3x3xf32>, tensor<3x3xf32>) -> tensor<1x2x3x3xf32>
+  %2 = "tfl.softmax"(%1) {beta = 1.000000e+00 : f32} : (tensor<1x2x3x3xf32>) -> tensor<1x2x3x3xf32>
+  %3 = "tfl.batch_matmul"(%2, %arg2) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<1x2x3x3xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32>
+  func.return %3 : tensor<1x2x3x4xf32>
+  // CHECK: "tfl.custom"(%arg0, %arg1, %arg2) {custom_code = "FusedAttention"
+  // CHECK-SAME: (tensor<1x2x3x4xf32>, tensor<1x2x3x4xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32>
+}
+
+// With more queries than keys, the first query attends to no key, so the
+// mask is passed to the fused op instead.
+// CHECK-LABEL: KeepMaskWithMoreQueriesThanKeys
+func.func @KeepMaskWithMoreQueriesThanKeys(%arg0: tensor<1x2x3x4xf32>, %arg1: tensor<1x2x2x4xf32>, %arg2: tensor<1x2x2x4xf32>) -> tensor<1x2x3x4xf32> {
+  %mask = arith.constant dense<[[-1.0e+09, -1.0e+09], [0.0, -1.0e+09], [0.0, 0.0]]> : tensor<3x2xf32>
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true, asymmetric_quantize_inputs = false} : (tensor<1x2x3x4xf32>, tensor<1x2x2x4xf32>) -> tensor<1x2x3x2xf32>
+  %1 = "tfl.add"(%0, %mask) {fused_activation_function = "NONE"} : (tensor<1x2x3x2xf32>, tensor<3x2xf32>) -> tensor<1x2x3x2xf32>
+  %2 = "tfl.softmax"(%1) {beta = 1.000000e+00 : f32} : (tensor<1x2x3x2xf32>) -> tensor<1x2x3x2xf32>
+  %3 = "tfl.batch_matmul"(%2, %arg2) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<1x2x3x2xf32>, tensor<1x2x2x4xf32>) -> tensor<1x2x3x4xf32>
+  func.return %3 : tensor<1x2x3x4xf32>
+  // CHECK: "tfl.custom"(%arg0, %arg1, %arg2, %{{.*}}) {custom_code = "FusedAttention"
+  // CHECK-SAME: tensor<3x2xf32>
+}
+
+// The scores are also returned, so they have to be materialized anyway.
+// CHECK-LABEL: DontFuseWhenScoresAreUsed
+func.func @DontFuseWhenScoresAreUsed(%arg0: tensor<1x2x3x4xf32>, %arg1: tensor<1x2x3x4xf32>, %arg2: tensor<1x2x3x4xf32>) -> (tensor<1x2x3x4xf32>, tensor<1x2x3x3xf32>) {
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true, asymmetric_quantize_inputs = false} : (tensor<1x2x3x4xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x3xf32>
+  %1 = "tfl.softmax"(%0) {beta = 1.000000e+00 : f32} : (tensor<1x2x3x3xf32>) -> tensor<1x2x3x3xf32>
+  %2 = "tfl.batch_matmul"(%1, %arg2) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<1x2x3x3xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32>
+  func.return %2, %1 : tensor<1x2x3x4xf32>, tensor<1x2x3x3xf32>
+  // CHECK-NOT: "tfl.custom"
+  // CHECK: "tfl.softmax"
+}
+
+// CHECK-LABEL: DontFuseSoftmaxWithBeta
+func.func @DontFuseSoftmaxWithBeta(%arg0: tensor<1x2x3x4xf32>, %arg1: tensor<1x2x3x4xf32>, %arg2: tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32> {
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true, asymmetric_quantize_inputs = false} : (tensor<1x2x3x4xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x3xf32>
+  %1 = "tfl.softmax"(%0) {beta = 5.000000e-01 : f32} : (tensor<1x2x3x3xf32>) -> tensor<1x2x3x3xf32>
+  %2 = "tfl.batch_matmul"(%1, %arg2) {adj_x = false, adj_y = false, asymmetric_quantize_inputs = false} : (tensor<1x2x3x3xf32>, tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32>
+  func.return %2 : tensor<1x2x3x4xf32>
+  // CHECK-NOT: "tfl.custom"
+}
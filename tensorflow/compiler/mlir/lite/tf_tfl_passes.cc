@@ -420,6 +420,13 @@ void AddPostVariableFreezingTFToTFLConversionPasses(
     pass_manager->addNestedPass<mlir::func::FuncOp>(
         mlir::TFL::CreateOptimizePass(/*enable_canonicalization=*/true,
                                       toco_flags.disable_fuse_mul_and_fc()));
+    if (toco_flags.enable_attention_fusion() &&
+        !pass_config.unfold_batch_matmul) {
+      // Attention is only fused from BatchMatMul ops, which are unrolled when
+      // `unfold_batch_matmul=true`.
+      pass_manager->addNestedPass<mlir::func::FuncOp>(
+          mlir::TFL::CreateFuseAttentionPass());
+    }
 
     // This pass operates on TensorFlow ops but is triggered after legalization
     // so that it can target constants introduced once TensorFlow Identity ops
@@ -203,3 +203,10 @@ opt<bool> reduce_type_precision(
                    "within the reduced precision range. This could have side "
                    "effects triggered by downstream packing algorithms."),
     llvm::cl::init(false));
+
+// NOLINTNEXTLINE
+opt<bool> enable_attention_fusion(
+    "enable-attention-fusion",
+    llvm::cl::desc("Fuse scaled dot-product attention into the FusedAttention "
+                   "custom op."),
+    llvm::cl::init(false));
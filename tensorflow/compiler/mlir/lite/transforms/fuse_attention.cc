@@ -0,0 +1,289 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// This pass fuses the scaled dot-product attention of transformer layers,
+//   BatchMatMul(Softmax(Add(Mul(BatchMatMul(query, key^T), scale), mask)),
+//               value),
+// into the FusedAttention custom op of the TFLite runtime, which computes it
+// without materializing the [query_length, key_length] scores.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // from @llvm-project
+#include "mlir/IR/BuiltinAttributes.h"  // from @llvm-project
+#include "mlir/IR/BuiltinTypes.h"  // from @llvm-project
+#include "mlir/IR/Matchers.h"  // from @llvm-project
+#include "mlir/IR/PatternMatch.h"  // from @llvm-project
+#include "mlir/IR/Value.h"  // from @llvm-project
+#include "mlir/Pass/Pass.h"  // from @llvm-project
+#include "mlir/Pass/PassRegistry.h"  // from @llvm-project
+#include "mlir/Support/LogicalResult.h"  // from @llvm-project
+#include "mlir/Support/TypeID.h"  // from @llvm-project
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"  // from @llvm-project
+#include "tensorflow/compiler/mlir/lite/ir/tfl_ops.h"
+#include "tensorflow/compiler/mlir/lite/transforms/passes.h"
+
+namespace mlir {
+namespace TFL {
+namespace {
+#define GEN_PASS_DEF_FUSEATTENTIONPASS
+#include "tensorflow/compiler/mlir/lite/transforms/passes.h.inc"
+
+constexpr char kFusedAttention[] = "FusedAttention";
+
+class FuseAttentionPass
+    : public impl::FuseAttentionPassBase<FuseAttentionPass> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(FuseAttentionPass)
+
+  FuseAttentionPass() = default;
+  FuseAttentionPass(const FuseAttentionPass&) {}
+
+  void runOnOperation() override;
+};
+
+// Returns the static float32 type of rank 4 of `value`, or null.
+RankedTensorType GetAttentionOperandType(Value value) {
+  auto type = value.getType().dyn_cast<RankedTensorType>();
+  if (!type || type.getRank() != 4 || !type.hasStaticShape() ||
+      !type.getElementType().isF32()) {
+    return nullptr;
+  }
+  return type;
+}
+
+// Returns true if `value` is a float splat constant, and sets `splat`.
+bool MatchFloatSplat(Value value, float* splat) {
+  DenseFPElementsAttr attr;
+  if (!matchPattern(value, m_Constant(&attr)) || !attr.isSplat() ||
+      !attr.getElementType().isF32()) {
+    return false;
+  }
+  *splat = attr.getSplatValue<float>();
+  return true;
+}
+
+// Returns true if the last two dimensions of `value` are swapped by a
+// tfl.transpose, and sets `input` to the operand of the transpose.
+bool MatchTransposeOfLastDims(Value value, Value* input) {
+  auto transpose = value.getDefiningOp<TransposeOp>();
+  DenseIntElementsAttr perm;
+  if (!transpose || !transpose->hasOneUse() ||
+      !matchPattern(transpose.getPerm(), m_Constant(&perm))) {
+    return false;
+  }
+  const llvm::SmallVector<int64_t, 4> expected = {0, 1, 3, 2};
+  if (perm.getNumElements() != 4) return false;
+  int i = 0;
+  for (const APInt& dim : perm.getValues<APInt>()) {
+    if (dim.getSExtValue() != expected[i++]) return false;
+  }
+  *input = transpose.getInput();
+  return true;
+}
+
+// Returns true if the float32 `mask` can be broadcast to `scores_shape`.
+bool IsBroadcastableMask(Value mask, llvm::ArrayRef<int64_t> scores_shape) {
+  auto type = mask.getType().dyn_cast<RankedTensorType>();
+  if (!type || !type.hasStaticShape() || !type.getElementType().isF32() ||
+      type.getRank() > 4) {
+    return false;
+  }
+  const int offset = 4 - type.getRank();
+  for (int i = 0; i < type.getRank(); ++i) {
+    const int64_t dim = type.getDimSize(i);
+    if (dim != 1 && dim != scores_shape[offset + i]) return false;
+  }
+  return true;
+}
+
+// Returns true if `mask` is a constant [..., query_length, key_length] mask
+// that only lets query i attend to keys up to i + key_length - query_length,
+// with 0 for these keys and a score low enough for the softmax to underflow
+// for the others. With more queries than keys, the first queries would attend
+// to no key, which the causal mask of the fused op doesn't reproduce.
+bool IsCausalMask(Value mask, int64_t query_length, int64_t key_length) {
+  if (query_length > key_length) return false;
+  DenseFPElementsAttr attr;
+  if (!matchPattern(mask, m_Constant(&attr)) ||
+      !attr.getElementType().isF32()) {
+    return false;
+  }
+  auto type = attr.getType().cast<ShapedType>();
+  const int rank = type.getRank();
+  if (rank < 2 || type.getDimSize(rank - 2) != query_length ||
+      type.getDimSize(rank - 1) != key_length ||
+      type.getNumElements() != query_length * key_length) {
+    return false;
+  }
+  const int64_t offset = key_length - query_length;
+  int64_t index = 0;
+  for (float value : attr.getValues<float>()) {
+    const int64_t i = index / key_length;
+    const int64_t j = index % key_length;
+    ++index;
+    if (j <= i + offset ? value != 0.0f : value > -1e4f) return false;
+  }
+  return true;
+}
+
+bool HasNoActivation(Operation* op) {
+  auto activation = op->getAttrOfType<StringAttr>("fused_activation_function");
+  return activation && activation.getValue() == "NONE";
+}
+
+// Fuses BatchMatMul(Softmax(scores), value) where the scores are
+// BatchMatMul(query, key^T), optionally multiplied or divided by a scalar and
+// then added to a mask. The key is transposed with adj_y or a tfl.transpose.
+struct FuseScaledDotProductAttention : public OpRewritePattern<BatchMatMulOp> {
+  using OpRewritePattern<BatchMatMulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(BatchMatMulOp output_matmul,
+                                PatternRewriter& rewriter) const override {
+    if (output_matmul.getAdjX() || output_matmul.getAdjY()) return failure();
+    auto softmax = output_matmul.getX().getDefiningOp<SoftmaxOp>();
+    if (!softmax || !softmax->hasOneUse() ||
+        !softmax.getBeta().isExactlyValue(1.0)) {
+      return failure();
+    }
+
+    Value scores = softmax.getInput();
+    Value mask;
+    if (auto add = scores.getDefiningOp<AddOp>()) {
+      if (!add->hasOneUse() || !HasNoActivation(add)) return failure();
+      // The mask is whichever operand isn't computed from the query.
+      if (add.getLhs().getDefiningOp<BatchMatMulOp>() ||
+          add.getLhs().getDefiningOp<MulOp>() ||
+          add.getLhs().getDefiningOp<DivOp>()) {
+        scores = add.getLhs();
+        mask = add.getRhs();
+      } else {
+        scores = add.getRhs();
+        mask = add.getLhs();
+      }
+    }
+
+    float scale = 1.0f;
+    if (auto mul = scores.getDefiningOp<MulOp>()) {
+      if (!mul->hasOneUse() || !HasNoActivation(mul)) return failure();
+      if (MatchFloatSplat(mul.getRhs(), &scale)) {
+        scores = mul.getLhs();
+      } else if (MatchFloatSplat(mul.getLhs(), &scale)) {
+        scores = mul.getRhs();
+      } else {
+        return failure();
+      }
+    } else if (auto div = scores.getDefiningOp<DivOp>()) {
+      float divisor;
+      if (!div->hasOneUse() || !HasNoActivation(div) ||
+          !MatchFloatSplat(div.getRhs(), &divisor) || divisor == 0.0f) {
+        return failure();
+      }
+      scale = 1.0f / divisor;
+      scores = div.getLhs();
+    }
+    // The kernel takes a negative scale as the default of 1/sqrt(depth).
+    if (scale < 0.0f) return failure();
+
+    auto scores_matmul = scores.getDefiningOp<BatchMatMulOp>();
+    if (!scores_matmul || !scores_matmul->hasOneUse() ||
+        scores_matmul.getAdjX()) {
+      return failure();
+    }
+    Value query = scores_matmul.getX();
+    Value key = scores_matmul.getY();
+    if (!scores_matmul.getAdjY() && !MatchTransposeOfLastDims(key, &key)) {
+      return failure();
+    }
+    Value value = output_matmul.getY();
+
+    // The query is [batches, heads, query_length, depth], the key
+    // [batches, kv_heads, key_length, depth] and the value
+    // [batches, kv_heads, key_length, value_depth], where BatchMatMul only
+    // broadcasts a single key and value head.
+    RankedTensorType query_type = GetAttentionOperandType(query);
+    RankedTensorType key_type = GetAttentionOperandType(key);
+    RankedTensorType value_type = GetAttentionOperandType(value);
+    auto output_type = output_matmul.getType().dyn_cast<RankedTensorType>();
+    if (!query_type || !key_type || !value_type || !output_type ||
+        !output_type.getElementType().isF32()) {
+      return failure();
+    }
+    llvm::ArrayRef<int64_t> query_shape = query_type.getShape();
+    llvm::ArrayRef<int64_t> key_shape = key_type.getShape();
+    llvm::ArrayRef<int64_t> value_shape = value_type.getShape();
+    if (key_shape[0] != query_shape[0] || value_shape[0] != query_shape[0] ||
+        key_shape[3] != query_shape[3] || value_shape[2] != key_shape[2] ||
+        value_shape[1] != key_shape[1] ||
+        (key_shape[1] != query_shape[1] && key_shape[1] != 1)) {
+      return failure();
+    }
+    const llvm::SmallVector<int64_t, 4> scores_shape = {
+        query_shape[0], query_shape[1], query_shape[2], key_shape[2]};
+    if (mask && !IsBroadcastableMask(mask, scores_shape)) return failure();
+    // A constant causal mask is computed by the kernel instead, which also
+    // skips the masked keys.
+    const bool causal =
+        mask && IsCausalMask(mask, query_shape[2], key_shape[2]);
+    if (causal) mask = nullptr;
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      fbb.Float("scale", scale);
+      fbb.Bool("causal", causal);
+    });
+    fbb.Finish();
+    const std::vector<uint8_t>& options = fbb.GetBuffer();
+    auto custom_option = ConstBytesAttr::get(
+        rewriter.getContext(),
+        StringRef(reinterpret_cast<const char*>(options.data()),
+                  options.size()));
+
+    llvm::SmallVector<Value, 4> operands = {query, key, value};
+    if (mask) operands.push_back(mask);
+    auto fused = rewriter.create<CustomOp>(
+        output_matmul.getLoc(), TypeRange{output_type}, operands,
+        kFusedAttention, custom_option);
+    rewriter.replaceOp(output_matmul, fused.getResults());
+    return success();
+  }
+};
+
+void FuseAttentionPass::runOnOperation() {
+  auto func = getOperation();
+  RewritePatternSet patterns(&getContext());
+  patterns.add<FuseScaledDotProductAttention>(&getContext());
+  (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
+}
+
+}  // namespace
+
+std::unique_ptr<OperationPass<func::FuncOp>> CreateFuseAttentionPass() {
+  return std::make_unique<FuseAttentionPass>();
+}
+
+static PassRegistration<FuseAttentionPass> pass;
+
+}  // namespace TFL
+}  // namespace mlir
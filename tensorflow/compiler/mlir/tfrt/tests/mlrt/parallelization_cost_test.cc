@@ -0,0 +1,99 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // from @llvm-project
+#include "mlir/IR/BuiltinOps.h"  // from @llvm-project
+#include "mlir/IR/MLIRContext.h"  // from @llvm-project
+#include "mlir/Parser/Parser.h"  // from @llvm-project
+#include "mlir/Pass/PassManager.h"  // from @llvm-project
+#include "mlir/Support/LogicalResult.h"  // from @llvm-project
+#include "tensorflow/compiler/mlir/tensorflow/ir/tf_ops.h"
+#include "tensorflow/compiler/mlir/tfrt/ir/mlrt/mlrt_dialect.h"
+#include "tensorflow/compiler/mlir/tfrt/ir/mlrt/mlrt_ops.h"
+#include "tensorflow/compiler/mlir/tfrt/ir/mlrt/tf_mlrt_ops.h"
+#include "tensorflow/compiler/mlir/tfrt/transforms/mlrt/parallelization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/tfrt/fallback/cost_recorder.h"
+#include "tensorflow/core/tfrt/fallback/op_cost_map.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// Two independent chains of four ops each. The static cost estimate of each op
+// is a few units, far below the cost threshold used below.
+constexpr char kModule[] = R"mlir(
+func.func @main(%a: tensor<i32>, %b: tensor<i32>) -> tensor<i32> {
+  %a0 = "tf.AddV2"(%a, %a) {__op_key = 0 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %a1 = "tf.AddV2"(%a0, %a) {__op_key = 1 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %a2 = "tf.AddV2"(%a1, %a) {__op_key = 2 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %a3 = "tf.AddV2"(%a2, %a) {__op_key = 3 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %b0 = "tf.Sub"(%b, %b) {__op_key = 4 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %b1 = "tf.Sub"(%b0, %b) {__op_key = 5 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %b2 = "tf.Sub"(%b1, %b) {__op_key = 6 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %b3 = "tf.Sub"(%b2, %b) {__op_key = 7 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  %c = "tf.AddV2"(%a3, %b3) {__op_key = 8 : i32} : (tensor<i32>, tensor<i32>) -> tensor<i32>
+  func.return %c : tensor<i32>
+}
+)mlir";
+
+constexpr uint64_t kCostThreshold = 1000;
+
+// Parallelizes `kModule` with the costs in `cost_recorder`, and returns the
+// number of streams launched with mlrt.async.
+int CountAsyncStreams(const tfrt_stub::CostRecorder* cost_recorder) {
+  mlir::DialectRegistry registry;
+  registry.insert<mlir::func::FuncDialect, mlir::TF::TensorFlowDialect,
+                  mlrt::compiler::MlrtDialect,
+                  tensorflow::tf_mlrt::TensorflowMlrtDialect>();
+  mlir::MLIRContext context(registry);
+  auto module = mlir::parseSourceString<mlir::ModuleOp>(kModule, &context);
+  if (!module) return -1;
+
+  mlir::PassManager pm(&context);
+  pm.addPass(mlrt_compiler::CreateParallelizationPass(
+      kCostThreshold, /*merge_inter_dependent_streams=*/false, cost_recorder));
+  if (mlir::failed(pm.run(module.get()))) return -1;
+
+  int num_async_streams = 0;
+  module->walk([&](mlrt::compiler::AsyncOp) { ++num_async_streams; });
+  return num_async_streams;
+}
+
+TEST(ParallelizationCostTest, ReplayedCostsSplitStreams) {
+  // Without recorded costs, both chains are cheap and run in one stream.
+  EXPECT_EQ(CountAsyncStreams(/*cost_recorder=*/nullptr), 0);
+
+  // Replay a cost map in which every op is expensive.
+  OpCostMapProto op_cost_map_proto;
+  for (int64_t op_key = 0; op_key <= 8; ++op_key) {
+    (*op_cost_map_proto.mutable_op_cost_map())[op_key] = kCostThreshold;
+  }
+  std::string op_cost_map_path;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&op_cost_map_path));
+  TF_ASSERT_OK(
+      WriteTextProto(Env::Default(), op_cost_map_path, op_cost_map_proto));
+  tfrt_stub::CostRecorder cost_recorder;
+  TF_ASSERT_OK(cost_recorder.ReadFromFile(op_cost_map_path));
+
+  // With the replayed costs, one chain is split into its own stream.
+  EXPECT_EQ(CountAsyncStreams(&cost_recorder), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -29,14 +29,17 @@ namespace mlrt_compiler {
 
 // Converts an MLIR `module` in TF dialect to MLRT's bytecode format. If
 // `module_with_op_keys` is non-null, the intermediate module on which passes
-// until (including) AssignOpKeyPass have run will be cloned to it.
+// until (including) AssignOpKeyPass have run will be cloned to it. If
+// `cost_recorder` is non-null, e.g. when replaying costs recorded in a previous
+// run, its op costs are used for Stream Analysis.
 //
 // This is for initial conversion.
 StatusOr<mlrt::bc::Buffer> ConvertTfMlirToBytecode(
     const TfrtCompileOptions& options, tfrt_stub::FallbackState& fallback_state,
     mlir::ModuleOp module, tfrt_stub::ModelRuntimeContext& model_context,
     mlir::OwningOpRef<mlir::ModuleOp>* module_with_op_keys = nullptr,
-    std::vector<std::string>* added_xla_function_names = nullptr);
+    std::vector<std::string>* added_xla_function_names = nullptr,
+    const tfrt_stub::CostRecorder* cost_recorder = nullptr);
 
 // Converts an MLIR `module_with_op_keys` in TF dialect to MLRT's bytecode
 // format, with op costs from `cost_recorder`.
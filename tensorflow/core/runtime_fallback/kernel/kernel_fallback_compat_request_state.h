@@ -181,6 +181,16 @@ class KernelFallbackCompatRequestState {
     return runtime_config_;
   }
 
+  // Nullable. If set, stateless kernels created by this request are shared
+  // with other models through this cache.
+  tfrt_stub::SharedOpKernelCache* shared_op_kernel_cache() const {
+    return shared_op_kernel_cache_;
+  }
+  void set_shared_op_kernel_cache(
+      tfrt_stub::SharedOpKernelCache* shared_op_kernel_cache) {
+    shared_op_kernel_cache_ = shared_op_kernel_cache;
+  }
+
  private:
   int64_t step_id_ = 0;
   // Below are resources needed by current tensorflow.
@@ -223,6 +233,8 @@ class KernelFallbackCompatRequestState {
   tfrt::ResourceContext* client_graph_resource_context_ = nullptr;
 
   const tensorflow::tfrt_stub::RuntimeConfig* runtime_config_ = nullptr;
+
+  tfrt_stub::SharedOpKernelCache* shared_op_kernel_cache_ = nullptr;
 };
 
 // Set up fallback context with common tensorflow states such as devices,
@@ -557,7 +557,8 @@ tfrt::AsyncValueRef<tfrt::Chain> KernelFallbackCreateOp(
   auto statusor_runner = OpKernelRunner::Create(
       op_name, ToAbslStringView(device.GetValue()), num_args.GetValue(),
       attr_builder, fallback_request_state->device_manager(),
-      fallback_request_state->process_function_library_runtime());
+      fallback_request_state->process_function_library_runtime(),
+      fallback_request_state->shared_op_kernel_cache());
   if (!statusor_runner.ok())
     return tfrt::EmitErrorAsync(exec_ctx, statusor_runner.status());
 
@@ -213,7 +213,8 @@ Expected<CoreRuntimeOp> KernelFallbackOpHandler::MakeOp(string_view op_name) {
             },
             fallback_op_entry.fallback_request_state->device_manager(),
             fallback_op_entry.fallback_request_state
-                ->process_function_library_runtime());
+                ->process_function_library_runtime(),
+            fallback_op_entry.fallback_request_state->shared_op_kernel_cache());
 
         if (!kernel_runner_or_status.ok()) {
           propagate_error(kernel_runner_or_status.status());
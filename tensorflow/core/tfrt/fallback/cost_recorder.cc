@@ -18,6 +18,7 @@ limitations under the License.
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
@@ -51,21 +52,41 @@ uint64_t CostRecorder::GetCost(int64_t op_key) const {
   return r;
 }
 
-Status CostRecorder::WriteToFile() const {
+OpCostMapProto CostRecorder::ToOpCostMap() const {
   OpCostMapProto op_cost_map_proto;
-  {
-    tf_shared_lock l(op_cost_map_mutex_);
-    for (const auto& [op_key, op_cost] : op_cost_map_) {
-      const uint64_t avg_op_cost = op_cost.first / op_cost.second;
-      (*op_cost_map_proto.mutable_op_cost_map())[op_key] = avg_op_cost;
-    }
+  tf_shared_lock l(op_cost_map_mutex_);
+  for (const auto& [op_key, op_cost] : op_cost_map_) {
+    const uint64_t avg_op_cost = op_cost.first / op_cost.second;
+    (*op_cost_map_proto.mutable_op_cost_map())[op_key] = avg_op_cost;
   }
+  return op_cost_map_proto;
+}
 
+Status CostRecorder::WriteToFile() const {
   std::string measured_cost_path;
   TF_RETURN_IF_ERROR(ReadStringFromEnvVar(MesuredCostPathEnvVarName(), "",
                                           &measured_cost_path));
   return tensorflow::WriteTextProto(tensorflow::Env::Default(),
-                                    measured_cost_path, op_cost_map_proto);
+                                    measured_cost_path, ToOpCostMap());
+}
+
+void CostRecorder::ApplyOpCostMap(const OpCostMapProto& op_cost_map_proto) {
+  mutex_lock l(op_cost_map_mutex_);
+  for (const auto& [op_key, op_cost] : op_cost_map_proto.op_cost_map()) {
+    auto& [total_cost, num_ops] = op_cost_map_[op_key];
+    total_cost += op_cost;
+    num_ops += 1;
+  }
+}
+
+Status CostRecorder::ReadFromFile(absl::string_view path) {
+  OpCostMapProto op_cost_map_proto;
+  TF_RETURN_IF_ERROR(tensorflow::ReadTextProto(
+      tensorflow::Env::Default(), std::string(path), &op_cost_map_proto));
+  ApplyOpCostMap(op_cost_map_proto);
+  LOG(INFO) << "TFRT applied " << op_cost_map_proto.op_cost_map_size()
+            << " recorded op costs from " << path;
+  return OkStatus();
 }
 
 size_t CostRecorder::size() const {
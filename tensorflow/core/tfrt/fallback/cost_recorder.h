@@ -21,9 +21,11 @@ limitations under the License.
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/tfrt/fallback/op_cost_map.pb.h"
 
 namespace tensorflow {
 namespace tfrt_stub {
@@ -42,11 +44,24 @@ class CostRecorder {
   // otherwise adding op costs would cause overflow.
   uint64_t GetCost(int64_t op_key) const;
 
+  // Returns the average execution duration of each op in the recorder.
+  OpCostMapProto ToOpCostMap() const;
+
   // Writes the op cost map (in format of `OpCostMapProto`) to a file specified
   // by the env var name `MesuredCostPathEnvVarName()`.
   // TODO(b/263837451): Fix the op_key unstableness during serialization.
   Status WriteToFile() const;
 
+  // Seeds the recorder with the average costs in `op_cost_map_proto`, e.g.
+  // ones written by `WriteToFile()` in a previous run of the same model. Each
+  // seeded cost counts as a single measurement, so that costs recorded later
+  // are averaged with it.
+  void ApplyOpCostMap(const OpCostMapProto& op_cost_map_proto);
+
+  // Reads the op cost map (in format of `OpCostMapProto`) from `path` and
+  // applies it to the recorder.
+  Status ReadFromFile(absl::string_view path);
+
   size_t size() const;
 
   static const char* MesuredCostPathEnvVarName() {
@@ -98,6 +98,53 @@ TEST(CostRecorderTest, ProtoRecordsTest) {
             kTestAvgCost);
 }
 
+TEST(CostRecorderTest, ApplyOpCostMapTest) {
+  OpCostMapProto op_cost_map_proto;
+  (*op_cost_map_proto.mutable_op_cost_map())[kTestOpKey] = kTestCost;
+
+  CostRecorder recorder;
+  recorder.ApplyOpCostMap(op_cost_map_proto);
+  ASSERT_EQ(recorder.size(), 1);
+  EXPECT_EQ(recorder.GetCost(kTestOpKey), kTestCost);
+
+  // The applied cost counts as one measurement.
+  recorder.RecordCost(kTestOpKey, 2 * kTestCost);
+  EXPECT_EQ(recorder.GetCost(kTestOpKey), kTestAvgCost);
+}
+
+TEST(CostRecorderTest, ToOpCostMapTest) {
+  CostRecorder recorder;
+  recorder.RecordCost(kTestOpKey, kTestCost);
+  recorder.RecordCost(kTestOpKey, 2 * kTestCost);
+
+  const OpCostMapProto op_cost_map_proto = recorder.ToOpCostMap();
+  ASSERT_EQ(op_cost_map_proto.op_cost_map_size(), 1);
+  EXPECT_EQ(op_cost_map_proto.op_cost_map().at(kTestOpKey), kTestAvgCost);
+}
+
+TEST(CostRecorderTest, ReadFromFileTest) {
+  CostRecorder recorder;
+  recorder.RecordCost(kTestOpKey, kTestCost);
+
+  std::string measured_cost_path;
+  tensorflow::Env::Default()->LocalTempFilename(&measured_cost_path);
+  ASSERT_EQ(setenv(CostRecorder::MesuredCostPathEnvVarName(),
+                   measured_cost_path.c_str(), 1),
+            0);
+  TF_CHECK_OK(recorder.WriteToFile());
+
+  CostRecorder replayed_recorder;
+  TF_CHECK_OK(replayed_recorder.ReadFromFile(measured_cost_path));
+  ASSERT_EQ(replayed_recorder.size(), 1);
+  EXPECT_EQ(replayed_recorder.GetCost(kTestOpKey), kTestCost);
+}
+
+TEST(CostRecorderTest, ReadFromMissingFileTest) {
+  CostRecorder recorder;
+  EXPECT_FALSE(recorder.ReadFromFile("/nonexistent/op_cost_map.pbtxt").ok());
+  EXPECT_EQ(recorder.size(), 0);
+}
+
 }  // namespace
 }  // namespace tfrt_stub
 }  // namespace tensorflow
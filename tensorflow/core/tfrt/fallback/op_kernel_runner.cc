@@ -14,17 +14,27 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/errors.h"
 
 namespace tensorflow {
 namespace tfrt_stub {
 namespace {
 
+auto* shared_op_kernel_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/tfrt/fallback/shared_op_kernel_cache/lookups",
+    "The number of lookups in the process-wide cache of stateless OpKernels "
+    "shared across models. The shared-hit ratio is hit / (hit + miss).",
+    "result");
+
 Status CheckOpDefCompatibility(const tensorflow::OpDef& op_def) {
   auto check_arg_def = [&](const auto& arg_def) {
     if (arg_def.is_ref())
@@ -89,7 +99,8 @@ StatusOr<OpKernelRunner> OpKernelRunner::Create(
     const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
     const tensorflow::DeviceMgr& device_manager,
     const tensorflow::ProcessFunctionLibraryRuntime&
-        process_function_library_runtime) {
+        process_function_library_runtime,
+    SharedOpKernelCache* shared_kernel_cache) {
   tensorflow::Device* device = nullptr;
   Status s = device_manager.LookupDevice(device_name, &device);
 
@@ -103,7 +114,7 @@ StatusOr<OpKernelRunner> OpKernelRunner::Create(
   }
 
   return Create(op_name, node_name, num_args, attr_builder,
-                process_function_library_runtime, device);
+                process_function_library_runtime, device, shared_kernel_cache);
 }
 
 StatusOr<OpKernelRunner> OpKernelRunner::Create(
@@ -111,7 +122,7 @@ StatusOr<OpKernelRunner> OpKernelRunner::Create(
     const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
     const tensorflow::ProcessFunctionLibraryRuntime&
         process_function_library_runtime,
-    tensorflow::Device* device) {
+    tensorflow::Device* device, SharedOpKernelCache* shared_kernel_cache) {
   const OpDef* op_def = nullptr;
   TF_RETURN_IF_ERROR(tensorflow::OpRegistry::Global()->LookUpOpDef(
       std::string(op_name), &op_def));
@@ -130,6 +141,18 @@ StatusOr<OpKernelRunner> OpKernelRunner::Create(
   function_library_runtime =
       process_function_library_runtime.GetFLR(device->name());
 
+  if (shared_kernel_cache != nullptr &&
+      SharedOpKernelCache::IsShareable(*op_def, node_def, *device)) {
+    TF_ASSIGN_OR_RETURN(
+        auto op_kernel,
+        shared_kernel_cache->GetOrCreate(
+            node_def, *device, [&](std::unique_ptr<OpKernel>* result) {
+              return CreateOpKernel(function_library_runtime, node_def, result);
+            }));
+    return OpKernelRunner(device, function_library_runtime,
+                          std::move(op_kernel));
+  }
+
   std::unique_ptr<OpKernel> op_kernel;
   TF_RETURN_IF_ERROR(CreateOpKernel(function_library_runtime,
                                     std::move(node_def), &op_kernel));
@@ -139,7 +162,7 @@ StatusOr<OpKernelRunner> OpKernelRunner::Create(
 OpKernelRunner::OpKernelRunner(
     tensorflow::Device* device,
     tensorflow::FunctionLibraryRuntime* function_library_runtime,
-    std::unique_ptr<tensorflow::OpKernel> op_kernel)
+    std::shared_ptr<tensorflow::OpKernel> op_kernel)
     : op_kernel_(std::move(op_kernel)), info_(std::make_unique<Info>()) {
   DCHECK(device);
   DCHECK(function_library_runtime);
@@ -185,5 +208,79 @@ void OpKernelRunner::RunAsync(OpKernelContext* context,
   async->ComputeAsync(context, std::move(done_callback));
 }
 
+SharedOpKernelCache* SharedOpKernelCache::Global() {
+  static auto* const cache = new SharedOpKernelCache();
+  return cache;
+}
+
+bool SharedOpKernelCache::IsShareable(const OpDef& op_def,
+                                      const NodeDef& node_def,
+                                      const Device& device) {
+  if (op_def.is_stateful()) return false;
+
+  // Kernels of other devices may hold on to the device they are created on,
+  // eg. its streams or allocators, which belong to the device manager of one
+  // model.
+  if (device.device_type() != DEVICE_CPU) return false;
+
+  // Kernels with function attributes hold function handles that are specific
+  // to the function library of their model.
+  for (const auto& [name, attr_value] : node_def.attr()) {
+    if (attr_value.has_func() || attr_value.list().func_size() > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+StatusOr<std::shared_ptr<OpKernel>> SharedOpKernelCache::GetOrCreate(
+    const NodeDef& node_def, const Device& device,
+    const std::function<Status(std::unique_ptr<OpKernel>*)>& create_fn) {
+  NodeDef canonical_node_def = node_def;
+  canonical_node_def.clear_name();
+  std::string key;
+  if (!SerializeToStringDeterministic(canonical_node_def, &key)) {
+    return errors::Internal("Failed to serialize NodeDef of ", node_def.op());
+  }
+  absl::StrAppend(&key, "@", device.name(), "@", device.device_type());
+
+  {
+    mutex_lock lock(mu_);
+    auto it = kernels_.find(key);
+    if (it != kernels_.end()) {
+      if (auto op_kernel = it->second.lock()) {
+        shared_op_kernel_cache_lookups->GetCell("hit")->IncrementBy(1);
+        return op_kernel;
+      }
+    }
+  }
+
+  // Create the kernel without holding the lock, so that loading models in
+  // parallel is not serialized.
+  std::unique_ptr<OpKernel> new_op_kernel;
+  TF_RETURN_IF_ERROR(create_fn(&new_op_kernel));
+
+  mutex_lock lock(mu_);
+  auto& entry = kernels_[key];
+  if (auto op_kernel = entry.lock()) {
+    // Another model created the same kernel in the meantime.
+    shared_op_kernel_cache_lookups->GetCell("hit")->IncrementBy(1);
+    return op_kernel;
+  }
+  shared_op_kernel_cache_lookups->GetCell("miss")->IncrementBy(1);
+  std::shared_ptr<OpKernel> op_kernel = std::move(new_op_kernel);
+  entry = op_kernel;
+  return op_kernel;
+}
+
+int64_t SharedOpKernelCache::NumKernels() const {
+  mutex_lock lock(mu_);
+  int64_t num_kernels = 0;
+  for (const auto& [key, op_kernel] : kernels_) {
+    if (!op_kernel.expired()) ++num_kernels;
+  }
+  return num_kernels;
+}
+
 }  // namespace tfrt_stub
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
@@ -34,20 +35,27 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace tfrt_stub {
 
+class SharedOpKernelCache;
+
 class OpKernelRunner {
  public:
+  // If `shared_kernel_cache` is not nullptr, stateless kernels are looked up in
+  // and added to it, so that identical kernels are shared across models.
   static StatusOr<OpKernelRunner> Create(
       absl::string_view op_name, absl::string_view node_name,
       absl::string_view device_name, int num_args,
       const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
       const tensorflow::DeviceMgr& device_manager,
       const tensorflow::ProcessFunctionLibraryRuntime&
-          process_function_library_runtime);
+          process_function_library_runtime,
+      SharedOpKernelCache* shared_kernel_cache = nullptr);
 
   ABSL_DEPRECATED("Please use the Create() method that takes node_name.")
   static StatusOr<OpKernelRunner> Create(
@@ -66,7 +74,8 @@ class OpKernelRunner {
       const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
       const tensorflow::ProcessFunctionLibraryRuntime&
           process_function_library_runtime,
-      tensorflow::Device* device);
+      tensorflow::Device* device,
+      SharedOpKernelCache* shared_kernel_cache = nullptr);
 
   ABSL_DEPRECATED("Please use the Create() method that takes node_name.")
   static StatusOr<OpKernelRunner> Create(
@@ -119,9 +128,11 @@ class OpKernelRunner {
   explicit OpKernelRunner(
       tensorflow::Device* device,
       tensorflow::FunctionLibraryRuntime* function_library_runtime,
-      std::unique_ptr<OpKernel> op_kernel);
+      std::shared_ptr<OpKernel> op_kernel);
 
-  std::unique_ptr<OpKernel> op_kernel_;
+  // The kernel may be shared with runners of other models through
+  // SharedOpKernelCache.
+  std::shared_ptr<OpKernel> op_kernel_;
   absl::Span<const AllocatorAttributes> input_alloc_attrs_;
   absl::Span<const AllocatorAttributes> output_alloc_attrs_;
 
@@ -218,6 +229,50 @@ class OpKernelRunnerTable {
   std::vector<OpKernelRunner> runners_;
 };
 
+// SharedOpKernelCache shares OpKernel instances of stateless ops across models,
+// eg. across the many versions of the same model served by one process, to
+// reduce the memory usage and the model load time. Kernels are keyed by their
+// NodeDef without the node name and by the device name and type, which are the
+// same for every model in the process even though each model has its own
+// device manager. They are reference counted by the OpKernelRunners using
+// them, and a kernel is destroyed together with the last runner using it.
+//
+// Only kernels that do not depend on the model or device instance they are
+// created for are shared: CPU kernels of stateless ops without function
+// attributes. Such kernels take the device, the function library and the
+// resource manager from the OpKernelContext of each run, so a runner keeps its
+// own. Note that a shared kernel keeps the node name of the first model that
+// created it.
+//
+// This class is thread-safe.
+class SharedOpKernelCache {
+ public:
+  // Returns the process-wide instance.
+  static SharedOpKernelCache* Global();
+
+  SharedOpKernelCache() = default;
+  SharedOpKernelCache(const SharedOpKernelCache&) = delete;
+  SharedOpKernelCache& operator=(const SharedOpKernelCache&) = delete;
+
+  // Returns true if the kernel of `node_def` on `device` can be shared.
+  static bool IsShareable(const OpDef& op_def, const NodeDef& node_def,
+                          const Device& device);
+
+  // Returns the cached kernel of `node_def` on `device`. If there is none, a
+  // kernel is created with `create_fn` and added to the cache.
+  StatusOr<std::shared_ptr<OpKernel>> GetOrCreate(
+      const NodeDef& node_def, const Device& device,
+      const std::function<Status(std::unique_ptr<OpKernel>*)>& create_fn);
+
+  // Returns the number of cached kernels that are still in use.
+  int64_t NumKernels() const;
+
+ private:
+  mutable mutex mu_;
+  absl::flat_hash_map<std::string, std::weak_ptr<OpKernel>> kernels_
+      TF_GUARDED_BY(mu_);
+};
+
 }  // namespace tfrt_stub
 }  // namespace tensorflow
 
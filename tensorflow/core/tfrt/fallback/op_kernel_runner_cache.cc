@@ -30,7 +30,8 @@ StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
     const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
     const tensorflow::DeviceMgr& device_manager,
     const tensorflow::ProcessFunctionLibraryRuntime&
-        process_function_library_runtime) {
+        process_function_library_runtime,
+    SharedOpKernelCache* shared_kernel_cache) {
   OpLocationKey key(loc);
   {
     tf_shared_lock lock(mu_);
@@ -56,9 +57,11 @@ StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
       op_name, "_", loc.data, "_", absl::bit_cast<uintptr_t>(loc.GetHandler()));
 
   TF_ASSIGN_OR_RETURN(
-      auto runner, OpKernelRunner::Create(
-                       op_name, node_name, device_name, num_args, attr_builder,
-                       device_manager, process_function_library_runtime));
+      auto runner,
+      OpKernelRunner::Create(op_name, node_name, device_name, num_args,
+                             attr_builder, device_manager,
+                             process_function_library_runtime,
+                             shared_kernel_cache));
 
   auto runner_uptr = std::make_unique<OpKernelRunner>(std::move(runner));
 
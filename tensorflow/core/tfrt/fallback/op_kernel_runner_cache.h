@@ -51,13 +51,16 @@ class OpKernelRunnerCache {
  public:
   OpKernelRunnerCache() = default;
 
+  // If `shared_kernel_cache` is not nullptr, the kernels of new runners are
+  // shared with other models through it, see OpKernelRunner::Create().
   StatusOr<OpKernelRunner*> GetOrCreate(
       tfrt::Location loc, absl::string_view op_name,
       absl::string_view device_name, int num_args,
       const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
       const tensorflow::DeviceMgr& device_manager,
       const tensorflow::ProcessFunctionLibraryRuntime&
-          process_function_library_runtime);
+          process_function_library_runtime,
+      SharedOpKernelCache* shared_kernel_cache = nullptr);
 
  private:
   mutable mutex mu_;
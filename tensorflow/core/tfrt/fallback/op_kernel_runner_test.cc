@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/tfrt/fallback/fallback_state.h"
@@ -34,9 +35,13 @@ namespace tensorflow {
 namespace tfrt_stub {
 namespace {
 
+using ::tensorflow::monitoring::testing::CellReader;
 using ::testing::IsNull;
 using ::testing::SizeIs;
 
+constexpr char kSharedOpKernelCacheLookups[] =
+    "/tensorflow/tfrt/fallback/shared_op_kernel_cache/lookups";
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 constexpr const char* kDeviceType = "GPU";
 #else
@@ -60,6 +65,26 @@ REGISTER_KERNEL_BUILDER(Name("TestOp").Device(DEVICE_CPU), TestOpKernel);
 // not have `f` attribute. Users will not invoke this op directly.
 REGISTER_OP("TestOp").Input("x: int32").Output("y: int32");
 
+REGISTER_KERNEL_BUILDER(Name("TestStatefulOp").Device(DEVICE_CPU),
+                        TestOpKernel);
+
+REGISTER_OP("TestStatefulOp")
+    .Input("x: int32")
+    .Output("y: int32")
+    .SetIsStateful();
+
+StatusOr<OpKernelRunner> CreateRunnerWithSharedKernel(
+    absl::string_view op_name, absl::string_view node_name,
+    const FallbackState& fallback_state, SharedOpKernelCache* cache) {
+  return OpKernelRunner::Create(
+      op_name, node_name,
+      /*device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0",
+      /*num_args=*/1,
+      /*attr_builder=*/[](tensorflow::AttrValueMap*) { return OkStatus(); },
+      fallback_state.device_manager(),
+      fallback_state.process_function_library_runtime(), cache);
+}
+
 TEST(OpKernelRunnerTest, Create) {
   tensorflow::SessionOptions session_options;
   tensorflow::FunctionDefLibrary fdef_lib;
@@ -122,6 +147,121 @@ TEST(OpKernelRunnerTest, OpKernelRunnerCache) {
   EXPECT_EQ(runner->op_kernel()->name(), "TestOp_100_0");
 }
 
+TEST(OpKernelRunnerTest, SharedOpKernelCache) {
+  tensorflow::SessionOptions session_options;
+  tensorflow::FunctionDefLibrary fdef_lib;
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state,
+                          FallbackState::Create(session_options, fdef_lib));
+
+  CellReader<int64_t> lookups(kSharedOpKernelCacheLookups);
+  SharedOpKernelCache cache;
+
+  {
+    // Identical stateless kernels on the same device are shared, even if their
+    // node names differ.
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto runner1, CreateRunnerWithSharedKernel("TestOp", "model1_node",
+                                                   *fallback_state, &cache));
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto runner2, CreateRunnerWithSharedKernel("TestOp", "model2_node",
+                                                   *fallback_state, &cache));
+    EXPECT_EQ(runner1.op_kernel(), runner2.op_kernel());
+    EXPECT_EQ(runner2.op_kernel()->name(), "model1_node");
+    EXPECT_EQ(cache.NumKernels(), 1);
+    EXPECT_EQ(lookups.Delta("miss"), 1);
+    EXPECT_EQ(lookups.Delta("hit"), 1);
+  }
+
+  // The kernel is released together with the last runner using it.
+  EXPECT_EQ(cache.NumKernels(), 0);
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto runner, CreateRunnerWithSharedKernel("TestOp", "model3_node",
+                                                *fallback_state, &cache));
+  EXPECT_EQ(runner.op_kernel()->name(), "model3_node");
+  EXPECT_EQ(lookups.Delta("miss"), 1);
+  EXPECT_EQ(lookups.Delta("hit"), 0);
+}
+
+TEST(OpKernelRunnerTest, SharedOpKernelCacheSharesAcrossModels) {
+  tensorflow::SessionOptions session_options;
+  tensorflow::FunctionDefLibrary fdef_lib;
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state1,
+                          FallbackState::Create(session_options, fdef_lib));
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state2,
+                          FallbackState::Create(session_options, fdef_lib));
+
+  // Each model has its own device manager. The kernel is shared, but each
+  // runner keeps the device of its model.
+  SharedOpKernelCache cache;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto runner1, CreateRunnerWithSharedKernel("TestOp", "model1_node",
+                                                 *fallback_state1, &cache));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto runner2, CreateRunnerWithSharedKernel("TestOp", "model2_node",
+                                                 *fallback_state2, &cache));
+  EXPECT_EQ(runner1.op_kernel(), runner2.op_kernel());
+  EXPECT_NE(runner1.device(), runner2.device());
+  EXPECT_EQ(runner2.device(), fallback_state2->device_manager().HostCPU());
+  EXPECT_EQ(cache.NumKernels(), 1);
+}
+
+TEST(OpKernelRunnerTest, OpKernelRunnerCacheWithSharedOpKernelCache) {
+  tensorflow::SessionOptions session_options;
+  tensorflow::FunctionDefLibrary fdef_lib;
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state1,
+                          FallbackState::Create(session_options, fdef_lib));
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state2,
+                          FallbackState::Create(session_options, fdef_lib));
+
+  SharedOpKernelCache shared_cache;
+  auto get_or_create = [&](OpKernelRunnerCache& cache, tfrt::Location loc,
+                           const FallbackState& fallback_state) {
+    return cache.GetOrCreate(
+        loc,
+        /*op_name=*/"TestOp",
+        /*device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0",
+        /*num_args=*/1,
+        /*attr_builder=*/[](tensorflow::AttrValueMap*) { return OkStatus(); },
+        fallback_state.device_manager(),
+        fallback_state.process_function_library_runtime(), &shared_cache);
+  };
+
+  // The runner caches of two models share the kernel of the same op at
+  // different locations.
+  OpKernelRunnerCache cache1;
+  OpKernelRunnerCache cache2;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto* runner1,
+      get_or_create(cache1, tfrt::Location(/*handler=*/nullptr, /*data=*/100),
+                    *fallback_state1));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto* runner2,
+      get_or_create(cache2, tfrt::Location(/*handler=*/nullptr, /*data=*/200),
+                    *fallback_state2));
+  EXPECT_NE(runner1, runner2);
+  EXPECT_EQ(runner1->op_kernel(), runner2->op_kernel());
+  EXPECT_EQ(runner2->op_kernel()->name(), "TestOp_100_0");
+  EXPECT_EQ(shared_cache.NumKernels(), 1);
+}
+
+TEST(OpKernelRunnerTest, SharedOpKernelCacheSkipsStatefulOps) {
+  tensorflow::SessionOptions session_options;
+  tensorflow::FunctionDefLibrary fdef_lib;
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state,
+                          FallbackState::Create(session_options, fdef_lib));
+
+  SharedOpKernelCache cache;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto runner1, CreateRunnerWithSharedKernel("TestStatefulOp", "node1",
+                                                 *fallback_state, &cache));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto runner2, CreateRunnerWithSharedKernel("TestStatefulOp", "node2",
+                                                 *fallback_state, &cache));
+  EXPECT_NE(runner1.op_kernel(), runner2.op_kernel());
+  EXPECT_EQ(cache.NumKernels(), 0);
+}
+
 TEST(OpKernelRunnerTest, OpKernelRunState) {
   SessionOptions options;
   auto* device_count = options.config.mutable_device_count();
@@ -96,6 +96,12 @@ struct GraphExecutionOptions {
     // Number of times to record costs before resetting Op cost estimates.
     // However, a reset always occurs after the first execution.
     int updates_per_interval = 1;
+
+    // If non-empty, op costs recorded by a previous run of the same model (see
+    // `CostRecorder::WriteToFile()`) are replayed from this file. With MLRT,
+    // they are used to partition the initial executable into streams, and in
+    // all cases they seed the costs used by online cost analysis.
+    std::string op_cost_map_path;
   };
 
   CostAnalysisOptions cost_analysis_options;
@@ -104,6 +110,11 @@ struct GraphExecutionOptions {
   // This option is experimental.
   bool enable_mlrt = false;
 
+  // If true, the CPU kernels of stateless ops are shared with other models
+  // loaded in the same process that have identical ops, which reduces the
+  // memory usage and the load time when many versions of a model are served.
+  bool enable_shared_op_kernel_cache = false;
+
   tensorflow::TfrtCompileOptions compile_options;
 };
 
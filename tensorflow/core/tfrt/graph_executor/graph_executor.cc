@@ -219,7 +219,8 @@ StatusOr<std::unique_ptr<RequestInfo>> CreateRequestInfo(
     request_id = GetNextStepId().id;
     // Otherwise we use the global queue in `runtime`.
     TF_ASSIGN_OR_RETURN(request_info->request_queue_owner,
-                        runtime.CreateRequestQueue(request_id));
+                        runtime.CreateRequestQueue(request_id,
+                                                   run_options.priority));
     request_info->request_queue = request_info->request_queue_owner.get();
   }
   auto* request_queue = request_info->request_queue;
@@ -250,6 +251,10 @@ StatusOr<std::unique_ptr<RequestInfo>> CreateRequestInfo(
   fallback_request_state.set_client_graph_resource_context(
       client_graph_resource_context);
   fallback_request_state.set_runtime_config(&options.runtime_config);
+  if (options.enable_shared_op_kernel_cache) {
+    fallback_request_state.set_shared_op_kernel_cache(
+        SharedOpKernelCache::Global());
+  }
   fallback_request_state.set_cancellation_manager(
       &request_info->cancellation_manager);
 
@@ -488,14 +493,23 @@ StatusOr<std::unique_ptr<GraphExecutor>> GraphExecutor::Create(
   options.compile_options.fuse_get_resource_ops_in_hoisting =
       !options.enable_mlrt;
 
+  std::unique_ptr<CostRecorder> replayed_cost_recorder;
+  if (!options.cost_analysis_options.op_cost_map_path.empty()) {
+    replayed_cost_recorder = std::make_unique<CostRecorder>();
+    TF_RETURN_IF_ERROR(replayed_cost_recorder->ReadFromFile(
+        options.cost_analysis_options.op_cost_map_path));
+  }
+
   TF_ASSIGN_OR_RETURN(
       auto graph_execution_state,
       TfrtGraphExecutionState::Create(graph_execution_state_options,
                                       std::move(graph_def), *fallback_state));
-  return std::make_unique<GraphExecutor>(
+  auto graph_executor = std::make_unique<GraphExecutor>(
       std::move(options), std::move(fallback_state),
       std::move(resource_context), std::move(graph_execution_state),
       std::move(kernel_registry));
+  graph_executor->replayed_cost_recorder_ = std::move(replayed_cost_recorder);
+  return graph_executor;
 }
 
 namespace {
@@ -694,11 +708,14 @@ GraphExecutor::ImportAndCompileClientGraph(
       return tensorflow::errors::Internal("Missing kernel registry in MLRT.");
     }
 
+    // Partition the initial executable with the replayed costs if any.
     ASSIGN_OR_RETURN_IN_COMPILE(
         auto bytecode_buffer,
         tensorflow::mlrt_compiler::ConvertTfMlirToBytecode(
             options_.compile_options, fallback_state(), module.get(),
-            model_context, &module_with_op_keys));
+            model_context, &module_with_op_keys,
+            /*added_xla_function_names=*/nullptr,
+            replayed_cost_recorder_.get()));
     mlrt::bc::Executable executable(bytecode_buffer.data());
     auto bytecode_executable =
         std::make_unique<mlrt::LoadedExecutable>(executable, *kernel_registry_);
@@ -1072,6 +1089,10 @@ GraphExecutor::LoadedClientGraph::LoadedClientGraph(
     cost_analysis_data_.is_available = true;
     cost_analysis_data_.num_cost_updates = options.updates_per_interval - 1;
     cost_analysis_data_.cost_recorder = std::make_unique<CostRecorder>();
+    if (graph_executor_->replayed_cost_recorder_ != nullptr) {
+      cost_analysis_data_.cost_recorder->ApplyOpCostMap(
+          graph_executor_->replayed_cost_recorder_->ToOpCostMap());
+    }
     if (executable_context_->IsForMlrt()) {
       cost_analysis_data_.tf_mlir_with_op_keys =
           std::move(tf_mlir_with_op_keys);
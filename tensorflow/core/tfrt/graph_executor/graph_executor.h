@@ -348,6 +348,10 @@ class GraphExecutor {
 
   std::unique_ptr<tfrt::ResourceContext> resource_context_;
 
+  // The op costs read from `CostAnalysisOptions::op_cost_map_path`, or nullptr
+  // if no recorded costs are replayed.
+  std::unique_ptr<CostRecorder> replayed_cost_recorder_;
+
  protected:
   // For testing basic Cost Analysis functionality.
   absl::Duration simulated_duration_ = absl::ZeroDuration();
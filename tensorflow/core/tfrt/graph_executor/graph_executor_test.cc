@@ -31,8 +31,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/tfrt/fallback/op_cost_map.pb.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/context.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/value.h"
 #include "tensorflow/core/tfrt/mlrt/kernel/kernel.h"
@@ -254,6 +256,83 @@ TEST_P(GraphExecutorTest, OnlineCostAnalysisDisabled) {
   EXPECT_EQ(graph_executor->num_recompilations(), 0);
 }
 
+// Replays a recorded op cost map against the model. The op keys are assigned
+// in program order starting from 0, so the costs below cover every op.
+TEST_P(GraphExecutorTest, ReplayRecordedOpCosts) {
+  GraphDef graph_def;
+  TF_ASSERT_OK(GetSimpleGraphDef(graph_def));
+
+  OpCostMapProto op_cost_map_proto;
+  for (int64_t op_key = 0; op_key < 8; ++op_key) {
+    (*op_cost_map_proto.mutable_op_cost_map())[op_key] = 1000 * (op_key + 1);
+  }
+  std::string op_cost_map_path;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&op_cost_map_path));
+  TF_ASSERT_OK(
+      WriteTextProto(Env::Default(), op_cost_map_path, op_cost_map_proto));
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  GraphExecutor::Options options(runtime.get());
+  options.cost_analysis_options.version =
+      GraphExecutionOptions::CostAnalysisOptions::kOnce;
+  options.cost_analysis_options.op_cost_map_path = op_cost_map_path;
+  options.enable_mlrt = GetParam();
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto fallback_state,
+      tensorflow::tfrt_stub::FallbackState::Create(
+          CreateDefaultSessionOptions(options), graph_def.library()));
+  auto resource_context = std::make_unique<tfrt::ResourceContext>();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto graph_executor_base,
+      GraphExecutor::Create(std::move(options), std::move(fallback_state),
+                            std::move(resource_context), graph_def,
+                            GetKernelRegistry()));
+  auto graph_executor = std::unique_ptr<GraphExecutorForTestingCostAnalysis>(
+      static_cast<GraphExecutorForTestingCostAnalysis*>(
+          graph_executor_base.release()));
+
+  // Set input 'x' to [[1, 1, 1]]
+  std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+  inputs.push_back({"input", CreateTfTensor<int32_t>(
+                                 /*shape=*/{1, 3}, /*data=*/{1, 1, 1})});
+
+  // Both the executable compiled with the replayed costs and the one
+  // recompiled with the refined costs produce the same results.
+  for (int i = 0; i < 2; ++i) {
+    std::vector<tensorflow::Tensor> outputs;
+    TF_ASSERT_OK(graph_executor->Run(/*run_options=*/{}, inputs,
+                                     /*output_tensor_names=*/{"rank"},
+                                     /*target_tensor_names=*/{}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+                ::testing::ElementsAreArray({2}));
+  }
+  EXPECT_EQ(graph_executor->num_recompilations(), 1);
+}
+
+TEST_P(GraphExecutorTest, ReplayMissingOpCostMap) {
+  GraphDef graph_def;
+  TF_ASSERT_OK(GetSimpleGraphDef(graph_def));
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  GraphExecutor::Options options(runtime.get());
+  options.cost_analysis_options.op_cost_map_path =
+      "/nonexistent/op_cost_map.pbtxt";
+  options.enable_mlrt = GetParam();
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto fallback_state,
+      tensorflow::tfrt_stub::FallbackState::Create(
+          CreateDefaultSessionOptions(options), graph_def.library()));
+  auto resource_context = std::make_unique<tfrt::ResourceContext>();
+  EXPECT_THAT(
+      GraphExecutor::Create(std::move(options), std::move(fallback_state),
+                            std::move(resource_context), graph_def,
+                            GetKernelRegistry()),
+      StatusIs(absl::StatusCode::kNotFound));
+}
+
 TEST_P(GraphExecutorTest, OnlineCostAnalysisPeriodic) {
   GraphDef graph_def;
   TF_ASSERT_OK(GetSimpleGraphDef(graph_def));
@@ -670,7 +670,8 @@ void CreateOp::Invoke() {
                       return OkStatus();
                     },
                     fallback_request_state.device_manager(),
-                    fallback_request_state.process_function_library_runtime())
+                    fallback_request_state.process_function_library_runtime(),
+                    fallback_request_state.shared_op_kernel_cache())
                     .value();
 
   if (!fallback_request_state.runner_table()->Insert(op_key(),
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -48,6 +50,9 @@ namespace {
 typedef typename internal::RunHandlerEnvironment::Task Task;
 typedef Eigen::RunQueue<Task, 1024> Queue;
 
+// The pass increment of a source with weight 1 under priority scheduling.
+constexpr int64_t kPriorityStrideBase = int64_t{1} << 24;
+
 }  // namespace
 
 namespace internal {
@@ -140,6 +145,9 @@ ThreadWorkSource::ThreadWorkSource()
       blocking_inflight_(0),
       non_blocking_inflight_(0),
       pending_tasks_(0),
+      priority_(0),
+      pass_(0),
+      skip_count_(0),
       traceme_id_(0),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
@@ -331,13 +339,50 @@ unsigned ThreadWorkSource::NonBlockingWorkShardingFactor() {
   return non_blocking_work_sharding_factor_;
 }
 
+bool ThreadWorkSource::HasRunnableTask(bool may_steal_blocking_work,
+                                       int max_blocking_inflight) {
+  if (may_steal_blocking_work &&
+      GetInflightTaskCount(true) < max_blocking_inflight &&
+      TaskQueueSize(true) > 0) {
+    return true;
+  }
+  return TaskQueueSize(false) > 0;
+}
+
+void ThreadWorkSource::ResetSchedulingState(int priority, int64_t pass) {
+  priority_.store(priority, std::memory_order_relaxed);
+  pass_.store(pass, std::memory_order_relaxed);
+  skip_count_.store(0, std::memory_order_relaxed);
+}
+
+int ThreadWorkSource::GetPriority() {
+  return priority_.load(std::memory_order_relaxed);
+}
+
+int64_t ThreadWorkSource::GetPass() {
+  return pass_.load(std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::AdvancePass(int64_t stride) {
+  pass_.fetch_add(stride, std::memory_order_relaxed);
+}
+
+int64_t ThreadWorkSource::IncrementSkipCount() {
+  return skip_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void ThreadWorkSource::ResetSkipCount() {
+  skip_count_.store(0, std::memory_order_relaxed);
+}
+
 std::string ThreadWorkSource::ToString() {
   return tensorflow::strings::StrCat(
       "traceme_id = ", GetTracemeId(),
       ", inter queue size = ", TaskQueueSize(true),
       ", inter inflight = ", GetInflightTaskCount(true),
       ", intra queue size = ", TaskQueueSize(false),
-      ", intra inflight = ", GetInflightTaskCount(false));
+      ", intra inflight = ", GetInflightTaskCount(false),
+      ", priority = ", GetPriority(), ", pass = ", GetPass());
 }
 
 RunHandlerThreadPool::RunHandlerThreadPool(
@@ -356,6 +401,9 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       blocking_thread_max_waiting_time_(
           options.blocking_threads_max_sleep_time_micro_sec),
       enable_wake_up_(options.enable_wake_up),
+      enable_priority_scheduling_(options.enable_priority_scheduling),
+      max_priority_skips_(options.max_priority_skips),
+      virtual_time_(0),
       thread_data_(num_threads_),
       env_(env, thread_options, name),
       name_(name),
@@ -364,6 +412,11 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       num_threads_in_sub_thread_pool_(options.num_threads_in_sub_thread_pool),
       sub_thread_pool_end_request_percentage_(
           options.sub_thread_request_percentage) {
+  for (int priority = 0; priority <= kMaxPriorityClass; ++priority) {
+    const double weight = std::pow(options.priority_weight_factor, priority);
+    priority_strides_[priority] =
+        std::max<int64_t>(1, kPriorityStrideBase / weight);
+  }
   thread_data_.resize(num_threads_);
   for (int i = 0; i < num_threads_; ++i) {
     thread_data_[i].new_thread_work_sources =
@@ -483,6 +536,13 @@ Task RunHandlerThreadPool::FindTask(
     bool may_steal_blocking_work,
     const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
     bool* task_from_blocking_queue, ThreadWorkSource** tws) {
+  if (enable_priority_scheduling_) {
+    return FindTaskByPriority(searching_range_start, searching_range_end,
+                              thread_id, max_blocking_inflight,
+                              may_steal_blocking_work, thread_work_sources,
+                              task_from_blocking_queue, tws);
+  }
+
   Task t;
   int current_index = thread_data_[thread_id].current_index;
   *task_from_blocking_queue = false;
@@ -515,6 +575,76 @@ Task RunHandlerThreadPool::FindTask(
   return t;
 }
 
+Task RunHandlerThreadPool::FindTaskByPriority(
+    int searching_range_start, int searching_range_end, int thread_id,
+    int max_blocking_inflight, bool may_steal_blocking_work,
+    const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
+    bool* task_from_blocking_queue, ThreadWorkSource** tws) {
+  Task t;
+  *task_from_blocking_queue = false;
+
+  // Other threads may pop the task of the chosen source before us, so retry a
+  // bounded number of times before giving up.
+  for (int attempt = 0; attempt < searching_range_end - searching_range_start;
+       ++attempt) {
+    ThreadWorkSource* chosen = nullptr;
+    ThreadWorkSource* starving = nullptr;
+    int64_t min_pass = std::numeric_limits<int64_t>::max();
+    // The sources are sorted by priority, so on ties the higher priority
+    // source wins.
+    for (int i = searching_range_start; i < searching_range_end; ++i) {
+      ThreadWorkSource* source = thread_work_sources[i];
+      if (!source->HasRunnableTask(may_steal_blocking_work,
+                                   max_blocking_inflight)) {
+        continue;
+      }
+      int64_t pass = source->GetPass();
+      if (pass < min_pass) {
+        min_pass = pass;
+        chosen = source;
+      }
+      if (source->IncrementSkipCount() > max_priority_skips_ &&
+          starving == nullptr) {
+        starving = source;
+      }
+    }
+    if (chosen == nullptr) break;
+    // Starving sources are served out of order, and they do not move the
+    // virtual time, which tracks the smallest pass of the runnable sources.
+    if (starving != nullptr) {
+      chosen = starving;
+    } else {
+      virtual_time_.store(min_pass, std::memory_order_relaxed);
+    }
+    chosen->ResetSkipCount();
+
+    if (may_steal_blocking_work &&
+        chosen->GetInflightTaskCount(true) < max_blocking_inflight) {
+      t = chosen->PopBlockingTask();
+      if (t.f) {
+        *task_from_blocking_queue = true;
+      }
+    }
+    if (!t.f) {
+      t = chosen->PopNonBlockingTask(thread_id, true);
+    }
+    if (t.f) {
+      *tws = chosen;
+      chosen->AdvancePass(PriorityStride(chosen->GetPriority()));
+      break;
+    }
+  }
+  return t;
+}
+
+int64_t RunHandlerThreadPool::VirtualTime() const {
+  return virtual_time_.load(std::memory_order_relaxed);
+}
+
+int64_t RunHandlerThreadPool::PriorityStride(int priority) const {
+  return priority_strides_[std::clamp(priority, 0, kMaxPriorityClass)];
+}
+
 // Main worker thread loop.
 void RunHandlerThreadPool::WorkerLoop(int thread_id,
                                       bool may_steal_blocking_work) {
@@ -732,7 +862,9 @@ class RunHandlerPool::Impl {
                 options.use_adaptive_waiting_time, options.enable_wake_up,
                 options.max_concurrent_handler,
                 options.num_threads_in_sub_thread_pool,
-                options.sub_thread_request_percentage),
+                options.sub_thread_request_percentage,
+                options.enable_priority_scheduling,
+                options.priority_weight_factor, options.max_priority_skips),
             tensorflow::Env::Default(), tensorflow::ThreadOptions(),
             "tf_run_handler_pool", &waiters_mu_, &queue_waiters_)),
         iterations_(0),
@@ -1016,6 +1148,9 @@ void RunHandler::Impl::Reset(int64_t step_id,
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.ResetSchedulingState(
+      options.priority,
+      pool_impl_->run_handler_thread_pool()->VirtualTime());
 }
 
 int RunHandler::Impl::RunHandlerEigenThreadPool::NumThreads() const {
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_RUN_HANDLER_THREAD_POOL_RUN_HANDLER_H_
 #define TENSORFLOW_CORE_TFRT_RUN_HANDLER_THREAD_POOL_RUN_HANDLER_H_
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <functional>
@@ -42,6 +43,10 @@ namespace tf {
 
 class RunHandler;
 
+// The highest priority class distinguished by priority scheduling. Higher
+// priorities are treated as kMaxPriorityClass.
+inline constexpr int kMaxPriorityClass = 8;
+
 // Options for RunHanler.
 struct RunHandlerOptions {
   RunHandlerOptions() : priority(0) {}
@@ -108,6 +113,23 @@ class RunHandlerPool {
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // If true, threads pick the next task among all active requests using
+    // weighted fair sharing based on RunHandlerOptions::priority, instead of
+    // visiting the requests in a round robin fashion. The decision is made
+    // again at every task boundary, so a newly arrived high priority request
+    // takes over the next free thread from lower priority ones.
+    bool enable_priority_scheduling = false;
+
+    // With priority scheduling, a request with priority `p` gets a share of
+    // the threads proportional to `priority_weight_factor ^ p`. Priorities are
+    // clamped to [0, kMaxPriorityClass].
+    double priority_weight_factor = 4.0;
+
+    // With priority scheduling, a request that has runnable tasks and has been
+    // passed over this many times in a row is picked next regardless of its
+    // priority, which bounds the waiting time of low priority requests.
+    int max_priority_skips = 64;
   };
   explicit RunHandlerPool(Options options);
   ~RunHandlerPool();
@@ -255,6 +277,25 @@ class ThreadWorkSource {
 
   unsigned NonBlockingWorkShardingFactor();
 
+  // Returns true if a task can be popped from this source.
+  bool HasRunnableTask(bool may_steal_blocking_work, int max_blocking_inflight);
+
+  // The states below are only used by priority scheduling. `pass` is the
+  // virtual time of the source: the source with the smallest pass is served
+  // first, and its pass advances by a stride inversely proportional to its
+  // weight every time a task is taken from it.
+  void ResetSchedulingState(int priority, int64_t pass);
+
+  int GetPriority();
+
+  int64_t GetPass();
+
+  void AdvancePass(int64_t stride);
+
+  int64_t IncrementSkipCount();
+
+  void ResetSkipCount();
+
   std::string ToString();
 
  private:
@@ -274,6 +315,12 @@ class ThreadWorkSource {
   // The number of tasks that are enqueued and not finished.
   std::atomic<int64_t> pending_tasks_;
 
+  std::atomic<int> priority_;
+  std::atomic<int64_t> pass_;
+  // The number of consecutive tasks taken from other sources while this
+  // source had runnable tasks.
+  std::atomic<int64_t> skip_count_;
+
   Queue blocking_work_queue_;
   tensorflow::mutex blocking_queue_op_mu_;
   char pad_[128];
@@ -301,6 +348,9 @@ class RunHandlerThreadPool {
     int max_concurrent_handler;
     std::vector<int> num_threads_in_sub_thread_pool;
     std::vector<double> sub_thread_request_percentage;
+    bool enable_priority_scheduling;
+    double priority_weight_factor;
+    int max_priority_skips;
     Options(int num_blocking_threads, int num_non_blocking_threads,
             bool wait_if_no_active_request,
             int non_blocking_threads_sleep_time_micro_sec,
@@ -308,7 +358,9 @@ class RunHandlerThreadPool {
             bool use_adaptive_waiting_time, bool enable_wake_up,
             int max_concurrent_handler,
             const std::vector<int>& num_threads_in_sub_thread_pool,
-            const std::vector<double>& sub_thread_request_percentage)
+            const std::vector<double>& sub_thread_request_percentage,
+            bool enable_priority_scheduling = false,
+            double priority_weight_factor = 4.0, int max_priority_skips = 64)
         : num_blocking_threads(num_blocking_threads),
           num_non_blocking_threads(num_non_blocking_threads),
           wait_if_no_active_request(wait_if_no_active_request),
@@ -320,7 +372,10 @@ class RunHandlerThreadPool {
           enable_wake_up(enable_wake_up),
           max_concurrent_handler(max_concurrent_handler),
           num_threads_in_sub_thread_pool(num_threads_in_sub_thread_pool),
-          sub_thread_request_percentage(sub_thread_request_percentage) {}
+          sub_thread_request_percentage(sub_thread_request_percentage),
+          enable_priority_scheduling(enable_priority_scheduling),
+          priority_weight_factor(priority_weight_factor),
+          max_priority_skips(max_priority_skips) {}
   };
   struct PerThread {
     constexpr PerThread() : pool(nullptr), thread_id(-1) {}
@@ -369,6 +424,21 @@ class RunHandlerThreadPool {
       const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
       bool* task_from_blocking_queue, ThreadWorkSource** tws);
 
+  // Same as FindTask(), but picks the source with the smallest pass among the
+  // sources with runnable tasks, unless a source has been skipped more than
+  // max_priority_skips times. Used when priority scheduling is enabled.
+  Task FindTaskByPriority(
+      int searching_range_start, int searching_range_end, int thread_id,
+      int max_blocking_inflight, bool may_steal_blocking_work,
+      const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
+      bool* task_from_blocking_queue, ThreadWorkSource** tws);
+
+  // Returns the pass that a newly activated source should start from.
+  int64_t VirtualTime() const;
+
+  // Returns the pass increment of a source with `priority`.
+  int64_t PriorityStride(int priority) const;
+
   void WaitForWorkInSubThreadPool(int thread_id, bool is_blocking,
                                   int sub_thread_pool_id);
 
@@ -399,6 +469,14 @@ class RunHandlerThreadPool {
   const int non_blocking_thread_sleep_time_;
   const int blocking_thread_max_waiting_time_;
   const bool enable_wake_up_;
+  const bool enable_priority_scheduling_;
+  // The pass increment of each priority class, from priority_weight_factor.
+  std::array<int64_t, kMaxPriorityClass + 1> priority_strides_;
+  const int max_priority_skips_;
+  // The smallest pass among the runnable sources when a task was last picked.
+  // New sources start from here so that they neither starve others nor get
+  // starved by them.
+  std::atomic<int64_t> virtual_time_;
   Eigen::MaxSizeVector<ThreadData> thread_data_;
   internal::RunHandlerEnvironment env_;
   std::atomic<bool> cancelled_;
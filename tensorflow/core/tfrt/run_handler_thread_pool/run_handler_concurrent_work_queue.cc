@@ -56,12 +56,22 @@ RunHandlerThreadWorkQueue::RunHandlerThreadWorkQueue(const Options& options)
   pool_options.enable_wake_up = options.enable_wake_up;
   pool_options.wait_if_no_active_request = options.wait_if_no_active_request;
   pool_options.use_adaptive_waiting_time = options.use_adaptive_waiting_time;
+  pool_options.enable_priority_scheduling = options.enable_priority_scheduling;
+  pool_options.priority_weight_factor = options.priority_weight_factor;
+  pool_options.max_priority_skips = options.max_priority_skips;
   handler_pool_ = std::make_unique<RunHandlerPool>(pool_options);
 }
 
 tensorflow::StatusOr<std::unique_ptr<tensorflow::tfrt_stub::WorkQueueInterface>>
 RunHandlerThreadWorkQueue::InitializeRequest(int64_t request_id) const {
+  return InitializeRequest(request_id, /*priority=*/0);
+}
+
+tensorflow::StatusOr<std::unique_ptr<tensorflow::tfrt_stub::WorkQueueInterface>>
+RunHandlerThreadWorkQueue::InitializeRequest(int64_t request_id,
+                                             int priority) const {
   RunHandlerOptions options;
+  options.priority = priority;
   std::unique_ptr<RunHandler> handler =
       handler_pool_->Get(request_id, options_.init_timeout_ms, options);
   if (!handler) {
@@ -126,7 +136,11 @@ std::ostream& operator<<(std::ostream& strm,
               << options.use_adaptive_waiting_time
               << ", wait_if_no_active_request = "
               << options.wait_if_no_active_request
-              << ", enable_wake_up = " << options.enable_wake_up << "}";
+              << ", enable_wake_up = " << options.enable_wake_up
+              << ", enable_priority_scheduling = "
+              << options.enable_priority_scheduling
+              << ", priority_weight_factor = " << options.priority_weight_factor
+              << ", max_priority_skips = " << options.max_priority_skips << "}";
 }
 
 }  // namespace tf
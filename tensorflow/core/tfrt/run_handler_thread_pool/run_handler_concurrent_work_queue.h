@@ -79,6 +79,18 @@ class RunHandlerThreadWorkQueue
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // If true, requests share the threads based on their priorities. See
+    // RunHandlerPool::Options for details.
+    bool enable_priority_scheduling = false;
+
+    // The share of a request with priority `p` is proportional to
+    // `priority_weight_factor ^ p`.
+    double priority_weight_factor = 4.0;
+
+    // The number of times in a row a request with runnable tasks can be passed
+    // over before it is served regardless of its priority.
+    int max_priority_skips = 64;
   };
 
   explicit RunHandlerThreadWorkQueue(const Options& options);
@@ -95,6 +107,10 @@ class RunHandlerThreadWorkQueue
       std::unique_ptr<tensorflow::tfrt_stub::WorkQueueInterface>>
   InitializeRequest(int64_t request_id) const override;
 
+  tensorflow::StatusOr<
+      std::unique_ptr<tensorflow::tfrt_stub::WorkQueueInterface>>
+  InitializeRequest(int64_t request_id, int priority) const override;
+
   int GetParallelismLevel() const override {
     return options_.num_main_threads + options_.num_complementary_threads;
   }
@@ -13,7 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -31,10 +33,13 @@ limitations under the License.
 #include "absl/synchronization/barrier.h"
 #include "absl/synchronization/notification.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tfrt/host_context/task_function.h"  // from @tf_runtime
 
 namespace tfrt {
@@ -638,10 +643,277 @@ TEST_P(RunHandlerThreadPoolTest, MultipleSubThreadPool) {
   delete run_handler_thread_pool;
 }
 
+internal::RunHandlerThreadPool::Options PrioritySchedulingOptions(
+    int max_priority_skips) {
+  return internal::RunHandlerThreadPool::Options(
+      /*num_blocking_threads=*/1, /*num_non_blocking_threads=*/0,
+      /*wait_if_no_active_request=*/true,
+      /*non_blocking_threads_sleep_time_micro_sec=*/250,
+      /*blocking_threads_max_sleep_time_micro_sec=*/250,
+      /*use_adaptive_waiting_time=*/true, /*enable_wake_up=*/true,
+      /*max_concurrent_handler=*/128,
+      /*num_threads_in_sub_thread_pool=*/{1},
+      /*sub_thread_request_percentage=*/{1},
+      /*enable_priority_scheduling=*/true, /*priority_weight_factor=*/4.0,
+      max_priority_skips);
+}
+
+// Pops one blocking task with `run_handler_thread_pool` and returns the index
+// of the source it came from.
+int FindAndRunTaskByPriority(
+    internal::RunHandlerThreadPool& run_handler_thread_pool,
+    const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
+        thread_work_sources) {
+  bool task_from_blocking_queue;
+  internal::ThreadWorkSource* tws = nullptr;
+  internal::Task t = run_handler_thread_pool.FindTask(
+      /*searching_range_start=*/0,
+      /*searching_range_end=*/thread_work_sources.size(), /*thread_id=*/0,
+      /*sub_thread_pool_id=*/0, /*max_blocking_inflight=*/10,
+      /*may_steal_blocking_work=*/true, thread_work_sources,
+      &task_from_blocking_queue, &tws);
+  if (!t.f) return -1;
+  EXPECT_TRUE(task_from_blocking_queue);
+  t.f->f();
+  for (int i = 0; i < thread_work_sources.size(); ++i) {
+    if (thread_work_sources[i] == tws) return i;
+  }
+  return -1;
+}
+
+TEST(RunHandlerPrioritySchedulingTest, WeightedFairSharing) {
+  Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  internal::RunHandlerThreadPool run_handler_thread_pool(
+      PrioritySchedulingOptions(/*max_priority_skips=*/100),
+      tensorflow::Env::Default(), tensorflow::ThreadOptions(),
+      "tf_run_handler_pool", &waiters_mu, &waiters);
+
+  // The sources are sorted by priority, as in RunHandlerPool.
+  internal::ThreadWorkSource tws[2];
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(2);
+  thread_work_sources.resize(2);
+  for (int i = 0; i < 2; ++i) {
+    tws[i].SetWaiter(1, &waiters[0], &waiters_mu[0]);
+    tws[i].ResetSchedulingState(/*priority=*/1 - i, /*pass=*/0);
+    thread_work_sources[i] = &tws[i];
+    for (int j = 0; j < 10; ++j) {
+      run_handler_thread_pool.AddWorkToQueue(&tws[i], /*is_blocking=*/true,
+                                             TaskFunction([] {}));
+    }
+  }
+
+  // The request with priority 1 has 4 times the weight of the request with
+  // priority 0.
+  int num_tasks[2] = {0, 0};
+  for (int i = 0; i < 10; ++i) {
+    ++num_tasks[FindAndRunTaskByPriority(run_handler_thread_pool,
+                                         thread_work_sources)];
+  }
+  EXPECT_EQ(num_tasks[0], 8);
+  EXPECT_EQ(num_tasks[1], 2);
+}
+
+TEST(RunHandlerPrioritySchedulingTest, NoStarvation) {
+  Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  constexpr int kMaxPrioritySkips = 3;
+  internal::RunHandlerThreadPool run_handler_thread_pool(
+      PrioritySchedulingOptions(kMaxPrioritySkips), tensorflow::Env::Default(),
+      tensorflow::ThreadOptions(), "tf_run_handler_pool", &waiters_mu,
+      &waiters);
+
+  internal::ThreadWorkSource tws[2];
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(2);
+  thread_work_sources.resize(2);
+  for (int i = 0; i < 2; ++i) {
+    tws[i].SetWaiter(1, &waiters[0], &waiters_mu[0]);
+    thread_work_sources[i] = &tws[i];
+    for (int j = 0; j < 20; ++j) {
+      run_handler_thread_pool.AddWorkToQueue(&tws[i], /*is_blocking=*/true,
+                                             TaskFunction([] {}));
+    }
+  }
+  tws[0].ResetSchedulingState(/*priority=*/kMaxPriorityClass, /*pass=*/0);
+  tws[1].ResetSchedulingState(/*priority=*/0, /*pass=*/0);
+
+  // By weight alone the low priority request would almost never run. The
+  // starvation guard bounds the number of tasks it waits for.
+  int num_skips = 0;
+  int num_low_priority_tasks = 0;
+  for (int i = 0; i < 20; ++i) {
+    if (FindAndRunTaskByPriority(run_handler_thread_pool,
+                                 thread_work_sources) == 1) {
+      ++num_low_priority_tasks;
+      num_skips = 0;
+    } else {
+      ++num_skips;
+    }
+    EXPECT_LE(num_skips, kMaxPrioritySkips);
+  }
+  EXPECT_GE(num_low_priority_tasks, 20 / (kMaxPrioritySkips + 1));
+}
+
+TEST(RunHandlerPrioritySchedulingTest, PreemptAtTaskBoundary) {
+  Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  internal::RunHandlerThreadPool run_handler_thread_pool(
+      PrioritySchedulingOptions(/*max_priority_skips=*/100),
+      tensorflow::Env::Default(), tensorflow::ThreadOptions(),
+      "tf_run_handler_pool", &waiters_mu, &waiters);
+
+  internal::ThreadWorkSource high_priority_tws;
+  internal::ThreadWorkSource low_priority_tws;
+  high_priority_tws.SetWaiter(1, &waiters[0], &waiters_mu[0]);
+  low_priority_tws.SetWaiter(1, &waiters[0], &waiters_mu[0]);
+  low_priority_tws.ResetSchedulingState(
+      /*priority=*/0, run_handler_thread_pool.VirtualTime());
+  for (int j = 0; j < 10; ++j) {
+    run_handler_thread_pool.AddWorkToQueue(
+        &low_priority_tws, /*is_blocking=*/true, TaskFunction([] {}));
+  }
+
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(2);
+  thread_work_sources.resize(1);
+  thread_work_sources[0] = &low_priority_tws;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(
+        FindAndRunTaskByPriority(run_handler_thread_pool, thread_work_sources),
+        0);
+  }
+
+  // A high priority request arrives while the low priority one still has
+  // queued tasks. It is served from the next task on.
+  high_priority_tws.ResetSchedulingState(
+      /*priority=*/2, run_handler_thread_pool.VirtualTime());
+  for (int j = 0; j < 3; ++j) {
+    run_handler_thread_pool.AddWorkToQueue(
+        &high_priority_tws, /*is_blocking=*/true, TaskFunction([] {}));
+  }
+  thread_work_sources.resize(2);
+  thread_work_sources[0] = &high_priority_tws;
+  thread_work_sources[1] = &low_priority_tws;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(
+        FindAndRunTaskByPriority(run_handler_thread_pool, thread_work_sources),
+        0);
+  }
+  EXPECT_EQ(
+      FindAndRunTaskByPriority(run_handler_thread_pool, thread_work_sources),
+      1);
+}
+
+TEST(RunHandlerPrioritySchedulingTest, RunHandlerPool) {
+  int num_threads = 2;
+  RunHandlerPool::Options pool_options;
+  pool_options.num_intra_op_threads = num_threads;
+  pool_options.num_inter_op_threads = num_threads;
+  pool_options.num_threads_in_sub_thread_pool = {2};
+  pool_options.enable_priority_scheduling = true;
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(pool_options));
+
+  constexpr int kNumHandlers = 6;
+  constexpr int kNumTasks = 20;
+  tensorflow::BlockingCounter counter(kNumHandlers * kNumTasks);
+  std::vector<std::unique_ptr<RunHandler>> handlers;
+  for (int i = 0; i < kNumHandlers; ++i) {
+    RunHandlerOptions options;
+    options.priority = i % 3;
+    handlers.push_back(pool->Get(/*step_id=*/i, /*timeout_in_ms=*/0, options));
+  }
+  for (auto& handler : handlers) {
+    for (int j = 0; j < kNumTasks; ++j) {
+      handler->ScheduleInterOpClosure(
+          TaskFunction([&counter] { counter.DecrementCount(); }));
+    }
+  }
+  counter.Wait();
+  pool->Quiesce();
+  handlers.clear();
+}
+
 INSTANTIATE_TEST_SUITE_P(Parameter, RunHandlerThreadPoolTest,
                          testing::Combine(::testing::Bool(),
                                           ::testing::Bool()));
 
+// Simulates a multi-tenant load: clients of different priorities concurrently
+// issue requests to the same pool, and the latency percentiles of each
+// priority are reported as counters. The argument toggles priority scheduling.
+void BM_MultiTenantLoad(::testing::benchmark::State& state) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumPriorities = 3;
+  constexpr int kNumClientsPerPriority = 4;
+  constexpr int kNumTasksPerRequest = 8;
+  constexpr int kTaskCostMicros = 50;
+
+  RunHandlerPool::Options pool_options;
+  pool_options.num_inter_op_threads = kNumThreads;
+  pool_options.num_intra_op_threads = 0;
+  pool_options.num_threads_in_sub_thread_pool = {kNumThreads};
+  pool_options.enable_priority_scheduling = state.range(0);
+  RunHandlerPool pool(pool_options);
+
+  tensorflow::thread::ThreadPool clients(
+      tensorflow::Env::Default(), "clients",
+      kNumPriorities * kNumClientsPerPriority);
+  std::atomic<int64_t> step_id{0};
+  tensorflow::mutex mu;
+  std::vector<tensorflow::histogram::Histogram> latency_us(kNumPriorities);
+
+  for (auto s : state) {
+    tensorflow::BlockingCounter requests_done(kNumPriorities *
+                                              kNumClientsPerPriority);
+    for (int priority = 0; priority < kNumPriorities; ++priority) {
+      for (int i = 0; i < kNumClientsPerPriority; ++i) {
+        clients.Schedule([&, priority] {
+          uint64_t start_us = tensorflow::Env::Default()->NowMicros();
+          RunHandlerOptions options;
+          options.priority = priority;
+          auto handler = pool.Get(++step_id, /*timeout_in_ms=*/0, options);
+          tensorflow::BlockingCounter tasks_done(kNumTasksPerRequest);
+          for (int j = 0; j < kNumTasksPerRequest; ++j) {
+            handler->ScheduleInterOpClosure(TaskFunction([&tasks_done] {
+              uint64_t task_start_us = tensorflow::Env::Default()->NowMicros();
+              while (tensorflow::Env::Default()->NowMicros() - task_start_us <
+                     kTaskCostMicros) {
+              }
+              tasks_done.DecrementCount();
+            }));
+          }
+          tasks_done.Wait();
+          handler.reset();
+          uint64_t elapsed_us =
+              tensorflow::Env::Default()->NowMicros() - start_us;
+          {
+            tensorflow::mutex_lock l(mu);
+            latency_us[priority].Add(elapsed_us);
+          }
+          requests_done.DecrementCount();
+        });
+      }
+    }
+    requests_done.Wait();
+  }
+
+  for (int priority = 0; priority < kNumPriorities; ++priority) {
+    state.counters[tensorflow::strings::StrCat("priority", priority,
+                                               "_p50_us")] =
+        latency_us[priority].Median();
+    state.counters[tensorflow::strings::StrCat("priority", priority,
+                                               "_p99_us")] =
+        latency_us[priority].Percentile(99);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPriorities *
+                          kNumClientsPerPriority);
+}
+BENCHMARK(BM_MultiTenantLoad)->Arg(0)->Arg(1)->UseRealTime();
+
 }  // namespace
 }  // namespace tf
 }  // namespace tfrt
@@ -175,20 +175,25 @@ class Runtime {
     }
   }
 
+  // Overrides how the work queues of requests are created. The function only
+  // receives the request id, so requests created through it bypass
+  // prioritization: the `priority` passed to `CreateRequestQueue()` is
+  // ignored.
   void SetCreateRequestQueueFn(
       std::function<StatusOr<std::unique_ptr<WorkQueueInterface>>(int64_t)>
           create_request_queue_fn) {
     create_request_queue_fn_ = std::move(create_request_queue_fn);
   }
 
-  // Creates a work queue for a request.
+  // Creates a work queue for a request with `priority`. The priority is
+  // ignored if a function was set with `SetCreateRequestQueueFn()`.
   StatusOr<std::unique_ptr<WorkQueueInterface>> CreateRequestQueue(
-      int64_t request_id) const {
+      int64_t request_id, int priority = 0) const {
     if (create_request_queue_fn_) {
       return create_request_queue_fn_(request_id);
     }
 
-    return work_queue_->InitializeRequest(request_id);
+    return work_queue_->InitializeRequest(request_id, priority);
   }
 
  private:
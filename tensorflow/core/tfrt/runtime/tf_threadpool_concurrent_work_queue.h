@@ -49,6 +49,8 @@ class TfThreadPoolWorkQueue : public WorkQueueInterface {
         intra_op_threadpool_(intra_op_threadpool),
         inter_op_threadpool_(inter_op_threadpool) {}
 
+  // Requests aren't scheduled by priority, so the priority is ignored.
+  using WorkQueueInterface::InitializeRequest;
   StatusOr<std::unique_ptr<WorkQueueInterface>> InitializeRequest(
       int64_t request_id) const override;
 
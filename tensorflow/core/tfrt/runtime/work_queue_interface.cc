@@ -75,6 +75,8 @@ class DefaultWorkQueueWrapper : public WorkQueueInterface {
     return work_queue_->IsInWorkerThread();
   }
 
+  // Requests aren't scheduled by priority, so the priority is ignored.
+  using WorkQueueInterface::InitializeRequest;
   StatusOr<std::unique_ptr<WorkQueueInterface>> InitializeRequest(
       int64_t request_id) const override {
     return {std::make_unique<DefaultWorkQueueWrapper>(request_id, work_queue_,
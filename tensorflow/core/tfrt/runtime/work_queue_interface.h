@@ -61,6 +61,13 @@ class WorkQueueInterface : public tfrt::ConcurrentWorkQueue {
     return {nullptr};
   }
 
+  // Same as above, but also passes the priority of the request. Work queues
+  // that schedule requests by priority should override this method.
+  virtual StatusOr<std::unique_ptr<WorkQueueInterface>> InitializeRequest(
+      int64_t request_id, int priority) const {
+    return InitializeRequest(request_id);
+  }
+
  private:
   int64_t id_ = 0;
   thread::ThreadPoolInterface* intra_op_threadpool_ = nullptr;
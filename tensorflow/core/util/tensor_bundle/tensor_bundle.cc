@@ -778,6 +778,10 @@ BundleReader::BundleReader(
       iter_(nullptr),
       need_to_swap_bytes_(false),
       enable_multi_threading_for_testing_(enable_multi_threading_for_testing) {
+  if (RestoredTensorPool::Global()->enabled()) {
+    tensor_pool_ = RestoredTensorPool::Global();
+  }
+
   const string filename = MetaFilename(prefix_);
   uint64 file_size;
   status_ = env_->GetFileSize(filename, &file_size);
@@ -1016,7 +1020,11 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
 
   if (entry.slices().empty()) {
-    return GetValue(entry, val);
+    TF_RETURN_IF_ERROR(GetValue(entry, val));
+    if (tensor_pool_ != nullptr && tensor_pool_->IsPoolable(entry)) {
+      *val = tensor_pool_->Intern(entry, *val);
+    }
+    return OkStatus();
   } else {
     return GetSliceValue(
         key, entry,
@@ -86,6 +86,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_pool.h"
 #include "tensorflow/core/util/tensor_slice_set.h"
 #include "tsl/lib/io/buffered_file.h"
 #include "tsl/platform/errors.h"
@@ -248,6 +249,10 @@ class BundleReader {
   // tensor keyed by "key" does not exist in this bundle.
   //
   // Validates the stored crc32c checksum against the restored bytes.
+  //
+  // If a tensor pool is set (see "set_tensor_pool()"), "val" may be rebound to
+  // a buffer shared with identical tensors restored by other readers, so it
+  // must not be modified in place.
   // REQUIRES: status().ok()
   Status Lookup(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
 
@@ -297,6 +302,13 @@ class BundleReader {
 
   std::string DebugString();
 
+  // Sets the pool used to deduplicate tensors returned by "Lookup()". Defaults
+  // to RestoredTensorPool::Global() if it is enabled when the reader is
+  // created, or nullptr otherwise. Not owned.
+  void set_tensor_pool(RestoredTensorPool* tensor_pool) {
+    tensor_pool_ = tensor_pool;
+  }
+
  private:
   // Seeks for "key" and reads the metadata proto.
   // On non-OK return, clears "entry" for the caller.
@@ -344,6 +356,8 @@ class BundleReader {
 
   bool enable_multi_threading_for_testing_ = false;
 
+  RestoredTensorPool* tensor_pool_ = nullptr;  // Not owned.
+
   BundleReader(const BundleReader&) = delete;
   void operator=(const BundleReader&) = delete;
 };
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap_tensor.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_pool.h"
 
 namespace tensorflow {
 using ::testing::ElementsAre;
@@ -1148,6 +1149,42 @@ TEST(TensorBundleTest, LargeVariableLoadingTest) {
   }
 }
 
+TEST(TensorBundleTest, DeduplicatesWithTensorPool) {
+  for (const string prefix : {"dedup_a", "dedup_b"}) {
+    BundleWriter writer(Env::Default(), Prefix(prefix));
+    TF_EXPECT_OK(writer.Add("shared", Constant_100x100<float>(1)));
+    TF_EXPECT_OK(writer.Add("distinct", Constant_100x100<float>(
+                                            prefix == "dedup_a" ? 2 : 3)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  RestoredTensorPool pool;
+  auto lookup = [&pool](const string& prefix, const string& key) {
+    BundleReader reader(Env::Default(), Prefix(prefix));
+    TF_CHECK_OK(reader.status());
+    reader.set_tensor_pool(&pool);
+    Tensor val(DT_FLOAT, TensorShape({100, 100}));
+    TF_CHECK_OK(reader.Lookup(key, &val));
+    return val;
+  };
+
+  Tensor shared_a = lookup("dedup_a", "shared");
+  Tensor shared_b = lookup("dedup_b", "shared");
+  Tensor distinct_a = lookup("dedup_a", "distinct");
+  Tensor distinct_b = lookup("dedup_b", "distinct");
+
+  EXPECT_TRUE(shared_a.SharesBufferWith(shared_b));
+  EXPECT_FALSE(distinct_a.SharesBufferWith(distinct_b));
+  test::ExpectTensorEqual<float>(shared_b, Constant_100x100<float>(1));
+  test::ExpectTensorEqual<float>(distinct_a, Constant_100x100<float>(2));
+  test::ExpectTensorEqual<float>(distinct_b, Constant_100x100<float>(3));
+
+  RestoredTensorPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_tensors, 3);
+  EXPECT_EQ(stats.num_hits, 1);
+  EXPECT_EQ(stats.matched_bytes, 100 * 100 * sizeof(float));
+}
+
 class TensorBundleAlignmentTest : public ::testing::Test {
  protected:
   template <typename T>
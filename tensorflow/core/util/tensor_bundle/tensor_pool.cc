@@ -0,0 +1,125 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/tensor_pool.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+std::string PoolKey(const BundleEntryProto& entry) {
+  return absl::StrCat(DataTypeString(entry.dtype()),
+                      TensorShape(entry.shape()).DebugString(), "/",
+                      entry.size(), "/", entry.crc32c());
+}
+
+}  // namespace
+
+RestoredTensorPool* RestoredTensorPool::Global() {
+  static RestoredTensorPool* const pool = [] {
+    auto* pool = new RestoredTensorPool();
+    bool enabled = false;
+    Status status = ReadBoolFromEnvVar("TF_DEDUPLICATE_RESTORED_TENSORS",
+                                       /*default_val=*/false, &enabled);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to read TF_DEDUPLICATE_RESTORED_TENSORS: "
+                   << status;
+    }
+    pool->set_enabled(enabled);
+    return pool;
+  }();
+  return pool;
+}
+
+bool RestoredTensorPool::IsPoolable(const BundleEntryProto& entry) const {
+  return DataTypeCanUseMemcpy(entry.dtype()) && entry.slices().empty() &&
+         entry.size() >= min_bytes_;
+}
+
+Tensor RestoredTensorPool::Intern(const BundleEntryProto& entry,
+                                  const Tensor& tensor) {
+  DCHECK(IsPoolable(entry));
+  const std::string key = PoolKey(entry);
+  const absl::string_view data = tensor.tensor_data();
+
+  std::vector<Tensor> candidates;
+  {
+    mutex_lock lock(mu_);
+    auto it = tensors_.find(key);
+    if (it != tensors_.end()) candidates = it->second;
+  }
+
+  // The comparison is done outside of the lock as the tensors can be large.
+  for (const Tensor& candidate : candidates) {
+    if (candidate.tensor_data() == data) {
+      mutex_lock lock(mu_);
+      ++stats_.num_hits;
+      stats_.matched_bytes += data.size();
+      return candidate;
+    }
+  }
+
+  mutex_lock lock(mu_);
+  // Purging walks the whole pool, so only do it once the number of insertions
+  // since the last purge catches up with the size of the pool.
+  if (++num_inserts_since_purge_ > stats_.num_tensors) PurgeLocked();
+  tensors_[key].push_back(tensor);
+  ++stats_.num_tensors;
+  stats_.pooled_bytes += data.size();
+  return tensor;
+}
+
+void RestoredTensorPool::Purge() {
+  mutex_lock lock(mu_);
+  PurgeLocked();
+}
+
+void RestoredTensorPool::PurgeLocked() {
+  num_inserts_since_purge_ = 0;
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    std::vector<Tensor>& bucket = it->second;
+    for (auto t = bucket.begin(); t != bucket.end();) {
+      if (t->RefCountIsOne()) {
+        --stats_.num_tensors;
+        stats_.pooled_bytes -= t->TotalBytes();
+        t = bucket.erase(t);
+      } else {
+        ++t;
+      }
+    }
+    if (bucket.empty()) {
+      tensors_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+RestoredTensorPool::Stats RestoredTensorPool::GetStats() const {
+  mutex_lock lock(mu_);
+  return stats_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,119 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_POOL_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+
+namespace tensorflow {
+
+// A content-addressed pool of restored tensors.
+//
+// When several models restored into the same process carry identical weights
+// (e.g. multiple versions or fine-tuned variants of the same base model), the
+// pool lets them share a single buffer per distinct tensor instead of holding
+// one copy per model. Tensors are addressed by the dtype, shape, size and
+// crc32c recorded in the checkpoint's BundleEntryProto, and a byte-wise
+// comparison guards against checksum collisions.
+//
+// The pool holds a reference to each interned buffer. Entries that are no
+// longer referenced by anything else are dropped lazily as new tensors are
+// interned, or eagerly via `Purge()`.
+//
+// Interned tensors must be treated as read-only; TensorFlow kernels that
+// update variables in place already copy buffers that are not exclusively
+// owned, which is always the case for pooled buffers.
+//
+// This class is thread-safe.
+class RestoredTensorPool {
+ public:
+  // Tensors smaller than this are not worth pooling.
+  static constexpr int64_t kDefaultMinBytes = 1024;
+
+  struct Stats {
+    // Number of distinct buffers currently held by the pool.
+    int64_t num_tensors = 0;
+    // Total size of the buffers currently held by the pool.
+    int64_t pooled_bytes = 0;
+    // Number of `Intern()` calls that were served by an existing buffer.
+    int64_t num_hits = 0;
+    // Total size of the restored tensors that were served by an existing
+    // buffer since process start. This is an upper bound of the memory saved
+    // by deduplication: a served tensor may still be copied by its user, e.g.
+    // when a variable is assigned, and it isn't reduced when buffers are
+    // released.
+    int64_t matched_bytes = 0;
+  };
+
+  explicit RestoredTensorPool(int64_t min_bytes = kDefaultMinBytes)
+      : min_bytes_(min_bytes) {}
+
+  RestoredTensorPool(const RestoredTensorPool&) = delete;
+  RestoredTensorPool& operator=(const RestoredTensorPool&) = delete;
+
+  // Returns the process-wide pool used by BundleReader. It is disabled unless
+  // the environment variable TF_DEDUPLICATE_RESTORED_TENSORS is set to true or
+  // `set_enabled(true)` is called.
+  static RestoredTensorPool* Global();
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  // Returns true if a tensor described by `entry` can be pooled.
+  bool IsPoolable(const BundleEntryProto& entry) const;
+
+  // Returns a tensor with the same contents as `tensor`, which was restored
+  // from `entry`. If an identical tensor is already in the pool, the pooled
+  // tensor is returned; otherwise `tensor` is added to the pool and returned.
+  // REQUIRES: IsPoolable(entry)
+  Tensor Intern(const BundleEntryProto& entry, const Tensor& tensor);
+
+  // Drops all entries that are not referenced outside the pool.
+  void Purge();
+
+  Stats GetStats() const;
+
+ private:
+  void PurgeLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t min_bytes_;
+  std::atomic<bool> enabled_{false};
+
+  mutable mutex mu_;
+  // Tensors with the same key only differ in content on a checksum collision,
+  // so each bucket almost always holds a single tensor.
+  absl::flat_hash_map<std::string, std::vector<Tensor>> tensors_
+      TF_GUARDED_BY(mu_);
+  Stats stats_ TF_GUARDED_BY(mu_);
+  // Number of tensors inserted since the last purge. Used to amortize the cost
+  // of purging over insertions.
+  int64_t num_inserts_since_purge_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_POOL_H_
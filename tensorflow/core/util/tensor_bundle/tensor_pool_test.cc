@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/tensor_pool.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor Constant(float value) {
+  Tensor tensor(DT_FLOAT, TensorShape({16, 16}));
+  tensor.flat<float>().setConstant(value);
+  return tensor;
+}
+
+BundleEntryProto Entry(const Tensor& tensor, uint32 crc32c) {
+  BundleEntryProto entry;
+  entry.set_dtype(tensor.dtype());
+  tensor.shape().AsProto(entry.mutable_shape());
+  entry.set_size(tensor.TotalBytes());
+  entry.set_crc32c(crc32c);
+  return entry;
+}
+
+TEST(RestoredTensorPoolTest, SharesIdenticalTensors) {
+  RestoredTensorPool pool;
+  Tensor a = Constant(1);
+  Tensor b = Constant(1);
+  ASSERT_FALSE(a.SharesBufferWith(b));
+
+  Tensor pooled_a = pool.Intern(Entry(a, 42), a);
+  Tensor pooled_b = pool.Intern(Entry(b, 42), b);
+  EXPECT_TRUE(pooled_a.SharesBufferWith(a));
+  EXPECT_TRUE(pooled_b.SharesBufferWith(a));
+  test::ExpectTensorEqual<float>(pooled_b, b);
+
+  RestoredTensorPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_tensors, 1);
+  EXPECT_EQ(stats.pooled_bytes, a.TotalBytes());
+  EXPECT_EQ(stats.num_hits, 1);
+  EXPECT_EQ(stats.matched_bytes, b.TotalBytes());
+}
+
+TEST(RestoredTensorPoolTest, ChecksumCollision) {
+  RestoredTensorPool pool;
+  Tensor a = Constant(1);
+  Tensor b = Constant(2);
+
+  // The same checksum is used for both tensors, but their contents differ.
+  pool.Intern(Entry(a, 42), a);
+  Tensor pooled_b = pool.Intern(Entry(b, 42), b);
+  EXPECT_TRUE(pooled_b.SharesBufferWith(b));
+  test::ExpectTensorEqual<float>(pooled_b, Constant(2));
+
+  RestoredTensorPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_tensors, 2);
+  EXPECT_EQ(stats.num_hits, 0);
+}
+
+TEST(RestoredTensorPoolTest, IsPoolable) {
+  RestoredTensorPool pool(/*min_bytes=*/1024);
+  EXPECT_TRUE(pool.IsPoolable(Entry(Constant(1), 0)));
+
+  Tensor small(DT_FLOAT, TensorShape({2}));
+  EXPECT_FALSE(pool.IsPoolable(Entry(small, 0)));
+
+  Tensor strings(DT_STRING, TensorShape({1024}));
+  EXPECT_FALSE(pool.IsPoolable(Entry(strings, 0)));
+
+  BundleEntryProto sliced = Entry(Constant(1), 0);
+  sliced.add_slices();
+  EXPECT_FALSE(pool.IsPoolable(sliced));
+}
+
+TEST(RestoredTensorPoolTest, PurgeReleasesUnusedTensors) {
+  RestoredTensorPool pool;
+  {
+    Tensor a = Constant(1);
+    pool.Intern(Entry(a, 1), a);
+  }
+  Tensor b = Constant(2);
+  pool.Intern(Entry(b, 2), b);
+  EXPECT_EQ(pool.GetStats().num_tensors, 2);
+
+  pool.Purge();
+  RestoredTensorPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_tensors, 1);
+  EXPECT_EQ(stats.pooled_bytes, b.TotalBytes());
+
+  // A tensor with the contents of the purged one is pooled anew.
+  Tensor c = Constant(1);
+  EXPECT_TRUE(pool.Intern(Entry(c, 1), c).SharesBufferWith(c));
+}
+
+}  // namespace
+}  // namespace tensorflow
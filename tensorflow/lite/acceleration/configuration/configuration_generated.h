@@ -1506,6 +1506,8 @@ struct XNNPackSettingsT : public ::flatbuffers::NativeTable {
   typedef XNNPackSettings TableType;
   int32_t num_threads = 0;
   tflite::XNNPackFlags flags = tflite::XNNPackFlags_TFLITE_XNNPACK_DELEGATE_NO_FLAGS;
+  std::string unpacked_weights_cache_dir{};
+  std::string unpacked_weights_cache_model_token{};
 };
 
 struct XNNPackSettings FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
@@ -1513,7 +1515,9 @@ struct XNNPackSettings FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   typedef XNNPackSettingsBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_NUM_THREADS = 4,
-    VT_FLAGS = 6
+    VT_FLAGS = 6,
+    VT_UNPACKED_WEIGHTS_CACHE_DIR = 8,
+    VT_UNPACKED_WEIGHTS_CACHE_MODEL_TOKEN = 10
   };
   int32_t num_threads() const {
     return GetField<int32_t>(VT_NUM_THREADS, 0);
@@ -1521,10 +1525,20 @@ struct XNNPackSettings FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   tflite::XNNPackFlags flags() const {
     return static_cast<tflite::XNNPackFlags>(GetField<int32_t>(VT_FLAGS, 0));
   }
+  const ::flatbuffers::String *unpacked_weights_cache_dir() const {
+    return GetPointer<const ::flatbuffers::String *>(VT_UNPACKED_WEIGHTS_CACHE_DIR);
+  }
+  const ::flatbuffers::String *unpacked_weights_cache_model_token() const {
+    return GetPointer<const ::flatbuffers::String *>(VT_UNPACKED_WEIGHTS_CACHE_MODEL_TOKEN);
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<int32_t>(verifier, VT_NUM_THREADS, 4) &&
            VerifyField<int32_t>(verifier, VT_FLAGS, 4) &&
+           VerifyOffset(verifier, VT_UNPACKED_WEIGHTS_CACHE_DIR) &&
+           verifier.VerifyString(unpacked_weights_cache_dir()) &&
+           VerifyOffset(verifier, VT_UNPACKED_WEIGHTS_CACHE_MODEL_TOKEN) &&
+           verifier.VerifyString(unpacked_weights_cache_model_token()) &&
            verifier.EndTable();
   }
   XNNPackSettingsT *UnPack(const ::flatbuffers::resolver_function_t *_resolver = nullptr) const;
@@ -1542,6 +1556,12 @@ struct XNNPackSettingsBuilder {
   void add_flags(tflite::XNNPackFlags flags) {
     fbb_.AddElement<int32_t>(XNNPackSettings::VT_FLAGS, static_cast<int32_t>(flags), 0);
   }
+  void add_unpacked_weights_cache_dir(::flatbuffers::Offset<::flatbuffers::String> unpacked_weights_cache_dir) {
+    fbb_.AddOffset(XNNPackSettings::VT_UNPACKED_WEIGHTS_CACHE_DIR, unpacked_weights_cache_dir);
+  }
+  void add_unpacked_weights_cache_model_token(::flatbuffers::Offset<::flatbuffers::String> unpacked_weights_cache_model_token) {
+    fbb_.AddOffset(XNNPackSettings::VT_UNPACKED_WEIGHTS_CACHE_MODEL_TOKEN, unpacked_weights_cache_model_token);
+  }
   explicit XNNPackSettingsBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -1556,13 +1576,33 @@ struct XNNPackSettingsBuilder {
 inline ::flatbuffers::Offset<XNNPackSettings> CreateXNNPackSettings(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     int32_t num_threads = 0,
-    tflite::XNNPackFlags flags = tflite::XNNPackFlags_TFLITE_XNNPACK_DELEGATE_NO_FLAGS) {
+    tflite::XNNPackFlags flags = tflite::XNNPackFlags_TFLITE_XNNPACK_DELEGATE_NO_FLAGS,
+    ::flatbuffers::Offset<::flatbuffers::String> unpacked_weights_cache_dir = 0,
+    ::flatbuffers::Offset<::flatbuffers::String> unpacked_weights_cache_model_token = 0) {
   XNNPackSettingsBuilder builder_(_fbb);
+  builder_.add_unpacked_weights_cache_model_token(unpacked_weights_cache_model_token);
+  builder_.add_unpacked_weights_cache_dir(unpacked_weights_cache_dir);
   builder_.add_flags(flags);
   builder_.add_num_threads(num_threads);
   return builder_.Finish();
 }
 
+inline ::flatbuffers::Offset<XNNPackSettings> CreateXNNPackSettingsDirect(
+    ::flatbuffers::FlatBufferBuilder &_fbb,
+    int32_t num_threads = 0,
+    tflite::XNNPackFlags flags = tflite::XNNPackFlags_TFLITE_XNNPACK_DELEGATE_NO_FLAGS,
+    const char *unpacked_weights_cache_dir = nullptr,
+    const char *unpacked_weights_cache_model_token = nullptr) {
+  auto unpacked_weights_cache_dir__ = unpacked_weights_cache_dir ? _fbb.CreateString(unpacked_weights_cache_dir) : 0;
+  auto unpacked_weights_cache_model_token__ = unpacked_weights_cache_model_token ? _fbb.CreateString(unpacked_weights_cache_model_token) : 0;
+  return tflite::CreateXNNPackSettings(
+      _fbb,
+      num_threads,
+      flags,
+      unpacked_weights_cache_dir__,
+      unpacked_weights_cache_model_token__);
+}
+
 ::flatbuffers::Offset<XNNPackSettings> CreateXNNPackSettings(::flatbuffers::FlatBufferBuilder &_fbb, const XNNPackSettingsT *_o, const ::flatbuffers::rehasher_function_t *_rehasher = nullptr);
 
 struct CoreMLSettingsT : public ::flatbuffers::NativeTable {
@@ -4513,7 +4553,9 @@ inline ::flatbuffers::Offset<HexagonSettings> CreateHexagonSettings(::flatbuffer
 inline bool operator==(const XNNPackSettingsT &lhs, const XNNPackSettingsT &rhs) {
   return
       (lhs.num_threads == rhs.num_threads) &&
-      (lhs.flags == rhs.flags);
+      (lhs.flags == rhs.flags) &&
+      (lhs.unpacked_weights_cache_dir == rhs.unpacked_weights_cache_dir) &&
+      (lhs.unpacked_weights_cache_model_token == rhs.unpacked_weights_cache_model_token);
 }
 
 inline bool operator!=(const XNNPackSettingsT &lhs, const XNNPackSettingsT &rhs) {
@@ -4532,6 +4574,8 @@ inline void XNNPackSettings::UnPackTo(XNNPackSettingsT *_o, const ::flatbuffers:
   (void)_resolver;
   { auto _e = num_threads(); _o->num_threads = _e; }
   { auto _e = flags(); _o->flags = _e; }
+  { auto _e = unpacked_weights_cache_dir(); if (_e) _o->unpacked_weights_cache_dir = _e->str(); }
+  { auto _e = unpacked_weights_cache_model_token(); if (_e) _o->unpacked_weights_cache_model_token = _e->str(); }
 }
 
 inline ::flatbuffers::Offset<XNNPackSettings> XNNPackSettings::Pack(::flatbuffers::FlatBufferBuilder &_fbb, const XNNPackSettingsT* _o, const ::flatbuffers::rehasher_function_t *_rehasher) {
@@ -4544,10 +4588,14 @@ inline ::flatbuffers::Offset<XNNPackSettings> CreateXNNPackSettings(::flatbuffer
   struct _VectorArgs { ::flatbuffers::FlatBufferBuilder *__fbb; const XNNPackSettingsT* __o; const ::flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
   auto _num_threads = _o->num_threads;
   auto _flags = _o->flags;
+  auto _unpacked_weights_cache_dir = _o->unpacked_weights_cache_dir.empty() ? 0 : _fbb.CreateString(_o->unpacked_weights_cache_dir);
+  auto _unpacked_weights_cache_model_token = _o->unpacked_weights_cache_model_token.empty() ? 0 : _fbb.CreateString(_o->unpacked_weights_cache_model_token);
   return tflite::CreateXNNPackSettings(
       _fbb,
       _num_threads,
-      _flags);
+      _flags,
+      _unpacked_weights_cache_dir,
+      _unpacked_weights_cache_model_token);
 }
 
 
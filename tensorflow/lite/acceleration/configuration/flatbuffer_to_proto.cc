@@ -248,6 +248,14 @@ proto::XNNPackSettings ConvertXNNPackSettings(const XNNPackSettings& settings) {
   proto::XNNPackSettings proto_settings;
   proto_settings.set_num_threads(settings.num_threads());
   proto_settings.set_flags(::tflite::proto::XNNPackFlags(settings.flags()));
+  if (settings.unpacked_weights_cache_dir() != nullptr) {
+    proto_settings.set_unpacked_weights_cache_dir(
+        settings.unpacked_weights_cache_dir()->str());
+  }
+  if (settings.unpacked_weights_cache_model_token() != nullptr) {
+    proto_settings.set_unpacked_weights_cache_model_token(
+        settings.unpacked_weights_cache_model_token()->str());
+  }
   return proto_settings;
 }
 
@@ -239,7 +239,11 @@ Offset<XNNPackSettings> ConvertXNNPackSettings(
   return CreateXNNPackSettings(
       builder,
       /*num_threads=*/settings.num_threads(),
-      /*flags=*/tflite::XNNPackFlags(settings.flags()));
+      /*flags=*/tflite::XNNPackFlags(settings.flags()),
+      /*unpacked_weights_cache_dir=*/
+      builder.CreateString(settings.unpacked_weights_cache_dir()),
+      /*unpacked_weights_cache_model_token=*/
+      builder.CreateString(settings.unpacked_weights_cache_model_token()));
 }
 
 Offset<CoreMLSettings> ConvertCoreMLSettings(
@@ -61,8 +61,27 @@ class Allocation {
 /// Use `IsSupported()` to check.
 class MMAPAllocation : public Allocation {
  public:
+  /// Tunes how the file is mapped. These are performance hints: the mapping
+  /// doesn't fail if the platform doesn't honor them.
+  struct Options {
+    /// Reads the whole file in while mapping it (MAP_POPULATE on Linux), so
+    /// that the first inference doesn't page fault on the weights.
+    bool populate = false;
+    /// Backs the mapping with transparent huge pages (MADV_HUGEPAGE on Linux)
+    /// to reduce TLB misses. For file mappings this requires a kernel built
+    /// with CONFIG_READ_ONLY_THP_FOR_FS; see `NumaReplicaAllocation` for a
+    /// copy that can always use huge pages.
+    bool use_huge_pages = false;
+    /// If positive, reads the file in with this many background threads once
+    /// the constructor returns, overlapping the page faults with the creation
+    /// of the interpreter. Ignored if `populate` is set.
+    int num_prefault_threads = 0;
+  };
+
   /// Loads and maps the provided file to a memory region.
   MMAPAllocation(const char* filename, ErrorReporter* error_reporter);
+  MMAPAllocation(const char* filename, const Options& options,
+                 ErrorReporter* error_reporter);
 
   /// Maps the provided file descriptor to a memory region.
   /// Note: The provided file descriptor will be dup'ed for usage; the caller
@@ -75,6 +94,8 @@ class MMAPAllocation : public Allocation {
   /// retains ownership of the provided descriptor and should close accordingly.
   MMAPAllocation(int fd, size_t offset, size_t length,
                  ErrorReporter* error_reporter);
+  MMAPAllocation(int fd, size_t offset, size_t length, const Options& options,
+                 ErrorReporter* error_reporter);
 
   ~MMAPAllocation() override;
   const void* base() const override;
@@ -95,6 +116,10 @@ class MMAPAllocation : public Allocation {
     return offset_of_buffer_in_file_;
   }
 
+  /// Blocks until the background threads requested with
+  /// `Options::num_prefault_threads` have read the whole file in.
+  void WaitForPrefault();
+
   static bool IsSupported();
 
  protected:
@@ -107,13 +132,46 @@ class MMAPAllocation : public Allocation {
   size_t offset_of_buffer_in_file_ = 0;
 
  private:
+  class Prefaulter;
+
   // Assumes ownership of the provided `owned_fd` instance.
-  MMAPAllocation(ErrorReporter* error_reporter, int owned_fd);
+  MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
+                 const Options& options);
 
   // Assumes ownership of the provided `owned_fd` instance, and uses the given
   // offset and length (both in bytes) for memory mapping.
   MMAPAllocation(ErrorReporter* error_reporter, int owned_fd, size_t offset,
-                 size_t length);
+                 size_t length, const Options& options);
+
+  std::unique_ptr<Prefaulter> prefaulter_;
+};
+
+/// A copy of another allocation in anonymous memory bound to a NUMA node, so
+/// that interpreters whose threads are pinned to that node read their weights
+/// from local memory. Building one `FlatBufferModel` from a replica per node
+/// replicates the weights across the nodes of multi-socket servers.
+/// Note that not all platforms support this allocation.
+/// Use `IsSupported()` to check.
+class NumaReplicaAllocation : public Allocation {
+ public:
+  /// Copies `source` to memory bound to `numa_node`. If `numa_node` is
+  /// negative, the memory is allocated on the node of the calling thread
+  /// instead. If `use_huge_pages` is true, the copy is backed by transparent
+  /// huge pages if the platform supports them.
+  NumaReplicaAllocation(const Allocation& source, int numa_node,
+                        bool use_huge_pages, ErrorReporter* error_reporter);
+  ~NumaReplicaAllocation() override;
+  const void* base() const override;
+  size_t bytes() const override;
+  bool valid() const override;
+
+  static bool IsSupported();
+
+ private:
+  void* buffer_;
+  size_t buffer_size_bytes_ = 0;
+  // Size of the mapping, i.e. buffer_size_bytes_ rounded up to pages.
+  size_t mapped_size_bytes_ = 0;
 };
 
 class FileCopyAllocation : public Allocation {
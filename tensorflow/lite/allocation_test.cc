@@ -20,6 +20,7 @@ limitations under the License.
 
 #include <sys/stat.h>
 
+#include <cstring>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -52,6 +53,108 @@ TEST(MMAPAllocation, TestValidFile) {
   EXPECT_NE(allocation.base(), nullptr);
 }
 
+TEST(MMAPAllocation, TestValidFileWithOptions) {
+  if (!MMAPAllocation::IsSupported()) {
+    return;
+  }
+
+  TestErrorReporter error_reporter;
+  MMAPAllocation allocation("tensorflow/lite/testdata/multi_add.bin",
+                            &error_reporter);
+  ASSERT_TRUE(allocation.valid());
+
+  MMAPAllocation::Options options;
+  options.populate = true;
+  options.use_huge_pages = true;
+  MMAPAllocation populated_allocation("tensorflow/lite/testdata/multi_add.bin",
+                                      options, &error_reporter);
+  ASSERT_TRUE(populated_allocation.valid());
+  ASSERT_EQ(populated_allocation.bytes(), allocation.bytes());
+  EXPECT_EQ(std::memcmp(populated_allocation.base(), allocation.base(),
+                        allocation.bytes()),
+            0);
+}
+
+TEST(MMAPAllocation, TestPrefault) {
+  if (!MMAPAllocation::IsSupported()) {
+    return;
+  }
+
+  TestErrorReporter error_reporter;
+  MMAPAllocation allocation("tensorflow/lite/testdata/multi_add.bin",
+                            &error_reporter);
+  ASSERT_TRUE(allocation.valid());
+
+  MMAPAllocation::Options options;
+  options.num_prefault_threads = 2;
+  MMAPAllocation prefaulted_allocation(
+      "tensorflow/lite/testdata/multi_add.bin", options, &error_reporter);
+  ASSERT_TRUE(prefaulted_allocation.valid());
+  prefaulted_allocation.WaitForPrefault();
+  ASSERT_EQ(prefaulted_allocation.bytes(), allocation.bytes());
+  EXPECT_EQ(std::memcmp(prefaulted_allocation.base(), allocation.base(),
+                        allocation.bytes()),
+            0);
+
+  // Destroying the allocation stops the prefault.
+  MMAPAllocation destroyed_allocation("tensorflow/lite/testdata/multi_add.bin",
+                                      options, &error_reporter);
+  EXPECT_TRUE(destroyed_allocation.valid());
+}
+
+TEST(NumaReplicaAllocation, TestCopy) {
+  if (!NumaReplicaAllocation::IsSupported()) {
+    return;
+  }
+
+  TestErrorReporter error_reporter;
+  MMAPAllocation allocation("tensorflow/lite/testdata/multi_add.bin",
+                            &error_reporter);
+  ASSERT_TRUE(allocation.valid());
+
+  NumaReplicaAllocation replica(allocation, /*numa_node=*/-1,
+                                /*use_huge_pages=*/true, &error_reporter);
+  ASSERT_TRUE(replica.valid());
+  EXPECT_EQ(replica.type(), Allocation::Type::kMemory);
+  ASSERT_EQ(replica.bytes(), allocation.bytes());
+  EXPECT_NE(replica.base(), allocation.base());
+  EXPECT_EQ(std::memcmp(replica.base(), allocation.base(), allocation.bytes()),
+            0);
+}
+
+TEST(NumaReplicaAllocation, TestCopyToNode) {
+  if (!NumaReplicaAllocation::IsSupported()) {
+    return;
+  }
+
+  TestErrorReporter error_reporter;
+  MMAPAllocation allocation("tensorflow/lite/testdata/multi_add.bin",
+                            &error_reporter);
+  ASSERT_TRUE(allocation.valid());
+
+  NumaReplicaAllocation replica(allocation, /*numa_node=*/0,
+                                /*use_huge_pages=*/false, &error_reporter);
+  // Sandboxes may not allow binding memory.
+  if (!replica.valid()) {
+    GTEST_SKIP() << error_reporter.error_messages();
+  }
+  ASSERT_EQ(replica.bytes(), allocation.bytes());
+  EXPECT_EQ(std::memcmp(replica.base(), allocation.base(), allocation.bytes()),
+            0);
+}
+
+TEST(NumaReplicaAllocation, TestInvalidSource) {
+  if (!NumaReplicaAllocation::IsSupported()) {
+    return;
+  }
+
+  TestErrorReporter error_reporter;
+  MMAPAllocation allocation("/tmp/tflite_model_1234", &error_reporter);
+  NumaReplicaAllocation replica(allocation, /*numa_node=*/-1,
+                                /*use_huge_pages=*/false, &error_reporter);
+  EXPECT_FALSE(replica.valid());
+}
+
 #if defined(__linux__)
 TEST(MMAPAllocation, TestInvalidFileDescriptor) {
   if (!MMAPAllocation::IsSupported()) {
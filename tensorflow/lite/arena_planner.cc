@@ -20,12 +20,16 @@ limitations under the License.
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "tensorflow/lite/arena_planning_strategy.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/simple_memory_arena.h"
+#include "tensorflow/lite/util.h"
 
 namespace tflite {
 
@@ -34,10 +38,15 @@ constexpr int32_t kLastActiveNodeUndefined =
 constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
 constexpr int32_t kScalarTensorBytes = 4;
 
+// Header of a serialized plan: "TLAP" followed by the format version.
+constexpr uint32_t kPlanMagic = 0x50414c54;
+constexpr uint32_t kPlanVersion = 1;
+
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_all_tensors, int tensor_alignment,
-                           int subgraph_index)
+                           int subgraph_index,
+                           std::unique_ptr<ArenaPlanningStrategy> strategy)
     : context_(context),
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment, subgraph_index),
@@ -45,7 +54,8 @@ ArenaPlanner::ArenaPlanner(TfLiteContext* context,
       persistent_arena_(kDefaultArenaAlignment, subgraph_index),
       preserve_all_tensors_(preserve_all_tensors),
       tensor_alignment_(tensor_alignment),
-      last_active_node_(kLastActiveNodeUndefined) {}
+      last_active_node_(kLastActiveNodeUndefined),
+      strategy_(std::move(strategy)) {}
 
 ArenaPlanner::~ArenaPlanner() {
   arena_.ReleaseBuffer();
@@ -102,6 +112,28 @@ int ArenaPlanner::FindSharedTensor(int tensor_index) {
   return tensor_index;
 }
 
+void ArenaPlanner::SetExecutionStages(const std::vector<int>& stage_ends) {
+  stage_last_node_.clear();
+  int stage_start = 0;
+  for (int stage_end : stage_ends) {
+    if (stage_end <= stage_start) continue;
+    stage_last_node_.insert(stage_last_node_.end(), stage_end - stage_start,
+                            stage_end - 1);
+    stage_start = stage_end;
+  }
+}
+
+int ArenaPlanner::LastConcurrentNode(int node) const {
+  // Tensors last used by a node may only be reused once the nodes running
+  // concurrently with it are done as well. Widening the lifetime of these
+  // tensors to the end of the stage is enough to keep the tensors of any two
+  // nodes of a stage apart.
+  if (node < 0 || node >= static_cast<int>(stage_last_node_.size())) {
+    return node;
+  }
+  return stage_last_node_[node];
+}
+
 bool ArenaPlanner::InputTensorCanBeShared(const TfLiteTensor& input_tensor,
                                           const TfLiteTensor& output_tensor,
                                           int input_id, int output_id,
@@ -228,7 +260,7 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
       return kTfLiteOk;
     }
     TF_LITE_ENSURE(context_, dealloc_node_[tensor] == kNodeNotAssigned);
-    dealloc_node_[tensor] = node;
+    dealloc_node_[tensor] = LastConcurrentNode(node);
     return kTfLiteOk;
   };
 
@@ -351,7 +383,7 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
       alloc_node_[tensor_index] = i;
       nodes_to_tensors_[i].insert(tensor_index);
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] = LastConcurrentNode(i);
       }
     }
   }
@@ -424,6 +456,144 @@ void ArenaPlanner::GetAllocInfo(size_t* arena_size,
   *arena_persist_size = persistent_arena_.GetBufferSize();
 }
 
+TfLiteStatus ArenaPlanner::SerializePlan(std::string* plan) const {
+  plan->clear();
+  AppendToBuffer(kPlanMagic, plan);
+  AppendToBuffer(kPlanVersion, plan);
+  AppendToBuffer(static_cast<uint32_t>(tensor_alignment_), plan);
+  uint32_t num_allocs = 0;
+  for (const auto& alloc : allocs_) {
+    if (alloc.size > 0) ++num_allocs;
+  }
+  AppendToBuffer(num_allocs, plan);
+  for (const auto& alloc : allocs_) {
+    if (alloc.size == 0) continue;
+    AppendToBuffer(alloc.tensor, plan);
+    AppendToBuffer(alloc.first_node, plan);
+    AppendToBuffer(alloc.last_node, plan);
+    AppendToBuffer(static_cast<uint64_t>(alloc.offset), plan);
+    AppendToBuffer(static_cast<uint64_t>(alloc.size), plan);
+  }
+  return kTfLiteOk;
+}
+
+// Returns true if two of `allocs`, which belong to the same arena, are live at
+// the same node and overlap in memory.
+bool HasOverlappingAllocs(std::vector<ArenaAllocWithUsageInterval> allocs) {
+  std::sort(allocs.begin(), allocs.end());
+  // Allocations that start below the current offset and may still end after
+  // it.
+  std::vector<const ArenaAllocWithUsageInterval*> open_allocs;
+  for (const ArenaAllocWithUsageInterval& alloc : allocs) {
+    open_allocs.erase(
+        std::remove_if(open_allocs.begin(), open_allocs.end(),
+                       [&](const ArenaAllocWithUsageInterval* open_alloc) {
+                         return open_alloc->offset + open_alloc->size <=
+                                alloc.offset;
+                       }),
+        open_allocs.end());
+    for (const ArenaAllocWithUsageInterval* open_alloc : open_allocs) {
+      if (open_alloc->first_node <= alloc.last_node &&
+          alloc.first_node <= open_alloc->last_node) {
+        return true;
+      }
+    }
+    open_allocs.push_back(&alloc);
+  }
+  return false;
+}
+
+TfLiteStatus ArenaPlanner::RestorePlan(const std::string& plan) {
+  restored_allocs_.clear();
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  const int32_t num_tensors = static_cast<int32_t>(graph_info_->num_tensors());
+  size_t pos = 0;
+  uint32_t magic, version, alignment, num_allocs;
+  TF_LITE_ENSURE(context_, ReadFromBuffer(plan, &pos, &magic) &&
+                               ReadFromBuffer(plan, &pos, &version) &&
+                               ReadFromBuffer(plan, &pos, &alignment) &&
+                               ReadFromBuffer(plan, &pos, &num_allocs));
+  TF_LITE_ENSURE(context_, magic == kPlanMagic);
+  TF_LITE_ENSURE(context_, version == kPlanVersion);
+  TF_LITE_ENSURE(context_,
+                 alignment == static_cast<uint32_t>(tensor_alignment_));
+
+  std::vector<ArenaAllocWithUsageInterval> allocs;
+  for (uint32_t i = 0; i < num_allocs; ++i) {
+    ArenaAllocWithUsageInterval alloc;
+    uint64_t offset, size;
+    TF_LITE_ENSURE(context_,
+                   ReadFromBuffer(plan, &pos, &alloc.tensor) &&
+                       ReadFromBuffer(plan, &pos, &alloc.first_node) &&
+                       ReadFromBuffer(plan, &pos, &alloc.last_node) &&
+                       ReadFromBuffer(plan, &pos, &offset) &&
+                       ReadFromBuffer(plan, &pos, &size));
+    TF_LITE_ENSURE(context_, alloc.tensor >= 0 && alloc.tensor < num_tensors);
+    TF_LITE_ENSURE(context_, alloc.first_node <= alloc.last_node);
+    TF_LITE_ENSURE(context_, offset % tensor_alignment_ == 0);
+    // The allocation must not wrap around the address space.
+    TF_LITE_ENSURE(context_, size <= std::numeric_limits<size_t>::max() &&
+                                 offset <= std::numeric_limits<size_t>::max() -
+                                               size);
+    alloc.offset = offset;
+    alloc.size = size;
+    if (alloc.tensor >= static_cast<int32_t>(allocs.size())) {
+      allocs.resize(alloc.tensor + 1);
+    }
+    // Each tensor has at most one allocation.
+    TF_LITE_ENSURE(context_, allocs[alloc.tensor].tensor < 0);
+    allocs[alloc.tensor] = alloc;
+  }
+  TF_LITE_ENSURE(context_, pos == plan.size());
+
+  // Offsets are relative to the arena of the tensor, so the allocations of
+  // each arena are checked separately.
+  std::vector<ArenaAllocWithUsageInterval> rw_allocs, persistent_allocs;
+  for (const ArenaAllocWithUsageInterval& alloc : allocs) {
+    if (alloc.tensor < 0) continue;
+    if (tensors[alloc.tensor].allocation_type == kTfLiteArenaRw) {
+      rw_allocs.push_back(alloc);
+    } else if (tensors[alloc.tensor].allocation_type ==
+               kTfLiteArenaRwPersistent) {
+      persistent_allocs.push_back(alloc);
+    }
+  }
+  TF_LITE_ENSURE(context_, !HasOverlappingAllocs(std::move(rw_allocs)));
+  TF_LITE_ENSURE(context_,
+                 !HasOverlappingAllocs(std::move(persistent_allocs)));
+  restored_allocs_ = std::move(allocs);
+  return kTfLiteOk;
+}
+
+bool ArenaPlanner::MatchesRestoredPlan(
+    const std::vector<int32_t>& tensors_to_allocate) {
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  auto matches = [&](int32_t idx, int32_t last_node) {
+    if (tensors[idx].bytes == 0) return true;
+    if (idx >= static_cast<int32_t>(restored_allocs_.size())) return false;
+    const ArenaAllocWithUsageInterval& alloc = restored_allocs_[idx];
+    return alloc.tensor == idx && alloc.size == tensors[idx].bytes &&
+           alloc.first_node == alloc_node_[idx] && alloc.last_node == last_node;
+  };
+  for (int32_t idx : tensors_to_allocate) {
+    const TfLiteTensor& tensor = tensors[idx];
+    if (tensor.allocation_type == kTfLiteArenaRw) {
+      // Tensors sharing the buffer of another one are not allocated.
+      auto it = actual_tensor_id_.find(idx);
+      if (it != actual_tensor_id_.end() &&
+          tensors[it->second].allocation_type == kTfLiteArenaRw &&
+          tensors[it->second].bytes == tensor.bytes) {
+        continue;
+      }
+      if (!matches(idx, dealloc_node_[idx])) return false;
+    } else if (tensor.allocation_type == kTfLiteArenaRwPersistent &&
+               allocs_[idx].size == 0) {
+      if (!matches(idx, std::numeric_limits<int32_t>::max())) return false;
+    }
+  }
+  return true;
+}
+
 TfLiteStatus ArenaPlanner::Commit(bool* reallocated) {
   bool arena_reallocated, persistent_arena_reallocated;
   TF_LITE_ENSURE_STATUS(arena_.Commit(&arena_reallocated));
@@ -467,6 +637,65 @@ void ArenaPlanner::CreateTensorAllocationVector(
             tensor_compare);
 }
 
+void ArenaPlanner::ApplyPlanningStrategy(
+    int first_node, bool arena_reset,
+    std::vector<int32_t>* tensors_to_allocate) {
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  auto lives_through_inference = [&](int idx) {
+    return alloc_node_[idx] == 0 && dealloc_node_[idx] == kNodeNotAssigned;
+  };
+
+  // Only the order of the tensors allocated in `arena_` matters, and the
+  // tensors living through the whole inference stay at the bottom of it.
+  std::vector<ArenaAllocWithUsageInterval> fixed;
+  std::vector<ArenaAllocWithUsageInterval> allocs;
+  std::vector<int32_t> others;
+  for (int32_t idx : *tensors_to_allocate) {
+    if (tensors[idx].allocation_type != kTfLiteArenaRw ||
+        actual_tensor_id_.count(idx) != 0) {
+      others.push_back(idx);
+      continue;
+    }
+    ArenaAllocWithUsageInterval alloc;
+    alloc.tensor = idx;
+    alloc.size = tensors[idx].bytes;
+    alloc.first_node = alloc_node_[idx];
+    alloc.last_node = dealloc_node_[idx];
+    (lives_through_inference(idx) ? fixed : allocs).push_back(alloc);
+  }
+  if (allocs.size() < 2) return;
+
+  std::vector<ArenaAllocWithUsageInterval> existing;
+  if (!arena_reset) {
+    std::unordered_set<int32_t> reallocated(tensors_to_allocate->begin(),
+                                            tensors_to_allocate->end());
+    for (const auto& alloc : allocs_) {
+      if (alloc.size > 0 && reallocated.count(alloc.tensor) == 0 &&
+          tensors[alloc.tensor].allocation_type == kTfLiteArenaRw) {
+        existing.push_back(alloc);
+      }
+    }
+  }
+
+  auto cost = [&](std::vector<ArenaAllocWithUsageInterval>* order) {
+    std::vector<ArenaAllocWithUsageInterval> all = fixed;
+    all.insert(all.end(), order->begin(), order->end());
+    const size_t arena_size = SimulateArenaAllocations(
+        context_, tensor_alignment_, existing, first_node, &all);
+    for (size_t i = 0; i < order->size(); ++i) {
+      (*order)[i].offset = all[fixed.size() + i].offset;
+    }
+    return arena_size;
+  };
+  strategy_->Order(cost, &allocs);
+
+  tensors_to_allocate->clear();
+  for (const auto& alloc : fixed) tensors_to_allocate->push_back(alloc.tensor);
+  for (const auto& alloc : allocs) tensors_to_allocate->push_back(alloc.tensor);
+  tensors_to_allocate->insert(tensors_to_allocate->end(), others.begin(),
+                              others.end());
+}
+
 std::vector<int32_t> ArenaPlanner::GetTensorsToAllocate(int first_node,
                                                         int last_node) {
   int num_tensors = static_cast<int>(graph_info_->num_tensors());
@@ -505,7 +734,8 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
     last_active_node_ = last_node;
     return kTfLiteOk;
   }
-  if (first_node < last_active_node_) {
+  const bool arena_reset = first_node < last_active_node_;
+  if (arena_reset) {
     arena_.ResetAllocs();
     last_active_node_ = first_node;
   } else {
@@ -514,6 +744,16 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
     arena_.PurgeActiveAllocs(first_node);
   }
   CreateTensorAllocationVector(tensors_allocated);
+  // Once planning diverges from the restored plan, its offsets can no longer
+  // be combined with the planned ones.
+  const bool use_restored_plan =
+      !restored_allocs_.empty() && MatchesRestoredPlan(*tensors_allocated);
+  if (!use_restored_plan) {
+    restored_allocs_.clear();
+    if (strategy_ != nullptr) {
+      ApplyPlanningStrategy(first_node, arena_reset, tensors_allocated);
+    }
+  }
   // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : *tensors_allocated) {
     TfLiteTensor& tensor = tensors[tensor_index];
@@ -537,16 +777,26 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
       }
     }
     if (tensor.allocation_type == kTfLiteArenaRw) {
-      TF_LITE_ENSURE_STATUS(
-          arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
-                          tensor_index, alloc_node_[tensor_index],
-                          dealloc_node_[tensor_index], &allocs_[tensor_index]));
+      if (use_restored_plan && tensor.bytes > 0) {
+        TF_LITE_ENSURE_STATUS(arena_.AllocateAt(
+            context_, tensor_alignment_, restored_allocs_[tensor_index],
+            &allocs_[tensor_index]));
+      } else {
+        TF_LITE_ENSURE_STATUS(arena_.Allocate(
+            context_, tensor_alignment_, tensor.bytes, tensor_index,
+            alloc_node_[tensor_index], dealloc_node_[tensor_index],
+            &allocs_[tensor_index]));
+      }
     }
     // Check allocs_[].size to prevent from reallocation of persistent tensors.
     // Only allocate ArenaRwPersistent tensors which own their buffer.
     if (tensor.allocation_type == kTfLiteArenaRwPersistent &&
         allocs_[tensor_index].size == 0) {
-      if (allocs_[tensor_index].size < tensor.bytes) {
+      if (use_restored_plan && tensor.bytes > 0) {
+        TF_LITE_ENSURE_STATUS(persistent_arena_.AllocateAt(
+            context_, tensor_alignment_, restored_allocs_[tensor_index],
+            &allocs_[tensor_index]));
+      } else if (allocs_[tensor_index].size < tensor.bytes) {
         TF_LITE_ENSURE_STATUS(persistent_arena_.Allocate(
             context_, tensor_alignment_, tensor.bytes, tensor_index,
             /*first_node=*/alloc_node_[tensor_index],
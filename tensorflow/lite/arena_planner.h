@@ -18,10 +18,12 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "tensorflow/lite/arena_planning_strategy.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
@@ -51,9 +53,11 @@ class ArenaPlanner : public MemoryPlanner {
   // ArenaPlanner is destroyed. The inputs to the graph will not share
   // memory with any other tensor, effectively preserving them until the end
   // of inference.
+  // If `strategy` is null, tensors are allocated from largest to smallest.
   ArenaPlanner(TfLiteContext* context, std::unique_ptr<GraphInfo> graph_info,
                bool preserve_all_tensors, int tensor_alignment,
-               int subgraph_index = 0);
+               int subgraph_index = 0,
+               std::unique_ptr<ArenaPlanningStrategy> strategy = nullptr);
   ~ArenaPlanner() override;
   ArenaPlanner(const ArenaPlanner&) = delete;
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
@@ -68,6 +72,10 @@ class ArenaPlanner : public MemoryPlanner {
   void DumpDebugInfo(const std::vector<int>& execution_plan) const override;
   void GetAllocInfo(size_t* arena_size,
                     size_t* arena_persist_size) const override;
+  TfLiteStatus SerializePlan(std::string* plan) const override;
+  TfLiteStatus RestorePlan(const std::string& plan) override;
+  bool HasRestoredPlan() const override { return !restored_allocs_.empty(); }
+  void SetExecutionStages(const std::vector<int>& stage_ends) override;
 
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
@@ -80,6 +88,10 @@ class ArenaPlanner : public MemoryPlanner {
                               const TfLiteTensor& output, int input_id,
                               int output_id, bool tensor_changed);
 
+  // Returns true if the restored plan holds an allocation for each tensor of
+  // `tensors_to_allocate` which needs one, with the same size and lifetime.
+  bool MatchesRestoredPlan(const std::vector<int32_t>& tensors_to_allocate);
+
   // Identify tensors which can share memory with another.
   void IdentifyInPlaceTensors();
 
@@ -95,6 +107,13 @@ class ArenaPlanner : public MemoryPlanner {
   // first goes first.
   void CreateTensorAllocationVector(std::vector<int32_t>* tensors_to_allocate);
 
+  // Lets `strategy_` reorder the non-persistent tensors of
+  // `tensors_to_allocate`, which must be sorted by
+  // `CreateTensorAllocationVector`. `arena_reset` is true if `arena_` holds no
+  // allocations, otherwise the allocations live at `first_node` are kept.
+  void ApplyPlanningStrategy(int first_node, bool arena_reset,
+                             std::vector<int32_t>* tensors_to_allocate);
+
   // Returns vector containing the indices of all tensors allocated between
   // `first_node` and `last_node`.
   std::vector<int32_t> GetTensorsToAllocate(int first_node, int last_node);
@@ -120,6 +139,10 @@ class ArenaPlanner : public MemoryPlanner {
   // Return the index of the tensor owing `tensor_index's` buffer.
   int FindSharedTensor(int tensor_index);
 
+  // Returns the last node of the execution stage of `node`, after which the
+  // tensors last used by `node` can be deallocated.
+  int LastConcurrentNode(int node) const;
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -166,6 +189,18 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Store number of references to each tensor.
   std::vector<int> refcounts_;
+
+  // Allocations set by RestorePlan(), indexed by tensor. Tensors without an
+  // allocation have a negative `tensor`. Empty if there is no restored plan.
+  std::vector<ArenaAllocWithUsageInterval> restored_allocs_;
+
+  // Last node of the execution stage of each node. Empty if nodes run one at
+  // a time.
+  std::vector<int32_t> stage_last_node_;
+
+  // Decides the order in which offsets are assigned to tensors of `arena_`.
+  // May be null.
+  std::unique_ptr<ArenaPlanningStrategy> strategy_;
 };
 
 }  // namespace tflite
@@ -20,18 +20,22 @@ limitations under the License.
 #include <cstdint>
 #include <cstdio>
 #include <initializer_list>
+#include <limits>
 #include <memory>
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "tensorflow/lite/arena_planning_strategy.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/util.h"
 
 namespace tflite {
 
@@ -208,12 +212,14 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_all_tensors = false) {
+  void SetGraph(TestGraph* graph, bool preserve_all_tensors = false,
+                std::unique_ptr<ArenaPlanningStrategy> strategy = nullptr) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_ = std::make_unique<ArenaPlanner>(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
-        preserve_all_tensors, kTensorAlignment);
+        preserve_all_tensors, kTensorAlignment, /*subgraph_index=*/0,
+        std::move(strategy));
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -1074,6 +1080,230 @@ TEST_F(ArenaPlannerTest, DebugTensors) {
   EXPECT_EQ(tensorOffsets.size(), 8);
 }
 
+TEST_F(ArenaPlannerTest, BestFitSearchStrategy) {
+  auto make_graph = [] {
+    return std::make_unique<TestGraph>(
+        std::initializer_list<int>{0, 1},
+        std::initializer_list<TestOp>{
+            /* in, out, tmp */
+            {{0}, {2}, {3}},
+            {{1, 2}, {4, 5}, {}},
+            {{5}, {6, 7}, {8, 9, 10}},
+            {{4, 6}, {11}, {12}},
+            {{11}, {13}, {}},
+            {{7, 13}, {14}, {15}},
+        },
+        std::initializer_list<int>{11, 14});
+  };
+  size_t default_arena_size, arena_size, persistent_arena_size;
+
+  auto default_graph = make_graph();
+  SetGraph(default_graph.get());
+  Execute(0, default_graph->nodes().size() - 1);
+  planner_->GetAllocInfo(&default_arena_size, &persistent_arena_size);
+
+  auto graph = make_graph();
+  SetGraph(graph.get(), /*preserve_all_tensors=*/false,
+           std::make_unique<BestFitSearchStrategy>());
+  Execute(0, graph->nodes().size() - 1);
+  planner_->GetAllocInfo(&arena_size, &persistent_arena_size);
+
+  EXPECT_LE(arena_size, default_arena_size);
+  // The graph inputs are still allocated first.
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+  for (int i = 0; i < graph->tensors()->size(); ++i) {
+    EXPECT_FALSE(IsUnallocated(i));
+    EXPECT_LE(GetOffset(i) + (*graph->tensors())[i].bytes, arena_size);
+  }
+}
+
+TEST_F(ArenaPlannerTest, RestorePlan) {
+  auto make_graph = [] {
+    return std::make_unique<TestGraph>(
+        std::initializer_list<int>{0, 1},
+        std::initializer_list<TestOp>{
+            /* in, out, tmp */
+            {{0}, {2}, {3}},
+            {{1, 2}, {4, 5}, {}},
+            {{5}, {6, 7}, {8, 9, 10}},
+            {{4, 6}, {11}, {12}},
+            {{11}, {13}, {}},
+            {{7, 13}, {14}, {15}},
+        },
+        std::initializer_list<int>{11, 14});
+  };
+
+  // The searched plan differs from the default one, so restoring it can be
+  // told apart from planning again.
+  auto planned_graph = make_graph();
+  SetGraph(planned_graph.get(), /*preserve_all_tensors=*/false,
+           std::make_unique<BestFitSearchStrategy>());
+  Execute(0, planned_graph->nodes().size() - 1);
+  std::string plan;
+  ASSERT_EQ(planner_->SerializePlan(&plan), kTfLiteOk);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i < planned_graph->tensors()->size(); ++i) {
+    offsets.push_back(GetOffset(i));
+  }
+  size_t planned_arena_size, arena_size, persistent_arena_size;
+  planner_->GetAllocInfo(&planned_arena_size, &persistent_arena_size);
+
+  auto graph = make_graph();
+  SetGraph(graph.get());
+  ASSERT_EQ(planner_->RestorePlan(plan), kTfLiteOk);
+  Execute(0, graph->nodes().size() - 1);
+  EXPECT_TRUE(planner_->HasRestoredPlan());
+  for (int i = 0; i < graph->tensors()->size(); ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]) << "tensor " << i;
+  }
+  planner_->GetAllocInfo(&arena_size, &persistent_arena_size);
+  EXPECT_EQ(arena_size, planned_arena_size);
+
+  // A plan made for different tensor sizes is dropped.
+  auto resized_graph = make_graph();
+  (*resized_graph->tensors())[6].bytes = 64;
+  SetGraph(resized_graph.get());
+  ASSERT_EQ(planner_->RestorePlan(plan), kTfLiteOk);
+  Execute(0, resized_graph->nodes().size() - 1);
+  EXPECT_FALSE(planner_->HasRestoredPlan());
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+
+  // Malformed plans are rejected.
+  SetGraph(graph.get());
+  EXPECT_EQ(planner_->RestorePlan(plan.substr(0, plan.size() - 1)),
+            kTfLiteError);
+  EXPECT_EQ(planner_->RestorePlan(""), kTfLiteError);
+  EXPECT_FALSE(planner_->HasRestoredPlan());
+}
+
+TEST_F(ArenaPlannerTest, RestorePlanValidatesAllocations) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {2}, {3}},
+                      {{1, 2}, {4}, {}},
+                  },
+                  {4});
+  SetGraph(&graph);
+
+  struct Record {
+    int32_t tensor;
+    int32_t first_node;
+    int32_t last_node;
+    uint64_t offset;
+    uint64_t size;
+  };
+  auto make_plan = [](const std::vector<Record>& records) {
+    std::string plan;
+    AppendToBuffer(uint32_t{0x50414c54}, &plan);
+    AppendToBuffer(uint32_t{1}, &plan);
+    AppendToBuffer(static_cast<uint32_t>(kTensorAlignment), &plan);
+    AppendToBuffer(static_cast<uint32_t>(records.size()), &plan);
+    for (const Record& record : records) {
+      AppendToBuffer(record.tensor, &plan);
+      AppendToBuffer(record.first_node, &plan);
+      AppendToBuffer(record.last_node, &plan);
+      AppendToBuffer(record.offset, &plan);
+      AppendToBuffer(record.size, &plan);
+    }
+    return plan;
+  };
+
+  // Tensors 2 and 3 are both live at node 0, tensors 3 and 4 never are.
+  EXPECT_EQ(planner_->RestorePlan(make_plan({{2, 0, 1, 0, 12}, {3, 0, 0, 12, 12},
+                                             {4, 1, 1, 12, 16}})),
+            kTfLiteOk);
+  EXPECT_TRUE(planner_->HasRestoredPlan());
+
+  // Allocations of concurrently live tensors overlap.
+  EXPECT_EQ(planner_->RestorePlan(
+                make_plan({{2, 0, 1, 0, 12}, {3, 0, 0, 8, 12}})),
+            kTfLiteError);
+  EXPECT_FALSE(planner_->HasRestoredPlan());
+  // The tensor doesn't exist.
+  EXPECT_EQ(planner_->RestorePlan(make_plan({{5, 0, 1, 0, 12}})),
+            kTfLiteError);
+  // The allocation wraps around the address space.
+  EXPECT_EQ(planner_->RestorePlan(make_plan(
+                {{2, 0, 1, std::numeric_limits<uint64_t>::max() - 3, 12}})),
+            kTfLiteError);
+  // The tensor has two allocations.
+  EXPECT_EQ(planner_->RestorePlan(
+                make_plan({{2, 0, 1, 0, 12}, {2, 0, 1, 12, 12}})),
+            kTfLiteError);
+  EXPECT_FALSE(planner_->HasRestoredPlan());
+
+  // Planning falls back to the default plan.
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+}
+
+TEST(BestFitSearchStrategyTest, ReducesFragmentation) {
+  TfLiteContext context;
+  context.ReportError = ReportError;
+  auto alloc = [](int32_t tensor, size_t size, int32_t first_node,
+                  int32_t last_node) {
+    ArenaAllocWithUsageInterval alloc;
+    alloc.tensor = tensor;
+    alloc.size = size;
+    alloc.first_node = first_node;
+    alloc.last_node = last_node;
+    return alloc;
+  };
+  // Sorted from largest to smallest, as done by the ArenaPlanner.
+  std::vector<ArenaAllocWithUsageInterval> allocs = {
+      alloc(0, 20, 0, 1), alloc(1, 20, 3, 5), alloc(2, 16, 0, 2),
+      alloc(3, 12, 2, 4), alloc(4, 4, 2, 4),
+  };
+  auto cost = [&](std::vector<ArenaAllocWithUsageInterval>* order) {
+    return SimulateArenaAllocations(&context, kTensorAlignment, {},
+                                    /*node=*/0, order);
+  };
+
+  std::vector<ArenaAllocWithUsageInterval> greedy = allocs;
+  EXPECT_EQ(cost(&greedy), 52);
+
+  BestFitSearchStrategy strategy;
+  strategy.Order(cost, &allocs);
+  EXPECT_EQ(cost(&allocs), 36);
+
+  std::vector<int32_t> tensors;
+  for (const auto& alloc : allocs) tensors.push_back(alloc.tensor);
+  std::sort(tensors.begin(), tensors.end());
+  EXPECT_EQ(tensors, std::vector<int32_t>({0, 1, 2, 3, 4}));
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentNodesDoNotShareMemory) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {4}},    // First op
+                      {{0}, {2}, {5}},    // Second op
+                      {{1, 2}, {3}, {}}  // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, graph.nodes().size() - 1);
+  // Run one at a time, the first two ops can use the same temporary memory.
+  EXPECT_EQ(GetOffset(4), GetOffset(5));
+
+  // Run concurrently, they can't.
+  planner_->SetExecutionStages({2, 3});
+  CHECK(planner_->PlanAllocations() == kTfLiteOk);
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_TRUE(GetOffset(4) >= GetOffsetAfter(5) ||
+              GetOffset(5) >= GetOffsetAfter(4));
+
+  // Back to one at a time.
+  planner_->SetExecutionStages({});
+  CHECK(planner_->PlanAllocations() == kTfLiteOk);
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_EQ(GetOffset(4), GetOffset(5));
+}
+
 TEST_F(ArenaPlannerTest, SimpleProfilerTest) {
   gNumAlloc = 0;
   gNumDealloc = 0;
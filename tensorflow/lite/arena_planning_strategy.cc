@@ -0,0 +1,137 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/arena_planning_strategy.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/simple_memory_arena.h"
+
+namespace tflite {
+namespace {
+
+using Alloc = ArenaAllocWithUsageInterval;
+
+int64_t Lifetime(const Alloc& alloc) {
+  return static_cast<int64_t>(alloc.last_node) - alloc.first_node + 1;
+}
+
+size_t End(const Alloc& alloc) { return alloc.offset + alloc.size; }
+
+}  // namespace
+
+size_t SimulateArenaAllocations(TfLiteContext* context, size_t alignment,
+                                const std::vector<Alloc>& existing,
+                                int32_t node, std::vector<Alloc>* allocs) {
+  SimpleMemoryArena arena(alignment);
+  arena.CalculateActiveAllocs(existing, node);
+  size_t arena_size = 0;
+  for (const Alloc& alloc : existing) {
+    if (alloc.first_node <= node && alloc.last_node >= node) {
+      arena_size = std::max(arena_size, End(alloc));
+    }
+  }
+  for (Alloc& alloc : *allocs) {
+    Alloc placed;
+    if (arena.Allocate(context, alignment, alloc.size, alloc.tensor,
+                       alloc.first_node, alloc.last_node,
+                       &placed) != kTfLiteOk) {
+      return std::numeric_limits<size_t>::max();
+    }
+    alloc.offset = placed.offset;
+    arena_size = std::max(arena_size, End(placed));
+  }
+  return arena_size;
+}
+
+void BestFitSearchStrategy::Order(const CostFunction& cost,
+                                  std::vector<Alloc>* allocs) {
+  if (allocs->size() < 2) return;
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point deadline =
+      Clock::now() + std::chrono::microseconds(time_budget_us_);
+  int num_evaluations = 0;
+  auto out_of_budget = [&]() {
+    return num_evaluations >= max_evaluations_ || Clock::now() >= deadline;
+  };
+
+  std::vector<Alloc> best = *allocs;
+  size_t best_size = cost(&best);
+  ++num_evaluations;
+  auto try_order = [&](std::vector<Alloc>* candidate) {
+    ++num_evaluations;
+    const size_t size = cost(candidate);
+    if (size >= best_size) return false;
+    best_size = size;
+    best.swap(*candidate);
+    return true;
+  };
+
+  // Seed the search with a few classic interval packing orders. The default
+  // order is used to break ties, so equal keys keep largest tensors first.
+  const std::function<bool(const Alloc&, const Alloc&)> orders[] = {
+      // Earliest allocated first, which mimics a stack allocator.
+      [](const Alloc& a, const Alloc& b) { return a.first_node < b.first_node; },
+      // Longest lived first, so that short-lived tensors fill the gaps.
+      [](const Alloc& a, const Alloc& b) { return Lifetime(a) > Lifetime(b); },
+      // Largest size-lifetime product first.
+      [](const Alloc& a, const Alloc& b) {
+        return static_cast<double>(a.size) * Lifetime(a) >
+               static_cast<double>(b.size) * Lifetime(b);
+      },
+  };
+  for (const auto& less : orders) {
+    if (out_of_budget()) break;
+    std::vector<Alloc> candidate = *allocs;
+    std::stable_sort(candidate.begin(), candidate.end(), less);
+    try_order(&candidate);
+  }
+
+  // Refine the best order found so far: the arena size is set by a single
+  // tensor, which can only get a lower offset if it is placed before some of
+  // the tensors it overlaps with. Moving it as early as possible is tried
+  // first, as that is the biggest change.
+  bool improved = true;
+  while (improved && !out_of_budget()) {
+    improved = false;
+    size_t peak = 0;
+    for (size_t i = 1; i < best.size(); ++i) {
+      if (End(best[i]) > End(best[peak])) peak = i;
+    }
+    // The arena size is set by allocations which are not reordered.
+    if (End(best[peak]) < best_size) break;
+    for (size_t pos = 0; pos < peak && !out_of_budget(); ++pos) {
+      std::vector<Alloc> candidate = best;
+      std::rotate(candidate.begin() + pos, candidate.begin() + peak,
+                  candidate.begin() + peak + 1);
+      if (try_order(&candidate)) {
+        improved = true;
+        break;
+      }
+    }
+  }
+
+  *allocs = std::move(best);
+}
+
+}  // namespace tflite
@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_ARENA_PLANNING_STRATEGY_H_
+#define TENSORFLOW_LITE_ARENA_PLANNING_STRATEGY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/simple_memory_arena.h"
+
+namespace tflite {
+
+// Places `allocs` one after the other with the same best-fit policy as
+// `SimpleMemoryArena::Allocate`, on top of the allocations in `existing` which
+// are live at `node`, and sets their offsets. Returns the size of the arena
+// needed to hold all of them.
+size_t SimulateArenaAllocations(
+    TfLiteContext* context, size_t alignment,
+    const std::vector<ArenaAllocWithUsageInterval>& existing, int32_t node,
+    std::vector<ArenaAllocWithUsageInterval>* allocs);
+
+// Decides in which order the ArenaPlanner assigns offsets to the tensors of
+// the non-persistent arena. Since each tensor is placed in the best-fitting
+// gap left by the tensors before it, the order determines how fragmented the
+// arena is, and hence its size.
+class ArenaPlanningStrategy {
+ public:
+  // Sets the offset of each of the given allocations, placing them in order,
+  // and returns the resulting arena size.
+  using CostFunction =
+      std::function<size_t(std::vector<ArenaAllocWithUsageInterval>*)>;
+
+  virtual ~ArenaPlanningStrategy() = default;
+
+  // Reorders `allocs`, whose `tensor`, `size`, `first_node` and `last_node`
+  // are set. On entry, `allocs` is sorted in the default order: from largest
+  // to smallest, ties broken by allocation time. `cost` may be used to
+  // evaluate candidate orders.
+  virtual void Order(const CostFunction& cost,
+                     std::vector<ArenaAllocWithUsageInterval>* allocs) = 0;
+};
+
+// Searches for the allocation order yielding the smallest arena.
+//
+// Several orders (by size, by allocation time, by lifetime, by size-lifetime
+// product) are evaluated first. The best one is then refined by repeatedly
+// moving the tensor that defines the arena size earlier in the order, which
+// lets it claim a lower offset, until no move helps or the budget runs out.
+// The default order is always a candidate, so the result is never worse than
+// the default greedy plan.
+class BestFitSearchStrategy : public ArenaPlanningStrategy {
+ public:
+  static constexpr int64_t kDefaultTimeBudgetUs = 10000;
+  static constexpr int kDefaultMaxEvaluations = 1000;
+
+  // The search stops after `time_budget_us` microseconds or
+  // `max_evaluations` calls to the cost function, whichever comes first.
+  explicit BestFitSearchStrategy(int64_t time_budget_us = kDefaultTimeBudgetUs,
+                                 int max_evaluations = kDefaultMaxEvaluations)
+      : time_budget_us_(time_budget_us), max_evaluations_(max_evaluations) {}
+
+  void Order(const CostFunction& cost,
+             std::vector<ArenaAllocWithUsageInterval>* allocs) override;
+
+ private:
+  const int64_t time_budget_us_;
+  const int max_evaluations_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_ARENA_PLANNING_STRATEGY_H_
@@ -39,6 +39,16 @@ static TfLiteDelegate* CreateDelegate(const void* settings) {
     if (xnnpack_settings->flags()) {
       options.flags = xnnpack_settings->flags();
     }
+    if (xnnpack_settings->unpacked_weights_cache_dir() != nullptr &&
+        xnnpack_settings->unpacked_weights_cache_dir()->size() > 0) {
+      options.experimental_unpacked_weights_cache_dir =
+          xnnpack_settings->unpacked_weights_cache_dir()->c_str();
+    }
+    if (xnnpack_settings->unpacked_weights_cache_model_token() != nullptr &&
+        xnnpack_settings->unpacked_weights_cache_model_token()->size() > 0) {
+      options.experimental_unpacked_weights_cache_model_token =
+          xnnpack_settings->unpacked_weights_cache_model_token()->c_str();
+    }
   }
   return TfLiteXNNPackDelegateCreate(&options);
 }
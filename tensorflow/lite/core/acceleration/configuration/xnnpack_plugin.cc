@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <memory>
+#include <string>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/lite/acceleration/configuration/configuration_generated.h"
@@ -24,6 +25,14 @@ namespace delegates {
 class XNNPackPlugin : public DelegatePluginInterface {
  public:
   TfLiteDelegatePtr Create() override {
+    options_.experimental_unpacked_weights_cache_dir =
+        unpacked_weights_cache_dir_.empty()
+            ? nullptr
+            : unpacked_weights_cache_dir_.c_str();
+    options_.experimental_unpacked_weights_cache_model_token =
+        unpacked_weights_cache_model_token_.empty()
+            ? nullptr
+            : unpacked_weights_cache_model_token_.c_str();
     return TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&options_),
                              TfLiteXNNPackDelegateDelete);
   }
@@ -38,11 +47,23 @@ class XNNPackPlugin : public DelegatePluginInterface {
     if (xnnpack_settings) {
       options_.num_threads = xnnpack_settings->num_threads();
       options_.flags = xnnpack_settings->flags();
+      if (xnnpack_settings->unpacked_weights_cache_dir() != nullptr) {
+        unpacked_weights_cache_dir_ =
+            xnnpack_settings->unpacked_weights_cache_dir()->str();
+      }
+      if (xnnpack_settings->unpacked_weights_cache_model_token() != nullptr) {
+        unpacked_weights_cache_model_token_ =
+            xnnpack_settings->unpacked_weights_cache_model_token()->str();
+      }
     }
   }
 
  private:
   TfLiteXNNPackDelegateOptions options_;
+  // Own the strings of the unpacked weights cache options in `options_`, as
+  // the settings may not outlive the plugin.
+  std::string unpacked_weights_cache_dir_;
+  std::string unpacked_weights_cache_model_token_;
 };
 
 TFLITE_REGISTER_DELEGATE_FACTORY_FUNCTION(XNNPackPlugin, XNNPackPlugin::New);
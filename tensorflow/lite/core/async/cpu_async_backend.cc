@@ -0,0 +1,722 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/async/cpu_async_backend.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/core/async/backend_async_kernel_interface.h"
+#include "tensorflow/lite/core/async/c/task.h"
+#include "tensorflow/lite/core/async/c/types.h"
+#include "tensorflow/lite/core/async/interop/c/attribute_map.h"
+#include "tensorflow/lite/core/async/interop/c/constants.h"
+#include "tensorflow/lite/core/async/interop/c/types.h"
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/delegates/utils/async_type_helpers.h"
+#include "tensorflow/lite/delegates/utils/ret_macros.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+namespace async {
+namespace {
+
+using delegates::utils::BufferAttributes;
+using delegates::utils::ReadBufferAttrs;
+using delegates::utils::WriteBufferAttrs;
+
+bool IsPowerOfTwo(size_t x) { return x && ((x & (x - 1)) == 0); }
+
+// Returns true if a subgraph of `interpreter` has variable or resource
+// tensors, whose values carry over from one invocation to the next.
+bool HasState(const Interpreter& interpreter) {
+  for (size_t i = 0; i < interpreter.subgraphs_size(); ++i) {
+    const Subgraph* subgraph = interpreter.subgraph(i);
+    for (size_t j = 0; j < subgraph->tensors_size(); ++j) {
+      const TfLiteTensor* tensor = subgraph->tensor(j);
+      if (tensor->is_variable || tensor->type == kTfLiteResource) return true;
+    }
+  }
+  return false;
+}
+
+bool HasType(const char* type, const char* expected) {
+  return type != nullptr && std::strcmp(type, expected) == 0;
+}
+
+const char* GetBufferType(const TfLiteAttributeMap* attrs) {
+  const char* type = nullptr;
+  TfLiteAttributeMapGetStringBufferAttr(
+      attrs, kTfLiteBufferAttrKeyResourceTypeName, &type);
+  return type;
+}
+
+const char* GetSyncType(const TfLiteAttributeMap* attrs) {
+  const char* type = nullptr;
+  TfLiteAttributeMapGetStringSyncAttr(
+      attrs, kTfLiteSynchronizationAttrKeyObjectTypeName, &type);
+  return type;
+}
+
+// The async kernel of a subgraph executed by the CpuAsyncBackend. The buffers
+// and synchronizations of a task are resolved at Eval, which schedules a job
+// on the workers and returns.
+class CpuAsyncKernel : public delegates::BackendAsyncKernelInterface {
+ public:
+  CpuAsyncKernel(CpuAsyncBackend* backend, int subgraph_index,
+                 const Subgraph* worker_subgraph)
+      : backend_(backend),
+        subgraph_index_(subgraph_index),
+        worker_subgraph_(worker_subgraph) {}
+
+  int subgraph_index() const { return subgraph_index_; }
+  const Subgraph* worker_subgraph() const { return worker_subgraph_; }
+
+  TfLiteStatus RegisterBuffer(TfLiteOpaqueContext* context,
+                              TfLiteIoType io_type,
+                              const TfLiteBackendBuffer* buffer,
+                              const TfLiteAttributeMap* attrs,
+                              TfLiteBufferHandle handle) override;
+  TfLiteStatus RegisterBufferSlice(TfLiteOpaqueContext* context,
+                                   TfLiteBufferHandle buffer_pool,
+                                   const TfLiteAttributeMap* attrs,
+                                   TfLiteBufferHandle handle) override;
+  TfLiteStatus UnregisterBuffer(TfLiteOpaqueContext* context,
+                                TfLiteBufferHandle handle) override;
+
+  const std::vector<const char*>& SupportedBufferTypes(
+      TfLiteIoType io_type) const override {
+    static const std::vector<const char*>* types =
+        new std::vector<const char*>{kCpuAsyncBufferTypeMemory};
+    return *types;
+  }
+  const std::vector<const char*>& SupportedSynchronizations(
+      TfLiteIoType io_type) const override {
+    static const std::vector<const char*>* types =
+        new std::vector<const char*>{kTfLiteSyncTypeNoSyncObj,
+                                     kCpuAsyncSyncTypeFence};
+    return *types;
+  }
+
+  bool ReconcileRestrictions(const TfLiteOpaqueContext* context,
+                             const TfLiteOpaqueNode* node, int tensor_index,
+                             const TfLiteAttributeMap* user_provided_attributes,
+                             TfLiteAttributeMap* merged,
+                             TfLiteAttributeMap* conflict) const override;
+  TfLiteStatus SetAttributes(TfLiteOpaqueContext* context,
+                             TfLiteOpaqueNode* node, int tensor_index,
+                             const TfLiteAttributeMap* attrs) override;
+  TfLiteStatus Prepare(TfLiteOpaqueContext* context,
+                       TfLiteOpaqueNode* node) override;
+
+  TfLiteStatus Eval(TfLiteOpaqueContext* context, TfLiteOpaqueNode* node,
+                    TfLiteExecutionTask* task) override;
+  TfLiteStatus Wait(TfLiteOpaqueContext* context,
+                    TfLiteExecutionTask* task) override;
+  TfLiteStatus Finish(TfLiteOpaqueContext* context,
+                      TfLiteExecutionTask* task) override;
+
+ private:
+  // `size` bytes of CPU memory at `data`.
+  struct Buffer {
+    char* data;
+    size_t size;
+    bool is_slice;
+  };
+
+  // The delegate execution data of a task.
+  struct TaskData {
+    std::shared_ptr<CpuAsyncBackend::Job> job;
+  };
+
+  // Appends the copies of `tensor_indices` to `copies`.
+  TfLiteStatus ResolveBuffers(TfLiteExecutionTask* task,
+                              const std::vector<int>& tensor_indices,
+                              std::vector<CpuAsyncBackend::TensorCopy>* copies);
+
+  bool UsesFence(int tensor_index) const {
+    auto it = fence_by_tensor_index_.find(tensor_index);
+    return it != fence_by_tensor_index_.end() && it->second;
+  }
+
+  CpuAsyncBackend* const backend_;
+  const int subgraph_index_;
+  const Subgraph* const worker_subgraph_;
+
+  std::mutex mutex_;
+  std::unordered_map<TfLiteBufferHandle, Buffer> buffer_by_handle_;
+  // Whether the tensors are synchronized with CpuSyncFence.
+  std::map<int, bool> fence_by_tensor_index_;
+  bool prepared_ = false;
+};
+
+TfLiteStatus CpuAsyncKernel::RegisterBuffer(TfLiteOpaqueContext* context,
+                                            TfLiteIoType io_type,
+                                            const TfLiteBackendBuffer* buffer,
+                                            const TfLiteAttributeMap* attrs,
+                                            TfLiteBufferHandle handle) {
+  TFLITE_ABORT_CHECK(buffer != nullptr, "");                  // Crash OK
+  TFLITE_ABORT_CHECK(attrs != nullptr, "");                   // Crash OK
+  TFLITE_ABORT_CHECK(handle != kTfLiteNullBufferHandle, "");  // Crash OK
+  TFLITE_RET_CHECK_STATUS(
+      TfLiteAttributeMapIsBufferAttributeMap(attrs),
+      "calling RegisterBuffer with invalid attribute map type");
+  TFLITE_RET_CHECK_STATUS(
+      HasType(GetBufferType(attrs), kCpuAsyncBufferTypeMemory),
+      "calling RegisterBuffer with a buffer type other than cpu_memory");
+  const BufferAttributes buffer_attrs = ReadBufferAttrs(attrs);
+  TFLITE_RET_CHECK_STATUS(
+      buffer_attrs.size.has_value(),
+      "calling RegisterBuffer with buffer size unspecified");
+  auto* data = static_cast<char*>(TfLiteBackendBufferGetPtr(buffer));
+  TFLITE_RET_CHECK_STATUS(data != nullptr,
+                          "calling RegisterBuffer with nullptr buffer");
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool inserted =
+      buffer_by_handle_
+          .try_emplace(handle,
+                       Buffer{data + buffer_attrs.offset.value_or(0),
+                              buffer_attrs.size.value(), /*is_slice=*/false})
+          .second;
+  TFLITE_RET_CHECK_STATUS(inserted,
+                          "RegisterBuffer called with duplicate handle");
+  return kTfLiteOk;
+}
+
+TfLiteStatus CpuAsyncKernel::RegisterBufferSlice(
+    TfLiteOpaqueContext* context, TfLiteBufferHandle buffer_pool,
+    const TfLiteAttributeMap* attrs, TfLiteBufferHandle handle) {
+  TFLITE_ABORT_CHECK(attrs != nullptr, "");                   // Crash OK
+  TFLITE_ABORT_CHECK(handle != kTfLiteNullBufferHandle, "");  // Crash OK
+  TFLITE_RET_CHECK_STATUS(
+      TfLiteAttributeMapIsBufferAttributeMap(attrs),
+      "calling RegisterBufferSlice with invalid attribute map type");
+  const BufferAttributes buffer_attrs = ReadBufferAttrs(attrs);
+  TFLITE_RET_CHECK_STATUS(
+      buffer_attrs.size.has_value(),
+      "calling RegisterBufferSlice with slice size unspecified");
+  const size_t offset = buffer_attrs.offset.value_or(0);
+  const size_t size = buffer_attrs.size.value();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto pool = buffer_by_handle_.find(buffer_pool);
+  TFLITE_RET_CHECK_STATUS(pool != buffer_by_handle_.end(),
+                          "RegisterBufferSlice called with unknown pool");
+  TFLITE_RET_CHECK_STATUS(!pool->second.is_slice,
+                          "RegisterBufferSlice called with a slice as pool");
+  TFLITE_RET_CHECK_STATUS(
+      offset <= pool->second.size && size <= pool->second.size - offset,
+      "RegisterBufferSlice called with a slice out of the pool");
+  const bool inserted =
+      buffer_by_handle_
+          .try_emplace(handle, Buffer{pool->second.data + offset, size,
+                                      /*is_slice=*/true})
+          .second;
+  TFLITE_RET_CHECK_STATUS(inserted,
+                          "RegisterBufferSlice called with duplicate handle");
+  return kTfLiteOk;
+}
+
+TfLiteStatus CpuAsyncKernel::UnregisterBuffer(TfLiteOpaqueContext* context,
+                                              TfLiteBufferHandle handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = buffer_by_handle_.find(handle);
+  TFLITE_RET_CHECK_STATUS(it != buffer_by_handle_.end(),
+                          "UnregisterBuffer called with unknown handle");
+  buffer_by_handle_.erase(it);
+  return kTfLiteOk;
+}
+
+bool CpuAsyncKernel::ReconcileRestrictions(
+    const TfLiteOpaqueContext* context, const TfLiteOpaqueNode* node,
+    int tensor_index, const TfLiteAttributeMap* user_provided_attributes,
+    TfLiteAttributeMap* merged, TfLiteAttributeMap* conflict) const {
+  TFLITE_ABORT_CHECK(user_provided_attributes != nullptr, "");  // Crash OK
+  TFLITE_ABORT_CHECK(merged != nullptr, "");                    // Crash OK
+  const TfLiteTensor* tensor = worker_subgraph_->tensor(tensor_index);
+  if (tensor == nullptr) return false;
+
+  if (TfLiteAttributeMapIsBufferAttributeMap(user_provided_attributes)) {
+    if (!TfLiteAttributeMapIsBufferAttributeMap(merged) ||
+        (conflict != nullptr &&
+         !TfLiteAttributeMapIsBufferAttributeMap(conflict))) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "'merged' or 'conflict' have a different attribute map "
+                      "type than 'user_provided_attributes'");
+      return false;
+    }
+    const char* type = GetBufferType(user_provided_attributes);
+    if (type != nullptr && !HasType(type, kCpuAsyncBufferTypeMemory)) {
+      if (conflict != nullptr) {
+        TfLiteAttributeMapSetStringBufferAttr(
+            conflict, kTfLiteBufferAttrKeyResourceTypeName,
+            kCpuAsyncBufferTypeMemory);
+      }
+      return false;
+    }
+    const BufferAttributes user = ReadBufferAttrs(user_provided_attributes);
+    BufferAttributes merged_attrs{};
+    BufferAttributes conflict_attrs{};
+    bool ok = true;
+    if (user.alignment.has_value()) {
+      if (IsPowerOfTwo(user.alignment.value())) {
+        merged_attrs.alignment = user.alignment;
+      } else {
+        conflict_attrs.alignment = alignof(std::max_align_t);
+        ok = false;
+      }
+    }
+    merged_attrs.padding = user.padding;
+    merged_attrs.offset = user.offset;
+    merged_attrs.size = std::max(user.size.value_or(0), tensor->bytes);
+    WriteBufferAttrs(merged_attrs, merged);
+    TfLiteAttributeMapSetStringBufferAttr(
+        merged, kTfLiteBufferAttrKeyResourceTypeName,
+        kCpuAsyncBufferTypeMemory);
+    if (conflict != nullptr) WriteBufferAttrs(conflict_attrs, conflict);
+    return ok;
+  }
+  if (TfLiteAttributeMapIsSyncAttributeMap(user_provided_attributes)) {
+    if (!TfLiteAttributeMapIsSyncAttributeMap(merged) ||
+        (conflict != nullptr &&
+         !TfLiteAttributeMapIsSyncAttributeMap(conflict))) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "'merged' or 'conflict' have a different attribute map "
+                      "type than 'user_provided_attributes'");
+      return false;
+    }
+    const char* type = GetSyncType(user_provided_attributes);
+    if (type == nullptr) type = kTfLiteSyncTypeNoSyncObj;
+    if (!HasType(type, kTfLiteSyncTypeNoSyncObj) &&
+        !HasType(type, kCpuAsyncSyncTypeFence)) {
+      if (conflict != nullptr) {
+        TfLiteAttributeMapSetStringSyncAttr(
+            conflict, kTfLiteSynchronizationAttrKeyObjectTypeName,
+            kCpuAsyncSyncTypeFence);
+      }
+      return false;
+    }
+    TfLiteAttributeMapSetStringSyncAttr(
+        merged, kTfLiteSynchronizationAttrKeyObjectTypeName,
+        HasType(type, kCpuAsyncSyncTypeFence) ? kCpuAsyncSyncTypeFence
+                                              : kTfLiteSyncTypeNoSyncObj);
+    return true;
+  }
+  TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "unknown type of user_provided_attributes");
+  return false;
+}
+
+TfLiteStatus CpuAsyncKernel::SetAttributes(TfLiteOpaqueContext* context,
+                                           TfLiteOpaqueNode* node,
+                                           int tensor_index,
+                                           const TfLiteAttributeMap* attrs) {
+  if (TfLiteAttributeMapIsBufferAttributeMap(attrs)) {
+    const char* type = GetBufferType(attrs);
+    TFLITE_RET_CHECK_STATUS(
+        type == nullptr || HasType(type, kCpuAsyncBufferTypeMemory),
+        "calling SetAttributes with a buffer type other than cpu_memory");
+    return kTfLiteOk;
+  }
+  TFLITE_RET_CHECK_STATUS(
+      TfLiteAttributeMapIsSyncAttributeMap(attrs),
+      "calling SetAttributes with an invalid attribute map type");
+  const char* type = GetSyncType(attrs);
+  TFLITE_RET_CHECK_STATUS(
+      type != nullptr,
+      "calling SetAttributes with sync object type name unspecified");
+  const bool uses_fence = HasType(type, kCpuAsyncSyncTypeFence);
+  TFLITE_RET_CHECK_STATUS(
+      uses_fence || HasType(type, kTfLiteSyncTypeNoSyncObj),
+      "calling SetAttributes with unknown sync object type name");
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  TFLITE_RET_CHECK_STATUS(!prepared_,
+                          "SetAttributes must be called before Prepare");
+  fence_by_tensor_index_[tensor_index] = uses_fence;
+  return kTfLiteOk;
+}
+
+TfLiteStatus CpuAsyncKernel::Prepare(TfLiteOpaqueContext* context,
+                                     TfLiteOpaqueNode* node) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  prepared_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus CpuAsyncKernel::ResolveBuffers(
+    TfLiteExecutionTask* task, const std::vector<int>& tensor_indices,
+    std::vector<CpuAsyncBackend::TensorCopy>* copies) {
+  for (int tensor_index : tensor_indices) {
+    const TfLiteBufferHandle handle =
+        TfLiteExecutionTaskGetBufferByIndex(task, tensor_index);
+    auto it = buffer_by_handle_.find(handle);
+    TFLITE_RET_CHECK_STATUS(it != buffer_by_handle_.end(),
+                            "no buffer registered for a tensor of the task");
+    TFLITE_RET_CHECK_STATUS(
+        it->second.size >= worker_subgraph_->tensor(tensor_index)->bytes,
+        "the buffer of a tensor of the task is smaller than the tensor");
+    copies->push_back({tensor_index, it->second.data, it->second.size});
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus CpuAsyncKernel::Eval(TfLiteOpaqueContext* context,
+                                  TfLiteOpaqueNode* node,
+                                  TfLiteExecutionTask* task) {
+  auto job = std::make_shared<CpuAsyncBackend::Job>();
+  job->subgraph_index = subgraph_index_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TF_LITE_ENSURE_STATUS(
+        ResolveBuffers(task, worker_subgraph_->inputs(), &job->inputs));
+    TF_LITE_ENSURE_STATUS(
+        ResolveBuffers(task, worker_subgraph_->outputs(), &job->outputs));
+    for (int tensor_index : worker_subgraph_->inputs()) {
+      if (!UsesFence(tensor_index)) continue;
+      TfLiteSynchronization* sync =
+          TfLiteExecutionTaskGetSyncByIndex(task, tensor_index);
+      if (sync == nullptr) continue;
+      auto* fence =
+          static_cast<CpuSyncFence*>(TfLiteSynchronizationGetPtr(sync));
+      if (fence != nullptr) job->input_fences.push_back(*fence);
+    }
+    for (int tensor_index : worker_subgraph_->outputs()) {
+      if (!UsesFence(tensor_index)) continue;
+      TfLiteSynchronization* sync =
+          TfLiteExecutionTaskGetSyncByIndex(task, tensor_index);
+      if (sync == nullptr) continue;
+      auto* fence =
+          static_cast<CpuSyncFence*>(TfLiteSynchronizationGetPtr(sync));
+      if (fence == nullptr) {
+        fence = new CpuSyncFence();
+        TfLiteSynchronizationSetPtr(sync, fence);
+      } else {
+        fence->Reset();
+      }
+      job->output_fences.push_back(*fence);
+    }
+  }
+
+  // The task was waited for before being scheduled again, so the previous job
+  // is done.
+  auto* task_data = static_cast<TaskData*>(
+      TfLiteExecutionTaskGetDelegateExecutionData(task, kernel()));
+  if (task_data == nullptr) {
+    task_data = new TaskData();
+    TfLiteExecutionTaskSetDelegateExecutionData(task, kernel(), task_data);
+  }
+  task_data->job = job;
+  backend_->Schedule(std::move(job));
+  return kTfLiteOk;
+}
+
+TfLiteStatus CpuAsyncKernel::Wait(TfLiteOpaqueContext* context,
+                                  TfLiteExecutionTask* task) {
+  auto* task_data = static_cast<TaskData*>(
+      TfLiteExecutionTaskGetDelegateExecutionData(task, kernel()));
+  TFLITE_RET_CHECK_STATUS(task_data != nullptr && task_data->job != nullptr,
+                          "Wait called on a task that was never scheduled");
+  return task_data->job->done.Wait();
+}
+
+TfLiteStatus CpuAsyncKernel::Finish(TfLiteOpaqueContext* context,
+                                    TfLiteExecutionTask* task) {
+  auto* task_data = static_cast<TaskData*>(
+      TfLiteExecutionTaskGetDelegateExecutionData(task, kernel()));
+  if (task_data == nullptr) return kTfLiteOk;
+  TfLiteStatus status = kTfLiteOk;
+  if (task_data->job != nullptr) status = task_data->job->done.Wait();
+  TfLiteExecutionTaskSetDelegateExecutionData(task, kernel(), nullptr);
+  delete task_data;
+  return status;
+}
+
+// Runs the subgraph on a worker synchronously, for Interpreter::Invoke.
+TfLiteStatus InvokeSynchronously(TfLiteContext* context,
+                                 CpuAsyncBackend* backend,
+                                 const CpuAsyncKernel& kernel) {
+  auto job = std::make_shared<CpuAsyncBackend::Job>();
+  job->subgraph_index = kernel.subgraph_index();
+  auto add_copies = [context](
+                        const std::vector<int>& tensor_indices,
+                        std::vector<CpuAsyncBackend::TensorCopy>* copies) {
+    for (int tensor_index : tensor_indices) {
+      TfLiteTensor* tensor = &context->tensors[tensor_index];
+      copies->push_back({tensor_index, tensor->data.raw, tensor->bytes});
+    }
+  };
+  const Subgraph* worker_subgraph = kernel.worker_subgraph();
+  add_copies(worker_subgraph->inputs(), &job->inputs);
+  add_copies(worker_subgraph->outputs(), &job->outputs);
+  backend->Schedule(job);
+  return job->done.Wait();
+}
+
+TfLiteStatus DelegatePrepare(TfLiteContext* context,
+                             TfLiteDelegate* delegate) {
+  auto* backend = static_cast<CpuAsyncBackend*>(delegate->data_);
+  // The following cast is safe only because this code is part of the
+  // TF Lite runtime implementation.
+  const int subgraph_index =
+      static_cast<Subgraph*>(context->impl_)->GetSubgraphIndex();
+  const Subgraph* worker_subgraph = backend->GetSubgraph(subgraph_index);
+  // The other subgraphs, e.g. the bodies of control flow ops, are run by the
+  // workers along with the subgraphs calling them.
+  if (worker_subgraph == nullptr) return kTfLiteOk;
+  if (worker_subgraph->tensors_size() != context->tensors_size) {
+    TF_LITE_KERNEL_LOG(context,
+                       "The model of the interpreter differs from the model "
+                       "of the workers of the CPU async backend.");
+    return kTfLiteError;
+  }
+
+  TfLiteRegistration registration{};
+  registration.init = [](TfLiteContext* context, const char* buffer,
+                         size_t length) -> void* {
+    const auto* params = reinterpret_cast<const TfLiteDelegateParams*>(buffer);
+    auto* backend = static_cast<CpuAsyncBackend*>(params->delegate->data_);
+    const int subgraph_index =
+        static_cast<Subgraph*>(context->impl_)->GetSubgraphIndex();
+    return new CpuAsyncKernel(backend, subgraph_index,
+                              backend->GetSubgraph(subgraph_index));
+  };
+  registration.free = [](TfLiteContext* context, void* buffer) -> void {
+    delete static_cast<CpuAsyncKernel*>(buffer);
+  };
+  registration.prepare = [](TfLiteContext* context,
+                            TfLiteNode* node) -> TfLiteStatus {
+    // The tensors of the workers are allocated once, so the inputs can't be
+    // resized.
+    const auto* kernel = static_cast<CpuAsyncKernel*>(node->user_data);
+    for (int tensor_index : kernel->worker_subgraph()->inputs()) {
+      TF_LITE_ENSURE(
+          context,
+          TfLiteIntArrayEqual(
+              context->tensors[tensor_index].dims,
+              kernel->worker_subgraph()->tensor(tensor_index)->dims));
+    }
+    return kTfLiteOk;
+  };
+  registration.invoke = [](TfLiteContext* context,
+                           TfLiteNode* node) -> TfLiteStatus {
+    const auto* kernel = static_cast<CpuAsyncKernel*>(node->user_data);
+    auto* backend = static_cast<CpuAsyncBackend*>(node->delegate->data_);
+    return InvokeSynchronously(context, backend, *kernel);
+  };
+  registration.async_kernel = [](TfLiteContext* context,
+                                 TfLiteNode* node) -> TfLiteAsyncKernel* {
+    return static_cast<CpuAsyncKernel*>(node->user_data)->kernel();
+  };
+  registration.builtin_code = kTfLiteBuiltinDelegate;
+  registration.custom_name = "CpuAsyncBackend";
+  registration.version = 1;
+
+  TfLiteIntArray* execution_plan = nullptr;
+  TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &execution_plan));
+  return context->ReplaceNodeSubsetsWithDelegateKernels(
+      context, registration, execution_plan, delegate);
+}
+
+}  // namespace
+
+CpuSyncFence::CpuSyncFence() : state_(std::make_shared<State>()) {}
+
+void CpuSyncFence::Signal(TfLiteStatus status) {
+  // The fence may be reset once signalled, so the state is kept alive until
+  // the waiters are notified.
+  std::shared_ptr<State> state = state_;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->signalled) return;
+    state->signalled = true;
+    state->status = status;
+  }
+  state->signalled_cv.notify_all();
+}
+
+TfLiteStatus CpuSyncFence::Wait() const {
+  std::shared_ptr<State> state = state_;
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->signalled_cv.wait(lock, [&state] { return state->signalled; });
+  return state->status;
+}
+
+bool CpuSyncFence::IsSignalled() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->signalled;
+}
+
+void CpuSyncFence::Reset() { state_ = std::make_shared<State>(); }
+
+std::unique_ptr<CpuAsyncBackend> CpuAsyncBackend::Create(
+    const InterpreterFactory& interpreter_factory, const Options& options) {
+  if (options.num_workers < 1) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                    "The CPU async backend needs at least 1 worker.");
+    return nullptr;
+  }
+  std::unique_ptr<CpuAsyncBackend> backend(new CpuAsyncBackend());
+  int num_workers = options.num_workers;
+  for (int i = 0; i < num_workers; ++i) {
+    std::unique_ptr<Interpreter> interpreter = interpreter_factory();
+    if (interpreter == nullptr) return nullptr;
+    if (i == 0) {
+      if (num_workers > 1 && HasState(*interpreter)) {
+        // The state would diverge between the interpreters of the workers.
+        TFLITE_LOG_PROD(TFLITE_LOG_WARNING,
+                        "The model has variable or resource tensors, so the "
+                        "CPU async backend runs it on a single worker.");
+        num_workers = 1;
+      }
+      backend->supported_subgraphs_.push_back(0);
+      for (const std::string* key : interpreter->signature_keys()) {
+        const int subgraph_index =
+            interpreter->GetSubgraphIndexFromSignature(key->c_str());
+        if (subgraph_index > 0) {
+          backend->supported_subgraphs_.push_back(subgraph_index);
+        }
+      }
+    }
+    // The tensors are allocated before the workers start, as the backend
+    // doesn't support resizing them.
+    for (int subgraph_index : backend->supported_subgraphs_) {
+      Subgraph* subgraph = interpreter->subgraph(subgraph_index);
+      if (subgraph == nullptr || subgraph->AllocateTensors() != kTfLiteOk) {
+        TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                        "Failed to allocate the tensors of subgraph %d of a "
+                        "worker of the CPU async backend.",
+                        subgraph_index);
+        return nullptr;
+      }
+    }
+    backend->interpreters_.push_back(std::move(interpreter));
+  }
+
+  backend->delegate_ = TfLiteDelegateCreate();
+  backend->delegate_.data_ = backend.get();
+  backend->delegate_.Prepare = DelegatePrepare;
+  for (auto& interpreter : backend->interpreters_) {
+    backend->workers_.emplace_back(&CpuAsyncBackend::RunWorker, backend.get(),
+                                   interpreter.get());
+  }
+  return backend;
+}
+
+std::unique_ptr<CpuAsyncBackend> CpuAsyncBackend::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    int num_threads, const Options& options) {
+  return Create(
+      [&]() -> std::unique_ptr<Interpreter> {
+        std::unique_ptr<Interpreter> interpreter;
+        InterpreterBuilder builder(model, op_resolver);
+        builder.SetNumThreads(num_threads);
+        if (builder(&interpreter) != kTfLiteOk) return nullptr;
+        return interpreter;
+      },
+      options);
+}
+
+CpuAsyncBackend::~CpuAsyncBackend() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  jobs_cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+  for (const std::shared_ptr<Job>& job : jobs_) {
+    for (CpuSyncFence& fence : job->output_fences) {
+      fence.Signal(kTfLiteCancelled);
+    }
+    job->done.Signal(kTfLiteCancelled);
+  }
+}
+
+const Subgraph* CpuAsyncBackend::GetSubgraph(int subgraph_index) const {
+  if (std::find(supported_subgraphs_.begin(), supported_subgraphs_.end(),
+                subgraph_index) == supported_subgraphs_.end()) {
+    return nullptr;
+  }
+  return interpreters_[0]->subgraph(subgraph_index);
+}
+
+void CpuAsyncBackend::Schedule(std::shared_ptr<Job> job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stopping_) {
+      jobs_.push_back(std::move(job));
+      job = nullptr;
+    }
+  }
+  if (job != nullptr) {
+    for (CpuSyncFence& fence : job->output_fences) {
+      fence.Signal(kTfLiteCancelled);
+    }
+    job->done.Signal(kTfLiteCancelled);
+    return;
+  }
+  jobs_cv_.notify_one();
+}
+
+void CpuAsyncBackend::RunWorker(Interpreter* interpreter) {
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobs_cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (stopping_) return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    const TfLiteStatus status = RunJob(interpreter, *job);
+    for (CpuSyncFence& fence : job->output_fences) fence.Signal(status);
+    job->done.Signal(status);
+  }
+}
+
+TfLiteStatus CpuAsyncBackend::RunJob(Interpreter* interpreter,
+                                     const Job& job) {
+  for (const CpuSyncFence& fence : job.input_fences) {
+    TF_LITE_ENSURE_STATUS(fence.Wait());
+  }
+  Subgraph* subgraph = interpreter->subgraph(job.subgraph_index);
+  for (const TensorCopy& input : job.inputs) {
+    TfLiteTensor* tensor = subgraph->tensor(input.tensor_index);
+    if (input.size < tensor->bytes) return kTfLiteError;
+    std::memcpy(tensor->data.raw, input.data, tensor->bytes);
+  }
+  TF_LITE_ENSURE_STATUS(subgraph->Invoke());
+  for (const TensorCopy& output : job.outputs) {
+    const TfLiteTensor* tensor = subgraph->tensor(output.tensor_index);
+    if (output.size < tensor->bytes) return kTfLiteError;
+    std::memcpy(output.data, tensor->data.raw, tensor->bytes);
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace async
+}  // namespace tflite
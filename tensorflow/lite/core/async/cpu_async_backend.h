@@ -0,0 +1,184 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_ASYNC_CPU_ASYNC_BACKEND_H_
+#define TENSORFLOW_LITE_CORE_ASYNC_CPU_ASYNC_BACKEND_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/model_builder.h"
+#include "tensorflow/lite/core/subgraph.h"
+
+namespace tflite {
+namespace async {
+
+// Buffer type name of plain CPU memory. The TfLiteBackendBuffer holds a
+// pointer to the memory, whose size must be given with
+// kTfLiteBufferAttrKeySize.
+constexpr char kCpuAsyncBufferTypeMemory[] = "cpu_memory";
+
+// Synchronization type name of CpuSyncFence. The TfLiteSynchronization holds a
+// pointer to a CpuSyncFence.
+constexpr char kCpuAsyncSyncTypeFence[] = "cpu_sync_fence";
+
+// A synchronization object signalled once, from any thread, with the status of
+// the work it guards. Copies share the same state.
+//
+// Input fences are owned by the application, which may destroy them once
+// InvokeAsync returns. Output fences are created by the backend and owned by
+// the application; when the TfLiteSynchronization of an output already holds
+// a fence, e.g. from a previous invocation of the same task, that fence is
+// reset to the new invocation instead.
+class CpuSyncFence {
+ public:
+  CpuSyncFence();
+
+  // Signals the fence. Only the first call has an effect.
+  void Signal(TfLiteStatus status = kTfLiteOk);
+
+  // Blocks until the fence is signalled and returns the status it was
+  // signalled with.
+  TfLiteStatus Wait() const;
+
+  bool IsSignalled() const;
+
+  // Unsignals the fence for a new invocation. Must not be called while the
+  // fence is waited on.
+  void Reset();
+
+ private:
+  struct State {
+    mutable std::mutex mutex;
+    std::condition_variable signalled_cv;
+    bool signalled = false;
+    TfLiteStatus status = kTfLiteOk;
+  };
+  std::shared_ptr<State> state_;
+};
+
+// A backend of the asynchronous API executing models on CPU, for
+// AsyncSignatureRunner without an accelerator delegate.
+//
+// The backend is a delegate taking over the whole primary subgraph and the
+// subgraphs of the signatures of the interpreter it is applied to. Tasks are
+// executed by a pool of workers, each with its own interpreter of the same
+// model, so that several tasks are in flight at once: the application can
+// prepare the inputs of the next tasks and read the outputs of the previous
+// ones while a task runs. Each worker copies the registered input buffers into
+// its own input tensors and its output tensors into the registered output
+// buffers, so that the buffers of a task can be reused as soon as it completes.
+//
+// Buffers are kCpuAsyncBufferTypeMemory and synchronizations either
+// kTfLiteSyncTypeNoSyncObj or kCpuAsyncSyncTypeFence. A worker waits for the
+// fences of the inputs of its task before running it and signals the fences of
+// its outputs when done, so that a pipeline can submit tasks ahead of their
+// inputs and consume their outputs without calling Wait.
+//
+// Models with variable or resource tensors, e.g. the state of an LSTM or of
+// VAR_HANDLE ops, run on a single worker whatever the number of workers in
+// the options, as the state of the interpreter of each worker would diverge
+// from the others. Tasks then run one at a time, in the order they are
+// submitted.
+//
+// The backend must outlive the interpreters it is applied to. Synchronous
+// Interpreter::Invoke calls keep working and run on a worker as well.
+class CpuAsyncBackend {
+ public:
+  struct Options {
+    // The number of tasks executed at once. Further tasks wait for a worker.
+    // Models with state use a single worker.
+    int num_workers = 2;
+  };
+
+  // Creates a new interpreter of the model, not yet allocated.
+  using InterpreterFactory = std::function<std::unique_ptr<Interpreter>()>;
+
+  // Returns nullptr if the interpreters of the workers can't be created.
+  static std::unique_ptr<CpuAsyncBackend> Create(
+      const InterpreterFactory& interpreter_factory, const Options& options);
+
+  // Creates the interpreters of the workers from `model` with `num_threads`
+  // threads each.
+  static std::unique_ptr<CpuAsyncBackend> Create(const FlatBufferModel& model,
+                                                 const OpResolver& op_resolver,
+                                                 int num_threads,
+                                                 const Options& options);
+
+  // Cancels the queued tasks and waits for the running ones.
+  ~CpuAsyncBackend();
+
+  TfLiteDelegate* get_delegate() { return &delegate_; }
+
+  int num_workers() const { return static_cast<int>(workers_.size()); }
+
+  // A copy between the registered buffers and the tensors of a worker.
+  struct TensorCopy {
+    int tensor_index;
+    char* data;
+    size_t size;
+  };
+
+  // An execution of a subgraph by a worker.
+  struct Job {
+    int subgraph_index;
+    std::vector<TensorCopy> inputs;
+    std::vector<TensorCopy> outputs;
+    // Waited for before copying the inputs.
+    std::vector<CpuSyncFence> input_fences;
+    // Signalled once the outputs are copied, as well as `done`.
+    std::vector<CpuSyncFence> output_fences;
+    CpuSyncFence done;
+  };
+
+  // Returns the subgraph of the first worker with the same index, whose
+  // tensors are allocated, or nullptr if the backend doesn't execute it.
+  const Subgraph* GetSubgraph(int subgraph_index) const;
+
+  // Queues the job for the next free worker.
+  void Schedule(std::shared_ptr<Job> job);
+
+ private:
+  CpuAsyncBackend() = default;
+
+  void RunWorker(Interpreter* interpreter);
+
+  // Runs the job on `interpreter` and returns the status to signal.
+  static TfLiteStatus RunJob(Interpreter* interpreter, const Job& job);
+
+  TfLiteDelegate delegate_;
+  std::vector<std::unique_ptr<Interpreter>> interpreters_;
+  // The primary subgraph and the subgraphs of the signatures.
+  std::vector<int> supported_subgraphs_;
+
+  std::mutex mutex_;
+  std::condition_variable jobs_cv_;
+  std::deque<std::shared_ptr<Job>> jobs_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace async
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_ASYNC_CPU_ASYNC_BACKEND_H_
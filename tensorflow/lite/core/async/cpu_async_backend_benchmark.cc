@@ -0,0 +1,297 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Measures the throughput of a stream of requests, each preprocessed, run by
+// the model and postprocessed, with a synchronous Interpreter::Invoke loop
+// against a pipeline of the CpuAsyncBackend, where a producer thread
+// preprocesses the next requests and the main thread postprocesses the
+// previous ones while the workers run the model.
+//
+// Usage: cpu_async_backend_benchmark model.tflite [num_workers] [num_requests]
+//          [preprocess_us] [postprocess_us] [num_threads]
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/async/async_signature_runner.h"
+#include "tensorflow/lite/core/async/c/task.h"
+#include "tensorflow/lite/core/async/c/types.h"
+#include "tensorflow/lite/core/async/cpu_async_backend.h"
+#include "tensorflow/lite/core/async/interop/c/attribute_map.h"
+#include "tensorflow/lite/core/async/interop/c/types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/core/model_builder.h"
+
+namespace tflite {
+namespace async {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  int num_workers;
+  int num_requests;
+  int preprocess_us;
+  int postprocess_us;
+  int num_threads;
+};
+
+// Keeps the calling thread busy for `us` microseconds, like the processing of
+// a request by the application.
+void Spin(int us) {
+  const Clock::time_point end = Clock::now() + std::chrono::microseconds(us);
+  while (Clock::now() < end) {
+  }
+}
+
+// Writes the input of request `request` to `data`.
+void Preprocess(int request, int us, char* data, size_t size) {
+  Spin(us);
+  std::memset(data, request & 1, size);
+}
+
+// Reads the output of a request from `data`.
+char Postprocess(int us, const char* data, size_t size) {
+  Spin(us);
+  char checksum = 0;
+  for (size_t i = 0; i < size; ++i) checksum ^= data[i];
+  return checksum;
+}
+
+std::unique_ptr<Interpreter> BuildInterpreter(const FlatBufferModel& model,
+                                              int num_threads) {
+  ops::builtin::BuiltinOpResolver op_resolver;
+  std::unique_ptr<Interpreter> interpreter;
+  InterpreterBuilder builder(model, op_resolver);
+  builder.SetNumThreads(num_threads);
+  if (builder(&interpreter) != kTfLiteOk) return nullptr;
+  return interpreter;
+}
+
+// Returns the number of requests per second of the synchronous loop.
+double RunSynchronously(const FlatBufferModel& model, const Config& config) {
+  std::unique_ptr<Interpreter> interpreter =
+      BuildInterpreter(model, config.num_threads);
+  if (interpreter == nullptr || interpreter->AllocateTensors() != kTfLiteOk) {
+    return 0;
+  }
+  char checksum = 0;
+  const Clock::time_point start = Clock::now();
+  for (int request = 0; request < config.num_requests; ++request) {
+    for (int input : interpreter->inputs()) {
+      TfLiteTensor* tensor = interpreter->tensor(input);
+      Preprocess(request, config.preprocess_us, tensor->data.raw,
+                 tensor->bytes);
+    }
+    if (interpreter->Invoke() != kTfLiteOk) return 0;
+    for (int output : interpreter->outputs()) {
+      const TfLiteTensor* tensor = interpreter->tensor(output);
+      checksum ^= Postprocess(config.postprocess_us, tensor->data.raw,
+                              tensor->bytes);
+    }
+  }
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  fprintf(stderr, "checksum %d\n", checksum);
+  return config.num_requests / seconds;
+}
+
+// The buffers, fence and task of one of the requests in flight.
+struct Slot {
+  std::vector<std::vector<char>> inputs;
+  std::vector<std::vector<char>> outputs;
+  CpuSyncFence input_fence;
+  TfLiteSynchronization* input_sync = nullptr;
+  TfLiteExecutionTask* task = nullptr;
+};
+
+// Returns the number of requests per second of the pipeline.
+double RunPipelined(const FlatBufferModel& model, const Config& config) {
+  CpuAsyncBackend::Options options;
+  options.num_workers = config.num_workers;
+  std::unique_ptr<CpuAsyncBackend> backend = CpuAsyncBackend::Create(
+      [&]() { return BuildInterpreter(model, config.num_threads); }, options);
+  if (backend == nullptr) return 0;
+  std::unique_ptr<Interpreter> interpreter =
+      BuildInterpreter(model, config.num_threads);
+  if (interpreter == nullptr ||
+      interpreter->ModifyGraphWithDelegate(backend->get_delegate()) !=
+          kTfLiteOk) {
+    return 0;
+  }
+  AsyncSignatureRunner* runner = interpreter->GetAsyncSignatureRunner(nullptr);
+  if (runner == nullptr) {
+    fprintf(stderr, "The model has no signature.\n");
+    return 0;
+  }
+
+  TfLiteAttributeMap* sync_attrs =
+      TfLiteAttributeMapCreate(kTfLiteAttrMapTypeSync);
+  TfLiteAttributeMapSetStringSyncAttr(
+      sync_attrs, kTfLiteSynchronizationAttrKeyObjectTypeName,
+      kCpuAsyncSyncTypeFence);
+  for (int input : runner->inputs()) {
+    runner->SetAttributes(input, sync_attrs);
+  }
+  TfLiteAttributeMapDelete(sync_attrs);
+  if (runner->PrepareBackends() != kTfLiteOk) return 0;
+
+  // Registers `buffer` and binds it to `tensor_index` in `task`.
+  TfLiteAttributeMap* buffer_attrs =
+      TfLiteAttributeMapCreate(kTfLiteAttrMapTypeBuffer);
+  TfLiteAttributeMapSetStringBufferAttr(buffer_attrs,
+                                        kTfLiteBufferAttrKeyResourceTypeName,
+                                        kCpuAsyncBufferTypeMemory);
+  TfLiteBackendBuffer* backend_buffer = TfLiteBackendBufferCreate();
+  auto bind_buffer = [&](TfLiteIoType io_type, int tensor_index,
+                         std::vector<char>* buffer,
+                         TfLiteExecutionTask* task) {
+    buffer->resize(interpreter->tensor(tensor_index)->bytes);
+    TfLiteBackendBufferSetPtr(backend_buffer, buffer->data());
+    TfLiteAttributeMapSetSizeTBufferAttr(
+        buffer_attrs, kTfLiteBufferAttrKeySize, buffer->size());
+    TfLiteBufferHandle handle = kTfLiteNullBufferHandle;
+    runner->RegisterBuffer(io_type, backend_buffer, buffer_attrs, &handle);
+    TfLiteExecutionTaskSetBufferByIndex(task, tensor_index, handle);
+  };
+
+  // Twice as many requests as workers are in flight, so that the next ones
+  // are ready when a worker completes one.
+  const int num_slots = 2 * config.num_workers;
+  std::vector<Slot> slots(num_slots);
+  for (Slot& slot : slots) {
+    slot.task = runner->CreateTask();
+    slot.input_sync = TfLiteSynchronizationCreate();
+    TfLiteSynchronizationSetPtr(slot.input_sync, &slot.input_fence);
+    slot.inputs.resize(runner->inputs().size());
+    for (size_t i = 0; i < runner->inputs().size(); ++i) {
+      bind_buffer(kTfLiteIoTypeInput, runner->inputs()[i], &slot.inputs[i],
+                  slot.task);
+      TfLiteExecutionTaskSetSyncByIndex(slot.task, runner->inputs()[i],
+                                        slot.input_sync);
+    }
+    slot.outputs.resize(runner->outputs().size());
+    for (size_t i = 0; i < runner->outputs().size(); ++i) {
+      bind_buffer(kTfLiteIoTypeOutput, runner->outputs()[i], &slot.outputs[i],
+                  slot.task);
+    }
+  }
+  TfLiteBackendBufferDelete(backend_buffer);
+  TfLiteAttributeMapDelete(buffer_attrs);
+
+  // The producer preprocesses a request once its task is scheduled, which is
+  // once the previous request of the slot is postprocessed.
+  std::mutex mutex;
+  std::condition_variable scheduled_cv;
+  int num_scheduled = 0;
+  auto producer = [&]() {
+    for (int request = 0; request < config.num_requests; ++request) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        scheduled_cv.wait(lock, [&] { return num_scheduled > request; });
+      }
+      Slot& slot = slots[request % num_slots];
+      for (std::vector<char>& input : slot.inputs) {
+        Preprocess(request, config.preprocess_us, input.data(), input.size());
+      }
+      slot.input_fence.Signal();
+    }
+  };
+
+  char checksum = 0;
+  bool ok = true;
+  auto postprocess = [&](Slot& slot) {
+    ok &= runner->Wait(slot.task) == kTfLiteOk;
+    for (const std::vector<char>& output : slot.outputs) {
+      checksum ^= Postprocess(config.postprocess_us, output.data(),
+                              output.size());
+    }
+  };
+
+  const Clock::time_point start = Clock::now();
+  std::thread producer_thread(producer);
+  for (int request = 0; request < config.num_requests; ++request) {
+    Slot& slot = slots[request % num_slots];
+    if (request >= num_slots) postprocess(slot);
+    slot.input_fence.Reset();
+    ok &= runner->InvokeAsync(slot.task) == kTfLiteOk;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++num_scheduled;
+    }
+    scheduled_cv.notify_one();
+  }
+  for (int request = std::max(config.num_requests - num_slots, 0);
+       request < config.num_requests; ++request) {
+    postprocess(slots[request % num_slots]);
+  }
+  producer_thread.join();
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  for (Slot& slot : slots) {
+    runner->Finish(slot.task);
+    TfLiteSynchronizationDelete(slot.input_sync);
+  }
+  if (!ok) return 0;
+  fprintf(stderr, "checksum %d\n", checksum);
+  return config.num_requests / seconds;
+}
+
+}  // namespace
+}  // namespace async
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "Usage: %s model.tflite [num_workers] [num_requests] "
+            "[preprocess_us] [postprocess_us] [num_threads]\n",
+            argv[0]);
+    return 1;
+  }
+  tflite::async::Config config;
+  config.num_workers = argc > 2 ? atoi(argv[2]) : 2;
+  config.num_requests = argc > 3 ? atoi(argv[3]) : 200;
+  config.preprocess_us = argc > 4 ? atoi(argv[4]) : 1000;
+  config.postprocess_us = argc > 5 ? atoi(argv[5]) : 500;
+  config.num_threads = argc > 6 ? atoi(argv[6]) : 1;
+  std::unique_ptr<tflite::FlatBufferModel> model =
+      tflite::FlatBufferModel::BuildFromFile(argv[1]);
+  if (model == nullptr) return 1;
+
+  const double sync_throughput =
+      tflite::async::RunSynchronously(*model, config);
+  const double async_throughput = tflite::async::RunPipelined(*model, config);
+  printf("%d requests, %d us preprocessing, %d us postprocessing, "
+         "%d thread(s) per interpreter\n",
+         config.num_requests, config.preprocess_us, config.postprocess_us,
+         config.num_threads);
+  printf("%-32s %10.1f requests/s\n", "Interpreter::Invoke", sync_throughput);
+  printf("%-24s %2d worker(s) %10.1f requests/s\n", "CpuAsyncBackend",
+         config.num_workers, async_throughput);
+  return sync_throughput > 0 && async_throughput > 0 ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/async/cpu_async_backend.h"
+
+#include <cstdlib>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/builtin_op_data.h"
+#include "tensorflow/lite/core/async/async_signature_runner.h"
+#include "tensorflow/lite/core/async/c/task.h"
+#include "tensorflow/lite/core/async/c/types.h"
+#include "tensorflow/lite/core/async/interop/c/attribute_map.h"
+#include "tensorflow/lite/core/async/interop/c/constants.h"
+#include "tensorflow/lite/core/async/interop/c/types.h"
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/delegates/utils/async_type_helpers.h"
+#include "tensorflow/lite/interpreter_test_util.h"
+
+using ::testing::ElementsAre;
+using ::tflite::delegates::utils::CreateScopedTfLiteAttrMap;
+using ::tflite::delegates::utils::CreateScopedTfLiteBackendBuffer;
+using ::tflite::delegates::utils::CreateScopedTfLiteSynchronization;
+using ::tflite::delegates::utils::ScopedTfLiteAttrMap;
+using ::tflite::delegates::utils::ScopedTfLiteBackendBuffer;
+using ::tflite::delegates::utils::ScopedTfLiteSynchronization;
+
+namespace tflite {
+namespace async {
+
+class CpuAsyncBackendTest : public InterpreterTest {
+ protected:
+  static constexpr char kSignatureKey[] = "serving_default";
+  static constexpr size_t kTensorBytes = 3 * sizeof(float);
+
+  void SetUp() override {
+    CpuAsyncBackend::Options options;
+    options.num_workers = 2;
+    backend_ = CpuAsyncBackend::Create(&BuildInterpreter, options);
+    ASSERT_NE(backend_, nullptr);
+    interpreter_ = BuildInterpreter();
+    ASSERT_EQ(interpreter_->ModifyGraphWithDelegate(backend_->get_delegate()),
+              kTfLiteOk);
+    runner_ = interpreter_->GetAsyncSignatureRunner(kSignatureKey);
+    ASSERT_NE(runner_, nullptr);
+  }
+
+  void TearDown() override {
+    // The backend must outlive the interpreter.
+    interpreter_.reset();
+  }
+
+  // Builds an interpreter computing output = input + input, for {3} floats.
+  static std::unique_ptr<Interpreter> BuildInterpreter() {
+    auto interpreter = std::make_unique<Interpreter>();
+    interpreter->AddTensors(2);
+    interpreter->SetInputs({0});
+    interpreter->SetOutputs({1});
+    TfLiteQuantizationParams quant;
+    interpreter->SetTensorParametersReadWrite(0, kTfLiteFloat32, "x", {3},
+                                              quant);
+    interpreter->SetTensorParametersReadWrite(1, kTfLiteFloat32, "a", {3},
+                                              quant);
+    auto* params =
+        static_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+    params->activation = kTfLiteActNone;
+    params->pot_scale_int16 = false;
+    interpreter->AddNodeWithParameters({0, 0}, {1}, nullptr, 0, params,
+                                       ops::builtin::Register_ADD());
+    BuildSignature(interpreter.get(), kSignatureKey, {{"input", 0}},
+                   {{"output", 1}});
+    return interpreter;
+  }
+
+  // Registers `size` bytes at `data` and returns the handle.
+  TfLiteBufferHandle RegisterBuffer(TfLiteIoType io_type, void* data,
+                                    size_t size) {
+    ScopedTfLiteBackendBuffer buffer = CreateScopedTfLiteBackendBuffer();
+    TfLiteBackendBufferSetPtr(buffer.get(), data);
+    ScopedTfLiteAttrMap attrs =
+        CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeBuffer);
+    TfLiteAttributeMapSetStringBufferAttr(attrs.get(),
+                                          kTfLiteBufferAttrKeyResourceTypeName,
+                                          kCpuAsyncBufferTypeMemory);
+    TfLiteAttributeMapSetSizeTBufferAttr(attrs.get(), kTfLiteBufferAttrKeySize,
+                                         size);
+    TfLiteBufferHandle handle = kTfLiteNullBufferHandle;
+    EXPECT_EQ(runner_->RegisterBuffer(io_type, buffer.get(), attrs.get(),
+                                      &handle),
+              kTfLiteOk);
+    return handle;
+  }
+
+  TfLiteStatus SetSyncType(TfLiteIoType io_type, const char* name,
+                           const char* sync_type) {
+    ScopedTfLiteAttrMap attrs =
+        CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeSync);
+    TfLiteAttributeMapSetStringSyncAttr(
+        attrs.get(), kTfLiteSynchronizationAttrKeyObjectTypeName, sync_type);
+    return runner_->SetAttributes(io_type, name, attrs.get());
+  }
+
+  std::unique_ptr<CpuAsyncBackend> backend_;
+  AsyncSignatureRunner* runner_ = nullptr;
+};
+
+TEST_F(CpuAsyncBackendTest, InvokeAsync) {
+  std::vector<float> input = {1.0f, 2.0f, 3.0f};
+  std::vector<float> output(3);
+  TfLiteBufferHandle input_handle =
+      RegisterBuffer(kTfLiteIoTypeInput, input.data(), kTensorBytes);
+  TfLiteBufferHandle output_handle =
+      RegisterBuffer(kTfLiteIoTypeOutput, output.data(), kTensorBytes);
+  ASSERT_EQ(runner_->PrepareBackends(), kTfLiteOk);
+
+  TfLiteExecutionTask* task = runner_->CreateTask();
+  ASSERT_EQ(TfLiteExecutionTaskSetBuffer(task, kTfLiteIoTypeInput, "input",
+                                         input_handle),
+            kTfLiteOk);
+  ASSERT_EQ(TfLiteExecutionTaskSetBuffer(task, kTfLiteIoTypeOutput, "output",
+                                         output_handle),
+            kTfLiteOk);
+  ASSERT_EQ(runner_->InvokeAsync(task), kTfLiteOk);
+  EXPECT_EQ(runner_->Wait(task), kTfLiteOk);
+  EXPECT_THAT(output, ElementsAre(2.0f, 4.0f, 6.0f));
+
+  // The task can be scheduled again once waited for.
+  input = {4.0f, 5.0f, 6.0f};
+  ASSERT_EQ(runner_->InvokeAsync(task), kTfLiteOk);
+  EXPECT_EQ(runner_->Wait(task), kTfLiteOk);
+  EXPECT_THAT(output, ElementsAre(8.0f, 10.0f, 12.0f));
+  EXPECT_EQ(runner_->Finish(task), kTfLiteOk);
+}
+
+TEST_F(CpuAsyncBackendTest, InvokeAsyncWithoutBufferFails) {
+  ASSERT_EQ(runner_->PrepareBackends(), kTfLiteOk);
+  TfLiteExecutionTask* task = runner_->CreateTask();
+  EXPECT_NE(runner_->InvokeAsync(task), kTfLiteOk);
+  EXPECT_EQ(runner_->Finish(task), kTfLiteOk);
+}
+
+// The tasks are scheduled before their inputs are ready, which are produced
+// by another thread.
+TEST_F(CpuAsyncBackendTest, PipelinesTasksWaitingForInputFences) {
+  constexpr int kNumTasks = 8;
+  ASSERT_EQ(SetSyncType(kTfLiteIoTypeInput, "input", kCpuAsyncSyncTypeFence),
+            kTfLiteOk);
+  ASSERT_EQ(runner_->PrepareBackends(), kTfLiteOk);
+
+  std::vector<std::vector<float>> inputs(kNumTasks, std::vector<float>(3));
+  std::vector<std::vector<float>> outputs(kNumTasks, std::vector<float>(3));
+  std::vector<CpuSyncFence> fences(kNumTasks);
+  std::vector<ScopedTfLiteSynchronization> syncs;
+  std::vector<TfLiteExecutionTask*> tasks;
+  for (int i = 0; i < kNumTasks; ++i) {
+    TfLiteExecutionTask* task = runner_->CreateTask();
+    TfLiteExecutionTaskSetBuffer(
+        task, kTfLiteIoTypeInput, "input",
+        RegisterBuffer(kTfLiteIoTypeInput, inputs[i].data(), kTensorBytes));
+    TfLiteExecutionTaskSetBuffer(
+        task, kTfLiteIoTypeOutput, "output",
+        RegisterBuffer(kTfLiteIoTypeOutput, outputs[i].data(), kTensorBytes));
+    syncs.push_back(CreateScopedTfLiteSynchronization());
+    TfLiteSynchronizationSetPtr(syncs.back().get(), &fences[i]);
+    TfLiteExecutionTaskSetSync(task, kTfLiteIoTypeInput, "input",
+                               syncs.back().get());
+    ASSERT_EQ(runner_->InvokeAsync(task), kTfLiteOk);
+    tasks.push_back(task);
+  }
+
+  std::thread producer([&]() {
+    for (int i = kNumTasks - 1; i >= 0; --i) {
+      inputs[i] = {1.0f * i, 2.0f * i, 3.0f * i};
+      fences[i].Signal();
+    }
+  });
+  for (int i = 0; i < kNumTasks; ++i) {
+    EXPECT_EQ(runner_->Wait(tasks[i]), kTfLiteOk);
+    EXPECT_THAT(outputs[i], ElementsAre(2.0f * i, 4.0f * i, 6.0f * i));
+    EXPECT_EQ(runner_->Finish(tasks[i]), kTfLiteOk);
+  }
+  producer.join();
+}
+
+TEST_F(CpuAsyncBackendTest, InputFenceErrorFailsTask) {
+  std::vector<float> input(3);
+  std::vector<float> output(3);
+  ASSERT_EQ(SetSyncType(kTfLiteIoTypeInput, "input", kCpuAsyncSyncTypeFence),
+            kTfLiteOk);
+  ASSERT_EQ(runner_->PrepareBackends(), kTfLiteOk);
+
+  TfLiteExecutionTask* task = runner_->CreateTask();
+  TfLiteExecutionTaskSetBuffer(
+      task, kTfLiteIoTypeInput, "input",
+      RegisterBuffer(kTfLiteIoTypeInput, input.data(), kTensorBytes));
+  TfLiteExecutionTaskSetBuffer(
+      task, kTfLiteIoTypeOutput, "output",
+      RegisterBuffer(kTfLiteIoTypeOutput, output.data(), kTensorBytes));
+  CpuSyncFence fence;
+  ScopedTfLiteSynchronization sync = CreateScopedTfLiteSynchronization();
+  TfLiteSynchronizationSetPtr(sync.get(), &fence);
+  TfLiteExecutionTaskSetSync(task, kTfLiteIoTypeInput, "input", sync.get());
+  ASSERT_EQ(runner_->InvokeAsync(task), kTfLiteOk);
+  fence.Signal(kTfLiteError);
+  EXPECT_EQ(runner_->Wait(task), kTfLiteError);
+  EXPECT_EQ(runner_->Finish(task), kTfLiteError);
+}
+
+TEST_F(CpuAsyncBackendTest, SignalsOutputFences) {
+  std::vector<float> input = {1.0f, 2.0f, 3.0f};
+  std::vector<float> output(3);
+  ASSERT_EQ(SetSyncType(kTfLiteIoTypeOutput, "output", kCpuAsyncSyncTypeFence),
+            kTfLiteOk);
+  ASSERT_EQ(runner_->PrepareBackends(), kTfLiteOk);
+
+  TfLiteExecutionTask* task = runner_->CreateTask();
+  TfLiteExecutionTaskSetBuffer(
+      task, kTfLiteIoTypeInput, "input",
+      RegisterBuffer(kTfLiteIoTypeInput, input.data(), kTensorBytes));
+  TfLiteExecutionTaskSetBuffer(
+      task, kTfLiteIoTypeOutput, "output",
+      RegisterBuffer(kTfLiteIoTypeOutput, output.data(), kTensorBytes));
+  ScopedTfLiteSynchronization sync = CreateScopedTfLiteSynchronization();
+  TfLiteExecutionTaskSetSync(task, kTfLiteIoTypeOutput, "output", sync.get());
+  ASSERT_EQ(runner_->InvokeAsync(task), kTfLiteOk);
+
+  auto* fence = static_cast<CpuSyncFence*>(
+      TfLiteSynchronizationGetPtr(sync.get()));
+  ASSERT_NE(fence, nullptr);
+  EXPECT_EQ(fence->Wait(), kTfLiteOk);
+  EXPECT_THAT(output, ElementsAre(2.0f, 4.0f, 6.0f));
+  EXPECT_EQ(runner_->Wait(task), kTfLiteOk);
+
+  // The fence is reused by the next invocation of the task.
+  input = {4.0f, 5.0f, 6.0f};
+  ASSERT_EQ(runner_->InvokeAsync(task), kTfLiteOk);
+  EXPECT_EQ(TfLiteSynchronizationGetPtr(sync.get()), fence);
+  EXPECT_EQ(fence->Wait(), kTfLiteOk);
+  EXPECT_THAT(output, ElementsAre(8.0f, 10.0f, 12.0f));
+  EXPECT_EQ(runner_->Finish(task), kTfLiteOk);
+  delete fence;
+}
+
+TEST_F(CpuAsyncBackendTest, Invoke) {
+  ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  float* input = interpreter_->typed_input_tensor<float>(0);
+  input[0] = 1.0f;
+  input[1] = 2.0f;
+  input[2] = 3.0f;
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  const float* output = interpreter_->typed_output_tensor<float>(0);
+  EXPECT_THAT(std::vector<float>(output, output + 3),
+              ElementsAre(2.0f, 4.0f, 6.0f));
+}
+
+TEST_F(CpuAsyncBackendTest, RunsModelsWithStateOnOneWorker) {
+  EXPECT_EQ(backend_->num_workers(), 2);
+
+  auto build_interpreter_with_variable = []() {
+    std::unique_ptr<Interpreter> interpreter = BuildInterpreter();
+    int variable_index;
+    interpreter->AddTensors(1, &variable_index);
+    TfLiteQuantizationParams quant;
+    interpreter->SetTensorParametersReadWrite(variable_index, kTfLiteFloat32,
+                                              "v", {3}, quant,
+                                              /*is_variable=*/true);
+    return interpreter;
+  };
+  CpuAsyncBackend::Options options;
+  options.num_workers = 2;
+  std::unique_ptr<CpuAsyncBackend> backend =
+      CpuAsyncBackend::Create(build_interpreter_with_variable, options);
+  ASSERT_NE(backend, nullptr);
+  EXPECT_EQ(backend->num_workers(), 1);
+}
+
+TEST_F(CpuAsyncBackendTest, ReconcileRestrictions) {
+  ScopedTfLiteAttrMap user =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeBuffer);
+  ScopedTfLiteAttrMap merged =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeBuffer);
+  ScopedTfLiteAttrMap conflict =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeBuffer);
+  ASSERT_TRUE(runner_->ReconcileRestrictions(kTfLiteIoTypeInput, "input",
+                                             user.get(), merged.get(),
+                                             conflict.get()));
+  const char* buffer_type = nullptr;
+  EXPECT_TRUE(TfLiteAttributeMapGetStringBufferAttr(
+      merged.get(), kTfLiteBufferAttrKeyResourceTypeName, &buffer_type));
+  EXPECT_STREQ(buffer_type, kCpuAsyncBufferTypeMemory);
+  size_t size = 0;
+  EXPECT_TRUE(TfLiteAttributeMapGetSizeTBufferAttr(
+      merged.get(), kTfLiteBufferAttrKeySize, &size));
+  EXPECT_EQ(size, kTensorBytes);
+
+  TfLiteAttributeMapSetStringBufferAttr(
+      user.get(), kTfLiteBufferAttrKeyResourceTypeName, "ahardware_buffer");
+  EXPECT_FALSE(runner_->ReconcileRestrictions(kTfLiteIoTypeInput, "input",
+                                              user.get(), merged.get(),
+                                              conflict.get()));
+
+  ScopedTfLiteAttrMap user_sync =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeSync);
+  ScopedTfLiteAttrMap merged_sync =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeSync);
+  TfLiteAttributeMapSetStringSyncAttr(
+      user_sync.get(), kTfLiteSynchronizationAttrKeyObjectTypeName,
+      kCpuAsyncSyncTypeFence);
+  EXPECT_TRUE(runner_->ReconcileRestrictions(kTfLiteIoTypeOutput, "output",
+                                             user_sync.get(), merged_sync.get(),
+                                             nullptr));
+  TfLiteAttributeMapSetStringSyncAttr(
+      user_sync.get(), kTfLiteSynchronizationAttrKeyObjectTypeName,
+      "sync_fence_fd");
+  EXPECT_FALSE(runner_->ReconcileRestrictions(kTfLiteIoTypeOutput, "output",
+                                              user_sync.get(),
+                                              merged_sync.get(), nullptr));
+}
+
+TEST_F(CpuAsyncBackendTest, RegisterBufferWithoutSizeFails) {
+  std::vector<float> data(3);
+  ScopedTfLiteBackendBuffer buffer = CreateScopedTfLiteBackendBuffer();
+  TfLiteBackendBufferSetPtr(buffer.get(), data.data());
+  ScopedTfLiteAttrMap attrs =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeBuffer);
+  TfLiteAttributeMapSetStringBufferAttr(attrs.get(),
+                                        kTfLiteBufferAttrKeyResourceTypeName,
+                                        kCpuAsyncBufferTypeMemory);
+  TfLiteBufferHandle handle = kTfLiteNullBufferHandle;
+  EXPECT_NE(runner_->RegisterBuffer(kTfLiteIoTypeInput, buffer.get(),
+                                    attrs.get(), &handle),
+            kTfLiteOk);
+}
+
+TEST_F(CpuAsyncBackendTest, RegisterBufferSlice) {
+  std::vector<float> pool(6);
+  TfLiteBufferHandle pool_handle =
+      RegisterBuffer(kTfLiteIoTypeInput, pool.data(), 2 * kTensorBytes);
+  ScopedTfLiteAttrMap attrs =
+      CreateScopedTfLiteAttrMap(kTfLiteAttrMapTypeBuffer);
+  TfLiteAttributeMapSetSizeTBufferAttr(attrs.get(), kTfLiteBufferAttrKeyOffset,
+                                       kTensorBytes);
+  TfLiteAttributeMapSetSizeTBufferAttr(attrs.get(), kTfLiteBufferAttrKeySize,
+                                       kTensorBytes);
+  TfLiteBufferHandle slice_handle = kTfLiteNullBufferHandle;
+  EXPECT_EQ(runner_->RegisterBufferSlice(pool_handle, attrs.get(),
+                                         &slice_handle),
+            kTfLiteOk);
+
+  // Slices can't be sliced further, nor go past the end of their pool.
+  TfLiteBufferHandle handle = kTfLiteNullBufferHandle;
+  EXPECT_NE(runner_->RegisterBufferSlice(slice_handle, attrs.get(), &handle),
+            kTfLiteOk);
+  TfLiteAttributeMapSetSizeTBufferAttr(attrs.get(), kTfLiteBufferAttrKeySize,
+                                       2 * kTensorBytes);
+  EXPECT_NE(runner_->RegisterBufferSlice(pool_handle, attrs.get(), &handle),
+            kTfLiteOk);
+  EXPECT_EQ(runner_->UnregisterBuffer(slice_handle), kTfLiteOk);
+  EXPECT_EQ(runner_->UnregisterBuffer(pool_handle), kTfLiteOk);
+}
+
+}  // namespace async
+}  // namespace tflite
@@ -751,6 +751,33 @@ class Interpreter {
       int tensor_index, const TfLiteCustomAllocation& allocation,
       int64_t flags = kTfLiteCustomAllocationFlagsNone);
 
+  /// \brief Serializes the arena offsets of the tensors of all subgraphs into
+  /// `plan`, so that another interpreter built from the same model, with the
+  /// same delegates and input shapes, can reuse them with RestoreMemoryPlan().
+  ///
+  /// NOTE: AllocateTensors() must have been called before this. The plan is
+  /// written in the byte order of the host and is meant to be restored on the
+  /// same kind of platform; a plan of the other byte order fails the header
+  /// check of RestoreMemoryPlan().
+  /// \warning This is an experimental API and subject to change. \n
+  TfLiteStatus SerializeMemoryPlan(std::string* plan) const;
+
+  /// \brief Makes the next AllocateTensors() place the tensors at the offsets
+  /// recorded in `plan` by SerializeMemoryPlan(), instead of choosing them.
+  /// Only the choice of offsets is skipped: operators are still prepared,
+  /// delegates are still applied, and the planner still computes the size and
+  /// lifetime of every tensor. Each subgraph falls back to regular planning if
+  /// these differ from the recorded ones. Subgraphs are matched with a
+  /// structural fingerprint, not a cryptographic hash; the size and lifetime
+  /// checks are what guarantee that the offsets are valid.
+  ///
+  /// NOTE: Call this after ModifyGraphWithDelegate() and
+  /// ResizeInputTensor(), and before AllocateTensors(). Returns kTfLiteError
+  /// if `plan` is malformed or was made for a different model, delegation or
+  /// input shapes, in which case the interpreter is left unchanged.
+  /// \warning This is an experimental API and subject to change. \n
+  TfLiteStatus RestoreMemoryPlan(const std::string& plan);
+
   /// \warning This is an experimental API and subject to change. \n
   /// \brief Apply InterpreterOptions which tunes behavior of the interpreter.
   TfLiteStatus ApplyOptions(InterpreterOptions* options);
@@ -870,6 +870,11 @@ TfLiteStatus InterpreterBuilder::operator()(
       return cleanup_and_error();
     if (operators && ParseNodes(operators, modified_subgraph) != kTfLiteOk)
       return cleanup_and_error();
+    if (options_.GetFuseActivations()) {
+      int num_fused_nodes = 0;
+      if (modified_subgraph->FuseActivations(&num_fused_nodes) != kTfLiteOk)
+        return cleanup_and_error();
+    }
 
     std::vector<int> variables;
     for (int i = 0; i < modified_subgraph->tensors_size(); ++i) {
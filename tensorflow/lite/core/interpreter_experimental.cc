@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -41,6 +42,10 @@ namespace tflite {
 
 namespace {
 static constexpr char kDefaultServingSignatureDefKey[] = "serving_default";
+
+// Header of a serialized memory plan: "TLMP" followed by the format version.
+constexpr uint32_t kMemoryPlanMagic = 0x504d4c54;
+constexpr uint32_t kMemoryPlanVersion = 1;
 }  // namespace
 
 TfLiteStatus Interpreter::SetCustomAllocationForTensor(
@@ -49,6 +54,65 @@ TfLiteStatus Interpreter::SetCustomAllocationForTensor(
                                                          allocation, flags);
 }
 
+TfLiteStatus Interpreter::SerializeMemoryPlan(std::string* plan) const {
+  plan->clear();
+  AppendToBuffer(kMemoryPlanMagic, plan);
+  AppendToBuffer(kMemoryPlanVersion, plan);
+  AppendToBuffer(static_cast<uint32_t>(subgraphs_.size()), plan);
+  for (const auto& subgraph : subgraphs_) {
+    // Subgraphs which were never allocated, e.g. the branches of a control
+    // flow op that did not run, are planned as usual after restoring.
+    std::string subgraph_plan;
+    if (subgraph->SerializeMemoryPlan(&subgraph_plan) != kTfLiteOk) {
+      subgraph_plan.clear();
+    }
+    AppendToBuffer(subgraph->MemoryPlanKey(), plan);
+    AppendToBuffer(static_cast<uint64_t>(subgraph_plan.size()), plan);
+    plan->append(subgraph_plan);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::RestoreMemoryPlan(const std::string& plan) {
+  // The plan covers the nodes of the default delegates, which are otherwise
+  // only applied by AllocateTensors().
+  if (ApplyLazyDelegateProviders() == kTfLiteError) return kTfLiteError;
+
+  size_t pos = 0;
+  uint32_t magic, version, num_subgraphs;
+  TF_LITE_ENSURE(context_, ReadFromBuffer(plan, &pos, &magic) &&
+                               ReadFromBuffer(plan, &pos, &version) &&
+                               ReadFromBuffer(plan, &pos, &num_subgraphs));
+  TF_LITE_ENSURE(context_, magic == kMemoryPlanMagic);
+  TF_LITE_ENSURE(context_, version == kMemoryPlanVersion);
+  TF_LITE_ENSURE(context_, num_subgraphs == subgraphs_.size());
+
+  // Validate the whole plan before handing any of it to the subgraphs.
+  std::vector<std::string> subgraph_plans(num_subgraphs);
+  for (uint32_t i = 0; i < num_subgraphs; ++i) {
+    uint64_t key, size;
+    TF_LITE_ENSURE(context_, ReadFromBuffer(plan, &pos, &key) &&
+                                 ReadFromBuffer(plan, &pos, &size));
+    if (key != subgraphs_[i]->MemoryPlanKey()) {
+      TF_LITE_KERNEL_LOG(context_,
+                         "The memory plan of subgraph %d was made for a "
+                         "different graph or input shapes.",
+                         i);
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE(context_, size <= plan.size() - pos);
+    subgraph_plans[i] = plan.substr(pos, size);
+    pos += size;
+  }
+  TF_LITE_ENSURE(context_, pos == plan.size());
+
+  for (uint32_t i = 0; i < num_subgraphs; ++i) {
+    if (subgraph_plans[i].empty()) continue;
+    TF_LITE_ENSURE_STATUS(subgraphs_[i]->RestoreMemoryPlan(subgraph_plans[i]));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Interpreter::ReleaseNonPersistentMemory() {
   // TODO(b/138790287): We could do this for all subgraphs whose tensors have
   // been allocated. However, AllocateTensors() relies on Control Flow ops to
@@ -15,9 +15,14 @@ limitations under the License.
 
 #include "tensorflow/lite/core/signature_runner.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/util.h"
 
 namespace tflite {
 namespace impl {
@@ -60,6 +65,7 @@ TfLiteStatus SignatureRunner::ResizeInputTensor(
     subgraph_->ReportError("Input name %s was not found", input_name);
     return kTfLiteError;
   }
+  bound_buffers_.clear();
   return subgraph_->ResizeInputTensor(it->second, new_size);
 }
 
@@ -70,10 +76,47 @@ TfLiteStatus SignatureRunner::ResizeInputTensorStrict(
     subgraph_->ReportError("Input name %s was not found", input_name);
     return kTfLiteError;
   }
+  bound_buffers_.clear();
   return subgraph_->ResizeInputTensorStrict(it->second, new_size);
 }
 
+TfLiteStatus SignatureRunner::AllocateTensors() {
+  bound_buffers_.clear();
+  validated_bytes_.clear();
+  return subgraph_->AllocateTensors();
+}
+
 TfLiteStatus SignatureRunner::Invoke() {
+  if (bound_buffers_.empty()) return InvokeImpl();
+
+  // Swaps the bound buffers in for this invocation only. The inputs and
+  // outputs of a graph never share their arena buffer with another tensor, so
+  // the rest of the plan is unaffected.
+  std::vector<BoundBuffer> bound_buffers = std::move(bound_buffers_);
+  bound_buffers_.clear();
+  for (const BoundBuffer& bound_buffer : bound_buffers) {
+    // The tensor may have been reallocated through the interpreter since the
+    // buffer was bound.
+    const TfLiteTensor* tensor = subgraph_->tensor(bound_buffer.tensor_index);
+    if (bound_buffer.bytes < tensor->bytes) {
+      subgraph_->ReportError("The buffer bound to tensor %d is too small",
+                             bound_buffer.tensor_index);
+      return kTfLiteError;
+    }
+  }
+  for (BoundBuffer& bound_buffer : bound_buffers) {
+    std::swap(subgraph_->tensor(bound_buffer.tensor_index)->data.raw,
+              bound_buffer.data);
+  }
+  const TfLiteStatus status = InvokeImpl();
+  for (BoundBuffer& bound_buffer : bound_buffers) {
+    std::swap(subgraph_->tensor(bound_buffer.tensor_index)->data.raw,
+              bound_buffer.data);
+  }
+  return status;
+}
+
+TfLiteStatus SignatureRunner::InvokeImpl() {
   // "Resets" cancellation flag so cancellation happens before this invoke will
   // not take effect.
   if (subgraph_->continue_invocation_)
@@ -99,6 +142,8 @@ TfLiteStatus SignatureRunner::SetCustomAllocationForInputTensor(
     subgraph_->ReportError("Input name %s was not found", input_name);
     return kTfLiteError;
   }
+  bound_buffers_.clear();
+  validated_bytes_.clear();
   return subgraph_->SetCustomAllocationForTensor(it->second, allocation, flags);
 }
 
@@ -110,8 +155,96 @@ TfLiteStatus SignatureRunner::SetCustomAllocationForOutputTensor(
     subgraph_->ReportError("Output name %s was not found", output_name);
     return kTfLiteError;
   }
+  bound_buffers_.clear();
+  validated_bytes_.clear();
   return subgraph_->SetCustomAllocationForTensor(it->second, allocation, flags);
 }
 
+TfLiteStatus SignatureRunner::BindInputBuffer(const char* input_name,
+                                              const void* data, size_t bytes,
+                                              int64_t flags) {
+  const auto& it = signature_def_->inputs.find(input_name);
+  if (it == signature_def_->inputs.end()) {
+    subgraph_->ReportError("Input name %s was not found", input_name);
+    return kTfLiteError;
+  }
+  // The runtime only reads the inputs.
+  return BindBuffer(it->second,
+                    const_cast<char*>(static_cast<const char*>(data)), bytes,
+                    flags);
+}
+
+TfLiteStatus SignatureRunner::BindOutputBuffer(const char* output_name,
+                                               void* data, size_t bytes,
+                                               int64_t flags) {
+  const auto& it = signature_def_->outputs.find(output_name);
+  if (it == signature_def_->outputs.end()) {
+    subgraph_->ReportError("Output name %s was not found", output_name);
+    return kTfLiteError;
+  }
+  return BindBuffer(it->second, static_cast<char*>(data), bytes, flags);
+}
+
+TfLiteStatus SignatureRunner::BindBuffer(int tensor_index, char* data,
+                                         size_t bytes, int64_t flags) {
+  const TfLiteTensor* tensor = subgraph_->tensor(tensor_index);
+  const auto& validated = validated_bytes_.find(tensor_index);
+  if (validated == validated_bytes_.end() ||
+      validated->second != tensor->bytes) {
+    TF_LITE_ENSURE_STATUS(ValidateBufferBinding(tensor_index));
+    validated_bytes_[tensor_index] = tensor->bytes;
+  }
+
+  TfLiteContext* context = subgraph_->context();
+  TF_LITE_ENSURE(context, data != nullptr);
+  TF_LITE_ENSURE(context, bytes >= tensor->bytes);
+  if (!(flags & kTfLiteCustomAllocationFlagsSkipAlignCheck)) {
+    const intptr_t data_ptr_value = reinterpret_cast<intptr_t>(data);
+    TF_LITE_ENSURE(context, data_ptr_value % kDefaultTensorAlignment == 0);
+  }
+
+  for (BoundBuffer& bound_buffer : bound_buffers_) {
+    if (bound_buffer.tensor_index == tensor_index) {
+      bound_buffer.data = data;
+      bound_buffer.bytes = bytes;
+      return kTfLiteOk;
+    }
+  }
+  bound_buffers_.push_back({tensor_index, data, bytes});
+  return kTfLiteOk;
+}
+
+TfLiteStatus SignatureRunner::ValidateBufferBinding(int tensor_index) {
+  // Reallocating the tensors in the middle of an invocation, as for dynamic
+  // tensors, would reset the data of the tensor to its arena buffer.
+  if (subgraph_->state_ == Subgraph::kStateUninvokable ||
+      subgraph_->next_execution_plan_index_to_prepare_ !=
+          static_cast<int>(subgraph_->execution_plan().size())) {
+    subgraph_->ReportError(
+        "AllocateTensors must be called before binding buffers.");
+    return kTfLiteError;
+  }
+  if (subgraph_->HasDynamicTensors()) {
+    subgraph_->ReportError(
+        "Buffers can't be bound to a graph with dynamic tensors.");
+    return kTfLiteError;
+  }
+  const TfLiteTensor* tensor = subgraph_->tensor(tensor_index);
+  if (tensor->allocation_type != kTfLiteArenaRw) {
+    subgraph_->ReportError(
+        "Buffers can only be bound to tensors allocated in the arena, tensor "
+        "%d isn't.",
+        tensor_index);
+    return kTfLiteError;
+  }
+  if (tensor->buffer_handle != kTfLiteNullBufferHandle) {
+    subgraph_->ReportError(
+        "Buffers can't be bound to tensor %d, which has a buffer handle.",
+        tensor_index);
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
 }  // namespace impl
 }  // namespace tflite
@@ -28,6 +28,7 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/lite/core/c/common.h"
@@ -140,10 +141,13 @@ class SignatureRunner {
                                        const std::vector<int>& new_size);
 
   /// Updates allocations for all tensors, related to the given signature.
-  TfLiteStatus AllocateTensors() { return subgraph_->AllocateTensors(); }
+  /// Drops the buffers bound with BindInputBuffer and BindOutputBuffer.
+  TfLiteStatus AllocateTensors();
 
   /// Invokes the signature runner (run the graph identified by the given
   /// signature in dependency order).
+  /// The buffers bound with BindInputBuffer and BindOutputBuffer are used for
+  /// this invocation only, and unbound once it returns.
   TfLiteStatus Invoke();
 
   /// Attempts to cancel in flight invocation if any.
@@ -204,6 +208,46 @@ class SignatureRunner {
       const char* output_name, const TfLiteCustomAllocation& allocation,
       int64_t flags = kTfLiteCustomAllocationFlagsNone);
 
+  /// \brief Binds a caller-owned buffer to the given input tensor for the next
+  /// call to Invoke only, without copying it and without replanning the
+  /// tensor allocations. The runtime does NOT take ownership of the memory,
+  /// which is only read and may be e.g. a read-only mapping of a file or
+  /// shared memory.
+  ///
+  /// Unlike SetCustomAllocationForInputTensor, no call to AllocateTensors is
+  /// needed, and the arena buffer of the tensor is used again by the
+  /// invocations without a bound buffer. This suits servers binding the
+  /// buffers of each request.
+  ///
+  /// The tensor must be allocated in the arena, without a delegate buffer
+  /// handle, and the graph must not have dynamic tensors. This is checked
+  /// once per shape of the tensor, whereas every call checks that:
+  /// 1. `data` is not null, and `bytes` >= tensor->bytes.
+  /// 2. `data` is aligned to kDefaultTensorAlignment defined in lite/util.h,
+  ///    unless kTfLiteCustomAllocationFlagsSkipAlignCheck is set in `flags`.
+  ///
+  /// Binding a buffer to a tensor again replaces the previous one. The
+  /// bindings are dropped by AllocateTensors, ResizeInputTensor and the
+  /// custom allocation setters.
+  /// \warning This is an experimental API and subject to change. \n
+  TfLiteStatus BindInputBuffer(
+      const char* input_name, const void* data, size_t bytes,
+      int64_t flags = kTfLiteCustomAllocationFlagsNone);
+
+  /// \brief Binds a caller-owned buffer to the given output tensor for the
+  /// next call to Invoke only, so that the graph writes the output to it
+  /// directly. See BindInputBuffer for the requirements, except that the
+  /// memory must be writable.
+  /// \warning This is an experimental API and subject to change. \n
+  TfLiteStatus BindOutputBuffer(
+      const char* output_name, void* data, size_t bytes,
+      int64_t flags = kTfLiteCustomAllocationFlagsNone);
+
+  /// \brief Drops the buffers bound with BindInputBuffer and BindOutputBuffer
+  /// without invoking the signature runner.
+  /// \warning This is an experimental API and subject to change. \n
+  void ClearBoundBuffers() { bound_buffers_.clear(); }
+
   /// \brief Set if buffer handle output is allowed.
   ///
   /// When using hardware delegation, Interpreter will make the data of output
@@ -228,6 +272,23 @@ class SignatureRunner {
   friend class ::tflite::SignatureRunnerJNIHelper;
   friend class ::tflite::TensorHandle;
 
+  // A buffer bound to a tensor for the next invocation.
+  struct BoundBuffer {
+    int tensor_index;
+    char* data;
+    size_t bytes;
+  };
+
+  TfLiteStatus InvokeImpl();
+
+  // Binds `data` to the input or output `tensor_index`.
+  TfLiteStatus BindBuffer(int tensor_index, char* data, size_t bytes,
+                          int64_t flags);
+
+  // Checks the requirements of a bound buffer which only depend on the shape
+  // of the tensor and on the allocation of the graph.
+  TfLiteStatus ValidateBufferBinding(int tensor_index);
+
   // The SignatureDef object is owned by the interpreter.
   const internal::SignatureDef* signature_def_;
   // The Subgraph object is owned by the interpreter.
@@ -238,6 +299,12 @@ class SignatureRunner {
   std::vector<const char*> output_names_;
 
   bool allow_buffer_handle_output_ = false;
+
+  // The buffers bound to the next invocation.
+  std::vector<BoundBuffer> bound_buffers_;
+  // Maps the tensors validated for binding to the size they were validated
+  // at. Cleared whenever the allocations may change.
+  std::unordered_map<int, size_t> validated_bytes_;
 };
 
 }  // namespace impl
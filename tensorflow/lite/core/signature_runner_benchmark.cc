@@ -0,0 +1,214 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Measures the time per request of a signature whose inputs and outputs live
+// in buffers of the application, e.g. the image of a request received by a
+// server, when:
+// - copying the buffers to and from the tensors around Invoke,
+// - binding the buffers with SignatureRunner::BindInputBuffer and
+//   BindOutputBuffer,
+// - setting them as custom allocations, followed by AllocateTensors.
+// The time of Invoke alone, on the tensors of the arena, is the baseline the
+// overhead of each is measured against.
+//
+// Usage: signature_runner_benchmark model.tflite [num_runs] [num_requests]
+//          [signature_key]
+// The first signature of the model is run by default.
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/core/model_builder.h"
+#include "tensorflow/lite/core/signature_runner.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace impl {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct AlignedFree {
+  void operator()(char* data) const { free(data); }
+};
+using AlignedBuffer = std::unique_ptr<char, AlignedFree>;
+
+AlignedBuffer AllocateBuffer(size_t bytes) {
+  // aligned_alloc requires a multiple of the alignment.
+  const size_t aligned_bytes =
+      (bytes + kDefaultTensorAlignment - 1) / kDefaultTensorAlignment *
+      kDefaultTensorAlignment;
+  AlignedBuffer buffer(static_cast<char*>(
+      aligned_alloc(kDefaultTensorAlignment, aligned_bytes)));
+  memset(buffer.get(), 0, aligned_bytes);
+  return buffer;
+}
+
+// The input and output buffers of a request.
+struct Request {
+  std::vector<AlignedBuffer> inputs;
+  std::vector<AlignedBuffer> outputs;
+};
+
+// Returns the mean time of `run_request` in microseconds, cycling through the
+// requests, or a negative value if it fails.
+double TimeRequests(int num_runs, std::vector<Request>& requests,
+                    const std::function<TfLiteStatus(Request&)>& run_request) {
+  // Warms up the caches and the allocations.
+  for (Request& request : requests) {
+    if (run_request(request) != kTfLiteOk) return -1;
+  }
+  const Clock::time_point start = Clock::now();
+  for (int run = 0; run < num_runs; ++run) {
+    if (run_request(requests[run % requests.size()]) != kTfLiteOk) return -1;
+  }
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+             .count() /
+         num_runs;
+}
+
+int Run(const FlatBufferModel& model, int num_runs, int num_requests,
+        const char* signature_key) {
+  ops::builtin::BuiltinOpResolver op_resolver;
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(model, op_resolver)(&interpreter) != kTfLiteOk) {
+    return 1;
+  }
+  if (signature_key == nullptr) {
+    if (interpreter->signature_keys().empty()) {
+      fprintf(stderr, "The model has no signature.\n");
+      return 1;
+    }
+    signature_key = interpreter->signature_keys()[0]->c_str();
+  }
+  SignatureRunner* runner = interpreter->GetSignatureRunner(signature_key);
+  if (runner == nullptr || runner->AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "The signature can't be run.\n");
+    return 1;
+  }
+  const std::vector<const char*>& input_names = runner->input_names();
+  const std::vector<const char*>& output_names = runner->output_names();
+
+  std::vector<size_t> input_bytes;
+  std::vector<size_t> output_bytes;
+  size_t total_input_bytes = 0;
+  for (const char* name : input_names) {
+    input_bytes.push_back(runner->input_tensor(name)->bytes);
+    total_input_bytes += input_bytes.back();
+  }
+  for (const char* name : output_names) {
+    output_bytes.push_back(runner->output_tensor(name)->bytes);
+  }
+  std::vector<Request> requests(num_requests);
+  for (Request& request : requests) {
+    for (size_t bytes : input_bytes) {
+      request.inputs.push_back(AllocateBuffer(bytes));
+    }
+    for (size_t bytes : output_bytes) {
+      request.outputs.push_back(AllocateBuffer(bytes));
+    }
+  }
+
+  const double invoke_us = TimeRequests(
+      num_runs, requests, [&](Request&) { return runner->Invoke(); });
+
+  const double copy_us = TimeRequests(num_runs, requests, [&](Request& r) {
+    for (size_t i = 0; i < input_names.size(); ++i) {
+      memcpy(runner->input_tensor(input_names[i])->data.raw,
+             r.inputs[i].get(), input_bytes[i]);
+    }
+    TF_LITE_ENSURE_STATUS(runner->Invoke());
+    for (size_t i = 0; i < output_names.size(); ++i) {
+      memcpy(r.outputs[i].get(),
+             runner->output_tensor(output_names[i])->data.raw,
+             output_bytes[i]);
+    }
+    return kTfLiteOk;
+  });
+
+  const double bind_us = TimeRequests(num_runs, requests, [&](Request& r) {
+    for (size_t i = 0; i < input_names.size(); ++i) {
+      TF_LITE_ENSURE_STATUS(runner->BindInputBuffer(
+          input_names[i], r.inputs[i].get(), input_bytes[i]));
+    }
+    for (size_t i = 0; i < output_names.size(); ++i) {
+      TF_LITE_ENSURE_STATUS(runner->BindOutputBuffer(
+          output_names[i], r.outputs[i].get(), output_bytes[i]));
+    }
+    return runner->Invoke();
+  });
+
+  // Runs last, since the custom allocations stay in place.
+  const double custom_allocation_us =
+      TimeRequests(num_runs, requests, [&](Request& r) {
+        for (size_t i = 0; i < input_names.size(); ++i) {
+          TF_LITE_ENSURE_STATUS(runner->SetCustomAllocationForInputTensor(
+              input_names[i], {r.inputs[i].get(), input_bytes[i]}));
+        }
+        for (size_t i = 0; i < output_names.size(); ++i) {
+          TF_LITE_ENSURE_STATUS(runner->SetCustomAllocationForOutputTensor(
+              output_names[i], {r.outputs[i].get(), output_bytes[i]}));
+        }
+        TF_LITE_ENSURE_STATUS(runner->AllocateTensors());
+        return runner->Invoke();
+      });
+
+  if (invoke_us < 0 || copy_us < 0 || bind_us < 0 ||
+      custom_allocation_us < 0) {
+    fprintf(stderr, "Invoke failed.\n");
+    return 1;
+  }
+  printf("%d runs over %d requests, %zu input bytes\n", num_runs,
+         num_requests, total_input_bytes);
+  printf("%-32s %10s %14s\n", "", "us/request", "overhead (us)");
+  printf("%-32s %10.2f\n", "Invoke", invoke_us);
+  printf("%-32s %10.2f %14.2f\n", "Copies", copy_us, copy_us - invoke_us);
+  printf("%-32s %10.2f %14.2f\n", "BindInput/OutputBuffer", bind_us,
+         bind_us - invoke_us);
+  printf("%-32s %10.2f %14.2f\n", "SetCustomAllocation + Allocate",
+         custom_allocation_us, custom_allocation_us - invoke_us);
+  return 0;
+}
+
+}  // namespace
+}  // namespace impl
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "Usage: %s model.tflite [num_runs] [num_requests] "
+            "[signature_key]\n",
+            argv[0]);
+    return 1;
+  }
+  const int num_runs = argc > 2 ? atoi(argv[2]) : 100;
+  const int num_requests = argc > 3 ? atoi(argv[3]) : 8;
+  const char* signature_key = argc > 4 ? argv[4] : nullptr;
+  if (num_runs <= 0 || num_requests <= 0) return 1;
+  std::unique_ptr<tflite::FlatBufferModel> model =
+      tflite::FlatBufferModel::BuildFromFile(argv[1]);
+  if (model == nullptr) return 1;
+  return tflite::impl::Run(*model, num_runs, num_requests, signature_key);
+}
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/core/interpreter_builder.h"
 #include "tensorflow/lite/core/kernels/register.h"
 #include "tensorflow/lite/testing/util.h"
+#include "tensorflow/lite/util.h"
 
 namespace tflite {
 namespace impl {
@@ -96,6 +97,129 @@ TEST(SignatureRunnerTest, TestMultiSignatures) {
   ASSERT_EQ(sub_output->data.f[2], 3);
 }
 
+std::unique_ptr<Interpreter> BuildMultiSignatures() {
+  auto model = FlatBufferModel::BuildFromFile(
+      "tensorflow/lite/testdata/multi_signatures.bin");
+  if (model == nullptr) return nullptr;
+  ops::builtin::BuiltinOpResolver resolver;
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(*model, resolver)(&interpreter) != kTfLiteOk) {
+    return nullptr;
+  }
+  return interpreter;
+}
+
+TEST(SignatureRunnerTest, BindBuffers) {
+  std::unique_ptr<Interpreter> interpreter = BuildMultiSignatures();
+  ASSERT_NE(interpreter, nullptr);
+  SignatureRunner* runner = interpreter->GetSignatureRunner("add");
+  ASSERT_NE(runner, nullptr);
+  ASSERT_EQ(runner->ResizeInputTensor("x", {2}), kTfLiteOk);
+  ASSERT_EQ(runner->AllocateTensors(), kTfLiteOk);
+  TfLiteTensor* input = runner->input_tensor("x");
+  const TfLiteTensor* output = runner->output_tensor("output_0");
+  void* input_data = input->data.raw;
+  void* output_data = output->data.raw;
+
+  alignas(kDefaultTensorAlignment) float bound_input[2] = {2, 4};
+  alignas(kDefaultTensorAlignment) float bound_output[2] = {0, 0};
+  ASSERT_EQ(runner->BindInputBuffer("x", bound_input, sizeof(bound_input)),
+            kTfLiteOk);
+  ASSERT_EQ(
+      runner->BindOutputBuffer("output_0", bound_output, sizeof(bound_output)),
+      kTfLiteOk);
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(bound_output[0], 4);
+  EXPECT_EQ(bound_output[1], 6);
+  // The arena buffers are restored once the invocation returns.
+  EXPECT_EQ(input->data.raw, input_data);
+  EXPECT_EQ(output->data.raw, output_data);
+
+  // The bindings only apply to one invocation.
+  input->data.f[0] = 1;
+  input->data.f[1] = 3;
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(output->data.f[0], 3);
+  EXPECT_EQ(output->data.f[1], 5);
+  EXPECT_EQ(bound_output[0], 4);
+
+  // Binding the input only reads it from the buffer.
+  bound_input[0] = 10;
+  ASSERT_EQ(runner->BindInputBuffer("x", bound_input, sizeof(bound_input)),
+            kTfLiteOk);
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(output->data.f[0], 12);
+  EXPECT_EQ(output->data.f[1], 6);
+}
+
+TEST(SignatureRunnerTest, BindBuffersAfterResize) {
+  std::unique_ptr<Interpreter> interpreter = BuildMultiSignatures();
+  ASSERT_NE(interpreter, nullptr);
+  SignatureRunner* runner = interpreter->GetSignatureRunner("add");
+  ASSERT_NE(runner, nullptr);
+  ASSERT_EQ(runner->ResizeInputTensor("x", {2}), kTfLiteOk);
+  alignas(kDefaultTensorAlignment) float bound_input[3] = {2, 4, 6};
+  alignas(kDefaultTensorAlignment) float bound_output[3] = {0, 0, 0};
+  // The tensors aren't allocated yet.
+  EXPECT_EQ(runner->BindInputBuffer("x", bound_input, sizeof(bound_input)),
+            kTfLiteError);
+
+  ASSERT_EQ(runner->AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(runner->BindInputBuffer("x", bound_input, sizeof(bound_input)),
+            kTfLiteOk);
+  // Resizing drops the bindings.
+  ASSERT_EQ(runner->ResizeInputTensor("x", {3}), kTfLiteOk);
+  ASSERT_EQ(runner->AllocateTensors(), kTfLiteOk);
+  runner->input_tensor("x")->data.f[0] = 1;
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(runner->output_tensor("output_0")->data.f[0], 3);
+
+  ASSERT_EQ(runner->BindInputBuffer("x", bound_input, sizeof(bound_input)),
+            kTfLiteOk);
+  ASSERT_EQ(
+      runner->BindOutputBuffer("output_0", bound_output, sizeof(bound_output)),
+      kTfLiteOk);
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(bound_output[0], 4);
+  EXPECT_EQ(bound_output[1], 6);
+  EXPECT_EQ(bound_output[2], 8);
+}
+
+TEST(SignatureRunnerTest, BindInvalidBuffers) {
+  std::unique_ptr<Interpreter> interpreter = BuildMultiSignatures();
+  ASSERT_NE(interpreter, nullptr);
+  SignatureRunner* runner = interpreter->GetSignatureRunner("add");
+  ASSERT_NE(runner, nullptr);
+  ASSERT_EQ(runner->ResizeInputTensor("x", {2}), kTfLiteOk);
+  ASSERT_EQ(runner->AllocateTensors(), kTfLiteOk);
+
+  alignas(kDefaultTensorAlignment) float buffer[3] = {2, 4, 6};
+  EXPECT_EQ(runner->BindInputBuffer("dummy", buffer, sizeof(buffer)),
+            kTfLiteError);
+  EXPECT_EQ(runner->BindOutputBuffer("x", buffer, sizeof(buffer)),
+            kTfLiteError);
+  EXPECT_EQ(runner->BindInputBuffer("x", nullptr, sizeof(buffer)),
+            kTfLiteError);
+  EXPECT_EQ(runner->BindInputBuffer("x", buffer, sizeof(float)),
+            kTfLiteError);
+  // Misaligned buffers are only accepted with the flag.
+  EXPECT_EQ(runner->BindInputBuffer("x", buffer + 1, 2 * sizeof(float)),
+            kTfLiteError);
+  ASSERT_EQ(runner->BindInputBuffer("x", buffer + 1, 2 * sizeof(float),
+                                    kTfLiteCustomAllocationFlagsSkipAlignCheck),
+            kTfLiteOk);
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(runner->output_tensor("output_0")->data.f[0], 6);
+  EXPECT_EQ(runner->output_tensor("output_0")->data.f[1], 8);
+
+  // Cleared bindings aren't used.
+  ASSERT_EQ(runner->BindInputBuffer("x", buffer, sizeof(buffer)), kTfLiteOk);
+  runner->ClearBoundBuffers();
+  runner->input_tensor("x")->data.f[0] = 0;
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(runner->output_tensor("output_0")->data.f[0], 2);
+}
+
 }  // namespace
 }  // namespace impl
 }  // namespace tflite
@@ -22,6 +22,7 @@ limitations under the License.
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -37,9 +38,11 @@ limitations under the License.
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
+#include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/minimal_logging.h"
@@ -50,6 +53,7 @@ limitations under the License.
 #include "tensorflow/lite/simple_planner.h"
 #else
 #include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/arena_planning_strategy.h"
 #endif
 #ifdef TF_LITE_TENSORFLOW_PROFILER
 #include "tensorflow/lite/tensorflow_profiler_logger.h"
@@ -190,6 +194,22 @@ TfLiteStatus VerifyCustomAllocationForTensor(
   return kTfLiteOk;
 }
 
+// Initial value of the FNV-1a hashes computed by MixIntoKey().
+constexpr uint64_t kInitialKey = 0xcbf29ce484222325ULL;
+
+// Mixes `value` into the FNV-1a hash `key`.
+void MixIntoKey(int64_t value, uint64_t* key) {
+  for (int i = 0; i < 8; ++i) {
+    *key = (*key ^ ((value >> (8 * i)) & 0xff)) * 0x100000001b3ULL;
+  }
+}
+
+void MixArrayIntoKey(const TfLiteIntArray* array, uint64_t* key) {
+  if (array == nullptr) return MixIntoKey(-1, key);
+  MixIntoKey(array->size, key);
+  for (int i = 0; i < array->size; ++i) MixIntoKey(array->data[i], key);
+}
+
 }  // namespace
 
 // A trivial implementation of GraphInfo around the Interpreter.
@@ -489,6 +509,71 @@ const char* GetDelegateKernalName(const TfLiteRegistration& registration) {
   return "unknown";
 }
 
+// Returns the fused activation function in the `builtin_data` of a node of
+// the builtin op `builtin_code`, or nullptr if the op has none.
+TfLiteFusedActivation* GetFusedActivation(int32_t builtin_code,
+                                          void* builtin_data) {
+  if (builtin_data == nullptr) return nullptr;
+  switch (builtin_code) {
+    case kTfLiteBuiltinAdd:
+      return &static_cast<TfLiteAddParams*>(builtin_data)->activation;
+    case kTfLiteBuiltinSub:
+      return &static_cast<TfLiteSubParams*>(builtin_data)->activation;
+    case kTfLiteBuiltinMul:
+      return &static_cast<TfLiteMulParams*>(builtin_data)->activation;
+    case kTfLiteBuiltinDiv:
+      return &static_cast<TfLiteDivParams*>(builtin_data)->activation;
+    case kTfLiteBuiltinConv2d:
+      return &static_cast<TfLiteConvParams*>(builtin_data)->activation;
+    case kTfLiteBuiltinDepthwiseConv2d:
+      return &static_cast<TfLiteDepthwiseConvParams*>(builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinFullyConnected:
+      return &static_cast<TfLiteFullyConnectedParams*>(builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinMaxPool2d:
+      return &static_cast<TfLitePoolParams*>(builtin_data)->activation;
+    default:
+      return nullptr;
+  }
+}
+
+// Returns the activation function computed by the builtin op `builtin_code`,
+// or kTfLiteActNone if the op isn't one.
+TfLiteFusedActivation GetActivationOfOp(int32_t builtin_code) {
+  switch (builtin_code) {
+    case kTfLiteBuiltinRelu:
+      return kTfLiteActRelu;
+    case kTfLiteBuiltinReluN1To1:
+      return kTfLiteActReluN1To1;
+    case kTfLiteBuiltinRelu6:
+      return kTfLiteActRelu6;
+    default:
+      return kTfLiteActNone;
+  }
+}
+
+// Returns true if an activation from `input` to `output` computes the same
+// values as the activation fused into the op producing `input`, which clamps
+// its output in the representation of `input`.
+bool CanFuseActivation(const TfLiteTensor& input, const TfLiteTensor& output) {
+  if (input.type != output.type || input.is_variable ||
+      input.allocation_type != kTfLiteArenaRw) {
+    return false;
+  }
+  switch (input.type) {
+    case kTfLiteFloat32:
+      return true;
+    case kTfLiteInt8:
+    case kTfLiteUInt8:
+      return input.params.scale == output.params.scale &&
+             input.params.zero_point == output.params.zero_point;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 TfLiteStatus Subgraph::PartitionGraph(const TfLiteIntArray* nodes_to_replace,
@@ -1006,9 +1091,22 @@ TfLiteStatus Subgraph::AllocateTensors() {
   if (memory_planner_) {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
   }
+  TF_LITE_ENSURE_STATUS(ScheduleExecutionStages());
+  if (node_prepared_tensors_execution_plan_ != execution_plan_) {
+    // Node indices are only meaningful for the same execution plan.
+    node_prepared_tensors_.clear();
+    node_prepared_tensors_execution_plan_ = execution_plan_;
+  }
+  uint64_t input_shape_key = 0;
+  if (MemoryPlanCacheSize() > 0) {
+    input_shape_key = InputShapeKey();
+    // A plan restored by RestoreMemoryPlan() takes precedence.
+    if (pending_memory_plan_.empty()) RestoreCachedMemoryPlan(input_shape_key);
+  }
 
   TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
 
+  if (MemoryPlanCacheSize() > 0) CacheMemoryPlan(input_shape_key);
   state_ = kStateInvokable;
 
   // Reset the variable tensors to zero after (re)allocating the tensors.
@@ -1462,6 +1560,13 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
     TfLiteNode& node = nodes_and_registration_[node_index].first;
     const TfLiteRegistration& registration =
         nodes_and_registration_[node_index].second;
+    // Only nodes of `execution_plan_` have their preparation tracked.
+    const bool prepare_incrementally =
+        ShouldPrepareIncrementally() && &execution_plan == &execution_plan_;
+    if (prepare_incrementally && CanSkipPrepare(node_index)) {
+      *last_execution_plan_index_prepared = execution_plan_index;
+      continue;
+    }
     EnsureTensorsVectorCapacity();
 #ifdef TF_LITE_TENSORFLOW_PROFILER
     tflite::OnTfLiteOpPrepare(GetTFLiteOpName(registration), subgraph_index_,
@@ -1481,8 +1586,17 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
     // sizes of other tensors in the graph.
     if (HasDynamicTensor(context_, node.outputs, &dynamic_tensor_index_)) {
       has_dynamic_tensors_ = true;
+      if (prepare_incrementally && node_index < node_prepared_tensors_.size()) {
+        node_prepared_tensors_[node_index].clear();
+      }
       return kTfLiteOk;
     }
+    if (prepare_incrementally) {
+      if (node_index >= node_prepared_tensors_.size()) {
+        node_prepared_tensors_.resize(nodes_and_registration_.size());
+      }
+      GetPreparedTensorsState(node, &node_prepared_tensors_[node_index]);
+    }
   }
   return kTfLiteOk;
 }
@@ -1521,13 +1635,38 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
 #ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
     memory_planner_.reset(new SimplePlanner(&context_, CreateGraphInfo()));
 #else
+    std::unique_ptr<ArenaPlanningStrategy> strategy;
+    if (options_ && options_->GetArenaPlanningAlgorithm() ==
+                        ArenaPlanningAlgorithm::kBestFitSearch) {
+      strategy = std::make_unique<BestFitSearchStrategy>(
+          options_->GetArenaPlanningTimeBudgetUs());
+    }
     memory_planner_ = std::make_unique<ArenaPlanner>(
         &context_, CreateGraphInfo(), ShouldPreserveAllTensors(),
-        kDefaultTensorAlignment, subgraph_index_);
+        kDefaultTensorAlignment, subgraph_index_, std::move(strategy));
 #endif
+    memory_planner_->SetExecutionStages(execution_stage_ends_);
     memory_planner_->PlanAllocations();
   }
 
+  if (!pending_memory_plan_.empty()) {
+    // Node indices in the plan are only meaningful for the same partitioning.
+    if (pending_memory_plan_execution_plan_ == execution_plan_) {
+      if (memory_planner_->RestorePlan(pending_memory_plan_) != kTfLiteOk) {
+        TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+                   "Ignoring the memory plan restored for subgraph %d.",
+                   subgraph_index_);
+      }
+    } else {
+      TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+                 "Ignoring the memory plan restored for subgraph %d, which "
+                 "was made for a different execution plan.",
+                 subgraph_index_);
+    }
+    pending_memory_plan_.clear();
+    pending_memory_plan_execution_plan_.clear();
+  }
+
   // Execute arena allocations.
   TF_LITE_ENSURE_STATUS(memory_planner_->ExecuteAllocations(
       next_execution_plan_index_to_plan_allocation_,
@@ -1577,6 +1716,65 @@ TfLiteStatus Subgraph::RemoveUnusedInputs() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::FuseActivations(int* num_fused_nodes) {
+  *num_fused_nodes = 0;
+  if (memory_planner_ || !delegates_applied_.empty()) {
+    ReportError(
+        "FuseActivations must be called before AllocateTensors and "
+        "ModifyGraphWithDelegate.");
+    return kTfLiteError;
+  }
+  // The tensors between the ops and their activations wouldn't be computed.
+  if (ShouldPreserveAllTensors()) return kTfLiteOk;
+
+  std::vector<int> input_tensors_count = GetInputTensorsCount();
+  std::vector<int> producers(tensors_.size(), -1);
+  std::vector<int> new_plan;
+  new_plan.reserve(execution_plan_.size());
+  for (int node_index : execution_plan_) {
+    auto& [node, registration] = nodes_and_registration_[node_index];
+    const TfLiteFusedActivation activation =
+        GetActivationOfOp(registration.builtin_code);
+    if (activation != kTfLiteActNone && node.delegate == nullptr &&
+        node.inputs->size == 1 && node.outputs->size == 1 &&
+        node.inputs->data[0] != kTfLiteOptionalTensor) {
+      const int input = node.inputs->data[0];
+      const int output = node.outputs->data[0];
+      const int producer_index = producers[input];
+      if (producer_index != -1 && input_tensors_count[input] == 1 &&
+          CanFuseActivation(tensors_[input], tensors_[output])) {
+        TfLiteNode& producer = nodes_and_registration_[producer_index].first;
+        TfLiteFusedActivation* fused_activation = GetFusedActivation(
+            nodes_and_registration_[producer_index].second.builtin_code,
+            producer.builtin_data);
+        if (fused_activation != nullptr &&
+            *fused_activation == kTfLiteActNone) {
+          // The producer writes the output of the activation instead, and the
+          // tensor in between is left without any node to allocate it.
+          *fused_activation = activation;
+          producer.outputs->data[0] = output;
+          producers[output] = producer_index;
+          ++*num_fused_nodes;
+          continue;
+        }
+      }
+    }
+    new_plan.push_back(node_index);
+    // Only the producers of single outputs may have an activation fused.
+    if (node.outputs->size == 1 && node.delegate == nullptr &&
+        node.outputs->data[0] != kTfLiteOptionalTensor) {
+      producers[node.outputs->data[0]] = node_index;
+    }
+  }
+  if (*num_fused_nodes > 0) {
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_INFO,
+                    "Fused %d activation node(s) into their producers in "
+                    "subgraph %d.",
+                    *num_fused_nodes, subgraph_index_);
+  }
+  return SetExecutionPlan(new_plan);
+}
+
 TfLiteStatus Subgraph::Invoke() {
   auto status = InvokeImpl();
   telemetry::TelemetryReportEvent(&context_, "Invoke", status);
@@ -1602,12 +1800,19 @@ TfLiteStatus Subgraph::InvokeImpl() {
       tflite::OnTfLiteSubgraphInvoke(name_.c_str(), subgraph_index_);
 #endif  // TF_LITE_TENSORFLOW_PROFILER
 
-  // Invocations are always done in node order.
+  // Invocations are always done in node order, except for the nodes of a
+  // stage which may run concurrently.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
   // called.
-  for (int execution_plan_index = 0;
-       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
+  int execution_plan_index = 0;
+  if (!execution_stage_ends_.empty() && !has_dynamic_tensors_ &&
+      next_execution_plan_index_to_prepare_ == execution_plan_.size() &&
+      !ShouldOptimizeMemoryForLargeTensors()) {
+    TF_LITE_ENSURE_STATUS(InvokeStages(&execution_plan_index));
+  }
+  for (; execution_plan_index < execution_plan_.size();
+       execution_plan_index++) {
     if (execution_plan_index == next_execution_plan_index_to_prepare_) {
       TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
       TF_LITE_ENSURE(&context_, next_execution_plan_index_to_prepare_ >=
@@ -1636,52 +1841,12 @@ TfLiteStatus Subgraph::InvokeImpl() {
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(
         profile_op ? profiler_.get() : nullptr, op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureOpInputsAreReadable(node, registration));
     // Allocate dynamic tensors which memory is required to be allocated
     // before executing the node.
     MayAllocateOpOutput(&node);
 
-    if (check_cancelled_func_ != nullptr &&
-        check_cancelled_func_(cancellation_data_)) {
-      ReportError("Client requested cancel during Invoke()");
-      return kTfLiteError;
-    }
-
-    if (continue_invocation_ && !continue_invocation_->test_and_set()) {
-      // `Cancel` is called and cancellation flag is flipped.
-      ReportError("Client requested cancel during Invoke()");
-      return kTfLiteCancelled;
-    }
+    TF_LITE_ENSURE_STATUS(CheckCancelled());
 
     EnsureTensorsVectorCapacity();
     tensor_resized_since_op_invoke_ = false;
@@ -1723,6 +1888,292 @@ TfLiteStatus Subgraph::InvokeImpl() {
   return status;
 }
 
+TfLiteStatus Subgraph::EnsureOpInputsAreReadable(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::CheckCancelled() {
+  if (check_cancelled_func_ != nullptr &&
+      check_cancelled_func_(cancellation_data_)) {
+    ReportError("Client requested cancel during Invoke()");
+    return kTfLiteError;
+  }
+
+  if (continue_invocation_ && !continue_invocation_->test_and_set()) {
+    // `Cancel` is called and cancellation flag is flipped.
+    ReportError("Client requested cancel during Invoke()");
+    return kTfLiteCancelled;
+  }
+  return kTfLiteOk;
+}
+
+bool Subgraph::MustRunAlone(int node_index) const {
+  const TfLiteNode& node = nodes_and_registration_[node_index].first;
+  const TfLiteRegistration& registration =
+      nodes_and_registration_[node_index].second;
+  // Delegate kernels may share state across nodes, and custom ops are
+  // unknown.
+  if (node.delegate != nullptr ||
+      registration.builtin_code == kTfLiteBuiltinDelegate ||
+      registration.builtin_code == kTfLiteBuiltinCustom) {
+    return true;
+  }
+  // Control flow and resource ops.
+  if (node.might_have_side_effect) return true;
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinStablehloReduce:
+    case kTfLiteBuiltinStablehloReduceWindow:
+    case kTfLiteBuiltinStablehloScatter:
+    case kTfLiteBuiltinStablehloSort:
+    case kTfLiteBuiltinStablehloWhile:
+      // These run other subgraphs.
+      return true;
+    default:
+      break;
+  }
+  for (const TfLiteIntArray* tensor_indices : {node.inputs, node.outputs}) {
+    for (int i = 0; i < tensor_indices->size; ++i) {
+      const int tensor_index = tensor_indices->data[i];
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      if (tensors_[tensor_index].type == kTfLiteVariant) return true;
+    }
+  }
+  if (control_edges_ != nullptr) {
+    for (const ControlEdge& edge : *control_edges_) {
+      if (edge.first == node_index || edge.second == node_index) return true;
+    }
+  }
+  return false;
+}
+
+TfLiteStatus Subgraph::ScheduleExecutionStages() {
+  std::vector<int> stage_ends;
+  std::vector<int> execution_plan = execution_plan_;
+  if (ShouldRunIndependentNodesConcurrently() && !execution_plan.empty()) {
+    // Assign each node the earliest level after the levels of the nodes it
+    // depends on. Nodes of the same level don't depend on each other.
+    std::vector<int> levels(execution_plan.size());
+    // Last level writing each tensor, and last level reading it since.
+    std::vector<int> write_levels(tensors_.size(), -1);
+    std::vector<int> read_levels(tensors_.size(), -1);
+    // Nodes may not move before a node running alone.
+    int min_level = 0;
+    int max_level = -1;
+    for (int i = 0; i < execution_plan.size(); ++i) {
+      const int node_index = execution_plan[i];
+      const TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const bool run_alone = MustRunAlone(node_index);
+      int level = run_alone ? max_level + 1 : min_level;
+      for (int j = 0; j < node.inputs->size; ++j) {
+        const int tensor_index = node.inputs->data[j];
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        level = std::max(level, write_levels[tensor_index] + 1);
+        // Variable tensors are updated in place.
+        if (tensors_[tensor_index].is_variable) {
+          level = std::max(level, read_levels[tensor_index] + 1);
+        }
+      }
+      for (int j = 0; j < node.outputs->size; ++j) {
+        const int tensor_index = node.outputs->data[j];
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        level = std::max(level, std::max(write_levels[tensor_index],
+                                         read_levels[tensor_index]) +
+                                    1);
+      }
+      for (int j = 0; j < node.inputs->size; ++j) {
+        const int tensor_index = node.inputs->data[j];
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        read_levels[tensor_index] = std::max(read_levels[tensor_index], level);
+        if (tensors_[tensor_index].is_variable) {
+          write_levels[tensor_index] = level;
+        }
+      }
+      for (int j = 0; j < node.outputs->size; ++j) {
+        const int tensor_index = node.outputs->data[j];
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        write_levels[tensor_index] = level;
+      }
+      if (run_alone) min_level = level + 1;
+      max_level = std::max(max_level, level);
+      levels[i] = level;
+    }
+
+    // Stages are only worth it if some of them hold several nodes.
+    if (max_level + 1 < execution_plan.size()) {
+      std::vector<int> order(execution_plan.size());
+      for (int i = 0; i < order.size(); ++i) order[i] = i;
+      std::stable_sort(order.begin(), order.end(), [&levels](int a, int b) {
+        return levels[a] < levels[b];
+      });
+      for (int i = 0; i < order.size(); ++i) {
+        execution_plan[i] = execution_plan_[order[i]];
+        if (i > 0 && levels[order[i]] != levels[order[i - 1]]) {
+          stage_ends.push_back(i);
+        }
+      }
+      stage_ends.push_back(execution_plan.size());
+    }
+  }
+
+  if (execution_plan == execution_plan_ &&
+      stage_ends == execution_stage_ends_) {
+    return kTfLiteOk;
+  }
+  execution_plan_ = std::move(execution_plan);
+  execution_stage_ends_ = std::move(stage_ends);
+  if (memory_planner_) {
+    memory_planner_->SetExecutionStages(execution_stage_ends_);
+    TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::InvokeStageOp(int execution_plan_index) {
+  int node_index = execution_plan_[execution_plan_index];
+  TfLiteNode& node = nodes_and_registration_[node_index].first;
+  const TfLiteRegistration& registration =
+      nodes_and_registration_[node_index].second;
+
+  const char* op_name = nullptr;
+  if (profiler_) op_name = GetTFLiteOpName(registration);
+#ifdef TF_LITE_TENSORFLOW_PROFILER
+  if (!op_name) {
+    op_name = GetTFLiteOpName(registration);
+  }
+  tensorflow::profiler::TraceMe* trace_op =
+      tflite::OnTfLiteOpInvoke(op_name, subgraph_index_, node_index);
+#endif  // TF_LITE_TENSORFLOW_PROFILER
+
+  // If per operator profiling flag is set in the delegate, this macro op
+  // should not be profiled, thus a nullptr is passed to the ScopedProfile
+  bool profile_op =
+      !(node.delegate != nullptr &&
+        (node.delegate->flags & kTfLiteDelegateFlagsPerOperatorProfiling));
+  TfLiteStatus status;
+  {
+    TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(
+        profile_op ? profiler_.get() : nullptr, op_name, node_index);
+    status = OpInvoke(registration, &node);
+  }
+
+#ifdef TF_LITE_TENSORFLOW_PROFILER
+  tflite::OnTfLiteOpInvokeEnd(trace_op);
+#endif  // TF_LITE_TENSORFLOW_PROFILER
+  return status;
+}
+
+TfLiteStatus Subgraph::InvokeStages(int* next_execution_plan_index) {
+  // Nodes of a stage run concurrently only once the CPU backend context has
+  // been created, i.e. once a kernel has used it.
+  auto* external_context = static_cast<ExternalCpuBackendContext*>(
+      GetExternalContext(kTfLiteCpuBackendContext));
+  TfLiteInternalBackendContext* backend_context =
+      external_context != nullptr ? external_context->internal_backend_context()
+                                  : nullptr;
+
+  int stage_start = 0;
+  for (int stage_end : execution_stage_ends_) {
+    // Anything touching the subgraph state is done on this thread, before
+    // and after running the nodes of the stage.
+    for (int i = stage_start; i < stage_end; ++i) {
+      const int node_index = execution_plan_[i];
+      TF_LITE_ENSURE_STATUS(EnsureOpInputsAreReadable(
+          nodes_and_registration_[node_index].first,
+          nodes_and_registration_[node_index].second));
+    }
+    TF_LITE_ENSURE_STATUS(CheckCancelled());
+    EnsureTensorsVectorCapacity();
+    tensor_resized_since_op_invoke_ = false;
+
+    const int num_nodes = stage_end - stage_start;
+    std::vector<TfLiteStatus> statuses(num_nodes, kTfLiteOk);
+    const int num_tasks =
+        std::min(num_nodes, context_.recommended_num_threads);
+    if (backend_context == nullptr || num_tasks <= 1) {
+      for (int i = stage_start; i < stage_end; ++i) {
+        statuses[i - stage_start] = InvokeStageOp(i);
+        if (statuses[i - stage_start] != kTfLiteOk) break;
+      }
+    } else {
+      std::atomic<int> next_index(stage_start);
+      backend_context->RunConcurrently(num_tasks, [&](int) {
+        for (int i = next_index++; i < stage_end; i = next_index++) {
+          statuses[i - stage_start] = InvokeStageOp(i);
+        }
+      });
+    }
+
+    bool replan = false;
+    for (int i = stage_start; i < stage_end; ++i) {
+      const int node_index = execution_plan_[i];
+      TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[node_index].second;
+      if (auto s = statuses[i - stage_start]; s != kTfLiteOk) {
+        auto err = ReportOpError(&context_, node, registration, node_index,
+                                 "failed to invoke");
+        return s == kTfLiteCancelled ? s : err;
+      }
+      if (tensor_resized_since_op_invoke_ &&
+          HasDynamicTensor(context_, node.outputs, nullptr)) {
+        replan = true;
+      }
+      MaybeReleaseDynamicTensors(node, node_index);
+    }
+    stage_start = stage_end;
+
+    // A node of the stage resized a dynamic tensor. The remaining nodes run
+    // one at a time, after preparing them again like Invoke() does.
+    if (replan) {
+      next_execution_plan_index_to_prepare_ = stage_end;
+      if (next_execution_plan_index_to_plan_allocation_ >
+          next_execution_plan_index_to_prepare_) {
+        next_execution_plan_index_to_plan_allocation_ =
+            next_execution_plan_index_to_prepare_;
+        if (memory_planner_) {
+          TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocationsAfter(
+              next_execution_plan_index_to_plan_allocation_ - 1));
+        }
+      }
+      break;
+    }
+  }
+  *next_execution_plan_index = stage_start;
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -2394,6 +2845,164 @@ void Subgraph::GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const {
   }
 }
 
+uint64_t Subgraph::MemoryPlanKey() const {
+  uint64_t key = kInitialKey;
+  MixIntoKey(execution_plan_.size(), &key);
+  for (int node_index : execution_plan_) {
+    const auto& [node, registration] = nodes_and_registration_[node_index];
+    MixIntoKey(node_index, &key);
+    MixIntoKey(registration.builtin_code, &key);
+    MixIntoKey(registration.version, &key);
+    if (registration.custom_name != nullptr) {
+      for (const char* c = registration.custom_name; *c != '\0'; ++c) {
+        MixIntoKey(*c, &key);
+      }
+    }
+    MixArrayIntoKey(node.inputs, &key);
+    MixArrayIntoKey(node.outputs, &key);
+    MixArrayIntoKey(node.intermediates, &key);
+    MixArrayIntoKey(node.temporaries, &key);
+  }
+  MixIntoKey(inputs_.size(), &key);
+  for (int tensor_index : inputs_) {
+    MixIntoKey(tensor_index, &key);
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    MixIntoKey(tensors_[tensor_index].type, &key);
+    MixArrayIntoKey(tensors_[tensor_index].dims, &key);
+  }
+  return key;
+}
+
+TfLiteStatus Subgraph::SerializeMemoryPlan(std::string* plan) const {
+  if (memory_planner_ == nullptr) return kTfLiteError;
+  std::string planner_plan;
+  TF_LITE_ENSURE_STATUS(memory_planner_->SerializePlan(&planner_plan));
+  plan->clear();
+  AppendToBuffer(static_cast<uint32_t>(execution_plan_.size()), plan);
+  for (int node_index : execution_plan_) {
+    AppendToBuffer(static_cast<int32_t>(node_index), plan);
+  }
+  plan->append(planner_plan);
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::RestoreMemoryPlan(const std::string& plan) {
+  size_t pos = 0;
+  uint32_t num_nodes;
+  TF_LITE_ENSURE(&context_, ReadFromBuffer(plan, &pos, &num_nodes));
+  TF_LITE_ENSURE(&context_, num_nodes <= (plan.size() - pos) / sizeof(int32_t));
+  std::vector<int> execution_plan(num_nodes);
+  for (int& node_index : execution_plan) {
+    int32_t value;
+    TF_LITE_ENSURE(&context_, ReadFromBuffer(plan, &pos, &value));
+    node_index = value;
+  }
+  pending_memory_plan_execution_plan_ = std::move(execution_plan);
+  pending_memory_plan_ = plan.substr(pos);
+  TF_LITE_ENSURE(&context_, !pending_memory_plan_.empty());
+  // Allocations are only restored when AllocateTensors() plans them.
+  if (state_ == kStateInvokable) state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+uint64_t Subgraph::InputShapeKey() const {
+  uint64_t key = kInitialKey;
+  MixIntoKey(execution_plan_.size(), &key);
+  for (int node_index : execution_plan_) MixIntoKey(node_index, &key);
+  MixIntoKey(inputs_.size(), &key);
+  for (int tensor_index : inputs_) {
+    MixIntoKey(tensor_index, &key);
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    MixIntoKey(tensors_[tensor_index].type, &key);
+    MixArrayIntoKey(tensors_[tensor_index].dims, &key);
+  }
+  return key;
+}
+
+void Subgraph::RestoreCachedMemoryPlan(uint64_t key) {
+  for (auto it = memory_plan_cache_.begin(); it != memory_plan_cache_.end();
+       ++it) {
+    if (it->first != key) continue;
+    memory_plan_cache_.splice(memory_plan_cache_.begin(), memory_plan_cache_,
+                              it);
+    // The planner still checks that all the tensor sizes and lifetimes match
+    // the cached plan, which makes key collisions harmless.
+    pending_memory_plan_ = it->second;
+    pending_memory_plan_execution_plan_ = execution_plan_;
+    return;
+  }
+}
+
+void Subgraph::CacheMemoryPlan(uint64_t key) {
+  // The plan of a subgraph with dynamic tensors is only complete once it ran.
+  if (memory_planner_ == nullptr || has_dynamic_tensors_) return;
+  if (!memory_plan_cache_.empty() && memory_plan_cache_.front().first == key &&
+      memory_planner_->HasRestoredPlan()) {
+    return;
+  }
+  std::string plan;
+  if (memory_planner_->SerializePlan(&plan) != kTfLiteOk) return;
+  memory_plan_cache_.remove_if(
+      [key](const std::pair<uint64_t, std::string>& cached_plan) {
+        return cached_plan.first == key;
+      });
+  memory_plan_cache_.emplace_front(key, std::move(plan));
+  while (memory_plan_cache_.size() > MemoryPlanCacheSize()) {
+    memory_plan_cache_.pop_back();
+  }
+}
+
+void Subgraph::GetPreparedTensorsState(const TfLiteNode& node,
+                                       std::vector<int64_t>* state) const {
+  state->clear();
+  for (const TfLiteIntArray* tensor_indices :
+       {node.inputs, node.outputs, node.temporaries}) {
+    state->push_back(tensor_indices->size);
+    for (int i = 0; i < tensor_indices->size; ++i) {
+      const int tensor_index = tensor_indices->data[i];
+      state->push_back(tensor_index);
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors_[tensor_index];
+      state->push_back(tensor.type);
+      state->push_back(tensor.allocation_type);
+      state->push_back(tensor.bytes);
+      state->push_back(tensor.dims->size);
+      state->insert(state->end(), tensor.dims->data,
+                    tensor.dims->data + tensor.dims->size);
+    }
+  }
+}
+
+bool Subgraph::CanSkipPrepare(int node_index) {
+  if (node_index < 0 ||
+      static_cast<size_t>(node_index) >= node_prepared_tensors_.size() ||
+      node_prepared_tensors_[node_index].empty()) {
+    return false;
+  }
+  const TfLiteNode& node = nodes_and_registration_[node_index].first;
+  // Delegate kernels may depend on the whole graph, and control flow ops on
+  // other subgraphs.
+  if (node.delegate != nullptr || node.might_have_side_effect) return false;
+  // Kernels may read the values of their inputs while preparing. Those of
+  // read-only tensors can't change, and those of arena tensors aren't set
+  // while preparing, except for variables, which keep their values across
+  // invocations. The values of other tensors, e.g. dynamic ones, may have
+  // changed with the same shape.
+  for (int i = 0; i < node.inputs->size; ++i) {
+    const int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    if (tensor.is_variable) return false;
+    if (tensor.allocation_type != kTfLiteArenaRw &&
+        tensor.allocation_type != kTfLiteArenaRwPersistent &&
+        tensor.allocation_type != kTfLiteMmapRo) {
+      return false;
+    }
+  }
+  GetPreparedTensorsState(node, &prepared_tensors_scratch_);
+  return prepared_tensors_scratch_ == node_prepared_tensors_[node_index];
+}
+
 std::unique_ptr<GraphInfo> Subgraph::CreateGraphInfo() {
   return std::unique_ptr<GraphInfo>(new InterpreterInfo(this));
 }
@@ -20,8 +20,10 @@ limitations under the License.
 
 #include <atomic>
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -428,6 +430,32 @@ class Subgraph {
   // Returns memory allocation status.
   void GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const;
 
+  // WARNING: This is an experimental API and subject to change.
+  // Returns a fingerprint of the graph as seen by the memory planner: the
+  // operators of the execution plan, including the delegate kernels, their
+  // inputs and outputs, and the type and shape of the subgraph inputs. Two
+  // subgraphs with the same key get the same memory plan.
+  uint64_t MemoryPlanKey() const;
+
+  // WARNING: This is an experimental API and subject to change.
+  // Serializes the execution plan and the tensor allocations made by the
+  // memory planner into `plan`. Must be called after AllocateTensors().
+  TfLiteStatus SerializeMemoryPlan(std::string* plan) const;
+
+  // WARNING: This is an experimental API and subject to change.
+  // Makes the next AllocateTensors() reuse the offsets serialized by
+  // SerializeMemoryPlan() instead of choosing them, provided the execution
+  // plan and the size and lifetime of all the tensors match the serialized
+  // ones. Otherwise the plan is dropped and allocations are planned as usual.
+  // Ops are prepared and tensor lifetimes are computed either way.
+  TfLiteStatus RestoreMemoryPlan(const std::string& plan);
+
+  // WARNING: This is an experimental API and subject to change.
+  // Returns true if the tensors are allocated from a restored memory plan.
+  bool HasRestoredMemoryPlan() const {
+    return memory_planner_ && memory_planner_->HasRestoredPlan();
+  }
+
   // WARNING: This is an experimental API and subject to change.
   // Set the given `InterpreterOptions` object.
   void SetOptions(InterpreterOptions* options) { options_ = options; }
@@ -445,6 +473,24 @@ class Subgraph {
     return (options_ && options_->GetEnsureDynamicTensorsAreReleased());
   }
 
+  // WARNING: This is an experimental API and subject to change.
+  // True if nodes which don't depend on each other may run concurrently.
+  bool ShouldRunIndependentNodesConcurrently() const {
+    return (options_ && options_->GetInterOpParallelism());
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // Number of memory plans kept for different input shapes.
+  int MemoryPlanCacheSize() const {
+    return options_ ? options_->GetMemoryPlanCacheSize() : 0;
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // True if only the nodes whose input shapes changed are prepared again.
+  bool ShouldPrepareIncrementally() const {
+    return (options_ && options_->GetIncrementalPreparation());
+  }
+
   /// WARNING: This is an experimental API and subject to change.
   /// Use dynamic tensor allocation and deallocation method for large tensors
   /// instead of static memory planner. Dynamic tensors are allocated just
@@ -467,6 +513,18 @@ class Subgraph {
   // Currently, it's used to remove unused inputs of WHILE cond subgraphs.
   TfLiteStatus RemoveUnusedInputs();
 
+  // WARNING: This is an experimental API and subject to change.
+  // Fuses the RELU, RELU6 and RELU_N1_TO_1 nodes into the nodes producing
+  // their input, when those are builtin ops with a fused activation function
+  // (e.g. ADD, CONV_2D or FULLY_CONNECTED) and the activation is the only
+  // consumer of their output. The fused nodes are removed from the execution
+  // plan, and the tensors between the ops and their activations are left
+  // unused, so they take no arena memory. Does nothing if all tensors are
+  // preserved. Must be called before the tensors are allocated and the
+  // graph is delegated. Sets `num_fused_nodes` to the number of removed
+  // nodes.
+  TfLiteStatus FuseActivations(int* num_fused_nodes);
+
   // WARNING: This is an experimental API and subject to change.
   // If true, the graph-reordering optimization that finds a topological
   // reordering that keeps delegated nodes together will be disabled.
@@ -586,24 +644,28 @@ class Subgraph {
                         int64_t event_metadata1,
                         int64_t event_metadata2) override {
       if (!profiler_) return 0;
+      std::lock_guard<std::mutex> lock(mutex_);
       return profiler_->BeginEvent(tag, event_type, event_metadata1,
                                    subgraph_index_);
     }
 
     void EndEvent(uint32_t event_handle) override {
       if (!profiler_) return;
+      std::lock_guard<std::mutex> lock(mutex_);
       profiler_->EndEvent(event_handle);
     }
 
     void EndEvent(uint32_t event_handle, int64_t event_metadata1,
                   int64_t event_metadata2) override {
       if (!profiler_) return;
+      std::lock_guard<std::mutex> lock(mutex_);
       profiler_->EndEvent(event_handle, event_metadata1, event_metadata2);
     }
 
     void AddEvent(const char* tag, EventType event_type, uint64_t elapsed_time,
                   int64_t event_metadata1, int64_t event_metadata2) override {
       if (!profiler_) return;
+      std::lock_guard<std::mutex> lock(mutex_);
       profiler_->AddEvent(tag, event_type, elapsed_time, event_metadata1,
                           subgraph_index_);
     }
@@ -611,6 +673,7 @@ class Subgraph {
     void AddEventWithData(const char* tag, EventType event_type,
                           const void* data) override {
       if (!profiler_) return;
+      std::lock_guard<std::mutex> lock(mutex_);
       profiler_->AddEventWithData(tag, event_type, data);
     }
 
@@ -618,6 +681,9 @@ class Subgraph {
     // Not own the memory.
     Profiler* const profiler_;
     const int64_t subgraph_index_;
+    // Serializes the events of nodes running concurrently, since profilers
+    // aren't thread-safe.
+    std::mutex mutex_;
   };
 
   // Ensure the internal node storage memory allocates at least `count`
@@ -672,6 +738,54 @@ class Subgraph {
                                     const std::vector<int>& execution_plan,
                                     int* last_execution_plan_index_prepared);
 
+  // If independent nodes may run concurrently, reorders the execution plan in
+  // stages of nodes which don't depend on each other, and passes them to the
+  // memory planner. Otherwise, clears the stages.
+  TfLiteStatus ScheduleExecutionStages();
+
+  // Returns true if `node` must not run concurrently with any other node,
+  // e.g. because it has side effects or runs other subgraphs.
+  bool MustRunAlone(int node_index) const;
+
+  // Runs the stages of the execution plan, running the nodes of each stage
+  // concurrently on the CPU backend context. Stops early, with
+  // `next_execution_plan_index` set to the first node left to run, if a stage
+  // resized a dynamic tensor.
+  TfLiteStatus InvokeStages(int* next_execution_plan_index);
+
+  // Invokes the node at `execution_plan_index` on behalf of InvokeStages(),
+  // possibly concurrently with other nodes of its stage.
+  TfLiteStatus InvokeStageOp(int execution_plan_index);
+
+  // Checks that the inputs of `node` have data, copying it from delegate
+  // buffers if needed.
+  TfLiteStatus EnsureOpInputsAreReadable(
+      const TfLiteNode& node, const TfLiteRegistration& registration);
+
+  // Returns an error if the client requested to cancel the invocation.
+  TfLiteStatus CheckCancelled();
+
+  // Returns a fingerprint of the execution plan and of the type and shape of
+  // the subgraph inputs, which keys `memory_plan_cache_`.
+  uint64_t InputShapeKey() const;
+
+  // Makes the next PrepareOpsAndTensors() reuse the memory plan cached for
+  // `key`, if any.
+  void RestoreCachedMemoryPlan(uint64_t key);
+
+  // Caches the memory plan made by AllocateTensors() for `key`, evicting the
+  // least recently used plan if the cache is full.
+  void CacheMemoryPlan(uint64_t key);
+
+  // Sets `state` to the type, allocation type, size and shape of the tensors
+  // of `node`, which tell whether preparing it again can be skipped.
+  void GetPreparedTensorsState(const TfLiteNode& node,
+                               std::vector<int64_t>* state) const;
+
+  // Returns true if `node_index` was prepared for the same tensors as it has
+  // now, and may skip being prepared again.
+  bool CanSkipPrepare(int node_index);
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -1046,6 +1160,23 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Memory plan set by RestoreMemoryPlan(), and the execution plan it was
+  // made for. Handed to `memory_planner_` by the next PrepareOpsAndTensors().
+  std::string pending_memory_plan_;
+  std::vector<int> pending_memory_plan_execution_plan_;
+
+  // Memory plans made for different input shapes, keyed by InputShapeKey(),
+  // the most recently used first.
+  std::list<std::pair<uint64_t, std::string>> memory_plan_cache_;
+
+  // GetPreparedTensorsState() of each node when it was last prepared, indexed
+  // by node, or empty if it must be prepared. Only valid for the execution
+  // plan in `node_prepared_tensors_execution_plan_`.
+  std::vector<std::vector<int64_t>> node_prepared_tensors_;
+  std::vector<int> node_prepared_tensors_execution_plan_;
+  // Reused by CanSkipPrepare() to avoid allocations.
+  std::vector<int64_t> prepared_tensors_scratch_;
+
   // Maps tensor index to custom allocation for all applicable tensors.
   std::map<int, TfLiteCustomAllocation> custom_allocations_;
 
@@ -1069,6 +1200,10 @@ class Subgraph {
   // The value is invalid before `PrepareOpStartingAt` is called.
   bool has_dynamic_tensors_ = true;
 
+  // End of each stage of the execution plan, whose nodes may run
+  // concurrently. Empty if nodes run one at a time.
+  std::vector<int> execution_stage_ends_;
+
   // WARNING: This is an experimental interface that is subject to change.
   // This is the index of dynamic tensor which was checked at
   // PrepareOpsStartingAt() when `has_dynamic_tensors_` is set. This information
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <numeric>
@@ -24,7 +25,9 @@ limitations under the License.
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/c_api_types.h"
+#include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/interpreter.h"
 #include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/util.h"
@@ -35,6 +38,8 @@ namespace ops {
 namespace builtin {
 TfLiteRegistration* Register_PADV2();
 TfLiteRegistration* Register_NEG();
+TfLiteRegistration* Register_ADD();
+TfLiteRegistration* Register_RELU();
 }  // namespace builtin
 }  // namespace ops
 
@@ -82,6 +87,93 @@ TEST(RemoveUnusedInputs, BypassInputsWithoutOp) {
   ASSERT_EQ(subgraph.inputs(), std::vector<int>({0, -1, 2}));
 }
 
+// Builds `input0 + input1 -> sum`, `relu(sum) -> output` with tensors
+// {input0, input1, sum, output} of type `type`, where `sum` has the scale
+// `sum_scale`.
+void BuildAddRelu(Interpreter* interpreter, TfLiteType type,
+                  float sum_scale = 1.0f) {
+  interpreter->AddTensors(4);
+  interpreter->SetInputs({0, 1});
+  interpreter->SetOutputs({3});
+  for (int i = 0; i < 4; ++i) {
+    TfLiteQuantizationParams quant = {i == 2 ? sum_scale : 1.0f, 0};
+    interpreter->SetTensorParametersReadWrite(i, type, "", {2}, quant);
+  }
+  TfLiteRegistration add_op = *ops::builtin::Register_ADD();
+  add_op.builtin_code = kTfLiteBuiltinAdd;
+  TfLiteRegistration relu_op = *ops::builtin::Register_RELU();
+  relu_op.builtin_code = kTfLiteBuiltinRelu;
+  auto* add_params =
+      static_cast<TfLiteAddParams*>(calloc(1, sizeof(TfLiteAddParams)));
+  add_params->activation = kTfLiteActNone;
+  interpreter->AddNodeWithParameters({0, 1}, {2}, nullptr, 0, add_params,
+                                     &add_op);
+  interpreter->AddNodeWithParameters({2}, {3}, nullptr, 0, nullptr,
+                                     &relu_op);
+}
+
+TEST(FuseActivations, FusesReluIntoAdd) {
+  Interpreter interpreter;
+  BuildAddRelu(&interpreter, kTfLiteFloat32);
+  auto& subgraph = interpreter.primary_subgraph();
+
+  int num_fused_nodes = 0;
+  ASSERT_EQ(subgraph.FuseActivations(&num_fused_nodes), kTfLiteOk);
+  EXPECT_EQ(num_fused_nodes, 1);
+  ASSERT_EQ(subgraph.execution_plan(), std::vector<int>({0}));
+  const auto* add = subgraph.node_and_registration(0);
+  EXPECT_EQ(add->first.outputs->data[0], 3);
+  EXPECT_EQ(static_cast<TfLiteAddParams*>(add->first.builtin_data)->activation,
+            kTfLiteActRelu);
+
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  // The tensor between the ADD and the RELU isn't allocated anymore.
+  EXPECT_EQ(interpreter.tensor(2)->data.raw, nullptr);
+  interpreter.typed_tensor<float>(0)[0] = -1;
+  interpreter.typed_tensor<float>(0)[1] = 2;
+  interpreter.typed_tensor<float>(1)[0] = -1;
+  interpreter.typed_tensor<float>(1)[1] = 1;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 0);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[1], 3);
+}
+
+TEST(FuseActivations, KeepsActivationsOfGraphOutputs) {
+  Interpreter interpreter;
+  BuildAddRelu(&interpreter, kTfLiteFloat32);
+  // The output of the ADD is read by the application as well.
+  interpreter.SetOutputs({2, 3});
+  auto& subgraph = interpreter.primary_subgraph();
+
+  int num_fused_nodes = 0;
+  ASSERT_EQ(subgraph.FuseActivations(&num_fused_nodes), kTfLiteOk);
+  EXPECT_EQ(num_fused_nodes, 0);
+  EXPECT_EQ(subgraph.execution_plan(), std::vector<int>({0, 1}));
+}
+
+TEST(FuseActivations, KeepsActivationsRequantizing) {
+  Interpreter interpreter;
+  BuildAddRelu(&interpreter, kTfLiteInt8, /*sum_scale=*/0.5f);
+  auto& subgraph = interpreter.primary_subgraph();
+
+  int num_fused_nodes = 0;
+  ASSERT_EQ(subgraph.FuseActivations(&num_fused_nodes), kTfLiteOk);
+  EXPECT_EQ(num_fused_nodes, 0);
+  EXPECT_EQ(subgraph.execution_plan(), std::vector<int>({0, 1}));
+}
+
+TEST(FuseActivations, FailsAfterAllocateTensors) {
+  Interpreter interpreter;
+  BuildAddRelu(&interpreter, kTfLiteFloat32);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  int num_fused_nodes = 0;
+  EXPECT_EQ(interpreter.primary_subgraph().FuseActivations(&num_fused_nodes),
+            kTfLiteError);
+  EXPECT_EQ(interpreter.primary_subgraph().execution_plan(),
+            std::vector<int>({0, 1}));
+}
+
 TEST(GetSubgraphContext, NonConstGetSubgraphContext) {
   Interpreter interpreter;
   auto& subgraph = interpreter.primary_subgraph();
@@ -0,0 +1,215 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/delegates/xnnpack/unpacked_weights_cache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "tensorflow/lite/version.h"
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+constexpr uint32_t kMagic = 0x43555858;  // "XXUC"
+constexpr uint32_t kFormatVersion = 1;
+constexpr size_t kDataAlignment = 64;
+
+struct Header {
+  uint32_t magic;
+  uint32_t format_version;
+  uint64_t version_hash;
+  uint64_t key;
+  uint64_t num_entries;
+  uint64_t data_offset;
+  uint64_t data_size;
+};
+
+struct Entry {
+  int64_t tensor;
+  uint64_t offset;
+};
+
+uint64_t VersionHash() {
+  return UnpackedWeightsCache::Hash(TFLITE_VERSION_STRING,
+                                    std::strlen(TFLITE_VERSION_STRING));
+}
+
+size_t DataOffset(size_t num_entries) {
+  const size_t size = sizeof(Header) + num_entries * sizeof(Entry);
+  return (size + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+
+}  // namespace
+
+uint64_t UnpackedWeightsCache::Hash(const void* data, size_t size,
+                                    uint64_t hash) {
+  constexpr uint64_t kPrime = 0x100000001b3ull;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+    hash ^= hash >> 32;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * kPrime;
+  }
+  return hash;
+}
+
+std::string UnpackedWeightsCache::GetPath(const std::string& directory,
+                                          uint64_t key) {
+  char name[64];
+  snprintf(name, sizeof(name), "xnnpack_unpacked_weights_%016" PRIx64 ".bin",
+           key);
+  if (directory.empty() || directory.back() == '/') return directory + name;
+  return directory + "/" + name;
+}
+
+#if defined(_WIN32)
+
+std::string UnpackedWeightsCache::GetModelFileToken(const std::string& path) {
+  return "";
+}
+
+std::unique_ptr<UnpackedWeightsCache> UnpackedWeightsCache::Load(
+    const std::string& path, uint64_t key) {
+  return nullptr;
+}
+
+bool UnpackedWeightsCache::Save(const std::string& path, uint64_t key,
+                                const std::unordered_map<int, size_t>& offsets,
+                                const std::vector<char>& data) {
+  return false;
+}
+
+UnpackedWeightsCache::~UnpackedWeightsCache() = default;
+
+#else
+
+std::string UnpackedWeightsCache::GetModelFileToken(const std::string& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) return "";
+  return path + ":" + std::to_string(static_cast<int64_t>(st.st_size)) + ":" +
+         std::to_string(static_cast<int64_t>(st.st_mtime));
+}
+
+std::unique_ptr<UnpackedWeightsCache> UnpackedWeightsCache::Load(
+    const std::string& path, uint64_t key) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+    close(fd);
+    return nullptr;
+  }
+  const size_t file_size = st.st_size;
+  void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+  if (mapping == MAP_FAILED) return nullptr;
+  std::unique_ptr<UnpackedWeightsCache> cache(
+      new UnpackedWeightsCache(mapping, file_size));
+
+  const char* bytes = static_cast<const char*>(mapping);
+  Header header;
+  std::memcpy(&header, bytes, sizeof(header));
+  if (header.magic != kMagic || header.format_version != kFormatVersion ||
+      header.version_hash != VersionHash() || header.key != key ||
+      header.num_entries > (file_size - sizeof(Header)) / sizeof(Entry) ||
+      header.data_offset != DataOffset(header.num_entries) ||
+      header.data_offset > file_size ||
+      header.data_size != file_size - header.data_offset) {
+    return nullptr;
+  }
+  for (uint64_t i = 0; i < header.num_entries; ++i) {
+    Entry entry;
+    std::memcpy(&entry, bytes + sizeof(Header) + i * sizeof(Entry),
+                sizeof(entry));
+    if (entry.offset > header.data_size) return nullptr;
+    cache->offsets_[static_cast<int>(entry.tensor)] = entry.offset;
+  }
+  cache->data_ = bytes + header.data_offset;
+  cache->size_ = header.data_size;
+  return cache;
+}
+
+bool UnpackedWeightsCache::Save(const std::string& path, uint64_t key,
+                                const std::unordered_map<int, size_t>& offsets,
+                                const std::vector<char>& data) {
+  std::vector<Entry> entries;
+  entries.reserve(offsets.size());
+  for (const auto& [tensor, offset] : offsets) {
+    entries.push_back({tensor, offset});
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.tensor < b.tensor; });
+
+  Header header;
+  header.magic = kMagic;
+  header.format_version = kFormatVersion;
+  header.version_hash = VersionHash();
+  header.key = key;
+  header.num_entries = entries.size();
+  header.data_offset = DataOffset(entries.size());
+  header.data_size = data.size();
+  std::vector<char> prefix(header.data_offset, 0);
+  std::memcpy(prefix.data(), &header, sizeof(header));
+  if (!entries.empty()) {
+    std::memcpy(prefix.data() + sizeof(header), entries.data(),
+                entries.size() * sizeof(Entry));
+  }
+
+  const std::string temp_path =
+      path + ".tmp." + std::to_string(static_cast<int64_t>(getpid()));
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == nullptr) return false;
+  bool ok = fwrite(prefix.data(), 1, prefix.size(), file) == prefix.size() &&
+            fwrite(data.data(), 1, data.size(), file) == data.size();
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+UnpackedWeightsCache::~UnpackedWeightsCache() {
+  munmap(mapping_, mapping_size_);
+}
+
+#endif  // defined(_WIN32)
+
+}  // namespace xnnpack
+}  // namespace tflite
@@ -0,0 +1,95 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_XNNPACK_UNPACKED_WEIGHTS_CACHE_H_
+#define TENSORFLOW_LITE_DELEGATES_XNNPACK_UNPACKED_WEIGHTS_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tflite {
+namespace xnnpack {
+
+// File-backed copy of the static weights unpacked by the delegate, e.g. FP16
+// weights dequantized to FP32.
+//
+// The file is written once by Save() and then mapped read-only by Load(), so
+// that the unpacking is skipped and the unpacked weights are shared through
+// the page cache by all the processes which load the same model.
+//
+// The file starts with a header holding a format version, a hash of the
+// TensorFlow Lite version and the key of the unpacked weights, which is
+// computed by the delegate from the model token and the unpacking nodes.
+// Load() rejects files whose header does not match.
+class UnpackedWeightsCache {
+ public:
+  // Maps the cache file at `path`. Returns nullptr if the file does not
+  // exist, is malformed or was written for another `key` or another version
+  // of TensorFlow Lite.
+  static std::unique_ptr<UnpackedWeightsCache> Load(const std::string& path,
+                                                    uint64_t key);
+
+  // Writes `data`, in which tensor `i` starts at `offsets[i]`, to the cache
+  // file at `path`. The file is written under a temporary name and then
+  // renamed, so that concurrent processes never map a partial file. Returns
+  // false on failure.
+  static bool Save(const std::string& path, uint64_t key,
+                   const std::unordered_map<int, size_t>& offsets,
+                   const std::vector<char>& data);
+
+  // Returns the path of the cache file for `key` in `directory`.
+  static std::string GetPath(const std::string& directory, uint64_t key);
+
+  // Returns a token identifying the model file at `path` by its path, size
+  // and modification time, to be passed to the delegate as the model token of
+  // the cache. Returns an empty string if the file can't be accessed.
+  static std::string GetModelFileToken(const std::string& path);
+
+  // Returns a hash of `size` bytes at `data`, continuing `hash`. It is a
+  // variant of FNV-1a that consumes 8 bytes per step, and is not meant to
+  // resist deliberate collisions.
+  static uint64_t Hash(const void* data, size_t size,
+                       uint64_t hash = 0xcbf29ce484222325ull);
+
+  ~UnpackedWeightsCache();
+
+  UnpackedWeightsCache(const UnpackedWeightsCache&) = delete;
+  UnpackedWeightsCache& operator=(const UnpackedWeightsCache&) = delete;
+
+  // Unpacked weights. Aligned to 64 bytes.
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  // Offset of the unpacked weights of each tensor in data().
+  const std::unordered_map<int, size_t>& offsets() const { return offsets_; }
+
+ private:
+  UnpackedWeightsCache(void* mapping, size_t mapping_size)
+      : mapping_(mapping), mapping_size_(mapping_size) {}
+
+  void* mapping_;
+  size_t mapping_size_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  std::unordered_map<int, size_t> offsets_;
+};
+
+}  // namespace xnnpack
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_XNNPACK_UNPACKED_WEIGHTS_CACHE_H_
@@ -0,0 +1,130 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/delegates/xnnpack/unpacked_weights_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+std::string TempDir() {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  return dir != nullptr ? dir : "/tmp";
+}
+
+#if !defined(_WIN32)
+
+TEST(UnpackedWeightsCacheTest, SaveAndLoad) {
+  const uint64_t key = 0x1234;
+  const std::string path = UnpackedWeightsCache::GetPath(TempDir(), key);
+  std::vector<char> data(100);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i);
+  const std::unordered_map<int, size_t> offsets = {{3, 0}, {7, 48}};
+  ASSERT_TRUE(UnpackedWeightsCache::Save(path, key, offsets, data));
+
+  std::unique_ptr<UnpackedWeightsCache> cache =
+      UnpackedWeightsCache::Load(path, key);
+  ASSERT_NE(cache, nullptr);
+  EXPECT_EQ(cache->offsets(), offsets);
+  ASSERT_EQ(cache->size(), data.size());
+  EXPECT_EQ(std::memcmp(cache->data(), data.data(), data.size()), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(cache->data()) % 64, 0);
+  std::remove(path.c_str());
+}
+
+TEST(UnpackedWeightsCacheTest, RejectsOtherKey) {
+  const std::string path = UnpackedWeightsCache::GetPath(TempDir(), 1);
+  ASSERT_TRUE(
+      UnpackedWeightsCache::Save(path, 1, {{0, 0}}, std::vector<char>(16)));
+  EXPECT_EQ(UnpackedWeightsCache::Load(path, 2), nullptr);
+  std::remove(path.c_str());
+}
+
+TEST(UnpackedWeightsCacheTest, RejectsTruncatedFile) {
+  const std::string path = UnpackedWeightsCache::GetPath(TempDir(), 5);
+  ASSERT_TRUE(
+      UnpackedWeightsCache::Save(path, 5, {{0, 0}}, std::vector<char>(256)));
+  FILE* file = std::fopen(path.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::vector<char> contents(1024);
+  contents.resize(std::fread(contents.data(), 1, contents.size(), file));
+  std::fclose(file);
+  file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fwrite(contents.data(), 1, contents.size() - 1, file);
+  std::fclose(file);
+
+  EXPECT_EQ(UnpackedWeightsCache::Load(path, 5), nullptr);
+  std::remove(path.c_str());
+}
+
+TEST(UnpackedWeightsCacheTest, ModelFileToken) {
+  const std::string path = TempDir() + "/unpacked_weights_cache_model.tflite";
+  FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fwrite("model", 1, 5, file);
+  std::fclose(file);
+  const std::string token = UnpackedWeightsCache::GetModelFileToken(path);
+  EXPECT_EQ(token.rfind(path + ":5:", 0), 0) << token;
+  EXPECT_EQ(UnpackedWeightsCache::GetModelFileToken(path), token);
+
+  // A model file of another size gets another token.
+  file = std::fopen(path.c_str(), "ab");
+  ASSERT_NE(file, nullptr);
+  std::fwrite("v2", 1, 2, file);
+  std::fclose(file);
+  EXPECT_NE(UnpackedWeightsCache::GetModelFileToken(path), token);
+
+  std::remove(path.c_str());
+  EXPECT_EQ(UnpackedWeightsCache::GetModelFileToken(path), "");
+}
+
+#endif  // !defined(_WIN32)
+
+TEST(UnpackedWeightsCacheTest, MissingFile) {
+  EXPECT_EQ(UnpackedWeightsCache::Load(
+                UnpackedWeightsCache::GetPath(TempDir() + "/missing", 0), 0),
+            nullptr);
+}
+
+TEST(UnpackedWeightsCacheTest, HashCoversAllBytes) {
+  std::vector<char> data(100000, 1);
+  const uint64_t hash = UnpackedWeightsCache::Hash(data.data(), data.size());
+  // Every byte, whether in a whole word or in the tail, changes the hash.
+  for (size_t i : {size_t{0}, size_t{12345}, data.size() / 2,
+                   data.size() - 1}) {
+    data[i] = 2;
+    EXPECT_NE(UnpackedWeightsCache::Hash(data.data(), data.size()), hash)
+        << "byte " << i;
+    data[i] = 1;
+  }
+  EXPECT_NE(UnpackedWeightsCache::Hash(data.data(), data.size() - 1), hash);
+}
+
+}  // namespace
+}  // namespace xnnpack
+}  // namespace tflite
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/delegates/xnnpack/quantization_util.h"
+#include "tensorflow/lite/delegates/xnnpack/unpacked_weights_cache.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -499,6 +500,17 @@ class Delegate {
 
     options_ =
         options != nullptr ? *options : TfLiteXNNPackDelegateOptionsDefault();
+    if (options_.experimental_unpacked_weights_cache_dir != nullptr) {
+      unpacked_weights_cache_dir_ =
+          options_.experimental_unpacked_weights_cache_dir;
+    }
+    if (options_.experimental_unpacked_weights_cache_model_token != nullptr) {
+      unpacked_weights_cache_model_token_ =
+          options_.experimental_unpacked_weights_cache_model_token;
+    }
+    // The caller's strings are not guaranteed to outlive the delegate.
+    options_.experimental_unpacked_weights_cache_dir = nullptr;
+    options_.experimental_unpacked_weights_cache_model_token = nullptr;
     workspace_.reset(workspace);
   }
 
@@ -628,7 +640,21 @@ class Delegate {
 
   TfLiteXNNPackDelegateOptions options() const { return options_; }
 
+  // Unpacked data for quasi-static tensors, either unpacked by
+  // PrepareOpsToDelegate or mapped from the unpacked weights cache.
+  const char* static_unpacked_data() const {
+    return unpacked_weights_cache_ != nullptr ? unpacked_weights_cache_->data()
+                                              : static_unpacked_data_.data();
+  }
+
  private:
+  // Returns the key of the unpacked weights cache for the quasi-static
+  // `tensors`, which depends on the model token and on the nodes producing
+  // them.
+  uint64_t UnpackedWeightsKey(
+      TfLiteContext* context, const std::vector<int>& tensors,
+      const std::unordered_map<int, int>& producers) const;
+
   TfLiteDelegate delegate_ = {
       reinterpret_cast<void*>(this),             // .data_
       DelegatePrepare,                           // .Prepare
@@ -651,6 +677,14 @@ class Delegate {
   std::unordered_set<int> static_unpack_nodes_;
   // Set of indices of tensors with unpacked static sparse weights.
   std::unordered_set<int> static_sparse_weights_;
+  // Directory of the unpacked weights cache files, empty if disabled.
+  std::string unpacked_weights_cache_dir_;
+  // Identity of the model file, which keys the unpacked weights cache. The
+  // cache is disabled if it is empty.
+  std::string unpacked_weights_cache_model_token_;
+  // Unpacked weights mapped from the cache, which replace
+  // static_unpacked_data_ when set.
+  std::unique_ptr<xnnpack::UnpackedWeightsCache> unpacked_weights_cache_;
 #if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
   // Thread pool with smart-pointer for lifetime management.
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)> threadpool_{
@@ -927,7 +961,7 @@ class Subgraph {
         // Check for quasi-static data.
         const auto it = delegate.static_unpacked_data_map_.find(t);
         if (it != delegate.static_unpacked_data_map_.end()) {
-          data = delegate.static_unpacked_data_.data() + it->second;
+          data = delegate.static_unpacked_data() + it->second;
         }
       }
       if (inputs.count(t) != 0) {
@@ -6389,10 +6423,45 @@ class Subgraph {
   bool variables_set_up_ = false;
 };
 
+uint64_t Delegate::UnpackedWeightsKey(
+    TfLiteContext* context, const std::vector<int>& tensors,
+    const std::unordered_map<int, int>& producers) const {
+  // The model is identified by its token rather than by hashing its weights,
+  // which would take about as long as unpacking them. The unpacking nodes are
+  // hashed too, so that the subgraphs of a model get different keys.
+  uint64_t key = xnnpack::UnpackedWeightsCache::Hash(
+      unpacked_weights_cache_model_token_.data(),
+      unpacked_weights_cache_model_token_.size());
+  for (int t : tensors) {
+    const int producer_index = producers.at(t);
+    TfLiteNode* node = nullptr;
+    TfLiteRegistration* registration = nullptr;
+    if (context->GetNodeAndRegistration(context, producer_index, &node,
+                                        &registration) != kTfLiteOk ||
+        node->inputs->size != 1) {
+      return 0;
+    }
+    const int input = node->inputs->data[0];
+    const TfLiteTensor& input_tensor = context->tensors[input];
+    const TfLiteTensor& output_tensor = context->tensors[t];
+    const int64_t fields[] = {t,
+                              producer_index,
+                              registration->builtin_code,
+                              input,
+                              input_tensor.type,
+                              static_cast<int64_t>(input_tensor.bytes),
+                              output_tensor.type,
+                              static_cast<int64_t>(output_tensor.bytes)};
+    key = xnnpack::UnpackedWeightsCache::Hash(fields, sizeof(fields), key);
+  }
+  return key;
+}
+
 TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   // Clear previous data, in case the delegate is reused without re-creation.
   static_unpacked_data_map_.clear();
   static_unpacked_data_.clear();
+  unpacked_weights_cache_.reset();
   static_unpack_nodes_.clear();
   static_sparse_weights_.clear();
   variable_holder_.ClearTensorIdToGlobalId();
@@ -6559,6 +6628,41 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
                      quasi_static_tensors_producers[t2];
             });
 
+  // Map the unpacked data from the cache if a previous run saved it.
+  uint64_t unpacked_weights_key = 0;
+  const bool use_unpacked_weights_cache =
+      !unpacked_weights_cache_dir_.empty() &&
+      !unpacked_weights_cache_model_token_.empty() &&
+      !sorted_quasi_static_tensors_to_unpack.empty();
+  if (use_unpacked_weights_cache) {
+    unpacked_weights_key =
+        UnpackedWeightsKey(context, sorted_quasi_static_tensors_to_unpack,
+                           quasi_static_tensors_producers);
+    unpacked_weights_cache_ = xnnpack::UnpackedWeightsCache::Load(
+        xnnpack::UnpackedWeightsCache::GetPath(unpacked_weights_cache_dir_,
+                                               unpacked_weights_key),
+        unpacked_weights_key);
+    if (unpacked_weights_cache_ != nullptr) {
+      const auto& offsets = unpacked_weights_cache_->offsets();
+      bool valid =
+          offsets.size() == sorted_quasi_static_tensors_to_unpack.size();
+      for (int t : sorted_quasi_static_tensors_to_unpack) {
+        const auto it = offsets.find(t);
+        valid = valid && it != offsets.end() &&
+                it->second <= unpacked_weights_cache_->size() &&
+                context->tensors[t].bytes <=
+                    unpacked_weights_cache_->size() - it->second;
+      }
+      if (valid) {
+        static_unpacked_data_map_ = offsets;
+        // Nothing left to unpack.
+        sorted_quasi_static_tensors_to_unpack.clear();
+      } else {
+        unpacked_weights_cache_.reset();
+      }
+    }
+  }
+
   // Unpack static data of all tensors
   for (int t : sorted_quasi_static_tensors_to_unpack) {
     const int producer_index = quasi_static_tensors_producers[t];
@@ -6752,6 +6856,17 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     static_unpacked_data_map_[t] = tensor_offset;
   }
 
+  if (use_unpacked_weights_cache && unpacked_weights_cache_ == nullptr &&
+      !xnnpack::UnpackedWeightsCache::Save(
+          xnnpack::UnpackedWeightsCache::GetPath(unpacked_weights_cache_dir_,
+                                                 unpacked_weights_key),
+          unpacked_weights_key, static_unpacked_data_map_,
+          static_unpacked_data_)) {
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                    "Failed to save the XNNPACK unpacked weights cache in %s.",
+                    unpacked_weights_cache_dir_.c_str());
+  }
+
   // Add nodes that unpack static data consumed by delegated nodes.
   // Note: this is done purely to avoid the overhead of running these nodes
   // again in TFLite interpreter which would allocate memory for their outputs.
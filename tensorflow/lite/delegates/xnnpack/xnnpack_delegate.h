@@ -66,6 +66,21 @@ typedef struct {
   bool handle_variable_ops;
   // Enable adaptive optimization for AVX CPUs.
   bool experimental_adaptive_avx_optimization;
+  // Directory of the files caching the static weights which the delegate
+  // unpacks, e.g. FP16 weights dequantized to FP32. When set together with
+  // `experimental_unpacked_weights_cache_model_token`, the unpacked weights
+  // are written to a file on the first run and memory-mapped read-only by the
+  // next ones, which skip the unpacking and share these weights between
+  // processes. The files are keyed by the model token, the unpacking nodes and
+  // the version of TensorFlow Lite. The weights packed by XNNPACK itself are
+  // not cached on disk, so XNNPACK still packs them on every start.
+  const char* experimental_unpacked_weights_cache_dir;
+  // Identity of the model file for the unpacked weights cache, e.g. its path,
+  // size and modification time (see
+  // xnnpack::UnpackedWeightsCache::GetModelFileToken()), or a hash stored
+  // alongside the model. It must change whenever the weights of the model
+  // change, as the weights themselves are not hashed.
+  const char* experimental_unpacked_weights_cache_model_token;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns a structure with the default XNNPack delegate options.
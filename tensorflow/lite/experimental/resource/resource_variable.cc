@@ -15,15 +15,29 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/resource/resource_variable.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/lite/core/c/c_api_types.h"
 
 namespace tflite {
 namespace resource {
+namespace {
+
+// Returns the size of the buffer to allocate for `bytes` bytes of data.
+size_t GetCapacity(size_t bytes) {
+  constexpr size_t kBlockBytes = ResourceVariable::kBlockBytes;
+  if (bytes <= kBlockBytes) return bytes;
+  return (bytes + kBlockBytes - 1) / kBlockBytes * kBlockBytes;
+}
+
+}  // namespace
 
 ResourceVariable::ResourceVariable() {
   memset(&tensor_, 0, sizeof(TfLiteTensor));
@@ -31,9 +45,11 @@ ResourceVariable::ResourceVariable() {
 
 ResourceVariable::ResourceVariable(ResourceVariable&& other) {
   tensor_ = other.tensor_;
+  capacity_ = other.capacity_;
   is_initialized_ = other.is_initialized_;
 
   memset(&other.tensor_, 0, sizeof(TfLiteTensor));
+  other.capacity_ = 0;
   other.is_initialized_ = false;
 }
 
@@ -49,7 +65,6 @@ ResourceVariable::~ResourceVariable() {
 TfLiteStatus ResourceVariable::AssignFrom(const TfLiteTensor* tensor) {
   // Save the old allocated resources and attributes that we might use.
   char* old_raw = tensor_.data.raw;
-  size_t old_bytes = tensor_.bytes;
   TfLiteIntArray* old_dims = tensor_.dims;
 
   // Copy primitive parameters.
@@ -68,13 +83,17 @@ TfLiteStatus ResourceVariable::AssignFrom(const TfLiteTensor* tensor) {
     tensor_.dims = TfLiteIntArrayCopy(tensor->dims);
   }
 
-  // Reuse the same buffer if possible otherwise allocate a new one.
+  // Reuse the same buffer if it's large enough, otherwise allocate a new one.
+  // The old contents are overwritten, so they don't need to be preserved.
   tensor_.data.raw = old_raw;
-  if (old_bytes != tensor->bytes) {
-    TfLiteTensorRealloc(tensor->bytes, &tensor_);
-  } else {
-    tensor_.bytes = old_bytes;
+  if (old_raw == nullptr || tensor->bytes > capacity_) {
+    tensor_.bytes = capacity_;
+    const size_t capacity = GetCapacity(tensor->bytes);
+    TF_LITE_ENSURE_STATUS(TfLiteTensorResizeMaybeCopy(
+        capacity, &tensor_, /*preserve_data=*/false));
+    capacity_ = capacity;
   }
+  tensor_.bytes = tensor->bytes;
 
   memcpy(tensor_.data.raw, tensor->data.raw, tensor_.bytes);
   is_initialized_ = true;
@@ -82,6 +101,52 @@ TfLiteStatus ResourceVariable::AssignFrom(const TfLiteTensor* tensor) {
   return kTfLiteOk;
 }
 
+TfLiteStatus ResourceVariable::UpdateSlice(const TfLiteTensor* update,
+                                           const int32_t* start_indices) {
+  if (!is_initialized_ || update->type != tensor_.type ||
+      update->type == kTfLiteString ||
+      update->dims->size != tensor_.dims->size) {
+    return kTfLiteError;
+  }
+  const int rank = tensor_.dims->size;
+  size_t num_elements = 1;
+  for (int i = 0; i < rank; ++i) {
+    if (update->dims->data[i] > tensor_.dims->data[i]) return kTfLiteError;
+    num_elements *= update->dims->data[i];
+  }
+  if (num_elements == 0) return kTfLiteOk;
+  if (rank == 0) {
+    memcpy(tensor_.data.raw, update->data.raw, tensor_.bytes);
+    return kTfLiteOk;
+  }
+
+  std::vector<int> start(rank);
+  for (int i = 0; i < rank; ++i) {
+    start[i] = std::min(std::max(0, start_indices[i]),
+                        tensor_.dims->data[i] - update->dims->data[i]);
+  }
+
+  // Copy the update one row of its innermost dimension at a time; `index`
+  // walks over the outer dimensions of the update.
+  const size_t element_bytes = update->bytes / num_elements;
+  const size_t row_bytes = update->dims->data[rank - 1] * element_bytes;
+  const size_t num_rows = num_elements / update->dims->data[rank - 1];
+  std::vector<int> index(rank, 0);
+  for (size_t row = 0; row < num_rows; ++row) {
+    size_t offset = 0;
+    for (int i = 0; i < rank; ++i) {
+      offset = offset * tensor_.dims->data[i] + start[i] + index[i];
+    }
+    memcpy(tensor_.data.raw + offset * element_bytes,
+           update->data.raw + row * row_bytes, row_bytes);
+    for (int i = rank - 2; i >= 0; --i) {
+      if (++index[i] < update->dims->data[i]) break;
+      index[i] = 0;
+    }
+  }
+  return kTfLiteOk;
+}
+
 void CreateResourceVariableIfNotAvailable(ResourceMap* resources,
                                           int resource_id) {
   if (resources->count(resource_id) != 0) {
@@ -15,6 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_RESOURCE_VARIABLE_H_
 #define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_RESOURCE_VARIABLE_H_
 
+#include <cstddef>
+#include <cstdint>
+
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
 
@@ -35,9 +38,22 @@ class ResourceVariable : public ResourceBase {
 
   ~ResourceVariable() override;
 
+  // Buffers larger than this are allocated in multiples of it, so that a
+  // variable which grows a little on every assignment (e.g. a cache extended
+  // by one row per decoding step) is only reallocated once per block.
+  static constexpr size_t kBlockBytes = 64 * 1024;
+
   // Assigns data from a tensor. Copies its type, shape and data over.
   TfLiteStatus AssignFrom(const TfLiteTensor* tensor);
 
+  // Overwrites the slice of the variable starting at `start_indices` with
+  // `update`, in place. Follows the semantics of DYNAMIC_UPDATE_SLICE: the
+  // start indices are clamped so that the update fits in the variable.
+  // `update` must have the same type and rank as the variable, and
+  // `start_indices` one entry per dimension.
+  TfLiteStatus UpdateSlice(const TfLiteTensor* update,
+                           const int32_t* start_indices);
+
   // Get the data tensor stored in the resource variable.
   // Returns `nullptr` if the variable is never initialized by calling
   // `AssignFrom`.
@@ -46,14 +62,14 @@ class ResourceVariable : public ResourceBase {
   // Returns true if this resource variable is initialized.
   bool IsInitialized() override { return is_initialized_; }
 
-  size_t GetMemoryUsage() override {
-    return is_initialized_ ? tensor_.bytes : 0;
-  }
+  size_t GetMemoryUsage() override { return is_initialized_ ? capacity_ : 0; }
 
  private:
   // The tensor (and its buffer stored in `tensor_.data` is fully owned by
   // the `ResourceVariable` object.
   TfLiteTensor tensor_;
+  // Size of the buffer in `tensor_.data`, which may exceed `tensor_.bytes`.
+  size_t capacity_ = 0;
   // True if `AssignFrom` function is every called.
   // False if and only if `tensor_` is filled with zeros.
   bool is_initialized_ = false;
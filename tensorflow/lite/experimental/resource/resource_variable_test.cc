@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/experimental/resource/resource_variable.h"
 
+#include <cstdint>
 #include <vector>
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
@@ -215,5 +217,89 @@ TEST(ResourceTest, GetMemoryUsage) {
   TfLiteTensorFree(&tensor);
 }
 
+TEST(ResourceTest, UpdateSlice) {
+  ResourceVariable var;
+  TfLiteTensor update;
+  std::vector<int> update_shape = {1, 2};
+  InitTensor(update_shape, kTfLiteDynamic, 1.0f, &update);
+  const int32_t start_indices[] = {1, 1};
+
+  // Uninitialized variables can't be updated.
+  EXPECT_EQ(kTfLiteError, var.UpdateSlice(&update, start_indices));
+
+  TfLiteTensor tensor;
+  std::vector<int> shape = {3, 4};
+  InitTensor(shape, kTfLiteDynamic, 0.0f, &tensor);
+  EXPECT_EQ(kTfLiteOk, var.AssignFrom(&tensor));
+  auto* value = var.GetTensor();
+  float* data = value->data.f;
+
+  EXPECT_EQ(kTfLiteOk, var.UpdateSlice(&update, start_indices));
+  // The update is written in place.
+  EXPECT_EQ(data, var.GetTensor()->data.f);
+  ASSERT_THAT(value, DimsAre({3, 4}));
+  EXPECT_THAT(std::vector<float>(data, data + 12),
+              testing::ElementsAreArray(
+                  {0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0}));
+
+  // Start indices are clamped so that the update fits.
+  update.data.f[0] = 2.0f;
+  update.data.f[1] = 3.0f;
+  const int32_t out_of_bounds_indices[] = {5, 3};
+  EXPECT_EQ(kTfLiteOk, var.UpdateSlice(&update, out_of_bounds_indices));
+  EXPECT_THAT(std::vector<float>(data, data + 12),
+              testing::ElementsAreArray(
+                  {0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 2, 3}));
+
+  // Updates of a different rank are rejected.
+  TfLiteTensor flat_update;
+  std::vector<int> flat_shape = {2};
+  InitTensor(flat_shape, kTfLiteDynamic, 1.0f, &flat_update);
+  EXPECT_EQ(kTfLiteError, var.UpdateSlice(&flat_update, start_indices));
+
+  // Cleanup
+  TfLiteTensorFree(&tensor);
+  TfLiteTensorFree(&update);
+  TfLiteTensorFree(&flat_update);
+}
+
+TEST(ResourceTest, LargeVariableGrowsInBlocks) {
+  ResourceVariable var;
+  const int block_elements = ResourceVariable::kBlockBytes / sizeof(float);
+
+  TfLiteTensor tensor_a, tensor_b, tensor_c;
+  std::vector<int> shape_a = {block_elements + 1};
+  std::vector<int> shape_b = {block_elements + 2};
+  std::vector<int> shape_c = {2 * block_elements + 1};
+  InitTensor(shape_a, kTfLiteDynamic, 1.0f, &tensor_a);
+  InitTensor(shape_b, kTfLiteDynamic, 2.0f, &tensor_b);
+  InitTensor(shape_c, kTfLiteDynamic, 3.0f, &tensor_c);
+
+  EXPECT_EQ(kTfLiteOk, var.AssignFrom(&tensor_a));
+  EXPECT_EQ(2 * ResourceVariable::kBlockBytes, var.GetMemoryUsage());
+  const char* buffer = var.GetTensor()->data.raw;
+
+  // Growing within the allocated blocks reuses the buffer.
+  EXPECT_EQ(kTfLiteOk, var.AssignFrom(&tensor_b));
+  auto* value = var.GetTensor();
+  EXPECT_EQ(buffer, value->data.raw);
+  EXPECT_EQ((block_elements + 2) * sizeof(float), value->bytes);
+  ASSERT_THAT(value, DimsAre({block_elements + 2}));
+  EXPECT_EQ(2.0f, value->data.f[block_elements + 1]);
+  EXPECT_EQ(2 * ResourceVariable::kBlockBytes, var.GetMemoryUsage());
+
+  // Growing past them allocates more.
+  EXPECT_EQ(kTfLiteOk, var.AssignFrom(&tensor_c));
+  value = var.GetTensor();
+  ASSERT_THAT(value, DimsAre({2 * block_elements + 1}));
+  EXPECT_EQ(3.0f, value->data.f[2 * block_elements]);
+  EXPECT_EQ(3 * ResourceVariable::kBlockBytes, var.GetMemoryUsage());
+
+  // Cleanup
+  TfLiteTensorFree(&tensor_a);
+  TfLiteTensorFree(&tensor_b);
+  TfLiteTensorFree(&tensor_c);
+}
+
 }  // namespace resource
 }  // namespace tflite
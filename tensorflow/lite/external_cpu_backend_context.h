@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXTERNAL_CPU_BACKEND_CONTEXT_H_
 #define TENSORFLOW_LITE_EXTERNAL_CPU_BACKEND_CONTEXT_H_
 
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -38,6 +39,16 @@ class TfLiteInternalBackendContext {
   // A context may internally cache prepacked versions of constant tensors for
   // faster computation. This function will clear any caches on the context.
   virtual void ClearCaches() = 0;
+
+  // Runs `task(i)` for each `i` in [0, num_tasks), possibly concurrently on
+  // the threads of this context, and returns once they are all done. Each
+  // concurrent task sees its own single-threaded backend context, so that the
+  // tasks may run TF Lite kernels. This implementation runs the tasks one
+  // after another.
+  virtual void RunConcurrently(int num_tasks,
+                               const std::function<void(int)>& task) {
+    for (int i = 0; i < num_tasks; ++i) task(i);
+  }
 };
 
 // This TfLiteExternalContext-derived class is the default
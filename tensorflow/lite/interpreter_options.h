@@ -21,6 +21,18 @@ limitations under the License.
 
 namespace tflite {
 
+/// Algorithms the memory planner can use to assign arena offsets to tensors.
+/// WARNING: This is an experimental API and subject to change.
+enum class ArenaPlanningAlgorithm {
+  /// Tensors are placed from largest to smallest, each one in the best-fitting
+  /// gap left by the tensors before it.
+  kGreedyBySize = 0,
+  /// Several placement orders are tried, and refined by a local search bounded
+  /// by a time budget. The one yielding the smallest arena is kept. Planning
+  /// takes longer, but the arena is never larger than with `kGreedyBySize`.
+  kBestFitSearch = 1,
+};
+
 /// Options class for `Interpreter`.
 /// WARNING: This is an experimental API and subject to change.
 class InterpreterOptions {
@@ -29,7 +41,14 @@ class InterpreterOptions {
       : experimental_preserve_all_tensors_(false),
         experimental_ensure_dynamic_tensors_are_released_(false),
         experimental_optimize_memory_for_large_tensors_(0),
-        experimental_disable_delegate_clustering_(false) {}
+        experimental_disable_delegate_clustering_(false),
+        experimental_arena_planning_algorithm_(
+            ArenaPlanningAlgorithm::kGreedyBySize),
+        experimental_arena_planning_time_budget_us_(10000),
+        experimental_inter_op_parallelism_(false),
+        experimental_memory_plan_cache_size_(0),
+        experimental_incremental_preparation_(false),
+        experimental_fuse_activations_(false) {}
 
   /// Preserving all intermediates tensors for debugging.
   /// WARNING: This is an experimental API and subject to change.
@@ -93,11 +112,106 @@ class InterpreterOptions {
     experimental_disable_delegate_clustering_ = value;
   }
 
+  /// Selects the algorithm used to assign arena offsets to tensors. The time
+  /// budget (in microseconds) bounds each planning pass of
+  /// `kBestFitSearch`, and is ignored by other algorithms. This has no effect
+  /// when TFLITE_USE_SIMPLE_MEMORY_PLANNER is defined.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetArenaPlanningAlgorithm(ArenaPlanningAlgorithm algorithm,
+                                 int time_budget_us = 10000) {
+    experimental_arena_planning_algorithm_ = algorithm;
+    experimental_arena_planning_time_budget_us_ = time_budget_us;
+  }
+
+  /// Returns the algorithm used to assign arena offsets to tensors.
+  /// WARNING: This is an experimental API and subject to change.
+  ArenaPlanningAlgorithm GetArenaPlanningAlgorithm() {
+    return experimental_arena_planning_algorithm_;
+  }
+
+  /// Returns the time budget (in microseconds) of each planning pass of
+  /// `ArenaPlanningAlgorithm::kBestFitSearch`.
+  /// WARNING: This is an experimental API and subject to change.
+  int GetArenaPlanningTimeBudgetUs() {
+    return experimental_arena_planning_time_budget_us_;
+  }
+
+  /// Runs the nodes of the execution plan which don't depend on each other
+  /// concurrently on the threads of the CPU backend context, i.e. up to the
+  /// number of threads set on the interpreter. Nodes are grouped in stages of
+  /// independent nodes, and the memory planner keeps the tensors of the nodes
+  /// of a stage apart, so the arena may grow. Subgraphs with dynamic tensors
+  /// and nodes with side effects (e.g. delegate kernels, custom ops, control
+  /// flow and resource ops) still run one at a time. This must be set before
+  /// `AllocateTensors`.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetInterOpParallelism(bool value = true) {
+    experimental_inter_op_parallelism_ = value;
+  }
+
+  /// Returns if independent nodes may run concurrently.
+  /// WARNING: This is an experimental API and subject to change.
+  bool GetInterOpParallelism() { return experimental_inter_op_parallelism_; }
+
+  /// Keeps the memory plans made by `AllocateTensors` for up to `num_plans`
+  /// different input shapes, evicting the least recently used one. When the
+  /// inputs are resized back to cached shapes, `AllocateTensors` reuses the
+  /// cached plan instead of planning the arena again. Zero, the default,
+  /// disables the cache.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetMemoryPlanCacheSize(int num_plans) {
+    experimental_memory_plan_cache_size_ = num_plans;
+  }
+
+  /// Returns the number of memory plans kept for different input shapes.
+  /// WARNING: This is an experimental API and subject to change.
+  int GetMemoryPlanCacheSize() { return experimental_memory_plan_cache_size_; }
+
+  /// Makes `AllocateTensors` skip preparing the operators whose input tensors
+  /// kept the same type and shape since they were last prepared, e.g. the
+  /// operators which don't depend on an input resized since. Delegate
+  /// kernels, operators with side effects and operators reading tensors which
+  /// aren't allocated in the arena (e.g. whose values are computed while
+  /// preparing) are always prepared again.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetIncrementalPreparation(bool value = true) {
+    experimental_incremental_preparation_ = value;
+  }
+
+  /// Returns if only the operators whose tensor shapes changed are prepared
+  /// again.
+  /// WARNING: This is an experimental API and subject to change.
+  bool GetIncrementalPreparation() {
+    return experimental_incremental_preparation_;
+  }
+
+  /// Makes `InterpreterBuilder` fuse the RELU, RELU6 and RELU_N1_TO_1
+  /// operators into the builtin operators producing their input which have a
+  /// fused activation function, e.g. ADD, CONV_2D or FULLY_CONNECTED, when
+  /// they are the only consumer of that input. This saves running the
+  /// activations and the arena memory of the tensors in between, which can't
+  /// be read anymore. This has no effect with `SetPreserveAllTensors`.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetFuseActivations(bool value = true) {
+    experimental_fuse_activations_ = value;
+  }
+
+  /// Returns if activations are fused into the operators producing their
+  /// input.
+  /// WARNING: This is an experimental API and subject to change.
+  bool GetFuseActivations() { return experimental_fuse_activations_; }
+
  private:
   bool experimental_preserve_all_tensors_;
   bool experimental_ensure_dynamic_tensors_are_released_;
   int experimental_optimize_memory_for_large_tensors_;
   bool experimental_disable_delegate_clustering_;
+  ArenaPlanningAlgorithm experimental_arena_planning_algorithm_;
+  int experimental_arena_planning_time_budget_us_;
+  bool experimental_inter_op_parallelism_;
+  int experimental_memory_plan_cache_size_;
+  bool experimental_incremental_preparation_;
+  bool experimental_fuse_activations_;
 };
 
 }  // namespace tflite
@@ -0,0 +1,183 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/interpreter_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+namespace {
+
+InterpreterPool::Options Normalize(InterpreterPool::Options options) {
+  options.max_size = std::max(options.max_size, 1);
+  options.initial_size = std::clamp(options.initial_size, 1, options.max_size);
+  return options;
+}
+
+}  // namespace
+
+void InterpreterPool::Releaser::operator()(Interpreter* interpreter) const {
+  if (pool_ != nullptr && interpreter != nullptr) pool_->Release(interpreter);
+}
+
+InterpreterPool::InterpreterPool(const FlatBufferModel& model,
+                                 const OpResolver& op_resolver,
+                                 const Options& options)
+    : model_(model),
+      op_resolver_(op_resolver),
+      options_(Normalize(options)),
+      weights_cache_(options.use_xnnpack
+                         ? TfLiteXNNPackDelegateWeightsCacheCreate()
+                         : nullptr,
+                     TfLiteXNNPackDelegateWeightsCacheDelete) {}
+
+InterpreterPool::~InterpreterPool() = default;
+
+std::unique_ptr<InterpreterPool> InterpreterPool::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const Options& options) {
+  std::unique_ptr<InterpreterPool> pool(
+      new InterpreterPool(model, op_resolver, options));
+  if (options.use_xnnpack && pool->weights_cache_ == nullptr) return nullptr;
+
+  // The first interpreter fills the weights cache and computes the memory
+  // plan, which the other interpreters then reuse.
+  std::unique_ptr<Entry> first = pool->BuildEntry();
+  if (first == nullptr) return nullptr;
+  if (first->interpreter->SerializeMemoryPlan(&pool->memory_plan_) !=
+      kTfLiteOk) {
+    pool->memory_plan_.clear();
+  }
+  if (pool->weights_cache_ != nullptr &&
+      !TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(
+          pool->weights_cache_.get())) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Failed to finalize the weights cache.");
+    return nullptr;
+  }
+  pool->idle_.push_back(first->interpreter.get());
+  pool->entries_.push_back(std::move(first));
+
+  while (static_cast<int>(pool->entries_.size()) <
+         pool->options_.initial_size) {
+    std::unique_ptr<Entry> entry = pool->BuildEntry();
+    if (entry == nullptr) return nullptr;
+    pool->idle_.push_back(entry->interpreter.get());
+    pool->entries_.push_back(std::move(entry));
+  }
+  return pool;
+}
+
+std::unique_ptr<InterpreterPool::Entry> InterpreterPool::BuildEntry() {
+  auto entry = std::make_unique<Entry>();
+  InterpreterBuilder builder(model_, op_resolver_);
+  if (builder(&entry->interpreter, options_.num_threads) != kTfLiteOk) {
+    return nullptr;
+  }
+  Interpreter& interpreter = *entry->interpreter;
+
+  if (weights_cache_ != nullptr) {
+    TfLiteXNNPackDelegateOptions xnnpack_options =
+        TfLiteXNNPackDelegateOptionsDefault();
+    xnnpack_options.num_threads = options_.num_threads;
+    xnnpack_options.weights_cache = weights_cache_.get();
+    entry->delegate = Interpreter::TfLiteDelegatePtr(
+        TfLiteXNNPackDelegateCreate(&xnnpack_options),
+        TfLiteXNNPackDelegateDelete);
+    // Nodes the delegate rejects keep running on the builtin kernels.
+    if (interpreter.ModifyGraphWithDelegate(entry->delegate.get()) ==
+        kTfLiteError) {
+      return nullptr;
+    }
+  }
+
+  const std::vector<int>& inputs = interpreter.inputs();
+  for (size_t i = 0; i < options_.input_shapes.size() && i < inputs.size();
+       ++i) {
+    if (options_.input_shapes[i].empty()) continue;
+    if (interpreter.ResizeInputTensor(inputs[i], options_.input_shapes[i]) !=
+        kTfLiteOk) {
+      return nullptr;
+    }
+  }
+
+  std::string memory_plan;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_plan = memory_plan_;
+  }
+  // The plan only speeds up AllocateTensors(), which plans the allocations
+  // itself if the plan cannot be restored.
+  if (!memory_plan.empty() &&
+      interpreter.RestoreMemoryPlan(memory_plan) != kTfLiteOk) {
+    TFLITE_LOG(TFLITE_LOG_WARNING,
+               "Failed to restore the memory plan of the interpreter pool.");
+  }
+  if (interpreter.AllocateTensors() != kTfLiteOk) return nullptr;
+  return entry;
+}
+
+InterpreterPool::Lease InterpreterPool::Acquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  released_.wait(lock, [this] {
+    return !idle_.empty() ||
+           static_cast<int>(entries_.size()) + num_pending_ <
+               options_.max_size;
+  });
+  if (!idle_.empty()) {
+    Interpreter* interpreter = idle_.back();
+    idle_.pop_back();
+    return Lease(interpreter, Releaser(this));
+  }
+
+  // Building an interpreter takes a while, don't block the other requests.
+  ++num_pending_;
+  lock.unlock();
+  std::unique_ptr<Entry> entry = BuildEntry();
+  lock.lock();
+  --num_pending_;
+  if (entry == nullptr) {
+    // Let another waiting request try to build the interpreter.
+    released_.notify_one();
+    return Lease(nullptr, Releaser(this));
+  }
+  Interpreter* interpreter = entry->interpreter.get();
+  entries_.push_back(std::move(entry));
+  return Lease(interpreter, Releaser(this));
+}
+
+int InterpreterPool::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void InterpreterPool::Release(Interpreter* interpreter) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(interpreter);
+  }
+  released_.notify_one();
+}
+
+}  // namespace tflite
@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+///
+/// A pool of interpreters serving concurrent requests to a single model.
+#ifndef TENSORFLOW_LITE_INTERPRETER_POOL_H_
+#define TENSORFLOW_LITE_INTERPRETER_POOL_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/model_builder.h"
+
+struct TfLiteXNNPackDelegateWeightsCache;
+
+namespace tflite {
+
+/// Runs one model for many concurrent requests.
+///
+/// Each request needs an interpreter of its own, since an interpreter holds
+/// the activations of the inference in flight. The pool builds these
+/// interpreters on demand and hands them out to one request at a time, while
+/// everything that does not depend on the request is shared between them:
+///
+/// - the model, whose read-only tensors point into the FlatBufferModel
+///   buffer instead of being copied,
+/// - the weights packed by the XNNPACK delegate, through a single
+///   `TfLiteXNNPackDelegateWeightsCache`,
+/// - the arena offsets, which are chosen by the first interpreter and
+///   restored by the next ones (see Interpreter::RestoreMemoryPlan()).
+///
+/// Operator state is not shared: each interpreter initializes and prepares
+/// every operator itself, and keeps its own operator data, including the
+/// weights that builtin kernels outside of XNNPACK pack or transform for
+/// themselves. So each additional interpreter costs its activation arena, its
+/// operator state and the time of preparing the model.
+///
+/// Example:
+///
+///   auto pool = InterpreterPool::Create(*model, resolver, options);
+///   ...
+///   // On each request, from any thread:
+///   InterpreterPool::Lease interpreter = pool->Acquire();
+///   if (interpreter == nullptr) return error;
+///   FillInputs(interpreter.get());
+///   interpreter->Invoke();
+///   // The interpreter goes back to the pool when `interpreter` is destroyed.
+///
+/// This class is thread-safe.
+class InterpreterPool {
+ public:
+  struct Options {
+    /// Maximum number of interpreters, i.e. of requests served concurrently.
+    /// Once all of them are in use, Acquire() waits for one to be released.
+    int max_size = 1;
+    /// Number of interpreters built by Create(). The others are built by
+    /// Acquire() when all the existing ones are in use.
+    int initial_size = 1;
+    /// Number of threads used by each interpreter.
+    int num_threads = 1;
+    /// Whether to apply the XNNPACK delegate with a weights cache shared by
+    /// all interpreters. The op resolver should then not provide default
+    /// delegates, e.g. be a BuiltinOpResolverWithoutDefaultDelegates, as
+    /// those would not share their packed weights.
+    bool use_xnnpack = true;
+    /// Shapes of the model inputs, in the order of `Interpreter::inputs()`.
+    /// Inputs with no shape keep the one of the model.
+    std::vector<std::vector<int>> input_shapes;
+  };
+
+  /// Returns the interpreter to the pool on destruction.
+  class Releaser {
+   public:
+    explicit Releaser(InterpreterPool* pool = nullptr) : pool_(pool) {}
+    void operator()(Interpreter* interpreter) const;
+
+   private:
+    InterpreterPool* pool_;
+  };
+  using Lease = std::unique_ptr<Interpreter, Releaser>;
+
+  /// Returns nullptr if the interpreters cannot be built. `model` and
+  /// `op_resolver` must outlive the pool.
+  static std::unique_ptr<InterpreterPool> Create(const FlatBufferModel& model,
+                                                 const OpResolver& op_resolver,
+                                                 const Options& options);
+
+  ~InterpreterPool();
+
+  InterpreterPool(const InterpreterPool&) = delete;
+  InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+  /// Returns an interpreter ready to be invoked, with its tensors allocated.
+  /// Waits if `max_size` interpreters are in use. Returns nullptr if a new
+  /// interpreter is needed but cannot be built. All leases must be released
+  /// before the pool is destroyed.
+  Lease Acquire();
+
+  /// Number of interpreters built so far.
+  int size() const;
+
+ private:
+  // An interpreter and the delegate it uses. The interpreter is declared last
+  // so that it is destroyed before the delegate.
+  struct Entry {
+    Interpreter::TfLiteDelegatePtr delegate{nullptr, [](TfLiteDelegate*) {}};
+    std::unique_ptr<Interpreter> interpreter;
+  };
+
+  InterpreterPool(const FlatBufferModel& model, const OpResolver& op_resolver,
+                  const Options& options);
+
+  // Builds a new interpreter, without holding `mutex_`.
+  std::unique_ptr<Entry> BuildEntry();
+
+  void Release(Interpreter* interpreter);
+
+  const FlatBufferModel& model_;
+  const OpResolver& op_resolver_;
+  const Options options_;
+
+  // Shared by the XNNPACK delegates of all interpreters.
+  std::unique_ptr<TfLiteXNNPackDelegateWeightsCache,
+                  void (*)(TfLiteXNNPackDelegateWeightsCache*)>
+      weights_cache_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  // Memory plan of the first interpreter, restored into the next ones.
+  std::string memory_plan_;
+  std::vector<std::unique_ptr<Entry>> entries_;
+  std::vector<Interpreter*> idle_;
+  // Number of interpreters being built by Acquire().
+  int num_pending_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_INTERPRETER_POOL_H_
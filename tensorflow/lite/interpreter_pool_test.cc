@@ -0,0 +1,119 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/interpreter_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/core/model_builder.h"
+
+namespace tflite {
+namespace {
+
+class InterpreterPoolTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/multi_add.bin");
+    ASSERT_NE(model_, nullptr);
+    options_.use_xnnpack = GetParam();
+
+    std::unique_ptr<Interpreter> interpreter;
+    ASSERT_EQ(InterpreterBuilder(*model_, resolver_)(&interpreter), kTfLiteOk);
+    ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    expected_ = Run(interpreter.get(), 1.0f);
+  }
+
+  // Sets all inputs to `value`, and returns the outputs.
+  static std::vector<float> Run(Interpreter* interpreter, float value) {
+    for (int input : interpreter->inputs()) {
+      TfLiteTensor* tensor = interpreter->tensor(input);
+      for (size_t i = 0; i < tensor->bytes / sizeof(float); ++i) {
+        tensor->data.f[i] = value;
+      }
+    }
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    std::vector<float> outputs;
+    for (int output : interpreter->outputs()) {
+      const TfLiteTensor* tensor = interpreter->tensor(output);
+      outputs.insert(outputs.end(), tensor->data.f,
+                     tensor->data.f + tensor->bytes / sizeof(float));
+    }
+    return outputs;
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver_;
+  InterpreterPool::Options options_;
+  std::vector<float> expected_;
+};
+
+TEST_P(InterpreterPoolTest, BuildsInterpretersOnDemand) {
+  options_.max_size = 2;
+  auto pool = InterpreterPool::Create(*model_, resolver_, options_);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool->size(), 1);
+
+  InterpreterPool::Lease first = pool->Acquire();
+  InterpreterPool::Lease second = pool->Acquire();
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(pool->size(), 2);
+  // The second interpreter reuses the memory plan of the first one.
+  EXPECT_TRUE(second->primary_subgraph().HasRestoredMemoryPlan());
+
+  EXPECT_EQ(Run(first.get(), 1.0f), expected_);
+  EXPECT_EQ(Run(second.get(), 1.0f), expected_);
+
+  // Released interpreters are handed out again.
+  Interpreter* released = first.get();
+  first.reset();
+  InterpreterPool::Lease third = pool->Acquire();
+  EXPECT_EQ(third.get(), released);
+  EXPECT_EQ(pool->size(), 2);
+}
+
+TEST_P(InterpreterPoolTest, ServesConcurrentRequests) {
+  options_.max_size = 3;
+  auto pool = InterpreterPool::Create(*model_, resolver_, options_);
+  ASSERT_NE(pool, nullptr);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 20; ++j) {
+        InterpreterPool::Lease interpreter = pool->Acquire();
+        ASSERT_NE(interpreter, nullptr);
+        EXPECT_EQ(Run(interpreter.get(), 1.0f), expected_);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_LE(pool->size(), 3);
+}
+
+INSTANTIATE_TEST_SUITE_P(InterpreterPoolTest, InterpreterPoolTest,
+                         ::testing::Bool());
+
+}  // namespace
+}  // namespace tflite
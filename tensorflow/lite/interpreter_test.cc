@@ -20,6 +20,7 @@ limitations under the License.
 #include <stdlib.h>
 #include <string.h>
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -754,7 +755,139 @@ TEST(BasicInterpreter, ReleaseNonPersistentMemory) {
   ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
 }
 
-// Forcefully divides tensor allocation in three steps: one before invocation
+// Number of times GetCountingPassthroughOpRegistration() nodes were prepared,
+// by input tensor index.
+std::map<int, int>& NumPreparesByInput() {
+  static auto* num_prepares = new std::map<int, int>();
+  return *num_prepares;
+}
+
+TfLiteRegistration GetCountingPassthroughOpRegistration() {
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    ++NumPreparesByInput()[node->inputs->data[0]];
+    return GetPassthroughOpRegistration().prepare(context, node);
+  };
+  return reg;
+}
+
+TEST(BasicInterpreter, IncrementalPreparation) {
+  Interpreter interpreter;
+  InterpreterOptions options;
+  options.SetIncrementalPreparation();
+  interpreter.ApplyOptions(&options);
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2, 3}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+  TfLiteRegistration reg = GetCountingPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1}, {3}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  NumPreparesByInput().clear();
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(NumPreparesByInput()[0], 1);
+  EXPECT_EQ(NumPreparesByInput()[1], 1);
+
+  // Only the node reading the resized input is prepared again.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {5}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(NumPreparesByInput()[0], 2);
+  EXPECT_EQ(NumPreparesByInput()[1], 1);
+  EXPECT_EQ(interpreter.tensor(2)->bytes, 5 * sizeof(float));
+  EXPECT_EQ(interpreter.tensor(3)->bytes, 3 * sizeof(float));
+
+  for (int i = 0; i < 5; ++i) interpreter.typed_tensor<float>(0)[i] = i;
+  for (int i = 0; i < 3; ++i) interpreter.typed_tensor<float>(1)[i] = -i;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(2)[4], 4);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[2], -2);
+}
+
+TEST(BasicInterpreter, IncrementalPreparationPreparesVariableReaders) {
+  Interpreter interpreter;
+  InterpreterOptions options;
+  options.SetIncrementalPreparation();
+  interpreter.ApplyOptions(&options);
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2, 3}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {3}, quantized,
+                  /*is_variable=*/i == 1),
+              kTfLiteOk);
+  }
+  TfLiteRegistration reg = GetCountingPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1}, {3}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  NumPreparesByInput().clear();
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // The value of the variable may have changed since it was last prepared,
+  // so the node reading it is prepared again.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {5}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(NumPreparesByInput()[0], 2);
+  EXPECT_EQ(NumPreparesByInput()[1], 2);
+}
+
+TEST(BasicInterpreter, MemoryPlanCache) {
+  Interpreter interpreter;
+  InterpreterOptions options;
+  options.SetMemoryPlanCacheSize(2);
+  interpreter.ApplyOptions(&options);
+  ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({1}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+
+  auto allocate_for_shape = [&interpreter](int size) {
+    return interpreter.ResizeInputTensor(0, {size}) == kTfLiteOk &&
+           interpreter.AllocateTensors() == kTfLiteOk;
+  };
+  ASSERT_TRUE(allocate_for_shape(3));
+  EXPECT_FALSE(interpreter.subgraph(0)->HasRestoredMemoryPlan());
+  ASSERT_TRUE(allocate_for_shape(5));
+  EXPECT_FALSE(interpreter.subgraph(0)->HasRestoredMemoryPlan());
+  ASSERT_TRUE(allocate_for_shape(3));
+  EXPECT_TRUE(interpreter.subgraph(0)->HasRestoredMemoryPlan());
+  EXPECT_EQ(interpreter.tensor(1)->bytes, 3 * sizeof(float));
+  // Evicts the plan for 5, which is the least recently used.
+  ASSERT_TRUE(allocate_for_shape(7));
+  EXPECT_FALSE(interpreter.subgraph(0)->HasRestoredMemoryPlan());
+  ASSERT_TRUE(allocate_for_shape(3));
+  EXPECT_TRUE(interpreter.subgraph(0)->HasRestoredMemoryPlan());
+  ASSERT_TRUE(allocate_for_shape(5));
+  EXPECT_FALSE(interpreter.subgraph(0)->HasRestoredMemoryPlan());
+
+  for (int i = 0; i < 5; ++i) interpreter.typed_tensor<float>(0)[i] = i;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(1)[4], 4);
+}
+
 // and two more at invocation time. This happens because we use string tensors
 // and their sizes can't be determined until invocation time.
 TEST(BasicInterpreter, ThreeStepAllocate) {
@@ -1261,6 +1394,75 @@ TEST_F(InterpreterTest, ExternalBackendContextClearsCachesOnDelete) {
   EXPECT_EQ(cpu_backend_context->num_calls, 1);
 }
 
+// Runs each task on its own thread.
+struct ThreadedBackendContext : public TfLiteInternalBackendContext {
+  void ClearCaches() override {}
+  void SetMaxNumThreads(int num_threads) override {}
+  void RunConcurrently(int num_tasks,
+                       const std::function<void(int)>& task) override {
+    ++num_calls;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_tasks; ++i) threads.emplace_back(task, i);
+    for (std::thread& thread : threads) thread.join();
+  }
+  int num_calls = 0;
+};
+
+TEST(InterpreterInterOpParallelismTest, RunsIndependentNodesConcurrently) {
+  ExternalCpuBackendContext external_cpu_context;
+  ThreadedBackendContext* backend_context = new ThreadedBackendContext();
+  external_cpu_context.set_internal_backend_context(
+      std::unique_ptr<TfLiteInternalBackendContext>(backend_context));
+
+  Interpreter interpreter;
+  interpreter.SetExternalContext(kTfLiteCpuBackendContext,
+                                 &external_cpu_context);
+  ASSERT_EQ(interpreter.SetNumThreads(2), kTfLiteOk);
+  InterpreterOptions options;
+  options.SetInterOpParallelism();
+  interpreter.ApplyOptions(&options);
+
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  interpreter.SetInputs({0});
+  interpreter.SetOutputs({4});
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {3},
+                                             quant);
+  }
+  TfLiteRegistration* add_op = ops::builtin::Register_ADD();
+  TfLiteRegistration* neg_op = ops::builtin::Register_NEG();
+  auto add_params = [] {
+    TfLiteAddParams* params =
+        reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+    params->activation = kTfLiteActNone;
+    return params;
+  };
+  // 4 = neg(0 + 0) + neg(0), where both negations are independent.
+  interpreter.AddNodeWithParameters({0, 0}, {1}, nullptr, 0, add_params(),
+                                    add_op);
+  interpreter.AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr, neg_op);
+  interpreter.AddNodeWithParameters({0}, {3}, nullptr, 0, nullptr, neg_op);
+  interpreter.AddNodeWithParameters({2, 3}, {4}, nullptr, 0, add_params(),
+                                    add_op);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // The first negation moves to the stage of the first addition.
+  EXPECT_THAT(interpreter.execution_plan(), ElementsAre(0, 2, 1, 3));
+  // The outputs of the two nodes of the first stage don't overlap.
+  const TfLiteTensor* first = interpreter.tensor(1);
+  const TfLiteTensor* second = interpreter.tensor(3);
+  EXPECT_TRUE(first->data.raw + first->bytes <= second->data.raw ||
+              second->data.raw + second->bytes <= first->data.raw);
+
+  for (int i = 0; i < 3; ++i) interpreter.typed_tensor<float>(0)[i] = i;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(backend_context->num_calls, 1);
+  EXPECT_THAT(std::vector<float>(interpreter.typed_tensor<float>(4),
+                                 interpreter.typed_tensor<float>(4) + 3),
+              ElementsAre(0, -3, -6));
+}
+
 // Test fixture that allows playing with execution plans. It creates a two
 // node graph that can be executed in either [0,1] order or [1,0] order.
 // The CopyOp records when it is invoked in the class member run_order_
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/resource/resource_variable.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/variable_update_util.h"
 
 namespace tflite {
 namespace ops {
@@ -29,6 +30,20 @@ namespace assign_variable {
 constexpr int kInputVariableId = 0;
 constexpr int kInputValue = 1;
 
+struct OpData {
+  // True if the value is written to the variable in place by the
+  // DYNAMIC_UPDATE_SLICE producing it. See variable_update_util.h.
+  bool assigned_in_place = false;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  return new OpData;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 0);
@@ -40,6 +55,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                            input_resource_id_tensor->type == kTfLiteInt32));
   TF_LITE_ENSURE_EQ(context, NumElements(input_resource_id_tensor), 1);
 
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  op_data->assigned_in_place = IsVariableAssignedInPlace(
+      reinterpret_cast<Subgraph*>(context->impl_), node);
+
   return kTfLiteOk;
 }
 
@@ -58,6 +77,12 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   resource::CreateResourceVariableIfNotAvailable(&resources, resource_id);
   auto* variable = resource::GetResourceVariable(&resources, resource_id);
   TF_LITE_ENSURE(context, variable != nullptr);
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  if (op_data->assigned_in_place &&
+      CanUpdateVariableInPlace(variable, input_value_tensor)) {
+    // The variable already holds the value.
+    return kTfLiteOk;
+  }
   variable->AssignFrom(input_value_tensor);
 
   return kTfLiteOk;
@@ -66,7 +91,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace assign_variable
 
 TfLiteRegistration* Register_ASSIGN_VARIABLE() {
-  static TfLiteRegistration r = {nullptr, nullptr, assign_variable::Prepare,
+  static TfLiteRegistration r = {assign_variable::Init, assign_variable::Free,
+                                 assign_variable::Prepare,
                                  assign_variable::Eval};
   return &r;
 }
@@ -20,13 +20,18 @@ limitations under the License.
 #include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/batch_matmul.h"
+#include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
+#include "tensorflow/lite/kernels/internal/optimized/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_weights.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -65,6 +70,11 @@ struct OpData {
   int scratch_tensor_index;
   bool rhs_transposed;
   bool compute_row_sums = false;
+  // Constant sparse RHS packed for optimized_sparse.
+  std::unique_ptr<optimized_sparse::SparseWeights<float>> sparse_rhs_float;
+  std::unique_ptr<optimized_sparse::SparseWeights<int8_t>> sparse_rhs_int8;
+  // Constant int4 RHS prepacked for optimized_4bit.
+  std::unique_ptr<optimized_4bit::HybridMatMulData4Bit> hybrid_4bit;
 };
 
 struct OpContext {
@@ -135,9 +145,15 @@ TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
   // is quantized int8.
   bool is_hybrid =
       (op_context->lhs->type == kTfLiteFloat32 && rhs->type == kTfLiteInt8);
+  // An int4 RHS is prepacked once by EvalHybrid4Bit, which keeps its own
+  // buffers, so only the transposed LHS is needed.
+  const bool is_hybrid_4bit =
+      (op_context->lhs->type == kTfLiteFloat32 && rhs->type == kTfLiteInt4);
   if (is_hybrid) {
     node->temporaries = TfLiteIntArrayCreate(kNumTempTensorsForAdjoints +
                                              kNumTempTensorsForHybrid);
+  } else if (is_hybrid_4bit) {
+    node->temporaries = TfLiteIntArrayCreate(1);
   } else {
     node->temporaries = TfLiteIntArrayCreate(kNumTempTensorsForAdjoints);
   }
@@ -170,6 +186,9 @@ TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
     TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, scratch_buffer,
                                                      scratch_buffer_size));
   }
+  if (is_hybrid_4bit) {
+    return kTfLiteOk;
+  }
 
   // We need a temp buffer for the RHS if we need to transpose the RHS. We
   // transpose by default, so that the two inputs (LHS and RHS) are in a proper
@@ -291,6 +310,35 @@ TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+// Checks that an int4 RHS is supported by EvalHybrid4Bit: constant, with
+// leading dimensions of 1, an even accumulation depth so that its rows are
+// byte aligned, and per-tensor or per-output-column scales.
+TfLiteStatus CheckHybrid4BitRhs(TfLiteContext* context,
+                                const TfLiteTensor* rhs, bool adj_y,
+                                int rhs_rank) {
+  TF_LITE_ENSURE_MSG(context, IsConstantTensor(rhs),
+                     "An int4 RHS of BatchMatMul must be constant.");
+  for (int i = 0; i < rhs_rank - 2; ++i) {
+    TF_LITE_ENSURE_EQ(context, rhs->dims->data[i], 1);
+  }
+  const int units_dim = adj_y ? rhs_rank - 2 : rhs_rank - 1;
+  const int accum_dim = adj_y ? rhs_rank - 1 : rhs_rank - 2;
+  TF_LITE_ENSURE_EQ(context, rhs->dims->data[accum_dim] % 2, 0);
+  TF_LITE_ENSURE_EQ(context, rhs->quantization.type,
+                    kTfLiteAffineQuantization);
+  const auto* affine_quantization =
+      reinterpret_cast<TfLiteAffineQuantization*>(rhs->quantization.params);
+  TF_LITE_ENSURE(context, affine_quantization);
+  TF_LITE_ENSURE(context, affine_quantization->scale);
+  if (affine_quantization->scale->size > 1) {
+    TF_LITE_ENSURE_EQ(context, affine_quantization->quantized_dimension,
+                      units_dim);
+    TF_LITE_ENSURE_EQ(context, affine_quantization->scale->size,
+                      rhs->dims->data[units_dim]);
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -345,11 +393,13 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                               lhs_data->type == kTfLiteInt16);
   TF_LITE_ENSURE(context, rhs_data->type == kTfLiteFloat32 ||
                               rhs_data->type == kTfLiteInt8 ||
-                              rhs_data->type == kTfLiteInt16);
-  // Either we have a hybrid quantization with a float32 and an int8 input,
-  // otherwise both inputs should be of the same type.
+                              rhs_data->type == kTfLiteInt16 ||
+                              rhs_data->type == kTfLiteInt4);
+  // Either we have a hybrid quantization with a float32 and an int8 or int4
+  // input, otherwise both inputs should be of the same type.
   TF_LITE_ENSURE(context, (lhs_data->type == kTfLiteFloat32 &&
-                           rhs_data->type == kTfLiteInt8) ||
+                           (rhs_data->type == kTfLiteInt8 ||
+                            rhs_data->type == kTfLiteInt4)) ||
                               lhs_data->type == rhs_data->type);
   // Support dimensions between 2 and 5, inclusive.
   TF_LITE_ENSURE(context, NumDimensions(lhs_data) >= 2);
@@ -382,6 +432,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                             : extended_rhs_shape.Dims(output_rank - 2);
 
   TF_LITE_ENSURE_EQ(context, accum_dim_lhs, accum_dim_rhs);
+  if (rhs_data->type == kTfLiteInt4) {
+    TF_LITE_ENSURE_OK(context,
+                      CheckHybrid4BitRhs(context, rhs_data, adj_y, rhs_rank));
+  }
   TfLiteStatus status =
       ResizeOutputTensor(context, extended_lhs_shape, extended_rhs_shape, adj_x,
                          adj_y, output_rank, output);
@@ -693,6 +747,164 @@ TfLiteTensor* GetTempLhs(TfLiteContext* context, TfLiteNode* node,
   return transposed_lhs;
 }
 
+// Packs the constant sparse `rhs` on first use, and again when `batch_size`
+// changes which of the sparse and dense kernels are faster.
+template <typename T>
+TfLiteStatus PrepareSparseRhs(
+    TfLiteContext* context, const TfLiteTensor* rhs, bool adj_y, int batch_size,
+    std::unique_ptr<optimized_sparse::SparseWeights<T>>* rhs_weights) {
+  if (*rhs_weights &&
+      !optimized_sparse::NeedsRepacking(**rhs_weights, batch_size)) {
+    return kTfLiteOk;
+  }
+  if (!*rhs_weights) {
+    *rhs_weights = std::make_unique<optimized_sparse::SparseWeights<T>>();
+  }
+  // The output columns are the rows of the weights, as in FullyConnected.
+  const int rows = rhs->dims->data[adj_y ? 0 : 1];
+  const int cols = rhs->dims->data[adj_y ? 1 : 0];
+  return optimized_sparse::PackSparseWeights(
+      *rhs->sparsity, rows, cols, /*transposed=*/!adj_y,
+      GetTensorData<T>(rhs), batch_size, rhs_weights->get(), context);
+}
+
+// Multiplies by a constant 2D sparse RHS, as a FullyConnected op whose
+// weights are the RHS and whose inputs are the rows of the LHS.
+TfLiteStatus EvalSparseRhs(TfLiteContext* context, OpData* data,
+                           const TfLiteBatchMatMulParams* params,
+                           const TfLiteTensor* lhs, const TfLiteTensor* rhs,
+                           TfLiteTensor* output) {
+  if (!IsConstantTensor(rhs) || NumDimensions(rhs) != 2 || params->adj_x) {
+    TF_LITE_KERNEL_LOG(context,
+                       "A sparse RHS of BatchMatMul must be constant and 2D, "
+                       "without adj_x.");
+    return kTfLiteError;
+  }
+  const int accum_depth = rhs->dims->data[params->adj_y ? 1 : 0];
+  const int batch_size = NumElements(lhs) / accum_depth;
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  FullyConnectedParams op_params;
+  if (lhs->type == kTfLiteFloat32 && rhs->type == kTfLiteFloat32) {
+    TF_LITE_ENSURE_OK(
+        context, PrepareSparseRhs(context, rhs, params->adj_y, batch_size,
+                                  &data->sparse_rhs_float));
+    const auto& weights = *data->sparse_rhs_float;
+    op_params.float_activation_min = std::numeric_limits<float>::lowest();
+    op_params.float_activation_max = std::numeric_limits<float>::max();
+    if (weights.use_dense) {
+      op_params.lhs_cacheable = true;
+      optimized_ops::FullyConnected(
+          op_params, RuntimeShape({batch_size, accum_depth}),
+          GetTensorData<float>(lhs), RuntimeShape({weights.rows, weights.cols}),
+          weights.dense.data(), RuntimeShape(), nullptr,
+          RuntimeShape({batch_size, weights.rows}),
+          GetTensorData<float>(output), cpu_backend_context);
+    } else {
+      optimized_sparse::SparseFullyConnected(
+          weights, op_params, GetTensorData<float>(lhs), batch_size,
+          /*bias_data=*/nullptr, GetTensorData<float>(output),
+          cpu_backend_context);
+    }
+    return kTfLiteOk;
+  }
+  if (lhs->type == kTfLiteInt8 && rhs->type == kTfLiteInt8 &&
+      output->type == kTfLiteInt8) {
+    TF_LITE_ENSURE_EQ(context, rhs->params.zero_point, 0);
+    TF_LITE_ENSURE_OK(
+        context, PrepareSparseRhs(context, rhs, params->adj_y, batch_size,
+                                  &data->sparse_rhs_int8));
+    const auto& weights = *data->sparse_rhs_int8;
+    op_params.input_offset = -lhs->params.zero_point;
+    op_params.output_offset = output->params.zero_point;
+    op_params.output_multiplier = data->output_multiplier;
+    op_params.output_shift = data->output_shift;
+    op_params.quantized_activation_min = data->output_activation_min;
+    op_params.quantized_activation_max = data->output_activation_max;
+    if (weights.use_dense) {
+      op_params.lhs_cacheable = true;
+      optimized_integer_ops::FullyConnected(
+          op_params, RuntimeShape({batch_size, accum_depth}),
+          GetTensorData<int8_t>(lhs),
+          RuntimeShape({weights.rows, weights.cols}), weights.dense.data(),
+          RuntimeShape(), nullptr,
+          RuntimeShape({batch_size, weights.rows}),
+          GetTensorData<int8_t>(output), cpu_backend_context);
+    } else {
+      optimized_sparse::SparseFullyConnected(
+          weights, op_params, /*per_channel_multiplier=*/nullptr,
+          /*per_channel_shift=*/nullptr, GetTensorData<int8_t>(lhs),
+          batch_size, /*bias_data=*/nullptr, GetTensorData<int8_t>(output),
+          cpu_backend_context);
+    }
+    return kTfLiteOk;
+  }
+  TF_LITE_KERNEL_LOG(context,
+                     "A sparse RHS of BatchMatMul is only supported for float "
+                     "and int8 inputs and outputs.");
+  return kTfLiteError;
+}
+
+// Multiplies a float LHS by a constant int4 RHS, as a hybrid FullyConnected
+// op whose weights are the RHS and whose inputs are the rows of the LHS, with
+// the kernels of optimized_4bit. The RHS is transposed to the layout of the
+// weights on first use when adj_y is false.
+TfLiteStatus EvalHybrid4Bit(TfLiteContext* context, TfLiteNode* node,
+                            OpData* data,
+                            const TfLiteBatchMatMulParams* params,
+                            const TfLiteTensor* lhs, const TfLiteTensor* rhs,
+                            TfLiteTensor* output) {
+  const int rhs_rank = NumDimensions(rhs);
+  const int units =
+      rhs->dims->data[params->adj_y ? rhs_rank - 2 : rhs_rank - 1];
+  const int accum_depth =
+      rhs->dims->data[params->adj_y ? rhs_rank - 1 : rhs_rank - 2];
+  const int batch_size = NumElements(lhs) / accum_depth;
+  if (batch_size == 0 || units == 0) {
+    return kTfLiteOk;
+  }
+  if (params->adj_x) {
+    TfLiteTensor* transposed_lhs = GetTemporary(context, node, 0);
+    TF_LITE_ENSURE_OK(context,
+                      TransposeRowsColumns(context, lhs, transposed_lhs));
+    lhs = transposed_lhs;
+  }
+  if (!data->hybrid_4bit) {
+    data->hybrid_4bit =
+        std::make_unique<optimized_4bit::HybridMatMulData4Bit>();
+  }
+  const int8_t* weights = GetTensorData<int8_t>(rhs);
+  std::vector<int8_t> transposed_weights;
+  if (data->hybrid_4bit->needs_prepack && !params->adj_y) {
+    std::vector<int8_t> unpacked(units * accum_depth);
+    std::vector<int8_t> transposed(units * accum_depth);
+    tensor_utils::UnpackDenseInt4IntoInt8(weights, units * accum_depth,
+                                          unpacked.data());
+    for (int d = 0; d < accum_depth; ++d) {
+      for (int u = 0; u < units; ++u) {
+        transposed[u * accum_depth + d] = unpacked[d * units + u];
+      }
+    }
+    transposed_weights.resize((units * accum_depth + 1) / 2);
+    tensor_utils::PackInt8IntoDenseInt4(transposed.data(), units * accum_depth,
+                                        transposed_weights.data());
+    weights = transposed_weights.data();
+  }
+  const bool needs_prepack = data->hybrid_4bit->needs_prepack;
+  const auto* affine_quantization =
+      reinterpret_cast<TfLiteAffineQuantization*>(rhs->quantization.params);
+  optimized_4bit::api::HybridMatMul(
+      data->hybrid_4bit.get(), weights, affine_quantization->scale->data,
+      affine_quantization->scale->size, units, accum_depth,
+      GetTensorData<float>(lhs), batch_size, /*bias=*/nullptr,
+      GetTensorData<float>(output));
+  if (needs_prepack) {
+    // The RHS from the model file is never read again.
+    optimized_4bit::api::PageOut(rhs->data.raw_const, rhs->bytes);
+  }
+  return kTfLiteOk;
+}
+
 // Perform a batch matrix multiply on
 // LHS <..., A, B>  X  RHS<..., B, C>
 // where the leading dimensions of LHS and RHS obey broadcasting rules
@@ -717,6 +929,14 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context,
                     GetOutputSafe(context, node, kOutputTensor, &output));
+  if (rhs->sparsity != nullptr) {
+    return EvalSparseRhs(context, op_data, op_context.params, lhs, rhs,
+                         output);
+  }
+  if (rhs->type == kTfLiteInt4) {
+    return EvalHybrid4Bit(context, node, op_data, op_context.params, lhs, rhs,
+                          output);
+  }
   RuntimeShape orig_lhs_shape = GetTensorShape(lhs);
   RuntimeShape orig_rhs_shape = GetTensorShape(rhs);
 
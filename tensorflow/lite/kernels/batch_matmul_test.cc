@@ -346,6 +346,162 @@ TEST_P(BatchMatMulOpTest, Float32Test_BroadcastFromRHS) {
   EXPECT_THAT(model.GetOutputShape(), ElementsAreArray({3, 1, 4, 2}));
 }
 
+class SparseRHSBatchMatMulOpModel : public SingleOpModel {
+ public:
+  SparseRHSBatchMatMulOpModel(const TensorData& lhs, const TensorData& rhs,
+                              const std::vector<float>& rhs_data,
+                              bool adj_y = false) {
+    lhs_id_ = AddInput(lhs);
+    rhs_id_ = AddConstSparseInput(rhs, rhs_data);
+    output_id_ = AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_BATCH_MATMUL,
+                 BuiltinOptions_BatchMatMulOptions,
+                 CreateBatchMatMulOptions(builder_, /*adj_x=*/false, adj_y)
+                     .Union());
+    BuildInterpreter({GetShape(lhs_id_), GetShape(rhs_id_)});
+  }
+
+  int lhs() const { return lhs_id_; }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_id_); }
+  std::vector<int32_t> GetOutputShape() { return GetTensorShape(output_id_); }
+
+ protected:
+  int lhs_id_;
+  int rhs_id_;
+  int output_id_;
+};
+
+TEST_P(BatchMatMulOpTest, Float32Test_SparseRHS) {
+  TensorData rhs = {TensorType_FLOAT32, {3, 4}};
+  rhs.traversal_order = {0, 1};
+  rhs.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  SparseRHSBatchMatMulOpModel model({TensorType_FLOAT32, {1, 2, 3}}, rhs,
+                                    {0, 8, 0, 10, 11, 0, 0, 0, 0, 0, 17, 18});
+  model.PopulateTensor<float>(model.lhs(), {1, 2, 3, 4, 5, 6});
+  ASSERT_EQ(model.Invoke(), kTfLiteOk);
+  EXPECT_THAT(model.GetOutput(),
+              ElementsAreArray({22., 8., 51., 64., 55., 32., 102., 148.}));
+  EXPECT_THAT(model.GetOutputShape(), ElementsAreArray({1, 2, 4}));
+}
+
+TEST_P(BatchMatMulOpTest, Float32Test_SparseRHSAdjoint) {
+  TensorData rhs = {TensorType_FLOAT32, {4, 3}};
+  rhs.traversal_order = {0, 1};
+  rhs.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  SparseRHSBatchMatMulOpModel model({TensorType_FLOAT32, {1, 2, 3}}, rhs,
+                                    {0, 11, 0, 8, 0, 0, 0, 0, 17, 10, 0, 18},
+                                    /*adj_y=*/true);
+  model.PopulateTensor<float>(model.lhs(), {1, 2, 3, 4, 5, 6});
+  ASSERT_EQ(model.Invoke(), kTfLiteOk);
+  EXPECT_THAT(model.GetOutput(),
+              ElementsAreArray({22., 8., 51., 64., 55., 32., 102., 148.}));
+  EXPECT_THAT(model.GetOutputShape(), ElementsAreArray({1, 2, 4}));
+}
+
+// Float LHS and constant int4 RHS, given as int4 values in [-7, 7] that are
+// packed two per byte.
+class Int4RHSBatchMatMulOpModel : public SingleOpModel {
+ public:
+  Int4RHSBatchMatMulOpModel(const TensorData& lhs, const TensorData& rhs,
+                            const std::vector<int8_t>& rhs_values,
+                            bool adj_x = false, bool adj_y = false) {
+    std::vector<int8_t> packed((rhs_values.size() + 1) / 2);
+    for (size_t i = 0; i < rhs_values.size(); ++i) {
+      const uint8_t value = rhs_values[i] & UINT8_C(15);
+      packed[i / 2] |= (i % 2 == 0) ? value : (value << 4);
+    }
+    lhs_id_ = AddInput(lhs);
+    rhs_id_ = AddConstInput<int8_t>(rhs, packed.data(), packed.size());
+    output_id_ = AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(
+        BuiltinOperator_BATCH_MATMUL, BuiltinOptions_BatchMatMulOptions,
+        CreateBatchMatMulOptions(builder_, adj_x, adj_y).Union());
+    BuildInterpreter({GetShape(lhs_id_), GetShape(rhs_id_)});
+  }
+
+  int lhs() const { return lhs_id_; }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_id_); }
+  std::vector<int32_t> GetOutputShape() { return GetTensorShape(output_id_); }
+
+ protected:
+  int lhs_id_;
+  int rhs_id_;
+  int output_id_;
+};
+
+// Runs a float x int4 BatchMatMul of `batches` rows of `accum_depth` values by
+// `units` columns, and checks it against the float computation. Each row of
+// the LHS reaches 127 in magnitude so that it is quantized exactly.
+void TestInt4RHS(int batches, int accum_depth, int units, bool adj_x,
+                 bool adj_y, const std::vector<float>& scales) {
+  std::vector<int8_t> weights(accum_depth * units);
+  for (int i = 0; i < weights.size(); ++i) {
+    weights[i] = (i * 5 + 3) % 15 - 7;
+  }
+  // weight(d, u) of the [accum_depth, units] RHS, whatever its layout.
+  auto weight = [&](int d, int u) {
+    return adj_y ? weights[u * accum_depth + d] : weights[d * units + u];
+  };
+  std::vector<float> lhs(batches * accum_depth);
+  for (int i = 0; i < lhs.size(); ++i) {
+    lhs[i] = (i % accum_depth == 0) ? 127 : (i * 7 % 41) - 20;
+  }
+  std::vector<float> expected(batches * units);
+  for (int b = 0; b < batches; ++b) {
+    for (int u = 0; u < units; ++u) {
+      const float scale = scales.size() == 1 ? scales[0] : scales[u];
+      for (int d = 0; d < accum_depth; ++d) {
+        expected[b * units + u] +=
+            lhs[b * accum_depth + d] * weight(d, u) * scale;
+      }
+    }
+  }
+  std::vector<float> lhs_values(lhs);
+  std::vector<int> lhs_shape = {1, batches, accum_depth};
+  if (adj_x) {
+    for (int b = 0; b < batches; ++b) {
+      for (int d = 0; d < accum_depth; ++d) {
+        lhs_values[d * batches + b] = lhs[b * accum_depth + d];
+      }
+    }
+    lhs_shape = {1, accum_depth, batches};
+  }
+  TensorData rhs = {TensorType_INT4,
+                    adj_y ? std::vector<int>{1, units, accum_depth}
+                          : std::vector<int>{1, accum_depth, units},
+                    0.0f, 0.0f, scales[0]};
+  if (scales.size() > 1) {
+    rhs.per_channel_quantization = true;
+    rhs.per_channel_quantization_scales = scales;
+    rhs.per_channel_quantization_offsets.assign(scales.size(), 0);
+    rhs.channel_index = adj_y ? 1 : 2;
+  }
+  Int4RHSBatchMatMulOpModel model({TensorType_FLOAT32, lhs_shape}, rhs,
+                                  weights, adj_x, adj_y);
+  model.PopulateTensor<float>(model.lhs(), lhs_values);
+  ASSERT_EQ(model.Invoke(), kTfLiteOk);
+  EXPECT_THAT(model.GetOutput(), ElementsAreArray(ArrayFloatNear(expected)));
+  EXPECT_THAT(model.GetOutputShape(),
+              ElementsAreArray({1, batches, units}));
+}
+
+TEST_P(BatchMatMulOpTest, HybridInt4Test) {
+  TestInt4RHS(/*batches=*/3, /*accum_depth=*/40, /*units=*/6, /*adj_x=*/false,
+              /*adj_y=*/false, /*scales=*/{0.5f});
+}
+
+TEST_P(BatchMatMulOpTest, HybridInt4Test_PerChannel) {
+  TestInt4RHS(/*batches=*/5, /*accum_depth=*/64, /*units=*/8, /*adj_x=*/false,
+              /*adj_y=*/false,
+              /*scales=*/{0.5f, 0.25f, 1.0f, 2.0f, 0.5f, 0.25f, 1.0f, 2.0f});
+}
+
+TEST_P(BatchMatMulOpTest, HybridInt4Test_Adjoints) {
+  TestInt4RHS(/*batches=*/4, /*accum_depth=*/36, /*units=*/5, /*adj_x=*/true,
+              /*adj_y=*/true,
+              /*scales=*/{0.5f, 0.25f, 1.0f, 2.0f, 4.0f});
+}
+
 INSTANTIATE_TEST_SUITE_P(
     BatchMatMulOpTest, BatchMatMulOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
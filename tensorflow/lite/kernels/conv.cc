@@ -37,6 +37,7 @@ limitations under the License.
 #if defined(TFLITE_WITH_MULTITHREADED_EIGEN)
 #include "tensorflow/lite/kernels/internal/optimized/multithreaded_conv.h"
 #endif
+#include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
@@ -118,6 +119,10 @@ struct OpData {
   bool supports_multithreaded_kernel = false;
   bool is_hybrid_per_channel = false;
   bool compute_hybrid_row_sums = true;
+  // Float input with an int4 filter. The filter is prepacked on the first Eval
+  // and run through the 4-bit hybrid kernels.
+  bool is_hybrid_4bit = false;
+  std::unique_ptr<optimized_4bit::HybridMatMulData4Bit> hybrid_4bit;
 
   // Number of convolution groups.
   int32_t groups = 1;
@@ -194,7 +199,7 @@ bool IsIm2ColRequired(const TfLiteTensor* input, TfLiteConvParams* params,
 
   switch (kernel_type) {
     case kReference:
-      if (is_hybrid) {
+      if (is_hybrid || data->is_hybrid_4bit) {
         return true;
       } else {
         return false;
@@ -258,7 +263,8 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(
   // TODO(b/178743262): Consider making this check conditioned on the available
   // memory of the system, rather than coupling to the mobile platform check.
   if (IsMobilePlatform() && !(is_hybrid && !is_per_channel) &&
-      data->need_im2col && im2col_bytes >= kMaxIm2colBufferSizeMobile) {
+      !data->is_hybrid_4bit && data->need_im2col &&
+      im2col_bytes >= kMaxIm2colBufferSizeMobile) {
     data->need_im2col = false;
     data->im2col_oversized = true;
   }
@@ -412,6 +418,31 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
   const bool is_hybrid =
       (input->type == kTfLiteFloat32 &&
        (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8));
+  // The 4-bit path keeps its own quantization buffers, so it only needs the
+  // float im2col temporary.
+  data->is_hybrid_4bit =
+      (input->type == kTfLiteFloat32 && filter->type == kTfLiteInt4);
+  if (data->is_hybrid_4bit) {
+    TF_LITE_ENSURE_MSG(context, IsConstantTensor(filter),
+                       "An int4 filter of Conv2D must be constant.");
+    TF_LITE_ENSURE_EQ(context, data->groups, 1);
+    // Each output channel must start on a byte boundary of the packed filter.
+    const int filter_cols =
+        filter->dims->data[1] * filter->dims->data[2] * filter->dims->data[3];
+    TF_LITE_ENSURE_EQ(context, filter_cols % 2, 0);
+    TF_LITE_ENSURE_EQ(context, filter->quantization.type,
+                      kTfLiteAffineQuantization);
+    const auto* affine_quantization =
+        reinterpret_cast<TfLiteAffineQuantization*>(
+            filter->quantization.params);
+    TF_LITE_ENSURE(context, affine_quantization);
+    TF_LITE_ENSURE(context, affine_quantization->scale);
+    if (affine_quantization->scale->size > 1) {
+      TF_LITE_ENSURE_EQ(context, affine_quantization->quantized_dimension, 0);
+      TF_LITE_ENSURE_EQ(context, affine_quantization->scale->size,
+                        filter->dims->data[0]);
+    }
+  }
 
   if (is_hybrid && filter->type == kTfLiteInt8 &&
       filter->quantization.type == kTfLiteAffineQuantization &&
@@ -437,6 +468,7 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
   data->supports_multithreaded_kernel =
       (kernel_type == kMultithreadOptimized) &&
       (context->recommended_num_threads != 1) && !is_hybrid &&
+      !data->is_hybrid_4bit &&
       (params->dilation_width_factor == 1) &&
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) && !IsDynamicTensor(filter);
@@ -1190,6 +1222,77 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+TfLiteStatus EvalHybrid4Bit(TfLiteContext* context, TfLiteNode* node,
+                            TfLiteConvParams* params, OpData* data,
+                            const TfLiteTensor* input,
+                            const TfLiteTensor* filter,
+                            const TfLiteTensor* bias, TfLiteTensor* im2col,
+                            TfLiteTensor* output) {
+  ConvParams op_params;
+  op_params.padding_type = RuntimePaddingType(params->padding);
+  op_params.padding_values.width = data->padding.width;
+  op_params.padding_values.height = data->padding.height;
+  op_params.stride_width = params->stride_width;
+  op_params.stride_height = params->stride_height;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+
+  // The filter is [out_c, fh, fw, in_c], i.e. a [units, fh * fw * in_c]
+  // matrix, so the convolution is a matmul against the im2col patches.
+  const float* gemm_input = GetTensorData<float>(input);
+  if (im2col != nullptr) {
+    // NB: the float 0.0f value is represented by all zero bytes.
+    const uint8_t float_zero_byte = 0x00;
+    if (params->dilation_width_factor != 1 ||
+        params->dilation_height_factor != 1) {
+      optimized_ops::DilatedIm2col(
+          op_params, float_zero_byte, GetTensorShape(input),
+          GetTensorData<float>(input), GetTensorShape(filter),
+          GetTensorShape(output), GetTensorData<float>(im2col));
+    } else {
+      optimized_ops::Im2col(op_params, SizeOfDimension(filter, 1),
+                            SizeOfDimension(filter, 2), float_zero_byte,
+                            GetTensorShape(input), GetTensorData<float>(input),
+                            GetTensorShape(im2col),
+                            GetTensorData<float>(im2col));
+    }
+    gemm_input = GetTensorData<float>(im2col);
+  }
+
+  const int units = SizeOfDimension(filter, 0);
+  const int cols = NumElements(filter) / units;
+  const int batch_size = NumElements(output) / units;
+  if (batch_size == 0 || units == 0) {
+    return kTfLiteOk;
+  }
+  if (!data->hybrid_4bit) {
+    data->hybrid_4bit =
+        std::make_unique<optimized_4bit::HybridMatMulData4Bit>();
+  }
+  const bool needs_prepack = data->hybrid_4bit->needs_prepack;
+  const auto* affine_quantization =
+      reinterpret_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+  float* output_data = GetTensorData<float>(output);
+  optimized_4bit::api::HybridMatMul(
+      data->hybrid_4bit.get(), GetTensorData<int8_t>(filter),
+      affine_quantization->scale->data, affine_quantization->scale->size,
+      units, cols, gemm_input, batch_size, GetTensorData<float>(bias),
+      output_data);
+  float output_activation_min, output_activation_max;
+  CalculateActivationRange(params->activation, &output_activation_min,
+                           &output_activation_max);
+  const int output_size = batch_size * units;
+  for (int i = 0; i < output_size; ++i) {
+    output_data[i] = ActivationFunctionWithMinMax(
+        output_data[i], output_activation_min, output_activation_max);
+  }
+  if (needs_prepack) {
+    // The filter from the model file is never read again.
+    optimized_4bit::api::PageOut(filter->data.raw_const, filter->bytes);
+  }
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type, TfLiteType input_type>
 TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
@@ -1220,7 +1323,11 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK_EQ(input_type, input->type);
   switch (input_type) {  // Already know in/outtypes are same.
     case kTfLiteFloat32:
-      if (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8) {
+      if (data->is_hybrid_4bit) {
+        TF_LITE_ENSURE_OK(context,
+                          EvalHybrid4Bit(context, node, params, data, input,
+                                         filter, bias, im2col, output));
+      } else if (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8) {
         if (data->is_hybrid_per_channel ||
             // TODO(b/162870360): Fallback to PerChannel implementation
             // before we have grouped hybrid convolution.
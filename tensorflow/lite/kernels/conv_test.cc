@@ -2161,6 +2161,82 @@ TEST_P(ConvolutionOpTest, SimpleTestHybridWithDilationPerChannel) {
                                  0.16)));
 }
 
+class Hybrid4BitConvolutionOpModel : public BaseConvolutionOpModel<int8_t> {
+ public:
+  using BaseConvolutionOpModel::BaseConvolutionOpModel;
+
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+
+  void SetBias(std::initializer_list<float> data) {
+    PopulateTensor(bias_, data);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+};
+
+// [2 * 2 * 2 * 2] as [output_channel, y, x, input_channel], holding
+//   1,  2, 3, 4,  3, 4, 5,  6,  // out channel = 0
+//   7, -7, 5, 6, -3, 4, 1, -2,  // out channel = 1
+// packed two int4 values per byte, low nibble first.
+constexpr std::initializer_list<int8_t> kPackedInt4ConvFilter = {
+    33, 67, 67, 101, -105, 101, 77, -31};
+
+TEST_P(ConvolutionOpTest, SimpleTestHybridInt4PerChannel) {
+  Hybrid4BitConvolutionOpModel m(
+      GetRegistration(), {TensorType_FLOAT32, {1, 2, 3, 2}},
+      {TensorType_INT4,
+       {2, 2, 2, 2},
+       0,
+       0,
+       0,
+       0,
+       /*per_channel_quantization=*/true,
+       /*per_channel_quantization_scales=*/{0.5, 2},
+       /*per_channel_quantization_offsets=*/{0, 0},
+       /*channel_index=*/0},
+      {TensorType_FLOAT32, {}},
+      /*stride_width=*/1, /*stride_height=*/1, Padding_VALID,
+      ActivationFunctionType_NONE, /*dilation_width_factor=*/1,
+      /*dilation_height_factor=*/1, /*num_threads=*/-1,
+      kPackedInt4ConvFilter);
+  m.SetInput({
+      // [1 * 2 * 3 * 2] as [batch, y, x, input_channel]
+      3, 2, 1, -1, -2, -3,  // y = 0
+      4, 3, 2, -2, -3, -4,  // y = 1
+  });
+  m.SetBias({3, -2});
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  // Output has dimension [1 * 1 * 2 * 2] as [batch, y, x, output_channel].
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({17, 22, -27, -48}, 0.5)));
+}
+
+TEST_P(ConvolutionOpTest, SimpleTestHybridInt4WithRelu) {
+  Hybrid4BitConvolutionOpModel m(
+      GetRegistration(), {TensorType_FLOAT32, {1, 2, 3, 2}},
+      {TensorType_INT4, {2, 2, 2, 2}, 0, 0, /*scale=*/2, 0},
+      {TensorType_FLOAT32, {}},
+      /*stride_width=*/1, /*stride_height=*/1, Padding_VALID,
+      ActivationFunctionType_RELU, /*dilation_width_factor=*/1,
+      /*dilation_height_factor=*/1, /*num_threads=*/-1,
+      kPackedInt4ConvFilter);
+  m.SetInput({
+      // [1 * 2 * 3 * 2] as [batch, y, x, input_channel]
+      3, 2, 1, -1, -2, -3,  // y = 0
+      4, 3, 2, -2, -3, -4,  // y = 1
+  });
+  m.SetBias({3, -2});
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({59, 22, 0, 0}, 0.5)));
+}
+
 const auto kQuantizedKernelMap = new std::map<string, TfLiteRegistration*>({
     {"GenericOptimized", ops::builtin::Register_CONV_2D_UINT8()},
 });
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "pthreadpool.h"  // from @pthreadpool
 
@@ -26,6 +28,7 @@ limitations under the License.
 #include "public/gemmlowp.h"
 #include "ruy/context.h"  // from @ruy
 #include "ruy/path.h"  // from @ruy
+#include "ruy/thread_pool.h"  // from @ruy
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
@@ -38,6 +41,32 @@ const int kDefaultNumThreadpoolThreads = 1;
 }  // namespace
 
 namespace tflite {
+namespace {
+
+// The context reserved for the task of RunConcurrently() running on this
+// thread, if any.
+thread_local CpuBackendContext* current_task_context = nullptr;
+
+class ConcurrentTask final : public ruy::Task {
+ public:
+  ConcurrentTask(int index, CpuBackendContext* context,
+                 const std::function<void(int)>* task)
+      : index_(index), context_(context), task_(task) {}
+
+  void Run() override {
+    CpuBackendContext* const previous_context = current_task_context;
+    current_task_context = context_;
+    (*task_)(index_);
+    current_task_context = previous_context;
+  }
+
+ private:
+  const int index_;
+  CpuBackendContext* const context_;
+  const std::function<void(int)>* const task_;
+};
+
+}  // namespace
 
 // Use weak symbols if possible to dispatch to deprecated paths.
 #if TFLITE_HAS_ATTRIBUTE_WEAK && !defined(__APPLE__)
@@ -101,6 +130,10 @@ bool CpuBackendContext::CpuInfo::Avx512() { return false; }
 #endif  // TFLITE_HAVE_CPUINFO
 
 CpuBackendContext* CpuBackendContext::GetFromContext(TfLiteContext* context) {
+  if (current_task_context != nullptr) {
+    return current_task_context;
+  }
+
   auto* external_context = static_cast<ExternalCpuBackendContext*>(
       context->GetExternalContext(context, kTfLiteCpuBackendContext));
 
@@ -149,6 +182,38 @@ void CpuBackendContext::SetMaxNumThreads(int max_num_threads) {
 
 void CpuBackendContext::SetUseCaching(bool flag) { use_caching_ = flag; }
 
+void CpuBackendContext::SetUseX86Int8Kernels(bool flag) {
+  use_x86_int8_kernels_ = flag;
+}
+
+void CpuBackendContext::ClearCaches() {
+  ruy_context_->ClearPrepackedCache();
+  for (auto& task_context : task_contexts_) {
+    task_context->ClearCaches();
+  }
+}
+
+void CpuBackendContext::RunConcurrently(int num_tasks,
+                                        const std::function<void(int)>& task) {
+  if (num_tasks <= 1 || num_tasks > max_num_threads_) {
+    TfLiteInternalBackendContext::RunConcurrently(num_tasks, task);
+    return;
+  }
+  while (task_contexts_.size() < static_cast<size_t>(num_tasks)) {
+    auto task_context = std::make_unique<CpuBackendContext>();
+    task_context->SetMaxNumThreads(1);
+    task_context->SetUseCaching(use_caching_);
+    task_context->SetUseX86Int8Kernels(use_x86_int8_kernels_);
+    task_contexts_.push_back(std::move(task_context));
+  }
+  std::vector<ConcurrentTask> tasks;
+  tasks.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    tasks.emplace_back(i, task_contexts_[i].get(), &task);
+  }
+  ruy_context_->mutable_thread_pool()->Execute(num_tasks, tasks.data());
+}
+
 pthreadpool_t CpuBackendContext::get_xnnpack_threadpool() {
   if (!xnnpack_threadpool_ && max_num_threads_ > 1) {
     xnnpack_threadpool_.reset(
@@ -21,7 +21,9 @@ limitations under the License.
 #define TFLITE_X86_PLATFORM
 #endif
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "public/gemmlowp.h"
 #include "pthreadpool.h"  // from @pthreadpool
@@ -54,9 +56,22 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
 
   bool use_caching() const { return use_caching_; }
 
+  // Lets int8 GEMMs use the AVX-512 VNNI and AMX kernels on CPUs supporting
+  // them (see cpu_backend_gemm_x86_int8.h). Enabled by default.
+  void SetUseX86Int8Kernels(bool flag);
+
+  bool use_x86_int8_kernels() const { return use_x86_int8_kernels_; }
+
   pthreadpool_t get_xnnpack_threadpool();
 
-  void ClearCaches() override { ruy_context_->ClearPrepackedCache(); }
+  void ClearCaches() override;
+
+  // Runs the tasks on the ruy thread pool when there are several of them and
+  // no more than max_num_threads(). While a task runs, GetFromContext()
+  // returns a single-threaded context owned by this one and reserved for the
+  // task, since ruy and gemmlowp contexts can't be used concurrently.
+  void RunConcurrently(int num_tasks,
+                       const std::function<void(int)>& task) override;
 
   // Gemmlowp on x86 is a deprecated path but some clients may still use
   // this path based on link time dependencies.
@@ -118,11 +133,16 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
   // (currently the Ruy library only).
   bool use_caching_;
 
+  bool use_x86_int8_kernels_ = true;
+
   // A smart pointer for the xnnpack threadpool. Is created by a call from the
   // interpreter, and then consumed by xnnpack, possibly via a TFLite kernel.
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)>
       xnnpack_threadpool_{nullptr, &pthreadpool_destroy};
 
+  // Contexts used by the tasks of RunConcurrently(), created on first use.
+  std::vector<std::unique_ptr<CpuBackendContext>> task_contexts_;
+
   CpuBackendContext(const CpuBackendContext&) = delete;
 };
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/cpu_backend_gemm_custom_gemv.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_ruy.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_x86_int8.h"
 
 #ifndef TFLITE_WITH_RUY
 #include "tensorflow/lite/kernels/cpu_backend_gemm_eigen.h"
@@ -154,6 +155,14 @@ void Gemm(const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
                                                        params, context);
     return;
   }
+#ifdef TFLITE_X86_PLATFORM
+  // On CPUs with AVX-512 VNNI or AMX, int8 GEMMs go to dedicated kernels,
+  // selected at runtime regardless of `tflite_with_ruy`.
+  if (detail::X86Int8Gemm(lhs_params, lhs_data, rhs_params, rhs_data,
+                          dst_params, dst_data, params, context)) {
+    return;
+  }
+#endif
   // If we did not choose to force usage of ruy above, then we may now consider
   // using custom GEMV code for the matrix*vector cases.
   const bool try_custom_gemv = (dst_params.cols == 1);
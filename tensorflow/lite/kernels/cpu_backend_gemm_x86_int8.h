@@ -0,0 +1,202 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Int8 GEMM on x86 CPUs with AVX-512 VNNI or AMX, dispatched at runtime to
+// the kernels of optimized_x86_int8. This covers the int8 FullyConnected,
+// Conv and BatchMatMul ops, which all go through cpu_backend_gemm::Gemm.
+
+#ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_X86_INT8_H_
+#define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_X86_INT8_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/optimized/x86_int8_gemm.h"
+
+namespace tflite {
+namespace cpu_backend_gemm {
+namespace detail {
+
+// Runs the x86 int8 kernel on a range of rows.
+template <typename DstScalar>
+class X86Int8GemmTask : public cpu_backend_threadpool::Task {
+ public:
+  X86Int8GemmTask(optimized_x86_int8::Kernel kernel,
+                  const optimized_x86_int8::GemmParams& params,
+                  const int8_t* lhs_data, const int8_t* rhs_data,
+                  const uint8_t* scratch, int row_start, int row_end,
+                  DstScalar* dst_data)
+      : kernel_(kernel),
+        params_(params),
+        lhs_data_(lhs_data),
+        rhs_data_(rhs_data),
+        scratch_(scratch),
+        row_start_(row_start),
+        row_end_(row_end),
+        dst_data_(dst_data) {}
+
+  void Run() override {
+    optimized_x86_int8::Gemm(kernel_, params_, lhs_data_, rhs_data_, scratch_,
+                             row_start_, row_end_, dst_data_);
+  }
+
+ private:
+  optimized_x86_int8::Kernel kernel_;
+  const optimized_x86_int8::GemmParams& params_;
+  const int8_t* lhs_data_;
+  const int8_t* rhs_data_;
+  const uint8_t* scratch_;
+  int row_start_;
+  int row_end_;
+  DstScalar* dst_data_;
+};
+
+template <typename DstScalar, QuantizationFlavor quantization_flavor>
+bool RunX86Int8Gemm(
+    const MatrixParams<int8_t>& lhs_params, const int8_t* lhs_data,
+    const MatrixParams<int8_t>& rhs_params, const int8_t* rhs_data,
+    const MatrixParams<DstScalar>& dst_params, DstScalar* dst_data,
+    const GemmParams<int32_t, DstScalar, quantization_flavor>& params,
+    CpuBackendContext* context) {
+  if (!context->use_x86_int8_kernels()) {
+    return false;
+  }
+  optimized_x86_int8::GemmParams x86_params;
+  x86_params.rows = lhs_params.rows;
+  x86_params.depth = lhs_params.cols;
+  x86_params.cols = rhs_params.cols;
+  const optimized_x86_int8::Kernel kernel =
+      optimized_x86_int8::SelectKernel(x86_params);
+  if (kernel == optimized_x86_int8::Kernel::kNone) {
+    return false;
+  }
+  ruy::profiler::ScopeLabel label("cpu_backend_gemm::Gemm: X86Int8Gemm");
+  x86_params.lhs_zero_point = lhs_params.zero_point;
+  x86_params.rhs_zero_point = rhs_params.zero_point;
+  x86_params.dst_zero_point = dst_params.zero_point;
+  x86_params.bias = params.bias;
+  x86_params.multiplier_fixedpoint = params.multiplier_fixedpoint;
+  x86_params.multiplier_exponent = params.multiplier_exponent;
+  x86_params.multiplier_fixedpoint_perchannel =
+      params.multiplier_fixedpoint_perchannel;
+  x86_params.multiplier_exponent_perchannel =
+      params.multiplier_exponent_perchannel;
+  x86_params.clamp_min = params.clamp_min;
+  x86_params.clamp_max = params.clamp_max;
+
+  std::vector<uint8_t> scratch(
+      optimized_x86_int8::RhsScratchSize(kernel, x86_params));
+  optimized_x86_int8::PrepareRhs(kernel, x86_params, rhs_data, scratch.data());
+
+  const int kernel_rows = optimized_x86_int8::KernelRows(kernel);
+  const int thread_count =
+      kernel == optimized_x86_int8::Kernel::kAmx
+          ? LegacyHowManyThreads<32>(context->max_num_threads(),
+                                     x86_params.rows, x86_params.cols,
+                                     x86_params.depth)
+          : LegacyHowManyThreads<4>(context->max_num_threads(),
+                                    x86_params.rows, x86_params.cols,
+                                    x86_params.depth);
+  if (thread_count == 1) {
+    optimized_x86_int8::Gemm(kernel, x86_params, lhs_data, rhs_data,
+                             scratch.data(), 0, x86_params.rows, dst_data);
+    return true;
+  }
+  std::vector<X86Int8GemmTask<DstScalar>> tasks;
+  tasks.reserve(thread_count);
+  const int rows_per_thread =
+      CeilQuotient(CeilQuotient(x86_params.rows, thread_count), kernel_rows) *
+      kernel_rows;
+  for (int row_start = 0; row_start < x86_params.rows;
+       row_start += rows_per_thread) {
+    const int row_end = std::min(x86_params.rows, row_start + rows_per_thread);
+    tasks.emplace_back(kernel, x86_params, lhs_data, rhs_data, scratch.data(),
+                       row_start, row_end, dst_data);
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(), context);
+  return true;
+}
+
+// X86Int8GemmImpl is specialized for the supported combinations of types,
+// other ones are left to the other backends.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+struct X86Int8GemmImpl {
+  static bool Run(
+      const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
+      const MatrixParams<RhsScalar>& rhs_params, const RhsScalar* rhs_data,
+      const MatrixParams<DstScalar>& dst_params, DstScalar* dst_data,
+      const GemmParams<AccumScalar, DstScalar, quantization_flavor>& params,
+      CpuBackendContext* context) {
+    return false;
+  }
+};
+
+template <QuantizationFlavor quantization_flavor>
+struct X86Int8GemmImpl<int8_t, int8_t, int32_t, int8_t, quantization_flavor> {
+  static bool Run(
+      const MatrixParams<int8_t>& lhs_params, const int8_t* lhs_data,
+      const MatrixParams<int8_t>& rhs_params, const int8_t* rhs_data,
+      const MatrixParams<int8_t>& dst_params, int8_t* dst_data,
+      const GemmParams<int32_t, int8_t, quantization_flavor>& params,
+      CpuBackendContext* context) {
+    return RunX86Int8Gemm(lhs_params, lhs_data, rhs_params, rhs_data,
+                          dst_params, dst_data, params, context);
+  }
+};
+
+template <QuantizationFlavor quantization_flavor>
+struct X86Int8GemmImpl<int8_t, int8_t, int32_t, int16_t, quantization_flavor> {
+  static bool Run(
+      const MatrixParams<int8_t>& lhs_params, const int8_t* lhs_data,
+      const MatrixParams<int8_t>& rhs_params, const int8_t* rhs_data,
+      const MatrixParams<int16_t>& dst_params, int16_t* dst_data,
+      const GemmParams<int32_t, int16_t, quantization_flavor>& params,
+      CpuBackendContext* context) {
+    return RunX86Int8Gemm(lhs_params, lhs_data, rhs_params, rhs_data,
+                          dst_params, dst_data, params, context);
+  }
+};
+
+// Either performs the requested GEMM with the x86 int8 kernels and returns
+// true, or immediately returns false. Expects the storage orders that
+// cpu_backend_gemm::Gemm defaults to: row-major lhs, column-major rhs and dst.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+bool X86Int8Gemm(
+    const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
+    const MatrixParams<RhsScalar>& rhs_params, const RhsScalar* rhs_data,
+    const MatrixParams<DstScalar>& dst_params, DstScalar* dst_data,
+    const GemmParams<AccumScalar, DstScalar, quantization_flavor>& params,
+    CpuBackendContext* context) {
+  return X86Int8GemmImpl<LhsScalar, RhsScalar, AccumScalar, DstScalar,
+                         quantization_flavor>::Run(lhs_params, lhs_data,
+                                                   rhs_params, rhs_data,
+                                                   dst_params, dst_data,
+                                                   params, context);
+}
+
+}  // namespace detail
+}  // namespace cpu_backend_gemm
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_X86_INT8_H_
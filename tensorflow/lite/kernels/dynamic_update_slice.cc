@@ -20,11 +20,14 @@ limitations under the License.
 
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/variable_update_util.h"
 
 namespace tflite {
 namespace ops {
@@ -36,6 +39,20 @@ constexpr int kUpdateTensor = 1;
 constexpr int kStartIndicesTensor = 2;
 constexpr int kOutputTensor = 0;
 
+struct OpData {
+  // Id of the resource variable that the output is also written to in place,
+  // or -1. See variable_update_util.h.
+  int variable_id = -1;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  return new OpData;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
 // TFLite DynamicUpdateSlice op follows the semantics of XLA DynamicUpdateSlice
 // op. See https://www.tensorflow.org/xla/operation_semantics#dynamicupdateslice
 // for details.
@@ -72,6 +89,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_TYPES_EQ(context, operand->type, update->type);
   TF_LITE_ENSURE_TYPES_EQ(context, start_indices->type, kTfLiteInt32);
 
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  op_data->variable_id = GetVariableUpdatedInPlace(
+      reinterpret_cast<Subgraph*>(context->impl_), node);
+
   output->type = operand->type;
   TfLiteIntArray* output_size = TfLiteIntArrayCopy(operand->dims);
   return context->ResizeTensor(context, output, output_size);
@@ -183,13 +204,25 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
   }
 
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  if (op_data->variable_id >= 0) {
+    Subgraph* subgraph = reinterpret_cast<Subgraph*>(context->impl_);
+    auto* variable = resource::GetResourceVariable(&subgraph->resources(),
+                                                   op_data->variable_id);
+    if (CanUpdateVariableInPlace(variable, output)) {
+      TF_LITE_ENSURE_OK(context,
+                        variable->UpdateSlice(update, GetTensorData<int32_t>(
+                                                          indice)));
+    }
+  }
+
   return kTfLiteOk;
 }
 }  // namespace dynamic_update_slice
 
 TfLiteRegistration* Register_DYNAMIC_UPDATE_SLICE() {
-  static TfLiteRegistration r = {/*init=*/nullptr,
-                                 /*free=*/nullptr,
+  static TfLiteRegistration r = {dynamic_update_slice::Init,
+                                 dynamic_update_slice::Free,
                                  dynamic_update_slice::Prepare,
                                  dynamic_update_slice::Eval,
                                  /*profiling_string=*/nullptr,
@@ -25,15 +25,19 @@ limitations under the License.
 //   Output.dim[0] == Tensor[0].dim[0], num of lookups
 //   Output.dim[1] == Tensor[1].dim[1],  num of items per row
 //   Each item in output is a raw bytes copy of the corresponding item in input,
-//   or a dequantized value in the case of a uint8 input.
+//   or a dequantized value in the case of a quantized input and a float output.
+//   Quantized inputs of hybrid lookups are int8, uint8 holding int8 values,
+//   or int4, quantized per tensor or per row.
 //   When indices are out of bound, the ops will not succeed.
 //
 
 #include <stdint.h>
 
-#include <cstring>
+#include <cstddef>
 
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/embedding_lookup.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 
@@ -57,6 +61,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+  if (value->type == kTfLiteInt4) {
+    // Int4 rows aren't byte aligned, so they can only be dequantized.
+    TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+  }
   TfLiteIntArray* outputSize = TfLiteIntArrayCreate(NumDimensions(value));
 
   outputSize->data[0] = SizeOfDimension(lookup, 0);
@@ -67,71 +75,53 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return context->ResizeTensor(context, output, outputSize);
 }
 
-TfLiteStatus EvalSimple(TfLiteContext* context, TfLiteNode* node,
-                        const TfLiteTensor* lookup, const TfLiteTensor* value,
-                        TfLiteTensor* output) {
-  const int row_size = SizeOfDimension(value, 0);
-  if (row_size == 0) {
-    // Propagate empty tensor if input is empty
-    return kTfLiteOk;
-  }
-  const int row_bytes = value->bytes / row_size;
-
-  char* output_raw = GetTensorData<char>(output);
-  const char* value_raw = GetTensorData<char>(value);
+// Returns an error if any of the lookups is out of the rows of `value`.
+TfLiteStatus CheckLookups(TfLiteContext* context, const TfLiteTensor* lookup,
+                          const TfLiteTensor* value) {
+  const int num_rows = SizeOfDimension(value, 0);
   const int32_t* lookup_data = GetTensorData<int32_t>(lookup);
   for (int i = 0; i < SizeOfDimension(lookup, 0); i++) {
     int idx = lookup_data[i];
-    if (idx >= row_size || idx < 0) {
+    if (idx >= num_rows || idx < 0) {
       TF_LITE_KERNEL_LOG(context,
                          "Embedding Lookup: index out of bounds. "
                          "Got %d, and bounds are [0, %d]",
-                         idx, row_size - 1);
+                         idx, num_rows - 1);
       return kTfLiteError;
-    } else {
-      std::memcpy(output_raw + i * row_bytes, value_raw + idx * row_bytes,
-                  row_bytes);
     }
   }
-
   return kTfLiteOk;
 }
 
-TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
+TfLiteStatus EvalSimple(TfLiteContext* context, TfLiteNode* node,
                         const TfLiteTensor* lookup, const TfLiteTensor* value,
                         TfLiteTensor* output) {
   const int row_size = SizeOfDimension(value, 0);
-  const double scaling_factor = value->params.scale;
-
-  // col_size after we flatten tensor into 2D.
-  int col_size = 1;
-  for (int i = 1; i < NumDimensions(value); i++) {
-    col_size *= SizeOfDimension(value, i);
-  }
-
-  float* output_ptr = GetTensorData<float>(output);
-  const int8_t* value_ptr = GetTensorData<int8_t>(value);
-  const int32_t* lookup_data = GetTensorData<int32_t>(lookup);
-
-  for (int i = 0; i < SizeOfDimension(lookup, 0); i++) {
-    int idx = lookup_data[i];
-    if (idx >= row_size || idx < 0) {
-      TF_LITE_KERNEL_LOG(context,
-                         "Embedding Lookup: index out of bounds. "
-                         "Got %d, and bounds are [0, %d]",
-                         idx, row_size - 1);
-      return kTfLiteError;
-    } else {
-      // Dequantize embedding values.
-      // TODO(alanchiao): refactor scalar multiply into separate function
-      // for ease of adding a neon equivalent if ever necessary.
-      for (int j = 0; j < col_size; j++) {
-        output_ptr[j + i * col_size] =
-            value_ptr[j + idx * col_size] * scaling_factor;
-      }
-    }
+  if (row_size == 0) {
+    // Propagate empty tensor if input is empty
+    return kTfLiteOk;
   }
+  TF_LITE_ENSURE_OK(context, CheckLookups(context, lookup, value));
+  const size_t row_bytes = value->bytes / row_size;
+  optimized_embedding::GatherRows(
+      GetTensorData<char>(value), row_bytes, GetTensorData<int32_t>(lookup),
+      SizeOfDimension(lookup, 0), GetTensorData<char>(output),
+      CpuBackendContext::GetFromContext(context));
+  return kTfLiteOk;
+}
 
+TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
+                        const TfLiteTensor* lookup, const TfLiteTensor* value,
+                        TfLiteTensor* output) {
+  optimized_embedding::EmbeddingTable table;
+  TF_LITE_ENSURE_OK(context,
+                    optimized_embedding::GetEmbeddingTable(context, value,
+                                                           &table));
+  TF_LITE_ENSURE_OK(context, CheckLookups(context, lookup, value));
+  optimized_embedding::GatherRows(table, GetTensorData<int32_t>(lookup),
+                                  SizeOfDimension(lookup, 0),
+                                  GetTensorData<float>(output),
+                                  CpuBackendContext::GetFromContext(context));
   return kTfLiteOk;
 }
 
@@ -147,6 +137,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return EvalSimple(context, node, lookup, value, output);
     case kTfLiteUInt8:
     case kTfLiteInt8:
+    case kTfLiteInt4:
       if (output->type == kTfLiteFloat32) {
         return EvalHybrid(context, node, lookup, value, output);
       } else {
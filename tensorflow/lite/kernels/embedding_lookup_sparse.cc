@@ -35,7 +35,8 @@ limitations under the License.
 //     Tensor[2]: Dense shape, int32.
 //     Tensor[3]: Weights to use for aggregation, float.
 //     Tensor[4]: Params, a matrix of multi-dimensional items,
-//                dim.size >= 2, float.
+//                dim.size >= 2, float, or int8, uint8 holding int8 values,
+//                or int4, quantized symmetrically per tensor or per row.
 //
 // Output:
 //   A (dense) tensor representing the combined embeddings for the sparse ids.
@@ -65,12 +66,13 @@ limitations under the License.
 #include <stdint.h>
 
 #include <algorithm>
-#include <cmath>
+#include <vector>
 
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/embedding_lookup.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
-#include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/util.h"
 
@@ -112,6 +114,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* value;
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 4, &value));
   TF_LITE_ENSURE(context, NumDimensions(value) >= 2);
+  optimized_embedding::EmbeddingTable table;
+  TF_LITE_ENSURE_OK(context, optimized_embedding::GetEmbeddingTable(
+                                 context, value, &table));
 
   // Mark the output as a dynamic tensor.
   TfLiteTensor* output;
@@ -122,25 +127,14 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
-void FinalizeAggregation(TfLiteCombinerType combiner, int num_elements,
-                         float current_total_weight,
-                         float current_squares_weight, int embedding_size,
-                         float* output) {
-  if (combiner != kTfLiteCombinerTypeSum && num_elements > 0) {
-    float multiplier = 1.0;
-    switch (combiner) {
-      case kTfLiteCombinerTypeMean:
-        multiplier = current_total_weight;
-        break;
-      case kTfLiteCombinerTypeSqrtn:
-        multiplier = std::sqrt(current_squares_weight);
-        break;
-      default:
-        break;
-    }
-    for (int k = 0; k < embedding_size; k++) {
-      output[k] /= multiplier;
-    }
+optimized_embedding::Combiner GetCombiner(TfLiteCombinerType combiner) {
+  switch (combiner) {
+    case kTfLiteCombinerTypeMean:
+      return optimized_embedding::Combiner::kMean;
+    case kTfLiteCombinerTypeSqrtn:
+      return optimized_embedding::Combiner::kSqrtN;
+    default:
+      return optimized_embedding::Combiner::kSum;
   }
 }
 
@@ -159,7 +153,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 3, &weights));
   const TfLiteTensor* value;
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 4, &value));
-  const size_t values_size = NumElements(value);
 
   const int lookup_rank = SizeOfDimension(indices, 1);
   const int embedding_rank = NumDimensions(value);
@@ -200,19 +193,15 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensorRealloc(output_size * sizeof(float), output);
 
   float* output_ptr = GetTensorData<float>(output);
-  const float* weights_ptr = GetTensorData<float>(weights);
-  const float* value_ptr = GetTensorData<float>(value);
   // Makes sure reallocation was successful.
   TF_LITE_ENSURE(context, output_ptr != nullptr);
 
   std::fill_n(output_ptr, output_size, 0.0f);
 
-  // Keep track of the current bucket for aggregation/combination.
-  int current_output_offset = 0;
-  float current_total_weight = 0.0;
-  float current_squares_weight = 0.0;
-  int num_elements = 0;
-
+  // Splits the lookups into bags of consecutive lookups with the same output
+  // row, i.e. the same indices but the last one.
+  std::vector<int32_t> bag_offsets;
+  std::vector<int32_t> bag_output_rows;
   for (int i = 0; i < num_lookups; i++) {
     int idx = ids->data.i32[i];
     if (idx >= num_rows || idx < 0) {
@@ -223,51 +212,36 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
     }
 
-    // Check where we need to aggregate.
     const int example_indices_offset = i * lookup_rank;
     int output_bucket = 0;
     int stride = 1;
     for (int k = (lookup_rank - 1) - 1; k >= 0; k--) {
-      output_bucket += indices->data.i32[example_indices_offset + k] * stride;
+      const int index = indices->data.i32[example_indices_offset + k];
+      if (index < 0 || index >= dense_shape->data.i32[k]) {
+        TF_LITE_KERNEL_LOG(context,
+                           "Embedding Lookup Sparse: sparse index out of "
+                           "bounds. Got %d, and bounds are [0, %d]",
+                           index, dense_shape->data.i32[k] - 1);
+        return kTfLiteError;
+      }
+      output_bucket += index * stride;
       stride *= dense_shape->data.i32[k];
     }
-    const int output_offset = output_bucket * embedding_size;
-
-    // If we are in a new aggregation bucket and the combiner is not the sum,
-    // go back and finalize the result of the previous bucket.
-    if (output_offset != current_output_offset) {
-      FinalizeAggregation(params->combiner, num_elements, current_total_weight,
-                          current_squares_weight, embedding_size,
-                          &output_ptr[current_output_offset]);
-
-      // Track next bucket.
-      num_elements = 0;
-      current_total_weight = 0.0;
-      current_squares_weight = 0.0;
-      current_output_offset = output_offset;
-    }
-
-    // Add element to aggregation.
-    ++num_elements;
-    const int example_embedding_offset = idx * embedding_size;
-    const float w = weights_ptr[i];
-    current_squares_weight += w * w;
-    current_total_weight += w;
-    for (int k = 0; k < embedding_size; k++) {
-      // only index if indices are valid
-      if (current_output_offset + k < 0) continue;
-      if (current_output_offset + k >= output_size) continue;
-      if (example_embedding_offset + k < 0) continue;
-      if (example_embedding_offset + k >= values_size) continue;
-      output_ptr[current_output_offset + k] +=
-          value_ptr[example_embedding_offset + k] * w;
+    if (bag_output_rows.empty() || bag_output_rows.back() != output_bucket) {
+      bag_offsets.push_back(i);
+      bag_output_rows.push_back(output_bucket);
     }
   }
-
-  // Finalize last bucket.
-  FinalizeAggregation(params->combiner, num_elements, current_total_weight,
-                      current_squares_weight, embedding_size,
-                      &GetTensorData<float>(output)[current_output_offset]);
+  bag_offsets.push_back(num_lookups);
+
+  optimized_embedding::EmbeddingTable table;
+  TF_LITE_ENSURE_OK(context, optimized_embedding::GetEmbeddingTable(
+                                 context, value, &table));
+  optimized_embedding::CombineBags(
+      table, GetTensorData<int32_t>(ids), GetTensorData<float>(weights),
+      bag_offsets.data(), bag_output_rows.data(), bag_output_rows.size(),
+      GetCombiner(params->combiner), output_ptr,
+      CpuBackendContext::GetFromContext(context));
 
   return kTfLiteOk;
 }
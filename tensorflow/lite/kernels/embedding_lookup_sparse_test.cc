@@ -39,12 +39,13 @@ class EmbeddingLookupSparseOpModel : public SingleOpModel {
                                std::initializer_list<int> lookup_shape,
                                std::initializer_list<int> indices_shape,
                                std::initializer_list<int> dense_shape_shape,
-                               std::initializer_list<int> value_shape) {
+                               std::initializer_list<int> value_shape,
+                               TensorType value_type = TensorType_FLOAT32) {
     lookup_ = AddInput(TensorType_INT32);
     indices_ = AddInput(TensorType_INT32);
     dense_shape_ = AddInput(TensorType_INT32);
     weights_ = AddInput(TensorType_FLOAT32);
-    value_ = AddInput(TensorType_FLOAT32);
+    value_ = AddInput(value_type);
     output_ = AddOutput(TensorType_FLOAT32);
     SetBuiltinOp(BuiltinOperator_EMBEDDING_LOOKUP_SPARSE,
                  BuiltinOptions_EmbeddingLookupSparseOptions,
@@ -78,6 +79,24 @@ class EmbeddingLookupSparseOpModel : public SingleOpModel {
     }
   }
 
+  // Quantizes the values of `function` into an int8 table.
+  void SetQuantized3DWeightMatrix(
+      const std::function<float(int, int, int)>& function) {
+    TfLiteTensor* tensor = interpreter_->tensor(value_);
+    int rows = tensor->dims->data[0];
+    int columns = tensor->dims->data[1];
+    int features = tensor->dims->data[2];
+    std::vector<float> values;
+    for (int i = 0; i < rows; i++) {
+      for (int j = 0; j < columns; j++) {
+        for (int k = 0; k < features; k++) {
+          values.push_back(function(i, j, k));
+        }
+      }
+    }
+    SignedSymmetricQuantizeAndPopulate(value_, values);
+  }
+
   std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
 
  private:
@@ -140,6 +159,33 @@ TEST(EmbeddingLookupSparseOpTest, SimpleTestSqrtn) {
               })));
 }
 
+TEST(EmbeddingLookupSparseOpTest, HybridTestMean) {
+  EmbeddingLookupSparseOpModel m(CombinerType_MEAN, {3}, {3, 2}, {2},
+                                 {4, 3, 2}, TensorType_INT8);
+  m.SetInput({1, 3, 0}, {0, 0, 2, 0, 2, 1}, {3, 2}, {1.0, 2.0, 4.0});
+  m.SetQuantized3DWeightMatrix(
+      [](int i, int j, int k) { return i + j / 10.0f + k / 100.0f; });
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {
+                      1.00, 1.01, 1.10, 1.11, 1.20, 1.21,  // Row 1
+                      0.00, 0.00, 0.00, 0.00, 0.00, 0.00,  // -
+                      // (2 * Row 3 + 4 * Row 0) / 6
+                      1.00, 1.01, 1.10, 1.11, 1.20, 1.21,
+                  },
+                  0.02)));
+}
+
+TEST(EmbeddingLookupSparseOpTest, IndexOutOfDenseShape) {
+  EmbeddingLookupSparseOpModel m(CombinerType_SUM, {3}, {3, 2}, {2}, {4, 3, 2});
+  m.SetInput({1, 3, 0}, {0, 0, 3, 0, 2, 1}, {3, 2}, {1.0, 2.0, 4.0});
+  m.Set3DWeightMatrix(
+      [](int i, int j, int k) { return i + j / 10.0f + k / 100.0f; });
+  EXPECT_EQ(m.Invoke(), kTfLiteError);
+}
+
 TEST(EmbeddingLookupSparseOpTest, Indices3DTest) {
   EmbeddingLookupSparseOpModel m(CombinerType_SUM, {3}, {3, 3}, {3}, {4, 3, 2});
   m.SetInput({1, 3, 0}, {0, 0, 0, 2, 0, 0, 2, 0, 1}, {3, 2, 2},
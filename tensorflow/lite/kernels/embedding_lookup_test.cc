@@ -101,6 +101,41 @@ class HybridEmbeddingLookupOpModel : public BaseEmbeddingLookupOpModel {
   }
 };
 
+// Looks up rows of a table quantized with `scales`, one for the whole table
+// or one per row.
+class AffineHybridEmbeddingLookupOpModel : public SingleOpModel {
+ public:
+  AffineHybridEmbeddingLookupOpModel(std::initializer_list<int> index_shape,
+                                     std::initializer_list<int> weight_shape,
+                                     TensorType type,
+                                     const std::vector<float>& scales) {
+    input_ = AddInput(TensorType_INT32);
+    weight_ = AddInput({type, weight_shape, /*min=*/0, /*max=*/0,
+                        /*scale=*/0, /*zero_point=*/0,
+                        /*per_channel_quantization=*/true, scales,
+                        std::vector<int64_t>(scales.size(), 0),
+                        /*channel_index=*/0});
+    output_ = AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_EMBEDDING_LOOKUP, BuiltinOptions_NONE, 0);
+    BuildInterpreter({index_shape, weight_shape});
+  }
+
+  void SetInput(std::initializer_list<int> data) {
+    PopulateTensor(input_, data);
+  }
+
+  void SetWeight(const std::vector<float>& data) {
+    PerChannelSymmetricQuantizeAndPopulate(weight_, data);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int weight_;
+  int output_;
+};
+
 // TODO(ahentz): write more tests that exercise the details of the op, such as
 // lookup errors and variable input shapes.
 TEST(EmbeddingLookupOpTest, SimpleTest) {
@@ -245,6 +280,65 @@ TEST(HybridEmbeddingLookupHybridOpTest, Simple4DTestInt8) {
                   kTestTolerance)));
 }
 
+TEST(HybridEmbeddingLookupHybridOpTest, Simple2DTestInt4) {
+  AffineHybridEmbeddingLookupOpModel m({3}, {3, 8}, TensorType_INT4, {0.5});
+  m.SetInput({1, 0, 2});
+  m.SetWeight({
+      0.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5,          // Row 0
+      -0.5, -1.0, -1.5, -2.0, -2.5, -3.0, -3.5, 0.0,  // Row 1
+      3.5, 3.0, 2.5, 2.0, 1.5, 1.0, 0.5, 0.0,          // Row 2
+  });
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({
+                  -0.5, -1.0, -1.5, -2.0, -2.5, -3.0, -3.5, 0.0,  // Row 1
+                  0.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5,          // Row 0
+                  3.5, 3.0, 2.5, 2.0, 1.5, 1.0, 0.5, 0.0,          // Row 2
+              })));
+}
+
+TEST(HybridEmbeddingLookupHybridOpTest, PerRowTestInt8) {
+  AffineHybridEmbeddingLookupOpModel m({4}, {3, 2, 2}, TensorType_INT8,
+                                       {0.01, 1.0, 100.0});
+  m.SetInput({2, 0, 1, 2});
+  m.SetWeight({
+      0.01, -0.02, 0.5, 1.27,          // Row 0
+      1.0, -2.0, 50.0, 127.0,          // Row 1
+      100.0, -200.0, 5000.0, 12700.0,  // Row 2
+  });
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 100.0, -200.0, 5000.0, 12700.0,  // Row 2
+                                 0.01, -0.02, 0.5, 1.27,          // Row 0
+                                 1.0, -2.0, 50.0, 127.0,          // Row 1
+                                 100.0, -200.0, 5000.0, 12700.0,  // Row 2
+                             })));
+}
+
+TEST(HybridEmbeddingLookupHybridOpTest, PerRowTestInt4) {
+  // Rows of 3 values, so that row 1 starts in the middle of a byte.
+  AffineHybridEmbeddingLookupOpModel m({3}, {3, 3}, TensorType_INT4,
+                                       {0.5, 1.0, 2.0});
+  m.SetInput({1, 2, 0});
+  m.SetWeight({
+      0.5, -1.0, 3.5,  // Row 0
+      1.0, -7.0, 7.0,  // Row 1
+      2.0, 4.0, -14.0  // Row 2
+  });
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 1.0, -7.0, 7.0,   // Row 1
+                                 2.0, 4.0, -14.0,  // Row 2
+                                 0.5, -1.0, 3.5,   // Row 0
+                             })));
+}
+
 TEST(EmbeddingLookupHybridOpTest, Simple3DTestQuantized) {
   EmbeddingLookupOpModel m({3}, {3, 2, 4}, TensorType_UINT8, TensorType_INT8);
   m.SetInput({1, 0, 2});
@@ -25,9 +25,11 @@ limitations under the License.
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 #include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_weights.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
@@ -136,6 +138,9 @@ struct OpData {
   // Used for 4bit hybrid
   std::unique_ptr<optimized_4bit::OpData4Bit> op_data_4bit = nullptr;
   TfLiteType quantized_bias_type = kTfLiteNoType;
+  // Constant sparse weights packed for optimized_sparse.
+  std::unique_ptr<optimized_sparse::SparseWeights<float>> sparse_weights_float;
+  std::unique_ptr<optimized_sparse::SparseWeights<int8_t>> sparse_weights_int8;
 };
 
 constexpr int kInputTensor = 0;
@@ -726,16 +731,25 @@ TfLiteStatus EvalHybridDense(
   tensor_utils::BatchQuantizeFloats(
       input_ptr, batch_size, input_size, quant_data, scaling_factors_ptr,
       input_offset_ptr, params->asymmetric_quantize_inputs);
-  for (int b = 0; b < batch_size; ++b) {
-    // Incorporate scaling of the filter.
-    scaling_factors_ptr[b] *= filter->params.scale;
+  // Per-channel scales of the filter are applied to each row of the output,
+  // a per-tensor one is incorporated into the scaling factors.
+  const float* per_channel_scale = nullptr;
+  const auto* filter_params =
+      reinterpret_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+  if (filter_params && filter_params->scale &&
+      filter_params->scale->size > 1) {
+    per_channel_scale = filter_params->scale->data;
+  } else {
+    for (int b = 0; b < batch_size; ++b) {
+      scaling_factors_ptr[b] *= filter->params.scale;
+    }
   }
 
   // Compute output += weight * quantized_input
   int32_t* scratch = GetTensorData<int32_t>(accum_scratch);
   tensor_utils::MatrixBatchVectorMultiplyAccumulate(
       filter_data, num_units, input_size, quant_data, scaling_factors_ptr,
-      batch_size, GetTensorData<float>(output), /*per_channel_scale=*/nullptr,
+      batch_size, GetTensorData<float>(output), per_channel_scale,
       input_offset_ptr, scratch, row_sums_ptr, &data->compute_row_sums,
       CpuBackendContext::GetFromContext(context));
 
@@ -917,29 +931,10 @@ TfLiteStatus EvalHybridDense4Bit(
                                  weight_ptr, lhs_layout_rows, lhs_layout_cols,
                                  output_depth, cols, lhs_width, depth);
     data->op_data_4bit->needs_prepack = false;
-#ifdef MADV_PAGEOUT
     // After prepacking, we will never use the weights from the model file. Mark
-    // them with MADV_PAGEOUT so the kernel can reclaim the pages, decreasing
-    // the resident memory size.
-    //
-    // This is Linux specific. There is no effect on other platforms (e.g. on
-    // Windows, but possibly other POSIX platforms!). It requires a minimum
-    // Kernel version of 5.4 - on older kernels the call will return with an
-    // error, but we ignore it. The kernel might also ignore this hint.
-    //
-    // Note, due to rounding the pointer up (which is necessary due to madvise
-    // requiring an address that aligns with the page size), the first partial
-    // page will not be reclaimed. Madvise also rounds the end of the hinted
-    // range down, so the last partial page is also unaffected. Because of this
-    // behavior, on average one memory page (usually 4 kiB) per buffer holding 4
-    // bit data will not be paged out.
-    static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
-    int8_t* up_aligned_ptr = reinterpret_cast<int8_t*>(
-        ((reinterpret_cast<uintptr_t>(weight_ptr) + pagesize - 1) / pagesize) *
-        pagesize);
-    const auto rounding_size = up_aligned_ptr - weight_ptr;
-    madvise(up_aligned_ptr, weight_size - rounding_size, MADV_PAGEOUT);
-#endif
+    // them so the kernel can reclaim the pages, decreasing the resident memory
+    // size.
+    optimized_4bit::api::PageOut(weight_ptr, weight_size);
   }
 
   std::vector<float> filter_scales(lhs_layout_rows, filter->params.scale);
@@ -1224,6 +1219,107 @@ bool VerifySparsity(const RuntimeShape& weights_shape,
   return true;
 }
 
+// Returns true if the constant sparse `filter` should be packed for
+// optimized_sparse, which handles any block size and has AVX2 kernels. Formats
+// with NEON kernels keep using them on other CPUs.
+bool UseSparseWeights(const TfLiteTensor* filter, bool has_neon_kernels) {
+  return IsConstantTensor(filter) &&
+         (!has_neon_kernels || DetectX86Avx2Fma());
+}
+
+// Packs the weights of `filter` on first use, and again when `batch_size`
+// changes which of the sparse and dense kernels are faster.
+template <typename T>
+TfLiteStatus PrepareSparseWeights(
+    TfLiteContext* context, const TfLiteTensor* filter, int batch_size,
+    std::unique_ptr<optimized_sparse::SparseWeights<T>>* weights) {
+  if (*weights && !optimized_sparse::NeedsRepacking(**weights, batch_size)) {
+    return kTfLiteOk;
+  }
+  if (!*weights) {
+    *weights = std::make_unique<optimized_sparse::SparseWeights<T>>();
+  }
+  return optimized_sparse::PackSparseWeights(
+      *filter->sparsity, filter->dims->data[0], filter->dims->data[1],
+      /*transposed=*/false, GetTensorData<T>(filter), batch_size,
+      weights->get(), context);
+}
+
+TfLiteStatus EvalSparseWeightsInt8(TfLiteContext* context, OpData* data,
+                                   const FullyConnectedParams& op_params,
+                                   bool is_per_channel,
+                                   const TfLiteTensor* input,
+                                   const TfLiteTensor* filter,
+                                   const TfLiteTensor* bias,
+                                   TfLiteTensor* output) {
+  const RuntimeShape output_shape = GetTensorShape(output);
+  const int batch_size =
+      FlatSizeSkipDim(output_shape, output_shape.DimensionsCount() - 1);
+  TF_LITE_ENSURE_OK(context,
+                    PrepareSparseWeights(context, filter, batch_size,
+                                         &data->sparse_weights_int8));
+  const auto& weights = *data->sparse_weights_int8;
+  const int32_t* per_channel_multiplier =
+      is_per_channel ? data->per_channel_output_multiplier.data() : nullptr;
+  const int* per_channel_shift =
+      is_per_channel ? data->per_channel_output_shift.data() : nullptr;
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  if (!weights.use_dense) {
+    optimized_sparse::SparseFullyConnected(
+        weights, op_params, per_channel_multiplier, per_channel_shift,
+        GetTensorData<int8_t>(input), batch_size, GetTensorData<int32_t>(bias),
+        GetTensorData<int8_t>(output), cpu_backend_context);
+  } else if (is_per_channel) {
+    optimized_integer_ops::FullyConnectedPerChannel(
+        op_params, per_channel_multiplier, per_channel_shift,
+        GetTensorShape(input), GetTensorData<int8_t>(input),
+        RuntimeShape({weights.rows, weights.cols}), weights.dense.data(),
+        GetTensorShape(bias), GetTensorData<int32_t>(bias), output_shape,
+        GetTensorData<int8_t>(output), cpu_backend_context);
+  } else {
+    optimized_integer_ops::FullyConnected(
+        op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
+        RuntimeShape({weights.rows, weights.cols}), weights.dense.data(),
+        GetTensorShape(bias), GetTensorData<int32_t>(bias), output_shape,
+        GetTensorData<int8_t>(output), cpu_backend_context);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus EvalSparseWeightsFloat(TfLiteContext* context, OpData* data,
+                                    const FullyConnectedParams& op_params,
+                                    const TfLiteTensor* input,
+                                    const TfLiteTensor* filter,
+                                    const TfLiteTensor* bias,
+                                    TfLiteTensor* output) {
+  const RuntimeShape output_shape = GetTensorShape(output);
+  const int batch_size =
+      FlatSizeSkipDim(output_shape, output_shape.DimensionsCount() - 1);
+  TF_LITE_ENSURE_OK(context,
+                    PrepareSparseWeights(context, filter, batch_size,
+                                         &data->sparse_weights_float));
+  const auto& weights = *data->sparse_weights_float;
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  if (!weights.use_dense) {
+    optimized_sparse::SparseFullyConnected(
+        weights, op_params, GetTensorData<float>(input), batch_size,
+        GetTensorData<float>(bias), GetTensorData<float>(output),
+        cpu_backend_context);
+  } else {
+    FullyConnectedParams dense_params = op_params;
+    dense_params.lhs_cacheable = true;
+    dense_params.rhs_cacheable = IsConstantTensor(input);
+    optimized_ops::FullyConnected(
+        dense_params, GetTensorShape(input), GetTensorData<float>(input),
+        RuntimeShape({weights.rows, weights.cols}), weights.dense.data(),
+        GetTensorShape(bias), GetTensorData<float>(bias), output_shape,
+        GetTensorData<float>(output), cpu_backend_context);
+  }
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type>
 TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                            TfLiteFullyConnectedParams* params, OpData* data,
@@ -1300,6 +1396,17 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                                "supports symmetric weight quantization only.");
             return kTfLiteError;
           }
+          // Int4 support for sparse filter tensor is currently not supported
+          TF_LITE_ENSURE(context, filter->type != kTfLiteInt4);
+          const bool has_neon_kernels =
+              SupportedSparsityFormat(sparsity) &&
+              sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse &&
+              sparsity.dim_metadata[2].dense_size == 16;
+          if (UseSparseWeights(filter, has_neon_kernels)) {
+            return EvalSparseWeightsInt8(context, data, op_params,
+                                         is_per_channel, input, filter, bias,
+                                         output);
+          }
           if (!SupportedSparsityFormat(sparsity) ||
               !VerifySparsity(filter_shape, input_shape, output_shape,
                               &sparsity)) {
@@ -1308,8 +1415,6 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                 "Invalid quantized and sparse fully-connected format.");
             return kTfLiteError;
           }
-          // Int4 support for sparse filter tensor is currently not supported
-          TF_LITE_ENSURE(context, filter->type != kTfLiteInt4);
           if (sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse &&
               sparsity.dim_metadata[2].dense_size == 16) {
             // Block sparse with block size of 1x16.
@@ -1478,6 +1583,15 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
     op_params.float_activation_max = output_activation_max;
     if (filter->sparsity != nullptr) {
       const auto& sparsity = *filter->sparsity;
+      const bool has_neon_kernels =
+          SupportedSparsityFormat(sparsity) &&
+          (sparsity.dim_metadata_size == kDimMetadataSizeRandomSparse ||
+           (sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse &&
+            sparsity.dim_metadata[2].dense_size == 4));
+      if (UseSparseWeights(filter, has_neon_kernels)) {
+        return EvalSparseWeightsFloat(context, data, op_params, input, filter,
+                                      bias, output);
+      }
       if (!SupportedSparsityFormat(sparsity)) {
         TF_LITE_KERNEL_LOG(context,
                            "Unsupported sparse fully-connected weight format.");
@@ -1966,6 +1966,66 @@ TEST_P(SparseFullyConnectedOpTest, Simple1x4TestMultiThreadedMoreBatches) {
   }
 }
 
+TEST_P(SparseFullyConnectedOpTest, Simple2x2Test) {
+  std::initializer_list<float> weight_data = {
+      1, 2, 0, 0,  0, 0, 3, 4,  // u = 0
+      5, 6, 0, 0,  0, 0, 7, 8,  // u = 1
+      0, 0, 1, -1, 0, 0, 0, 0,  // u = 2
+      0, 0, 2, -2, 0, 0, 0, 0,  // u = 3
+  };
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {4, 8};
+  weight.traversal_order = {0, 1, 2, 3};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {0, 1};
+  weight.block_size = {2, 2};
+  SparseFullyConnectedOpModel<float> m(GetRegistration(),
+                                       /*units=*/4, /*batches=*/2,
+                                       /*input=*/{TensorType_FLOAT32, {2, 8}},
+                                       weight, weight_data);
+  m.SetBias({1, 2, 3, 4});
+
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,  // b = 0
+      8, 7, 6, 5, 4, 3, 2, 1,  // b = 1
+  });
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 4));
+  EXPECT_THAT(m.GetOutput(), ElementsAre(59, 132, 2, 2, 33, 106, 4, 6));
+}
+
+TEST_P(SparseFullyConnectedOpTest, Structured2x4Test) {
+  // At most 2 nonzero weights in each group of 4.
+  std::initializer_list<float> weight_data = {
+      1, 0,  2, 0,  0, 3, 0, 4,  0, 0, 5, 6, 7, 0, 0, 8,  // u = 0
+      0, -1, 0, -2, 3, 0, 0, 4,  1, 1, 0, 0, 0, 2, 0, 2,  // u = 1
+      0, 0,  0, 0,  1, 0, 0, -1, 0, 2, 0, 0, 0, 0, 3, 0,  // u = 2
+  };
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {3, 16};
+  weight.traversal_order = {0, 1};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  SparseFullyConnectedOpModel<float> m(GetRegistration(),
+                                       /*units=*/3, /*batches=*/2,
+                                       /*input=*/{TensorType_FLOAT32, {2, 16}},
+                                       weight, weight_data);
+  m.SetBias({1, 2, 3});
+
+  m.SetInput({
+      1,  2,  3,  4,  5,  6,  7, 8, 9, 10, 11, 12, 13, 14, 15, 16,  // b = 0
+      16, 15, 14, 13, 12, 11, 10, 9, 8, 7,  6,  5,  4,  3,  2,  1,  // b = 1
+  });
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+  EXPECT_THAT(m.GetOutput(), ElementsAre(404, 118, 65, 210, 56, 26));
+}
+
 TEST_P(SparseHybridFullyConnectedOpTest, SparseHybrid1x16Test) {
   std::initializer_list<float> weight_data = {
       /* 1st row */
@@ -2251,6 +2311,35 @@ TEST_P(SparseQuantizedFullyConnectedOpTest, Simple1x16TestScaledInputOutput) {
   EXPECT_THAT(m.GetOutput(), ElementsAre(-52, -50, -52));
 }
 
+TEST_P(SparseQuantizedFullyConnectedOpTest, Simple1x4Test) {
+  std::vector<float> weight_data = {
+      1, 2, 3, 4, 0, 0, 0, 0, -1, -2, -3, -4,  // u = 0
+      0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,   // u = 1
+      0, 0, 0, 0, 4, 3, 2, 1, 1,  1,  1,  1,   // u = 2
+  };
+  TensorData weight = {TensorType_INT8, {3, 12}, 0, 0, 1};
+  weight.traversal_order = {0, 1, 2};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {1};
+  weight.block_size = {4};
+  SparseQuantizedFullyConnectedOpModel m(
+      GetRegistration(),
+      /*units=*/3, /*batches=*/2,
+      /*input=*/{TensorType_INT8, {2, 12}, 0, 0, 1}, weight, weight_data,
+      /*output=*/{TensorType_INT8, {}, 0, 0, 1});
+
+  m.SetBias({1, 2, 3});
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,  -9, -10, 11,  12,  // b = 0
+      1, 2, 3, 4, 5, 6, 7, -8, 9,  -10, -11, 12,  // b = 1
+  });
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+  EXPECT_THAT(m.GetOutput(), ElementsAre(0, 2, 67, 27, 2, 47));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     SparseQuantizedFullyConnectedOpTest, SparseQuantizedFullyConnectedOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMapNoPie)));
@@ -0,0 +1,252 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Scaled dot-product attention, which the converter fuses from the
+// BatchMatMul, Mul, Add, Softmax and BatchMatMul ops of attention layers.
+//
+// Input:
+//     Tensor[0]: Query, [batches, heads, query_length, depth].
+//     Tensor[1]: Key, [batches, kv_heads, key_length, depth], where kv_heads
+//                divides heads.
+//     Tensor[2]: Value, [batches, kv_heads, key_length, value_depth].
+//     Tensor[3]: Optional mask added to the scores, float32, broadcastable to
+//                [batches, heads, query_length, key_length].
+//
+// Options (flexbuffer map):
+//     scale: Factor of the scores, 1/sqrt(depth) if missing.
+//     causal: Whether query i only attends to keys up to
+//             i + key_length - query_length.
+//
+// Output:
+//     Tensor[0]: softmax(scale * query * key^T + mask) * value,
+//                [batches, heads, query_length, value_depth].
+//
+// The inputs and output are all float32, or all int8 quantized per tensor.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/fused_attention.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace fused_attention {
+
+constexpr int kQueryTensor = 0;
+constexpr int kKeyTensor = 1;
+constexpr int kValueTensor = 2;
+constexpr int kMaskTensor = 3;
+constexpr int kOutputTensor = 0;
+
+struct OpData {
+  // A negative scale means 1/sqrt(depth).
+  float scale = -1.0f;
+  bool causal = false;
+  // The index of the temporary tensor holding the scratch memory of the
+  // threads.
+  int scratch_tensor_index;
+  optimized_attention::AttentionParams params;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  auto* op_data = new OpData();
+  if (buffer != nullptr && length > 0) {
+    const flexbuffers::Map& m =
+        flexbuffers::GetRoot(reinterpret_cast<const uint8_t*>(buffer), length)
+            .AsMap();
+    if (!m["scale"].IsNull()) op_data->scale = m["scale"].AsFloat();
+    op_data->causal = m["causal"].AsBool();
+  }
+  context->AddTensors(context, 1, &op_data->scratch_tensor_index);
+  return op_data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE(context, NumInputs(node) == 3 || NumInputs(node) == 4);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  const TfLiteTensor* query;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kQueryTensor, &query));
+  const TfLiteTensor* key;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kKeyTensor, &key));
+  const TfLiteTensor* value;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kValueTensor, &value));
+  const TfLiteTensor* mask = GetOptionalInputTensor(context, node, kMaskTensor);
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+
+  TF_LITE_ENSURE(context,
+                 query->type == kTfLiteFloat32 || query->type == kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, key->type, query->type);
+  TF_LITE_ENSURE_TYPES_EQ(context, value->type, query->type);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, query->type);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(query), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(key), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(value), 4);
+
+  optimized_attention::AttentionParams& params = op_data->params;
+  params.batches = SizeOfDimension(query, 0);
+  params.heads = SizeOfDimension(query, 1);
+  params.kv_heads = SizeOfDimension(key, 1);
+  params.query_length = SizeOfDimension(query, 2);
+  params.key_length = SizeOfDimension(key, 2);
+  params.depth = SizeOfDimension(query, 3);
+  params.value_depth = SizeOfDimension(value, 3);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(key, 0), params.batches);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(value, 0), params.batches);
+  TF_LITE_ENSURE(context, params.kv_heads > 0);
+  TF_LITE_ENSURE_EQ(context, params.heads % params.kv_heads, 0);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(value, 1), params.kv_heads);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(key, 3), params.depth);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(value, 2), params.key_length);
+  params.scale = op_data->scale >= 0.0f
+                     ? op_data->scale
+                     : 1.0f / std::sqrt(static_cast<float>(params.depth));
+  params.causal = op_data->causal;
+
+  // The mask is right-aligned with the scores, and broadcast along its
+  // dimensions of size 1.
+  std::fill_n(params.mask_strides, 4, 0);
+  if (mask != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, mask->type, kTfLiteFloat32);
+    const int mask_rank = NumDimensions(mask);
+    TF_LITE_ENSURE(context, mask_rank <= 4);
+    const int scores_shape[4] = {params.batches, params.heads,
+                                 params.query_length, params.key_length};
+    int64_t stride = 1;
+    for (int i = mask_rank - 1; i >= 0; --i) {
+      const int dim = SizeOfDimension(mask, i);
+      const int scores_dim = scores_shape[4 - mask_rank + i];
+      TF_LITE_ENSURE(context, dim == 1 || dim == scores_dim);
+      params.mask_strides[4 - mask_rank + i] = dim == 1 ? 0 : stride;
+      stride *= dim;
+    }
+  }
+
+  if (query->type == kTfLiteInt8) {
+    for (const TfLiteTensor* tensor :
+         {query, key, value, static_cast<const TfLiteTensor*>(output)}) {
+      TF_LITE_ENSURE_EQ(context, tensor->quantization.type,
+                        kTfLiteAffineQuantization);
+      const auto* quantization = static_cast<const TfLiteAffineQuantization*>(
+          tensor->quantization.params);
+      TF_LITE_ENSURE(context, quantization != nullptr &&
+                                  quantization->scale->size == 1);
+      TF_LITE_ENSURE(context, tensor->params.scale > 0.0f);
+    }
+  }
+
+  // Scratch memory for as many threads as the backend context has.
+  TfLiteIntArrayFree(node->temporaries);
+  node->temporaries = TfLiteIntArrayCreate(1);
+  node->temporaries->data[0] = op_data->scratch_tensor_index;
+  TfLiteTensor* scratch_tensor;
+  TF_LITE_ENSURE_OK(
+      context, GetTemporarySafe(context, node, /*index=*/0, &scratch_tensor));
+  scratch_tensor->type = kTfLiteFloat32;
+  scratch_tensor->allocation_type = kTfLiteArenaRw;
+  const int num_threads = std::max(
+      1, CpuBackendContext::GetFromContext(context)->max_num_threads());
+  TfLiteIntArray* scratch_shape = TfLiteIntArrayCreate(2);
+  scratch_shape->data[0] = num_threads;
+  scratch_shape->data[1] = optimized_attention::GetScratchSize(
+      params, /*quantized=*/query->type == kTfLiteInt8);
+  TF_LITE_ENSURE_OK(
+      context, context->ResizeTensor(context, scratch_tensor, scratch_shape));
+
+  TfLiteIntArray* output_shape = TfLiteIntArrayCopy(query->dims);
+  output_shape->data[3] = params.value_depth;
+  return context->ResizeTensor(context, output, output_shape);
+}
+
+optimized_attention::QuantizationParams GetQuantizationParams(
+    const TfLiteTensor* tensor) {
+  optimized_attention::QuantizationParams params;
+  params.scale = tensor->params.scale;
+  params.zero_point = tensor->params.zero_point;
+  return params;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* query;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kQueryTensor, &query));
+  const TfLiteTensor* key;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kKeyTensor, &key));
+  const TfLiteTensor* value;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kValueTensor, &value));
+  const TfLiteTensor* mask = GetOptionalInputTensor(context, node, kMaskTensor);
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+  TfLiteTensor* scratch_tensor;
+  TF_LITE_ENSURE_OK(context,
+                    GetTemporarySafe(context, node, 0, &scratch_tensor));
+
+  optimized_attention::AttentionParams params = op_data->params;
+  params.mask = mask ? GetTensorData<float>(mask) : nullptr;
+  const int num_scratch_slots = SizeOfDimension(scratch_tensor, 0);
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  switch (query->type) {
+    case kTfLiteFloat32:
+      optimized_attention::FusedAttention(
+          params, GetTensorData<float>(query), GetTensorData<float>(key),
+          GetTensorData<float>(value), GetTensorData<float>(output),
+          GetTensorData<float>(scratch_tensor), num_scratch_slots,
+          cpu_backend_context);
+      return kTfLiteOk;
+    case kTfLiteInt8:
+      optimized_attention::FusedAttention(
+          params, GetTensorData<int8_t>(query), GetQuantizationParams(query),
+          GetTensorData<int8_t>(key), GetQuantizationParams(key),
+          GetTensorData<int8_t>(value), GetQuantizationParams(value),
+          GetTensorData<int8_t>(output), GetQuantizationParams(output),
+          GetTensorData<float>(scratch_tensor), num_scratch_slots,
+          cpu_backend_context);
+      return kTfLiteOk;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s is not supported by FusedAttention.",
+                         TfLiteTypeGetName(query->type));
+      return kTfLiteError;
+  }
+}
+
+}  // namespace fused_attention
+
+TfLiteRegistration* Register_FUSED_ATTENTION() {
+  static TfLiteRegistration r = {fused_attention::Init, fused_attention::Free,
+                                 fused_attention::Prepare,
+                                 fused_attention::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,198 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+
+#include <cmath>
+#include <initializer_list>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+
+TfLiteRegistration* Register_FUSED_ATTENTION();
+
+namespace {
+
+using ::testing::ElementsAreArray;
+
+// The logarithm of 3, which makes the softmax of {0, kLog3} {1/4, 3/4}.
+const float kLog3 = std::log(3.0f);
+
+class FusedAttentionOpModel : public SingleOpModel {
+ public:
+  // A scale below zero leaves the scale out of the options.
+  FusedAttentionOpModel(const TensorData& query, const TensorData& key,
+                        const TensorData& value, const TensorData& output,
+                        float scale, bool causal, const TensorData* mask,
+                        bool allocate = true) {
+    query_ = AddInput(query);
+    key_ = AddInput(key);
+    value_ = AddInput(value);
+    if (mask) mask_ = AddInput(*mask);
+    output_ = AddOutput(output);
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      if (scale >= 0.0f) fbb.Float("scale", scale);
+      fbb.Bool("causal", causal);
+    });
+    fbb.Finish();
+    SetCustomOp("FusedAttention", fbb.GetBuffer(), Register_FUSED_ATTENTION);
+    std::vector<std::vector<int>> shapes = {query.shape, key.shape,
+                                            value.shape};
+    if (mask) shapes.push_back(mask->shape);
+    BuildInterpreter(shapes, /*num_threads=*/-1,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/true,
+                     /*allocate_and_delegate=*/allocate);
+  }
+
+  TfLiteStatus AllocateTensors() { return interpreter_->AllocateTensors(); }
+
+  int query() const { return query_; }
+  int key() const { return key_; }
+  int value() const { return value_; }
+  int mask() const { return mask_; }
+  int output() const { return output_; }
+
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int query_;
+  int key_;
+  int value_;
+  int mask_ = -1;
+  int output_;
+};
+
+// Query 0 attends equally to both keys, and query 1 attends with {1/4, 3/4}.
+TEST(FusedAttentionOpTest, Float) {
+  FusedAttentionOpModel m({TensorType_FLOAT32, {1, 1, 2, 1}},
+                          {TensorType_FLOAT32, {1, 1, 2, 1}},
+                          {TensorType_FLOAT32, {1, 1, 2, 2}},
+                          {TensorType_FLOAT32, {}}, /*scale=*/1.0f,
+                          /*causal=*/false, /*mask=*/nullptr);
+  m.PopulateTensor<float>(m.query(), {0.0f, 1.0f});
+  m.PopulateTensor<float>(m.key(), {0.0f, kLog3});
+  m.PopulateTensor<float>(m.value(), {1.0f, 2.0f, 5.0f, 6.0f});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 1, 2, 2}));
+  EXPECT_THAT(m.ExtractVector<float>(m.output()),
+              ElementsAreArray(ArrayFloatNear({3.0f, 4.0f, 4.0f, 5.0f})));
+}
+
+TEST(FusedAttentionOpTest, DefaultScaleIsInverseSqrtDepth) {
+  FusedAttentionOpModel m({TensorType_FLOAT32, {1, 1, 1, 4}},
+                          {TensorType_FLOAT32, {1, 1, 2, 4}},
+                          {TensorType_FLOAT32, {1, 1, 2, 2}},
+                          {TensorType_FLOAT32, {}}, /*scale=*/-1.0f,
+                          /*causal=*/false, /*mask=*/nullptr);
+  m.PopulateTensor<float>(m.query(), {1.0f, 0.0f, 0.0f, 0.0f});
+  m.PopulateTensor<float>(m.key(),
+                          {0.0f, 0.0f, 0.0f, 0.0f, 2 * kLog3, 0.0f, 0.0f, 0.0f});
+  m.PopulateTensor<float>(m.value(), {1.0f, 2.0f, 5.0f, 6.0f});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(m.ExtractVector<float>(m.output()),
+              ElementsAreArray(ArrayFloatNear({4.0f, 5.0f})));
+}
+
+TEST(FusedAttentionOpTest, Causal) {
+  FusedAttentionOpModel m({TensorType_FLOAT32, {1, 1, 2, 1}},
+                          {TensorType_FLOAT32, {1, 1, 2, 1}},
+                          {TensorType_FLOAT32, {1, 1, 2, 2}},
+                          {TensorType_FLOAT32, {}}, /*scale=*/1.0f,
+                          /*causal=*/true, /*mask=*/nullptr);
+  m.PopulateTensor<float>(m.query(), {0.0f, 1.0f});
+  m.PopulateTensor<float>(m.key(), {0.0f, kLog3});
+  m.PopulateTensor<float>(m.value(), {1.0f, 2.0f, 5.0f, 6.0f});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(m.ExtractVector<float>(m.output()),
+              ElementsAreArray(ArrayFloatNear({1.0f, 2.0f, 4.0f, 5.0f})));
+}
+
+// A [query_length, key_length] mask broadcast over the batches and heads.
+TEST(FusedAttentionOpTest, BroadcastMask) {
+  const TensorData mask = {TensorType_FLOAT32, {2, 2}};
+  FusedAttentionOpModel m({TensorType_FLOAT32, {1, 2, 2, 1}},
+                          {TensorType_FLOAT32, {1, 2, 2, 1}},
+                          {TensorType_FLOAT32, {1, 2, 2, 2}},
+                          {TensorType_FLOAT32, {}}, /*scale=*/1.0f,
+                          /*causal=*/false, &mask);
+  m.PopulateTensor<float>(m.query(), {0.0f, 1.0f, 0.0f, 1.0f});
+  m.PopulateTensor<float>(m.key(), {0.0f, kLog3, 0.0f, 0.0f});
+  m.PopulateTensor<float>(m.value(),
+                          {1.0f, 2.0f, 5.0f, 6.0f, 1.0f, 2.0f, 5.0f, 6.0f});
+  m.PopulateTensor<float>(m.mask(), {0.0f, -1e9f, kLog3, 0.0f});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(m.ExtractVector<float>(m.output()),
+              ElementsAreArray(ArrayFloatNear(
+                  {1.0f, 2.0f, 3.0f, 4.0f, 1.0f, 2.0f, 2.0f, 3.0f})));
+}
+
+// Both query heads attend to the single key and value head.
+TEST(FusedAttentionOpTest, GroupedQueryAttention) {
+  FusedAttentionOpModel m({TensorType_FLOAT32, {1, 2, 1, 1}},
+                          {TensorType_FLOAT32, {1, 1, 2, 1}},
+                          {TensorType_FLOAT32, {1, 1, 2, 2}},
+                          {TensorType_FLOAT32, {}}, /*scale=*/1.0f,
+                          /*causal=*/false, /*mask=*/nullptr);
+  m.PopulateTensor<float>(m.query(), {0.0f, 1.0f});
+  m.PopulateTensor<float>(m.key(), {0.0f, kLog3});
+  m.PopulateTensor<float>(m.value(), {1.0f, 2.0f, 5.0f, 6.0f});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 2, 1, 2}));
+  EXPECT_THAT(m.ExtractVector<float>(m.output()),
+              ElementsAreArray(ArrayFloatNear({3.0f, 4.0f, 4.0f, 5.0f})));
+}
+
+TEST(FusedAttentionOpTest, Int8) {
+  FusedAttentionOpModel m({TensorType_INT8, {1, 1, 2, 1}, -2.0f, 2.0f},
+                          {TensorType_INT8, {1, 1, 2, 1}, -2.0f, 2.0f},
+                          {TensorType_INT8, {1, 1, 2, 2}, -8.0f, 8.0f},
+                          {TensorType_INT8, {}, -8.0f, 8.0f}, /*scale=*/1.0f,
+                          /*causal=*/false, /*mask=*/nullptr);
+  m.QuantizeAndPopulate<int8_t>(m.query(), {0.0f, 1.0f});
+  m.QuantizeAndPopulate<int8_t>(m.key(), {0.0f, kLog3});
+  m.QuantizeAndPopulate<int8_t>(m.value(), {1.0f, 2.0f, 5.0f, 6.0f});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(Dequantize<int8_t>(m.ExtractVector<int8_t>(m.output()),
+                                 m.GetScale(m.output()),
+                                 m.GetZeroPoint(m.output())),
+              ElementsAreArray(ArrayFloatNear({3.0f, 4.0f, 4.0f, 5.0f},
+                                              /*max_abs_err=*/0.15f)));
+}
+
+TEST(FusedAttentionOpTest, HeadsNotMultipleOfKeyHeadsFails) {
+  FusedAttentionOpModel m({TensorType_FLOAT32, {1, 3, 1, 1}},
+                          {TensorType_FLOAT32, {1, 2, 1, 1}},
+                          {TensorType_FLOAT32, {1, 2, 1, 1}},
+                          {TensorType_FLOAT32, {}}, /*scale=*/1.0f,
+                          /*causal=*/false, /*mask=*/nullptr,
+                          /*allocate=*/false);
+  EXPECT_EQ(m.AllocateTensors(), kTfLiteError);
+}
+
+}  // namespace
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
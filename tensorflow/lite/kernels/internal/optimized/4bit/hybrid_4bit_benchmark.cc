@@ -0,0 +1,166 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Compares the int4 hybrid kernels of fully_connected_4bit.h with the int8
+// hybrid ones the FullyConnected op uses for the same float weights, reporting
+// the size of the weights, the latency and the error against a float matmul.
+//
+// Usage: hybrid_4bit_benchmark [units] [cols] [num_threads]
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
+
+namespace tflite {
+namespace optimized_4bit {
+namespace {
+
+constexpr int kBatches[] = {1, 4, 16, 64};
+
+// Returns the average time in microseconds of `fn` over about 0.2 seconds.
+template <typename Fn>
+double TimeMicros(Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  fn();
+  int iterations = 0;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point end;
+  do {
+    fn();
+    ++iterations;
+    end = Clock::now();
+  } while (end - start < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+// Returns the largest difference to `expected`, relative to its largest value.
+float RelativeError(const std::vector<float>& expected,
+                    const std::vector<float>& actual) {
+  float max_expected = 0;
+  float max_error = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    max_expected = std::max(max_expected, std::abs(expected[i]));
+    max_error = std::max(max_error, std::abs(expected[i] - actual[i]));
+  }
+  return max_expected == 0 ? max_error : max_error / max_expected;
+}
+
+void Run(int units, int cols, CpuBackendContext* context) {
+  std::mt19937 random_engine(1234);
+  std::normal_distribution<float> value_dist(0.f, 1.f);
+  std::vector<float> weights(units * cols);
+  for (float& weight : weights) weight = value_dist(random_engine);
+
+  // Per-tensor int8 weights, as produced by the weights-only quantizer.
+  std::vector<int8_t> weights_int8(units * cols);
+  float min, max, scale_int8;
+  tensor_utils::SymmetricQuantizeFloats(weights.data(), units * cols,
+                                        weights_int8.data(), &min, &max,
+                                        &scale_int8);
+
+  // Per-channel int4 weights, packed two per byte.
+  std::vector<int8_t> weights_int4(units * cols);
+  std::vector<float> scales_int4(units);
+  for (int row = 0; row < units; ++row) {
+    const float* row_weights = weights.data() + row * cols;
+    float range = 0;
+    for (int col = 0; col < cols; ++col) {
+      range = std::max(range, std::abs(row_weights[col]));
+    }
+    scales_int4[row] = range / 7;
+    for (int col = 0; col < cols; ++col) {
+      const float value =
+          range == 0 ? 0 : std::round(row_weights[col] / scales_int4[row]);
+      weights_int4[row * cols + col] =
+          static_cast<int8_t>(std::min(7.f, std::max(-7.f, value)));
+    }
+  }
+  std::vector<int8_t> packed_int4((units * cols + 1) / 2);
+  tensor_utils::PackInt8IntoDenseInt4(weights_int4.data(), units * cols,
+                                      packed_int4.data());
+
+  for (int batches : kBatches) {
+    std::vector<float> input(batches * cols);
+    for (float& value : input) value = value_dist(random_engine);
+
+    std::vector<float> expected(batches * units, 0.f);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        weights.data(), units, cols, input.data(), batches, expected.data());
+
+    std::vector<int8_t> quantized_input(batches * cols);
+    std::vector<float> scaling_factors(batches);
+    std::vector<int32_t> scratch(batches * units);
+    std::vector<float> output_int8(batches * units);
+    const double int8_micros = TimeMicros([&] {
+      tensor_utils::BatchQuantizeFloats(
+          input.data(), batches, cols, quantized_input.data(),
+          scaling_factors.data(), /*zero_points=*/nullptr,
+          /*do_asymmetric=*/false);
+      for (float& scaling_factor : scaling_factors) {
+        scaling_factor *= scale_int8;
+      }
+      std::fill(output_int8.begin(), output_int8.end(), 0.f);
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          weights_int8.data(), units, cols, quantized_input.data(),
+          scaling_factors.data(), batches, scratch.data(), output_int8.data(),
+          context);
+    });
+
+    HybridMatMulData4Bit data;
+    std::vector<float> output_int4(batches * units);
+    const double int4_micros = TimeMicros([&] {
+      api::HybridMatMul(&data, packed_int4.data(), scales_int4.data(), units,
+                        units, cols, input.data(), batches, /*bias=*/nullptr,
+                        output_int4.data());
+    });
+
+    printf("%8d %12.1f %12.1f %8.2fx %10.4f %10.4f\n", batches, int8_micros,
+           int4_micros, int8_micros / int4_micros,
+           RelativeError(expected, output_int8),
+           RelativeError(expected, output_int4));
+  }
+}
+
+}  // namespace
+}  // namespace optimized_4bit
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  const int units = argc > 1 ? atoi(argv[1]) : 2048;
+  const int cols = argc > 2 ? atoi(argv[2]) : 2048;
+  const int num_threads = argc > 3 ? atoi(argv[3]) : 1;
+  if (cols % 2 != 0) {
+    fprintf(stderr, "cols must be even to pack int4 weights.\n");
+    return 1;
+  }
+  tflite::CpuBackendContext context;
+  context.SetMaxNumThreads(num_threads);
+  printf("%d x %d weights, %d thread(s)\n", units, cols, num_threads);
+  printf("weights: int8 %d bytes, int4 %d bytes\n", units * cols,
+         (units * cols + 1) / 2);
+  printf("%8s %12s %12s %9s %10s %10s\n", "batches", "int8 (us)", "int4 (us)",
+         "speedup", "int8 err", "int4 err");
+  tflite::optimized_4bit::Run(units, cols, &context);
+  return 0;
+}
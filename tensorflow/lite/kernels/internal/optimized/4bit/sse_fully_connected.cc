@@ -29,6 +29,13 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/cppmath.h"
 #include "tensorflow/lite/kernels/internal/optimized/4bit/fully_connected_common.h"
 #include "tensorflow/lite/kernels/internal/optimized/4bit/sse_fully_connected_impl.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
+
+#if defined(__GNUC__)
+#define FC_4BIT_AVX2
+#include <immintrin.h>
+#define FC_4BIT_AVX2_TARGET __attribute__((target("avx2")))
+#endif
 
 namespace tflite {
 namespace optimized_4bit {
@@ -310,11 +317,94 @@ inline __m128i ReduceInt32x4x4(__m128i a, __m128i b, __m128i c, __m128i d) {
   return _mm_add_epi32(all_evns, all_odds);    // [a0123, b0123, c0123, d0123]
 }
 
+#ifdef FC_4BIT_AVX2
+
+FC_4BIT_AVX2_TARGET inline __m256i DotProdInt8x4x8(__m256i acc_32x8,
+                                                   __m256i a_8x32,
+                                                   __m256i b_8x32) {
+  b_8x32 = _mm256_sign_epi8(b_8x32, a_8x32);
+  a_8x32 = _mm256_abs_epi8(a_8x32);
+  __m256i sumprod_16x16 = _mm256_maddubs_epi16(a_8x32, b_8x32);
+  return _mm256_add_epi32(
+      acc_32x8, _mm256_madd_epi16(sumprod_16x16, _mm256_set1_epi16(1)));
+}
+
+FC_4BIT_AVX2_TARGET inline __m128i AddHalves(__m256i a) {
+  return _mm_add_epi32(_mm256_castsi256_si128(a),
+                       _mm256_extracti128_si256(a, 1));
+}
+
+// Same as SseRunKernel, with the 32 values of each depth block in one
+// register: the upper nibbles of lhs in the low half, for the first 16
+// values of rhs, and the lower nibbles in the high half, for the last 16.
+template <int RowsLeft, int RowsRight, int Cols>
+FC_4BIT_AVX2_TARGET void Avx2RunKernel(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols) {
+  const int clamped_end_row = std::min(lhs_layout_rows, dst_layout_cols);
+  const int clamped_end_col = std::min(rhs_layout_rows, dst_layout_rows);
+  int32_t* elementPtr = dst;
+  const int outer_rows = (clamped_end_row + RowsLeft - 1) / RowsLeft;
+  const int outer_cols = (clamped_end_col + RowsRight - 1) / RowsRight;
+  const int depth = std::min(lhs_layout_cols / Cols, rhs_layout_cols / Cols);
+  const __m256i bitmask = _mm256_set1_epi8(15);
+  for (int i = 0; i < outer_rows; ++i) {
+    const uint8_t* lhs_val_data = lhs + i * RowsLeft * lhs_layout_cols / 2;
+    for (int j = 0; j < outer_cols; ++j) {
+      const uint8_t* lhs_val = lhs_val_data;
+      const int8_t* rhs_val = rhs + j * RowsRight * rhs_layout_cols;
+      __m256i accum[RowsRight * RowsLeft];
+      for (int m = 0; m < (RowsLeft * RowsRight); ++m) {
+        accum[m] = _mm256_setzero_si256();
+      }
+      for (int k = 0; k < depth; ++k) {
+        __m256i lhs_row_8[RowsLeft];
+        for (int m = 0; m < RowsLeft; ++m) {
+          const __m256i v = _mm256_broadcastsi128_si256(
+              _mm_loadu_si128((const __m128i*)(lhs_val)));
+          lhs_val += 16;
+          lhs_row_8[m] = _mm256_and_si256(
+              _mm256_blend_epi32(_mm256_srli_epi16(v, 4), v, 0xF0), bitmask);
+        }
+        for (int r = 0; r < RowsRight; ++r) {
+          const __m256i rhs_row =
+              _mm256_loadu_si256((const __m256i*)(rhs_val));
+          rhs_val += 32;
+          for (int l = 0; l < RowsLeft; ++l) {
+            accum[r * RowsLeft + l] =
+                DotProdInt8x4x8(accum[r * RowsLeft + l], lhs_row_8[l], rhs_row);
+          }
+        }
+      }
+      for (int r = 0; r < RowsRight; ++r) {
+        __m128i sum = ReduceInt32x4x4(AddHalves(accum[r * RowsLeft]),
+                                      AddHalves(accum[r * RowsLeft + 1]),
+                                      AddHalves(accum[r * RowsLeft + 2]),
+                                      AddHalves(accum[r * RowsLeft + 3]));
+        _mm_storeu_si128((__m128i*)elementPtr, sum);
+        elementPtr += 4;
+      }
+    }
+  }
+}
+
+#endif  // FC_4BIT_AVX2
+
 template <int RowsLeft, int RowsRight, int Cols>
 void SseRunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
                   int lhs_layout_rows, int lhs_layout_cols, int rhs_layout_rows,
                   int rhs_layout_cols, int dst_layout_rows,
                   int dst_layout_cols) {
+#ifdef FC_4BIT_AVX2
+  static const bool has_avx2 = DetectX86Avx2Fma();
+  if (has_avx2) {
+    Avx2RunKernel<RowsLeft, RowsRight, Cols>(
+        lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+        rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+    return;
+  }
+#endif
   const int start_row = 0;
   const int start_col = 0;
   const int end_row = lhs_layout_rows;
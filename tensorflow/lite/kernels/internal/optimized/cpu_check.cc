@@ -19,6 +19,16 @@ limitations under the License.
 #include <sys/auxv.h>
 #endif
 
+#if defined __x86_64__ && defined __GNUC__
+#define TFLITE_CPU_CHECK_X86_CPUID
+#include <cpuid.h>
+#endif
+
+#if defined TFLITE_CPU_CHECK_X86_CPUID && defined __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace tflite {
 
 namespace {
@@ -37,6 +47,71 @@ bool DetectDotprodByLinuxAuxvMethod() {
 }
 #endif
 
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+// Returns the state components enabled by the OS in XCR0. Uses the raw
+// instruction rather than _xgetbv(), which would need the xsave target.
+unsigned long long ReadXcr0() {  // NOLINT(runtime/int)
+  unsigned int eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) |  // NOLINT(runtime/int)
+         eax;
+}
+
+bool HasOsxsave() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  return ecx & (1u << 27);
+}
+
+bool DetectAvx2FmaByCpuid() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  const bool fma = ecx & (1u << 12);
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool avx2 = ebx & (1u << 5);
+  if (!(avx2 && fma) || !HasOsxsave()) return false;
+  // SSE and AVX state.
+  constexpr unsigned long long kAvxState = 0x6;  // NOLINT(runtime/int)
+  return (ReadXcr0() & kAvxState) == kAvxState;
+}
+
+bool DetectAvx512VnniByCpuid() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool avx512f = ebx & (1u << 16);
+  const bool avx512bw = ebx & (1u << 30);
+  const bool avx512vl = ebx & (1u << 31);
+  const bool avx512vnni = ecx & (1u << 11);
+  if (!(avx512f && avx512bw && avx512vl && avx512vnni) || !HasOsxsave()) {
+    return false;
+  }
+  // SSE, AVX, opmask, ZMM_Hi256 and Hi16_ZMM state.
+  constexpr unsigned long long kAvx512State = 0xe6;  // NOLINT(runtime/int)
+  return (ReadXcr0() & kAvx512State) == kAvx512State;
+}
+
+bool DetectAmxInt8ByCpuid() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool amx_tile = edx & (1u << 24);
+  const bool amx_int8 = edx & (1u << 25);
+  if (!(amx_tile && amx_int8) || !HasOsxsave()) return false;
+  // XTILECFG and XTILEDATA state.
+  constexpr unsigned long long kAmxState = 0x60000;  // NOLINT(runtime/int)
+  if ((ReadXcr0() & kAmxState) != kAmxState) return false;
+#ifdef __linux__
+  // Linux only hands out the (large) tile data state to processes asking for
+  // it. These are the values of ARCH_REQ_XCOMP_PERM and XFEATURE_XTILEDATA,
+  // which older headers don't define.
+  constexpr int kArchReqXcompPerm = 0x1023;
+  constexpr int kXfeatureXtiledata = 18;
+  return syscall(SYS_arch_prctl, kArchReqXcompPerm, kXfeatureXtiledata) == 0;
+#else
+  return false;
+#endif
+}
+#endif  // TFLITE_CPU_CHECK_X86_CPUID
+
 }  // namespace
 
 bool DetectArmNeonDotprod() {
@@ -47,4 +122,31 @@ bool DetectArmNeonDotprod() {
   return false;
 }
 
+bool DetectX86Avx2Fma() {
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+  static const bool avx2_fma = DetectAvx2FmaByCpuid();
+  return avx2_fma;
+#endif
+
+  return false;
+}
+
+bool DetectX86Avx512Vnni() {
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+  static const bool avx512_vnni = DetectAvx512VnniByCpuid();
+  return avx512_vnni;
+#endif
+
+  return false;
+}
+
+bool DetectX86AmxInt8() {
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+  static const bool amx_int8 = DetectAmxInt8ByCpuid();
+  return amx_int8;
+#endif
+
+  return false;
+}
+
 }  // namespace tflite
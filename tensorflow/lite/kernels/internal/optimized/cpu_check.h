@@ -27,12 +27,33 @@ namespace tflite {
 // On other architectures, returns false unconditionally.
 bool DetectArmNeonDotprod();
 
+// On x86-64, returns true if the CPU supports AVX2 and FMA and the OS saves
+// the AVX registers.
+// On other architectures, returns false unconditionally.
+bool DetectX86Avx2Fma();
+
+// On x86-64, returns true if the CPU supports AVX-512 VNNI (along with
+// AVX-512 F, BW and VL) and the OS saves the AVX-512 registers.
+// On other architectures, returns false unconditionally.
+bool DetectX86Avx512Vnni();
+
+// On x86-64 Linux, returns true if the CPU supports AMX int8 tiles and the OS
+// granted this process the use of them.
+// On other platforms, returns false unconditionally.
+bool DetectX86AmxInt8();
+
 struct CpuFlags {
   bool neon_dotprod = false;
+  bool avx2_fma = false;
+  bool avx512_vnni = false;
+  bool amx_int8 = false;
 };
 
 inline void GetCpuFlags(CpuFlags* cpu_flags) {
   cpu_flags->neon_dotprod = DetectArmNeonDotprod();
+  cpu_flags->avx2_fma = DetectX86Avx2Fma();
+  cpu_flags->avx512_vnni = DetectX86Avx512Vnni();
+  cpu_flags->amx_int8 = DetectX86AmxInt8();
 }
 
 }  // namespace tflite
@@ -0,0 +1,310 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/embedding_lookup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace optimized_embedding {
+namespace {
+
+// How many lookups ahead the rows are prefetched. Enough to cover the latency
+// of DRAM with the time to copy or dequantize rows of a few hundred bytes.
+constexpr int kPrefetchDistance = 16;
+constexpr size_t kCacheLineSize = 64;
+// The lookups are split across threads only if each thread reads at least
+// this many bytes of rows.
+constexpr size_t kMinBytesPerThread = 1 << 16;
+
+void PrefetchRow(const char* row, size_t row_bytes) {
+  for (size_t i = 0; i < row_bytes; i += kCacheLineSize) {
+    optimized_ops_preload_l1_keep(row + i);
+  }
+}
+
+// Bytes spanned by a row of `table`. Rows of int4 tables with an odd number
+// of values may start in the middle of a byte.
+size_t GetRowBytes(const EmbeddingTable& table) {
+  switch (table.type) {
+    case kTfLiteFloat32:
+      return table.row_size * sizeof(float);
+    case kTfLiteInt4:
+      return table.row_size / 2 + 1;
+    default:
+      return table.row_size;
+  }
+}
+
+const char* GetRow(const EmbeddingTable& table, int row) {
+  const char* data = static_cast<const char*>(table.data);
+  switch (table.type) {
+    case kTfLiteFloat32:
+      return data + static_cast<size_t>(row) * table.row_size * sizeof(float);
+    case kTfLiteInt4:
+      return data + static_cast<size_t>(row) * table.row_size / 2;
+    default:
+      return data + static_cast<size_t>(row) * table.row_size;
+  }
+}
+
+// Sign-extends the low nibble of `byte`.
+int8_t LowNibble(int8_t byte) {
+  return static_cast<int8_t>(static_cast<uint8_t>(byte) << 4) >> 4;
+}
+
+template <bool kAccumulate>
+void Store(float value, float* output) {
+  if (kAccumulate) {
+    *output += value;
+  } else {
+    *output = value;
+  }
+}
+
+// Writes, or adds if `kAccumulate`, row `row` of `table` times `weight` to
+// `output`.
+template <bool kAccumulate>
+void DequantizeRow(const EmbeddingTable& table, int row, float weight,
+                   float* output) {
+  const int row_size = table.row_size;
+  const char* row_data = GetRow(table, row);
+  if (table.type == kTfLiteFloat32) {
+    const float* values = reinterpret_cast<const float*>(row_data);
+    for (int i = 0; i < row_size; ++i) {
+      Store<kAccumulate>(values[i] * weight, &output[i]);
+    }
+    return;
+  }
+  const float multiplier =
+      weight * table.scales[table.num_scales == table.num_rows ? row : 0];
+  const int8_t* values = reinterpret_cast<const int8_t*>(row_data);
+  if (table.type == kTfLiteInt8) {
+    for (int i = 0; i < row_size; ++i) {
+      Store<kAccumulate>(values[i] * multiplier, &output[i]);
+    }
+    return;
+  }
+  // Int4, where the row starts in the high nibble of its first byte if the
+  // previous rows have an odd number of values.
+  int i = 0;
+  if (static_cast<int64_t>(row) * row_size % 2 != 0) {
+    Store<kAccumulate>((*values++ >> 4) * multiplier, &output[i++]);
+  }
+  for (; i + 1 < row_size; i += 2) {
+    const int8_t value = *values++;
+    Store<kAccumulate>(LowNibble(value) * multiplier, &output[i]);
+    Store<kAccumulate>((value >> 4) * multiplier, &output[i + 1]);
+  }
+  if (i < row_size) {
+    Store<kAccumulate>(LowNibble(*values) * multiplier, &output[i]);
+  }
+}
+
+template <typename Fn>
+class RangeTask : public cpu_backend_threadpool::Task {
+ public:
+  RangeTask(const Fn& fn, int begin, int end)
+      : fn_(fn), begin_(begin), end_(end) {}
+
+  void Run() override { fn_(begin_, end_); }
+
+ private:
+  const Fn& fn_;
+  int begin_;
+  int end_;
+};
+
+// Calls `fn` on contiguous ranges of [0, `num_items`), on as many threads of
+// `cpu_backend_context` as `total_bytes` read from the table are worth.
+template <typename Fn>
+void ParallelFor(int num_items, size_t total_bytes,
+                 CpuBackendContext* cpu_backend_context, const Fn& fn) {
+  int thread_count = 1;
+  if (cpu_backend_context != nullptr) {
+    thread_count = std::max<int64_t>(
+        1, std::min<int64_t>(
+               {cpu_backend_context->max_num_threads(),
+                static_cast<int64_t>(total_bytes / kMinBytesPerThread),
+                num_items}));
+  }
+  if (thread_count == 1) {
+    fn(0, num_items);
+    return;
+  }
+  std::vector<RangeTask<Fn>> tasks;
+  tasks.reserve(thread_count);
+  int begin = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    const int end = begin + num_items / thread_count +
+                    (i < num_items % thread_count ? 1 : 0);
+    tasks.emplace_back(fn, begin, end);
+    begin = end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+}  // namespace
+
+TfLiteStatus GetEmbeddingTable(TfLiteContext* context,
+                               const TfLiteTensor* value,
+                               EmbeddingTable* table) {
+  TF_LITE_ENSURE(context, NumDimensions(value) >= 2);
+  table->type = value->type == kTfLiteUInt8 ? kTfLiteInt8 : value->type;
+  table->data = value->data.raw_const;
+  table->num_rows = SizeOfDimension(value, 0);
+  table->row_size = table->num_rows == 0 ? 0 : NumElements(value) /
+                                                  table->num_rows;
+  table->scales = nullptr;
+  table->num_scales = 0;
+  switch (table->type) {
+    case kTfLiteFloat32:
+      return kTfLiteOk;
+    case kTfLiteInt8:
+    case kTfLiteInt4:
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s of embeddings not supported.",
+                         TfLiteTypeGetName(value->type));
+      return kTfLiteError;
+  }
+  if (value->quantization.type == kTfLiteAffineQuantization &&
+      value->quantization.params != nullptr) {
+    const auto* params = static_cast<const TfLiteAffineQuantization*>(
+        value->quantization.params);
+    TF_LITE_ENSURE(context, params->scale != nullptr);
+    table->scales = params->scale->data;
+    table->num_scales = params->scale->size;
+    if (table->num_scales > 1) {
+      TF_LITE_ENSURE_EQ(context, params->quantized_dimension, 0);
+      TF_LITE_ENSURE_EQ(context, table->num_scales, table->num_rows);
+    }
+  } else {
+    table->scales = &value->params.scale;
+    table->num_scales = 1;
+  }
+  TF_LITE_ENSURE(context, table->num_scales > 0);
+  return kTfLiteOk;
+}
+
+void GatherRows(const char* table, size_t row_bytes, const int32_t* ids,
+                int num_ids, char* output,
+                CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("EmbeddingLookup/GatherRows");
+  ParallelFor(num_ids, num_ids * row_bytes, cpu_backend_context,
+              [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                  if (i + kPrefetchDistance < end) {
+                    PrefetchRow(table + ids[i + kPrefetchDistance] * row_bytes,
+                                row_bytes);
+                  }
+                  std::memcpy(output + i * row_bytes,
+                              table + ids[i] * row_bytes, row_bytes);
+                }
+              });
+}
+
+void GatherRows(const EmbeddingTable& table, const int32_t* ids, int num_ids,
+                float* output, CpuBackendContext* cpu_backend_context) {
+  if (table.type == kTfLiteFloat32) {
+    GatherRows(static_cast<const char*>(table.data),
+               table.row_size * sizeof(float), ids, num_ids,
+               reinterpret_cast<char*>(output), cpu_backend_context);
+    return;
+  }
+  ruy::profiler::ScopeLabel label("EmbeddingLookup/DequantizeRows");
+  const size_t row_bytes = GetRowBytes(table);
+  ParallelFor(num_ids, num_ids * row_bytes, cpu_backend_context,
+              [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                  if (i + kPrefetchDistance < end) {
+                    PrefetchRow(GetRow(table, ids[i + kPrefetchDistance]),
+                                row_bytes);
+                  }
+                  DequantizeRow</*kAccumulate=*/false>(
+                      table, ids[i], 1.0f,
+                      output + static_cast<size_t>(i) * table.row_size);
+                }
+              });
+}
+
+void CombineBags(const EmbeddingTable& table, const int32_t* ids,
+                 const float* weights, const int32_t* bag_offsets,
+                 const int32_t* bag_output_rows, int num_bags,
+                 Combiner combiner, float* output,
+                 CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("EmbeddingLookup/CombineBags");
+  if (num_bags == 0) return;
+  const size_t row_bytes = GetRowBytes(table);
+  auto combine = [&](int begin, int end) {
+    const int end_offset = bag_offsets[end];
+    for (int bag = begin; bag < end; ++bag) {
+      const int bag_begin = bag_offsets[bag];
+      const int bag_end = bag_offsets[bag + 1];
+      if (bag_begin == bag_end) continue;
+      float* bag_output =
+          output + static_cast<size_t>(bag_output_rows ? bag_output_rows[bag]
+                                                       : bag) *
+                       table.row_size;
+      float total_weight = 0.0f;
+      float total_squared_weight = 0.0f;
+      for (int i = bag_begin; i < bag_end; ++i) {
+        // Prefetches across bags, which are often small.
+        if (i + kPrefetchDistance < end_offset) {
+          PrefetchRow(GetRow(table, ids[i + kPrefetchDistance]), row_bytes);
+        }
+        const float weight = weights ? weights[i] : 1.0f;
+        total_weight += weight;
+        total_squared_weight += weight * weight;
+        DequantizeRow</*kAccumulate=*/true>(table, ids[i], weight,
+                                            bag_output);
+      }
+      if (combiner == Combiner::kSum) continue;
+      const float divisor = combiner == Combiner::kMean
+                                ? total_weight
+                                : std::sqrt(total_squared_weight);
+      for (int i = 0; i < table.row_size; ++i) bag_output[i] /= divisor;
+    }
+  };
+  // Bags sharing output rows must run in order.
+  bool ordered_output_rows = true;
+  for (int bag = 1; bag_output_rows && bag < num_bags; ++bag) {
+    if (bag_output_rows[bag] <= bag_output_rows[bag - 1]) {
+      ordered_output_rows = false;
+      break;
+    }
+  }
+  if (!ordered_output_rows) {
+    combine(0, num_bags);
+    return;
+  }
+  ParallelFor(num_bags, (bag_offsets[num_bags] - bag_offsets[0]) * row_bytes,
+              cpu_backend_context, combine);
+}
+
+}  // namespace optimized_embedding
+}  // namespace tflite
@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_EMBEDDING_LOOKUP_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_EMBEDDING_LOOKUP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+
+namespace tflite {
+namespace optimized_embedding {
+
+// Gathers rows of embedding tables for EMBEDDING_LOOKUP and
+// EMBEDDING_LOOKUP_SPARSE. Lookups in large tables are bound by the latency
+// of the random accesses to the rows, so the rows are prefetched a few
+// lookups ahead, and the lookups are split across the threads of the CPU
+// backend context.
+
+// A table of `num_rows` rows of `row_size` values, stored row-major.
+struct EmbeddingTable {
+  // kTfLiteFloat32, or kTfLiteInt8 or kTfLiteInt4 symmetrically quantized.
+  // Int4 values are packed two per byte, the first in the low nibble, as
+  // UnpackDenseInt4IntoInt8() expects.
+  TfLiteType type = kTfLiteFloat32;
+  const void* data = nullptr;
+  int num_rows = 0;
+  int row_size = 0;
+  // Scales of quantized tables: one per row if `num_scales` == `num_rows`,
+  // otherwise one for the whole table.
+  const float* scales = nullptr;
+  int num_scales = 0;
+};
+
+// Returns in `table` the table held by `value`, whose first dimension indexes
+// the rows. Quantized tables must be quantized per tensor or per row, i.e.
+// along dimension 0. For compatibility with older hybrid models, uint8 tables
+// hold int8 values.
+TfLiteStatus GetEmbeddingTable(TfLiteContext* context,
+                               const TfLiteTensor* value,
+                               EmbeddingTable* table);
+
+// Copies rows `ids` of a table of rows of `row_bytes` bytes to consecutive
+// rows of `output`. The ids must be valid.
+void GatherRows(const char* table, size_t row_bytes, const int32_t* ids,
+                int num_ids, char* output,
+                CpuBackendContext* cpu_backend_context);
+
+// Same as above, dequantizing the rows of quantized tables.
+void GatherRows(const EmbeddingTable& table, const int32_t* ids, int num_ids,
+                float* output, CpuBackendContext* cpu_backend_context);
+
+enum class Combiner { kSum, kMean, kSqrtN };
+
+// Combines bags of rows of `table`. Bag `b` is made of rows
+// ids[bag_offsets[b]:bag_offsets[b + 1]], weighted by the same range of
+// `weights`, or by 1 if `weights` is null. The weighted sum of the rows is
+// added to row `bag_output_rows[b]` of `output`, or to row `b` if
+// `bag_output_rows` is null, which is then divided by the sum of the weights
+// for kMean, or by the square root of the sum of their squares for kSqrtN.
+// Empty bags leave their output row untouched.
+//
+// The output rows must be initialized by the caller. Bags sharing an output
+// row are combined one after the other, in order. The ids must be valid.
+void CombineBags(const EmbeddingTable& table, const int32_t* ids,
+                 const float* weights, const int32_t* bag_offsets,
+                 const int32_t* bag_output_rows, int num_bags,
+                 Combiner combiner, float* output,
+                 CpuBackendContext* cpu_backend_context);
+
+}  // namespace optimized_embedding
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_EMBEDDING_LOOKUP_H_
@@ -0,0 +1,221 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Measures the lookups of embedding_lookup.h in a large table with Zipfian
+// ids, as in recommendation models, against the per-row loops the
+// EMBEDDING_LOOKUP and EMBEDDING_LOOKUP_SPARSE kernels used before, for float,
+// int8 and int4 tables.
+//
+// Usage: embedding_lookup_benchmark [rows] [row_size] [num_threads]
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/embedding_lookup.h"
+
+namespace tflite {
+namespace optimized_embedding {
+namespace {
+
+constexpr int kNumLookups = 1 << 16;
+constexpr int kBagSize = 32;
+// Exponent of the Zipfian distribution of the ids.
+constexpr double kZipfExponent = 1.05;
+
+// Returns the average time in microseconds of `fn` over about 0.2 seconds.
+template <typename Fn>
+double TimeMicros(Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  fn();
+  int iterations = 0;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point end;
+  do {
+    fn();
+    ++iterations;
+    end = Clock::now();
+  } while (end - start < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+// Draws ids with Zipfian frequencies by inverting the CDF of a continuous
+// power law, and scatters the ranks over the table so that the frequent rows
+// aren't next to each other.
+std::vector<int32_t> ZipfianIds(int num_ids, int num_rows) {
+  std::mt19937 random_engine(1234);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  const double a = 1.0 - kZipfExponent;
+  const double max_term = std::pow(static_cast<double>(num_rows), a);
+  std::vector<int32_t> ids(num_ids);
+  for (int32_t& id : ids) {
+    const double rank =
+        std::pow((max_term - 1.0) * uniform(random_engine) + 1.0, 1.0 / a);
+    const uint64_t scattered =
+        static_cast<uint64_t>(rank - 1.0) * 2654435761ull;
+    id = static_cast<int32_t>(scattered % num_rows);
+  }
+  return ids;
+}
+
+// The loop of the kernels before embedding_lookup.h, without prefetching or
+// threads.
+void NaiveGather(const EmbeddingTable& table, const std::vector<int32_t>& ids,
+                 float* output) {
+  const int row_size = table.row_size;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    const size_t offset = static_cast<size_t>(ids[i]) * row_size;
+    float* row_output = output + i * row_size;
+    const float scale =
+        table.scales
+            ? table.scales[table.num_scales == table.num_rows ? ids[i] : 0]
+            : 1.0f;
+    if (table.type == kTfLiteFloat32) {
+      std::memcpy(row_output, static_cast<const float*>(table.data) + offset,
+                  row_size * sizeof(float));
+    } else if (table.type == kTfLiteInt8) {
+      const int8_t* values = static_cast<const int8_t*>(table.data) + offset;
+      for (int j = 0; j < row_size; ++j) row_output[j] = values[j] * scale;
+    } else {
+      const int8_t* values = static_cast<const int8_t*>(table.data);
+      for (int j = 0; j < row_size; ++j) {
+        const int8_t byte = values[(offset + j) / 2];
+        const int value = (offset + j) % 2 == 0
+                              ? static_cast<int8_t>(
+                                    static_cast<uint8_t>(byte) << 4) >> 4
+                              : byte >> 4;
+        row_output[j] = value * scale;
+      }
+    }
+  }
+}
+
+void Run(const char* type_name, const EmbeddingTable& table,
+         const std::vector<int32_t>& ids, CpuBackendContext* single_thread,
+         CpuBackendContext* multi_thread) {
+  std::vector<float> output(static_cast<size_t>(ids.size()) * table.row_size);
+  const double naive_micros =
+      TimeMicros([&] { NaiveGather(table, ids, output.data()); });
+  const double single_micros = TimeMicros([&] {
+    GatherRows(table, ids.data(), ids.size(), output.data(), single_thread);
+  });
+  const double multi_micros = TimeMicros([&] {
+    GatherRows(table, ids.data(), ids.size(), output.data(), multi_thread);
+  });
+  printf("%-6s %-8s %14.2f %14.2f %14.2f\n", type_name, "gather",
+         ids.size() / naive_micros, ids.size() / single_micros,
+         ids.size() / multi_micros);
+
+  // Bags of kBagSize ids, pooled with weights.
+  const int num_bags = ids.size() / kBagSize;
+  std::vector<int32_t> bag_offsets(num_bags + 1);
+  for (int i = 0; i <= num_bags; ++i) bag_offsets[i] = i * kBagSize;
+  const std::vector<float> weights(ids.size(), 0.5f);
+  std::vector<float> bag_output(static_cast<size_t>(num_bags) *
+                                table.row_size);
+  const double naive_pool_micros = TimeMicros([&] {
+    // Gathers, then sums the rows of each bag.
+    NaiveGather(table, ids, output.data());
+    std::fill(bag_output.begin(), bag_output.end(), 0.0f);
+    for (size_t i = 0; i < ids.size(); ++i) {
+      float* row_output = bag_output.data() + (i / kBagSize) * table.row_size;
+      for (int j = 0; j < table.row_size; ++j) {
+        row_output[j] += weights[i] * output[i * table.row_size + j];
+      }
+    }
+  });
+  const auto combine = [&](CpuBackendContext* context) {
+    std::fill(bag_output.begin(), bag_output.end(), 0.0f);
+    CombineBags(table, ids.data(), weights.data(), bag_offsets.data(),
+                /*bag_output_rows=*/nullptr, num_bags, Combiner::kSum,
+                bag_output.data(), context);
+  };
+  const double single_pool_micros =
+      TimeMicros([&] { combine(single_thread); });
+  const double multi_pool_micros = TimeMicros([&] { combine(multi_thread); });
+  printf("%-6s %-8s %14.2f %14.2f %14.2f\n", type_name, "sum bags",
+         ids.size() / naive_pool_micros, ids.size() / single_pool_micros,
+         ids.size() / multi_pool_micros);
+}
+
+template <typename T>
+std::vector<T> RandomValues(size_t size) {
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<int> value_dist(-127, 127);
+  std::vector<T> values(size);
+  for (T& value : values) value = value_dist(random_engine);
+  return values;
+}
+
+void RunAll(int rows, int row_size, CpuBackendContext* single_thread,
+            CpuBackendContext* multi_thread) {
+  const std::vector<int32_t> ids = ZipfianIds(kNumLookups, rows);
+  const size_t num_values = static_cast<size_t>(rows) * row_size;
+  EmbeddingTable table;
+  table.num_rows = rows;
+  table.row_size = row_size;
+  {
+    const std::vector<float> values = RandomValues<float>(num_values);
+    table.type = kTfLiteFloat32;
+    table.data = values.data();
+    Run("float", table, ids, single_thread, multi_thread);
+  }
+  std::vector<float> scales(rows, 0.01f);
+  table.scales = scales.data();
+  table.num_scales = rows;
+  {
+    const std::vector<int8_t> values = RandomValues<int8_t>(num_values);
+    table.type = kTfLiteInt8;
+    table.data = values.data();
+    Run("int8", table, ids, single_thread, multi_thread);
+  }
+  {
+    const std::vector<int8_t> values =
+        RandomValues<int8_t>((num_values + 1) / 2);
+    table.type = kTfLiteInt4;
+    table.data = values.data();
+    Run("int4", table, ids, single_thread, multi_thread);
+  }
+}
+
+}  // namespace
+}  // namespace optimized_embedding
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  const int rows = argc > 1 ? atoi(argv[1]) : 10000000;
+  const int row_size = argc > 2 ? atoi(argv[2]) : 64;
+  const int num_threads = argc > 3 ? atoi(argv[3]) : 4;
+  tflite::CpuBackendContext single_thread;
+  single_thread.SetMaxNumThreads(1);
+  tflite::CpuBackendContext multi_thread;
+  multi_thread.SetMaxNumThreads(num_threads);
+  printf("%d x %d table, %d Zipfian lookups, bags of %d, %d thread(s)\n",
+         rows, row_size, tflite::optimized_embedding::kNumLookups,
+         tflite::optimized_embedding::kBagSize, num_threads);
+  printf("%-6s %-8s %14s %14s %14s\n", "type", "op", "naive (M/s)",
+         "1 thread (M/s)", "threads (M/s)");
+  tflite::optimized_embedding::RunAll(rows, row_size, &single_thread,
+                                      &multi_thread);
+  return 0;
+}
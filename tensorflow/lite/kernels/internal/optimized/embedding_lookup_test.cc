@@ -0,0 +1,221 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/embedding_lookup.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+
+namespace tflite {
+namespace optimized_embedding {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+// A random table of `num_rows` x `row_size` values of type `type`, with the
+// float values it holds.
+class RandomTable {
+ public:
+  RandomTable(TfLiteType type, int num_rows, int row_size, bool per_row,
+              std::mt19937* random_engine)
+      : num_rows_(num_rows), row_size_(row_size) {
+    const int max_value = type == kTfLiteInt4 ? 7 : 127;
+    std::uniform_int_distribution<int> value_dist(-max_value, max_value);
+    std::uniform_real_distribution<float> scale_dist(0.01f, 1.0f);
+    scales_.resize(type == kTfLiteFloat32 ? 0 : per_row ? num_rows : 1);
+    for (float& scale : scales_) scale = scale_dist(*random_engine);
+    const int num_values = num_rows * row_size;
+    values_.resize(num_values);
+    if (type == kTfLiteFloat32) {
+      float_data_.resize(num_values);
+    } else if (type == kTfLiteInt8) {
+      int8_data_.resize(num_values);
+    } else {
+      int8_data_.resize((num_values + 1) / 2);
+    }
+    for (int i = 0; i < num_values; ++i) {
+      const int value = value_dist(*random_engine);
+      const int row = i / row_size;
+      if (type == kTfLiteFloat32) {
+        float_data_[i] = values_[i] = value / 16.0f;
+        continue;
+      }
+      values_[i] = value * scales_[per_row ? row : 0];
+      if (type == kTfLiteInt8) {
+        int8_data_[i] = value;
+      } else {
+        int8_data_[i / 2] |= (value & 0xf) << (i % 2 == 0 ? 0 : 4);
+      }
+    }
+    table_.type = type;
+    table_.data = type == kTfLiteFloat32
+                      ? static_cast<const void*>(float_data_.data())
+                      : static_cast<const void*>(int8_data_.data());
+    table_.num_rows = num_rows;
+    table_.row_size = row_size;
+    table_.scales = scales_.data();
+    table_.num_scales = scales_.size();
+  }
+
+  const EmbeddingTable& table() const { return table_; }
+  float value(int row, int i) const { return values_[row * row_size_ + i]; }
+
+ private:
+  int num_rows_;
+  int row_size_;
+  std::vector<float> values_;
+  std::vector<float> float_data_;
+  std::vector<int8_t> int8_data_;
+  std::vector<float> scales_;
+  EmbeddingTable table_;
+};
+
+std::vector<int32_t> RandomIds(int num_ids, int num_rows,
+                               std::mt19937* random_engine) {
+  std::uniform_int_distribution<int32_t> id_dist(0, num_rows - 1);
+  std::vector<int32_t> ids(num_ids);
+  for (int32_t& id : ids) id = id_dist(*random_engine);
+  return ids;
+}
+
+struct TableParam {
+  TfLiteType type;
+  bool per_row;
+};
+
+class EmbeddingLookupTest : public ::testing::TestWithParam<TableParam> {
+ protected:
+  EmbeddingLookupTest() { cpu_backend_context_.SetMaxNumThreads(4); }
+
+  std::mt19937 random_engine_{42};
+  CpuBackendContext cpu_backend_context_;
+};
+
+TEST_P(EmbeddingLookupTest, GatherRows) {
+  // An odd row size makes every other int4 row start in the middle of a byte.
+  constexpr int kNumRows = 1000;
+  constexpr int kRowSize = 67;
+  const RandomTable table(GetParam().type, kNumRows, kRowSize,
+                          GetParam().per_row, &random_engine_);
+  for (int num_ids : {0, 1, 10, 5000}) {
+    const std::vector<int32_t> ids =
+        RandomIds(num_ids, kNumRows, &random_engine_);
+    std::vector<float> expected;
+    for (int32_t id : ids) {
+      for (int i = 0; i < kRowSize; ++i) expected.push_back(table.value(id, i));
+    }
+    std::vector<float> output(num_ids * kRowSize);
+    GatherRows(table.table(), ids.data(), num_ids, output.data(),
+               &cpu_backend_context_);
+    EXPECT_THAT(output, Pointwise(FloatNear(1e-5), expected));
+  }
+}
+
+TEST_P(EmbeddingLookupTest, CombineBags) {
+  constexpr int kNumRows = 1000;
+  constexpr int kRowSize = 33;
+  constexpr int kNumBags = 500;
+  const RandomTable table(GetParam().type, kNumRows, kRowSize,
+                          GetParam().per_row, &random_engine_);
+  std::uniform_int_distribution<int> bag_size_dist(0, 20);
+  std::uniform_real_distribution<float> weight_dist(0.5f, 2.0f);
+  std::vector<int32_t> bag_offsets = {0};
+  for (int bag = 0; bag < kNumBags; ++bag) {
+    bag_offsets.push_back(bag_offsets.back() + bag_size_dist(random_engine_));
+  }
+  const int num_ids = bag_offsets.back();
+  const std::vector<int32_t> ids =
+      RandomIds(num_ids, kNumRows, &random_engine_);
+  std::vector<float> weights(num_ids);
+  for (float& weight : weights) weight = weight_dist(random_engine_);
+
+  for (Combiner combiner :
+       {Combiner::kSum, Combiner::kMean, Combiner::kSqrtN}) {
+    std::vector<float> expected(kNumBags * kRowSize, 0.0f);
+    for (int bag = 0; bag < kNumBags; ++bag) {
+      float total_weight = 0.0f;
+      float total_squared_weight = 0.0f;
+      for (int j = bag_offsets[bag]; j < bag_offsets[bag + 1]; ++j) {
+        total_weight += weights[j];
+        total_squared_weight += weights[j] * weights[j];
+        for (int i = 0; i < kRowSize; ++i) {
+          expected[bag * kRowSize + i] += weights[j] * table.value(ids[j], i);
+        }
+      }
+      if (combiner == Combiner::kSum || total_weight == 0.0f) continue;
+      const float divisor = combiner == Combiner::kMean
+                                ? total_weight
+                                : std::sqrt(total_squared_weight);
+      for (int i = 0; i < kRowSize; ++i) {
+        expected[bag * kRowSize + i] /= divisor;
+      }
+    }
+    std::vector<float> output(kNumBags * kRowSize, 0.0f);
+    CombineBags(table.table(), ids.data(), weights.data(), bag_offsets.data(),
+                /*bag_output_rows=*/nullptr, kNumBags, combiner, output.data(),
+                &cpu_backend_context_);
+    EXPECT_THAT(output, Pointwise(FloatNear(1e-3), expected));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    EmbeddingLookupTest, EmbeddingLookupTest,
+    ::testing::Values(TableParam{kTfLiteFloat32, false},
+                      TableParam{kTfLiteInt8, false},
+                      TableParam{kTfLiteInt8, true},
+                      TableParam{kTfLiteInt4, false},
+                      TableParam{kTfLiteInt4, true}));
+
+TEST(EmbeddingLookupTest, CombineBagsSharingOutputRows) {
+  const std::vector<float> values = {1, 2, 3, 4, 5, 6};
+  EmbeddingTable table;
+  table.data = values.data();
+  table.num_rows = 3;
+  table.row_size = 2;
+  // Bag 0 is {rows 0, 1} into output row 1, bag 1 is {row 2} into output row
+  // 0, and bag 2 is {row 2} into output row 1 again.
+  const std::vector<int32_t> ids = {0, 1, 2, 2};
+  const std::vector<float> weights = {1, 3, 2, 1};
+  const std::vector<int32_t> bag_offsets = {0, 2, 3, 4};
+  const std::vector<int32_t> bag_output_rows = {1, 0, 1};
+  std::vector<float> output(4, 0.0f);
+  CombineBags(table, ids.data(), weights.data(), bag_offsets.data(),
+              bag_output_rows.data(), 3, Combiner::kMean, output.data(),
+              /*cpu_backend_context=*/nullptr);
+  // Output row 1 is ((1 * row 0 + 3 * row 1) / 4 + row 2) / 1.
+  EXPECT_THAT(output, Pointwise(FloatNear(1e-6), {5.0f, 6.0f, 7.5f, 9.5f}));
+}
+
+TEST(EmbeddingLookupTest, GatherRawRows) {
+  const std::vector<int16_t> values = {1, 2, 3, 4, 5, 6};
+  const std::vector<int32_t> ids = {2, 0, 2};
+  std::vector<int16_t> output(6);
+  GatherRows(reinterpret_cast<const char*>(values.data()), 2 * sizeof(int16_t),
+             ids.data(), ids.size(), reinterpret_cast<char*>(output.data()),
+             /*cpu_backend_context=*/nullptr);
+  EXPECT_THAT(output, ElementsAreArray({5, 6, 1, 2, 5, 6}));
+}
+
+}  // namespace
+}  // namespace optimized_embedding
+}  // namespace tflite
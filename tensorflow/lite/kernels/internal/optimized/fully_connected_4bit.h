@@ -19,10 +19,13 @@ limitations under the License.
 
 #ifndef TFLITE_MMAP_DISABLED
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 #include <memory>
+#include <vector>
 
 #if defined(FC_4BIT_SSE) && defined(__SSSE3__)
 #include "tensorflow/lite/kernels/internal/optimized/4bit/sse_fully_connected.h"
@@ -86,6 +89,18 @@ struct OpData4Bit {
   }
 };
 
+// State of a float x int4 matmul with constant weights, for the ops other
+// than FullyConnected that run on the kernels below. The quantized input and
+// the accumulators are kept between calls instead of in arena temporaries.
+struct HybridMatMulData4Bit : OpData4Bit {
+  // Scale of each row of the weights, padded to the rows of the layout.
+  std::vector<float> filter_scales;
+  std::vector<int8_t> input_quantized;
+  std::vector<float> scaling_factors;
+  std::vector<int32_t> input_offsets;
+  std::vector<int32_t> accum_scratch;
+};
+
 namespace api {
 /* Prepack lhs matrix into dest.
  * Transform tensor from (src_rows, src_cols) to
@@ -145,6 +160,97 @@ inline void RunAndUnpack(int rhs_width, const uint8_t* lhs, const int8_t* rhs,
       dst_layout_cols, output_ptr, scaling_factors, filter_scales);
 }
 
+/* Hint that the pages of the `size` bytes at `data`, weights from the model
+ * file that have been prepacked, can be reclaimed since they will not be read
+ * anymore.
+ *
+ * This is Linux specific. There is no effect on other platforms (e.g. on
+ * Windows, but possibly other POSIX platforms!). It requires a minimum
+ * Kernel version of 5.4 - on older kernels the call will return with an
+ * error, but we ignore it. The kernel might also ignore this hint.
+ *
+ * Note, due to rounding the pointer up (which is necessary due to madvise
+ * requiring an address that aligns with the page size), the first partial
+ * page will not be reclaimed. Madvise also rounds the end of the hinted
+ * range down, so the last partial page is also unaffected. Because of this
+ * behavior, on average one memory page (usually 4 kiB) per buffer holding 4
+ * bit data will not be paged out.
+ */
+inline void PageOut(const void* data, size_t size) {
+#ifdef MADV_PAGEOUT
+  static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t up_aligned = ((begin + pagesize - 1) / pagesize) * pagesize;
+  if (up_aligned - begin >= size) {
+    return;
+  }
+  madvise(reinterpret_cast<void*>(up_aligned), size - (up_aligned - begin),
+          MADV_PAGEOUT);
+#endif
+}
+
+/* Compute output = input * transpose(weights) + bias with float input of
+ * shape (batch_size, cols) and output of shape (batch_size, units).
+ * weights of shape (units, cols) are int4 values packed two per byte, as in
+ * kTfLiteInt4 tensors, with cols even, and dequantized with filter_scales,
+ * one per unit, or a single one when num_filter_scales is 1. The weights are
+ * prepacked on the first call, and must not change afterwards.
+ */
+inline void HybridMatMul(HybridMatMulData4Bit* data, const int8_t* weights,
+                         const float* filter_scales, int num_filter_scales,
+                         int units, int cols, const float* input,
+                         int batch_size, const float* bias, float* output) {
+  const int depth = FilterDepth;
+  const int lhs_width = FilterWidth;
+  const int lhs_layout_rows = (units + (lhs_width - 1)) & ~(lhs_width - 1);
+  const int lhs_layout_cols = (cols + (depth - 1)) & ~(depth - 1);
+  if (data->needs_prepack) {
+    const int weight_size = lhs_layout_rows * lhs_layout_cols / 2;
+    data->AllocatePackedRegion(kDefaultAlignmentPadding + weight_size);
+    Prepack(data->prepacked_cache, weights, lhs_layout_rows, lhs_layout_cols,
+            units, cols, lhs_width, depth);
+    data->filter_scales.assign(lhs_layout_rows, filter_scales[0]);
+    if (num_filter_scales > 1) {
+      std::copy(filter_scales, filter_scales + units,
+                data->filter_scales.begin());
+    }
+    data->needs_prepack = false;
+  }
+  if (data->batch_size != batch_size) {
+    data->batch_size = batch_size;
+    data->rows_right = 1;
+    for (int packed_rows = GetMaxSupportedRows(); packed_rows > 0;
+         packed_rows /= 2) {
+      if (batch_size >= packed_rows) {
+        data->rows_right = packed_rows;
+        break;
+      }
+    }
+  }
+  const int rhs_width = data->rows_right;
+  const int rhs_layout_rows = (batch_size + (rhs_width - 1)) & ~(rhs_width - 1);
+  const int rhs_layout_cols = lhs_layout_cols;
+  const int dst_layout_rows = rhs_layout_rows;
+  const int dst_layout_cols = lhs_layout_rows;
+  data->input_quantized.resize(rhs_layout_rows * rhs_layout_cols);
+  data->scaling_factors.resize(rhs_layout_rows);
+  data->input_offsets.resize(rhs_layout_rows);
+  data->accum_scratch.resize(dst_layout_rows * dst_layout_cols);
+
+  BatchQuantizeFloats4Bit(input, batch_size, cols, data->input_quantized.data(),
+                          data->scaling_factors.data(), rhs_width, depth,
+                          data->input_offsets.data());
+  AssignBiasAndComputeOffsets(data->input_offsets.data(),
+                              data->scaling_factors.data(),
+                              data->filter_scales.data(), bias, output, units,
+                              batch_size);
+  RunAndUnpack(rhs_width, data->prepacked_cache, data->input_quantized.data(),
+               data->accum_scratch.data(), units, batch_size, lhs_layout_rows,
+               lhs_layout_cols, rhs_layout_rows, rhs_layout_cols,
+               dst_layout_rows, dst_layout_cols, output,
+               data->scaling_factors.data(), data->filter_scales.data());
+}
+
 }  // namespace api
 }  // namespace optimized_4bit
 }  // namespace tflite
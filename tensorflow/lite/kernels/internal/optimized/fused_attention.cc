@@ -0,0 +1,352 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/fused_attention.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
+
+namespace tflite {
+namespace optimized_attention {
+namespace {
+
+// Queries and keys per tile. A tile of 128 keys of depth 64 is 32 KiB of
+// floats, and the scores of a tile 16 KiB.
+constexpr int kQueryTile = 32;
+constexpr int kKeyTile = 128;
+
+// Scratch memory of a thread.
+struct Scratch {
+  Scratch(const AttentionParams& params, bool quantized, float* data) {
+    scores = data;
+    data += kQueryTile * kKeyTile;
+    output = data;
+    data += kQueryTile * params.value_depth;
+    row_max = data;
+    data += kQueryTile;
+    row_sum = data;
+    data += kQueryTile;
+    if (quantized) {
+      query = data;
+      data += kQueryTile * params.depth;
+      key = data;
+      data += kKeyTile * params.depth;
+      value = data;
+    }
+  }
+
+  float* scores;
+  float* output;
+  float* row_max;
+  float* row_sum;
+  // Dequantized tiles of int8 inputs.
+  float* query = nullptr;
+  float* key = nullptr;
+  float* value = nullptr;
+};
+
+// Provides tiles of the float inputs in place.
+class FloatInputs {
+ public:
+  FloatInputs(const float* query, const float* key, const float* value,
+              float* output)
+      : query_(query), key_(key), value_(value), output_(output) {}
+
+  const float* Query(int64_t offset, int size, Scratch*) const {
+    return query_ + offset;
+  }
+  const float* Key(int64_t offset, int size, Scratch*) const {
+    return key_ + offset;
+  }
+  const float* Value(int64_t offset, int size, Scratch*) const {
+    return value_ + offset;
+  }
+  void StoreOutput(const float* values, int64_t offset, int size) const {
+    std::copy_n(values, size, output_ + offset);
+  }
+
+ private:
+  const float* query_;
+  const float* key_;
+  const float* value_;
+  float* output_;
+};
+
+void Dequantize(const int8_t* values, int size,
+                const QuantizationParams& params, float* output) {
+  for (int i = 0; i < size; ++i) {
+    output[i] = (values[i] - params.zero_point) * params.scale;
+  }
+}
+
+// Dequantizes tiles of the int8 inputs into the scratch memory.
+class QuantizedInputs {
+ public:
+  QuantizedInputs(const int8_t* query, const QuantizationParams& query_params,
+                  const int8_t* key, const QuantizationParams& key_params,
+                  const int8_t* value, const QuantizationParams& value_params,
+                  int8_t* output, const QuantizationParams& output_params)
+      : query_(query),
+        key_(key),
+        value_(value),
+        output_(output),
+        query_params_(query_params),
+        key_params_(key_params),
+        value_params_(value_params),
+        output_params_(output_params) {}
+
+  const float* Query(int64_t offset, int size, Scratch* scratch) const {
+    Dequantize(query_ + offset, size, query_params_, scratch->query);
+    return scratch->query;
+  }
+  const float* Key(int64_t offset, int size, Scratch* scratch) const {
+    Dequantize(key_ + offset, size, key_params_, scratch->key);
+    return scratch->key;
+  }
+  const float* Value(int64_t offset, int size, Scratch* scratch) const {
+    Dequantize(value_ + offset, size, value_params_, scratch->value);
+    return scratch->value;
+  }
+  void StoreOutput(const float* values, int64_t offset, int size) const {
+    const float inverse_scale = 1.0f / output_params_.scale;
+    for (int i = 0; i < size; ++i) {
+      const int32_t quantized =
+          static_cast<int32_t>(std::round(values[i] * inverse_scale)) +
+          output_params_.zero_point;
+      output_[offset + i] = static_cast<int8_t>(
+          std::min<int32_t>(std::max<int32_t>(quantized, -128), 127));
+    }
+  }
+
+ private:
+  const int8_t* query_;
+  const int8_t* key_;
+  const int8_t* value_;
+  int8_t* output_;
+  QuantizationParams query_params_;
+  QuantizationParams key_params_;
+  QuantizationParams value_params_;
+  QuantizationParams output_params_;
+};
+
+// Computes the outputs of up to kQueryTile queries of one batch and head,
+// starting at query `query_begin`.
+template <typename Inputs>
+void ComputeQueryTile(const AttentionParams& params, const Inputs& inputs,
+                      int batch, int head, int query_begin, Scratch* scratch) {
+  const int depth = params.depth;
+  const int value_depth = params.value_depth;
+  const int num_queries =
+      std::min(kQueryTile, params.query_length - query_begin);
+  const int kv_head = head / (params.heads / params.kv_heads);
+  const int64_t query_offset =
+      (static_cast<int64_t>(batch * params.heads + head) * params.query_length +
+       query_begin) *
+      depth;
+  const int64_t kv_offset =
+      static_cast<int64_t>(batch * params.kv_heads + kv_head) *
+      params.key_length;
+  // With a causal mask, query i attends to keys up to i + causal_offset.
+  const int causal_offset = params.key_length - params.query_length;
+  const int key_end =
+      params.causal ? std::max(0, std::min(params.key_length,
+                                           query_begin + num_queries +
+                                               causal_offset))
+                    : params.key_length;
+
+  const float* query =
+      inputs.Query(query_offset, num_queries * depth, scratch);
+  float* scores = scratch->scores;
+  float* output = scratch->output;
+  float* row_max = scratch->row_max;
+  float* row_sum = scratch->row_sum;
+  std::fill_n(output, num_queries * value_depth, 0.0f);
+  std::fill_n(row_max, num_queries, -std::numeric_limits<float>::infinity());
+  std::fill_n(row_sum, num_queries, 0.0f);
+
+  for (int key_begin = 0; key_begin < key_end; key_begin += kKeyTile) {
+    const int num_keys = std::min(kKeyTile, key_end - key_begin);
+    const float* key = inputs.Key((kv_offset + key_begin) * depth,
+                                  num_keys * depth, scratch);
+    const float* value = inputs.Value((kv_offset + key_begin) * value_depth,
+                                      num_keys * value_depth, scratch);
+    std::fill_n(scores, num_queries * num_keys, 0.0f);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        key, num_keys, depth, query, num_queries, scores);
+
+    for (int i = 0; i < num_queries; ++i) {
+      float* row_scores = scores + i * num_keys;
+      const int num_row_keys =
+          params.causal
+              ? std::max(0, std::min(num_keys, query_begin + i +
+                                                   causal_offset + 1 -
+                                                   key_begin))
+              : num_keys;
+      if (num_row_keys == 0) continue;
+      const float* mask =
+          params.mask
+              ? params.mask + batch * params.mask_strides[0] +
+                    head * params.mask_strides[1] +
+                    (query_begin + i) * params.mask_strides[2] +
+                    key_begin * params.mask_strides[3]
+              : nullptr;
+      float tile_max = -std::numeric_limits<float>::infinity();
+      for (int j = 0; j < num_row_keys; ++j) {
+        float score = row_scores[j] * params.scale;
+        if (mask) score += mask[j * params.mask_strides[3]];
+        row_scores[j] = score;
+        tile_max = std::max(tile_max, score);
+      }
+      const float new_max = std::max(row_max[i], tile_max);
+      // All the keys so far are masked out.
+      if (new_max == -std::numeric_limits<float>::infinity()) continue;
+
+      // Rescales what was accumulated with the previous maximum.
+      float* row_output = output + i * value_depth;
+      const float correction = std::exp(row_max[i] - new_max);
+      if (correction != 1.0f) {
+        row_sum[i] *= correction;
+        for (int k = 0; k < value_depth; ++k) row_output[k] *= correction;
+      }
+      row_max[i] = new_max;
+      for (int j = 0; j < num_row_keys; ++j) {
+        const float probability = std::exp(row_scores[j] - new_max);
+        row_sum[i] += probability;
+        const float* value_row = value + j * value_depth;
+        for (int k = 0; k < value_depth; ++k) {
+          row_output[k] += probability * value_row[k];
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < num_queries; ++i) {
+    float* row_output = output + i * value_depth;
+    const float inverse_sum = row_sum[i] > 0.0f ? 1.0f / row_sum[i] : 0.0f;
+    for (int k = 0; k < value_depth; ++k) row_output[k] *= inverse_sum;
+  }
+  const int64_t output_offset =
+      (static_cast<int64_t>(batch * params.heads + head) * params.query_length +
+       query_begin) *
+      value_depth;
+  inputs.StoreOutput(output, output_offset, num_queries * value_depth);
+}
+
+template <typename Inputs>
+class AttentionTask : public cpu_backend_threadpool::Task {
+ public:
+  AttentionTask(const AttentionParams& params, const Inputs& inputs,
+                bool quantized, float* scratch, int begin, int end)
+      : params_(params),
+        inputs_(inputs),
+        scratch_(params, quantized, scratch),
+        begin_(begin),
+        end_(end) {}
+
+  void Run() override {
+    const int query_tiles = (params_.query_length + kQueryTile - 1) / kQueryTile;
+    for (int i = begin_; i < end_; ++i) {
+      const int batch_head = i / query_tiles;
+      ComputeQueryTile(params_, inputs_, batch_head / params_.heads,
+                       batch_head % params_.heads,
+                       (i % query_tiles) * kQueryTile, &scratch_);
+    }
+  }
+
+ private:
+  const AttentionParams& params_;
+  const Inputs& inputs_;
+  Scratch scratch_;
+  int begin_;
+  int end_;
+};
+
+// Splits the query tiles of all batches and heads across threads.
+template <typename Inputs>
+void Run(const AttentionParams& params, const Inputs& inputs, bool quantized,
+         float* scratch, int num_scratch_slots,
+         CpuBackendContext* cpu_backend_context) {
+  const int query_tiles = (params.query_length + kQueryTile - 1) / kQueryTile;
+  const int num_units = params.batches * params.heads * query_tiles;
+  if (num_units == 0) return;
+  int thread_count = std::min(num_units, num_scratch_slots);
+  if (cpu_backend_context != nullptr) {
+    thread_count =
+        std::min(thread_count, cpu_backend_context->max_num_threads());
+  }
+  thread_count = std::max(1, thread_count);
+  const int scratch_size = GetScratchSize(params, quantized);
+  std::vector<AttentionTask<Inputs>> tasks;
+  tasks.reserve(thread_count);
+  int begin = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    const int end = begin + num_units / thread_count +
+                    (i < num_units % thread_count ? 1 : 0);
+    tasks.emplace_back(params, inputs, quantized, scratch + i * scratch_size,
+                       begin, end);
+    begin = end;
+  }
+  if (thread_count == 1) {
+    tasks[0].Run();
+    return;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+}  // namespace
+
+int GetScratchSize(const AttentionParams& params, bool quantized) {
+  int size = kQueryTile * kKeyTile + kQueryTile * params.value_depth +
+             2 * kQueryTile;
+  if (quantized) {
+    size += kQueryTile * params.depth + kKeyTile * params.depth +
+            kKeyTile * params.value_depth;
+  }
+  return size;
+}
+
+void FusedAttention(const AttentionParams& params, const float* query,
+                    const float* key, const float* value, float* output,
+                    float* scratch, int num_scratch_slots,
+                    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FusedAttention/Float");
+  Run(params, FloatInputs(query, key, value, output), /*quantized=*/false,
+      scratch, num_scratch_slots, cpu_backend_context);
+}
+
+void FusedAttention(const AttentionParams& params, const int8_t* query,
+                    const QuantizationParams& query_params, const int8_t* key,
+                    const QuantizationParams& key_params, const int8_t* value,
+                    const QuantizationParams& value_params, int8_t* output,
+                    const QuantizationParams& output_params, float* scratch,
+                    int num_scratch_slots,
+                    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FusedAttention/Int8");
+  Run(params,
+      QuantizedInputs(query, query_params, key, key_params, value,
+                      value_params, output, output_params),
+      /*quantized=*/true, scratch, num_scratch_slots, cpu_backend_context);
+}
+
+}  // namespace optimized_attention
+}  // namespace tflite
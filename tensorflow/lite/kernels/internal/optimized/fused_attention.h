@@ -0,0 +1,85 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_FUSED_ATTENTION_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_FUSED_ATTENTION_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+
+namespace tflite {
+namespace optimized_attention {
+
+// Computes softmax(scale * query * key^T + mask) * value for each batch and
+// head without materializing the [query_length, key_length] scores: the keys
+// are processed in tiles, and the softmax is computed online, rescaling the
+// partial outputs of the query rows whenever their maximum score grows. The
+// memory used is a few tiles per thread, whatever the sequence lengths.
+
+struct AttentionParams {
+  int batches = 0;
+  int heads = 0;
+  // Heads of the keys and values, which divides `heads`. Query head h
+  // attends to key head h / (heads / kv_heads), as in grouped-query
+  // attention.
+  int kv_heads = 0;
+  int query_length = 0;
+  int key_length = 0;
+  int depth = 0;
+  int value_depth = 0;
+  float scale = 1.0f;
+  // If true, query i only attends to keys up to i + key_length -
+  // query_length, i.e. the queries are the last positions of the sequence.
+  bool causal = false;
+  // Optional scores added before the softmax, indexed by the dot product of
+  // [batch, head, query, key] with `mask_strides`. Broadcast dimensions have
+  // a stride of 0.
+  const float* mask = nullptr;
+  int64_t mask_strides[4] = {0, 0, 0, 0};
+};
+
+// Quantization of an int8 tensor.
+struct QuantizationParams {
+  float scale = 1.0f;
+  int32_t zero_point = 0;
+};
+
+// Floats of scratch memory each thread needs.
+int GetScratchSize(const AttentionParams& params, bool quantized);
+
+// The query is [batches, heads, query_length, depth], the key is
+// [batches, kv_heads, key_length, depth], the value is
+// [batches, kv_heads, key_length, value_depth] and the output is
+// [batches, heads, query_length, value_depth]. `scratch` holds
+// `num_scratch_slots` times GetScratchSize() floats, which bounds the number
+// of threads used.
+void FusedAttention(const AttentionParams& params, const float* query,
+                    const float* key, const float* value, float* output,
+                    float* scratch, int num_scratch_slots,
+                    CpuBackendContext* cpu_backend_context);
+
+// Same as above for int8 tensors, which are dequantized a tile at a time.
+void FusedAttention(const AttentionParams& params, const int8_t* query,
+                    const QuantizationParams& query_params, const int8_t* key,
+                    const QuantizationParams& key_params, const int8_t* value,
+                    const QuantizationParams& value_params, int8_t* output,
+                    const QuantizationParams& output_params, float* scratch,
+                    int num_scratch_slots,
+                    CpuBackendContext* cpu_backend_context);
+
+}  // namespace optimized_attention
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_FUSED_ATTENTION_H_
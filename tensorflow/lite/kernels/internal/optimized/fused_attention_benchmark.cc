@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Measures the latency and the intermediate memory of fused_attention.h
+// against the unfused BatchMatMul, Softmax and BatchMatMul sequence, which
+// materializes the [heads, sequence_length, sequence_length] scores, for
+// growing sequence lengths of self-attention.
+//
+// Usage: fused_attention_benchmark [heads] [depth] [num_threads]
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/fused_attention.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
+
+namespace tflite {
+namespace optimized_attention {
+namespace {
+
+// Returns the average time in microseconds of `fn` over about 0.2 seconds.
+template <typename Fn>
+double TimeMicros(Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  fn();
+  int iterations = 0;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point end;
+  do {
+    fn();
+    ++iterations;
+    end = Clock::now();
+  } while (end - start < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+// The unfused ops of one batch: query * key^T into `scores`, a softmax over
+// each row of the scores, then scores * value.
+void UnfusedAttention(const AttentionParams& params, const float* query,
+                      const float* key, const float* value, float* scores,
+                      float* output) {
+  const int length = params.query_length;
+  const int depth = params.depth;
+  for (int h = 0; h < params.heads; ++h) {
+    float* head_scores = scores + static_cast<size_t>(h) * length * length;
+    std::fill_n(head_scores, length * length, 0.0f);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        key + h * length * depth, length, depth, query + h * length * depth,
+        length, head_scores);
+  }
+  for (int r = 0; r < params.heads * length; ++r) {
+    float* row = scores + static_cast<size_t>(r) * length;
+    float max_score = row[0] * params.scale;
+    for (int j = 0; j < length; ++j) {
+      row[j] *= params.scale;
+      max_score = std::max(max_score, row[j]);
+    }
+    float sum = 0.0f;
+    for (int j = 0; j < length; ++j) {
+      row[j] = std::exp(row[j] - max_score);
+      sum += row[j];
+    }
+    for (int j = 0; j < length; ++j) row[j] /= sum;
+  }
+  const int value_depth = params.value_depth;
+  std::fill_n(output, params.heads * length * value_depth, 0.0f);
+  for (int r = 0; r < params.heads * length; ++r) {
+    const float* row = scores + static_cast<size_t>(r) * length;
+    const float* head_value = value + (r / length) * length * value_depth;
+    float* row_output = output + r * value_depth;
+    for (int j = 0; j < length; ++j) {
+      for (int k = 0; k < value_depth; ++k) {
+        row_output[k] += row[j] * head_value[j * value_depth + k];
+      }
+    }
+  }
+}
+
+void Run(int heads, int depth, int length, CpuBackendContext* single_thread,
+         CpuBackendContext* multi_thread) {
+  AttentionParams params;
+  params.batches = 1;
+  params.heads = heads;
+  params.kv_heads = heads;
+  params.query_length = length;
+  params.key_length = length;
+  params.depth = depth;
+  params.value_depth = depth;
+  params.scale = 1.0f / std::sqrt(static_cast<float>(depth));
+
+  std::mt19937 random_engine(42);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  const size_t size = static_cast<size_t>(heads) * length * depth;
+  std::vector<float> query(size), key(size), value(size), output(size);
+  for (std::vector<float>* values : {&query, &key, &value}) {
+    for (float& v : *values) v = dist(random_engine);
+  }
+
+  std::vector<float> scores(static_cast<size_t>(heads) * length * length);
+  const double unfused_micros = TimeMicros([&] {
+    UnfusedAttention(params, query.data(), key.data(), value.data(),
+                     scores.data(), output.data());
+  });
+  const int num_threads = multi_thread->max_num_threads();
+  const int scratch_size = GetScratchSize(params, /*quantized=*/false);
+  std::vector<float> scratch(static_cast<size_t>(num_threads) * scratch_size);
+  const double single_micros = TimeMicros([&] {
+    FusedAttention(params, query.data(), key.data(), value.data(),
+                   output.data(), scratch.data(), 1, single_thread);
+  });
+  const double multi_micros = TimeMicros([&] {
+    FusedAttention(params, query.data(), key.data(), value.data(),
+                   output.data(), scratch.data(), num_threads, multi_thread);
+  });
+  printf("%7d %12.1f %12.1f %12.1f %14.1f %14.1f\n", length, unfused_micros,
+         single_micros, multi_micros, scores.size() * sizeof(float) / 1024.0,
+         scratch.size() * sizeof(float) / 1024.0);
+}
+
+}  // namespace
+}  // namespace optimized_attention
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  const int heads = argc > 1 ? atoi(argv[1]) : 8;
+  const int depth = argc > 2 ? atoi(argv[2]) : 64;
+  const int num_threads = argc > 3 ? atoi(argv[3]) : 4;
+  tflite::CpuBackendContext single_thread;
+  single_thread.SetMaxNumThreads(1);
+  tflite::CpuBackendContext multi_thread;
+  multi_thread.SetMaxNumThreads(num_threads);
+  printf("%d heads of depth %d, %d thread(s)\n", heads, depth, num_threads);
+  printf("%7s %12s %12s %12s %14s %14s\n", "length", "unfused (us)",
+         "fused (us)", "threads (us)", "scores (KiB)", "scratch (KiB)");
+  for (int length = 64; length <= 4096; length *= 2) {
+    tflite::optimized_attention::Run(heads, depth, length, &single_thread,
+                                     &multi_thread);
+  }
+  return 0;
+}
@@ -0,0 +1,243 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/fused_attention.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+
+namespace tflite {
+namespace optimized_attention {
+namespace {
+
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+// Materializes the scores and computes a full softmax, as the unfused ops do.
+std::vector<float> NaiveAttention(const AttentionParams& params,
+                                  const std::vector<float>& query,
+                                  const std::vector<float>& key,
+                                  const std::vector<float>& value) {
+  const int group = params.heads / params.kv_heads;
+  std::vector<float> output(static_cast<size_t>(params.batches) *
+                            params.heads * params.query_length *
+                            params.value_depth);
+  std::vector<float> scores(params.key_length);
+  for (int b = 0; b < params.batches; ++b) {
+    for (int h = 0; h < params.heads; ++h) {
+      const int kv_h = h / group;
+      for (int i = 0; i < params.query_length; ++i) {
+        const float* q =
+            &query[((b * params.heads + h) * params.query_length + i) *
+                   params.depth];
+        float max_score = -std::numeric_limits<float>::infinity();
+        for (int j = 0; j < params.key_length; ++j) {
+          const float* k =
+              &key[((b * params.kv_heads + kv_h) * params.key_length + j) *
+                   params.depth];
+          float score = 0.0f;
+          for (int d = 0; d < params.depth; ++d) score += q[d] * k[d];
+          score *= params.scale;
+          if (params.mask) {
+            score += params.mask[b * params.mask_strides[0] +
+                                 h * params.mask_strides[1] +
+                                 i * params.mask_strides[2] +
+                                 j * params.mask_strides[3]];
+          }
+          if (params.causal &&
+              j > i + params.key_length - params.query_length) {
+            score = -std::numeric_limits<float>::infinity();
+          }
+          scores[j] = score;
+          max_score = std::max(max_score, score);
+        }
+        float* out =
+            &output[((b * params.heads + h) * params.query_length + i) *
+                    params.value_depth];
+        if (max_score == -std::numeric_limits<float>::infinity()) continue;
+        float sum = 0.0f;
+        for (int j = 0; j < params.key_length; ++j) {
+          scores[j] = std::exp(scores[j] - max_score);
+          sum += scores[j];
+        }
+        for (int j = 0; j < params.key_length; ++j) {
+          const float* v =
+              &value[((b * params.kv_heads + kv_h) * params.key_length + j) *
+                     params.value_depth];
+          for (int d = 0; d < params.value_depth; ++d) {
+            out[d] += scores[j] / sum * v[d];
+          }
+        }
+      }
+    }
+  }
+  return output;
+}
+
+std::vector<float> RandomValues(size_t size, std::mt19937* random_engine) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> values(size);
+  for (float& value : values) value = dist(*random_engine);
+  return values;
+}
+
+struct Shape {
+  int heads;
+  int kv_heads;
+  int query_length;
+  int key_length;
+  bool causal;
+};
+
+class FusedAttentionTest : public ::testing::TestWithParam<Shape> {
+ protected:
+  FusedAttentionTest() { cpu_backend_context_.SetMaxNumThreads(4); }
+
+  AttentionParams GetParams() const {
+    AttentionParams params;
+    params.batches = 2;
+    params.heads = GetParam().heads;
+    params.kv_heads = GetParam().kv_heads;
+    params.query_length = GetParam().query_length;
+    params.key_length = GetParam().key_length;
+    params.depth = 16;
+    params.value_depth = 12;
+    params.scale = 0.25f;
+    params.causal = GetParam().causal;
+    return params;
+  }
+
+  std::mt19937 random_engine_{42};
+  CpuBackendContext cpu_backend_context_;
+};
+
+TEST_P(FusedAttentionTest, Float) {
+  AttentionParams params = GetParams();
+  const std::vector<float> query = RandomValues(
+      params.batches * params.heads * params.query_length * params.depth,
+      &random_engine_);
+  const std::vector<float> key = RandomValues(
+      params.batches * params.kv_heads * params.key_length * params.depth,
+      &random_engine_);
+  const std::vector<float> value = RandomValues(
+      params.batches * params.kv_heads * params.key_length *
+          params.value_depth,
+      &random_engine_);
+  // A [query_length, key_length] mask broadcast over batches and heads.
+  const std::vector<float> mask = RandomValues(
+      params.query_length * params.key_length, &random_engine_);
+
+  std::vector<float> scratch(4 * GetScratchSize(params, /*quantized=*/false));
+  for (bool masked : {false, true}) {
+    params.mask = masked ? mask.data() : nullptr;
+    params.mask_strides[2] = masked ? params.key_length : 0;
+    params.mask_strides[3] = masked ? 1 : 0;
+    std::vector<float> output(params.batches * params.heads *
+                              params.query_length * params.value_depth);
+    FusedAttention(params, query.data(), key.data(), value.data(),
+                   output.data(), scratch.data(), /*num_scratch_slots=*/4,
+                   &cpu_backend_context_);
+    EXPECT_THAT(output, Pointwise(FloatNear(1e-5),
+                                  NaiveAttention(params, query, key, value)));
+  }
+}
+
+TEST_P(FusedAttentionTest, Int8) {
+  const AttentionParams params = GetParams();
+  const QuantizationParams input_params = {1.0f / 64, 3};
+  const QuantizationParams output_params = {1.0f / 32, -2};
+  std::uniform_int_distribution<int> value_dist(-128, 127);
+  const auto random_int8 = [&](size_t size, std::vector<float>* dequantized) {
+    std::vector<int8_t> values(size);
+    for (int8_t& value : values) {
+      value = value_dist(random_engine_);
+      dequantized->push_back((value - input_params.zero_point) *
+                             input_params.scale);
+    }
+    return values;
+  };
+  std::vector<float> query_float, key_float, value_float;
+  const std::vector<int8_t> query = random_int8(
+      params.batches * params.heads * params.query_length * params.depth,
+      &query_float);
+  const std::vector<int8_t> key = random_int8(
+      params.batches * params.kv_heads * params.key_length * params.depth,
+      &key_float);
+  const std::vector<int8_t> value =
+      random_int8(params.batches * params.kv_heads * params.key_length *
+                      params.value_depth,
+                  &value_float);
+
+  std::vector<float> scratch(GetScratchSize(params, /*quantized=*/true));
+  std::vector<int8_t> output(params.batches * params.heads *
+                             params.query_length * params.value_depth);
+  FusedAttention(params, query.data(), input_params, key.data(), input_params,
+                 value.data(), input_params, output.data(), output_params,
+                 scratch.data(), /*num_scratch_slots=*/1,
+                 &cpu_backend_context_);
+  std::vector<float> dequantized_output;
+  for (int8_t value : output) {
+    dequantized_output.push_back((value - output_params.zero_point) *
+                                 output_params.scale);
+  }
+  EXPECT_THAT(dequantized_output,
+              Pointwise(FloatNear(output_params.scale),
+                        NaiveAttention(params, query_float, key_float,
+                                       value_float)));
+}
+
+// The lengths cover a partial tile of queries and several tiles of keys.
+INSTANTIATE_TEST_SUITE_P(FusedAttentionTest, FusedAttentionTest,
+                         ::testing::Values(Shape{1, 1, 1, 1, false},
+                                           Shape{3, 3, 7, 300, false},
+                                           Shape{4, 2, 40, 200, false},
+                                           Shape{4, 1, 70, 70, true},
+                                           Shape{2, 2, 5, 260, true}));
+
+TEST(FusedAttentionTest, FullyMaskedRowIsZero) {
+  AttentionParams params;
+  params.batches = 1;
+  params.heads = 1;
+  params.kv_heads = 1;
+  params.query_length = 2;
+  params.key_length = 2;
+  params.depth = 1;
+  params.value_depth = 1;
+  const float kInf = std::numeric_limits<float>::infinity();
+  const std::vector<float> mask = {0.0f, -kInf, -kInf, -kInf};
+  params.mask = mask.data();
+  params.mask_strides[2] = 2;
+  params.mask_strides[3] = 1;
+  const std::vector<float> query = {1.0f, 1.0f};
+  const std::vector<float> key = {1.0f, 2.0f};
+  const std::vector<float> value = {3.0f, 4.0f};
+  std::vector<float> scratch(GetScratchSize(params, /*quantized=*/false));
+  std::vector<float> output(2);
+  FusedAttention(params, query.data(), key.data(), value.data(), output.data(),
+                 scratch.data(), /*num_scratch_slots=*/1,
+                 /*cpu_backend_context=*/nullptr);
+  EXPECT_THAT(output, Pointwise(FloatNear(1e-6), {3.0f, 0.0f}));
+}
+
+}  // namespace
+}  // namespace optimized_attention
+}  // namespace tflite
@@ -0,0 +1,831 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_weights.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/internal/utils/sparsity_format_converter.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TFLITE_SPARSE_WEIGHTS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace tflite {
+namespace optimized_sparse {
+namespace {
+
+// Above these fractions of stored weights, the dense kernels are faster than
+// the sparse ones for a few input vectors, as measured by
+// sparse_weights_benchmark with 1024x1024 float weights on an AVX2 CPU. Blocks
+// of at least 8 rows or 16 columns vectorize best. The sparse kernels go
+// through the weights once per input vector, so the dense kernels win earlier
+// for larger batches, and always beyond kMaxSparseBatches.
+constexpr float kMaxBlocksDensity = 0.3f;
+constexpr float kMaxLongBlocksDensity = 0.5f;
+constexpr float kMaxUnstructuredDensity = 0.3f;
+constexpr float kMaxStructured2x4Density = 0.5f;
+constexpr int kMaxSparseBatches = 16;
+
+// Below this number of multiply-adds per thread, threads cost more than they
+// save.
+constexpr int kMinMultiplyAddsPerThread = 1 << 16;
+
+float MaxSparseDensity(SparseLayout layout, int block_rows, int block_cols,
+                       int batches) {
+  if (batches > kMaxSparseBatches) return 0.0f;
+  float max_density = kMaxBlocksDensity;
+  if (layout == SparseLayout::kStructured2x4) {
+    max_density = kMaxStructured2x4Density;
+  } else if (block_rows * block_cols == 1) {
+    max_density = kMaxUnstructuredDensity;
+  } else if (block_rows >= 8 || block_cols >= 16) {
+    max_density = kMaxLongBlocksDensity;
+  }
+  return max_density / (1 + batches / 8);
+}
+
+template <typename T>
+bool IsStructured2x4(const T* values, int rows, int cols) {
+  if (cols % 4 != 0) return false;
+  for (int i = 0; i < rows * cols; i += 4) {
+    const int nonzeros = (values[i] != 0) + (values[i + 1] != 0) +
+                         (values[i + 2] != 0) + (values[i + 3] != 0);
+    if (nonzeros > 2) return false;
+  }
+  return true;
+}
+
+template <typename T>
+void PackStructured2x4(const T* values, SparseWeights<T>* weights) {
+  constexpr int kSpan = Structured2x4Span<T>();
+  const int size = weights->rows * weights->cols;
+  weights->values.resize(size / 2);
+  weights->positions.resize(size / 2);
+  int packed = 0;
+  for (int i = 0; i < size; i += 4) {
+    // Keeps the nonzero weights, then zeros at other positions if needed.
+    int kept[2];
+    int num_kept = 0;
+    for (int j = 0; j < 4 && num_kept < 2; ++j) {
+      if (values[i + j] != 0) kept[num_kept++] = j;
+    }
+    for (int j = 0; j < 4 && num_kept < 2; ++j) {
+      if (values[i + j] == 0 && (num_kept == 0 || kept[0] != j)) {
+        kept[num_kept++] = j;
+      }
+    }
+    std::sort(kept, kept + 2);
+    const int col = i % weights->cols;
+    for (int j : kept) {
+      weights->values[packed] = values[i + j];
+      weights->positions[packed] = (col + j) % kSpan;
+      ++packed;
+    }
+  }
+}
+
+template <typename T>
+void PackBlocks(const T* values, SparseWeights<T>* weights) {
+  const int rows = weights->rows;
+  const int cols = weights->cols;
+  const int block_rows = weights->block_rows;
+  const int block_cols = weights->block_cols;
+  weights->block_row_segments.assign(1, 0);
+  weights->block_cols_start.clear();
+  weights->values.clear();
+  for (int row = 0; row < rows; row += block_rows) {
+    for (int col = 0; col < cols; col += block_cols) {
+      bool is_zero = true;
+      for (int r = 0; r < block_rows && is_zero; ++r) {
+        for (int c = 0; c < block_cols; ++c) {
+          if (values[(row + r) * cols + col + c] != 0) {
+            is_zero = false;
+            break;
+          }
+        }
+      }
+      if (is_zero) continue;
+      weights->block_cols_start.push_back(col);
+      for (int r = 0; r < block_rows; ++r) {
+        const T* block_row = values + (row + r) * cols + col;
+        weights->values.insert(weights->values.end(), block_row,
+                               block_row + block_cols);
+      }
+    }
+    weights->block_row_segments.push_back(weights->block_cols_start.size());
+  }
+}
+
+// Returns out[r] = sum(weights[row_start + r][c] * input[c]) for the rows in
+// [row_start, row_end), using plain loops.
+template <typename T, typename AccumT>
+void ComputeRowsPortable(const SparseWeights<T>& weights, const T* input,
+                         int row_start, int row_end, AccumT* out) {
+  if (weights.layout == SparseLayout::kStructured2x4) {
+    constexpr int kSpan = Structured2x4Span<T>();
+    const int row_size = weights.cols / 2;
+    for (int row = row_start; row < row_end; ++row) {
+      const T* values = weights.values.data() + row * row_size;
+      const uint8_t* positions = weights.positions.data() + row * row_size;
+      AccumT sum = 0;
+      for (int i = 0; i < row_size; ++i) {
+        const int col = i / (kSpan / 2) * kSpan + positions[i];
+        sum += static_cast<AccumT>(values[i]) * input[col];
+      }
+      out[row - row_start] = sum;
+    }
+    return;
+  }
+  const int block_rows = weights.block_rows;
+  const int block_cols = weights.block_cols;
+  const int block_size = block_rows * block_cols;
+  std::fill(out, out + row_end - row_start, 0);
+  for (int block_row = row_start / block_rows;
+       block_row < row_end / block_rows; ++block_row) {
+    AccumT* block_out = out + block_row * block_rows - row_start;
+    for (int i = weights.block_row_segments[block_row];
+         i < weights.block_row_segments[block_row + 1]; ++i) {
+      const T* block = weights.values.data() + i * block_size;
+      const T* block_input = input + weights.block_cols_start[i];
+      for (int r = 0; r < block_rows; ++r) {
+        AccumT sum = 0;
+        for (int c = 0; c < block_cols; ++c) {
+          sum += static_cast<AccumT>(block[r * block_cols + c]) *
+                 block_input[c];
+        }
+        block_out[r] += sum;
+      }
+    }
+  }
+}
+
+#ifdef TFLITE_SPARSE_WEIGHTS_AVX2
+
+#define TFLITE_SPARSE_WEIGHTS_AVX2_TARGET __attribute__((target("avx2,fma")))
+
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET inline float ReduceAdd(__m128 v) {
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_movehdup_ps(v));
+  return _mm_cvtss_f32(v);
+}
+
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET inline float ReduceAdd(__m256 v) {
+  return ReduceAdd(_mm_add_ps(_mm256_castps256_ps128(v),
+                              _mm256_extractf128_ps(v, 1)));
+}
+
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET inline int32_t ReduceAdd(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+// Widens 16 int8 values to int16.
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET inline __m256i Load16(const int8_t* data) {
+  return _mm256_cvtepi8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+}
+
+// Widens 8 int8 values to int16.
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET inline __m128i Load8(const int8_t* data) {
+  return _mm_cvtepi8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)));
+}
+
+// Widens 4 int8 values to int16, the upper half being zeros.
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET inline __m128i Load4(const int8_t* data) {
+  int32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return _mm_cvtepi8_epi16(_mm_cvtsi32_si128(value));
+}
+
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void Structured2x4RowsAvx2(
+    const SparseWeights<float>& weights, const float* input, int row_start,
+    int row_end, float* out) {
+  const int row_size = weights.cols / 2;
+  for (int row = row_start; row < row_end; ++row) {
+    const float* values = weights.values.data() + row * row_size;
+    const uint8_t* positions = weights.positions.data() + row * row_size;
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    int i = 0;
+    // Each 8 weights come from 16 inputs: the first 4 from the first 8 inputs
+    // and the last 4 from the next 8.
+    for (; i + 16 <= row_size; i += 16) {
+      const float* block_input = input + 2 * i;
+      const __m256i index0 = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(positions + i)));
+      const __m256i index1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+          reinterpret_cast<const __m128i*>(positions + i + 8)));
+      const __m256 input0 = _mm256_blend_ps(
+          _mm256_permutevar8x32_ps(_mm256_loadu_ps(block_input), index0),
+          _mm256_permutevar8x32_ps(_mm256_loadu_ps(block_input + 8), index0),
+          0xf0);
+      const __m256 input1 = _mm256_blend_ps(
+          _mm256_permutevar8x32_ps(_mm256_loadu_ps(block_input + 16), index1),
+          _mm256_permutevar8x32_ps(_mm256_loadu_ps(block_input + 24), index1),
+          0xf0);
+      sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), input0, sum0);
+      sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i + 8), input1, sum1);
+    }
+    float sum = ReduceAdd(_mm256_add_ps(sum0, sum1));
+    for (; i < row_size; ++i) {
+      sum += values[i] * input[i / 4 * 8 + positions[i]];
+    }
+    out[row - row_start] = sum;
+  }
+}
+
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void Structured2x4RowsAvx2(
+    const SparseWeights<int8_t>& weights, const int8_t* input, int row_start,
+    int row_end, int32_t* out) {
+  const int row_size = weights.cols / 2;
+  for (int row = row_start; row < row_end; ++row) {
+    const int8_t* values = weights.values.data() + row * row_size;
+    const uint8_t* positions = weights.positions.data() + row * row_size;
+    __m256i sum = _mm256_setzero_si256();
+    int i = 0;
+    // Each 16 weights come from 32 inputs: the first 8 from the first 16
+    // inputs, shuffled within the low 128-bit lane, and the last 8 from the
+    // next 16, shuffled within the high lane.
+    for (; i + 16 <= row_size; i += 16) {
+      const __m256i shuffle = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(positions + i)));
+      const __m256i shuffled = _mm256_shuffle_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + 2 * i)),
+          shuffle);
+      // Keeps the low half of the low lane and the high half of the high one.
+      const __m256i block_input = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(
+          _mm256_permute4x64_epi64(shuffled, _MM_SHUFFLE(0, 0, 3, 0))));
+      sum = _mm256_add_epi32(
+          sum, _mm256_madd_epi16(block_input, Load16(values + i)));
+    }
+    int32_t total = ReduceAdd(sum);
+    for (; i < row_size; ++i) {
+      total += values[i] * input[i / 8 * 16 + positions[i]];
+    }
+    out[row - row_start] = total;
+  }
+}
+
+// Unstructured 1x1 blocks, gathering 8 inputs at a time.
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void UnstructuredRowsAvx2(
+    const SparseWeights<float>& weights, const float* input, int row_start,
+    int row_end, float* out) {
+  const float* values = weights.values.data();
+  const int32_t* cols = weights.block_cols_start.data();
+  for (int row = row_start; row < row_end; ++row) {
+    const int end = weights.block_row_segments[row + 1];
+    int i = weights.block_row_segments[row];
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (; i + 16 <= end; i += 16) {
+      const __m256 input0 = _mm256_i32gather_ps(
+          input,
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols + i)), 4);
+      const __m256 input1 = _mm256_i32gather_ps(
+          input,
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols + i + 8)),
+          4);
+      sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), input0, sum0);
+      sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i + 8), input1, sum1);
+    }
+    float sum = ReduceAdd(_mm256_add_ps(sum0, sum1));
+    for (; i < end; ++i) {
+      sum += values[i] * input[cols[i]];
+    }
+    out[row - row_start] = sum;
+  }
+}
+
+// Blocks of one column and a multiple of 8 rows, computed along the rows.
+// kRowVectors of the block rows are computed at a time.
+template <int kRowVectors>
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void ColumnBlockRowsAvx2(
+    const SparseWeights<float>& weights, const float* input, int block_row,
+    int first_row, float* out) {
+  const int block_rows = weights.block_rows;
+  const int begin = weights.block_row_segments[block_row];
+  const int end = weights.block_row_segments[block_row + 1];
+  const float* values = weights.values.data() + first_row;
+  const int32_t* cols = weights.block_cols_start.data();
+  __m256 sum0[kRowVectors];
+  __m256 sum1[kRowVectors];
+  for (int v = 0; v < kRowVectors; ++v) {
+    sum0[v] = _mm256_setzero_ps();
+    sum1[v] = _mm256_setzero_ps();
+  }
+  int i = begin;
+  for (; i + 2 <= end; i += 2) {
+    const __m256 input0 = _mm256_broadcast_ss(input + cols[i]);
+    const __m256 input1 = _mm256_broadcast_ss(input + cols[i + 1]);
+    const float* block0 = values + i * block_rows;
+    const float* block1 = block0 + block_rows;
+    for (int v = 0; v < kRowVectors; ++v) {
+      sum0[v] = _mm256_fmadd_ps(_mm256_loadu_ps(block0 + 8 * v), input0,
+                                sum0[v]);
+      sum1[v] = _mm256_fmadd_ps(_mm256_loadu_ps(block1 + 8 * v), input1,
+                                sum1[v]);
+    }
+  }
+  if (i < end) {
+    const __m256 input0 = _mm256_broadcast_ss(input + cols[i]);
+    const float* block0 = values + i * block_rows;
+    for (int v = 0; v < kRowVectors; ++v) {
+      sum0[v] = _mm256_fmadd_ps(_mm256_loadu_ps(block0 + 8 * v), input0,
+                                sum0[v]);
+    }
+  }
+  for (int v = 0; v < kRowVectors; ++v) {
+    _mm256_storeu_ps(out + 8 * v, _mm256_add_ps(sum0[v], sum1[v]));
+  }
+}
+
+template <int kRowVectors>
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void ColumnBlockRowsAvx2(
+    const SparseWeights<int8_t>& weights, const int8_t* input, int block_row,
+    int first_row, int32_t* out) {
+  const int block_rows = weights.block_rows;
+  const int begin = weights.block_row_segments[block_row];
+  const int end = weights.block_row_segments[block_row + 1];
+  const int8_t* values = weights.values.data() + first_row;
+  const int32_t* cols = weights.block_cols_start.data();
+  __m256i sum[kRowVectors];
+  for (int v = 0; v < kRowVectors; ++v) sum[v] = _mm256_setzero_si256();
+  for (int i = begin; i < end; ++i) {
+    const __m256i block_input = _mm256_set1_epi32(input[cols[i]]);
+    const int8_t* block = values + i * block_rows;
+    for (int v = 0; v < kRowVectors; ++v) {
+      const __m256i block_values = _mm256_cvtepi8_epi32(_mm_loadl_epi64(
+          reinterpret_cast<const __m128i*>(block + 8 * v)));
+      sum[v] = _mm256_add_epi32(
+          sum[v], _mm256_mullo_epi32(block_values, block_input));
+    }
+  }
+  for (int v = 0; v < kRowVectors; ++v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8 * v), sum[v]);
+  }
+}
+
+// Blocks of a multiple of 4 columns, computed along the columns. kRows of the
+// block rows are computed at a time.
+template <int kRows>
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void RowBlockRowsAvx2(
+    const SparseWeights<float>& weights, const float* input, int block_row,
+    int first_row, float* out) {
+  const int block_cols = weights.block_cols;
+  const int block_size = weights.block_rows * block_cols;
+  const int begin = weights.block_row_segments[block_row];
+  const int end = weights.block_row_segments[block_row + 1];
+  const float* values = weights.values.data() + first_row * block_cols;
+  const int32_t* cols = weights.block_cols_start.data();
+  __m256 sum[2][kRows];
+  __m128 sum_half[2][kRows];
+  for (int k = 0; k < 2; ++k) {
+    for (int r = 0; r < kRows; ++r) {
+      sum[k][r] = _mm256_setzero_ps();
+      sum_half[k][r] = _mm_setzero_ps();
+    }
+  }
+  // Alternates between two sets of sums, so that the latency of the
+  // multiply-adds of consecutive blocks overlaps.
+  for (int i = begin; i < end; ++i) {
+    const int k = (i - begin) & 1;
+    const float* block = values + i * block_size;
+    const float* block_input = input + cols[i];
+    int c = 0;
+    for (; c + 8 <= block_cols; c += 8) {
+      const __m256 input_vector = _mm256_loadu_ps(block_input + c);
+      for (int r = 0; r < kRows; ++r) {
+        sum[k][r] = _mm256_fmadd_ps(
+            _mm256_loadu_ps(block + r * block_cols + c), input_vector,
+            sum[k][r]);
+      }
+    }
+    if (c < block_cols) {
+      const __m128 input_vector = _mm_loadu_ps(block_input + c);
+      for (int r = 0; r < kRows; ++r) {
+        sum_half[k][r] =
+            _mm_fmadd_ps(_mm_loadu_ps(block + r * block_cols + c),
+                         input_vector, sum_half[k][r]);
+      }
+    }
+  }
+  for (int r = 0; r < kRows; ++r) {
+    out[r] = ReduceAdd(_mm256_add_ps(sum[0][r], sum[1][r])) +
+             ReduceAdd(_mm_add_ps(sum_half[0][r], sum_half[1][r]));
+  }
+}
+
+template <int kRows>
+TFLITE_SPARSE_WEIGHTS_AVX2_TARGET void RowBlockRowsAvx2(
+    const SparseWeights<int8_t>& weights, const int8_t* input, int block_row,
+    int first_row, int32_t* out) {
+  const int block_cols = weights.block_cols;
+  const int block_size = weights.block_rows * block_cols;
+  const int begin = weights.block_row_segments[block_row];
+  const int end = weights.block_row_segments[block_row + 1];
+  const int8_t* values = weights.values.data() + first_row * block_cols;
+  const int32_t* cols = weights.block_cols_start.data();
+  __m256i sum[kRows];
+  __m128i sum_half[kRows];
+  for (int r = 0; r < kRows; ++r) {
+    sum[r] = _mm256_setzero_si256();
+    sum_half[r] = _mm_setzero_si128();
+  }
+  for (int i = begin; i < end; ++i) {
+    const int8_t* block = values + i * block_size;
+    const int8_t* block_input = input + cols[i];
+    int c = 0;
+    for (; c + 16 <= block_cols; c += 16) {
+      const __m256i input_vector = Load16(block_input + c);
+      for (int r = 0; r < kRows; ++r) {
+        sum[r] = _mm256_add_epi32(
+            sum[r], _mm256_madd_epi16(Load16(block + r * block_cols + c),
+                                      input_vector));
+      }
+    }
+    if (c + 8 <= block_cols) {
+      const __m128i input_vector = Load8(block_input + c);
+      for (int r = 0; r < kRows; ++r) {
+        sum_half[r] = _mm_add_epi32(
+            sum_half[r],
+            _mm_madd_epi16(Load8(block + r * block_cols + c), input_vector));
+      }
+      c += 8;
+    }
+    if (c < block_cols) {
+      const __m128i input_vector = Load4(block_input + c);
+      for (int r = 0; r < kRows; ++r) {
+        sum_half[r] = _mm_add_epi32(
+            sum_half[r],
+            _mm_madd_epi16(Load4(block + r * block_cols + c), input_vector));
+      }
+    }
+  }
+  for (int r = 0; r < kRows; ++r) {
+    out[r] = ReduceAdd(_mm256_add_epi32(
+        sum[r], _mm256_zextsi128_si256(sum_half[r])));
+  }
+}
+
+template <typename T, typename AccumT>
+bool ComputeRowsAvx2(const SparseWeights<T>& weights, const T* input,
+                     int row_start, int row_end, AccumT* out) {
+  if (weights.layout == SparseLayout::kStructured2x4) {
+    Structured2x4RowsAvx2(weights, input, row_start, row_end, out);
+    return true;
+  }
+  const int block_rows = weights.block_rows;
+  const int block_cols = weights.block_cols;
+  if (block_rows == 1 && block_cols == 1) {
+    // Gathering int8 inputs would read past the end of them, so int8 weights
+    // use the portable kernel.
+    if constexpr (std::is_same<T, float>::value) {
+      UnstructuredRowsAvx2(weights, input, row_start, row_end, out);
+      return true;
+    }
+    return false;
+  }
+  if (block_cols == 1) {
+    if (block_rows % 8 != 0) return false;
+    for (int row = row_start; row < row_end; row += block_rows) {
+      const int block_row = row / block_rows;
+      int r = 0;
+      for (; r + 32 <= block_rows; r += 32) {
+        ColumnBlockRowsAvx2<4>(weights, input, block_row, r,
+                               out + row - row_start + r);
+      }
+      for (; r < block_rows; r += 8) {
+        ColumnBlockRowsAvx2<1>(weights, input, block_row, r,
+                               out + row - row_start + r);
+      }
+    }
+    return true;
+  }
+  if (block_cols % 4 != 0) return false;
+  for (int row = row_start; row < row_end; row += block_rows) {
+    const int block_row = row / block_rows;
+    int r = 0;
+    for (; r + 4 <= block_rows; r += 4) {
+      RowBlockRowsAvx2<4>(weights, input, block_row, r,
+                          out + row - row_start + r);
+    }
+    for (; r < block_rows; ++r) {
+      RowBlockRowsAvx2<1>(weights, input, block_row, r,
+                          out + row - row_start + r);
+    }
+  }
+  return true;
+}
+
+#endif  // TFLITE_SPARSE_WEIGHTS_AVX2
+
+template <typename T, typename AccumT>
+void ComputeRows(const SparseWeights<T>& weights, const T* input,
+                 int row_start, int row_end, AccumT* out) {
+#ifdef TFLITE_SPARSE_WEIGHTS_AVX2
+  static const bool has_avx2 = DetectX86Avx2Fma();
+  if (has_avx2 &&
+      ComputeRowsAvx2(weights, input, row_start, row_end, out)) {
+    return;
+  }
+#endif
+  ComputeRowsPortable(weights, input, row_start, row_end, out);
+}
+
+void ComputeOutputRows(const SparseWeights<float>& weights,
+                       const FullyConnectedParams& params, const float* input,
+                       int batches, const float* bias, int row_start,
+                       int row_end, float* output) {
+  for (int b = 0; b < batches; ++b) {
+    float* out = output + b * weights.rows + row_start;
+    ComputeRows(weights, input + b * weights.cols, row_start, row_end, out);
+    for (int row = row_start; row < row_end; ++row) {
+      const float total = *out + (bias ? bias[row] : 0.0f);
+      *out++ = ActivationFunctionWithMinMax(total, params.float_activation_min,
+                                            params.float_activation_max);
+    }
+  }
+}
+
+struct Int8OutputParams {
+  const FullyConnectedParams& params;
+  const int32_t* per_channel_multiplier;
+  const int* per_channel_shift;
+};
+
+void ComputeOutputRows(const SparseWeights<int8_t>& weights,
+                       const Int8OutputParams& output_params,
+                       const int8_t* input, int batches, const int32_t* bias,
+                       int row_start, int row_end, int8_t* output) {
+  const FullyConnectedParams& params = output_params.params;
+  std::vector<int32_t> accumulators(row_end - row_start);
+  for (int b = 0; b < batches; ++b) {
+    ComputeRows(weights, input + b * weights.cols, row_start, row_end,
+                accumulators.data());
+    int8_t* out = output + b * weights.rows;
+    for (int row = row_start; row < row_end; ++row) {
+      int32_t total = accumulators[row - row_start] +
+                      params.input_offset * weights.row_sums[row];
+      if (bias) total += bias[row];
+      const bool per_channel = output_params.per_channel_multiplier != nullptr;
+      total = MultiplyByQuantizedMultiplier(
+          total,
+          per_channel ? output_params.per_channel_multiplier[row]
+                      : params.output_multiplier,
+          per_channel ? output_params.per_channel_shift[row]
+                      : params.output_shift);
+      total += params.output_offset;
+      total = std::max(total, params.quantized_activation_min);
+      total = std::min(total, params.quantized_activation_max);
+      out[row] = static_cast<int8_t>(total);
+    }
+  }
+}
+
+template <typename T, typename OutputParams, typename BiasT>
+class SparseFullyConnectedTask : public cpu_backend_threadpool::Task {
+ public:
+  SparseFullyConnectedTask(const SparseWeights<T>& weights,
+                           const OutputParams& output_params, const T* input,
+                           int batches, const BiasT* bias, int row_start,
+                           int row_end, T* output)
+      : weights_(weights),
+        output_params_(output_params),
+        input_(input),
+        batches_(batches),
+        bias_(bias),
+        row_start_(row_start),
+        row_end_(row_end),
+        output_(output) {}
+
+  void Run() override {
+    ComputeOutputRows(weights_, output_params_, input_, batches_, bias_,
+                      row_start_, row_end_, output_);
+  }
+
+ private:
+  const SparseWeights<T>& weights_;
+  const OutputParams& output_params_;
+  const T* input_;
+  int batches_;
+  const BiasT* bias_;
+  int row_start_;
+  int row_end_;
+  T* output_;
+};
+
+// Splits the rows in whole blocks among the threads.
+template <typename T, typename OutputParams, typename BiasT>
+void RunSparseFullyConnected(const SparseWeights<T>& weights,
+                             const OutputParams& output_params, const T* input,
+                             int batches, const BiasT* bias, T* output,
+                             CpuBackendContext* cpu_backend_context) {
+  TFLITE_DCHECK(!weights.use_dense);
+  const int block_rows =
+      weights.layout == SparseLayout::kBlocks ? weights.block_rows : 1;
+  const int num_block_rows = weights.rows / block_rows;
+  const int64_t multiply_adds = static_cast<int64_t>(weights.density *
+                                                     weights.rows) *
+                                weights.cols * batches;
+  const int thread_count = static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>({cpu_backend_context->max_num_threads(),
+                            multiply_adds / kMinMultiplyAddsPerThread,
+                            num_block_rows})));
+  if (thread_count == 1) {
+    ComputeOutputRows(weights, output_params, input, batches, bias, 0,
+                      weights.rows, output);
+    return;
+  }
+  std::vector<SparseFullyConnectedTask<T, OutputParams, BiasT>> tasks;
+  tasks.reserve(thread_count);
+  int row_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int task_block_rows = num_block_rows / thread_count;
+    if (i < num_block_rows % thread_count) ++task_block_rows;
+    const int row_end = row_start + task_block_rows * block_rows;
+    tasks.emplace_back(weights, output_params, input, batches, bias,
+                       row_start, row_end, output);
+    row_start = row_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+}  // namespace
+
+template <typename T>
+void PackDenseWeights(const T* values, int rows, int cols, int block_rows,
+                      int block_cols, int batches, SparseWeights<T>* weights) {
+  if (rows % block_rows != 0 || cols % block_cols != 0) {
+    block_rows = 1;
+    block_cols = 1;
+  }
+  weights->rows = rows;
+  weights->cols = cols;
+  weights->block_rows = block_rows;
+  weights->block_cols = block_cols;
+  weights->batches = batches;
+  weights->use_dense = false;
+  weights->block_row_segments.clear();
+  weights->block_cols_start.clear();
+  weights->values.clear();
+  weights->positions.clear();
+  weights->dense.clear();
+  weights->row_sums.clear();
+
+  const float size = static_cast<float>(rows) * cols;
+  if (block_rows * block_cols == 1 && IsStructured2x4(values, rows, cols) &&
+      std::count(values, values + rows * cols, T(0)) * 4 < size * 3) {
+    weights->layout = SparseLayout::kStructured2x4;
+    weights->density = 0.5f;
+  } else {
+    PackBlocks(values, weights);
+    weights->layout = SparseLayout::kBlocks;
+    weights->density = weights->values.size() / size;
+  }
+  if (batches > 0 &&
+      weights->density >
+          MaxSparseDensity(weights->layout, block_rows, block_cols, batches)) {
+    weights->use_dense = true;
+    weights->block_row_segments.clear();
+    weights->block_cols_start.clear();
+    weights->values.clear();
+    weights->dense.assign(values, values + rows * cols);
+  } else if (weights->layout == SparseLayout::kStructured2x4) {
+    PackStructured2x4(values, weights);
+  }
+  if (std::is_same<T, int8_t>::value && !weights->use_dense) {
+    weights->row_sums.resize(rows);
+    for (int row = 0; row < rows; ++row) {
+      int32_t sum = 0;
+      for (int col = 0; col < cols; ++col) sum += values[row * cols + col];
+      weights->row_sums[row] = sum;
+    }
+  }
+}
+
+template <typename T>
+TfLiteStatus PackSparseWeights(const TfLiteSparsity& sparsity, int rows,
+                               int cols, bool transposed, const T* values,
+                               int batches, SparseWeights<T>* weights,
+                               TfLiteContext* context) {
+  ruy::profiler::ScopeLabel label("PackSparseWeights");
+  const std::vector<int> shape =
+      transposed ? std::vector<int>{cols, rows} : std::vector<int>{rows, cols};
+  std::vector<T> dense(rows * cols);
+  internal::sparsity::FormatConverter<T> converter(shape, sparsity);
+  TF_LITE_ENSURE_OK(context, converter.SparseToDense(values, dense.size(),
+                                                     dense.data(), context));
+
+  // Finds the block size in the traversal order, past the 2 dense dimensions.
+  int block_size[2] = {1, 1};
+  const int num_block_dims =
+      sparsity.block_map == nullptr ? 0 : sparsity.block_map->size;
+  for (int i = 2; i < sparsity.dim_metadata_size; ++i) {
+    const int block_dim = sparsity.traversal_order->data[i] - 2;
+    TF_LITE_ENSURE(context, block_dim >= 0 && block_dim < num_block_dims);
+    const int dim = sparsity.block_map->data[block_dim];
+    TF_LITE_ENSURE(context, dim == 0 || dim == 1);
+    block_size[dim] = sparsity.dim_metadata[i].dense_size;
+  }
+
+  if (transposed) {
+    std::vector<T> transposed_dense(rows * cols);
+    for (int row = 0; row < rows; ++row) {
+      for (int col = 0; col < cols; ++col) {
+        transposed_dense[row * cols + col] = dense[col * rows + row];
+      }
+    }
+    dense.swap(transposed_dense);
+    std::swap(block_size[0], block_size[1]);
+  }
+  PackDenseWeights(dense.data(), rows, cols, block_size[0], block_size[1],
+                   batches, weights);
+  return kTfLiteOk;
+}
+
+template <typename T>
+bool NeedsRepacking(const SparseWeights<T>& weights, int batches) {
+  if (batches == weights.batches) return false;
+  return weights.use_dense !=
+         (weights.density > MaxSparseDensity(weights.layout,
+                                             weights.block_rows,
+                                             weights.block_cols, batches));
+}
+
+void SparseFullyConnected(const SparseWeights<float>& weights,
+                          const FullyConnectedParams& params,
+                          const float* input_data, int batches,
+                          const float* bias_data, float* output_data,
+                          CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("SparseFullyConnected");
+  RunSparseFullyConnected(weights, params, input_data, batches, bias_data,
+                          output_data, cpu_backend_context);
+}
+
+void SparseFullyConnected(const SparseWeights<int8_t>& weights,
+                          const FullyConnectedParams& params,
+                          const int32_t* per_channel_multiplier,
+                          const int* per_channel_shift,
+                          const int8_t* input_data, int batches,
+                          const int32_t* bias_data, int8_t* output_data,
+                          CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("SparseFullyConnected");
+  const Int8OutputParams output_params = {params, per_channel_multiplier,
+                                          per_channel_shift};
+  RunSparseFullyConnected(weights, output_params, input_data, batches,
+                          bias_data, output_data, cpu_backend_context);
+}
+
+template TfLiteStatus PackSparseWeights<float>(
+    const TfLiteSparsity& sparsity, int rows, int cols, bool transposed,
+    const float* values, int batches, SparseWeights<float>* weights,
+    TfLiteContext* context);
+template TfLiteStatus PackSparseWeights<int8_t>(
+    const TfLiteSparsity& sparsity, int rows, int cols, bool transposed,
+    const int8_t* values, int batches, SparseWeights<int8_t>* weights,
+    TfLiteContext* context);
+template void PackDenseWeights<float>(const float* values, int rows, int cols,
+                                      int block_rows, int block_cols,
+                                      int batches,
+                                      SparseWeights<float>* weights);
+template void PackDenseWeights<int8_t>(const int8_t* values, int rows,
+                                       int cols, int block_rows,
+                                       int block_cols, int batches,
+                                       SparseWeights<int8_t>* weights);
+template bool NeedsRepacking<float>(const SparseWeights<float>& weights,
+                                    int batches);
+template bool NeedsRepacking<int8_t>(const SparseWeights<int8_t>& weights,
+                                     int batches);
+
+}  // namespace optimized_sparse
+}  // namespace tflite
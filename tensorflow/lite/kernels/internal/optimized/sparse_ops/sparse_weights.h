@@ -0,0 +1,132 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_SPARSE_WEIGHTS_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_SPARSE_WEIGHTS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+// Sparse weights of FullyConnected and BatchMatMul, packed for the kernels
+// below on first use and again when the batch size changes which kernels are
+// faster. The kernels have AVX2 versions on x86, selected at runtime, and
+// portable ones elsewhere.
+//
+// Packing goes through the dense weights, so any TfLiteSparsity format of a
+// 2D tensor is accepted. Its block size only picks the layout:
+//  - 1x1 blocks with at most 2 nonzeros in each group of 4 consecutive weights
+//    of a row use the 2:4 structured layout,
+//  - other blocks, including 1x1 ones, are stored block by block for each row
+//    of blocks, as in CSR.
+// When so many weights are nonzero that the dense kernels are faster, the
+// dense weights are kept instead, to be used with the dense kernels.
+
+namespace tflite {
+namespace optimized_sparse {
+
+enum class SparseLayout {
+  // Nonzero blocks of block_rows x block_cols weights.
+  kBlocks,
+  // 2 weights out of each group of 4 consecutive weights of a row.
+  kStructured2x4,
+};
+
+template <typename T>
+struct SparseWeights {
+  int rows = 0;
+  int cols = 0;
+  int block_rows = 1;
+  int block_cols = 1;
+  SparseLayout layout = SparseLayout::kBlocks;
+  // Fraction of the weights stored by the sparse layout, zeros included.
+  float density = 0.0f;
+  // Whether the dense kernels are faster than the sparse ones, in which case
+  // the weights are only stored in `dense`.
+  bool use_dense = false;
+  // The batch size use_dense was chosen for.
+  int batches = 0;
+
+  // kBlocks: for each row of blocks, its range in `block_cols_start`.
+  std::vector<int32_t> block_row_segments;
+  // kBlocks: the first column of each block.
+  std::vector<int32_t> block_cols_start;
+  // kBlocks: the weights of each block, row-major.
+  // kStructured2x4: the cols / 2 weights kept of each row.
+  std::vector<T> values;
+  // kStructured2x4: for each weight in `values`, the position of its column in
+  // the span of Structured2x4Span<T>() columns it belongs to.
+  std::vector<uint8_t> positions;
+  // use_dense: the rows x cols row-major weights.
+  std::vector<T> dense;
+  // Sum of the weights of each row, to apply the input zero point of int8.
+  std::vector<int32_t> row_sums;
+};
+
+// Number of columns the positions of kStructured2x4 are relative to: AVX2
+// selects the inputs by permuting 8 floats, or shuffling 16 int8 values.
+template <typename T>
+constexpr int Structured2x4Span() {
+  return sizeof(T) == 1 ? 16 : 8;
+}
+
+// Packs the rows x cols weights `values` of a tensor with `sparsity`, for
+// multiplying `batches` input vectors at a time. When `transposed`, the
+// tensor is cols x rows instead, like the rhs of BatchMatMul without adj_y.
+template <typename T>
+TfLiteStatus PackSparseWeights(const TfLiteSparsity& sparsity, int rows,
+                               int cols, bool transposed, const T* values,
+                               int batches, SparseWeights<T>* weights,
+                               TfLiteContext* context);
+
+// Packs dense rows x cols row-major weights, looking for nonzero blocks of
+// block_rows x block_cols weights. With `batches` of 0, the sparse layout is
+// kept whatever the density, to measure it.
+template <typename T>
+void PackDenseWeights(const T* values, int rows, int cols, int block_rows,
+                      int block_cols, int batches, SparseWeights<T>* weights);
+
+// Returns true if use_dense would change for `batches`, so that the weights
+// should be packed again.
+template <typename T>
+bool NeedsRepacking(const SparseWeights<T>& weights, int batches);
+
+// Computes output[b][r] = sum(weights[r][c] * input[b][c]) + bias[r], clamped
+// to the float activation range of `params`, for `batches` input vectors of
+// weights.cols values and output vectors of weights.rows values. Bias may be
+// null. Weights with use_dense are for the dense kernels instead.
+void SparseFullyConnected(const SparseWeights<float>& weights,
+                          const FullyConnectedParams& params,
+                          const float* input_data, int batches,
+                          const float* bias_data, float* output_data,
+                          CpuBackendContext* cpu_backend_context);
+
+// Same as above with int8 inputs and outputs, requantized with the output
+// multiplier and shift of `params`, or per row with `per_channel_multiplier`
+// and `per_channel_shift` when not null. The weights are symmetric.
+void SparseFullyConnected(const SparseWeights<int8_t>& weights,
+                          const FullyConnectedParams& params,
+                          const int32_t* per_channel_multiplier,
+                          const int* per_channel_shift,
+                          const int8_t* input_data, int batches,
+                          const int32_t* bias_data, int8_t* output_data,
+                          CpuBackendContext* cpu_backend_context);
+
+}  // namespace optimized_sparse
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_SPARSE_WEIGHTS_H_
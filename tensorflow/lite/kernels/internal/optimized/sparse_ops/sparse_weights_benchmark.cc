@@ -0,0 +1,206 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Sweeps the density of the weights of a FullyConnected op for the layouts of
+// sparse_weights.h, comparing the sparse kernels with the dense ones the op
+// would otherwise use. The crossover points are what the dense fallback of
+// PackDenseWeights() is tuned with.
+//
+// Usage: sparse_weights_benchmark [rows] [cols] [num_threads]
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_weights.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_sparse {
+namespace {
+
+struct Layout {
+  const char* name;
+  int block_rows;
+  int block_cols;
+  bool structured_2x4;
+};
+
+constexpr Layout kLayouts[] = {
+    {"1x1", 1, 1, false}, {"2:4", 1, 1, true},   {"1x4", 1, 4, false},
+    {"1x16", 1, 16, false}, {"4x4", 4, 4, false}, {"8x1", 8, 1, false},
+};
+constexpr float kDensities[] = {0.05f, 0.1f, 0.2f, 0.3f,
+                                0.4f,  0.5f, 0.6f, 0.7f};
+constexpr int kBatches[] = {1, 4, 16};
+
+// Returns the average time in microseconds of `fn` over about 0.2 seconds.
+template <typename Fn>
+double TimeMicros(Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  fn();
+  int iterations = 0;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point end;
+  do {
+    fn();
+    ++iterations;
+    end = Clock::now();
+  } while (end - start < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+template <typename T>
+std::vector<T> RandomWeights(int rows, int cols, const Layout& layout,
+                             float density, std::mt19937* random_engine) {
+  std::uniform_int_distribution<int> value_dist(1, 127);
+  std::bernoulli_distribution keep_dist(density);
+  std::vector<T> weights(rows * cols);
+  if (layout.structured_2x4) {
+    for (int i = 0; i < rows * cols; i += 4) {
+      int positions[4] = {0, 1, 2, 3};
+      std::shuffle(positions, positions + 4, *random_engine);
+      weights[i + positions[0]] = value_dist(*random_engine);
+      weights[i + positions[1]] = value_dist(*random_engine);
+    }
+    return weights;
+  }
+  for (int row = 0; row < rows; row += layout.block_rows) {
+    for (int col = 0; col < cols; col += layout.block_cols) {
+      if (!keep_dist(*random_engine)) continue;
+      for (int r = 0; r < layout.block_rows; ++r) {
+        for (int c = 0; c < layout.block_cols; ++c) {
+          weights[(row + r) * cols + col + c] = value_dist(*random_engine);
+        }
+      }
+    }
+  }
+  return weights;
+}
+
+template <typename T>
+void SetOutputParams(cpu_backend_gemm::GemmParams<float, float>* params,
+                     FullyConnectedParams* op_params) {
+  params->clamp_min = op_params->float_activation_min = -1e9f;
+  params->clamp_max = op_params->float_activation_max = 1e9f;
+}
+
+template <typename T>
+void SetOutputParams(cpu_backend_gemm::GemmParams<int32_t, int8_t>* params,
+                     FullyConnectedParams* op_params) {
+  params->multiplier_fixedpoint = op_params->output_multiplier = 1 << 30;
+  params->multiplier_exponent = op_params->output_shift = -10;
+  params->clamp_min = op_params->quantized_activation_min = -128;
+  params->clamp_max = op_params->quantized_activation_max = 127;
+  op_params->input_offset = 0;
+  op_params->output_offset = 0;
+}
+
+void RunSparse(const SparseWeights<float>& weights,
+               const FullyConnectedParams& params, const float* input,
+               int batches, float* output, CpuBackendContext* context) {
+  SparseFullyConnected(weights, params, input, batches, nullptr, output,
+                       context);
+}
+
+void RunSparse(const SparseWeights<int8_t>& weights,
+               const FullyConnectedParams& params, const int8_t* input,
+               int batches, int8_t* output, CpuBackendContext* context) {
+  SparseFullyConnected(weights, params, nullptr, nullptr, input, batches,
+                       nullptr, output, context);
+}
+
+template <typename T, typename AccumT>
+void Sweep(const char* type_name, int rows, int cols,
+           CpuBackendContext* context) {
+  std::mt19937 random_engine(1234);
+  for (const Layout& layout : kLayouts) {
+    for (float density : kDensities) {
+      if (layout.structured_2x4 && density != 0.5f) continue;
+      const std::vector<T> values =
+          RandomWeights<T>(rows, cols, layout, density, &random_engine);
+      for (int batches : kBatches) {
+        std::vector<T> input(batches * cols, 1);
+        std::vector<T> output(batches * rows);
+
+        FullyConnectedParams op_params;
+        cpu_backend_gemm::GemmParams<AccumT, T> gemm_params;
+        SetOutputParams<T>(&gemm_params, &op_params);
+        cpu_backend_gemm::MatrixParams<T> lhs_params;
+        lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+        lhs_params.rows = rows;
+        lhs_params.cols = cols;
+        lhs_params.cache_policy = cpu_backend_gemm::CachePolicy::kAlwaysCache;
+        cpu_backend_gemm::MatrixParams<T> rhs_params;
+        rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+        rhs_params.rows = cols;
+        rhs_params.cols = batches;
+        cpu_backend_gemm::MatrixParams<T> dst_params;
+        dst_params.order = cpu_backend_gemm::Order::kColMajor;
+        dst_params.rows = rows;
+        dst_params.cols = batches;
+        const double dense_micros = TimeMicros([&] {
+          cpu_backend_gemm::Gemm(lhs_params, values.data(), rhs_params,
+                                 input.data(), dst_params, output.data(),
+                                 gemm_params, context);
+        });
+
+        SparseWeights<T> weights;
+        PackDenseWeights(values.data(), rows, cols, layout.block_rows,
+                         layout.block_cols, batches, &weights);
+        const bool picks_dense = weights.use_dense;
+        if (picks_dense) {
+          // Measures the sparse layout anyway.
+          PackDenseWeights(values.data(), rows, cols, layout.block_rows,
+                           layout.block_cols, /*batches=*/0, &weights);
+        }
+        const double sparse_micros = TimeMicros([&] {
+          RunSparse(weights, op_params, input.data(), batches, output.data(),
+                    context);
+        });
+        printf("%-6s %-5s %8.2f %8d %12.1f %12.1f %8.2fx %s\n", type_name,
+               layout.name, weights.density, batches, sparse_micros,
+               dense_micros, dense_micros / sparse_micros,
+               picks_dense ? "dense" : "sparse");
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace optimized_sparse
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  const int rows = argc > 1 ? atoi(argv[1]) : 1024;
+  const int cols = argc > 2 ? atoi(argv[2]) : 1024;
+  const int num_threads = argc > 3 ? atoi(argv[3]) : 1;
+  tflite::CpuBackendContext context;
+  context.SetMaxNumThreads(num_threads);
+  printf("%d x %d weights, %d thread(s)\n", rows, cols, num_threads);
+  printf("%-6s %-5s %8s %8s %12s %12s %9s %s\n", "type", "block", "density",
+         "batches", "sparse (us)", "dense (us)", "speedup", "picks");
+  tflite::optimized_sparse::Sweep<float, float>("float", rows, cols, &context);
+  tflite::optimized_sparse::Sweep<int8_t, int32_t>("int8", rows, cols,
+                                                   &context);
+  return 0;
+}
@@ -0,0 +1,281 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_weights.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/internal/utils/sparsity_format_converter.h"
+
+namespace tflite {
+namespace optimized_sparse {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::Pointwise;
+using ::testing::FloatNear;
+
+struct BlockShape {
+  int block_rows;
+  int block_cols;
+};
+
+// Returns rows x cols weights in which each block is nonzero with probability
+// `density`, or 2:4 structured weights for 0x0 blocks.
+template <typename T>
+std::vector<T> RandomWeights(int rows, int cols, const BlockShape& block,
+                             float density, std::mt19937* random_engine) {
+  std::uniform_int_distribution<int> value_dist(-127, 127);
+  std::bernoulli_distribution keep_dist(density);
+  std::vector<T> weights(rows * cols);
+  for (int row = 0; row < rows; row += std::max(1, block.block_rows)) {
+    for (int col = 0; col < cols; col += std::max(1, block.block_cols)) {
+      if (block.block_rows == 0) {
+        // Keeps 2 random positions out of 4.
+        int positions[4] = {0, 1, 2, 3};
+        std::shuffle(positions, positions + 4, *random_engine);
+        for (int i = 0; i < 4; ++i) {
+          weights[row * cols + col + i] =
+              i < 2 ? value_dist(*random_engine) : 0;
+        }
+        col += 3;
+        continue;
+      }
+      if (!keep_dist(*random_engine)) continue;
+      for (int r = 0; r < block.block_rows; ++r) {
+        for (int c = 0; c < block.block_cols; ++c) {
+          weights[(row + r) * cols + col + c] = value_dist(*random_engine);
+        }
+      }
+    }
+  }
+  return weights;
+}
+
+class SparseWeightsTest : public ::testing::TestWithParam<BlockShape> {
+ protected:
+  SparseWeightsTest() { cpu_backend_context_.SetMaxNumThreads(4); }
+
+  void TestFloat(int rows, int cols, float density, int batches) {
+    const BlockShape& block = GetParam();
+    const std::vector<float> values =
+        RandomWeights<float>(rows, cols, block, density, &random_engine_);
+    SparseWeights<float> weights;
+    PackDenseWeights(values.data(), rows, cols, std::max(1, block.block_rows),
+                     std::max(1, block.block_cols), batches, &weights);
+    ASSERT_FALSE(weights.use_dense);
+    if (block.block_rows == 0) {
+      EXPECT_EQ(weights.layout, SparseLayout::kStructured2x4);
+    }
+
+    std::uniform_real_distribution<float> input_dist(-1.0f, 1.0f);
+    std::vector<float> input(batches * cols);
+    for (float& value : input) value = input_dist(random_engine_);
+    std::vector<float> bias(rows);
+    for (float& value : bias) value = input_dist(random_engine_);
+    FullyConnectedParams params;
+    params.float_activation_min = -50.0f;
+    params.float_activation_max = 50.0f;
+    std::vector<float> output(batches * rows);
+    SparseFullyConnected(weights, params, input.data(), batches, bias.data(),
+                         output.data(), &cpu_backend_context_);
+
+    std::vector<float> expected(batches * rows);
+    for (int b = 0; b < batches; ++b) {
+      for (int row = 0; row < rows; ++row) {
+        float sum = bias[row];
+        for (int col = 0; col < cols; ++col) {
+          sum += values[row * cols + col] * input[b * cols + col];
+        }
+        expected[b * rows + row] = std::min(std::max(sum, -50.0f), 50.0f);
+      }
+    }
+    EXPECT_THAT(output, Pointwise(FloatNear(1e-2f), expected));
+  }
+
+  void TestInt8(int rows, int cols, float density, int batches,
+                bool per_channel) {
+    const BlockShape& block = GetParam();
+    const std::vector<int8_t> values =
+        RandomWeights<int8_t>(rows, cols, block, density, &random_engine_);
+    SparseWeights<int8_t> weights;
+    PackDenseWeights(values.data(), rows, cols, std::max(1, block.block_rows),
+                     std::max(1, block.block_cols), batches, &weights);
+    ASSERT_FALSE(weights.use_dense);
+
+    std::uniform_int_distribution<int> input_dist(-128, 127);
+    std::vector<int8_t> input(batches * cols);
+    for (int8_t& value : input) value = input_dist(random_engine_);
+    std::vector<int32_t> bias(rows);
+    for (int32_t& value : bias) value = input_dist(random_engine_) * 100;
+    std::vector<int32_t> multipliers(rows);
+    std::vector<int> shifts(rows);
+    std::uniform_int_distribution<int32_t> multiplier_dist(1 << 30,
+                                                           (1u << 31) - 1);
+    std::uniform_int_distribution<int> shift_dist(-12, -6);
+    for (int row = 0; row < rows; ++row) {
+      multipliers[row] = multiplier_dist(random_engine_);
+      shifts[row] = shift_dist(random_engine_);
+    }
+    FullyConnectedParams params;
+    params.input_offset = 7;
+    params.output_offset = -3;
+    params.output_multiplier = multipliers[0];
+    params.output_shift = shifts[0];
+    params.quantized_activation_min = -120;
+    params.quantized_activation_max = 120;
+    std::vector<int8_t> output(batches * rows);
+    SparseFullyConnected(
+        weights, params, per_channel ? multipliers.data() : nullptr,
+        per_channel ? shifts.data() : nullptr, input.data(), batches,
+        bias.data(), output.data(), &cpu_backend_context_);
+
+    std::vector<int8_t> expected(batches * rows);
+    for (int b = 0; b < batches; ++b) {
+      for (int row = 0; row < rows; ++row) {
+        int32_t sum = bias[row];
+        for (int col = 0; col < cols; ++col) {
+          sum += values[row * cols + col] *
+                 (input[b * cols + col] + params.input_offset);
+        }
+        sum = MultiplyByQuantizedMultiplier(
+            sum, per_channel ? multipliers[row] : params.output_multiplier,
+            per_channel ? shifts[row] : params.output_shift);
+        sum += params.output_offset;
+        expected[b * rows + row] = std::min(std::max(sum, -120), 120);
+      }
+    }
+    EXPECT_THAT(output, ElementsAreArray(expected));
+  }
+
+  std::mt19937 random_engine_{1234};
+  CpuBackendContext cpu_backend_context_;
+};
+
+TEST_P(SparseWeightsTest, Float) {
+  TestFloat(/*rows=*/64, /*cols=*/96, /*density=*/0.2f, /*batches=*/1);
+  TestFloat(/*rows=*/16, /*cols=*/48, /*density=*/0.05f, /*batches=*/3);
+  TestFloat(/*rows=*/512, /*cols=*/1024, /*density=*/0.1f, /*batches=*/2);
+}
+
+TEST_P(SparseWeightsTest, Int8) {
+  TestInt8(/*rows=*/64, /*cols=*/96, /*density=*/0.2f, /*batches=*/1,
+           /*per_channel=*/false);
+  TestInt8(/*rows=*/16, /*cols=*/48, /*density=*/0.05f, /*batches=*/3,
+           /*per_channel=*/false);
+  TestInt8(/*rows=*/512, /*cols=*/1024, /*density=*/0.1f, /*batches=*/2,
+           /*per_channel=*/true);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BlockShapes, SparseWeightsTest,
+    ::testing::Values(BlockShape{0, 0}, BlockShape{1, 1}, BlockShape{1, 2},
+                      BlockShape{1, 4}, BlockShape{1, 16}, BlockShape{2, 8},
+                      BlockShape{4, 4}, BlockShape{4, 1}, BlockShape{8, 1},
+                      BlockShape{16, 1}));
+
+TEST(SparseWeightsDensityTest, UsesDenseWeightsWhenDense) {
+  std::mt19937 random_engine(1234);
+  const std::vector<float> values = RandomWeights<float>(
+      32, 64, BlockShape{1, 4}, /*density=*/0.9f, &random_engine);
+  SparseWeights<float> weights;
+  PackDenseWeights(values.data(), 32, 64, 1, 4, /*batches=*/1, &weights);
+  EXPECT_TRUE(weights.use_dense);
+  EXPECT_EQ(weights.dense, values);
+  EXPECT_FALSE(NeedsRepacking(weights, /*batches=*/64));
+  PackDenseWeights(values.data(), 32, 64, 1, 4, /*batches=*/0, &weights);
+  EXPECT_FALSE(weights.use_dense);
+  EXPECT_TRUE(weights.dense.empty());
+}
+
+TEST(SparseWeightsDensityTest, UsesDenseWeightsForLargeBatches) {
+  std::mt19937 random_engine(1234);
+  const std::vector<float> values = RandomWeights<float>(
+      32, 64, BlockShape{1, 4}, /*density=*/0.1f, &random_engine);
+  SparseWeights<float> weights;
+  PackDenseWeights(values.data(), 32, 64, 1, 4, /*batches=*/1, &weights);
+  EXPECT_FALSE(weights.use_dense);
+  EXPECT_FALSE(NeedsRepacking(weights, /*batches=*/2));
+  ASSERT_TRUE(NeedsRepacking(weights, /*batches=*/64));
+  PackDenseWeights(values.data(), 32, 64, 1, 4, /*batches=*/64, &weights);
+  EXPECT_TRUE(weights.use_dense);
+}
+
+TEST(SparseWeightsPackingTest, PacksTransposedBlockSparseTensor) {
+  // A 8 x 4 tensor with 2x2 blocks, holding the transposed 4 x 8 weights.
+  const int rows = 4;
+  const int cols = 8;
+  std::vector<float> transposed_weights(rows * cols);
+  for (int col = 0; col < 2; ++col) {
+    for (int row = 0; row < 2; ++row) {
+      transposed_weights[(col + 4) * rows + row + 2] = 1 + row + 2 * col;
+    }
+  }
+  internal::sparsity::FormatConverter<float> converter(
+      {cols, rows}, /*traversal_order=*/{0, 1, 2, 3},
+      /*format=*/{kTfLiteDimDense, kTfLiteDimSparseCSR},
+      /*block_size=*/{2, 2}, /*block_map=*/{0, 1});
+  ASSERT_EQ(converter.DenseToSparse(transposed_weights.data()), kTfLiteOk);
+  const std::vector<std::vector<int>>& dim_metadata =
+      converter.GetDimMetadata();
+
+  auto to_int_array = [](const std::vector<int>& values) {
+    TfLiteIntArray* array = TfLiteIntArrayCreate(values.size());
+    std::copy(values.begin(), values.end(), array->data);
+    return array;
+  };
+  std::vector<TfLiteDimensionMetadata> metadata(4);
+  for (int i = 0; i < 4; ++i) {
+    metadata[i].format = i == 1 ? kTfLiteDimSparseCSR : kTfLiteDimDense;
+    metadata[i].dense_size = i == 1 ? 0 : dim_metadata[2 * i][0];
+    metadata[i].array_segments =
+        i == 1 ? to_int_array(dim_metadata[2 * i]) : nullptr;
+    metadata[i].array_indices =
+        i == 1 ? to_int_array(dim_metadata[2 * i + 1]) : nullptr;
+  }
+  TfLiteSparsity sparsity;
+  sparsity.traversal_order = to_int_array({0, 1, 2, 3});
+  sparsity.block_map = to_int_array({0, 1});
+  sparsity.dim_metadata = metadata.data();
+  sparsity.dim_metadata_size = metadata.size();
+
+  SparseWeights<float> weights;
+  EXPECT_EQ(PackSparseWeights(sparsity, rows, cols, /*transposed=*/true,
+                              converter.GetData().data(), /*batches=*/1,
+                              &weights, /*context=*/nullptr),
+            kTfLiteOk);
+  EXPECT_EQ(weights.block_rows, 2);
+  EXPECT_EQ(weights.block_cols, 2);
+  EXPECT_THAT(weights.block_row_segments, ElementsAreArray({0, 0, 1}));
+  EXPECT_THAT(weights.block_cols_start, ElementsAreArray({4}));
+  EXPECT_THAT(weights.values, ElementsAreArray({1, 3, 2, 4}));
+
+  TfLiteIntArrayFree(sparsity.traversal_order);
+  TfLiteIntArrayFree(sparsity.block_map);
+  TfLiteIntArrayFree(metadata[1].array_segments);
+  TfLiteIntArrayFree(metadata[1].array_indices);
+}
+
+}  // namespace
+}  // namespace optimized_sparse
+}  // namespace tflite
@@ -0,0 +1,648 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/x86_int8_gemm.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#if defined(__clang__) ? __clang_major__ >= 6 : __GNUC__ >= 8
+#define TFLITE_X86_INT8_GEMM_VNNI
+#endif
+#if defined(__clang__) ? __clang_major__ >= 12 : __GNUC__ >= 11
+#define TFLITE_X86_INT8_GEMM_AMX
+#endif
+#endif
+
+#ifdef TFLITE_X86_INT8_GEMM_VNNI
+#include <immintrin.h>
+#endif
+
+namespace tflite {
+namespace optimized_x86_int8 {
+namespace {
+
+// Below these sizes, AMX tiles would mostly multiply padding.
+constexpr int kMinAmxRows = 32;
+constexpr int kMinAmxCols = 64;
+constexpr int kMinAmxDepth = 64;
+
+// Per-column terms of the zero point correction, stored at the start of the
+// scratch buffer of both kernels:
+//   depth * lhs_zero_point * rhs_zero_point - lhs_zero_point * sum(rhs column)
+inline size_t ColOffsetsSize(const GemmParams& params) {
+  return RoundUp<64>(params.cols * sizeof(int32_t));
+}
+
+#ifdef TFLITE_X86_INT8_GEMM_VNNI
+
+#define TFLITE_X86_INT8_GEMM_VNNI_TARGET \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512vnni")))
+
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline __mmask64 TailMask(int n) {
+  return _cvtu64_mask64(~0ULL >> (64 - n));
+}
+
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline __mmask16 TailMask16(int n) {
+  return _cvtu32_mask16((1u << n) - 1);
+}
+
+// Returns the sum of n int8 values.
+TFLITE_X86_INT8_GEMM_VNNI_TARGET int32_t SumInt8(const int8_t* data, int n) {
+  const __m512i ones = _mm512_set1_epi8(1);
+  __m512i sum = _mm512_setzero_si512();
+  int i = 0;
+  for (; i + 64 <= n; i += 64) {
+    sum = _mm512_dpbusd_epi32(sum, ones, _mm512_loadu_si512(data + i));
+  }
+  if (i < n) {
+    sum = _mm512_dpbusd_epi32(
+        sum, ones, _mm512_maskz_loadu_epi8(TailMask(n - i), data + i));
+  }
+  return _mm512_reduce_add_epi32(sum);
+}
+
+// Returns the int64 products of the even int32 lanes of a and b, and of the
+// odd ones.
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline void MultiplyToInt64(__m512i a,
+                                                             __m512i b,
+                                                             __m512i* even,
+                                                             __m512i* odd) {
+  *even = _mm512_mul_epi32(a, b);
+  *odd = _mm512_mul_epi32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+}
+
+// Inverse of the split of MultiplyToInt64, keeping the low half of each int64.
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline __m512i MergeInt64(__m512i even,
+                                                           __m512i odd) {
+  return _mm512_mask_blend_epi32(0xaaaa, even, _mm512_slli_epi64(odd, 32));
+}
+
+#if TFLITE_SINGLE_ROUNDING
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline __m512i RoundingShiftRight(
+    __m512i x, __m512i shift) {
+  const __m512i round = _mm512_sllv_epi64(
+      _mm512_set1_epi64(1), _mm512_sub_epi64(shift, _mm512_set1_epi64(1)));
+  return _mm512_srav_epi64(_mm512_add_epi64(x, round), shift);
+}
+#else
+// (x + nudge) / 2^31 in gemmlowp's SaturatingRoundingDoublingHighMul, which
+// rounds towards zero.
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline __m512i RoundingHighHalf(__m512i x) {
+  const __m512i zero = _mm512_setzero_si512();
+  x = _mm512_add_epi64(
+      x, _mm512_mask_blend_epi64(_mm512_cmplt_epi64_mask(x, zero),
+                                 _mm512_set1_epi64(1 << 30),
+                                 _mm512_set1_epi64(1 - (1 << 30))));
+  x = _mm512_mask_add_epi64(x, _mm512_cmplt_epi64_mask(x, zero), x,
+                            _mm512_set1_epi64((1LL << 31) - 1));
+  return _mm512_srai_epi64(x, 31);
+}
+#endif
+
+// MultiplyByQuantizedMultiplier on 16 lanes, with the same rounding.
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline __m512i MultiplyByQuantizedMultiplier(
+    __m512i x, __m512i multiplier, __m512i shift) {
+  __m512i even, odd;
+#if TFLITE_SINGLE_ROUNDING
+  const __m512i total_shift = _mm512_sub_epi32(_mm512_set1_epi32(31), shift);
+  MultiplyToInt64(x, multiplier, &even, &odd);
+  even = RoundingShiftRight(
+      even, _mm512_srai_epi64(_mm512_slli_epi64(total_shift, 32), 32));
+  odd = RoundingShiftRight(odd, _mm512_srai_epi64(total_shift, 32));
+  return MergeInt64(even, odd);
+#else
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i left_shift = _mm512_max_epi32(shift, zero);
+  const __m512i right_shift =
+      _mm512_max_epi32(_mm512_sub_epi32(zero, shift), zero);
+  x = _mm512_sllv_epi32(x, left_shift);
+  // SaturatingRoundingDoublingHighMul.
+  MultiplyToInt64(x, multiplier, &even, &odd);
+  __m512i high = MergeInt64(RoundingHighHalf(even), RoundingHighHalf(odd));
+  const __m512i int32_min =
+      _mm512_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __mmask16 overflow = _mm512_cmpeq_epi32_mask(x, int32_min) &
+                             _mm512_cmpeq_epi32_mask(multiplier, int32_min);
+  high = _mm512_mask_mov_epi32(
+      high, overflow, _mm512_set1_epi32(std::numeric_limits<int32_t>::max()));
+  // RoundingDivideByPOT.
+  const __m512i mask =
+      _mm512_sub_epi32(_mm512_sllv_epi32(one, right_shift), one);
+  const __m512i remainder = _mm512_and_si512(high, mask);
+  __m512i threshold = _mm512_srai_epi32(mask, 1);
+  threshold = _mm512_mask_add_epi32(
+      threshold, _mm512_cmplt_epi32_mask(high, zero), threshold, one);
+  const __m512i result = _mm512_srav_epi32(high, right_shift);
+  return _mm512_mask_add_epi32(
+      result, _mm512_cmpgt_epi32_mask(remainder, threshold), result, one);
+#endif
+}
+
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline void StoreNarrow(int8_t* dst,
+                                                        __mmask16 mask,
+                                                        __m512i values) {
+  _mm512_mask_cvtepi32_storeu_epi8(dst, mask, values);
+}
+
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline void StoreNarrow(int16_t* dst,
+                                                        __mmask16 mask,
+                                                        __m512i values) {
+  _mm512_mask_cvtepi32_storeu_epi16(dst, mask, values);
+}
+
+// Adds the bias to the accumulators of rows [row, row + n) of a column of
+// dst, n <= 16, requantizes them and stores them to dst.
+template <typename DstScalar>
+TFLITE_X86_INT8_GEMM_VNNI_TARGET inline void StoreRequantized(
+    const GemmParams& params, int row, int n, __m512i acc, DstScalar* dst) {
+  const __mmask16 mask = TailMask16(n);
+  if (params.bias != nullptr) {
+    acc = _mm512_add_epi32(acc,
+                           _mm512_maskz_loadu_epi32(mask, params.bias + row));
+  }
+  if (params.multiplier_fixedpoint_perchannel != nullptr) {
+    acc = MultiplyByQuantizedMultiplier(
+        acc,
+        _mm512_maskz_loadu_epi32(
+            mask, params.multiplier_fixedpoint_perchannel + row),
+        _mm512_maskz_loadu_epi32(mask,
+                                 params.multiplier_exponent_perchannel + row));
+  } else {
+    acc = MultiplyByQuantizedMultiplier(
+        acc, _mm512_set1_epi32(params.multiplier_fixedpoint),
+        _mm512_set1_epi32(params.multiplier_exponent));
+  }
+  acc = _mm512_add_epi32(acc, _mm512_set1_epi32(params.dst_zero_point));
+  acc = _mm512_max_epi32(acc, _mm512_set1_epi32(params.clamp_min));
+  acc = _mm512_min_epi32(acc, _mm512_set1_epi32(params.clamp_max));
+  StoreNarrow(dst, mask, acc);
+}
+
+// Requantizes rows [row, row + rows) of column col of dst from their
+// accumulators, given the sums of the lhs rows and how much of them to
+// subtract.
+template <typename DstScalar>
+TFLITE_X86_INT8_GEMM_VNNI_TARGET void StoreColumn(
+    const GemmParams& params, int row, int rows, int col, const int32_t* acc,
+    const int32_t* row_sums, int32_t row_sums_multiplier,
+    int32_t col_offset, DstScalar* dst) {
+  const __m512i offset = _mm512_set1_epi32(col_offset);
+  const __m512i multiplier = _mm512_set1_epi32(row_sums_multiplier);
+  for (int i = 0; i < rows; i += 16) {
+    const int n = std::min(16, rows - i);
+    const __mmask16 mask = TailMask16(n);
+    __m512i values = _mm512_add_epi32(
+        _mm512_maskz_loadu_epi32(mask, acc + i), offset);
+    values = _mm512_sub_epi32(
+        values, _mm512_mullo_epi32(
+                    _mm512_maskz_loadu_epi32(mask, row_sums + i), multiplier));
+    StoreRequantized(params, row + i, n, values,
+                     dst + col * params.rows + row + i);
+  }
+}
+
+// Transposes a 16x16 block of int32 values, with rows of the source and of
+// the destination given by their byte strides.
+TFLITE_X86_INT8_GEMM_VNNI_TARGET void Transpose16x16(const void* src,
+                                                     size_t src_stride,
+                                                     void* dst,
+                                                     size_t dst_stride) {
+  __m512i r[16];
+  __m512i t[16];
+  for (int i = 0; i < 16; ++i) {
+    r[i] = _mm512_loadu_si512(static_cast<const char*>(src) + i * src_stride);
+  }
+  for (int i = 0; i < 8; ++i) {
+    t[2 * i] = _mm512_unpacklo_epi32(r[2 * i], r[2 * i + 1]);
+    t[2 * i + 1] = _mm512_unpackhi_epi32(r[2 * i], r[2 * i + 1]);
+  }
+  // Lane l of r[4 * i + c] now holds column 4 * l + c of rows 4 * i to
+  // 4 * i + 3.
+  for (int i = 0; i < 4; ++i) {
+    r[4 * i] = _mm512_unpacklo_epi64(t[4 * i], t[4 * i + 2]);
+    r[4 * i + 1] = _mm512_unpackhi_epi64(t[4 * i], t[4 * i + 2]);
+    r[4 * i + 2] = _mm512_unpacklo_epi64(t[4 * i + 1], t[4 * i + 3]);
+    r[4 * i + 3] = _mm512_unpackhi_epi64(t[4 * i + 1], t[4 * i + 3]);
+  }
+  for (int c = 0; c < 4; ++c) {
+    const __m512i low0 = _mm512_shuffle_i32x4(r[c], r[4 + c], 0x44);
+    const __m512i high0 = _mm512_shuffle_i32x4(r[c], r[4 + c], 0xee);
+    const __m512i low1 = _mm512_shuffle_i32x4(r[8 + c], r[12 + c], 0x44);
+    const __m512i high1 = _mm512_shuffle_i32x4(r[8 + c], r[12 + c], 0xee);
+    t[c] = _mm512_shuffle_i32x4(low0, low1, 0x88);
+    t[4 + c] = _mm512_shuffle_i32x4(low0, low1, 0xdd);
+    t[8 + c] = _mm512_shuffle_i32x4(high0, high1, 0x88);
+    t[12 + c] = _mm512_shuffle_i32x4(high0, high1, 0xdd);
+  }
+  for (int i = 0; i < 16; ++i) {
+    _mm512_storeu_si512(static_cast<char*>(dst) + i * dst_stride, t[i]);
+  }
+}
+
+void ComputeColOffsets(const GemmParams& params, const int8_t* rhs,
+                       int32_t* col_offsets) {
+  const int32_t constant_offset =
+      params.depth * params.lhs_zero_point * params.rhs_zero_point;
+  for (int col = 0; col < params.cols; ++col) {
+    col_offsets[col] = constant_offset;
+    if (params.lhs_zero_point != 0) {
+      col_offsets[col] -= params.lhs_zero_point *
+                          SumInt8(rhs + col * params.depth, params.depth);
+    }
+  }
+}
+
+// vpdpbusd multiplies unsigned by signed bytes, so rhs is offset by 128 on the
+// fly (by flipping its sign bit) and the matching row sums of lhs are
+// subtracted afterwards:
+//   sum(lhs * rhs) = sum(lhs * (rhs + 128)) - 128 * sum(lhs)
+// Zero-padding the tails of lhs makes the padding of rhs irrelevant.
+//
+// Computes the kRows x kCols dot products of lhs rows and rhs columns into
+// the columns of out, of stride out_stride, and the sums of the lhs rows into
+// row_sums if kRowSums.
+template <int kRows, int kCols, bool kRowSums>
+TFLITE_X86_INT8_GEMM_VNNI_TARGET void VnniKernel(const int8_t* lhs,
+                                                 const int8_t* rhs, int depth,
+                                                 int32_t* out, int out_stride,
+                                                 int32_t* row_sums) {
+  const __m512i sign_bit = _mm512_set1_epi8(static_cast<char>(0x80));
+  const __m512i ones = _mm512_set1_epi8(1);
+  // The loops over rows and columns need unrolling for acc to be kept in
+  // registers.
+  __m512i acc[kRows][kCols] = {};
+  __m512i sums[kRows] = {};
+  int k = 0;
+  for (; k + 64 <= depth; k += 64) {
+    __m512i r[kCols];
+#pragma GCC unroll 4
+    for (int j = 0; j < kCols; ++j) {
+      r[j] = _mm512_xor_si512(_mm512_loadu_si512(rhs + j * depth + k),
+                              sign_bit);
+    }
+#pragma GCC unroll 4
+    for (int i = 0; i < kRows; ++i) {
+      const __m512i l = _mm512_loadu_si512(lhs + i * depth + k);
+#pragma GCC unroll 4
+      for (int j = 0; j < kCols; ++j) {
+        acc[i][j] = _mm512_dpbusd_epi32(acc[i][j], r[j], l);
+      }
+      if (kRowSums) sums[i] = _mm512_dpbusd_epi32(sums[i], ones, l);
+    }
+  }
+  if (k < depth) {
+    const __mmask64 mask = TailMask(depth - k);
+    __m512i r[kCols];
+#pragma GCC unroll 4
+    for (int j = 0; j < kCols; ++j) {
+      r[j] = _mm512_xor_si512(
+          _mm512_maskz_loadu_epi8(mask, rhs + j * depth + k), sign_bit);
+    }
+#pragma GCC unroll 4
+    for (int i = 0; i < kRows; ++i) {
+      const __m512i l = _mm512_maskz_loadu_epi8(mask, lhs + i * depth + k);
+#pragma GCC unroll 4
+      for (int j = 0; j < kCols; ++j) {
+        acc[i][j] = _mm512_dpbusd_epi32(acc[i][j], r[j], l);
+      }
+      if (kRowSums) sums[i] = _mm512_dpbusd_epi32(sums[i], ones, l);
+    }
+  }
+#pragma GCC unroll 4
+  for (int i = 0; i < kRows; ++i) {
+#pragma GCC unroll 4
+    for (int j = 0; j < kCols; ++j) {
+      out[j * out_stride + i] = _mm512_reduce_add_epi32(acc[i][j]);
+    }
+    if (kRowSums) row_sums[i] = _mm512_reduce_add_epi32(sums[i]);
+  }
+}
+
+using VnniKernelFn = void (*)(const int8_t*, const int8_t*, int, int32_t*, int,
+                              int32_t*);
+
+template <int kRows, int kCols>
+VnniKernelFn GetVnniKernel(bool row_sums) {
+  return row_sums ? VnniKernel<kRows, kCols, true>
+                  : VnniKernel<kRows, kCols, false>;
+}
+
+template <int kRows>
+VnniKernelFn GetVnniKernel(int cols, bool row_sums) {
+  switch (cols) {
+    case 1:
+      return GetVnniKernel<kRows, 1>(row_sums);
+    case 2:
+      return GetVnniKernel<kRows, 2>(row_sums);
+    case 3:
+      return GetVnniKernel<kRows, 3>(row_sums);
+    default:
+      return GetVnniKernel<kRows, 4>(row_sums);
+  }
+}
+
+VnniKernelFn GetVnniKernel(int rows, int cols, bool row_sums) {
+  switch (rows) {
+    case 1:
+      return GetVnniKernel<1>(cols, row_sums);
+    case 2:
+      return GetVnniKernel<2>(cols, row_sums);
+    case 3:
+      return GetVnniKernel<3>(cols, row_sums);
+    default:
+      return GetVnniKernel<4>(cols, row_sums);
+  }
+}
+
+template <typename DstScalar>
+void VnniGemm(const GemmParams& params, const int8_t* lhs, const int8_t* rhs,
+              const uint8_t* scratch, int row_start, int row_end,
+              DstScalar* dst) {
+  const int depth = params.depth;
+  const int num_rows = row_end - row_start;
+  const int32_t* col_offsets = reinterpret_cast<const int32_t*>(scratch);
+  // Accumulators for a block of 4 columns, then the row sums, which are
+  // computed along with the first block of columns. This keeps the
+  // matrix*vector case a single pass over lhs.
+  std::vector<int32_t> buffer(5 * num_rows);
+  int32_t* row_sums = buffer.data() + 4 * num_rows;
+  // Columns are the outer loop so that a block of rhs stays in L1 while lhs
+  // streams through it.
+  for (int col = 0; col < params.cols; col += 4) {
+    const int cols = std::min(4, params.cols - col);
+    for (int row = row_start; row < row_end; row += 4) {
+      GetVnniKernel(std::min(4, row_end - row), cols, col == 0)(
+          lhs + row * depth, rhs + col * depth, depth,
+          buffer.data() + (row - row_start), num_rows,
+          row_sums + (row - row_start));
+    }
+    for (int j = 0; j < cols; ++j) {
+      StoreColumn(params, row_start, num_rows, col + j,
+                  buffer.data() + j * num_rows, row_sums,
+                  128 + params.rhs_zero_point, col_offsets[col + j], dst);
+    }
+  }
+}
+
+#endif  // TFLITE_X86_INT8_GEMM_VNNI
+
+#ifdef TFLITE_X86_INT8_GEMM_AMX
+
+#define TFLITE_X86_INT8_GEMM_AMX_TARGET                                     \
+  __attribute__((target(                                                    \
+      "avx512f,avx512bw,avx512vl,avx512vnni,amx-tile,amx-int8")))
+
+// rhs is packed into tiles of 16 columns by 64 bytes of depth, laid out the
+// way tdpbssd expects its second operand: row k of a tile holds, for each of
+// its 16 columns, the 4 bytes at depth 4 * k to 4 * k + 3. This is a 16x16
+// transpose of 4-byte groups.
+constexpr int kTileBytes = 16 * 64;
+
+inline int AmxDepthChunks(const GemmParams& params) {
+  return (params.depth + 63) / 64;
+}
+
+// Column tiles come in pairs, to run blocks of 32 columns.
+inline int AmxColTiles(const GemmParams& params) {
+  return 2 * ((params.cols + 31) / 32);
+}
+
+struct TileConfig {
+  uint8_t palette_id;
+  uint8_t start_row;
+  uint8_t reserved[14];
+  uint16_t colsb[16];
+  uint8_t rows[16];
+};
+
+void PackRhsForAmx(const GemmParams& params, const int8_t* rhs,
+                   int8_t* packed) {
+  const int depth = params.depth;
+  const int depth_chunks = AmxDepthChunks(params);
+  for (int tile = 0; tile < AmxColTiles(params); ++tile) {
+    const int col = tile * 16;
+    const int cols = std::max(0, std::min(16, params.cols - col));
+    for (int chunk = 0; chunk < depth_chunks; ++chunk) {
+      const int k = chunk * 64;
+      int8_t* tile_data = packed + (tile * depth_chunks + chunk) * kTileBytes;
+      if (cols == 16 && k + 64 <= depth) {
+        Transpose16x16(rhs + col * depth + k, depth, tile_data, 64);
+        continue;
+      }
+      std::memset(tile_data, 0, kTileBytes);
+      for (int j = 0; j < cols; ++j) {
+        for (int q = 0; q < 64 && k + q < depth; ++q) {
+          tile_data[(q / 4) * 64 + j * 4 + q % 4] =
+              rhs[(col + j) * depth + k + q];
+        }
+      }
+    }
+  }
+}
+
+// tdpbssd multiplies signed by signed bytes, so only the zero points need
+// correcting. Rows are processed 32 at a time against 32 columns, with lhs in
+// tiles 0 and 1, rhs in tiles 2 and 3 and the accumulators in tiles 4 to 7.
+template <typename DstScalar>
+TFLITE_X86_INT8_GEMM_AMX_TARGET void AmxGemm(const GemmParams& params,
+                                             const int8_t* lhs,
+                                             const uint8_t* scratch,
+                                             int row_start, int row_end,
+                                             DstScalar* dst) {
+  const int depth = params.depth;
+  const int depth_chunks = AmxDepthChunks(params);
+  const int32_t* col_offsets = reinterpret_cast<const int32_t*>(scratch);
+  const int8_t* packed =
+      reinterpret_cast<const int8_t*>(scratch + ColOffsetsSize(params));
+
+  alignas(64) TileConfig config = {};
+  config.palette_id = 1;
+  for (int i = 0; i < 8; ++i) {
+    config.rows[i] = 16;
+    config.colsb[i] = 64;
+  }
+  _tile_loadconfig(&config);
+
+  alignas(64) int8_t lhs_block[32 * 64];
+  // The accumulators as computed, one row of lhs per row, then transposed to
+  // one column of dst per row.
+  alignas(64) int32_t out[32 * 32];
+  alignas(64) int32_t out_transposed[32 * 32];
+  int32_t row_sums[32] = {};
+  for (int row = row_start; row < row_end; row += 32) {
+    const int rows = std::min(32, row_end - row);
+    if (params.rhs_zero_point != 0) {
+      for (int i = 0; i < rows; ++i) {
+        row_sums[i] = SumInt8(lhs + (row + i) * depth, depth);
+      }
+    }
+    // Rows past row_end but within lhs belong to other ranges, reading them
+    // is still fine.
+    const bool full_rows = row + 32 <= params.rows;
+    for (int tile = 0; tile < AmxColTiles(params); tile += 2) {
+      _tile_zero(4);
+      _tile_zero(5);
+      _tile_zero(6);
+      _tile_zero(7);
+      for (int chunk = 0; chunk < depth_chunks; ++chunk) {
+        const int k = chunk * 64;
+        const int8_t* lhs_data = lhs + row * depth + k;
+        int lhs_stride = depth;
+        if (!full_rows || k + 64 > depth) {
+          const int bytes = std::min(64, depth - k);
+          std::memset(lhs_block, 0, sizeof(lhs_block));
+          for (int i = 0; i < 32 && row + i < params.rows; ++i) {
+            std::memcpy(lhs_block + i * 64, lhs_data + i * depth, bytes);
+          }
+          lhs_data = lhs_block;
+          lhs_stride = 64;
+        }
+        _tile_loadd(0, lhs_data, lhs_stride);
+        _tile_loadd(1, lhs_data + 16 * lhs_stride, lhs_stride);
+        _tile_loadd(2, packed + (tile * depth_chunks + chunk) * kTileBytes,
+                    64);
+        _tile_loadd(3,
+                    packed + ((tile + 1) * depth_chunks + chunk) * kTileBytes,
+                    64);
+        _tile_dpbssd(4, 0, 2);
+        _tile_dpbssd(5, 0, 3);
+        _tile_dpbssd(6, 1, 2);
+        _tile_dpbssd(7, 1, 3);
+      }
+      constexpr int kStride = 32 * sizeof(int32_t);
+      _tile_stored(4, out, kStride);
+      _tile_stored(5, out + 16, kStride);
+      _tile_stored(6, out + 16 * 32, kStride);
+      _tile_stored(7, out + 16 * 32 + 16, kStride);
+      for (int i = 0; i < 32; i += 16) {
+        for (int j = 0; j < 32; j += 16) {
+          Transpose16x16(out + i * 32 + j, kStride,
+                         out_transposed + j * 32 + i, kStride);
+        }
+      }
+
+      const int col = tile * 16;
+      const int cols = std::min(32, params.cols - col);
+      for (int j = 0; j < cols; ++j) {
+        StoreColumn(params, row, rows, col + j, out_transposed + j * 32,
+                    row_sums, params.rhs_zero_point, col_offsets[col + j],
+                    dst);
+      }
+    }
+  }
+  _tile_release();
+}
+
+#endif  // TFLITE_X86_INT8_GEMM_AMX
+
+template <typename DstScalar>
+void GemmImpl(Kernel kernel, const GemmParams& params, const int8_t* lhs,
+              const int8_t* rhs, const uint8_t* scratch, int row_start,
+              int row_end, DstScalar* dst) {
+  switch (kernel) {
+#ifdef TFLITE_X86_INT8_GEMM_VNNI
+    case Kernel::kAvx512Vnni:
+      VnniGemm(params, lhs, rhs, scratch, row_start, row_end, dst);
+      return;
+#endif
+#ifdef TFLITE_X86_INT8_GEMM_AMX
+    case Kernel::kAmx:
+      AmxGemm(params, lhs, scratch, row_start, row_end, dst);
+      return;
+#endif
+    default:
+      TFLITE_DCHECK(false);
+  }
+}
+
+}  // namespace
+
+bool IsKernelSupported(Kernel kernel) {
+  CpuFlags cpu_flags;
+  GetCpuFlags(&cpu_flags);
+  switch (kernel) {
+#ifdef TFLITE_X86_INT8_GEMM_VNNI
+    case Kernel::kAvx512Vnni:
+      return cpu_flags.avx512_vnni;
+#endif
+#ifdef TFLITE_X86_INT8_GEMM_AMX
+    case Kernel::kAmx:
+      // Packing and zero point corrections also use AVX-512 VNNI.
+      return cpu_flags.amx_int8 && cpu_flags.avx512_vnni;
+#endif
+    default:
+      return false;
+  }
+}
+
+Kernel SelectKernel(const GemmParams& params) {
+  if (params.rows >= kMinAmxRows && params.cols >= kMinAmxCols &&
+      params.depth >= kMinAmxDepth && IsKernelSupported(Kernel::kAmx)) {
+    return Kernel::kAmx;
+  }
+  if (IsKernelSupported(Kernel::kAvx512Vnni)) return Kernel::kAvx512Vnni;
+  return Kernel::kNone;
+}
+
+int KernelRows(Kernel kernel) { return kernel == Kernel::kAmx ? 32 : 4; }
+
+size_t RhsScratchSize(Kernel kernel, const GemmParams& params) {
+  size_t size = ColOffsetsSize(params);
+#ifdef TFLITE_X86_INT8_GEMM_AMX
+  if (kernel == Kernel::kAmx) {
+    size += static_cast<size_t>(AmxColTiles(params)) *
+            AmxDepthChunks(params) * kTileBytes;
+  }
+#endif
+  return size;
+}
+
+void PrepareRhs(Kernel kernel, const GemmParams& params, const int8_t* rhs,
+                uint8_t* scratch) {
+#ifdef TFLITE_X86_INT8_GEMM_VNNI
+  ComputeColOffsets(params, rhs, reinterpret_cast<int32_t*>(scratch));
+#endif
+#ifdef TFLITE_X86_INT8_GEMM_AMX
+  if (kernel == Kernel::kAmx) {
+    PackRhsForAmx(params, rhs,
+                  reinterpret_cast<int8_t*>(scratch + ColOffsetsSize(params)));
+  }
+#endif
+}
+
+void Gemm(Kernel kernel, const GemmParams& params, const int8_t* lhs,
+          const int8_t* rhs, const uint8_t* scratch, int row_start,
+          int row_end, int8_t* dst) {
+  GemmImpl(kernel, params, lhs, rhs, scratch, row_start, row_end, dst);
+}
+
+void Gemm(Kernel kernel, const GemmParams& params, const int8_t* lhs,
+          const int8_t* rhs, const uint8_t* scratch, int row_start,
+          int row_end, int16_t* dst) {
+  GemmImpl(kernel, params, lhs, rhs, scratch, row_start, row_end, dst);
+}
+
+}  // namespace optimized_x86_int8
+}  // namespace tflite
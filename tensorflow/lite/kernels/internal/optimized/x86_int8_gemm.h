@@ -0,0 +1,93 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_X86_INT8_GEMM_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_X86_INT8_GEMM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Int8 matrix multiplication kernels for x86-64 CPUs with AVX-512 VNNI or AMX,
+// selected at runtime through cpu_check.h. They compute
+//
+//   dst = clamp(requantize((lhs - lhs_zero_point) * (rhs - rhs_zero_point)
+//                          + bias) + dst_zero_point)
+//
+// for a row-major lhs and column-major rhs and dst, as cpu_backend_gemm does.
+// Requantization goes through MultiplyByQuantizedMultiplier, so that results
+// match the reference kernels exactly.
+//
+// Kernels are compiled with function-level target attributes, so that the
+// rest of TF Lite doesn't need to be built with AVX-512 enabled.
+
+namespace tflite {
+namespace optimized_x86_int8 {
+
+enum class Kernel {
+  kNone,
+  // vpdpbusd on blocks of 4 rows by 4 columns.
+  kAvx512Vnni,
+  // AMX tiles on blocks of 32 rows by 32 columns.
+  kAmx,
+};
+
+struct GemmParams {
+  int rows = 0;
+  int depth = 0;
+  int cols = 0;
+  int32_t lhs_zero_point = 0;
+  int32_t rhs_zero_point = 0;
+  int32_t dst_zero_point = 0;
+  // Per-row bias, may be null.
+  const int32_t* bias = nullptr;
+  // Per-row multipliers when not null, otherwise the uniform multiplier.
+  int32_t multiplier_fixedpoint = 0;
+  int multiplier_exponent = 0;
+  const int32_t* multiplier_fixedpoint_perchannel = nullptr;
+  const int* multiplier_exponent_perchannel = nullptr;
+  int32_t clamp_min = 0;
+  int32_t clamp_max = 0;
+};
+
+// Returns true if both the CPU and the compiler support `kernel`.
+bool IsKernelSupported(Kernel kernel);
+
+// Returns the fastest supported kernel for the shape in `params`, or kNone.
+Kernel SelectKernel(const GemmParams& params);
+
+// Rows of lhs processed at a time. Ranges of rows given to Gemm() should
+// start at multiples of this.
+int KernelRows(Kernel kernel);
+
+// Size in bytes of the scratch buffer filled by PrepareRhs().
+size_t RhsScratchSize(Kernel kernel, const GemmParams& params);
+
+// Precomputes what only depends on rhs into `scratch`, shared by all the
+// ranges of rows computed by Gemm().
+void PrepareRhs(Kernel kernel, const GemmParams& params, const int8_t* rhs,
+                uint8_t* scratch);
+
+// Computes rows [row_start, row_end) of dst. Safe to call concurrently on
+// disjoint ranges of rows.
+void Gemm(Kernel kernel, const GemmParams& params, const int8_t* lhs,
+          const int8_t* rhs, const uint8_t* scratch, int row_start,
+          int row_end, int8_t* dst);
+void Gemm(Kernel kernel, const GemmParams& params, const int8_t* lhs,
+          const int8_t* rhs, const uint8_t* scratch, int row_start,
+          int row_end, int16_t* dst);
+
+}  // namespace optimized_x86_int8
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_X86_INT8_GEMM_H_
@@ -0,0 +1,178 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/x86_int8_gemm.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_x86_int8 {
+namespace {
+
+struct Shape {
+  int rows;
+  int depth;
+  int cols;
+};
+
+class X86Int8GemmTest : public ::testing::TestWithParam<Kernel> {
+ protected:
+  void SetUp() override {
+    if (!IsKernelSupported(GetParam())) {
+      GTEST_SKIP() << "Kernel not supported on this CPU or compiler.";
+    }
+  }
+
+  // Compares the kernel, computing the rows in two ranges, against the
+  // reference FullyConnected op, with lhs as the weights and rhs as the input.
+  template <typename DstScalar>
+  void TestShape(const Shape& shape, bool per_channel) {
+    std::uniform_int_distribution<int> int8_dist(-128, 127);
+    std::vector<int8_t> lhs(shape.rows * shape.depth);
+    std::vector<int8_t> rhs(shape.depth * shape.cols);
+    for (int8_t& value : lhs) value = int8_dist(random_engine_);
+    for (int8_t& value : rhs) value = int8_dist(random_engine_);
+    std::vector<int32_t> bias(shape.rows);
+    std::uniform_int_distribution<int32_t> bias_dist(-10000, 10000);
+    for (int32_t& value : bias) value = bias_dist(random_engine_);
+    std::vector<int32_t> multipliers(shape.rows);
+    std::vector<int> exponents(shape.rows);
+    std::uniform_int_distribution<int32_t> multiplier_dist(1 << 30,
+                                                           (1u << 31) - 1);
+    std::uniform_int_distribution<int> exponent_dist(-12, 1);
+    for (int row = 0; row < shape.rows; ++row) {
+      multipliers[row] = multiplier_dist(random_engine_);
+      exponents[row] = exponent_dist(random_engine_);
+    }
+
+    GemmParams params;
+    params.rows = shape.rows;
+    params.depth = shape.depth;
+    params.cols = shape.cols;
+    // Per-channel weights are symmetric.
+    params.lhs_zero_point = per_channel ? 0 : int8_dist(random_engine_);
+    params.rhs_zero_point = int8_dist(random_engine_);
+    params.dst_zero_point = int8_dist(random_engine_) / 2;
+    params.bias = bias.data();
+    params.multiplier_fixedpoint = multipliers[0];
+    params.multiplier_exponent = exponents[0];
+    if (per_channel) {
+      params.multiplier_fixedpoint_perchannel = multipliers.data();
+      params.multiplier_exponent_perchannel = exponents.data();
+    }
+    params.clamp_min = std::numeric_limits<DstScalar>::min() + 5;
+    params.clamp_max = std::numeric_limits<DstScalar>::max() - 5;
+
+    const Kernel kernel = GetParam();
+    std::vector<uint8_t> scratch(RhsScratchSize(kernel, params));
+    PrepareRhs(kernel, params, rhs.data(), scratch.data());
+    std::vector<DstScalar> dst(shape.rows * shape.cols);
+    const int split = std::min(shape.rows, KernelRows(kernel));
+    Gemm(kernel, params, lhs.data(), rhs.data(), scratch.data(), 0, split,
+         dst.data());
+    Gemm(kernel, params, lhs.data(), rhs.data(), scratch.data(), split,
+         shape.rows, dst.data());
+
+    FullyConnectedParams op_params;
+    op_params.input_offset = -params.rhs_zero_point;
+    op_params.weights_offset = -params.lhs_zero_point;
+    op_params.output_offset = params.dst_zero_point;
+    op_params.output_multiplier = params.multiplier_fixedpoint;
+    op_params.output_shift = params.multiplier_exponent;
+    op_params.quantized_activation_min = params.clamp_min;
+    op_params.quantized_activation_max = params.clamp_max;
+    const RuntimeShape input_shape({shape.cols, shape.depth});
+    const RuntimeShape filter_shape({shape.rows, shape.depth});
+    const RuntimeShape bias_shape({shape.rows});
+    const RuntimeShape output_shape({shape.cols, shape.rows});
+    std::vector<DstScalar> expected(shape.rows * shape.cols);
+    if (per_channel) {
+      reference_integer_ops::FullyConnectedPerChannel(
+          op_params, multipliers.data(), exponents.data(), input_shape,
+          rhs.data(), filter_shape, lhs.data(), bias_shape, bias.data(),
+          output_shape, expected.data());
+    } else {
+      reference_integer_ops::FullyConnected(
+          op_params, input_shape, rhs.data(), filter_shape, lhs.data(),
+          bias_shape, bias.data(), output_shape, expected.data());
+    }
+    EXPECT_EQ(dst, expected) << "rows=" << shape.rows
+                             << " depth=" << shape.depth
+                             << " cols=" << shape.cols;
+  }
+
+  std::mt19937 random_engine_{1234};
+};
+
+const Shape kShapes[] = {
+    {1, 1, 1},    {3, 7, 2},     {4, 64, 4},    {5, 65, 3},
+    {16, 128, 1}, {31, 100, 17}, {32, 64, 32},  {33, 192, 64},
+    {64, 200, 65}, {70, 63, 40}, {128, 512, 96}, {100, 300, 130},
+};
+
+TEST_P(X86Int8GemmTest, Int8Output) {
+  for (const Shape& shape : kShapes) {
+    TestShape<int8_t>(shape, /*per_channel=*/false);
+  }
+}
+
+TEST_P(X86Int8GemmTest, Int8OutputPerChannel) {
+  for (const Shape& shape : kShapes) {
+    TestShape<int8_t>(shape, /*per_channel=*/true);
+  }
+}
+
+TEST_P(X86Int8GemmTest, Int16Output) {
+  for (const Shape& shape : kShapes) {
+    TestShape<int16_t>(shape, /*per_channel=*/false);
+  }
+}
+
+TEST_P(X86Int8GemmTest, Int16OutputPerChannel) {
+  for (const Shape& shape : kShapes) {
+    TestShape<int16_t>(shape, /*per_channel=*/true);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, X86Int8GemmTest,
+                         ::testing::Values(Kernel::kAvx512Vnni, Kernel::kAmx));
+
+TEST(X86Int8GemmSelectionTest, SelectsSupportedKernel) {
+  GemmParams params;
+  params.rows = 256;
+  params.depth = 256;
+  params.cols = 256;
+  const Kernel kernel = SelectKernel(params);
+  if (kernel != Kernel::kNone) {
+    EXPECT_TRUE(IsKernelSupported(kernel));
+  }
+  if (IsKernelSupported(Kernel::kAmx)) {
+    EXPECT_EQ(kernel, Kernel::kAmx);
+  }
+
+  params.cols = 1;
+  EXPECT_NE(SelectKernel(params), Kernel::kAmx);
+}
+
+}  // namespace
+}  // namespace optimized_x86_int8
+}  // namespace tflite
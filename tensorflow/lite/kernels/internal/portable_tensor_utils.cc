@@ -86,6 +86,19 @@ void UnpackDenseInt4IntoInt8(const int8_t* src_buffer, int num_elements,
   }
 }
 
+void PackInt8IntoDenseInt4(const int8_t* src_buffer, int num_elements,
+                           int8_t* dst_buffer) {
+  for (int i = 0; i < num_elements / 2; i++) {
+    dst_buffer[i] = static_cast<int8_t>((src_buffer[2 * i] & 0x0F) |
+                                        (src_buffer[2 * i + 1] << 4));
+  }
+
+  // If the buffer size is odd, store the final element in the lower nibble.
+  if (num_elements % 2 != 0) {
+    dst_buffer[num_elements / 2] = src_buffer[num_elements - 1] & 0x0F;
+  }
+}
+
 }  // namespace tensor_utils
 }  // namespace tflite
 
@@ -616,6 +616,21 @@ void ApplySignbitToVector(const float* __restrict__ vector, int v_size,
 void UnpackDenseInt4IntoInt8(const int8_t* src_buffer, int num_elements,
                              int8_t* dst_buffer);
 
+// Pack or deflate `src_buffer` by storing each pair of elements as the lower
+// and upper nibble of a byte of `dst_buffer`. This is the inverse of
+// UnpackDenseInt4IntoInt8.
+// Parameters:
+//   src_buffer   : Buffer containing int4 values stored in int8 memory.
+//   num_elements : Number of elements stored in `src_buffer`.
+//   dst_buffer   : Buffer to pack into. Should be allocated by the caller.
+//                  Size should be at least `(num_elements + 1) / 2`.
+// Notes:
+//   For example, given `src_buffer = {0x02, 0x01, 0x04, 0x03}`, calling this
+//   function will return `dst_buffer = {0x12, 0x34}`. If `num_elements` is
+//   odd, the upper nibble of the last byte is 0.
+void PackInt8IntoDenseInt4(const int8_t* src_buffer, int num_elements,
+                           int8_t* dst_buffer);
+
 }  // namespace tensor_utils
 
 }  // namespace tflite
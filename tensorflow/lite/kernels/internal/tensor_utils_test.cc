@@ -2124,6 +2124,34 @@ TEST(uKernels, UnpackInt4OddLength) {
               testing::Pointwise(testing::Eq(), expected_output));
 }
 
+TEST(uKernels, PackInt4) {
+  const int8_t input[4] = {-8, 3, -2, -5};
+  const int8_t expected_output[2] = {0x38, static_cast<int8_t>(0xBE)};
+  int8_t actual_output[2];
+  PackInt8IntoDenseInt4(input, 4, actual_output);
+  EXPECT_THAT(actual_output,
+              testing::Pointwise(testing::Eq(), expected_output));
+}
+
+TEST(uKernels, PackInt4OddLength) {
+  const int8_t input[3] = {1, 2, 3};
+  const int8_t expected_output[2] = {0x21, 0x03};
+  int8_t actual_output[2];
+  PackInt8IntoDenseInt4(input, 3, actual_output);
+  EXPECT_THAT(actual_output,
+              testing::Pointwise(testing::Eq(), expected_output));
+}
+
+TEST(uKernels, PackUnpackInt4RoundTrip) {
+  std::vector<int8_t> input;
+  for (int8_t v = -8; v <= 7; ++v) input.push_back(v);
+  std::vector<int8_t> packed(input.size() / 2);
+  std::vector<int8_t> unpacked(input.size());
+  PackInt8IntoDenseInt4(input.data(), input.size(), packed.data());
+  UnpackDenseInt4IntoInt8(packed.data(), input.size(), unpacked.data());
+  EXPECT_THAT(unpacked, testing::ElementsAreArray(input));
+}
+
 }  // namespace tensor_utils
 }  // namespace tflite
 
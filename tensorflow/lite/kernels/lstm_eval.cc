@@ -157,6 +157,34 @@ inline float GetTensorScale(const TfLiteTensor* tensor) {
 }
 
 // LINT.IfChange
+// Finishes an LSTM gate from `gate_input`, the sum of its matrix products and,
+// unless with layer norm, its bias: adds the peephole connection, normalizes
+// the sum and writes its activation to `gate`. Overwrites `gate_input`.
+inline void ActivateLstmGateFloat(float* gate_input, const float* cell_state,
+                                  const float* cell_to_gate_weights,
+                                  const float* layer_norm_coefficients,
+                                  const float* gate_bias, const int n_batch,
+                                  const int n_cell,
+                                  const TfLiteFusedActivation activation,
+                                  float* gate) {
+  // For each batch and cell: compute cell_weight .* cell_state (peephole LSTM)
+  if (cell_to_gate_weights != nullptr) {
+    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
+        cell_to_gate_weights, n_cell, cell_state, n_batch, gate_input);
+  }
+  // Do layer normalization (if layer norm LSTM)
+  if (layer_norm_coefficients != nullptr) {
+    tensor_utils::MeanStddevNormalization(gate_input, gate_input, n_cell,
+                                          n_batch);
+    tensor_utils::VectorBatchVectorCwiseProduct(
+        layer_norm_coefficients, n_cell, gate_input, n_batch, gate_input);
+    tensor_utils::VectorBatchVectorAdd(gate_bias, n_cell, n_batch, gate_input);
+  }
+  // Apply activation
+  tensor_utils::ApplyActivationToVector(gate_input, n_batch * n_cell,
+                                        activation, gate);
+}
+
 // Calculates a single LSTM gate.
 //
 // Implements the following formula: (* is matrix multiply)
@@ -200,7 +228,6 @@ inline void CalculateLstmGateFloat(
     const TfLiteFusedActivation activation, float* gate,
     const bool is_input_all_zeros, const bool is_aux_input_all_zeros,
     float* output, bool recurrent_is_diag, CpuBackendContext* context) {
-  const bool use_peephole = (cell_to_gate_weights != nullptr);
   const bool use_layer_norm = (layer_norm_coefficients != nullptr);
 
   // Initialize scratch buffers with bias for regular lstm or initialize with
@@ -238,21 +265,29 @@ inline void CalculateLstmGateFloat(
                                         accumulation_buffer, output, n_cell,
                                         n_output, n_batch, context);
   }
-  // For each batch and cell: compute cell_weight .* cell_state (peephole LSTM)
-  if (use_peephole) {
-    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
-        cell_to_gate_weights, n_cell, cell_state, n_batch, output);
-  }
-  // Do layer normalization (if layer norm LSTM)
-  if (use_layer_norm) {
-    tensor_utils::MeanStddevNormalization(output, output, n_cell, n_batch);
-    tensor_utils::VectorBatchVectorCwiseProduct(layer_norm_coefficients, n_cell,
-                                                output, n_batch, output);
-    tensor_utils::VectorBatchVectorAdd(gate_bias, n_cell, n_batch, output);
-  }
-  // Apply activation
-  tensor_utils::ApplyActivationToVector(output, n_batch * n_cell, activation,
-                                        gate);
+  ActivateLstmGateFloat(output, cell_state, cell_to_gate_weights,
+                        layer_norm_coefficients, gate_bias, n_batch, n_cell,
+                        activation, gate);
+}
+
+// Computes the input contribution to an LSTM gate for `n_rows` input rows with
+// a single matrix multiplication, starting from `gate_bias`, or from zero if it
+// is null as with layer norm.
+void ProjectLstmInputFloat(const float* input,
+                           const float* input_to_gate_weights,
+                           const float* gate_bias, int n_rows, int n_input,
+                           int n_cell, float* projection,
+                           CpuBackendContext* context) {
+  tflite::FullyConnectedParams float_fc_params;
+  float_fc_params.float_activation_min = std::numeric_limits<float>::lowest();
+  float_fc_params.float_activation_max = std::numeric_limits<float>::max();
+  float_fc_params.lhs_cacheable = true;
+  float_fc_params.rhs_cacheable = false;
+  tflite::optimized_ops::FullyConnected(
+      float_fc_params, tflite::RuntimeShape({n_rows, n_input}), input,
+      tflite::RuntimeShape({n_cell, n_input}), input_to_gate_weights,
+      tflite::RuntimeShape({n_cell}), gate_bias,
+      tflite::RuntimeShape({n_rows, n_cell}), projection, context);
 }
 
 // Updates the LSTM cell state, used by both float and hybrid LSTM versions.
@@ -556,6 +591,9 @@ void CalculateLstmGateInteger8x8_16(
     const int8_t* input, const int8_t* input_to_gate_weights,
     const int32_t* input_to_gate_bias, const int32_t input_to_gate_scale_a,
     const int32_t input_to_gate_scale_b,
+    // Input contribution computed beforehand, replaces the input and weights
+    // above if not null.
+    const int16_t* input_projection,
     // Output state and weights
     const int8_t* output_state, const int8_t* recurrent_to_gate_weights,
     const int32_t* recurrent_to_gate_bias,
@@ -581,14 +619,18 @@ void CalculateLstmGateInteger8x8_16(
   const bool use_peephole = (cell_to_gate_weights != nullptr);
   const bool use_layer_norm = (layer_norm_coefficients != nullptr);
 
-  // Initialize scratch buffers with zeros. Note that unlike float and hybrid
-  // versions, bias is only used in layer normalization.
-  std::fill_n(gate, n_batch * n_cell, 0);
-  // For each batch and cell: compute input_weight * input.
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      input, input_to_gate_bias, input_to_gate_weights, input_to_gate_scale_a,
-      input_to_gate_scale_b, n_batch, n_input, n_cell, 0, scratch5, gate,
-      context);
+  if (input_projection != nullptr) {
+    std::copy_n(input_projection, n_batch * n_cell, gate);
+  } else {
+    // Initialize scratch buffers with zeros. Note that unlike float and hybrid
+    // versions, bias is only used in layer normalization.
+    std::fill_n(gate, n_batch * n_cell, 0);
+    // For each batch and cell: compute input_weight * input.
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input, input_to_gate_bias, input_to_gate_weights, input_to_gate_scale_a,
+        input_to_gate_scale_b, n_batch, n_input, n_cell, 0, scratch5, gate,
+        context);
+  }
   // Note: no aux_input.
 
   // For each batch and cell: compute recurrent_weight * output_state.
@@ -995,6 +1037,115 @@ inline void LstmStepFloat(
 // LINT.ThenChange(../tools/optimize/calibration/builtin_logging_ops/lstm.cc,\
 //                 ../experimental/kernels/fp16/lstm_eval.cc)
 
+// Same as LstmStepFloat, but the input contribution of the gates is already in
+// input_gate_input (null with CIFG), forget_gate_input, cell_gate_input and
+// output_gate_input, each of size 'n_batch * n_cell', which are overwritten.
+//
+// The output state is multiplied by the recurrent weights of all gates with a
+// single matrix multiplication, of packed_recurrent_weights_ptr of size
+// 'num_gates * n_cell * n_output' (see PackRecurrentWeightsFloat) into
+// recurrent_projections of size 'n_batch * num_gates * n_cell'. This is valid
+// because every gate uses the output state of the previous step, which is only
+// updated at the end of the step.
+inline void LstmStepFloatWithGateProjections(
+    float* input_gate_input, float* forget_gate_input, float* cell_gate_input,
+    float* output_gate_input, const float* packed_recurrent_weights_ptr,
+    const float* cell_to_input_weights_ptr,
+    const float* cell_to_forget_weights_ptr,
+    const float* cell_to_output_weights_ptr,
+    const float* input_layer_norm_coefficients_ptr,
+    const float* forget_layer_norm_coefficients_ptr,
+    const float* cell_layer_norm_coefficients_ptr,
+    const float* output_layer_norm_coefficients_ptr,
+    const float* input_gate_bias_ptr, const float* forget_gate_bias_ptr,
+    const float* cell_gate_bias_ptr, const float* output_gate_bias_ptr,
+    const float* projection_weights_ptr, const float* projection_bias_ptr,
+    const TfLiteLSTMParams* params, int n_batch, int n_cell, int n_output,
+    int output_batch_leading_dim, float* output_state_ptr,
+    float* cell_state_ptr, float* scratch0, float* scratch1, float* scratch2,
+    float* scratch3, float* scratch4, float* recurrent_projections,
+    float* output_ptr, CpuBackendContext* context) {
+  ruy::profiler::ScopeLabel label("LstmStepFloatWithGateProjections");
+  const bool use_cifg = (input_gate_input == nullptr);
+  const int num_gates = use_cifg ? 3 : 4;
+
+  // Make named scratch buffers.
+  float* input_gate_scratch = scratch0;
+  float* forget_gate_scratch = scratch1;
+  float* cell_gate_scratch = scratch2;
+  float* output_gate_scratch = scratch3;
+  float* accumulation_scratch_buffer = scratch4;
+
+  // For each batch: compute the recurrent contribution of all gates, then add
+  // it to the input contribution of each gate.
+  tflite::FullyConnectedParams float_fc_params;
+  float_fc_params.float_activation_min = std::numeric_limits<float>::lowest();
+  float_fc_params.float_activation_max = std::numeric_limits<float>::max();
+  float_fc_params.lhs_cacheable = true;
+  float_fc_params.rhs_cacheable = false;
+  tflite::optimized_ops::FullyConnected(
+      float_fc_params, tflite::RuntimeShape({n_batch, n_output}),
+      output_state_ptr, tflite::RuntimeShape({num_gates * n_cell, n_output}),
+      packed_recurrent_weights_ptr, tflite::RuntimeShape({num_gates * n_cell}),
+      /*optional_bias_data=*/nullptr,
+      tflite::RuntimeShape({n_batch, num_gates * n_cell}),
+      recurrent_projections, context);
+  float* const gate_inputs[] = {input_gate_input, forget_gate_input,
+                                cell_gate_input, output_gate_input};
+  for (int b = 0; b < n_batch; ++b) {
+    const float* batch_projections =
+        recurrent_projections + b * num_gates * n_cell;
+    for (float* gate_input : gate_inputs) {
+      if (gate_input == nullptr) continue;
+      tensor_utils::VectorBatchVectorAdd(
+          batch_projections, n_cell, /*n_batch=*/1, gate_input + b * n_cell);
+      batch_projections += n_cell;
+    }
+  }
+
+  if (!use_cifg) {
+    // Calculate the input gate. (If not CIFG.)
+    ActivateLstmGateFloat(input_gate_input, cell_state_ptr,
+                          cell_to_input_weights_ptr,
+                          input_layer_norm_coefficients_ptr,
+                          input_gate_bias_ptr, n_batch, n_cell,
+                          /*activation=*/kTfLiteActSigmoid, input_gate_scratch);
+  }
+  // Calculate the forget gate.
+  ActivateLstmGateFloat(forget_gate_input, cell_state_ptr,
+                        cell_to_forget_weights_ptr,
+                        forget_layer_norm_coefficients_ptr,
+                        forget_gate_bias_ptr, n_batch, n_cell,
+                        /*activation=*/kTfLiteActSigmoid, forget_gate_scratch);
+  // Calculate the cell update gate.
+  ActivateLstmGateFloat(cell_gate_input, /*cell_state=*/nullptr,
+                        /*cell_to_gate_weights=*/nullptr,
+                        cell_layer_norm_coefficients_ptr, cell_gate_bias_ptr,
+                        n_batch, n_cell, params->activation, cell_gate_scratch);
+  // Update the cell state.
+  UpdateLstmCellFloat(n_batch, n_cell, cell_state_ptr, input_gate_scratch,
+                      forget_gate_scratch, cell_gate_scratch, use_cifg,
+                      params->cell_clip);
+  // Calculate output gate.
+  ActivateLstmGateFloat(output_gate_input, cell_state_ptr,
+                        cell_to_output_weights_ptr,
+                        output_layer_norm_coefficients_ptr,
+                        output_gate_bias_ptr, n_batch, n_cell,
+                        /*activation=*/kTfLiteActSigmoid, output_gate_scratch);
+  // Update the output state.
+  CalculateLstmOutputFloat(n_batch, n_cell, n_output, cell_state_ptr,
+                           output_gate_scratch, params->activation,
+                           projection_weights_ptr, projection_bias_ptr,
+                           params->proj_clip, output_state_ptr, scratch2,
+                           accumulation_scratch_buffer, context);
+  // Copy output state to the output. Note that the output's rows may not be
+  // contiguous (output_batch_leading_dim != n_output).
+  for (int b = 0; b < n_batch; b++) {
+    std::copy_n(output_state_ptr + b * n_output, n_output,
+                output_ptr + b * output_batch_leading_dim);
+  }
+}
+
 // Same as above but with quantized weight matrices. In detail:
 // Input of size 'n_batch * n_input':
 //   input_ptr
@@ -1480,7 +1631,9 @@ inline void LstmStepInteger8x8_16(
     int n_input, int n_output, int8_t* output_state_ptr,
     int32_t output_state_zp, int16_t* cell_state_ptr, int8_t* output_ptr,
     int16_t* scratch0, int16_t* scratch1, int16_t* scratch2, int16_t* scratch3,
-    int8_t* scratch4, int32_t* scratch5, CpuBackendContext* context) {
+    int8_t* scratch4, int32_t* scratch5, const int16_t* input_gate_projection,
+    const int16_t* forget_gate_projection, const int16_t* cell_gate_projection,
+    const int16_t* output_gate_projection, CpuBackendContext* context) {
   ruy::profiler::ScopeLabel label("LstmStepInteger8x8_16");
   // Make named scratch buffers for the different gates.
   int16_t* input_gate_scratch = scratch0;
@@ -1512,7 +1665,7 @@ inline void LstmStepInteger8x8_16(
     CalculateLstmGateInteger8x8_16(
         input_ptr, input_to_input_weight_ptr, input_to_input_effective_bias,
         effective_input_to_input_scale_a, effective_input_to_input_scale_b,
-        output_state_ptr, recurrent_to_input_weight_ptr,
+        input_gate_projection, output_state_ptr, recurrent_to_input_weight_ptr,
         recurrent_to_input_effective_bias, effective_recurrent_to_input_scale_a,
         effective_recurrent_to_input_scale_b, cell_state_ptr,
         cell_to_input_weight_ptr, effective_cell_to_input_scale_a,
@@ -1525,7 +1678,7 @@ inline void LstmStepInteger8x8_16(
   CalculateLstmGateInteger8x8_16(
       input_ptr, input_to_forget_weight_ptr, input_to_forget_effective_bias,
       effective_input_to_forget_scale_a, effective_input_to_forget_scale_b,
-      output_state_ptr, recurrent_to_forget_weight_ptr,
+      forget_gate_projection, output_state_ptr, recurrent_to_forget_weight_ptr,
       recurrent_to_forget_effective_bias, effective_recurrent_to_forget_scale_a,
       effective_recurrent_to_forget_scale_b, cell_state_ptr,
       cell_to_forget_weight_ptr, effective_cell_to_forget_scale_a,
@@ -1538,7 +1691,7 @@ inline void LstmStepInteger8x8_16(
   CalculateLstmGateInteger8x8_16(
       input_ptr, input_to_cell_weight_ptr, input_to_cell_effective_bias,
       effective_input_to_cell_scale_a, effective_input_to_cell_scale_b,
-      output_state_ptr, recurrent_to_cell_weight_ptr,
+      cell_gate_projection, output_state_ptr, recurrent_to_cell_weight_ptr,
       recurrent_to_cell_effective_bias, effective_recurrent_to_cell_scale_a,
       effective_recurrent_to_cell_scale_b, cell_state_ptr,
       /*cell_to_gate_weights=*/nullptr, /*cell_to_gate_scale_a=*/0,
@@ -1554,7 +1707,7 @@ inline void LstmStepInteger8x8_16(
   CalculateLstmGateInteger8x8_16(
       input_ptr, input_to_output_weight_ptr, input_to_output_effective_bias,
       effective_input_to_output_scale_a, effective_input_to_output_scale_b,
-      output_state_ptr, recurrent_to_output_weight_ptr,
+      output_gate_projection, output_state_ptr, recurrent_to_output_weight_ptr,
       recurrent_to_output_effective_bias, effective_recurrent_to_output_scale_a,
       effective_recurrent_to_output_scale_b, cell_state_ptr,
       cell_to_output_weight_ptr, effective_cell_to_output_scale_a,
@@ -1789,6 +1942,22 @@ inline void LstmStepInteger8x8_8(
 
 }  // namespace
 
+void PackRecurrentWeightsFloat(const TfLiteTensor* recurrent_to_input_weights,
+                               const TfLiteTensor* recurrent_to_forget_weights,
+                               const TfLiteTensor* recurrent_to_cell_weights,
+                               const TfLiteTensor* recurrent_to_output_weights,
+                               TfLiteTensor* packed_weights) {
+  float* packed_weights_ptr = GetTensorData<float>(packed_weights);
+  for (const TfLiteTensor* weights :
+       {recurrent_to_input_weights, recurrent_to_forget_weights,
+        recurrent_to_cell_weights, recurrent_to_output_weights}) {
+    if (weights == nullptr) continue;
+    const int size = weights->dims->data[0] * weights->dims->data[1];
+    packed_weights_ptr =
+        std::copy_n(GetTensorData<float>(weights), size, packed_weights_ptr);
+  }
+}
+
 // LINT.IfChange
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
@@ -1819,7 +1988,9 @@ TfLiteStatus EvalFloat(
     TfLiteTensor* cell_state, TfLiteTensor* output,
     bool recurrent_to_input_is_diag, bool recurrent_to_forget_is_diag,
     bool recurrent_to_cell_is_diag, bool recurrent_to_output_is_diag,
-    CpuBackendContext* context) {
+    CpuBackendContext* context, TfLiteTensor* input_projections,
+    const TfLiteTensor* packed_recurrent_weights,
+    TfLiteTensor* recurrent_projections) {
   TF_LITE_ASSERT(input->dims->size >= 2 && input->dims->size <= 3);
 
   int max_time, n_batch;
@@ -1866,6 +2037,120 @@ TfLiteStatus EvalFloat(
 
   const int output_batch_leading_dim =
       output->dims->data[output->dims->size - 1];
+  const bool use_gate_projections =
+      input_projections != nullptr && packed_recurrent_weights != nullptr &&
+      recurrent_projections != nullptr && aux_input == nullptr &&
+      (use_cifg || !recurrent_to_input_is_diag) &&
+      !recurrent_to_forget_is_diag && !recurrent_to_cell_is_diag &&
+      !recurrent_to_output_is_diag;
+  if (use_gate_projections) {
+    // Each sequence, that is the whole input when time major and each batch
+    // otherwise, is processed in chunks of steps. The input contribution of a
+    // gate is computed for all the rows of a chunk at once, then the steps of
+    // the chunk only have to add the recurrent contribution.
+    const int rows_per_step = time_major ? n_batch : 1;
+    const int num_sequences = time_major ? 1 : n_batch;
+    const int chunk_steps =
+        GetInputProjectionChunkSteps(n_batch, max_time, time_major);
+    const int chunk_rows = chunk_steps * rows_per_step;
+    const float* input_to_gate_weights[] = {
+        GetTensorData<float>(input_to_input_weights),
+        GetTensorData<float>(input_to_forget_weights),
+        GetTensorData<float>(input_to_cell_weights),
+        GetTensorData<float>(input_to_output_weights)};
+    // With layer norm, the bias is added after the normalization.
+    const float* projection_biases[] = {
+        input_layer_norm_coefficients ? nullptr
+                                      : GetTensorData<float>(input_gate_bias),
+        forget_layer_norm_coefficients
+            ? nullptr
+            : GetTensorData<float>(forget_gate_bias),
+        cell_layer_norm_coefficients ? nullptr
+                                     : GetTensorData<float>(cell_gate_bias),
+        output_layer_norm_coefficients
+            ? nullptr
+            : GetTensorData<float>(output_gate_bias)};
+    float* gate_projections[4] = {};
+    float* projections_ptr = GetTensorData<float>(input_projections);
+    for (int g = 0; g < 4; ++g) {
+      if (input_to_gate_weights[g] == nullptr) continue;
+      gate_projections[g] = projections_ptr;
+      projections_ptr += chunk_rows * n_cell;
+    }
+
+    for (int b = 0; b < num_sequences; ++b) {
+      const float* sequence_input_ptr =
+          GetTensorData<float>(input) + b * max_time * n_input;
+      float* sequence_output_ptr = GetTensorData<float>(output) +
+                                   b * max_time * output_batch_leading_dim +
+                                   output_offset;
+      // Offset the {output,cell}_state and scratch pointers to the right
+      // batch when batch major.
+      float* output_state_ptr =
+          GetTensorData<float>(output_state) + b * output_batch_leading_dim;
+      float* cell_state_ptr = GetTensorData<float>(cell_state) + b * n_cell;
+      float* input_gate_scratch_ptr =
+          input_gate_scratch ? input_gate_scratch + b * n_cell : nullptr;
+      float* forget_gate_scratch_ptr = forget_gate_scratch + b * n_cell;
+      float* cell_gate_scratch_ptr = cell_gate_scratch + b * n_cell;
+      float* output_gate_scratch_ptr = output_gate_scratch + b * n_cell;
+
+      for (int chunk_start = 0; chunk_start < max_time;
+           chunk_start += chunk_steps) {
+        const int steps = std::min(chunk_steps, max_time - chunk_start);
+        // The chunk covers the steps [first_t, first_t + steps), which are run
+        // backwards if this is not the forward sequence.
+        const int first_t =
+            forward_sequence ? chunk_start : max_time - chunk_start - steps;
+        for (int g = 0; g < 4; ++g) {
+          if (gate_projections[g] == nullptr) continue;
+          ProjectLstmInputFloat(
+              sequence_input_ptr + first_t * rows_per_step * n_input,
+              input_to_gate_weights[g], projection_biases[g],
+              steps * rows_per_step, n_input, n_cell, gate_projections[g],
+              context);
+        }
+        for (int s = 0; s < steps; ++s) {
+          const int t_rel =
+              forward_sequence ? first_t + s : first_t + steps - 1 - s;
+          const int projection_offset =
+              (t_rel - first_t) * rows_per_step * n_cell;
+          float* step_projections[4] = {};
+          for (int g = 0; g < 4; ++g) {
+            if (gate_projections[g] == nullptr) continue;
+            step_projections[g] = gate_projections[g] + projection_offset;
+          }
+          LstmStepFloatWithGateProjections(
+              step_projections[0], step_projections[1], step_projections[2],
+              step_projections[3],
+              GetTensorData<float>(packed_recurrent_weights),
+              GetTensorData<float>(cell_to_input_weights),
+              GetTensorData<float>(cell_to_forget_weights),
+              GetTensorData<float>(cell_to_output_weights),
+              GetTensorData<float>(input_layer_norm_coefficients),
+              GetTensorData<float>(forget_layer_norm_coefficients),
+              GetTensorData<float>(cell_layer_norm_coefficients),
+              GetTensorData<float>(output_layer_norm_coefficients),
+              GetTensorData<float>(input_gate_bias),
+              GetTensorData<float>(forget_gate_bias),
+              GetTensorData<float>(cell_gate_bias),
+              GetTensorData<float>(output_gate_bias),
+              GetTensorData<float>(projection_weights),
+              GetTensorData<float>(projection_bias), params, rows_per_step,
+              n_cell, n_output, output_batch_leading_dim, output_state_ptr,
+              cell_state_ptr, input_gate_scratch_ptr, forget_gate_scratch_ptr,
+              cell_gate_scratch_ptr, output_gate_scratch_ptr,
+              accumulation_scratch_buffer,
+              GetTensorData<float>(recurrent_projections),
+              sequence_output_ptr +
+                  t_rel * rows_per_step * output_batch_leading_dim,
+              context);
+        }
+      }
+    }
+    return kTfLiteOk;
+  }
+
   if (time_major) {
     // Loop through the sequence.
     const int input_step = n_batch * n_input;
@@ -2305,7 +2590,8 @@ TfLiteStatus EvalInteger8x8_16(
     TfLiteTensor* output_state, TfLiteTensor* cell_state, TfLiteTensor* output,
     TfLiteTensor* scratch0, TfLiteTensor* scratch1, TfLiteTensor* scratch2,
     TfLiteTensor* scratch3, TfLiteTensor* scratch4, TfLiteTensor* scratch5,
-    CpuBackendContext* context) {
+    CpuBackendContext* context, TfLiteTensor* input_projections,
+    TfLiteTensor* input_projection_scratch) {
   TF_LITE_ASSERT(input->dims->size >= 2 && input->dims->size <= 3);
   const int n_input = input->dims->data[input->dims->size - 1];
   int max_time, n_batch;
@@ -2328,112 +2614,95 @@ TfLiteStatus EvalInteger8x8_16(
   const int output_batch_leading_dim =
       output->dims->data[output->dims->size - 1];
 
-  if (time_major) {
-    const int input_step = n_batch * n_input;
-    const int output_step = n_batch * output_batch_leading_dim;
-    for (int t = 0; t < max_time; t++) {
-      const int t_rel = t;
-      int8_t* output_ptr = GetTensorData<int8_t>(output) + t_rel * output_step;
-      const int8_t* input_ptr =
-          GetTensorData<int8_t>(input) + t_rel * input_step;
-      LstmStepInteger8x8_16(
-          input_ptr, GetTensorData<int8_t>(input_to_input_weights),
-          integer_lstm_param->effective_input_to_input_scale_a,
-          integer_lstm_param->effective_input_to_input_scale_b,
-          GetTensorData<int8_t>(input_to_forget_weights),
-          integer_lstm_param->effective_input_to_forget_scale_a,
-          integer_lstm_param->effective_input_to_forget_scale_b,
-          GetTensorData<int8_t>(input_to_cell_weights),
-          integer_lstm_param->effective_input_to_cell_scale_a,
-          integer_lstm_param->effective_input_to_cell_scale_b,
-          GetTensorData<int8_t>(input_to_output_weights),
-          integer_lstm_param->effective_input_to_output_scale_a,
-          integer_lstm_param->effective_input_to_output_scale_b,
-          GetTensorData<int8_t>(recurrent_to_input_weights),
-          integer_lstm_param->effective_recurrent_to_input_scale_a,
-          integer_lstm_param->effective_recurrent_to_input_scale_b,
-          GetTensorData<int8_t>(recurrent_to_forget_weights),
-          integer_lstm_param->effective_recurrent_to_forget_scale_a,
-          integer_lstm_param->effective_recurrent_to_forget_scale_b,
-          GetTensorData<int8_t>(recurrent_to_cell_weights),
-          integer_lstm_param->effective_recurrent_to_cell_scale_a,
-          integer_lstm_param->effective_recurrent_to_cell_scale_b,
-          GetTensorData<int8_t>(recurrent_to_output_weights),
-          integer_lstm_param->effective_recurrent_to_output_scale_a,
-          integer_lstm_param->effective_recurrent_to_output_scale_b,
-          GetTensorData<int16_t>(cell_to_input_weights),
-          integer_lstm_param->effective_cell_to_input_scale_a,
-          integer_lstm_param->effective_cell_to_input_scale_b,
-          GetTensorData<int16_t>(cell_to_forget_weights),
-          integer_lstm_param->effective_cell_to_forget_scale_a,
-          integer_lstm_param->effective_cell_to_forget_scale_b,
-          GetTensorData<int16_t>(cell_to_output_weights),
-          integer_lstm_param->effective_cell_to_output_scale_a,
-          integer_lstm_param->effective_cell_to_output_scale_b,
-          GetTensorData<int8_t>(projection_weights),
-          integer_lstm_param->effective_proj_scale_a,
-          integer_lstm_param->effective_proj_scale_b,
-          integer_lstm_param->hidden_zp,
-          integer_lstm_param->effective_hidden_scale_a,
-          integer_lstm_param->effective_hidden_scale_b,
-          GetTensorData<int16_t>(input_layer_norm_coefficients),
-          integer_lstm_param->layer_norm_input_scale_a,
-          integer_lstm_param->layer_norm_input_scale_b,
-          GetTensorData<int16_t>(forget_layer_norm_coefficients),
-          integer_lstm_param->layer_norm_forget_scale_a,
-          integer_lstm_param->layer_norm_forget_scale_b,
-          GetTensorData<int16_t>(cell_layer_norm_coefficients),
-          integer_lstm_param->layer_norm_cell_scale_a,
-          integer_lstm_param->layer_norm_cell_scale_b,
-          GetTensorData<int16_t>(output_layer_norm_coefficients),
-          integer_lstm_param->layer_norm_output_scale_a,
-          integer_lstm_param->layer_norm_output_scale_b,
-          GetTensorData<int32_t>(input_gate_bias),
-          GetTensorData<int32_t>(forget_gate_bias),
-          GetTensorData<int32_t>(cell_gate_bias),
-          GetTensorData<int32_t>(output_gate_bias),
-          integer_lstm_param->quantized_cell_clip,
-          integer_lstm_param->quantized_proj_clip,
-          integer_lstm_param->cell_scale,
-          integer_lstm_param->input_variance_guard,
-          integer_lstm_param->forget_variance_guard,
-          integer_lstm_param->cell_variance_guard,
-          integer_lstm_param->output_variance_guard,
-          integer_lstm_param->input_to_forget_effective_bias.get(),
-          integer_lstm_param->recurrent_to_forget_effective_bias.get(),
-          integer_lstm_param->input_to_cell_effective_bias.get(),
-          integer_lstm_param->recurrent_to_cell_effective_bias.get(),
-          integer_lstm_param->input_to_output_effective_bias.get(),
-          integer_lstm_param->recurrent_to_output_effective_bias.get(),
-          integer_lstm_param->input_to_input_effective_bias.get(),
-          integer_lstm_param->recurrent_to_input_effective_bias.get(),
-          integer_lstm_param->projection_effective_bias.get(), n_batch, n_cell,
-          n_input, n_output, GetTensorData<int8_t>(output_state),
-          output_state_zp, GetTensorData<int16_t>(cell_state), output_ptr,
-          GetTensorData<int16_t>(scratch0), GetTensorData<int16_t>(scratch1),
-          GetTensorData<int16_t>(scratch2), GetTensorData<int16_t>(scratch3),
-          GetTensorData<int8_t>(scratch4), GetTensorData<int32_t>(scratch5),
-          context);
+  // Each sequence, that is the whole input when time major and each batch
+  // otherwise, is processed in chunks of steps. With input projections, the
+  // input contribution of a gate is computed for all the rows of a chunk at
+  // once, otherwise the chunks are single steps.
+  const bool use_input_projections =
+      input_projections != nullptr && input_projection_scratch != nullptr;
+  const int rows_per_step = time_major ? n_batch : 1;
+  const int num_sequences = time_major ? 1 : n_batch;
+  // The time major sequence always steps forward.
+  const bool step_forward = time_major || forward_sequence;
+  const int chunk_steps =
+      use_input_projections
+          ? GetInputProjectionChunkSteps(n_batch, max_time, time_major)
+          : 1;
+  const int chunk_rows = chunk_steps * rows_per_step;
+  const int8_t* input_to_gate_weights[] = {
+      GetTensorData<int8_t>(input_to_input_weights),
+      GetTensorData<int8_t>(input_to_forget_weights),
+      GetTensorData<int8_t>(input_to_cell_weights),
+      GetTensorData<int8_t>(input_to_output_weights)};
+  const int32_t* input_to_gate_effective_biases[] = {
+      integer_lstm_param->input_to_input_effective_bias.get(),
+      integer_lstm_param->input_to_forget_effective_bias.get(),
+      integer_lstm_param->input_to_cell_effective_bias.get(),
+      integer_lstm_param->input_to_output_effective_bias.get()};
+  const int32_t input_to_gate_scales_a[] = {
+      integer_lstm_param->effective_input_to_input_scale_a,
+      integer_lstm_param->effective_input_to_forget_scale_a,
+      integer_lstm_param->effective_input_to_cell_scale_a,
+      integer_lstm_param->effective_input_to_output_scale_a};
+  const int32_t input_to_gate_scales_b[] = {
+      integer_lstm_param->effective_input_to_input_scale_b,
+      integer_lstm_param->effective_input_to_forget_scale_b,
+      integer_lstm_param->effective_input_to_cell_scale_b,
+      integer_lstm_param->effective_input_to_output_scale_b};
+  int16_t* gate_projections[4] = {};
+  if (use_input_projections) {
+    int16_t* projections_ptr = GetTensorData<int16_t>(input_projections);
+    for (int g = 0; g < 4; ++g) {
+      if (input_to_gate_weights[g] == nullptr) continue;
+      gate_projections[g] = projections_ptr;
+      projections_ptr += chunk_rows * n_cell;
     }
-  } else {
-    for (int b = 0; b < n_batch; b++) {
-      const int input_step = n_input;
-      const int output_step = output_batch_leading_dim;
-      for (int t = 0; t < max_time; t++) {
-        // If this is the forward_sequence, step forward, otherwise step
-        // backwards.
-        const int t_rel = forward_sequence ? t : max_time - t - 1;
-        const int time_offset = b * max_time + t_rel;
-        const int8_t* input_ptr =
-            GetTensorData<int8_t>(input) + time_offset * input_step;
-        int8_t* output_ptr =
-            GetTensorData<int8_t>(output) + time_offset * output_step;
+  }
 
-        // Offset the {output,cell}_state pointers to the right batch.
-        int8_t* output_state_ptr =
-            GetTensorData<int8_t>(output_state) + b * output_batch_leading_dim;
-        int16_t* cell_state_ptr =
-            GetTensorData<int16_t>(cell_state) + b * n_cell;
+  for (int b = 0; b < num_sequences; ++b) {
+    const int8_t* sequence_input_ptr =
+        GetTensorData<int8_t>(input) + b * max_time * n_input;
+    int8_t* sequence_output_ptr =
+        GetTensorData<int8_t>(output) + b * max_time * output_batch_leading_dim;
+    // Offset the {output,cell}_state pointers to the right batch when batch
+    // major.
+    int8_t* output_state_ptr =
+        GetTensorData<int8_t>(output_state) + b * output_batch_leading_dim;
+    int16_t* cell_state_ptr = GetTensorData<int16_t>(cell_state) + b * n_cell;
+
+    for (int chunk_start = 0; chunk_start < max_time;
+         chunk_start += chunk_steps) {
+      const int steps = std::min(chunk_steps, max_time - chunk_start);
+      // The chunk covers the steps [first_t, first_t + steps), which are run
+      // backwards if this is not the forward sequence.
+      const int first_t =
+          step_forward ? chunk_start : max_time - chunk_start - steps;
+      if (use_input_projections) {
+        for (int g = 0; g < 4; ++g) {
+          if (gate_projections[g] == nullptr) continue;
+          std::fill_n(gate_projections[g], steps * rows_per_step * n_cell, 0);
+          tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+              sequence_input_ptr + first_t * rows_per_step * n_input,
+              input_to_gate_effective_biases[g], input_to_gate_weights[g],
+              input_to_gate_scales_a[g], input_to_gate_scales_b[g],
+              steps * rows_per_step, n_input, n_cell, 0,
+              GetTensorData<int32_t>(input_projection_scratch),
+              gate_projections[g], context);
+        }
+      }
+      for (int s = 0; s < steps; ++s) {
+        const int t_rel = step_forward ? first_t + s : first_t + steps - 1 - s;
+        const int8_t* input_ptr =
+            sequence_input_ptr + t_rel * rows_per_step * n_input;
+        int8_t* output_ptr = sequence_output_ptr +
+                             t_rel * rows_per_step * output_batch_leading_dim;
+        const int projection_offset =
+            (t_rel - first_t) * rows_per_step * n_cell;
+        const int16_t* step_projections[4] = {};
+        for (int g = 0; g < 4; ++g) {
+          if (gate_projections[g] == nullptr) continue;
+          step_projections[g] = gate_projections[g] + projection_offset;
+        }
 
         LstmStepInteger8x8_16(
             input_ptr, GetTensorData<int8_t>(input_to_input_weights),
@@ -2506,12 +2775,14 @@ TfLiteStatus EvalInteger8x8_16(
             integer_lstm_param->recurrent_to_output_effective_bias.get(),
             integer_lstm_param->input_to_input_effective_bias.get(),
             integer_lstm_param->recurrent_to_input_effective_bias.get(),
-            integer_lstm_param->projection_effective_bias.get(), /*n_batch=*/1,
+            integer_lstm_param->projection_effective_bias.get(), rows_per_step,
             n_cell, n_input, n_output, output_state_ptr, output_state_zp,
             cell_state_ptr, output_ptr, GetTensorData<int16_t>(scratch0),
             GetTensorData<int16_t>(scratch1), GetTensorData<int16_t>(scratch2),
             GetTensorData<int16_t>(scratch3), GetTensorData<int8_t>(scratch4),
-            GetTensorData<int32_t>(scratch5), context);
+            GetTensorData<int32_t>(scratch5), step_projections[0],
+            step_projections[1], step_projections[2], step_projections[3],
+            context);
       }
     }
   }
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_LSTM_EVAL_H_
 #define TENSORFLOW_LITE_KERNELS_LSTM_EVAL_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 
@@ -95,6 +96,38 @@ struct IntegerLstmParameter {
   int32_t intermediate_zp[12];
 };
 
+// The float and integer 8x8_16 LSTMs can compute the input contribution of
+// every gate for a chunk of time steps with one matrix multiplication per gate,
+// before running the recurrent steps of the chunk. This is the number of input
+// rows, time steps times the batches of a step, that a chunk aims for.
+constexpr int kInputProjectionChunkRows = 64;
+
+// Returns the number of time steps in a chunk of input projections, which is
+// at least one step.
+inline int GetInputProjectionChunkSteps(int n_batch, int max_time,
+                                        bool time_major) {
+  const int rows_per_step = time_major ? n_batch : 1;
+  return std::max(
+      1, std::min(max_time, kInputProjectionChunkRows / rows_per_step));
+}
+
+// Returns the number of input rows in a chunk of input projections.
+inline int GetInputProjectionChunkRows(int n_batch, int max_time,
+                                       bool time_major) {
+  return GetInputProjectionChunkSteps(n_batch, max_time, time_major) *
+         (time_major ? n_batch : 1);
+}
+
+// Copies the float recurrent weights of the input (unless CIFG), forget, cell
+// and output gates into the rows of `packed_weights`, which is of size
+// [num_gates * n_cell, n_output], so that EvalFloat can multiply the output
+// state by the weights of all gates at once.
+void PackRecurrentWeightsFloat(const TfLiteTensor* recurrent_to_input_weights,
+                               const TfLiteTensor* recurrent_to_forget_weights,
+                               const TfLiteTensor* recurrent_to_cell_weights,
+                               const TfLiteTensor* recurrent_to_output_weights,
+                               TfLiteTensor* packed_weights);
+
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
@@ -124,7 +157,16 @@ TfLiteStatus EvalFloat(
     TfLiteTensor* cell_state, TfLiteTensor* output,
     bool recurrent_to_input_is_diag, bool recurrent_to_forget_is_diag,
     bool recurrent_to_cell_is_diag, bool recurrent_to_output_is_diag,
-    CpuBackendContext* context);
+    CpuBackendContext* context,
+    // Optional buffers of the batched gate projections, used when none of the
+    // recurrent weights is diagonal and there is no auxiliary input:
+    //   input_projections: [num_gates * chunk_rows, n_cell], see
+    //     GetInputProjectionChunkRows.
+    //   packed_recurrent_weights: see PackRecurrentWeightsFloat.
+    //   recurrent_projections: [n_batch, num_gates * n_cell].
+    TfLiteTensor* input_projections = nullptr,
+    const TfLiteTensor* packed_recurrent_weights = nullptr,
+    TfLiteTensor* recurrent_projections = nullptr);
 
 TfLiteStatus EvalHybrid(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
@@ -198,7 +240,13 @@ TfLiteStatus EvalInteger8x8_16(
     TfLiteTensor* output_state, TfLiteTensor* cell_state, TfLiteTensor* output,
     TfLiteTensor* scratch0, TfLiteTensor* scratch1, TfLiteTensor* scratch2,
     TfLiteTensor* scratch3, TfLiteTensor* scratch4, TfLiteTensor* scratch5,
-    CpuBackendContext* context);
+    CpuBackendContext* context,
+    // Optional buffers of the batched input projections:
+    //   input_projections: int16 [num_gates * chunk_rows, n_cell], see
+    //     GetInputProjectionChunkRows.
+    //   input_projection_scratch: int32 [chunk_rows, n_cell].
+    TfLiteTensor* input_projections = nullptr,
+    TfLiteTensor* input_projection_scratch = nullptr);
 
 TfLiteStatus EvalInteger8x8_8(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
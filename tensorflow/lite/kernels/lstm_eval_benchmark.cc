@@ -0,0 +1,305 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Measures the latency per time step of the float and the int8x8_16 LSTM
+// evaluation of lstm_eval.h, step by step against the batched gate
+// projections, for a time major sequence.
+//
+// Usage: lstm_eval_benchmark [max_time] [num_threads]
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "tensorflow/lite/core/c/builtin_op_data.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/lstm_eval.h"
+
+namespace tflite {
+namespace ops {
+namespace builtin {
+namespace lstm_eval {
+namespace {
+
+// Returns the average time in microseconds of `fn` over about 0.2 seconds.
+template <typename Fn>
+double TimeMicros(Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  fn();
+  int iterations = 0;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point end;
+  do {
+    fn();
+    ++iterations;
+    end = Clock::now();
+  } while (end - start < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+// A tensor owning its data, filled with small random values.
+template <typename T>
+class Tensor {
+ public:
+  Tensor(TfLiteType type, const std::vector<int>& dims,
+         std::mt19937* random_engine) {
+    int size = 1;
+    for (int dim : dims) size *= dim;
+    data_.resize(size);
+    // Floats are in [-0.5, 0.5], integers in [-8, 8].
+    const double scale = std::is_floating_point<T>::value ? 1.0 / 16 : 1.0;
+    std::uniform_int_distribution<int> dist(-8, 8);
+    for (T& value : data_) {
+      value = static_cast<T>(dist(*random_engine) * scale);
+    }
+    tensor_.type = type;
+    tensor_.dims = TfLiteIntArrayCreate(dims.size());
+    for (int i = 0; i < dims.size(); ++i) tensor_.dims->data[i] = dims[i];
+    tensor_.data.data = data_.data();
+    tensor_.bytes = size * sizeof(T);
+  }
+  ~Tensor() { TfLiteIntArrayFree(tensor_.dims); }
+
+  TfLiteTensor* get() { return &tensor_; }
+
+ private:
+  std::vector<T> data_;
+  TfLiteTensor tensor_ = {};
+};
+
+// The tensors of an LSTM without peephole, layer norm nor projection, with
+// n_output == n_cell.
+template <typename T, typename BiasT>
+struct LstmTensors {
+  LstmTensors(TfLiteType type, TfLiteType bias_type, int max_time, int n_batch,
+              int n_input, int n_cell, std::mt19937* random_engine)
+      : input(type, {max_time, n_batch, n_input}, random_engine),
+        output(type, {max_time, n_batch, n_cell}, random_engine) {
+    for (int g = 0; g < 4; ++g) {
+      input_weights.emplace_back(
+          new Tensor<T>(type, {n_cell, n_input}, random_engine));
+      recurrent_weights.emplace_back(
+          new Tensor<T>(type, {n_cell, n_cell}, random_engine));
+      biases.emplace_back(
+          new Tensor<BiasT>(bias_type, {n_cell}, random_engine));
+    }
+  }
+
+  Tensor<T> input;
+  Tensor<T> output;
+  std::vector<std::unique_ptr<Tensor<T>>> input_weights;
+  std::vector<std::unique_ptr<Tensor<T>>> recurrent_weights;
+  std::vector<std::unique_ptr<Tensor<BiasT>>> biases;
+};
+
+// Returns the time in microseconds per step of the float evaluation.
+double TimeFloat(int max_time, int n_batch, int n_input, int n_cell,
+                 bool use_gate_projections, CpuBackendContext* context) {
+  std::mt19937 random_engine(42);
+  LstmTensors<float, float> lstm(kTfLiteFloat32, kTfLiteFloat32, max_time,
+                                 n_batch, n_input, n_cell, &random_engine);
+  Tensor<float> output_state(kTfLiteFloat32, {n_batch, n_cell},
+                             &random_engine);
+  Tensor<float> cell_state(kTfLiteFloat32, {n_batch, n_cell}, &random_engine);
+  Tensor<float> scratch_buffer(kTfLiteFloat32, {n_batch, n_cell * 5 + 16},
+                               &random_engine);
+  const int chunk_rows = GetInputProjectionChunkRows(n_batch, max_time,
+                                                     /*time_major=*/true);
+  Tensor<float> input_projections(kTfLiteFloat32, {4 * chunk_rows, n_cell},
+                                  &random_engine);
+  Tensor<float> packed_weights(kTfLiteFloat32, {4 * n_cell, n_cell},
+                               &random_engine);
+  Tensor<float> recurrent_projections(kTfLiteFloat32, {n_batch, 4 * n_cell},
+                                      &random_engine);
+  PackRecurrentWeightsFloat(
+      lstm.recurrent_weights[0]->get(), lstm.recurrent_weights[1]->get(),
+      lstm.recurrent_weights[2]->get(), lstm.recurrent_weights[3]->get(),
+      packed_weights.get());
+  TfLiteLSTMParams params = {};
+  params.activation = kTfLiteActTanh;
+
+  return TimeMicros([&] {
+           EvalFloat(
+               lstm.input.get(), lstm.input_weights[0]->get(),
+               lstm.input_weights[1]->get(), lstm.input_weights[2]->get(),
+               lstm.input_weights[3]->get(), lstm.recurrent_weights[0]->get(),
+               lstm.recurrent_weights[1]->get(),
+               lstm.recurrent_weights[2]->get(),
+               lstm.recurrent_weights[3]->get(),
+               /*cell_to_input_weights=*/nullptr,
+               /*cell_to_forget_weights=*/nullptr,
+               /*cell_to_output_weights=*/nullptr,
+               /*input_layer_norm_coefficients=*/nullptr,
+               /*forget_layer_norm_coefficients=*/nullptr,
+               /*cell_layer_norm_coefficients=*/nullptr,
+               /*output_layer_norm_coefficients=*/nullptr,
+               /*aux_input=*/nullptr, /*aux_input_to_input_weights=*/nullptr,
+               /*aux_input_to_forget_weights=*/nullptr,
+               /*aux_input_to_cell_weights=*/nullptr,
+               /*aux_input_to_output_weights=*/nullptr,
+               lstm.biases[0]->get(), lstm.biases[1]->get(),
+               lstm.biases[2]->get(), lstm.biases[3]->get(),
+               /*projection_weights=*/nullptr, /*projection_bias=*/nullptr,
+               &params, /*forward_sequence=*/true, /*time_major=*/true,
+               /*output_offset=*/0, scratch_buffer.get(), output_state.get(),
+               cell_state.get(), lstm.output.get(),
+               /*recurrent_to_input_is_diag=*/false,
+               /*recurrent_to_forget_is_diag=*/false,
+               /*recurrent_to_cell_is_diag=*/false,
+               /*recurrent_to_output_is_diag=*/false, context,
+               use_gate_projections ? input_projections.get() : nullptr,
+               use_gate_projections ? packed_weights.get() : nullptr,
+               use_gate_projections ? recurrent_projections.get() : nullptr);
+         }) /
+         max_time;
+}
+
+// Returns the time in microseconds per step of the int8x8_16 evaluation.
+double TimeInteger8x8_16(int max_time, int n_batch, int n_input, int n_cell,
+                         bool use_gate_projections,
+                         CpuBackendContext* context) {
+  std::mt19937 random_engine(42);
+  LstmTensors<int8_t, int32_t> lstm(kTfLiteInt8, kTfLiteInt32, max_time,
+                                    n_batch, n_input, n_cell, &random_engine);
+  Tensor<int8_t> output_state(kTfLiteInt8, {n_batch, n_cell}, &random_engine);
+  Tensor<int16_t> cell_state(kTfLiteInt16, {n_batch, n_cell}, &random_engine);
+  std::vector<std::unique_ptr<Tensor<int16_t>>> scratch;
+  for (int i = 0; i < 4; ++i) {
+    scratch.emplace_back(
+        new Tensor<int16_t>(kTfLiteInt16, {n_batch, n_cell}, &random_engine));
+  }
+  Tensor<int8_t> scratch4(kTfLiteInt8, {n_batch, n_cell}, &random_engine);
+  Tensor<int32_t> scratch5(kTfLiteInt32, {n_batch, n_cell}, &random_engine);
+  const int chunk_rows = GetInputProjectionChunkRows(n_batch, max_time,
+                                                     /*time_major=*/true);
+  Tensor<int16_t> input_projections(kTfLiteInt16, {4 * chunk_rows, n_cell},
+                                    &random_engine);
+  Tensor<int32_t> input_projection_scratch(kTfLiteInt32, {chunk_rows, n_cell},
+                                           &random_engine);
+
+  // Effective scales of 1/4, which keep the gates in range.
+  IntegerLstmParameter integer_lstm_param = {};
+  int32_t* scales[][2] = {
+      {&integer_lstm_param.effective_input_to_input_scale_a,
+       &integer_lstm_param.effective_input_to_input_scale_b},
+      {&integer_lstm_param.effective_recurrent_to_input_scale_a,
+       &integer_lstm_param.effective_recurrent_to_input_scale_b},
+      {&integer_lstm_param.effective_input_to_forget_scale_a,
+       &integer_lstm_param.effective_input_to_forget_scale_b},
+      {&integer_lstm_param.effective_recurrent_to_forget_scale_a,
+       &integer_lstm_param.effective_recurrent_to_forget_scale_b},
+      {&integer_lstm_param.effective_input_to_cell_scale_a,
+       &integer_lstm_param.effective_input_to_cell_scale_b},
+      {&integer_lstm_param.effective_recurrent_to_cell_scale_a,
+       &integer_lstm_param.effective_recurrent_to_cell_scale_b},
+      {&integer_lstm_param.effective_input_to_output_scale_a,
+       &integer_lstm_param.effective_input_to_output_scale_b},
+      {&integer_lstm_param.effective_recurrent_to_output_scale_a,
+       &integer_lstm_param.effective_recurrent_to_output_scale_b},
+      {&integer_lstm_param.effective_hidden_scale_a,
+       &integer_lstm_param.effective_hidden_scale_b}};
+  for (auto& scale : scales) {
+    *scale[0] = 1 << 30;
+    *scale[1] = -1;
+  }
+  integer_lstm_param.cell_scale = -11;
+  std::unique_ptr<int32_t[]>* effective_biases[] = {
+      &integer_lstm_param.input_to_forget_effective_bias,
+      &integer_lstm_param.recurrent_to_forget_effective_bias,
+      &integer_lstm_param.input_to_cell_effective_bias,
+      &integer_lstm_param.recurrent_to_cell_effective_bias,
+      &integer_lstm_param.input_to_output_effective_bias,
+      &integer_lstm_param.recurrent_to_output_effective_bias,
+      &integer_lstm_param.input_to_input_effective_bias,
+      &integer_lstm_param.recurrent_to_input_effective_bias};
+  for (std::unique_ptr<int32_t[]>* bias : effective_biases) {
+    bias->reset(new int32_t[n_cell]());
+  }
+  TfLiteLSTMParams params = {};
+  params.activation = kTfLiteActTanh;
+
+  return TimeMicros([&] {
+           EvalInteger8x8_16(
+               lstm.input.get(), lstm.input_weights[0]->get(),
+               lstm.input_weights[1]->get(), lstm.input_weights[2]->get(),
+               lstm.input_weights[3]->get(), lstm.recurrent_weights[0]->get(),
+               lstm.recurrent_weights[1]->get(),
+               lstm.recurrent_weights[2]->get(),
+               lstm.recurrent_weights[3]->get(),
+               /*cell_to_input_weights=*/nullptr,
+               /*cell_to_forget_weights=*/nullptr,
+               /*cell_to_output_weights=*/nullptr,
+               /*input_layer_norm_coefficients=*/nullptr,
+               /*forget_layer_norm_coefficients=*/nullptr,
+               /*cell_layer_norm_coefficients=*/nullptr,
+               /*output_layer_norm_coefficients=*/nullptr,
+               lstm.biases[0]->get(), lstm.biases[1]->get(),
+               lstm.biases[2]->get(), lstm.biases[3]->get(),
+               /*projection_weights=*/nullptr, /*projection_bias=*/nullptr,
+               &params, /*forward_sequence=*/true, /*time_major=*/true,
+               &integer_lstm_param, output_state.get(), cell_state.get(),
+               lstm.output.get(), scratch[0]->get(), scratch[1]->get(),
+               scratch[2]->get(), scratch[3]->get(), scratch4.get(),
+               scratch5.get(), context,
+               use_gate_projections ? input_projections.get() : nullptr,
+               use_gate_projections ? input_projection_scratch.get()
+                                    : nullptr);
+         }) /
+         max_time;
+}
+
+void Run(int max_time, int n_batch, int n_input, int n_cell,
+         CpuBackendContext* context) {
+  printf("%7d %7d %7d %14.2f %14.2f %14.2f %14.2f\n", n_batch, n_input, n_cell,
+         TimeFloat(max_time, n_batch, n_input, n_cell,
+                   /*use_gate_projections=*/false, context),
+         TimeFloat(max_time, n_batch, n_input, n_cell,
+                   /*use_gate_projections=*/true, context),
+         TimeInteger8x8_16(max_time, n_batch, n_input, n_cell,
+                           /*use_gate_projections=*/false, context),
+         TimeInteger8x8_16(max_time, n_batch, n_input, n_cell,
+                           /*use_gate_projections=*/true, context));
+}
+
+}  // namespace
+}  // namespace lstm_eval
+}  // namespace builtin
+}  // namespace ops
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  const int max_time = argc > 1 ? atoi(argv[1]) : 64;
+  const int num_threads = argc > 2 ? atoi(argv[2]) : 1;
+  tflite::CpuBackendContext context;
+  context.SetMaxNumThreads(num_threads);
+  printf("%d time steps, %d thread(s), microseconds per step\n", max_time,
+         num_threads);
+  printf("%7s %7s %7s %14s %14s %14s %14s\n", "batch", "input", "cell",
+         "float", "float batched", "int8", "int8 batched");
+  for (int n_batch : {1, 8}) {
+    for (int n_cell : {128, 512}) {
+      tflite::ops::builtin::lstm_eval::Run(max_time, n_batch,
+                                           /*n_input=*/n_cell, n_cell,
+                                           &context);
+    }
+  }
+  return 0;
+}
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <memory>
+#include <random>
+#include <tuple>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -493,6 +495,20 @@ class QuantizedLstmParam : public BaseLstmParam {
     scratch5_tensor_.data.i32 = scratch5_.data();
     return &scratch5_tensor_;
   }
+  TfLiteTensor* GetInputProjections() {
+    PackWeightToTensor(&input_projections_tensor_, input_projections_,
+                       input_projections_size_);
+    input_projections_tensor_.data.i16 = input_projections_.data();
+    return &input_projections_tensor_;
+  }
+  TfLiteTensor* GetInputProjectionScratch() {
+    PackWeightToTensor(&input_projection_scratch_tensor_,
+                       input_projection_scratch_,
+                       input_projection_scratch_size_);
+    input_projection_scratch_tensor_.data.i32 =
+        input_projection_scratch_.data();
+    return &input_projection_scratch_tensor_;
+  }
   TfLiteTensor* GetActivation() {
     PackWeightToTensor(&activation_tensor_, activation_, activation_size_);
     activation_tensor_.data.int8 = activation_.data();
@@ -516,6 +532,8 @@ class QuantizedLstmParam : public BaseLstmParam {
     TfLiteIntArrayFree(scratch3_tensor_.dims);
     TfLiteIntArrayFree(scratch4_tensor_.dims);
     TfLiteIntArrayFree(scratch5_tensor_.dims);
+    TfLiteIntArrayFree(input_projections_tensor_.dims);
+    TfLiteIntArrayFree(input_projection_scratch_tensor_.dims);
   }
 
  private:
@@ -599,9 +617,16 @@ class QuantizedLstmParam : public BaseLstmParam {
   std::vector<int32_t> scratch5_;
   std::vector<int32_t> scratch5_size_ = {n_batch_, n_cell_};
   TfLiteTensor scratch5_tensor_;
+  // The input of a single time step is one chunk of n_batch_ rows.
+  std::vector<int16_t> input_projections_;
+  std::vector<int32_t> input_projections_size_ = {4 * n_batch_, n_cell_};
+  TfLiteTensor input_projections_tensor_ = {};
+  std::vector<int32_t> input_projection_scratch_;
+  std::vector<int32_t> input_projection_scratch_size_ = {n_batch_, n_cell_};
+  TfLiteTensor input_projection_scratch_tensor_ = {};
 };
 
-void TestOneFullyQuantizedLSTM() {
+void TestOneFullyQuantizedLSTM(bool use_gate_projections) {
   CpuBackendContext context;
   QuantizedLstmParam one_parameter;
   auto activation = one_parameter.GetActivation();
@@ -621,7 +646,10 @@ void TestOneFullyQuantizedLSTM() {
       /*time_major=*/true, param, activation, cell, output,
       one_parameter.GetScratch0(), one_parameter.GetScratch1(),
       one_parameter.GetScratch2(), one_parameter.GetScratch3(),
-      one_parameter.GetScratch4(), one_parameter.GetScratch5(), &context);
+      one_parameter.GetScratch4(), one_parameter.GetScratch5(), &context,
+      use_gate_projections ? one_parameter.GetInputProjections() : nullptr,
+      use_gate_projections ? one_parameter.GetInputProjectionScratch()
+                           : nullptr);
 
   // Verify results.
   const std::vector<int16_t> expected_cell = {
@@ -636,7 +664,12 @@ void TestOneFullyQuantizedLSTM() {
 }
 
 TEST(TestOneFullyQuantizedLSTM, TestOneFullyQuantizedLSTM) {
-  TestOneFullyQuantizedLSTM();
+  TestOneFullyQuantizedLSTM(/*use_gate_projections=*/false);
+}
+
+// The input contributions computed ahead of the steps give the same results.
+TEST(TestOneFullyQuantizedLSTM, TestOneFullyQuantizedLSTMGateProjections) {
+  TestOneFullyQuantizedLSTM(/*use_gate_projections=*/true);
 }
 
 class HybridLstmParam : public BaseLstmParam {
@@ -969,5 +1002,142 @@ TEST(TestOneHybridAsymmLSTM, TestOneHybridAsymmLSTM) {
   TestOneHybridAsymmLSTM();
 }
 
+// A float tensor owning its data, filled with random values unless empty.
+class FloatTensor {
+ public:
+  FloatTensor(const std::vector<int>& dims, std::mt19937* random_engine) {
+    int size = 1;
+    for (int dim : dims) size *= dim;
+    data_.resize(size);
+    if (random_engine) {
+      std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+      for (float& value : data_) value = dist(*random_engine);
+    }
+    tensor_.type = kTfLiteFloat32;
+    tensor_.dims = TfLiteIntArrayCreate(dims.size());
+    for (int i = 0; i < dims.size(); ++i) tensor_.dims->data[i] = dims[i];
+    tensor_.data.f = data_.data();
+    tensor_.bytes = size * sizeof(float);
+  }
+  ~FloatTensor() { TfLiteIntArrayFree(tensor_.dims); }
+
+  TfLiteTensor* get() { return &tensor_; }
+  const std::vector<float>& data() const { return data_; }
+
+ private:
+  std::vector<float> data_;
+  TfLiteTensor tensor_ = {};
+};
+
+// Checks that computing the input contributions of the gates ahead of the
+// steps, in chunks of steps, and the recurrent ones with a single matrix for
+// all the gates gives the results of the step by step evaluation.
+class GateProjectionsFloatTest
+    : public ::testing::TestWithParam<std::tuple<bool, bool, bool>> {};
+
+TEST_P(GateProjectionsFloatTest, MatchesStepByStepEval) {
+  const bool time_major = std::get<0>(GetParam());
+  const bool forward_sequence = std::get<1>(GetParam());
+  const bool use_cifg = std::get<2>(GetParam());
+  // The sequence is longer than a chunk of steps.
+  const int n_batch = 2;
+  const int max_time = 70;
+  const int n_input = 5;
+  const int n_cell = 7;
+  const int n_output = 4;
+  std::mt19937 random_engine(42);
+  const auto make = [&](const std::vector<int>& dims) {
+    return std::make_unique<FloatTensor>(dims, &random_engine);
+  };
+  const auto make_gate = [&](const std::vector<int>& dims) {
+    return use_cifg ? nullptr : make(dims);
+  };
+  const auto get = [](const std::unique_ptr<FloatTensor>& tensor) {
+    return tensor ? tensor->get() : nullptr;
+  };
+
+  auto i2i = make_gate({n_cell, n_input});
+  auto i2f = make({n_cell, n_input});
+  auto i2c = make({n_cell, n_input});
+  auto i2o = make({n_cell, n_input});
+  auto r2i = make_gate({n_cell, n_output});
+  auto r2f = make({n_cell, n_output});
+  auto r2c = make({n_cell, n_output});
+  auto r2o = make({n_cell, n_output});
+  auto c2i = make_gate({n_cell});
+  auto c2f = make({n_cell});
+  auto c2o = make({n_cell});
+  auto input_layer_norm = make_gate({n_cell});
+  auto forget_layer_norm = make({n_cell});
+  auto cell_layer_norm = make({n_cell});
+  auto output_layer_norm = make({n_cell});
+  auto input_bias = make_gate({n_cell});
+  auto forget_bias = make({n_cell});
+  auto cell_bias = make({n_cell});
+  auto output_bias = make({n_cell});
+  auto projection = make({n_output, n_cell});
+  auto projection_bias = make({n_output});
+  auto input = make(time_major ? std::vector<int>{max_time, n_batch, n_input}
+                               : std::vector<int>{n_batch, max_time, n_input});
+  const std::vector<int> output_dims =
+      time_major ? std::vector<int>{max_time, n_batch, n_output}
+                 : std::vector<int>{n_batch, max_time, n_output};
+  TfLiteLSTMParams params = {};
+  params.activation = kTfLiteActTanh;
+
+  const int num_gates = use_cifg ? 3 : 4;
+  const int chunk_rows = ops::builtin::lstm_eval::GetInputProjectionChunkRows(
+      n_batch, max_time, time_major);
+  std::vector<float> results[2];
+  for (bool use_gate_projections : {false, true}) {
+    std::mt19937 state_random_engine(7);
+    FloatTensor output_state({n_batch, n_output}, &state_random_engine);
+    FloatTensor cell_state({n_batch, n_cell}, &state_random_engine);
+    FloatTensor output(output_dims, nullptr);
+    FloatTensor scratch_buffer({n_batch, n_cell * 5 + 16}, nullptr);
+    FloatTensor input_projections({num_gates * chunk_rows, n_cell}, nullptr);
+    FloatTensor packed_weights({num_gates * n_cell, n_output}, nullptr);
+    FloatTensor recurrent_projections({n_batch, num_gates * n_cell}, nullptr);
+    ops::builtin::lstm_eval::PackRecurrentWeightsFloat(
+        get(r2i), r2f->get(), r2c->get(), r2o->get(), packed_weights.get());
+    CpuBackendContext context;
+    ASSERT_EQ(
+        ops::builtin::lstm_eval::EvalFloat(
+            input->get(), get(i2i), i2f->get(), i2c->get(), i2o->get(),
+            get(r2i), r2f->get(), r2c->get(), r2o->get(), get(c2i),
+            c2f->get(), c2o->get(), get(input_layer_norm),
+            forget_layer_norm->get(), cell_layer_norm->get(),
+            output_layer_norm->get(), /*aux_input=*/nullptr,
+            /*aux_input_to_input_weights=*/nullptr,
+            /*aux_input_to_forget_weights=*/nullptr,
+            /*aux_input_to_cell_weights=*/nullptr,
+            /*aux_input_to_output_weights=*/nullptr, get(input_bias),
+            forget_bias->get(), cell_bias->get(), output_bias->get(),
+            projection->get(), projection_bias->get(), &params,
+            forward_sequence, time_major, /*output_offset=*/0,
+            scratch_buffer.get(), output_state.get(), cell_state.get(),
+            output.get(), /*recurrent_to_input_is_diag=*/use_cifg,
+            /*recurrent_to_forget_is_diag=*/false,
+            /*recurrent_to_cell_is_diag=*/false,
+            /*recurrent_to_output_is_diag=*/false, &context,
+            use_gate_projections ? input_projections.get() : nullptr,
+            use_gate_projections ? packed_weights.get() : nullptr,
+            use_gate_projections ? recurrent_projections.get() : nullptr),
+        kTfLiteOk);
+    std::vector<float>& result = results[use_gate_projections];
+    for (const FloatTensor* tensor : {&output, &output_state, &cell_state}) {
+      result.insert(result.end(), tensor->data().begin(),
+                    tensor->data().end());
+    }
+  }
+  EXPECT_TRUE(ArrayFloatNear(results[1].data(), results[0].data(),
+                             results[0].size(), 1e-5));
+}
+
+INSTANTIATE_TEST_SUITE_P(GateProjectionsFloatTest, GateProjectionsFloatTest,
+                         ::testing::Combine(::testing::Bool(),
+                                            ::testing::Bool(),
+                                            ::testing::Bool()));
+
 }  // namespace
 }  // namespace tflite
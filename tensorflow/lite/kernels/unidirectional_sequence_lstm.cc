@@ -48,6 +48,14 @@ struct OpData {
   bool recurrent_to_cell_is_diag = false;
   bool recurrent_to_output_is_diag = false;
 
+  // The index of the first tensor of the batched gate projections.
+  int gate_projections_tensor_index;
+  // The position of the first gate projection tensor in the node temporaries,
+  // or -1 if the gates are computed one by one.
+  int gate_projections_temporary = -1;
+  // Whether the packed recurrent weights hold the current weights.
+  bool recurrent_weights_packed = false;
+
   lstm_eval::IntegerLstmParameter integer_lstm_param;
 };
 
@@ -407,10 +415,34 @@ enum TemporaryTensor {
   kNumTemporaryTensors = 12,
 };
 
+// Temporary tensors of the batched gate projections of the float and integer
+// 8x8_16 kernels, which follow their scratch buffers in the node temporaries.
+enum GateProjectionTensor {
+  // The input contribution to the gates of a chunk of steps, float or int16.
+  kInputProjections = 0,
+  // Float: the recurrent contribution to all gates of a step. Integer: the
+  // int32 accumulators of the input projections.
+  kProjectionScratch = 1,
+  // Float only: the recurrent weights of all gates, persistent.
+  kPackedRecurrentWeights = 2,
+  kNumGateProjectionTensors = 3,
+};
+
+// The number of gate projection temporaries the float or integer kernels use.
+int NumGateProjectionTensors(bool is_integer) {
+  return is_integer ? kPackedRecurrentWeights : kNumGateProjectionTensors;
+}
+
+// The number of scratch buffers of the float and integer kernels.
+constexpr int kNumFloatScratchTensors = 1;
+constexpr int kNumIntegerScratchTensors = 6;
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   auto* op_data = new OpData();
   context->AddTensors(context, kNumTemporaryTensors,
                       &op_data->scratch_tensor_index);
+  context->AddTensors(context, kNumGateProjectionTensors,
+                      &op_data->gate_projections_tensor_index);
   return op_data;
 }
 
@@ -878,6 +910,68 @@ TfLiteStatus PopulatePrecomputedZPTimesWeightsWithBias(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+// Resizes the gate projection temporary `tensor` of the node to [rows, cols].
+TfLiteStatus PrepareGateProjectionTensor(TfLiteContext* context,
+                                         TfLiteNode* node, OpData* op_data,
+                                         int tensor, TfLiteType type,
+                                         TfLiteAllocationType allocation_type,
+                                         int rows, int cols) {
+  const int temporary = op_data->gate_projections_temporary + tensor;
+  node->temporaries->data[temporary] =
+      op_data->gate_projections_tensor_index + tensor;
+  TfLiteTensor* temporary_tensor;
+  TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node, temporary,
+                                              &temporary_tensor));
+  temporary_tensor->type = type;
+  temporary_tensor->allocation_type = allocation_type;
+  const int dims[2] = {rows, cols};
+  if (!TfLiteIntArrayEqualsArray(temporary_tensor->dims, 2, dims)) {
+    TfLiteIntArray* size = TfLiteIntArrayCreate(2);
+    size->data[0] = rows;
+    size->data[1] = cols;
+    TF_LITE_ENSURE_OK(context,
+                      context->ResizeTensor(context, temporary_tensor, size));
+  }
+  return kTfLiteOk;
+}
+
+// Allocates the temporaries that let the float and integer 8x8_16 kernels
+// compute the input contribution to the gates for chunks of steps at once
+// and, for float, the recurrent contribution to all gates with a single
+// matrix multiplication. See lstm_eval::EvalFloat and EvalInteger8x8_16.
+TfLiteStatus PrepareGateProjections(TfLiteContext* context, TfLiteNode* node,
+                                    OpData* op_data, bool is_integer,
+                                    bool use_cifg, int n_batch, int max_time,
+                                    bool time_major, int n_cell,
+                                    int n_output) {
+  const int num_gates = use_cifg ? 3 : 4;
+  const int chunk_rows =
+      lstm_eval::GetInputProjectionChunkRows(n_batch, max_time, time_major);
+  if (is_integer) {
+    TF_LITE_ENSURE_OK(
+        context, PrepareGateProjectionTensor(
+                     context, node, op_data, kInputProjections, kTfLiteInt16,
+                     kTfLiteArenaRw, num_gates * chunk_rows, n_cell));
+    return PrepareGateProjectionTensor(context, node, op_data,
+                                       kProjectionScratch, kTfLiteInt32,
+                                       kTfLiteArenaRw, chunk_rows, n_cell);
+  }
+  TF_LITE_ENSURE_OK(
+      context, PrepareGateProjectionTensor(
+                   context, node, op_data, kInputProjections, kTfLiteFloat32,
+                   kTfLiteArenaRw, num_gates * chunk_rows, n_cell));
+  TF_LITE_ENSURE_OK(
+      context, PrepareGateProjectionTensor(
+                   context, node, op_data, kProjectionScratch, kTfLiteFloat32,
+                   kTfLiteArenaRw, n_batch, num_gates * n_cell));
+  // The recurrent weights are packed by the first invocation after they were
+  // (re)allocated.
+  op_data->recurrent_weights_packed = false;
+  return PrepareGateProjectionTensor(
+      context, node, op_data, kPackedRecurrentWeights, kTfLiteFloat32,
+      kTfLiteArenaRwPersistent, num_gates * n_cell, n_output);
+}
+
 // Resize the output and state tensors based on the sizes of the input tensors.
 // Allocate a temporary scratch tensor. Also check that the sizes of the input
 // tensors match each other.
@@ -984,13 +1078,35 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE(context, num_intermediate_tensors == 5);
   }
 
+  // The gates of the hybrid kernel, and of the float kernel with diagonal
+  // recurrent weights, are computed one by one.
+  const TfLiteTensor* recurrent_to_input_weights = GetOptionalInputTensor(
+      context, node, lstm::full::kRecurrentToInputWeightsTensor);
+  const TfLiteTensor* recurrent_to_forget_weights = GetOptionalInputTensor(
+      context, node, lstm::full::kRecurrentToForgetWeightsTensor);
+  const TfLiteTensor* recurrent_to_cell_weights = GetOptionalInputTensor(
+      context, node, lstm::full::kRecurrentToCellWeightsTensor);
+  const bool has_diagonal_recurrent_weights =
+      (recurrent_to_input_weights != nullptr &&
+       recurrent_to_input_weights->dims->size == 1) ||
+      recurrent_to_forget_weights->dims->size == 1 ||
+      recurrent_to_cell_weights->dims->size == 1 || recurrent_to_output_is_diag;
+  const bool use_gate_projections =
+      !IsHybridOp(input, input_to_output_weights) &&
+      (is_integer || !has_diagonal_recurrent_weights);
+
   TfLiteIntArrayFree(node->temporaries);
   if (IsHybridOp(input, input_to_output_weights)) {
     node->temporaries = TfLiteIntArrayCreate(kNumTemporaryTensors);
-  } else if (is_integer) {
-    node->temporaries = TfLiteIntArrayCreate(6);
+    op_data->gate_projections_temporary = -1;
   } else {
-    node->temporaries = TfLiteIntArrayCreate(1);
+    const int num_scratch_tensors =
+        is_integer ? kNumIntegerScratchTensors : kNumFloatScratchTensors;
+    node->temporaries = TfLiteIntArrayCreate(
+        num_scratch_tensors +
+        (use_gate_projections ? NumGateProjectionTensors(is_integer) : 0));
+    op_data->gate_projections_temporary =
+        use_gate_projections ? num_scratch_tensors : -1;
   }
   node->temporaries->data[kScratchBuffer] =
       scratch_tensor_index + kScratchBuffer;
@@ -1019,6 +1135,15 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, scratch_buffer,
                                                    scratch_buffer_size));
 
+  if (use_gate_projections) {
+    const int max_time =
+        time_major ? input->dims->data[0] : input->dims->data[1];
+    TF_LITE_ENSURE_OK(context,
+                      PrepareGateProjections(context, node, op_data, is_integer,
+                                             use_cifg, n_batch, max_time,
+                                             time_major, n_cell, n_output));
+  }
+
   if (IsHybridOp(input, input_to_output_weights)) {
     op_data->compute_row_sums = true;
     // Allocate temporary tensors to store quantized values of input,
@@ -1366,6 +1491,40 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       TfLiteTensor* scratch_buffer;
       TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node, kScratchBuffer,
                                                   &scratch_buffer));
+      TfLiteTensor* input_projections = nullptr;
+      TfLiteTensor* recurrent_projections = nullptr;
+      TfLiteTensor* packed_recurrent_weights = nullptr;
+      const int gate_projections = op_data->gate_projections_temporary;
+      if (gate_projections >= 0) {
+        TF_LITE_ENSURE_OK(
+            context,
+            GetTemporarySafe(context, node,
+                             gate_projections + kInputProjections,
+                             &input_projections));
+        TF_LITE_ENSURE_OK(
+            context,
+            GetTemporarySafe(context, node,
+                             gate_projections + kProjectionScratch,
+                             &recurrent_projections));
+        TF_LITE_ENSURE_OK(
+            context,
+            GetTemporarySafe(context, node,
+                             gate_projections + kPackedRecurrentWeights,
+                             &packed_recurrent_weights));
+        if (!op_data->recurrent_weights_packed) {
+          lstm_eval::PackRecurrentWeightsFloat(
+              recurrent_to_input_weights, recurrent_to_forget_weights,
+              recurrent_to_cell_weights, recurrent_to_output_weights,
+              packed_recurrent_weights);
+          // Weights that may change are packed again by every invocation.
+          op_data->recurrent_weights_packed =
+              (recurrent_to_input_weights == nullptr ||
+               IsConstantTensor(recurrent_to_input_weights)) &&
+              IsConstantTensor(recurrent_to_forget_weights) &&
+              IsConstantTensor(recurrent_to_cell_weights) &&
+              IsConstantTensor(recurrent_to_output_weights);
+        }
+      }
       return lstm_eval::EvalFloat(
           input, input_to_input_weights, input_to_forget_weights,
           input_to_cell_weights, input_to_output_weights,
@@ -1392,7 +1551,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           (recurrent_to_cell_weights->dims->size == 1),
           /*recurrent_to_output_is_diag=*/
           (recurrent_to_output_weights->dims->size == 1),
-          CpuBackendContext::GetFromContext(context));
+          CpuBackendContext::GetFromContext(context), input_projections,
+          packed_recurrent_weights, recurrent_projections);
     }
     case kTfLiteUInt8:
     case kTfLiteInt8: {
@@ -1479,6 +1639,21 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
         TfLiteTensor* scratch5;
         TF_LITE_ENSURE_OK(context,
                           GetTemporarySafe(context, node, 5, &scratch5));
+        TfLiteTensor* input_projections = nullptr;
+        TfLiteTensor* input_projection_scratch = nullptr;
+        const int gate_projections = op_data->gate_projections_temporary;
+        if (gate_projections >= 0) {
+          TF_LITE_ENSURE_OK(
+              context,
+              GetTemporarySafe(context, node,
+                               gate_projections + kInputProjections,
+                               &input_projections));
+          TF_LITE_ENSURE_OK(
+              context,
+              GetTemporarySafe(context, node,
+                               gate_projections + kProjectionScratch,
+                               &input_projection_scratch));
+        }
         return lstm_eval::EvalInteger8x8_16(
             input, input_to_input_weights, input_to_forget_weights,
             input_to_cell_weights, input_to_output_weights,
@@ -1492,7 +1667,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
             projection_bias, &lstm_params, /*forward_sequence=*/true,
             time_major, &op_data->integer_lstm_param, output_state, cell_state,
             output, scratch0, scratch1, scratch2, scratch3, scratch4, scratch5,
-            CpuBackendContext::GetFromContext(context));
+            CpuBackendContext::GetFromContext(context), input_projections,
+            input_projection_scratch);
       }
     }
     default:
@@ -2661,6 +2661,16 @@ class UnidirectionalSequenceLSTMIntegerOpModel : public SingleOpModel {
 
   std::vector<int8_t> GetOutput() { return ExtractVector<int8_t>(output_); }
 
+  // The temporary tensors of the LSTM node, as set by its Prepare.
+  std::vector<int> GetTemporaries() {
+    const TfLiteIntArray* temporaries =
+        interpreter_->node_and_registration(0)->first.temporaries;
+    return std::vector<int>(temporaries->data,
+                            temporaries->data + temporaries->size);
+  }
+
+  int num_tensors() { return interpreter_->tensors_size(); }
+
   int num_inputs() { return n_input_; }
   int num_outputs() { return n_output_; }
 
@@ -3021,6 +3031,44 @@ TEST(IntegerUnidirectionalSequenceLstmOpTest,
   EXPECT_THAT(lstm.GetOutput(), ElementsAreArray(expected_output));
 }
 
+TEST(IntegerUnidirectionalSequenceLstmOpTest, PrepareSetsAllTemporaries) {
+  // The temporaries of delegated nodes aren't set by Prepare.
+  if (SingleOpModel::GetForceUseNnapi()) {
+    return;
+  }
+  const int n_batch = 2;
+  const int n_input = 5;
+  const int n_cell = 4;
+  const int n_output = 3;
+  const int sequence_length = 3;
+
+  std::vector<std::pair<float, float>> ranges(25, {-1.0, 1.0});
+  ranges[0] = {-1.0, 127.0 / 128};  // input tensor
+  for (int i = 12; i < 16; ++i) ranges[i] = {-100, 100};  // gate biases
+  ranges[18] = {-1.0, 32767.0 / 32768};  // output_state tensor
+  ranges[24] = {-1.0, 32767.0 / 32768};  // output tensor
+  std::vector<std::pair<float, int>> intermediates = {
+      {0.007059, 0}, {0.007812, 0}, {0.007059, 0}, {0.007812, 0}, {0.007, 0}};
+
+  UnidirectionalSequenceLSTMIntegerOpModel lstm(
+      n_batch, n_input, n_cell, n_output, sequence_length, /*time_major=*/true,
+      /*use_cifg=*/false, /*use_peephole=*/false,
+      /*use_projection_weights=*/true,
+      /*use_projection_bias=*/false,
+      /*use_layer_norm=*/true,
+      /*use_8x8_8_implementation=*/false, ranges, intermediates);
+  lstm.PerformAllocateAndDelegate();
+
+  // The 6 scratch buffers of the integer kernel, followed by the input
+  // projections and their accumulators. Every temporary is a valid tensor.
+  const std::vector<int> temporaries = lstm.GetTemporaries();
+  EXPECT_EQ(temporaries.size(), 8);
+  for (int tensor : temporaries) {
+    EXPECT_GE(tensor, 0);
+    EXPECT_LT(tensor, lstm.num_tensors());
+  }
+}
+
 class IndyLSTMOpTest
     : public ::testing::TestWithParam<std::tuple<bool, bool, bool>> {};
 
@@ -14,13 +14,19 @@ limitations under the License.
 ==============================================================================*/
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/interpreter.h"
 #include "tensorflow/lite/core/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 
 namespace tflite {
@@ -221,5 +227,143 @@ TEST_F(VariableOpsTest, TestReassignToDifferentSize) {
   }
 }
 
+// Tests DYNAMIC_UPDATE_SLICE updating a variable in place, as decoding models
+// do with their KV caches.
+class InPlaceVariableUpdateTest : public VariableOpsTest {
+ protected:
+  // Construct a graph like this:
+  //   Input: %0 (update), %1 (start indices)
+  //   Output: %4, and %5 if `read_between`
+  //   %2 = var_handle()
+  //   %3 = read(%2)
+  //   %4 = dynamic_update_slice(%3, %0, %1)
+  //   %5 = read(%2)  if `read_between`
+  //   variable_assign(%2, %4)
+  void ConstructUpdateGraph(bool read_between) {
+    interpreter_ = std::make_unique<Interpreter>();
+    int first_new_tensor_index;
+    ASSERT_EQ(interpreter_->AddTensors(6, &first_new_tensor_index), kTfLiteOk);
+    ASSERT_EQ(interpreter_->SetInputs({0, 1}), kTfLiteOk);
+    if (read_between) {
+      ASSERT_EQ(interpreter_->SetOutputs({4, 5}), kTfLiteOk);
+    } else {
+      ASSERT_EQ(interpreter_->SetOutputs({4}), kTfLiteOk);
+    }
+    interpreter_->SetTensorParametersReadWrite(0, kTfLiteFloat32, "", {1, 2},
+                                               TfLiteQuantization());
+    interpreter_->SetTensorParametersReadWrite(1, kTfLiteInt32, "", {2},
+                                               TfLiteQuantization());
+    interpreter_->SetTensorParametersReadWrite(2, kTfLiteResource, "", 0,
+                                               nullptr, {}, false);
+    for (int i : {3, 4, 5}) {
+      interpreter_->SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {3, 2},
+                                                 TfLiteQuantization());
+    }
+
+    // The in-place update is matched on the builtin codes, which the op
+    // resolver sets when loading a model.
+    var_handle_ = *var_handle_registration_;
+    var_handle_.builtin_code = kTfLiteBuiltinVarHandle;
+    read_ = *read_registration_;
+    read_.builtin_code = kTfLiteBuiltinReadVariable;
+    assign_ = *assign_registration_;
+    assign_.builtin_code = kTfLiteBuiltinAssignVariable;
+    update_ = *::tflite::ops::builtin::Register_DYNAMIC_UPDATE_SLICE();
+    update_.builtin_code = kTfLiteBuiltinDynamicUpdateSlice;
+
+    int node_index;
+    interpreter_->AddNodeWithParameters({}, {2}, nullptr, 0,
+                                        GetVarHandleParams(), &var_handle_,
+                                        &node_index);
+    interpreter_->AddNodeWithParameters({2}, {3}, nullptr, 0, nullptr, &read_,
+                                        &node_index);
+    interpreter_->AddNodeWithParameters({3, 0, 1}, {4}, nullptr, 0, nullptr,
+                                        &update_, &node_index);
+    if (read_between) {
+      interpreter_->AddNodeWithParameters({2}, {5}, nullptr, 0, nullptr,
+                                          &read_, &node_index);
+    }
+    interpreter_->AddNodeWithParameters({2, 4}, {}, nullptr, 0, nullptr,
+                                        &assign_, &node_index);
+  }
+
+  // Initializes the variable with zeros.
+  void InitializeVariable() {
+    Subgraph& subgraph = interpreter_->primary_subgraph();
+    const int id = subgraph.resource_ids().at(
+        std::make_pair(std::string(kContainer), std::string(kSharedName)));
+    resource::CreateResourceVariableIfNotAvailable(&subgraph.resources(), id);
+    variable_ = resource::GetResourceVariable(&subgraph.resources(), id);
+    // Tensor %4 has the shape of the variable, and isn't allocated before
+    // the graph runs.
+    std::vector<float> zeros(6, 0.f);
+    TfLiteTensor value = *interpreter_->tensor(4);
+    value.data.raw = reinterpret_cast<char*>(zeros.data());
+    value.bytes = zeros.size() * sizeof(float);
+    ASSERT_EQ(variable_->AssignFrom(&value), kTfLiteOk);
+  }
+
+  void Update(const std::vector<float>& update,
+              const std::vector<int32_t>& start_indices) {
+    std::copy(update.begin(), update.end(),
+              GetTensorData<float>(interpreter_->tensor(0)));
+    std::copy(start_indices.begin(), start_indices.end(),
+              GetTensorData<int32_t>(interpreter_->tensor(1)));
+    ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  }
+
+  std::vector<float> GetValues(const TfLiteTensor* tensor) {
+    const float* data = GetTensorData<float>(tensor);
+    return std::vector<float>(data, data + 6);
+  }
+
+  TfLiteRegistration var_handle_;
+  TfLiteRegistration read_;
+  TfLiteRegistration assign_;
+  TfLiteRegistration update_;
+  resource::ResourceVariable* variable_ = nullptr;
+};
+
+TEST_F(InPlaceVariableUpdateTest, UpdatesVariable) {
+  ConstructUpdateGraph(/*read_between=*/false);
+  ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  InitializeVariable();
+  const float* variable_data = variable_->GetTensor()->data.f;
+
+  Update({1, 2}, {1, 0});
+  EXPECT_EQ(GetValues(interpreter_->tensor(4)),
+            std::vector<float>({0, 0, 1, 2, 0, 0}));
+  EXPECT_EQ(GetValues(variable_->GetTensor()),
+            std::vector<float>({0, 0, 1, 2, 0, 0}));
+
+  // Updates accumulate across invocations, and out of bounds start indices
+  // are clamped.
+  Update({3, 4}, {5, 0});
+  EXPECT_EQ(GetValues(interpreter_->tensor(4)),
+            std::vector<float>({0, 0, 1, 2, 3, 4}));
+  EXPECT_EQ(GetValues(variable_->GetTensor()),
+            std::vector<float>({0, 0, 1, 2, 3, 4}));
+  EXPECT_EQ(variable_->GetTensor()->data.f, variable_data);
+}
+
+TEST_F(InPlaceVariableUpdateTest, ReadBeforeAssignSeesOldValue) {
+  ConstructUpdateGraph(/*read_between=*/true);
+  ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  InitializeVariable();
+
+  Update({1, 2}, {0, 0});
+  // The variable is only updated by the assignment.
+  EXPECT_EQ(GetValues(interpreter_->tensor(5)),
+            std::vector<float>({0, 0, 0, 0, 0, 0}));
+  EXPECT_EQ(GetValues(variable_->GetTensor()),
+            std::vector<float>({1, 2, 0, 0, 0, 0}));
+
+  Update({3, 4}, {2, 0});
+  EXPECT_EQ(GetValues(interpreter_->tensor(5)),
+            std::vector<float>({1, 2, 0, 0, 0, 0}));
+  EXPECT_EQ(GetValues(variable_->GetTensor()),
+            std::vector<float>({1, 2, 0, 0, 3, 4}));
+}
+
 }  // namespace
 }  // namespace tflite
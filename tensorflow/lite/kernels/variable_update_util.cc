@@ -0,0 +1,187 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/variable_update_util.h"
+
+#include <string>
+#include <utility>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/core/c/builtin_op_data.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
+
+namespace tflite {
+namespace ops {
+namespace builtin {
+namespace {
+
+const std::pair<TfLiteNode, TfLiteRegistration>& GetNodeAt(
+    const Subgraph& subgraph, int position) {
+  return *subgraph.node_and_registration(subgraph.execution_plan()[position]);
+}
+
+// Returns the position of `node` in the execution plan, or -1.
+int FindNode(const Subgraph& subgraph, const TfLiteNode* node) {
+  const int num_nodes = subgraph.execution_plan().size();
+  for (int i = 0; i < num_nodes; ++i) {
+    if (&GetNodeAt(subgraph, i).first == node) return i;
+  }
+  return -1;
+}
+
+// Returns the position in the execution plan of the node producing
+// `tensor_index`, or -1.
+int FindProducer(const Subgraph& subgraph, int tensor_index) {
+  const int num_nodes = subgraph.execution_plan().size();
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteIntArray* outputs = GetNodeAt(subgraph, i).first.outputs;
+    for (int j = 0; j < outputs->size; ++j) {
+      if (outputs->data[j] == tensor_index) return i;
+    }
+  }
+  return -1;
+}
+
+// Returns the id of the resource held by `tensor_index` if it's known before
+// the subgraph runs, i.e. the tensor is constant or produced by VAR_HANDLE.
+// Returns -1 otherwise.
+int GetStaticResourceId(Subgraph* subgraph, int tensor_index) {
+  const TfLiteTensor* tensor = subgraph->tensor(tensor_index);
+  if (tensor == nullptr) return -1;
+  if (tensor->allocation_type == kTfLiteMmapRo) {
+    if (tensor->type != kTfLiteInt32 || tensor->data.i32 == nullptr ||
+        tensor->bytes != sizeof(int32_t)) {
+      return -1;
+    }
+    return tensor->data.i32[0];
+  }
+  const int producer = FindProducer(*subgraph, tensor_index);
+  if (producer < 0) return -1;
+  const auto& var_handle = GetNodeAt(*subgraph, producer);
+  if (var_handle.second.builtin_code != kTfLiteBuiltinVarHandle) return -1;
+  const auto* params =
+      static_cast<const TfLiteVarHandleParams*>(var_handle.first.builtin_data);
+  if (params == nullptr) return -1;
+  // VAR_HANDLE registers its id when the node is created.
+  const auto it = subgraph->resource_ids().find(std::make_pair(
+      std::string(params->container ? params->container : ""),
+      std::string(params->shared_name ? params->shared_name : "")));
+  return it == subgraph->resource_ids().end() ? -1 : it->second;
+}
+
+// Returns true if the node at `position` may read or write the variable
+// `variable_id`.
+bool MayAccessVariable(Subgraph* subgraph, int position, int variable_id) {
+  const auto& [node, registration] = GetNodeAt(*subgraph, position);
+  if (node.delegate != nullptr) return true;
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinVarHandle:
+      return false;
+    case kTfLiteBuiltinReadVariable:
+    case kTfLiteBuiltinAssignVariable: {
+      const int id = GetStaticResourceId(subgraph, node.inputs->data[0]);
+      return id < 0 || id == variable_id;
+    }
+    case kTfLiteBuiltinDelegate:
+    case kTfLiteBuiltinCustom:
+    // These run other subgraphs.
+    case kTfLiteBuiltinStablehloReduce:
+    case kTfLiteBuiltinStablehloReduceWindow:
+    case kTfLiteBuiltinStablehloScatter:
+    case kTfLiteBuiltinStablehloSort:
+    case kTfLiteBuiltinStablehloWhile:
+      return true;
+    default:
+      // Control flow and other resource ops.
+      return node.might_have_side_effect;
+  }
+}
+
+// Matches the DYNAMIC_UPDATE_SLICE at `update_position` against the pattern
+// described in the header. On success returns the id of the variable and sets
+// `assign_position` to the position of the ASSIGN_VARIABLE node.
+int MatchInPlaceUpdate(Subgraph* subgraph, int update_position,
+                       int* assign_position) {
+  const int num_nodes = subgraph->execution_plan().size();
+  const TfLiteNode& update = GetNodeAt(*subgraph, update_position).first;
+  if (update.inputs->size != 3 || update.outputs->size != 1) return -1;
+
+  const int read_position = FindProducer(*subgraph, update.inputs->data[0]);
+  if (read_position < 0) return -1;
+  const auto& [read, read_registration] = GetNodeAt(*subgraph, read_position);
+  if (read_registration.builtin_code != kTfLiteBuiltinReadVariable ||
+      read.inputs->size != 1) {
+    return -1;
+  }
+  const int variable_id = GetStaticResourceId(subgraph, read.inputs->data[0]);
+  if (variable_id < 0) return -1;
+
+  *assign_position = -1;
+  for (int i = update_position + 1; i < num_nodes; ++i) {
+    const auto& [assign, registration] = GetNodeAt(*subgraph, i);
+    if (registration.builtin_code == kTfLiteBuiltinAssignVariable &&
+        assign.inputs->size == 2 &&
+        assign.inputs->data[1] == update.outputs->data[0] &&
+        GetStaticResourceId(subgraph, assign.inputs->data[0]) == variable_id) {
+      *assign_position = i;
+      break;
+    }
+  }
+  if (*assign_position < 0) return -1;
+
+  for (int i = read_position + 1; i < *assign_position; ++i) {
+    if (i != update_position && MayAccessVariable(subgraph, i, variable_id)) {
+      return -1;
+    }
+  }
+  return variable_id;
+}
+
+}  // namespace
+
+int GetVariableUpdatedInPlace(Subgraph* subgraph, const TfLiteNode* node) {
+  const int update_position = FindNode(*subgraph, node);
+  if (update_position < 0 || node->delegate != nullptr) return -1;
+  int assign_position;
+  return MatchInPlaceUpdate(subgraph, update_position, &assign_position);
+}
+
+bool IsVariableAssignedInPlace(Subgraph* subgraph, const TfLiteNode* node) {
+  if (node->inputs->size != 2) return false;
+  const int update_position = FindProducer(*subgraph, node->inputs->data[1]);
+  if (update_position < 0) return false;
+  const auto& [update, registration] = GetNodeAt(*subgraph, update_position);
+  if (registration.builtin_code != kTfLiteBuiltinDynamicUpdateSlice ||
+      update.delegate != nullptr) {
+    return false;
+  }
+  int assign_position;
+  return MatchInPlaceUpdate(subgraph, update_position, &assign_position) >= 0 &&
+         &GetNodeAt(*subgraph, assign_position).first == node;
+}
+
+bool CanUpdateVariableInPlace(resource::ResourceVariable* variable,
+                              const TfLiteTensor* value) {
+  if (variable == nullptr) return false;
+  const TfLiteTensor* variable_tensor = variable->GetTensor();
+  return variable_tensor != nullptr && variable_tensor->type == value->type &&
+         value->type != kTfLiteString &&
+         TfLiteIntArrayEqual(variable_tensor->dims, value->dims);
+}
+
+}  // namespace builtin
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,57 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_VARIABLE_UPDATE_UTIL_H_
+#define TENSORFLOW_LITE_KERNELS_VARIABLE_UPDATE_UTIL_H_
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
+
+namespace tflite {
+namespace ops {
+namespace builtin {
+
+// Autoregressive models keep state such as attention KV caches in resource
+// variables, and update a slice of it on every invocation with
+//
+//   %value = READ_VARIABLE(%id)
+//   %new_value = DYNAMIC_UPDATE_SLICE(%value, %update, %start_indices)
+//   ASSIGN_VARIABLE(%id, %new_value)
+//
+// Rather than copying the whole of `%new_value` back into the variable, the
+// DYNAMIC_UPDATE_SLICE node writes `%update` into the variable in place and
+// the ASSIGN_VARIABLE node has nothing left to do. This only applies when no
+// node between the READ_VARIABLE and the ASSIGN_VARIABLE nodes may access the
+// variable, so that the early write can't be observed.
+
+// Returns the id of the variable that the DYNAMIC_UPDATE_SLICE `node` of
+// `subgraph` updates in place, or -1 if `node` isn't part of the pattern.
+int GetVariableUpdatedInPlace(Subgraph* subgraph, const TfLiteNode* node);
+
+// Returns true if the value of the ASSIGN_VARIABLE `node` of `subgraph` is
+// written to the variable in place by the DYNAMIC_UPDATE_SLICE producing it.
+bool IsVariableAssignedInPlace(Subgraph* subgraph, const TfLiteNode* node);
+
+// Returns true if `value` can be written into `variable` in place, i.e. the
+// variable is initialized with the same type and shape. Both nodes of the
+// pattern check this at runtime, and fall back to the copy if it fails.
+bool CanUpdateVariableInPlace(resource::ResourceVariable* variable,
+                              const TfLiteTensor* value);
+
+}  // namespace builtin
+}  // namespace ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_VARIABLE_UPDATE_UTIL_H_
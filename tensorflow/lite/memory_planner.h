@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MEMORY_PLANNER_H_
 #define TENSORFLOW_LITE_MEMORY_PLANNER_H_
 
+#include <string>
 #include <vector>
 
 #include "tensorflow/lite/core/c/common.h"
@@ -69,6 +70,31 @@ class MemoryPlanner {
   // Returns a map of allocation information. It's only used for debugging.
   virtual void GetAllocInfo(size_t *arena_size,
                             size_t *arena_persist_size) const = 0;
+
+  // Serializes the allocations made so far into `plan`, so that a planner for
+  // an identical graph can reuse them with RestorePlan() instead of computing
+  // them again. Returns kTfLiteError if serialization is not supported.
+  virtual TfLiteStatus SerializePlan(std::string* plan) const {
+    return kTfLiteError;
+  }
+
+  // Makes the following calls to ExecuteAllocations() reuse the allocations
+  // serialized in `plan`, as long as the size and lifetime of all the tensors
+  // they allocate match the serialized ones. Otherwise `plan` is dropped and
+  // allocations are planned as usual. Returns kTfLiteError if `plan` is
+  // malformed or restoring is not supported.
+  virtual TfLiteStatus RestorePlan(const std::string& plan) {
+    return kTfLiteError;
+  }
+
+  // Returns true if a plan set by RestorePlan() is in use.
+  virtual bool HasRestoredPlan() const { return false; }
+
+  // Declares that the execution plan runs in stages of nodes which may run
+  // concurrently, where the stage ending with node `stage_ends[i] - 1` starts
+  // at node `stage_ends[i - 1]` (or 0). An empty `stage_ends` means that the
+  // nodes run one at a time. Takes effect at the next PlanAllocations().
+  virtual void SetExecutionStages(const std::vector<int>& stage_ends) {}
 };
 
 }  // namespace tflite
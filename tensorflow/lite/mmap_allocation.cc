@@ -19,7 +19,18 @@ limitations under the License.
 #include <sys/stat.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
@@ -27,6 +38,38 @@ limitations under the License.
 namespace tflite {
 namespace {
 
+size_t GetPageSize() {
+#ifdef __ANDROID__
+  static int pagesize = getpagesize();
+#else
+  static int pagesize = sysconf(_SC_PAGE_SIZE);
+#endif
+  return pagesize;
+}
+
+// Hints the kernel to back [`address`, `address` + `size`) with transparent
+// huge pages. Kernels without them fail with EINVAL, which is fine.
+void AdviseHugePages(void* address, size_t size) {
+#ifdef MADV_HUGEPAGE
+  madvise(address, size, MADV_HUGEPAGE);
+#endif
+}
+
+// Reads in the pages of [`address`, `address` + `size`), which must be page
+// aligned.
+void Prefault(const char* address, size_t size) {
+#ifdef MADV_POPULATE_READ
+  // Since Linux 5.14, this faults the pages in without touching them.
+  if (madvise(const_cast<char*>(address), size, MADV_POPULATE_READ) == 0) {
+    return;
+  }
+#endif
+  const size_t page_size = GetPageSize();
+  volatile char sink = 0;
+  for (size_t i = 0; i < size; i += page_size) sink += address[i];
+  (void)sink;
+}
+
 size_t GetFdSizeBytes(int fd) {
   if (fd < 0) {
     return 0;
@@ -42,16 +85,64 @@ size_t GetFdSizeBytes(int fd) {
 
 }  // namespace
 
+// Reads a mapping in with background threads, which take chunks of it in
+// order. Stops early when destroyed, so that the mapping can be unmapped.
+class MMAPAllocation::Prefaulter {
+ public:
+  Prefaulter(const void* address, size_t size, int num_threads)
+      : address_(static_cast<const char*>(address)), size_(size) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this] { Run(); });
+    }
+  }
+
+  ~Prefaulter() {
+    cancelled_ = true;
+    Wait();
+  }
+
+  void Wait() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::thread& thread : threads_) {
+      if (thread.joinable()) thread.join();
+    }
+  }
+
+ private:
+  // Large enough to amortize the cost of the madvise calls, small enough to
+  // balance the threads and to stop soon when cancelled.
+  static constexpr size_t kChunkSize = 4 << 20;
+
+  void Run() {
+    while (!cancelled_) {
+      const size_t begin = next_chunk_.fetch_add(1) * kChunkSize;
+      if (begin >= size_) return;
+      Prefault(address_ + begin, std::min(kChunkSize, size_ - begin));
+    }
+  }
+
+  const char* const address_;
+  const size_t size_;
+  std::atomic<size_t> next_chunk_{0};
+  std::atomic<bool> cancelled_{false};
+  std::mutex mutex_;
+  std::vector<std::thread> threads_;
+};
+
 MMAPAllocation::MMAPAllocation(const char* filename,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, open(filename, O_RDONLY)) {
+    : MMAPAllocation(filename, Options(), error_reporter) {}
+
+MMAPAllocation::MMAPAllocation(const char* filename, const Options& options,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, open(filename, O_RDONLY), options) {
   if (mmap_fd_ == -1) {
     TF_LITE_REPORT_ERROR(error_reporter, "Could not open '%s'.", filename);
   }
 }
 
 MMAPAllocation::MMAPAllocation(int fd, ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, dup(fd)) {
+    : MMAPAllocation(error_reporter, dup(fd), Options()) {
   if (mmap_fd_ == -1) {
     TF_LITE_REPORT_ERROR(error_reporter, "Failed to dup '%d' file descriptor.",
                          fd);
@@ -60,19 +151,26 @@ MMAPAllocation::MMAPAllocation(int fd, ErrorReporter* error_reporter)
 
 MMAPAllocation::MMAPAllocation(int fd, size_t offset, size_t length,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, dup(fd), offset, length) {
+    : MMAPAllocation(fd, offset, length, Options(), error_reporter) {}
+
+MMAPAllocation::MMAPAllocation(int fd, size_t offset, size_t length,
+                               const Options& options,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, dup(fd), offset, length, options) {
   if (mmap_fd_ == -1) {
     TF_LITE_REPORT_ERROR(error_reporter, "Failed to dup '%d' file descriptor.",
                          fd);
   }
 }
 
-MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd)
+MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
+                               const Options& options)
     : MMAPAllocation(error_reporter, owned_fd, /*offset=*/0,
-                     /*length=*/GetFdSizeBytes(owned_fd)) {}
+                     /*length=*/GetFdSizeBytes(owned_fd), options) {}
 
 MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
-                               size_t offset, size_t length)
+                               size_t offset, size_t length,
+                               const Options& options)
     : Allocation(error_reporter, Allocation::Type::kMMap),
       mmap_fd_(owned_fd),
       mmapped_buffer_(MAP_FAILED),
@@ -81,12 +179,7 @@ MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
     return;
   }
 
-#ifdef __ANDROID__
-  static int pagesize = getpagesize();
-#else
-  static int pagesize = sysconf(_SC_PAGE_SIZE);
-#endif
-
+  const size_t pagesize = GetPageSize();
   offset_in_buffer_ = offset % pagesize;
   offset_of_buffer_in_file_ = offset - offset_in_buffer_;
 
@@ -99,8 +192,12 @@ MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
     return;
   }
 
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (options.populate) flags |= MAP_POPULATE;
+#endif
   mmapped_buffer_ =
-      mmap(nullptr, /*__len=*/length + offset_in_buffer_, PROT_READ, MAP_SHARED,
+      mmap(nullptr, /*__len=*/length + offset_in_buffer_, PROT_READ, flags,
            mmap_fd_, /*__offset=*/offset - offset_in_buffer_);
   if (mmapped_buffer_ == MAP_FAILED) {
     TF_LITE_REPORT_ERROR(error_reporter,
@@ -108,9 +205,18 @@ MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
                          mmap_fd_, offset, errno);
     return;
   }
+  if (options.use_huge_pages) {
+    AdviseHugePages(const_cast<void*>(mmapped_buffer_), mmapped_buffer_size());
+  }
+  if (!options.populate && options.num_prefault_threads > 0) {
+    prefaulter_ = std::make_unique<Prefaulter>(
+        mmapped_buffer_, mmapped_buffer_size(), options.num_prefault_threads);
+  }
 }
 
 MMAPAllocation::~MMAPAllocation() {
+  // Stops the prefault before unmapping.
+  prefaulter_.reset();
   if (valid()) {
     munmap(const_cast<void*>(mmapped_buffer_),
            buffer_size_bytes_ + offset_in_buffer_);
@@ -129,6 +235,77 @@ size_t MMAPAllocation::bytes() const { return buffer_size_bytes_; }
 
 bool MMAPAllocation::valid() const { return mmapped_buffer_ != MAP_FAILED; }
 
+void MMAPAllocation::WaitForPrefault() {
+  if (prefaulter_) prefaulter_->Wait();
+}
+
 bool MMAPAllocation::IsSupported() { return true; }
 
+NumaReplicaAllocation::NumaReplicaAllocation(const Allocation& source,
+                                             int numa_node, bool use_huge_pages,
+                                             ErrorReporter* error_reporter)
+    : Allocation(error_reporter, Allocation::Type::kMemory),
+      buffer_(MAP_FAILED),
+      buffer_size_bytes_(source.bytes()) {
+  if (!source.valid() || buffer_size_bytes_ == 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Invalid allocation to replicate.");
+    return;
+  }
+  const size_t page_size = GetPageSize();
+  mapped_size_bytes_ =
+      (buffer_size_bytes_ + page_size - 1) / page_size * page_size;
+  buffer_ = mmap(nullptr, mapped_size_bytes_, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffer_ == MAP_FAILED) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Mmap of %zu bytes failed with error '%d'.",
+                         mapped_size_bytes_, errno);
+    return;
+  }
+  if (use_huge_pages) AdviseHugePages(buffer_, mapped_size_bytes_);
+  if (numa_node >= 0) {
+#if defined(__linux__) && defined(SYS_mbind)
+    // The memory policy applies to the pages faulted in by the copy below.
+    constexpr int kMpolBind = 2;
+    constexpr int kBitsPerLong = 8 * sizeof(unsigned long);  // NOLINT
+    std::vector<unsigned long> node_mask(  // NOLINT
+        numa_node / kBitsPerLong + 1, 0);
+    node_mask[numa_node / kBitsPerLong] = 1UL << (numa_node % kBitsPerLong);
+    // The kernel ignores the last bit of `maxnode`.
+    const unsigned long max_node =  // NOLINT
+        node_mask.size() * kBitsPerLong + 1;
+    if (syscall(SYS_mbind, buffer_, mapped_size_bytes_, kMpolBind,
+                node_mask.data(), max_node, 0) != 0) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Binding memory to NUMA node %d failed with error "
+                           "'%d'.",
+                           numa_node, errno);
+      munmap(buffer_, mapped_size_bytes_);
+      buffer_ = MAP_FAILED;
+      return;
+    }
+#else
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Binding memory to NUMA nodes isn't supported.");
+    munmap(buffer_, mapped_size_bytes_);
+    buffer_ = MAP_FAILED;
+    return;
+#endif
+  }
+  std::memcpy(buffer_, source.base(), buffer_size_bytes_);
+  mprotect(buffer_, mapped_size_bytes_, PROT_READ);
+}
+
+NumaReplicaAllocation::~NumaReplicaAllocation() {
+  if (valid()) munmap(buffer_, mapped_size_bytes_);
+}
+
+const void* NumaReplicaAllocation::base() const { return buffer_; }
+
+size_t NumaReplicaAllocation::bytes() const { return buffer_size_bytes_; }
+
+bool NumaReplicaAllocation::valid() const { return buffer_ != MAP_FAILED; }
+
+bool NumaReplicaAllocation::IsSupported() { return true; }
+
 }  // namespace tflite
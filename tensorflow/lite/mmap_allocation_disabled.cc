@@ -19,18 +19,30 @@ limitations under the License.
 
 namespace tflite {
 
+class MMAPAllocation::Prefaulter {};
+
 MMAPAllocation::MMAPAllocation(const char* filename,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, -1) {}
+    : MMAPAllocation(error_reporter, -1, Options()) {}
+
+MMAPAllocation::MMAPAllocation(const char* filename, const Options& options,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, -1, options) {}
 
 MMAPAllocation::MMAPAllocation(int fd, ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, -1) {}
+    : MMAPAllocation(error_reporter, -1, Options()) {}
+
+MMAPAllocation::MMAPAllocation(int fd, size_t offset, size_t length,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, -1, Options()) {}
 
 MMAPAllocation::MMAPAllocation(int fd, size_t offset, size_t length,
+                               const Options& options,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, -1) {}
+    : MMAPAllocation(error_reporter, -1, options) {}
 
-MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd)
+MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
+                               const Options& options)
     : Allocation(error_reporter, Allocation::Type::kMMap),
       mmapped_buffer_(nullptr) {
   // The disabled variant should never be created.
@@ -45,6 +57,27 @@ size_t MMAPAllocation::bytes() const { return 0; }
 
 bool MMAPAllocation::valid() const { return false; }
 
+void MMAPAllocation::WaitForPrefault() {}
+
 bool MMAPAllocation::IsSupported() { return false; }
 
+NumaReplicaAllocation::NumaReplicaAllocation(const Allocation& source,
+                                             int numa_node, bool use_huge_pages,
+                                             ErrorReporter* error_reporter)
+    : Allocation(error_reporter, Allocation::Type::kMemory),
+      buffer_(nullptr) {
+  // The disabled variant should never be created.
+  assert(false);
+}
+
+NumaReplicaAllocation::~NumaReplicaAllocation() {}
+
+const void* NumaReplicaAllocation::base() const { return nullptr; }
+
+size_t NumaReplicaAllocation::bytes() const { return 0; }
+
+bool NumaReplicaAllocation::valid() const { return false; }
+
+bool NumaReplicaAllocation::IsSupported() { return false; }
+
 }  // namespace tflite
@@ -133,8 +133,9 @@ class BufferedProfiler : public tflite::Profiler {
     return (static_cast<uint64_t>(event_type) & supported_event_types_) != 0;
   }
 
- private:
   ProfileBuffer* GetProfileBuffer() { return &buffer_; }
+
+ private:
   ProfileBuffer buffer_;
   const uint64_t supported_event_types_;
 };
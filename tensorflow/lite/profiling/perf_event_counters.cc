@@ -0,0 +1,278 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_counters.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+#ifdef __linux__
+// Opens a counter of the calling thread on any CPU, in the group of
+// `group_fd`, or as a new group leader if it's -1. Returns -1 on failure.
+int OpenCounter(uint32_t type, uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  // The group is enabled at once when complete.
+  attr.disabled = group_fd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  unsigned long flags = 0;  // NOLINT(runtime/int)
+#ifdef PERF_FLAG_FD_CLOEXEC
+  flags |= PERF_FLAG_FD_CLOEXEC;
+#endif
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0 /*pid*/,
+                                  -1 /*cpu*/, group_fd, flags));
+}
+
+uint64_t LastLevelCacheConfig(uint64_t result) {
+  return PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (result << 16);
+}
+#endif  // __linux__
+
+std::string EscapeCsv(const std::string& str) {
+  if (str.find_first_of(",\"\n") == std::string::npos) return str;
+  std::string escaped = "\"";
+  for (char c : str) {
+    if (c == '"') escaped += '"';
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+// Writes `value` in a column of `width`, or "-" if it isn't available.
+void WriteColumn(std::ostream& stream, int width, bool available,
+                 double value) {
+  if (available) {
+    stream << std::setw(width) << value;
+  } else {
+    stream << std::setw(width) << "-";
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<PerfEventCounters> PerfEventCounters::Create() {
+#ifdef __linux__
+  std::unique_ptr<PerfEventCounters> counters(new PerfEventCounters());
+  auto open = [&counters](HardwareCounter counter, uint32_t type,
+                          uint64_t config) {
+    const int fd = OpenCounter(
+        type, config, counters->fds_.empty() ? -1 : counters->fds_[0]);
+    if (fd == -1) return false;
+    counters->fds_.push_back(fd);
+    counters->counters_.push_back(counter);
+    counters->available_ |= counter;
+    return true;
+  };
+  open(kHardwareCounterCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  open(kHardwareCounterInstructions, PERF_TYPE_HARDWARE,
+       PERF_COUNT_HW_INSTRUCTIONS);
+  // The generic cache events count the last level cache on x86 only, so the
+  // last level cache events are preferred where the CPU defines both.
+  const size_t num_core_counters = counters->fds_.size();
+  if (!open(kHardwareCounterLlcReferences, PERF_TYPE_HW_CACHE,
+            LastLevelCacheConfig(PERF_COUNT_HW_CACHE_RESULT_ACCESS)) ||
+      !open(kHardwareCounterLlcMisses, PERF_TYPE_HW_CACHE,
+            LastLevelCacheConfig(PERF_COUNT_HW_CACHE_RESULT_MISS))) {
+    while (counters->fds_.size() > num_core_counters) {
+      close(counters->fds_.back());
+      counters->fds_.pop_back();
+      counters->available_ &= ~counters->counters_.back();
+      counters->counters_.pop_back();
+    }
+    open(kHardwareCounterLlcReferences, PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_CACHE_REFERENCES);
+    open(kHardwareCounterLlcMisses, PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_CACHE_MISSES);
+  }
+  if (counters->fds_.empty()) return nullptr;
+
+  const int leader = counters->fds_[0];
+  if (ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) == -1 ||
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == -1) {
+    return nullptr;
+  }
+  return counters;
+#else
+  return nullptr;
+#endif  // __linux__
+}
+
+PerfEventCounters::~PerfEventCounters() {
+#ifdef __linux__
+  // Members first, so that the group leader closes last.
+  for (auto it = fds_.rbegin(); it != fds_.rend(); ++it) close(*it);
+#endif
+}
+
+HardwareCounters PerfEventCounters::Read() const {
+  HardwareCounters result;
+#ifdef __linux__
+  // The number of counters, the times the group was enabled and running, and
+  // the value of each counter.
+  constexpr int kMaxCounters = 4;
+  uint64_t data[3 + kMaxCounters];
+  const size_t num_counters = counters_.size();
+  const ssize_t size = read(fds_[0], data, sizeof(data));
+  if (size < static_cast<ssize_t>((3 + num_counters) * sizeof(uint64_t)) ||
+      data[0] != num_counters || data[2] == 0) {
+    // The group hasn't been scheduled on the CPU yet, e.g. because it has
+    // more counters than the CPU.
+    return result;
+  }
+  const uint64_t time_enabled = data[1];
+  const uint64_t time_running = data[2];
+  for (size_t i = 0; i < num_counters; ++i) {
+    uint64_t value = data[3 + i];
+    if (time_running < time_enabled) {
+      // Multiplexed with other events, e.g. of a concurrent perf session.
+      value = static_cast<uint64_t>(static_cast<double>(value) *
+                                    time_enabled / time_running);
+    }
+    switch (counters_[i]) {
+      case kHardwareCounterCycles:
+        result.cycles = value;
+        break;
+      case kHardwareCounterInstructions:
+        result.instructions = value;
+        break;
+      case kHardwareCounterLlcReferences:
+        result.llc_references = value;
+        break;
+      case kHardwareCounterLlcMisses:
+        result.llc_misses = value;
+        break;
+    }
+  }
+  result.available = available_;
+#endif  // __linux__
+  return result;
+}
+
+OpHardwareCounters GetOpHardwareCounters(const std::string& name,
+                                         const std::string& type,
+                                         int64_t count, int64_t total_us,
+                                         const HardwareCounters& totals) {
+  OpHardwareCounters op;
+  op.name = name;
+  op.type = type;
+  op.count = count;
+  if (count == 0) return op;
+  op.avg_us = static_cast<double>(total_us) / count;
+  op.available = totals.available;
+  op.cycles = static_cast<double>(totals.cycles) / count;
+  op.instructions = static_cast<double>(totals.instructions) / count;
+  op.llc_references = static_cast<double>(totals.llc_references) / count;
+  op.llc_misses = static_cast<double>(totals.llc_misses) / count;
+  if (op.cycles > 0) op.ipc = op.instructions / op.cycles;
+  if (op.llc_references > 0) {
+    op.llc_miss_rate = op.llc_misses / op.llc_references;
+  }
+  op.dram_bytes = op.llc_misses * kCacheLineBytes;
+  // Bytes per microsecond are MB/s.
+  if (op.avg_us > 0) op.dram_gbps = op.dram_bytes / op.avg_us / 1e3;
+  return op;
+}
+
+std::string FormatHardwareCounterReport(
+    const std::vector<OpHardwareCounters>& ops, bool format_as_csv) {
+  std::stringstream stream;
+  auto has = [](const OpHardwareCounters& op, uint32_t counters) {
+    return (op.available & counters) == counters;
+  };
+  const uint32_t ipc_counters =
+      kHardwareCounterCycles | kHardwareCounterInstructions;
+  const uint32_t miss_rate_counters =
+      kHardwareCounterLlcReferences | kHardwareCounterLlcMisses;
+  if (format_as_csv) {
+    stream << "node type,name,count,avg us,cycles,instructions,ipc,"
+              "llc references,llc misses,llc miss rate,dram bytes,"
+              "dram gb per second"
+           << std::endl;
+    auto write = [&stream](bool available, double value) {
+      stream << ",";
+      if (available) stream << value;
+    };
+    for (const OpHardwareCounters& op : ops) {
+      stream << EscapeCsv(op.type) << "," << EscapeCsv(op.name) << ","
+             << op.count << "," << op.avg_us;
+      write(has(op, kHardwareCounterCycles), op.cycles);
+      write(has(op, kHardwareCounterInstructions), op.instructions);
+      write(has(op, ipc_counters), op.ipc);
+      write(has(op, kHardwareCounterLlcReferences), op.llc_references);
+      write(has(op, kHardwareCounterLlcMisses), op.llc_misses);
+      write(has(op, miss_rate_counters), op.llc_miss_rate);
+      write(has(op, kHardwareCounterLlcMisses), op.dram_bytes);
+      write(has(op, kHardwareCounterLlcMisses), op.dram_gbps);
+      stream << std::endl;
+    }
+    return stream.str();
+  }
+
+  stream << std::setw(24) << "[node type]" << std::setw(10) << "[count]"
+         << std::setw(12) << "[avg ms]" << std::setw(12) << "[Mcycles]"
+         << std::setw(12) << "[Minstr]" << std::setw(8) << "[IPC]"
+         << std::setw(12) << "[LLC Kref]" << std::setw(12) << "[LLC Kmiss]"
+         << std::setw(12) << "[miss %]" << std::setw(12) << "[DRAM MB]"
+         << std::setw(10) << "[GB/s]"
+         << "\t[Name]" << std::endl;
+  stream << std::fixed;
+  for (const OpHardwareCounters& op : ops) {
+    stream << std::setw(24) << op.type << std::setw(10) << op.count
+           << std::setprecision(3) << std::setw(12) << op.avg_us / 1e3;
+    WriteColumn(stream, 12, has(op, kHardwareCounterCycles), op.cycles / 1e6);
+    WriteColumn(stream, 12, has(op, kHardwareCounterInstructions),
+                op.instructions / 1e6);
+    stream << std::setprecision(2);
+    WriteColumn(stream, 8, has(op, ipc_counters), op.ipc);
+    stream << std::setprecision(1);
+    WriteColumn(stream, 12, has(op, kHardwareCounterLlcReferences),
+                op.llc_references / 1e3);
+    WriteColumn(stream, 12, has(op, kHardwareCounterLlcMisses),
+                op.llc_misses / 1e3);
+    WriteColumn(stream, 12, has(op, miss_rate_counters),
+                op.llc_miss_rate * 100);
+    stream << std::setprecision(3);
+    WriteColumn(stream, 12, has(op, kHardwareCounterLlcMisses),
+                op.dram_bytes / 1e6);
+    WriteColumn(stream, 10, has(op, kHardwareCounterLlcMisses), op.dram_gbps);
+    stream << "\t" << op.name << std::endl;
+  }
+  return stream.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,149 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_EVENT_COUNTERS_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_EVENT_COUNTERS_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tflite {
+namespace profiling {
+
+// Bits of HardwareCounters::available.
+enum HardwareCounter : uint32_t {
+  kHardwareCounterCycles = 1 << 0,
+  kHardwareCounterInstructions = 1 << 1,
+  kHardwareCounterLlcReferences = 1 << 2,
+  kHardwareCounterLlcMisses = 1 << 3,
+};
+
+// Values of the hardware counters of a thread, or their difference between
+// two readings.
+struct HardwareCounters {
+  // The HardwareCounter bits of the counters whose values are set. None are
+  // if the counters couldn't be read.
+  uint32_t available = 0;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  // Accesses to and misses of the last level cache.
+  uint64_t llc_references = 0;
+  uint64_t llc_misses = 0;
+
+  bool Has(HardwareCounter counter) const { return available & counter; }
+
+  HardwareCounters operator+(const HardwareCounters& obj) const {
+    HardwareCounters res;
+    res.available = available & obj.available;
+    res.cycles = cycles + obj.cycles;
+    res.instructions = instructions + obj.instructions;
+    res.llc_references = llc_references + obj.llc_references;
+    res.llc_misses = llc_misses + obj.llc_misses;
+    return res;
+  }
+
+  HardwareCounters operator-(const HardwareCounters& obj) const {
+    HardwareCounters res;
+    res.available = available & obj.available;
+    res.cycles = cycles - obj.cycles;
+    res.instructions = instructions - obj.instructions;
+    res.llc_references = llc_references - obj.llc_references;
+    res.llc_misses = llc_misses - obj.llc_misses;
+    return res;
+  }
+};
+
+// Reads the hardware counters of the calling thread with the Linux
+// perf_event_open interface, in user space only.
+//
+// The counters are opened as one group, so that they count over the same
+// intervals. Counters the CPU or hypervisor doesn't expose are left out, and
+// no counter can be opened where perf events are unavailable: on other
+// platforms, with a restrictive /proc/sys/kernel/perf_event_paranoid or in
+// containers whose seccomp profile denies perf_event_open.
+//
+// Only the thread that created the counters is counted, not e.g. the worker
+// threads of multithreaded kernels.
+class PerfEventCounters {
+ public:
+  // Returns nullptr if none of the counters can be opened.
+  static std::unique_ptr<PerfEventCounters> Create();
+
+  ~PerfEventCounters();
+
+  PerfEventCounters(const PerfEventCounters&) = delete;
+  PerfEventCounters& operator=(const PerfEventCounters&) = delete;
+
+  // The HardwareCounter bits of the opened counters.
+  uint32_t available() const { return available_; }
+
+  // Returns the values counted since the counters were opened, scaled up if
+  // the kernel had to multiplex them with other events. Returns no available
+  // counters if they can't be read.
+  HardwareCounters Read() const;
+
+ private:
+  PerfEventCounters() = default;
+
+  // File descriptors of the opened counters, the group leader first, and the
+  // HardwareCounter each counts.
+  std::vector<int> fds_;
+  std::vector<HardwareCounter> counters_;
+  uint32_t available_ = 0;
+};
+
+// Hardware counters of an op of the profiled model, per invocation.
+struct OpHardwareCounters {
+  std::string name;
+  std::string type;
+  // Invocations with counters.
+  int64_t count = 0;
+  double avg_us = 0;
+  // The HardwareCounter bits of the values below that are set.
+  uint32_t available = 0;
+  double cycles = 0;
+  double instructions = 0;
+  double llc_references = 0;
+  double llc_misses = 0;
+  // Instructions per cycle.
+  double ipc = 0;
+  // llc_misses / llc_references.
+  double llc_miss_rate = 0;
+  // Memory traffic estimated from the cache lines missing in the last level
+  // cache, in bytes per invocation and GB/s.
+  double dram_bytes = 0;
+  double dram_gbps = 0;
+};
+
+// Size of the cache lines the memory traffic is estimated with.
+constexpr int kCacheLineBytes = 64;
+
+// Returns the counters of an op invoked `count` times in `total_us` for a sum
+// of `totals` over the invocations.
+OpHardwareCounters GetOpHardwareCounters(const std::string& name,
+                                         const std::string& type,
+                                         int64_t count, int64_t total_us,
+                                         const HardwareCounters& totals);
+
+// Formats the hardware counters of `ops` as text or CSV. Counters that aren't
+// available are reported as empty in CSV and "-" in text.
+std::string FormatHardwareCounterReport(
+    const std::vector<OpHardwareCounters>& ops, bool format_as_csv);
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_EVENT_COUNTERS_H_
@@ -0,0 +1,165 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_counters.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+#include "tensorflow/lite/profiling/profile_buffer.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+// Keeps the CPU busy, so that the counters advance.
+int64_t Work() {
+  volatile int64_t sum = 0;
+  for (int i = 0; i < 100000; ++i) sum += i;
+  return sum;
+}
+
+TEST(HardwareCountersTest, Difference) {
+  HardwareCounters begin;
+  begin.available = kHardwareCounterCycles | kHardwareCounterInstructions;
+  begin.cycles = 100;
+  begin.instructions = 50;
+  HardwareCounters end = begin;
+  end.cycles = 350;
+  end.instructions = 550;
+  end.available |= kHardwareCounterLlcMisses;
+
+  const HardwareCounters diff = end - begin;
+  EXPECT_EQ(diff.cycles, 250);
+  EXPECT_EQ(diff.instructions, 500);
+  EXPECT_TRUE(diff.Has(kHardwareCounterCycles));
+  EXPECT_FALSE(diff.Has(kHardwareCounterLlcMisses));
+  EXPECT_EQ((diff + diff).cycles, 500);
+  EXPECT_EQ((diff - HardwareCounters()).available, 0);
+}
+
+TEST(PerfEventCountersTest, ReadsIncreasingCountersIfAvailable) {
+  std::unique_ptr<PerfEventCounters> counters = PerfEventCounters::Create();
+  if (counters == nullptr) {
+    GTEST_SKIP() << "Perf events are unavailable.";
+  }
+  EXPECT_NE(counters->available(), 0);
+  const HardwareCounters begin = counters->Read();
+  Work();
+  const HardwareCounters end = counters->Read();
+  const HardwareCounters diff = end - begin;
+  if (diff.available == 0) {
+    GTEST_SKIP() << "The counters couldn't be scheduled.";
+  }
+  EXPECT_EQ(diff.available, counters->available());
+  if (diff.Has(kHardwareCounterInstructions)) {
+    EXPECT_GT(diff.instructions, 100000);
+  }
+  if (diff.Has(kHardwareCounterCycles)) {
+    EXPECT_GT(diff.cycles, 0);
+  }
+}
+
+TEST(PerfEventCountersTest, ProfileBufferReadsCountersOfOperators) {
+  std::unique_ptr<PerfEventCounters> counters = PerfEventCounters::Create();
+  ProfileBuffer buffer(/*max_size*/ 10, /*enabled*/ true);
+  buffer.SetHardwareCounters(counters.get());
+  const uint32_t op_handle = buffer.BeginEvent(
+      "op", ProfileEvent::EventType::OPERATOR_INVOKE_EVENT, 0, 0);
+  Work();
+  buffer.EndEvent(op_handle);
+  const uint32_t other_handle =
+      buffer.BeginEvent("other", ProfileEvent::EventType::DEFAULT, 0, 0);
+  buffer.EndEvent(other_handle);
+  ASSERT_EQ(buffer.Size(), 2);
+
+  const ProfileEvent* op = buffer.At(0);
+  const uint32_t available = counters != nullptr ? counters->available() : 0;
+  const HardwareCounters diff = op->end_hw_counters - op->begin_hw_counters;
+  if (diff.available != 0) {
+    EXPECT_EQ(diff.available, available);
+  }
+  const ProfileEvent* other = buffer.At(1);
+  EXPECT_EQ((other->end_hw_counters - other->begin_hw_counters).available, 0);
+}
+
+TEST(PerfEventCountersTest, ProfilerRecordsEventsWithOrWithoutCounters) {
+  PerfEventProfiler profiler(/*max_num_initial_entries*/ 10,
+                             /*allow_dynamic_buffer_increase*/ false);
+  profiler.StartProfiling();
+  const uint32_t handle = profiler.BeginEvent(
+      "op", Profiler::EventType::OPERATOR_INVOKE_EVENT, 0, 0);
+  Work();
+  profiler.EndEvent(handle);
+  profiler.StopProfiling();
+
+  // The event is recorded whether the counters are available or not.
+  std::vector<const ProfileEvent*> events = profiler.GetProfileEvents();
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_STREQ(events[0]->tag.c_str(), "op");
+  const HardwareCounters diff =
+      events[0]->end_hw_counters - events[0]->begin_hw_counters;
+  if (profiler.available_hw_counters() == 0) {
+    EXPECT_EQ(diff.available, 0);
+  }
+}
+
+TEST(OpHardwareCountersTest, DerivedMetrics) {
+  HardwareCounters totals;
+  totals.available = kHardwareCounterCycles | kHardwareCounterInstructions |
+                     kHardwareCounterLlcReferences | kHardwareCounterLlcMisses;
+  totals.cycles = 2000;
+  totals.instructions = 3000;
+  totals.llc_references = 400;
+  totals.llc_misses = 100;
+  const OpHardwareCounters op =
+      GetOpHardwareCounters("out:0", "CONV_2D", /*count=*/2,
+                            /*total_us=*/10, totals);
+  EXPECT_EQ(op.count, 2);
+  EXPECT_DOUBLE_EQ(op.avg_us, 5);
+  EXPECT_DOUBLE_EQ(op.cycles, 1000);
+  EXPECT_DOUBLE_EQ(op.ipc, 1.5);
+  EXPECT_DOUBLE_EQ(op.llc_miss_rate, 0.25);
+  EXPECT_DOUBLE_EQ(op.dram_bytes, 50 * kCacheLineBytes);
+  // 3200 bytes in 5 us.
+  EXPECT_DOUBLE_EQ(op.dram_gbps, 0.64);
+}
+
+TEST(OpHardwareCountersTest, Report) {
+  HardwareCounters totals;
+  totals.available = kHardwareCounterCycles | kHardwareCounterInstructions;
+  totals.cycles = 2000;
+  totals.instructions = 3000;
+  const std::vector<OpHardwareCounters> ops = {
+      GetOpHardwareCounters("out,0", "ADD", 1, 4, totals)};
+
+  const std::string text = FormatHardwareCounterReport(ops, false);
+  EXPECT_THAT(text, ::testing::HasSubstr("[IPC]"));
+  EXPECT_THAT(text, ::testing::HasSubstr("1.50"));
+  EXPECT_THAT(text, ::testing::HasSubstr(" -"));
+
+  const std::string csv = FormatHardwareCounterReport(ops, true);
+  EXPECT_THAT(csv,
+              ::testing::HasSubstr("ADD,\"out,0\",1,4,2000,3000,1.5,,,,,"));
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
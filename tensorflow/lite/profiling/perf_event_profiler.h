@@ -0,0 +1,63 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/perf_event_counters.h"
+
+namespace tflite {
+namespace profiling {
+
+// A BufferedProfiler that also records the hardware counters of each operator
+// invocation, i.e. cycles, instructions and last level cache accesses and
+// misses, as ProfileEvent::begin_hw_counters and end_hw_counters. The
+// ProfileSummarizer reports the IPC, cache miss rate and estimated memory
+// traffic of each op from them.
+//
+// The counters are read with perf_event_open on Linux. Where they can't be
+// opened, the profiler only records the events like a BufferedProfiler.
+//
+// The counters count the thread that creates the profiler, which must be the
+// thread invoking the interpreter. The work of other threads, e.g. of the
+// thread pool of multithreaded kernels, isn't counted, so the model should be
+// run with one thread for the counters of all ops to be complete.
+class PerfEventProfiler : public BufferedProfiler {
+ public:
+  PerfEventProfiler(uint32_t max_num_initial_entries,
+                    bool allow_dynamic_buffer_increase)
+      : BufferedProfiler(max_num_initial_entries,
+                         allow_dynamic_buffer_increase),
+        counters_(PerfEventCounters::Create()) {
+    GetProfileBuffer()->SetHardwareCounters(counters_.get());
+  }
+
+  // The HardwareCounter bits of the counters that are recorded, none if the
+  // counters are unavailable.
+  uint32_t available_hw_counters() const {
+    return counters_ != nullptr ? counters_->available() : 0;
+  }
+
+ private:
+  std::unique_ptr<PerfEventCounters> counters_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
@@ -40,8 +40,13 @@ uint32_t ProfileBuffer::BeginEvent(const char* tag,
   event_buffer_[index].extra_event_metadata = event_metadata2;
   event_buffer_[index].begin_timestamp_us = timestamp;
   event_buffer_[index].elapsed_time = 0;
+  event_buffer_[index].begin_hw_counters = HardwareCounters();
+  event_buffer_[index].end_hw_counters = HardwareCounters();
   if (event_type != Profiler::EventType::OPERATOR_INVOKE_EVENT) {
     event_buffer_[index].begin_mem_usage = memory::GetMemoryUsage();
+  } else if (hw_counters_ != nullptr) {
+    // Read last, to leave out as much of the profiler as possible.
+    event_buffer_[index].begin_hw_counters = hw_counters_->Read();
   }
   current_index_++;
   return index;
@@ -61,6 +66,11 @@ void ProfileBuffer::EndEvent(uint32_t event_handle,
   }
 
   int event_index = event_handle % max_size;
+  if (hw_counters_ != nullptr &&
+      event_buffer_[event_index].event_type ==
+          Profiler::EventType::OPERATOR_INVOKE_EVENT) {
+    event_buffer_[event_index].end_hw_counters = hw_counters_->Read();
+  }
   event_buffer_[event_index].elapsed_time =
       time::NowMicros() - event_buffer_[event_index].begin_timestamp_us;
   if (event_buffer_[event_index].event_type !=
@@ -105,6 +115,8 @@ void ProfileBuffer::AddEvent(const char* tag,
   event_buffer_[index].extra_event_metadata = event_metadata2;
   event_buffer_[index].begin_timestamp_us = 0;
   event_buffer_[index].elapsed_time = elapsed_time;
+  event_buffer_[index].begin_hw_counters = HardwareCounters();
+  event_buffer_[index].end_hw_counters = HardwareCounters();
   current_index_++;
 }
 
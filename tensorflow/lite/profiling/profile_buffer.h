@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/profiling/perf_event_counters.h"
 #include "tensorflow/lite/profiling/time.h"
 
 namespace tflite {
@@ -50,6 +51,11 @@ struct ProfileEvent {
   // The memory usage when the event ends.
   memory::MemoryUsage end_mem_usage;
 
+  // The hardware counters when an OPERATOR_INVOKE_EVENT begins and ends, if
+  // the buffer reads them. See ProfileBuffer::SetHardwareCounters.
+  HardwareCounters begin_hw_counters;
+  HardwareCounters end_hw_counters;
+
   // The field containing the type of event. This must be one of the event types
   // in EventType.
   EventType event_type;
@@ -83,6 +89,13 @@ class ProfileBuffer {
   // Sets the enabled state of buffer to |enabled|
   void SetEnabled(bool enabled) { enabled_ = enabled; }
 
+  // Reads |counters| when OPERATOR_INVOKE_EVENTs begin and end, which must
+  // then be on the thread that created them. |counters| must outlive the
+  // buffer, or be reset with nullptr.
+  void SetHardwareCounters(const PerfEventCounters* counters) {
+    hw_counters_ = counters;
+  }
+
   // Sets the end timestamp for event for the handle to current time.
   // If the buffer is disabled or previous event has been overwritten this
   // operation has not effect.
@@ -119,6 +132,7 @@ class ProfileBuffer {
   uint32_t current_index_;
   std::vector<ProfileEvent> event_buffer_;
   const bool allow_dynamic_expansion_;
+  const PerfEventCounters* hw_counters_ = nullptr;
 };
 
 }  // namespace profiling
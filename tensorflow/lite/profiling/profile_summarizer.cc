@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/profiling/perf_event_counters.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
@@ -139,6 +143,29 @@ void ProfileSummarizer::ProcessProfiles(
 
       stats_calculator->AddNodeStats(node_name_in_stats, type_in_stats,
                                      node_num, node_exec_time, 0 /*memory */);
+
+      const auto* subgraph = const_cast<tflite::Interpreter&>(interpreter)
+                                 .subgraph(subgraph_index);
+      const auto* node_reg = subgraph->node_and_registration(node_index);
+      const OpCost cost =
+          EstimateOpCost(*subgraph, node_reg->first, node_reg->second);
+      OpTotals& totals = op_totals_[{subgraph_index, node_index}];
+      totals.name = node_name_in_stats;
+      totals.type = type_in_stats;
+      ++totals.count;
+      totals.total_us += node_exec_time;
+      totals.total_cost.flops += cost.flops;
+      totals.total_cost.bytes += cost.bytes;
+      const HardwareCounters hw_counters =
+          event->end_hw_counters - event->begin_hw_counters;
+      if (hw_counters.available != 0) {
+        totals.total_hw_counters =
+            totals.hw_counters_count == 0
+                ? hw_counters
+                : totals.total_hw_counters + hw_counters;
+        ++totals.hw_counters_count;
+        totals.hw_counters_total_us += node_exec_time;
+      }
     } else if (event->event_type ==
                Profiler::EventType::DELEGATE_OPERATOR_INVOKE_EVENT) {
       const std::string node_name(event->tag);
@@ -203,6 +230,69 @@ void ProfileSummarizer::ProcessProfiles(
   }
 }
 
+std::vector<OpEfficiency> ProfileSummarizer::GetOpEfficiencies(
+    const Roofline& roofline, double min_roofline_fraction) const {
+  std::vector<std::pair<int64_t, OpEfficiency>> ops_by_total_us;
+  for (const auto& [node, totals] : op_totals_) {
+    if (totals.count == 0) continue;
+    OpEfficiency op;
+    op.name = totals.name;
+    op.type = totals.type;
+    op.count = totals.count;
+    op.avg_us = static_cast<double>(totals.total_us) / totals.count;
+    op.cost.flops = totals.total_cost.flops / totals.count;
+    op.cost.bytes = totals.total_cost.bytes / totals.count;
+    if (totals.total_us > 0) {
+      // Flops per microsecond are MFLOP/s.
+      op.gflops = totals.total_cost.flops / totals.total_us / 1e3;
+      op.gbps = totals.total_cost.bytes / totals.total_us / 1e3;
+    }
+    if (op.cost.bytes > 0) {
+      op.arithmetic_intensity = op.cost.flops / op.cost.bytes;
+    }
+    op.compute_bound = op.cost.flops > 0 &&
+                       op.arithmetic_intensity >= roofline.ridge_point();
+    if (op.cost.flops > 0) {
+      const double attainable =
+          roofline.AttainableGflops(op.arithmetic_intensity);
+      if (attainable > 0) op.roofline_fraction = op.gflops / attainable;
+    } else if (roofline.peak_gbps > 0) {
+      op.roofline_fraction = op.gbps / roofline.peak_gbps;
+    }
+    // Ops too fast to be timed can't be judged.
+    op.far_from_roofline =
+        totals.total_us > 0 && op.roofline_fraction < min_roofline_fraction;
+    ops_by_total_us.emplace_back(totals.total_us, std::move(op));
+  }
+  std::stable_sort(
+      ops_by_total_us.begin(), ops_by_total_us.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+  std::vector<OpEfficiency> ops;
+  ops.reserve(ops_by_total_us.size());
+  for (auto& [total_us, op] : ops_by_total_us) ops.push_back(std::move(op));
+  return ops;
+}
+
+std::vector<OpHardwareCounters> ProfileSummarizer::GetOpHardwareCounters()
+    const {
+  std::vector<std::pair<int64_t, OpHardwareCounters>> ops_by_total_us;
+  for (const auto& [node, totals] : op_totals_) {
+    if (totals.hw_counters_count == 0) continue;
+    ops_by_total_us.emplace_back(
+        totals.hw_counters_total_us,
+        profiling::GetOpHardwareCounters(
+            totals.name, totals.type, totals.hw_counters_count,
+            totals.hw_counters_total_us, totals.total_hw_counters));
+  }
+  std::stable_sort(
+      ops_by_total_us.begin(), ops_by_total_us.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+  std::vector<OpHardwareCounters> ops;
+  ops.reserve(ops_by_total_us.size());
+  for (auto& [total_us, op] : ops_by_total_us) ops.push_back(std::move(op));
+  return ops;
+}
+
 tensorflow::StatsCalculator* ProfileSummarizer::GetStatsCalculator(
     uint32_t subgraph_index) {
   if (stats_calculator_map_.count(subgraph_index) == 0) {
@@ -16,16 +16,20 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_PROFILING_PROFILE_SUMMARIZER_H_
 #define TENSORFLOW_LITE_PROFILING_PROFILE_SUMMARIZER_H_
 
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/util/stats_calculator.h"
 #include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/profiling/perf_event_counters.h"
 #include "tensorflow/lite/profiling/profile_buffer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/roofline.h"
 
 namespace tflite {
 namespace profiling {
@@ -54,6 +58,35 @@ class ProfileSummarizer {
                                                *delegate_stats_calculator_);
   }
 
+  // Returns the efficiency of the profiled ops against `roofline`, most
+  // time-consuming first. Ops below `min_roofline_fraction` of the roofline
+  // are flagged as far from it.
+  std::vector<OpEfficiency> GetOpEfficiencies(
+      const Roofline& roofline, double min_roofline_fraction = 0.1) const;
+
+  // Returns the roofline report of the profiled ops, as CSV if the summary
+  // formatter formats as CSV.
+  std::string GetRooflineReport(const Roofline& roofline) const {
+    return FormatRooflineReport(
+        GetOpEfficiencies(roofline), roofline,
+        summary_formatter_->GetStatSummarizerOptions().format_as_csv
+            ? RooflineReportFormat::kCsv
+            : RooflineReportFormat::kText);
+  }
+
+  // Returns the hardware counters per invocation of the profiled ops whose
+  // invocations were recorded with counters, e.g. by a PerfEventProfiler, most
+  // time-consuming first.
+  std::vector<OpHardwareCounters> GetOpHardwareCounters() const;
+
+  // Returns the hardware counter report of the profiled ops, as CSV if the
+  // summary formatter formats as CSV.
+  std::string GetHardwareCounterReport() const {
+    return FormatHardwareCounterReport(
+        GetOpHardwareCounters(),
+        summary_formatter_->GetStatSummarizerOptions().format_as_csv);
+  }
+
   tensorflow::StatsCalculator* GetStatsCalculator(uint32_t subgraph_index);
 
   bool HasProfiles() {
@@ -65,12 +98,28 @@ class ProfileSummarizer {
   }
 
  private:
+  // Accumulated cost and time of the invocations of an op.
+  struct OpTotals {
+    std::string name;
+    std::string type;
+    int64_t count = 0;
+    int64_t total_us = 0;
+    OpCost total_cost;
+    // Invocations with hardware counters, and their time and counters.
+    int64_t hw_counters_count = 0;
+    int64_t hw_counters_total_us = 0;
+    HardwareCounters total_hw_counters;
+  };
+
   // Map storing stats per subgraph.
   std::map<uint32_t, std::unique_ptr<tensorflow::StatsCalculator>>
       stats_calculator_map_;
 
   std::unique_ptr<tensorflow::StatsCalculator> delegate_stats_calculator_;
 
+  // Totals per (subgraph index, node index).
+  std::map<std::pair<uint32_t, uint32_t>, OpTotals> op_totals_;
+
   // Summary formatter for customized output formats.
   std::shared_ptr<ProfileSummaryFormatter> summary_formatter_;
 };
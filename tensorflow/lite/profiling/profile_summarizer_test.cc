@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/subgraph_test_util.h"
 #include "tensorflow/lite/kernels/test_util.h"
 #include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
 #include "tensorflow/lite/version.h"
 
 namespace tflite {
@@ -149,6 +150,81 @@ TEST(ProfileSummarizerTest, InterpreterPlusProfilingDetails) {
       << output;
 }
 
+TEST(ProfileSummarizerTest, OpEfficiencies) {
+  BufferedProfiler profiler(1024);
+  SimpleOpModel m;
+  m.Init(RegisterSimpleOp);
+  auto interpreter = m.GetInterpreter();
+  interpreter->SetProfiler(&profiler);
+  profiler.StartProfiling();
+  m.SetInputs(1, 2);
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  profiler.StopProfiling();
+  ProfileSummarizer summarizer;
+  summarizer.ProcessProfiles(profiler.GetProfileEvents(), *interpreter);
+
+  Roofline roofline;
+  roofline.peak_gflops = 100;
+  roofline.peak_gbps = 10;
+  auto ops = summarizer.GetOpEfficiencies(roofline);
+  ASSERT_EQ(ops.size(), 1);
+  EXPECT_EQ(ops[0].type, "SimpleOpEval");
+  EXPECT_EQ(ops[0].count, 2);
+  // The cost of custom ops isn't modeled, only their 3 int32 tensors are.
+  EXPECT_EQ(ops[0].cost.flops, 0);
+  EXPECT_EQ(ops[0].cost.bytes, 3 * sizeof(int32_t));
+  EXPECT_FALSE(ops[0].compute_bound);
+  EXPECT_NE(summarizer.GetRooflineReport(roofline).find("SimpleOpEval"),
+            std::string::npos);
+}
+
+TEST(ProfileSummarizerTest, OpHardwareCounters) {
+  PerfEventProfiler profiler(1024, false);
+  SimpleOpModel m;
+  m.Init(RegisterSimpleOp);
+  auto interpreter = m.GetInterpreter();
+  interpreter->SetProfiler(&profiler);
+  profiler.StartProfiling();
+  m.SetInputs(1, 2);
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  profiler.StopProfiling();
+  ProfileSummarizer summarizer;
+  summarizer.ProcessProfiles(profiler.GetProfileEvents(), *interpreter);
+
+  auto ops = summarizer.GetOpHardwareCounters();
+  if (profiler.available_hw_counters() == 0) {
+    // Perf events are unavailable, e.g. in a container, so only the times are
+    // profiled.
+    EXPECT_TRUE(ops.empty());
+    EXPECT_TRUE(summarizer.HasProfiles());
+    return;
+  }
+  ASSERT_EQ(ops.size(), 1);
+  EXPECT_EQ(ops[0].type, "SimpleOpEval");
+  EXPECT_EQ(ops[0].count, 2);
+  EXPECT_EQ(ops[0].available, profiler.available_hw_counters());
+  EXPECT_NE(summarizer.GetHardwareCounterReport().find("SimpleOpEval"),
+            std::string::npos);
+}
+
+TEST(ProfileSummarizerTest, NoOpHardwareCountersWithoutPerfEvents) {
+  BufferedProfiler profiler(1024);
+  SimpleOpModel m;
+  m.Init(RegisterSimpleOp);
+  auto interpreter = m.GetInterpreter();
+  interpreter->SetProfiler(&profiler);
+  profiler.StartProfiling();
+  m.SetInputs(1, 2);
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  profiler.StopProfiling();
+  ProfileSummarizer summarizer;
+  summarizer.ProcessProfiles(profiler.GetProfileEvents(), *interpreter);
+
+  EXPECT_TRUE(summarizer.GetOpHardwareCounters().empty());
+}
+
 // A simple test that performs `ADD` if condition is true, and `MUL` otherwise.
 // The computation is: `cond ? a + b : a * b`.
 class ProfileSummarizerIfOpTest : public subgraph_test_util::ControlFlowOpTest {
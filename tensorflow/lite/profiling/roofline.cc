@@ -0,0 +1,268 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/roofline.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/core/c/builtin_op_data.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+int64_t NumElements(const TfLiteTensor* tensor) {
+  if (tensor == nullptr || tensor->dims == nullptr) return 0;
+  int64_t num_elements = 1;
+  for (int i = 0; i < tensor->dims->size; ++i) {
+    num_elements *= tensor->dims->data[i];
+  }
+  return num_elements;
+}
+
+// Returns dimension `i` of `tensor`, counting from the end if negative, or 0
+// if it doesn't exist.
+int64_t Dim(const TfLiteTensor* tensor, int i) {
+  if (tensor == nullptr || tensor->dims == nullptr) return 0;
+  const int rank = tensor->dims->size;
+  if (i < 0) i += rank;
+  return i >= 0 && i < rank ? tensor->dims->data[i] : 0;
+}
+
+const TfLiteTensor* GetTensor(const Subgraph& subgraph,
+                              const TfLiteIntArray* indices, int i) {
+  if (indices == nullptr || i >= indices->size || indices->data[i] < 0) {
+    return nullptr;
+  }
+  return subgraph.tensor(indices->data[i]);
+}
+
+double GetBytes(const Subgraph& subgraph, const TfLiteIntArray* indices) {
+  double bytes = 0;
+  for (int i = 0; indices != nullptr && i < indices->size; ++i) {
+    const TfLiteTensor* tensor = GetTensor(subgraph, indices, i);
+    if (tensor != nullptr) bytes += tensor->bytes;
+  }
+  return bytes;
+}
+
+std::string EscapeJson(const std::string& str) {
+  std::stringstream stream;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      stream << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(c) << std::dec << std::setfill(' ');
+    } else {
+      stream << c;
+    }
+  }
+  return stream.str();
+}
+
+// Quotes `str` for CSV if it contains a separator or quote.
+std::string EscapeCsv(const std::string& str) {
+  if (str.find_first_of(",\"\n") == std::string::npos) return str;
+  std::string escaped = "\"";
+  for (char c : str) {
+    if (c == '"') escaped += '"';
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+}  // namespace
+
+OpCost EstimateOpCost(const Subgraph& subgraph, const TfLiteNode& node,
+                      const TfLiteRegistration& registration) {
+  OpCost cost;
+  cost.bytes =
+      GetBytes(subgraph, node.inputs) + GetBytes(subgraph, node.outputs);
+
+  const TfLiteTensor* input = GetTensor(subgraph, node.inputs, 0);
+  const TfLiteTensor* output = GetTensor(subgraph, node.outputs, 0);
+  const double output_size = NumElements(output);
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinConv2d: {
+      // The filter is [output_depth, height, width, input_depth / groups].
+      const TfLiteTensor* filter = GetTensor(subgraph, node.inputs, 1);
+      cost.flops =
+          2 * output_size * Dim(filter, 1) * Dim(filter, 2) * Dim(filter, 3);
+      break;
+    }
+    case kTfLiteBuiltinDepthwiseConv2d: {
+      // The filter is [1, height, width, output_depth].
+      const TfLiteTensor* filter = GetTensor(subgraph, node.inputs, 1);
+      cost.flops = 2 * output_size * Dim(filter, 1) * Dim(filter, 2);
+      break;
+    }
+    case kTfLiteBuiltinTransposeConv: {
+      // The inputs are the output shape, the filter, which is
+      // [output_depth, height, width, input_depth], and the input.
+      const TfLiteTensor* filter = GetTensor(subgraph, node.inputs, 1);
+      const TfLiteTensor* conv_input = GetTensor(subgraph, node.inputs, 2);
+      cost.flops = 2.0 * NumElements(conv_input) * Dim(filter, 0) *
+                   Dim(filter, 1) * Dim(filter, 2);
+      break;
+    }
+    case kTfLiteBuiltinFullyConnected: {
+      // The weights are [units, depth].
+      const TfLiteTensor* weights = GetTensor(subgraph, node.inputs, 1);
+      cost.flops = 2 * output_size * Dim(weights, 1);
+      break;
+    }
+    case kTfLiteBuiltinBatchMatmul: {
+      const auto* params =
+          static_cast<const TfLiteBatchMatMulParams*>(node.builtin_data);
+      const bool adj_x = params != nullptr && params->adj_x;
+      cost.flops = 2 * output_size * Dim(input, adj_x ? -2 : -1);
+      break;
+    }
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinMaxPool2d:
+    case kTfLiteBuiltinL2Pool2d: {
+      const auto* params =
+          static_cast<const TfLitePoolParams*>(node.builtin_data);
+      if (params != nullptr) {
+        cost.flops =
+            output_size * params->filter_width * params->filter_height;
+      }
+      break;
+    }
+    case kTfLiteBuiltinSoftmax:
+    case kTfLiteBuiltinLogSoftmax:
+      // The max, the exponential of the difference, the sum and the division.
+      cost.flops = 4 * output_size;
+      break;
+    case kTfLiteBuiltinMean:
+    case kTfLiteBuiltinSum:
+    case kTfLiteBuiltinReduceMax:
+    case kTfLiteBuiltinReduceMin:
+    case kTfLiteBuiltinReduceProd:
+      cost.flops = NumElements(input);
+      break;
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinSub:
+    case kTfLiteBuiltinMul:
+    case kTfLiteBuiltinDiv:
+    case kTfLiteBuiltinMaximum:
+    case kTfLiteBuiltinMinimum:
+    case kTfLiteBuiltinSquaredDifference:
+    case kTfLiteBuiltinRelu:
+    case kTfLiteBuiltinRelu6:
+    case kTfLiteBuiltinReluN1To1:
+    case kTfLiteBuiltinRelu0To1:
+    case kTfLiteBuiltinLeakyRelu:
+    case kTfLiteBuiltinPrelu:
+    case kTfLiteBuiltinElu:
+    case kTfLiteBuiltinGelu:
+    case kTfLiteBuiltinHardSwish:
+    case kTfLiteBuiltinLogistic:
+    case kTfLiteBuiltinTanh:
+    case kTfLiteBuiltinExp:
+    case kTfLiteBuiltinSqrt:
+    case kTfLiteBuiltinRsqrt:
+    case kTfLiteBuiltinSquare:
+    case kTfLiteBuiltinAbs:
+    case kTfLiteBuiltinNeg:
+      cost.flops = output_size;
+      break;
+    default:
+      break;
+  }
+  return cost;
+}
+
+std::string FormatRooflineReport(const std::vector<OpEfficiency>& ops,
+                                 const Roofline& roofline,
+                                 RooflineReportFormat format) {
+  std::stringstream stream;
+  switch (format) {
+    case RooflineReportFormat::kText:
+      stream << "Roofline: " << roofline.peak_gflops << " GFLOP/s, "
+             << roofline.peak_gbps << " GB/s, ridge point "
+             << roofline.ridge_point() << " FLOP/byte" << std::endl;
+      stream << std::setw(24) << "[node type]" << std::setw(10) << "[count]"
+             << std::setw(12) << "[avg ms]" << std::setw(12) << "[MFLOP]"
+             << std::setw(10) << "[MB]" << std::setw(12) << "[FLOP/B]"
+             << std::setw(12) << "[GFLOP/s]" << std::setw(10) << "[GB/s]"
+             << std::setw(10) << "[bound]" << std::setw(12) << "[% of roof]"
+             << "\t[Name]" << std::endl;
+      stream << std::fixed;
+      for (const OpEfficiency& op : ops) {
+        stream << std::setw(24) << op.type << std::setw(10) << op.count
+               << std::setprecision(3) << std::setw(12) << op.avg_us / 1e3
+               << std::setw(12) << op.cost.flops / 1e6 << std::setw(10)
+               << op.cost.bytes / 1e6 << std::setw(12)
+               << op.arithmetic_intensity << std::setw(12) << op.gflops
+               << std::setw(10) << op.gbps << std::setw(10)
+               << (op.compute_bound ? "compute" : "memory")
+               << std::setprecision(1) << std::setw(11)
+               << op.roofline_fraction * 100 << "%"
+               << "\t" << op.name
+               << (op.far_from_roofline ? " (far from roofline)" : "")
+               << std::endl;
+      }
+      break;
+    case RooflineReportFormat::kCsv:
+      stream << "node type,name,count,avg us,flops,bytes,flops per byte,"
+                "gflops per second,gb per second,compute bound,"
+                "roofline fraction,far from roofline"
+             << std::endl;
+      for (const OpEfficiency& op : ops) {
+        stream << EscapeCsv(op.type) << "," << EscapeCsv(op.name) << ","
+               << op.count << "," << op.avg_us << "," << op.cost.flops << ","
+               << op.cost.bytes << "," << op.arithmetic_intensity << ","
+               << op.gflops << "," << op.gbps << "," << op.compute_bound
+               << "," << op.roofline_fraction << "," << op.far_from_roofline
+               << std::endl;
+      }
+      break;
+    case RooflineReportFormat::kJson:
+      stream << "{\"roofline\": {\"peak_gflops\": " << roofline.peak_gflops
+             << ", \"peak_gbps\": " << roofline.peak_gbps
+             << ", \"ridge_point\": " << roofline.ridge_point()
+             << "}, \"ops\": [";
+      for (size_t i = 0; i < ops.size(); ++i) {
+        const OpEfficiency& op = ops[i];
+        stream << (i > 0 ? ", " : "") << "{\"type\": \""
+               << EscapeJson(op.type) << "\", \"name\": \""
+               << EscapeJson(op.name) << "\", \"count\": " << op.count
+               << ", \"avg_us\": " << op.avg_us
+               << ", \"flops\": " << op.cost.flops
+               << ", \"bytes\": " << op.cost.bytes
+               << ", \"arithmetic_intensity\": " << op.arithmetic_intensity
+               << ", \"gflops\": " << op.gflops << ", \"gbps\": " << op.gbps
+               << ", \"compute_bound\": "
+               << (op.compute_bound ? "true" : "false")
+               << ", \"roofline_fraction\": " << op.roofline_fraction
+               << ", \"far_from_roofline\": "
+               << (op.far_from_roofline ? "true" : "false") << "}";
+      }
+      stream << "]}" << std::endl;
+      break;
+  }
+  return stream.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,92 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_ROOFLINE_H_
+#define TENSORFLOW_LITE_PROFILING_ROOFLINE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+
+namespace tflite {
+namespace profiling {
+
+// Work done by one invocation of an op.
+struct OpCost {
+  // Arithmetic operations, counting a multiply-add as 2. For quantized ops,
+  // these are integer operations.
+  double flops = 0;
+  // Bytes of the input and output tensors, i.e. the least memory traffic of
+  // the op if none of them is in the caches.
+  double bytes = 0;
+};
+
+// Estimates the cost of `node` from the shapes of its tensors and its params.
+// Ops whose cost isn't modeled, e.g. data movement ops or delegate kernels,
+// only have bytes.
+OpCost EstimateOpCost(const Subgraph& subgraph, const TfLiteNode& node,
+                      const TfLiteRegistration& registration);
+
+// Peak compute throughput and memory bandwidth of the machine. An op with an
+// arithmetic intensity of I flops per byte can at best run at
+// min(peak_gflops, peak_gbps * I) GFLOP/s.
+struct Roofline {
+  double peak_gflops = 0;
+  double peak_gbps = 0;
+
+  // Arithmetic intensity above which ops are compute-bound.
+  double ridge_point() const {
+    return peak_gbps > 0 ? peak_gflops / peak_gbps : 0;
+  }
+  double AttainableGflops(double arithmetic_intensity) const {
+    return std::min(peak_gflops, peak_gbps * arithmetic_intensity);
+  }
+};
+
+// How close an op of the profiled model runs to the roofline.
+struct OpEfficiency {
+  std::string name;
+  std::string type;
+  int64_t count = 0;
+  double avg_us = 0;
+  // Cost of an average invocation.
+  OpCost cost;
+  // Achieved throughputs.
+  double gflops = 0;
+  double gbps = 0;
+  // cost.flops / cost.bytes.
+  double arithmetic_intensity = 0;
+  bool compute_bound = false;
+  // Achieved fraction of the roofline at the arithmetic intensity of the op,
+  // or of the memory bandwidth for ops without flops.
+  double roofline_fraction = 0;
+  // True if `roofline_fraction` is below the threshold of the report.
+  bool far_from_roofline = false;
+};
+
+enum class RooflineReportFormat { kText, kCsv, kJson };
+
+// Formats the efficiency of `ops` against `roofline`.
+std::string FormatRooflineReport(const std::vector<OpEfficiency>& ops,
+                                 const Roofline& roofline,
+                                 RooflineReportFormat format);
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_ROOFLINE_H_
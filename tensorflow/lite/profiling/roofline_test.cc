@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/roofline.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using ::testing::HasSubstr;
+
+// Returns the cost of a single `builtin_code` node of `interpreter` whose
+// tensors have the given shapes.
+OpCost GetCost(int builtin_code, const std::vector<std::vector<int>>& inputs,
+               const std::vector<int>& output) {
+  Interpreter interpreter;
+  const int num_tensors = inputs.size() + 1;
+  EXPECT_EQ(interpreter.AddTensors(num_tensors), kTfLiteOk);
+  std::vector<int> input_indices;
+  for (int i = 0; i < num_tensors - 1; ++i) {
+    EXPECT_EQ(interpreter.SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", inputs[i], TfLiteQuantization()),
+              kTfLiteOk);
+    input_indices.push_back(i);
+  }
+  EXPECT_EQ(interpreter.SetTensorParametersReadWrite(
+                num_tensors - 1, kTfLiteFloat32, "", output,
+                TfLiteQuantization()),
+            kTfLiteOk);
+  TfLiteRegistration registration = {};
+  registration.builtin_code = builtin_code;
+  EXPECT_EQ(interpreter.AddNodeWithParameters(input_indices, {num_tensors - 1},
+                                              nullptr, 0, nullptr,
+                                              &registration),
+            kTfLiteOk);
+  const Subgraph& subgraph = interpreter.primary_subgraph();
+  const auto* node_and_registration = subgraph.node_and_registration(0);
+  return EstimateOpCost(subgraph, node_and_registration->first,
+                        node_and_registration->second);
+}
+
+TEST(RooflineTest, FullyConnectedCost) {
+  const OpCost cost =
+      GetCost(kTfLiteBuiltinFullyConnected, {{4, 16}, {8, 16}, {8}}, {4, 8});
+  EXPECT_EQ(cost.flops, 2 * 4 * 8 * 16);
+  EXPECT_EQ(cost.bytes, (4 * 16 + 8 * 16 + 8 + 4 * 8) * sizeof(float));
+}
+
+TEST(RooflineTest, Conv2dCost) {
+  const OpCost cost = GetCost(kTfLiteBuiltinConv2d,
+                              {{1, 8, 8, 3}, {16, 3, 3, 3}}, {1, 8, 8, 16});
+  EXPECT_EQ(cost.flops, 2 * 8 * 8 * 16 * 3 * 3 * 3);
+}
+
+TEST(RooflineTest, UnmodeledOpOnlyHasBytes) {
+  const OpCost cost = GetCost(kTfLiteBuiltinReshape, {{2, 3}}, {6});
+  EXPECT_EQ(cost.flops, 0);
+  EXPECT_EQ(cost.bytes, 12 * sizeof(float));
+}
+
+TEST(RooflineTest, RidgePoint) {
+  Roofline roofline;
+  roofline.peak_gflops = 100;
+  roofline.peak_gbps = 10;
+  EXPECT_EQ(roofline.ridge_point(), 10);
+  EXPECT_EQ(roofline.AttainableGflops(1), 10);
+  EXPECT_EQ(roofline.AttainableGflops(100), 100);
+}
+
+TEST(RooflineTest, FormatReport) {
+  Roofline roofline;
+  roofline.peak_gflops = 100;
+  roofline.peak_gbps = 10;
+  OpEfficiency op;
+  op.name = "conv \"1\"";
+  op.type = "CONV_2D";
+  op.count = 2;
+  op.far_from_roofline = true;
+
+  EXPECT_THAT(FormatRooflineReport({op}, roofline, RooflineReportFormat::kText),
+              HasSubstr("far from roofline"));
+  EXPECT_THAT(FormatRooflineReport({op}, roofline, RooflineReportFormat::kCsv),
+              HasSubstr("CONV_2D,\"conv \"\"1\"\"\",2,"));
+  const std::string json =
+      FormatRooflineReport({op}, roofline, RooflineReportFormat::kJson);
+  EXPECT_THAT(json, HasSubstr("\"peak_gflops\": 100"));
+  EXPECT_THAT(json, HasSubstr("\"name\": \"conv \\\"1\\\"\""));
+  EXPECT_THAT(json, HasSubstr("\"far_from_roofline\": true"));
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
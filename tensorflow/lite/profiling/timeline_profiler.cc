@@ -0,0 +1,134 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/timeline_profiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+std::string EscapeJson(const std::string& value) {
+  std::string escaped;
+  for (char c : value) {
+    if (c == '"' || c == '\\') escaped.push_back('\\');
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+
+}  // namespace
+
+TimelineProfiler::TimelineProfiler(size_t max_num_events)
+    : max_num_events_(max_num_events) {}
+
+uint32_t TimelineProfiler::BeginEvent(const char* tag, EventType event_type,
+                                      int64_t event_metadata1,
+                                      int64_t event_metadata2) {
+  const uint64_t now = time::NowMicros();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (events_.size() >= max_num_events_) return 0;
+  const auto thread =
+      threads_.emplace(std::this_thread::get_id(), threads_.size()).first;
+  events_.push_back({tag != nullptr ? tag : "", event_type, event_metadata1,
+                     event_metadata2, thread->second, now, 0});
+  // Handles start at 1, so that 0 is never a valid handle.
+  return events_.size();
+}
+
+void TimelineProfiler::EndEvent(uint32_t event_handle) {
+  const uint64_t now = time::NowMicros();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (event_handle == 0 || event_handle > events_.size()) return;
+  events_[event_handle - 1].end_us = now;
+}
+
+void TimelineProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.clear();
+}
+
+std::vector<TimelineProfiler::Event> TimelineProfiler::GetEvents() const {
+  std::vector<Event> events;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Event& event : events_) {
+      if (event.end_us != 0) events.push_back(event);
+    }
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const Event& a, const Event& b) {
+                     return a.begin_us < b.begin_us;
+                   });
+  return events;
+}
+
+std::string TimelineProfiler::ToChromeTrace() const {
+  std::ostringstream trace;
+  trace << "{\"traceEvents\":[";
+  bool first = true;
+  for (const Event& event : GetEvents()) {
+    if (!first) trace << ",";
+    first = false;
+    trace << "{\"name\":\"" << EscapeJson(event.tag) << "\",\"ph\":\"X\""
+          << ",\"ts\":" << event.begin_us
+          << ",\"dur\":" << event.end_us - event.begin_us
+          << ",\"pid\":0,\"tid\":" << event.thread << ",\"args\":{";
+    if (event.event_type == EventType::OPERATOR_INVOKE_EVENT) {
+      trace << "\"node\":" << event.event_metadata1
+            << ",\"subgraph\":" << event.event_metadata2;
+    }
+    trace << "}}";
+  }
+  trace << "]}";
+  return trace.str();
+}
+
+int TimelineProfiler::GetMaxConcurrentOperators() const {
+  // Sweeps the begin (+1) and end (-1) of operator invocations by time, ends
+  // first on ties. Invocations shorter than a microsecond can't be told apart
+  // and are skipped.
+  std::vector<std::pair<uint64_t, int>> changes;
+  for (const Event& event : GetEvents()) {
+    if (event.event_type != EventType::OPERATOR_INVOKE_EVENT ||
+        event.end_us == event.begin_us) {
+      continue;
+    }
+    changes.emplace_back(event.begin_us, 1);
+    changes.emplace_back(event.end_us, -1);
+  }
+  std::sort(changes.begin(), changes.end());
+  int concurrent = 0;
+  int max_concurrent = 0;
+  for (const auto& change : changes) {
+    concurrent += change.second;
+    max_concurrent = std::max(max_concurrent, concurrent);
+  }
+  return max_concurrent;
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_TIMELINE_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_TIMELINE_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// A thread-safe profiler recording when and on which thread each event ran,
+// e.g. to check which operators overlap when independent nodes run
+// concurrently (see `InterpreterOptions::SetInterOpParallelism`).
+//
+// Install it with `Interpreter::AddProfiler`, and write the timeline with
+// `ToChromeTrace` to view it in chrome://tracing or Perfetto.
+class TimelineProfiler : public Profiler {
+ public:
+  struct Event {
+    std::string tag;
+    EventType event_type;
+    // For operator events, the node index and the subgraph index.
+    int64_t event_metadata1;
+    int64_t event_metadata2;
+    // Threads are numbered from 0 in the order they first began an event.
+    int thread;
+    uint64_t begin_us;
+    // Zero while the event is running.
+    uint64_t end_us;
+  };
+
+  // Events beyond `max_num_events` are dropped.
+  explicit TimelineProfiler(size_t max_num_events = 1 << 16);
+
+  TimelineProfiler(const TimelineProfiler&) = delete;
+  TimelineProfiler& operator=(const TimelineProfiler&) = delete;
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+
+  void EndEvent(uint32_t event_handle) override;
+
+  // Drops all the events.
+  void Reset();
+
+  // Returns the events which ended, by begin time.
+  std::vector<Event> GetEvents() const;
+
+  // Returns the events which ended in the Chrome trace event format.
+  std::string ToChromeTrace() const;
+
+  // Returns the largest number of operator invocations which overlapped in
+  // time, at microsecond resolution.
+  int GetMaxConcurrentOperators() const;
+
+ private:
+  const size_t max_num_events_;
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  std::map<std::thread::id, int> threads_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_TIMELINE_PROFILER_H_
@@ -0,0 +1,92 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/timeline_profiler.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using EventType = Profiler::EventType;
+
+TEST(TimelineProfilerTest, RecordsEvents) {
+  TimelineProfiler profiler;
+  uint32_t handle =
+      profiler.BeginEvent("ADD", EventType::OPERATOR_INVOKE_EVENT, 3, 1);
+  time::SleepForMicros(100);
+  profiler.EndEvent(handle);
+
+  std::vector<TimelineProfiler::Event> events = profiler.GetEvents();
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].tag, "ADD");
+  EXPECT_EQ(events[0].event_metadata1, 3);
+  EXPECT_EQ(events[0].event_metadata2, 1);
+  EXPECT_EQ(events[0].thread, 0);
+  EXPECT_GE(events[0].end_us - events[0].begin_us, 100);
+  EXPECT_NE(profiler.ToChromeTrace().find(
+                "\"name\":\"ADD\",\"ph\":\"X\""),
+            std::string::npos);
+  EXPECT_EQ(profiler.GetMaxConcurrentOperators(), 1);
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.GetEvents().empty());
+}
+
+TEST(TimelineProfilerTest, SkipsRunningEvents) {
+  TimelineProfiler profiler;
+  profiler.BeginEvent("Invoke", EventType::DEFAULT, 0, 0);
+  EXPECT_TRUE(profiler.GetEvents().empty());
+  EXPECT_EQ(profiler.ToChromeTrace(), "{\"traceEvents\":[]}");
+}
+
+TEST(TimelineProfilerTest, DropsEventsBeyondCapacity) {
+  TimelineProfiler profiler(/*max_num_events=*/1);
+  profiler.EndEvent(profiler.BeginEvent("A", EventType::DEFAULT, 0, 0));
+  uint32_t handle = profiler.BeginEvent("B", EventType::DEFAULT, 0, 0);
+  EXPECT_EQ(handle, 0);
+  profiler.EndEvent(handle);
+  EXPECT_EQ(profiler.GetEvents().size(), 1);
+}
+
+TEST(TimelineProfilerTest, MeasuresOverlap) {
+  TimelineProfiler profiler;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace_back([&profiler, i] {
+      uint32_t handle = profiler.BeginEvent(
+          "NEG", EventType::OPERATOR_INVOKE_EVENT, i, 0);
+      time::SleepForMicros(50000);
+      profiler.EndEvent(handle);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  std::vector<TimelineProfiler::Event> events = profiler.GetEvents();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_NE(events[0].thread, events[1].thread);
+  EXPECT_EQ(profiler.GetMaxConcurrentOperators(), 2);
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
@@ -587,6 +587,7 @@ def build_conversion_flags(
     mlir_elide_elementsattrs_if_larger=None,
     use_buffer_offset=False,
     reduce_type_precision=False,
+    enable_attention_fusion=False,
     **_
 ):
   """Builds protocol buffer describing a conversion of a model.
@@ -711,6 +712,9 @@ def build_conversion_flags(
     reduce_type_precision: Convert some tensor types to a lower precision if all
       values within that tensor are within the range of the lower precision.
       This could have side effects e.g. reduced flatbuffer size.
+    enable_attention_fusion: Fuse the scaled dot-product attention of
+      transformer layers into the FusedAttention custom op of the TFLite
+      runtime, which doesn't materialize the attention scores.
 
   Returns:
     conversion_flags: protocol buffer describing the conversion process.
@@ -824,6 +828,8 @@ def build_conversion_flags(
     conversion_flags.use_buffer_offset = use_buffer_offset
   if reduce_type_precision is not None:
     conversion_flags.reduce_type_precision = reduce_type_precision
+  if enable_attention_fusion is not None:
+    conversion_flags.enable_attention_fusion = enable_attention_fusion
   return conversion_flags
 
 
@@ -142,6 +142,13 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Schedules memory allocation at a known offset, e.g. one computed by a
+  // previous run of `Allocate` for an identical sequence of allocations. The
+  // caller is responsible for the allocation not overlapping active ones.
+  TfLiteStatus AllocateAt(TfLiteContext* context, size_t alignment,
+                          const ArenaAllocWithUsageInterval& alloc,
+                          ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Commit(bool* arena_reallocated);
 
   TfLiteStatus ResolveAlloc(TfLiteContext* context,
@@ -0,0 +1,141 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Reports the size of the non-persistent arena of a set of .tflite models
+// under each arena planning algorithm, e.g.
+//
+//   arena_planning_report --graphs=a.tflite,b.tflite --time_budget_us=100000
+//
+// prints one CSV line per model and algorithm with the arena size in bytes
+// and the time spent in AllocateTensors(). That time includes preparing the
+// ops, which is the same for every algorithm, so the difference between the
+// algorithms is the difference in planning time. Delegates are not applied, so
+// that all tensors are planned by the arena planner.
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_split.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/core/model_builder.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/interpreter_options.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+
+namespace tflite {
+namespace {
+
+struct ArenaReport {
+  size_t arena_size = 0;
+  size_t persistent_arena_size = 0;
+  double allocate_tensors_time_ms = 0;
+};
+
+bool PlanModel(const FlatBufferModel& model, ArenaPlanningAlgorithm algorithm,
+               int time_budget_us, ArenaReport* report) {
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+  InterpreterOptions options;
+  options.SetArenaPlanningAlgorithm(algorithm, time_budget_us);
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(model, resolver, &options)(&interpreter) !=
+          kTfLiteOk ||
+      interpreter == nullptr) {
+    return false;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  if (interpreter->AllocateTensors() != kTfLiteOk) return false;
+  report->allocate_tensors_time_ms =
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+
+  for (size_t i = 0; i < interpreter->subgraphs_size(); ++i) {
+    Subgraph::SubgraphAllocInfo alloc_info;
+    interpreter->subgraph(i)->GetMemoryAllocInfo(&alloc_info);
+    report->arena_size += alloc_info.arena_size;
+    report->persistent_arena_size += alloc_info.arena_persist_size;
+  }
+  return true;
+}
+
+int Run(int argc, char** argv) {
+  std::string graphs;
+  int time_budget_us = InterpreterOptions().GetArenaPlanningTimeBudgetUs();
+  std::vector<Flag> flag_list = {
+      Flag::CreateFlag("graphs", &graphs,
+                       "Paths to the .tflite models, separated by comma.",
+                       Flag::kRequired),
+      Flag::CreateFlag("time_budget_us", &time_budget_us,
+                       "Time budget of each planning pass of the "
+                       "best-fit search, in microseconds."),
+  };
+  if (!Flags::Parse(&argc, const_cast<const char**>(argv), flag_list)) {
+    std::cerr << Flags::Usage(argv[0], flag_list);
+    return 1;
+  }
+
+  const std::pair<const char*, ArenaPlanningAlgorithm> algorithms[] = {
+      {"greedy_by_size", ArenaPlanningAlgorithm::kGreedyBySize},
+      {"best_fit_search", ArenaPlanningAlgorithm::kBestFitSearch},
+  };
+
+  int num_failures = 0;
+  std::cout << "model,algorithm,arena_bytes,persistent_arena_bytes,"
+               "reduction_percent,allocate_tensors_ms\n";
+  const std::vector<std::string> paths = absl::StrSplit(graphs, ',');
+  for (const std::string& path : paths) {
+    std::unique_ptr<FlatBufferModel> model =
+        FlatBufferModel::BuildFromFile(path.c_str());
+    if (model == nullptr) {
+      std::cerr << "Failed to load " << path << "\n";
+      ++num_failures;
+      continue;
+    }
+    size_t baseline_arena_size = 0;
+    for (const auto& [name, algorithm] : algorithms) {
+      ArenaReport report;
+      if (!PlanModel(*model, algorithm, time_budget_us, &report)) {
+        std::cerr << "Failed to plan " << path << " with " << name << "\n";
+        ++num_failures;
+        continue;
+      }
+      if (algorithm == ArenaPlanningAlgorithm::kGreedyBySize) {
+        baseline_arena_size = report.arena_size;
+      }
+      const double reduction =
+          baseline_arena_size == 0
+              ? 0
+              : 100.0 * (1.0 - static_cast<double>(report.arena_size) /
+                                   baseline_arena_size);
+      std::cout << path << "," << name << "," << report.arena_size << ","
+                << report.persistent_arena_size << "," << reduction << ","
+                << report.allocate_tensors_time_ms << "\n";
+    }
+  }
+  return num_failures == 0 ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::Run(argc, argv); }
@@ -88,6 +88,35 @@ void BenchmarkLoggingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                    << "Warmup (avg): " << warmup_us.avg() << ", "
                    << "Inference (avg): " << inference_us.avg();
 
+  const LoadTestResults& load_test = results.load_test_results();
+  if (load_test.num_instances > 0) {
+    std::stringstream target;
+    if (load_test.target_qps > 0) {
+      target << load_test.target_qps << " qps";
+    } else {
+      target << "closed loop";
+    }
+    TFLITE_LOG(INFO) << "Load test with " << load_test.num_instances
+                     << " instances: "
+                     << "Target: " << target.str() << ", "
+                     << "Throughput: " << load_test.throughput_qps << " qps, "
+                     << "Requests: " << load_test.num_requests << " ("
+                     << load_test.num_failed_requests << " failed)";
+    TFLITE_LOG(INFO) << "Load test latency in us: "
+                     << "p50: " << load_test.latency_p50_us << ", "
+                     << "p90: " << load_test.latency_p90_us << ", "
+                     << "p99: " << load_test.latency_p99_us << ", "
+                     << "max: " << load_test.latency_max_us;
+    std::stringstream cpu_times;
+    for (size_t i = 0; i < load_test.thread_cpu_time_us.size(); ++i) {
+      cpu_times << (i > 0 ? ", " : "") << load_test.thread_cpu_time_us[i];
+    }
+    TFLITE_LOG(INFO) << "Load test CPU time of the process in us: "
+                     << load_test.process_cpu_time_us;
+    TFLITE_LOG(INFO) << "Load test CPU time per instance driving thread in us: "
+                     << cpu_times.str();
+  }
+
   if (!init_mem_usage.IsSupported()) return;
   TFLITE_LOG(INFO)
       << "Note: as the benchmark tool itself affects memory footprint, the "
@@ -336,7 +365,8 @@ TfLiteStatus BenchmarkModel::Run() {
 
   listeners_.OnBenchmarkEnd({model_size_mb, startup_latency_us, input_bytes,
                              warmup_time_us, inference_time_us, init_mem_usage,
-                             overall_mem_usage, peak_mem_mb});
+                             overall_mem_usage, peak_mem_mb,
+                             MayGetLoadTestResults()});
   return status;
 }
 
@@ -40,6 +40,36 @@ enum RunType {
   REGULAR,
 };
 
+// Results of a load test, which sends concurrent requests to several
+// interpreter instances. See the --load_test_* flags of BenchmarkTfLiteModel.
+struct LoadTestResults {
+  // Number of interpreter instances, each driven by a thread of its own. 0 if
+  // no load test was run.
+  int num_instances = 0;
+  // Requests per second the requests were sent at, or 0 if each instance sent
+  // its next request as soon as the previous one completed.
+  double target_qps = 0;
+  // Requests per second completed over the whole test.
+  double throughput_qps = 0;
+  int64_t num_requests = 0;
+  int64_t num_failed_requests = 0;
+  // Latency percentiles of the requests, in microseconds. When requests are
+  // sent at a fixed rate, the latency of a request starts at the time it was
+  // scheduled, so that it includes the time it waited for an instance.
+  int64_t latency_p50_us = 0;
+  int64_t latency_p90_us = 0;
+  int64_t latency_p99_us = 0;
+  int64_t latency_max_us = 0;
+  // CPU time used by all the threads of the process during the test,
+  // including the worker threads of the instances, in microseconds, or -1 if
+  // not available.
+  int64_t process_cpu_time_us = -1;
+  // CPU time used by the thread driving each instance, in microseconds, or -1
+  // if not available. This excludes the worker threads of the instance, if
+  // --num_threads is greater than 1.
+  std::vector<int64_t> thread_cpu_time_us;
+};
+
 class BenchmarkResults {
  public:
   BenchmarkResults() {}
@@ -49,7 +79,7 @@ class BenchmarkResults {
                    tensorflow::Stat<int64_t> inference_time_us,
                    const profiling::memory::MemoryUsage& init_mem_usage,
                    const profiling::memory::MemoryUsage& overall_mem_usage,
-                   float peak_mem_mb)
+                   float peak_mem_mb, LoadTestResults load_test_results = {})
       : model_size_mb_(model_size_mb),
         startup_latency_us_(startup_latency_us),
         input_bytes_(input_bytes),
@@ -57,7 +87,8 @@ class BenchmarkResults {
         inference_time_us_(inference_time_us),
         init_mem_usage_(init_mem_usage),
         overall_mem_usage_(overall_mem_usage),
-        peak_mem_mb_(peak_mem_mb) {}
+        peak_mem_mb_(peak_mem_mb),
+        load_test_results_(std::move(load_test_results)) {}
 
   const double model_size_mb() const { return model_size_mb_; }
   tensorflow::Stat<int64_t> inference_time_us() const {
@@ -79,6 +110,9 @@ class BenchmarkResults {
     return overall_mem_usage_;
   }
   float peak_mem_mb() const { return peak_mem_mb_; }
+  const LoadTestResults& load_test_results() const {
+    return load_test_results_;
+  }
 
  private:
   double model_size_mb_ = 0.0;
@@ -93,6 +127,7 @@ class BenchmarkResults {
   // platform.
   float peak_mem_mb_ =
       profiling::memory::MemoryUsageMonitor::kInvalidMemUsageMB;
+  LoadTestResults load_test_results_;
 };
 
 class BenchmarkListener {
@@ -215,6 +250,8 @@ class BenchmarkModel {
 
   // Get the model file size if it's available.
   virtual int64_t MayGetModelFileSize() { return -1; }
+  // Get the results of the load test run instead of the regular runs, if any.
+  virtual LoadTestResults MayGetLoadTestResults() { return {}; }
   virtual uint64_t ComputeInputBytes() = 0;
   virtual tensorflow::Stat<int64_t> Run(int min_num_times, float min_secs,
                                         float max_secs, RunType run_type,
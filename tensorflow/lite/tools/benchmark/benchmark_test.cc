@@ -473,6 +473,93 @@ TEST(BenchmarkTest, MaxDurationWorks) {
   benchmark.Run();
 }
 
+class LoadTestListener : public BenchmarkListener {
+ public:
+  void OnBenchmarkEnd(const BenchmarkResults& results) override {
+    results_ = results.load_test_results();
+  }
+
+  LoadTestResults results_;
+};
+
+TEST(BenchmarkTest, DoesntCrashWithModelMappingOptions) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<bool>("mmap_populate", true);
+  params.Set<bool>("mmap_huge_pages", true);
+  TestBenchmark benchmark(std::move(params));
+  EXPECT_EQ(benchmark.Run(), kTfLiteOk);
+}
+
+TEST(BenchmarkTest, DoesntCrashWithModelPrefault) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<int32_t>("mmap_prefault_threads", 2);
+  TestBenchmark benchmark(std::move(params));
+  EXPECT_EQ(benchmark.Run(), kTfLiteOk);
+}
+
+TEST(BenchmarkTest, FailsWithNegativePrefaultThreads) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<int32_t>("mmap_prefault_threads", -1);
+  TestBenchmark benchmark(std::move(params));
+  EXPECT_EQ(benchmark.Run(), kTfLiteError);
+}
+
+TEST(BenchmarkTest, LoadTestWithClosedLoop) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<int32_t>("load_test_num_instances", 2);
+  TestBenchmark benchmark(std::move(params));
+  LoadTestListener listener;
+  benchmark.AddListener(&listener);
+
+  EXPECT_EQ(benchmark.Run(), kTfLiteOk);
+
+  const LoadTestResults& results = listener.results_;
+  EXPECT_EQ(results.num_instances, 2);
+  EXPECT_EQ(results.target_qps, 0);
+  EXPECT_GE(results.num_requests, 2);
+  EXPECT_EQ(results.num_failed_requests, 0);
+  EXPECT_GT(results.throughput_qps, 0);
+  EXPECT_GT(results.latency_p50_us, 0);
+  EXPECT_LE(results.latency_p50_us, results.latency_p90_us);
+  EXPECT_LE(results.latency_p90_us, results.latency_p99_us);
+  EXPECT_LE(results.latency_p99_us, results.latency_max_us);
+  EXPECT_EQ(results.thread_cpu_time_us.size(), 2);
+}
+
+TEST(BenchmarkTest, LoadTestWithTargetQps) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<int32_t>("load_test_num_instances", 2);
+  params.Set<float>("load_test_qps", 20.0f);
+  params.Set<bool>("load_test_share_weights", false);
+  TestBenchmark benchmark(std::move(params));
+  LoadTestListener listener;
+  benchmark.AddListener(&listener);
+
+  EXPECT_EQ(benchmark.Run(), kTfLiteOk);
+
+  // The requests scheduled during --min_secs=1.
+  EXPECT_EQ(listener.results_.num_requests, 20);
+  EXPECT_EQ(listener.results_.target_qps, 20.0f);
+  EXPECT_EQ(listener.results_.num_failed_requests, 0);
+}
+
+TEST(BenchmarkTest, LoadTestFailsWithAlternateInputShapes) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  TestBenchmark benchmark(CreateFp32Params());
+  ScopedCommandlineArgs scoped_argv(
+      {"--load_test_num_instances=2", "--input_layer=input",
+       "--input_layer_shape=1,224,224,3",
+       "--alternate_input_layer_shape=2,224,224,3"});
+
+  EXPECT_EQ(benchmark.Run(scoped_argv.argc(), scoped_argv.argv()),
+            kTfLiteError);
+}
+
 TEST(BenchmarkTest, ParametersArePopulatedWhenInputShapeIsNotSpecified) {
   ASSERT_THAT(g_fp32_model_path, testing::NotNull());
 
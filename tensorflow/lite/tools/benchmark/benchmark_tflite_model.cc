@@ -15,9 +15,13 @@ limitations under the License.
 
 #include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdlib>
+#include <ctime>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -25,16 +29,22 @@ limitations under the License.
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
 #include "absl/base/attributes.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "ruy/profiler/profiler.h"  // from @ruy
+#include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/core/kernels/register.h"
@@ -42,10 +52,14 @@ limitations under the License.
 #include "tensorflow/lite/core/model_builder.h"
 #include "tensorflow/lite/core/subgraph.h"
 #include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_pool.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/optional_debug_tools.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/profiling/timeline_profiler.h"
+#include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
@@ -158,6 +172,37 @@ class OutputSaver : public BenchmarkListener {
   const BenchmarkParams* params_ = nullptr;
 };
 
+// Records when and on which thread each op runs, and writes the timeline in
+// the Chrome trace event format when the benchmark ends.
+class OpTimelineListener : public BenchmarkListener {
+ public:
+  OpTimelineListener(Interpreter* interpreter, const std::string& output_file)
+      : output_file_(output_file) {
+    interpreter->AddProfiler(&profiler_);
+  }
+
+  void OnBenchmarkStart(const BenchmarkParams& params) override {
+    profiler_.Reset();
+  }
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override {
+    std::ofstream ofs(output_file_, std::ofstream::out);
+    if (!ofs.good() || !(ofs << profiler_.ToChromeTrace())) {
+      TFLITE_LOG(ERROR) << "Failed to write the op timeline to "
+                        << output_file_;
+      return;
+    }
+    TFLITE_LOG(INFO) << "Wrote the op timeline to " << output_file_
+                     << ", with up to "
+                     << profiler_.GetMaxConcurrentOperators()
+                     << " ops running concurrently.";
+  }
+
+ private:
+  const std::string output_file_;
+  profiling::TimelineProfiler profiler_;
+};
+
 std::vector<std::string> Split(const std::string& str, const char delim) {
   if (str.empty()) {
     return {};
@@ -312,8 +357,134 @@ CreateProfileSummaryFormatter(bool format_as_csv) {
              : std::make_shared<profiling::ProfileSummaryDefaultFormatter>();
 }
 
+// Returns true if --use_xnnpack is explicitly set to false.
+bool IsXnnpackExplicitlyDisabled(const BenchmarkParams& params) {
+  return params.HasParam("use_xnnpack") &&
+         params.HasValueSet<bool>("use_xnnpack") &&
+         !params.Get<bool>("use_xnnpack");
+}
+
+// Forwards to an op resolver without its default delegates, which the
+// interpreter pool replaces with XNNPACK delegates sharing a weights cache.
+class OpResolverWithoutDelegates : public OpResolver {
+ public:
+  explicit OpResolverWithoutDelegates(std::unique_ptr<OpResolver> op_resolver)
+      : op_resolver_(std::move(op_resolver)) {}
+
+  const TfLiteRegistration* FindOp(tflite::BuiltinOperator op,
+                                   int version) const override {
+    return op_resolver_->FindOp(op, version);
+  }
+  const TfLiteRegistration* FindOp(const char* op,
+                                   int version) const override {
+    return op_resolver_->FindOp(op, version);
+  }
+
+ private:
+  std::unique_ptr<OpResolver> op_resolver_;
+};
+
+// Returns the CPU time used by the calling thread in microseconds, or -1 if
+// it isn't available.
+int64_t GetThreadCpuTimeMicros() {
+#if defined(_WIN32)
+  return -1;
+#else
+  timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) return -1;
+  return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+// Returns the user and system CPU time used by all the threads of the process
+// in microseconds, or -1 if it isn't available.
+int64_t GetProcessCpuTimeMicros() {
+#if defined(_WIN32)
+  return -1;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+  auto to_micros = [](const timeval& time) {
+    return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_usec;
+  };
+  return to_micros(usage.ru_utime) + to_micros(usage.ru_stime);
+#endif
+}
+
+// Returns the `percentile` of `sorted_values` by the nearest-rank method.
+int64_t GetPercentile(const std::vector<int64_t>& sorted_values,
+                      double percentile) {
+  if (sorted_values.empty()) return 0;
+  const int64_t rank = static_cast<int64_t>(
+      std::ceil(percentile / 100 * sorted_values.size()));
+  return sorted_values[std::clamp<int64_t>(rank - 1, 0,
+                                           sorted_values.size() - 1)];
+}
+
 }  // namespace
 
+// The interpreter instances of a load test, each leased from an
+// InterpreterPool. When they share weights, they come from a single pool, so
+// that they share the weights packed by XNNPACK and the memory plan.
+// Otherwise each comes from a pool of its own and packs its own weights, as
+// if the model was served by separate processes.
+class BenchmarkTfLiteModel::LoadTestInstances {
+ public:
+  static std::unique_ptr<LoadTestInstances> Create(
+      const FlatBufferModel& model, std::unique_ptr<OpResolver> op_resolver,
+      const InterpreterPool::Options& options, int num_instances,
+      bool share_weights);
+
+  const std::vector<Interpreter*>& interpreters() const {
+    return interpreters_;
+  }
+
+ private:
+  explicit LoadTestInstances(std::unique_ptr<OpResolver> op_resolver)
+      : op_resolver_(std::move(op_resolver)) {}
+
+  OpResolverWithoutDelegates op_resolver_;
+#ifndef TFLITE_WITHOUT_XNNPACK
+  std::vector<std::unique_ptr<InterpreterPool>> pools_;
+  // Declared after `pools_` to be returned before the pools are destroyed.
+  std::vector<InterpreterPool::Lease> leases_;
+#endif  // !defined(TFLITE_WITHOUT_XNNPACK)
+  std::vector<Interpreter*> interpreters_;
+};
+
+std::unique_ptr<BenchmarkTfLiteModel::LoadTestInstances>
+BenchmarkTfLiteModel::LoadTestInstances::Create(
+    const FlatBufferModel& model, std::unique_ptr<OpResolver> op_resolver,
+    const InterpreterPool::Options& options, int num_instances,
+    bool share_weights) {
+#ifdef TFLITE_WITHOUT_XNNPACK
+  TFLITE_LOG(ERROR) << "The load test needs the interpreter pool, which isn't "
+                       "built without XNNPACK.";
+  return nullptr;
+#else   // !defined(TFLITE_WITHOUT_XNNPACK)
+  std::unique_ptr<LoadTestInstances> instances(
+      new LoadTestInstances(std::move(op_resolver)));
+  InterpreterPool::Options pool_options = options;
+  pool_options.max_size = share_weights ? num_instances : 1;
+  pool_options.initial_size = pool_options.max_size;
+  const int num_pools = share_weights ? 1 : num_instances;
+  for (int i = 0; i < num_pools; ++i) {
+    std::unique_ptr<InterpreterPool> pool =
+        InterpreterPool::Create(model, instances->op_resolver_, pool_options);
+    if (pool == nullptr) return nullptr;
+    instances->pools_.push_back(std::move(pool));
+  }
+  for (int i = 0; i < num_instances; ++i) {
+    InterpreterPool::Lease lease =
+        instances->pools_[share_weights ? 0 : i]->Acquire();
+    if (lease == nullptr) return nullptr;
+    instances->interpreters_.push_back(lease.get());
+    instances->leases_.push_back(std::move(lease));
+  }
+  return instances;
+#endif  // TFLITE_WITHOUT_XNNPACK
+}
+
 TfLiteStatus SplitInputLayerNameAndValueFile(
     const std::string& name_and_value_file,
     std::pair<std::string, std::string>& name_file_pair) {
@@ -358,6 +529,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("input_layer_value_files",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("alternate_input_layer_shape",
+                          BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("allow_fp16", BenchmarkParam::Create<bool>(false));
   default_params.AddParam("require_full_delegation",
                           BenchmarkParam::Create<bool>(false));
@@ -370,6 +543,12 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("enable_roofline_report",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("roofline_output_json_file",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("enable_op_hardware_counters",
+                          BenchmarkParam::Create<bool>(false));
 
   default_params.AddParam("print_preinvoke_state",
                           BenchmarkParam::Create<bool>(false));
@@ -381,8 +560,34 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<int32_t>(0));
   default_params.AddParam("disable_delegate_clustering",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("memory_plan_cache_file",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("use_inter_op_parallelism",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("use_x86_int8_kernels",
+                          BenchmarkParam::Create<bool>(true));
+  default_params.AddParam("op_timeline_output_file",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("memory_plan_cache_size",
+                          BenchmarkParam::Create<int32_t>(0));
+  default_params.AddParam("incremental_preparation",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("fuse_activations",
+                          BenchmarkParam::Create<bool>(false));
   default_params.AddParam("output_filepath",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("load_test_num_instances",
+                          BenchmarkParam::Create<int32_t>(0));
+  default_params.AddParam("load_test_qps", BenchmarkParam::Create<float>(0.0f));
+  default_params.AddParam("load_test_share_weights",
+                          BenchmarkParam::Create<bool>(true));
+  default_params.AddParam("mmap_populate", BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("mmap_huge_pages",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("mmap_prefault_threads",
+                          BenchmarkParam::Create<int32_t>(0));
+  default_params.AddParam("model_numa_node",
+                          BenchmarkParam::Create<int32_t>(-1));
 
   default_params.AddParam("tensor_name_display_length",
                           BenchmarkParam::Create<int32_t>(25));
@@ -406,6 +611,7 @@ BenchmarkTfLiteModel::BenchmarkTfLiteModel(BenchmarkParams params)
 void BenchmarkTfLiteModel::CleanUp() {
   // Free up any pre-allocated tensor data during PrepareInputData.
   inputs_data_.clear();
+  alternate_inputs_data_.clear();
 }
 
 BenchmarkTfLiteModel::~BenchmarkTfLiteModel() {
@@ -414,6 +620,7 @@ BenchmarkTfLiteModel::~BenchmarkTfLiteModel() {
   // Destory the owned interpreter earlier than other objects (specially
   // 'owned_delegates_').
   interpreter_.reset();
+  load_test_instances_.reset();
 }
 
 std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
@@ -452,6 +659,17 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
           "prints to stdout."),
+      CreateFlag<bool>(
+          "enable_roofline_report", &params_,
+          "With op profiling, also report how close each op runs to the "
+          "roofline of the machine, measured when the benchmark starts."),
+      CreateFlag<std::string>(
+          "roofline_output_json_file", &params_,
+          "File path to also export the roofline report as JSON."),
+      CreateFlag<bool>(
+          "enable_op_hardware_counters", &params_,
+          "With op profiling, also report the cycles, instructions and last "
+          "level cache misses of each op, read with Linux perf events."),
       CreateFlag<bool>(
           "print_preinvoke_state", &params_,
           "print out the interpreter internals just before calling Invoke. The "
@@ -469,9 +687,78 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "Optimize memory usage for large tensors with sacrificing latency."),
       CreateFlag<bool>("disable_delegate_clustering", &params_,
                        "Disable delegate clustering."),
+      CreateFlag<std::string>(
+          "memory_plan_cache_file", &params_,
+          "File caching the memory plan of the interpreter. If it exists and "
+          "matches the model, delegates and input shapes, tensors are placed "
+          "at the arena offsets recorded in it instead of choosing them; "
+          "otherwise the offsets chosen at startup are written to it."),
+      CreateFlag<bool>(
+          "use_inter_op_parallelism", &params_,
+          "Run ops which don't depend on each other concurrently, using up "
+          "to --num_threads threads."),
+      CreateFlag<bool>(
+          "use_x86_int8_kernels", &params_,
+          "Let int8 matrix multiplications use the AVX-512 VNNI and AMX "
+          "kernels on the x86 CPUs supporting them. Disable to compare with "
+          "ruy."),
+      CreateFlag<std::string>(
+          "op_timeline_output_file", &params_,
+          "File path to export the timeline of the ops of all runs to, in "
+          "the Chrome trace event format (see chrome://tracing)."),
+      CreateFlag<std::string>(
+          "alternate_input_layer_shape", &params_,
+          "Second set of input shapes, in the format of --input_layer_shape. "
+          "When set, the runs alternate between both sets of shapes, and the "
+          "time of each run includes resizing the inputs and "
+          "AllocateTensors()."),
+      CreateFlag<int32_t>(
+          "memory_plan_cache_size", &params_,
+          "Number of memory plans kept by the interpreter for different input "
+          "shapes. See --alternate_input_layer_shape."),
+      CreateFlag<bool>("incremental_preparation", &params_,
+                       "Only prepare again the ops whose input shapes changed "
+                       "when resizing inputs. See "
+                       "--alternate_input_layer_shape."),
+      CreateFlag<bool>("fuse_activations", &params_,
+                       "Fuse the RELU, RELU6 and RELU_N1_TO_1 ops into the "
+                       "ops producing their input when loading the model."),
       CreateFlag<std::string>(
           "output_filepath", &params_,
           "File path to export outputs layer as binary data."),
+      CreateFlag<int32_t>(
+          "load_test_num_instances", &params_,
+          "If positive, replaces the regular runs with a load test sending "
+          "concurrent requests to this number of interpreter instances, each "
+          "driven by a thread of its own. The instances use XNNPACK unless "
+          "--use_xnnpack=false, and no other delegate. The warmup runs and "
+          "the listeners, e.g. the op profiling, still use the primary "
+          "interpreter."),
+      CreateFlag<float>(
+          "load_test_qps", &params_,
+          "If positive, the load test sends requests at this rate, and each "
+          "request waits for the first free instance (open loop). Otherwise "
+          "each instance sends its next request as soon as the previous one "
+          "completes (closed loop)."),
+      CreateFlag<bool>(
+          "load_test_share_weights", &params_,
+          "Whether the instances of the load test share the weights packed "
+          "by XNNPACK and the memory plan, rather than each packing its own "
+          "copy of the weights."),
+      CreateFlag<bool>("mmap_populate", &params_,
+                       "Read the whole model in when mapping it, so that the "
+                       "first inference doesn't page fault on the weights."),
+      CreateFlag<bool>("mmap_huge_pages", &params_,
+                       "Back the model with transparent huge pages."),
+      CreateFlag<int32_t>(
+          "mmap_prefault_threads", &params_,
+          "If positive, read the mapped model in with this number of "
+          "background threads while the interpreter is created."),
+      CreateFlag<int32_t>(
+          "model_numa_node", &params_,
+          "If non-negative, run the benchmark on a copy of the model in "
+          "memory bound to this NUMA node. Pin the benchmark to the CPUs of "
+          "the node, e.g. with taskset, to read the weights locally."),
       CreateFlag<int32_t>(
           "tensor_name_display_length", &params_,
           "The number of characters to show for the tensor's name when "
@@ -518,6 +805,12 @@ void BenchmarkTfLiteModel::LogParams() {
                       verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_roofline_report", "Enable roofline report",
+                      verbose);
+  LOG_BENCHMARK_PARAM(std::string, "roofline_output_json_file",
+                      "JSON File to export the roofline report to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_op_hardware_counters",
+                      "Enable op hardware counters", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_preinvoke_state",
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
@@ -528,8 +821,36 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Optimize memory usage for large tensors", verbose);
   LOG_BENCHMARK_PARAM(bool, "disable_delegate_clustering",
                       "Disable delegate clustering", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "memory_plan_cache_file",
+                      "Memory plan cache file", verbose);
+  LOG_BENCHMARK_PARAM(bool, "use_inter_op_parallelism",
+                      "Use inter-op parallelism", verbose);
+  LOG_BENCHMARK_PARAM(bool, "use_x86_int8_kernels", "Use x86 int8 kernels",
+                      verbose);
+  LOG_BENCHMARK_PARAM(std::string, "op_timeline_output_file",
+                      "File path to export the op timeline to", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "alternate_input_layer_shape",
+                      "Alternate input shapes", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "memory_plan_cache_size",
+                      "Memory plan cache size", verbose);
+  LOG_BENCHMARK_PARAM(bool, "incremental_preparation",
+                      "Use incremental preparation", verbose);
+  LOG_BENCHMARK_PARAM(bool, "fuse_activations", "Fuse activations", verbose);
   LOG_BENCHMARK_PARAM(std::string, "output_filepath",
                       "File path to export outputs layer to", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "load_test_num_instances",
+                      "Load test instances", verbose);
+  LOG_BENCHMARK_PARAM(float, "load_test_qps", "Load test requests per second",
+                      verbose);
+  LOG_BENCHMARK_PARAM(bool, "load_test_share_weights",
+                      "Load test instances share weights", verbose);
+  LOG_BENCHMARK_PARAM(bool, "mmap_populate", "Populate the model mapping",
+                      verbose);
+  LOG_BENCHMARK_PARAM(bool, "mmap_huge_pages", "Use huge pages for the model",
+                      verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "mmap_prefault_threads",
+                      "Model prefault threads", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "model_numa_node", "Model NUMA node", verbose);
   LOG_BENCHMARK_PARAM(int32_t, "tensor_name_display_length",
                       "Tensor name display length", verbose);
   LOG_BENCHMARK_PARAM(int32_t, "tensor_type_display_length",
@@ -552,11 +873,63 @@ TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
     return kTfLiteError;
   }
 
-  return PopulateInputLayerInfo(
+  TF_LITE_ENSURE_STATUS(PopulateInputLayerInfo(
       params_.Get<std::string>("input_layer"),
       params_.Get<std::string>("input_layer_shape"),
       params_.Get<std::string>("input_layer_value_range"),
-      params_.Get<std::string>("input_layer_value_files"), &inputs_);
+      params_.Get<std::string>("input_layer_value_files"), &inputs_));
+
+  if (params_.Get<int32_t>("mmap_prefault_threads") < 0) {
+    TFLITE_LOG(ERROR) << "--mmap_prefault_threads should be non-negative.";
+    return kTfLiteError;
+  }
+  if (params_.Get<int32_t>("model_numa_node") >= 0 &&
+      !NumaReplicaAllocation::IsSupported()) {
+    TFLITE_LOG(ERROR) << "--model_numa_node isn't supported on this platform.";
+    return kTfLiteError;
+  }
+
+  if (params_.Get<bool>("enable_roofline_report") &&
+      !params_.Get<bool>("enable_op_profiling")) {
+    TFLITE_LOG(ERROR)
+        << "--enable_roofline_report requires --enable_op_profiling.";
+    return kTfLiteError;
+  }
+  if (params_.Get<bool>("enable_op_hardware_counters") &&
+      !params_.Get<bool>("enable_op_profiling")) {
+    TFLITE_LOG(ERROR)
+        << "--enable_op_hardware_counters requires --enable_op_profiling.";
+    return kTfLiteError;
+  }
+
+  const int32_t load_test_num_instances =
+      params_.Get<int32_t>("load_test_num_instances");
+  if (load_test_num_instances < 0) {
+    TFLITE_LOG(ERROR) << "--load_test_num_instances should be non-negative.";
+    return kTfLiteError;
+  }
+  if (load_test_num_instances > 0 &&
+      !params_.Get<std::string>("alternate_input_layer_shape").empty()) {
+    TFLITE_LOG(ERROR) << "--load_test_num_instances can't be used with "
+                      << "--alternate_input_layer_shape.";
+    return kTfLiteError;
+  }
+
+  alternate_inputs_.clear();
+  if (params_.Get<std::string>("alternate_input_layer_shape").empty()) {
+    return kTfLiteOk;
+  }
+  if (inputs_.empty()) {
+    TFLITE_LOG(ERROR) << "--alternate_input_layer_shape requires "
+                      << "--input_layer and --input_layer_shape.";
+    return kTfLiteError;
+  }
+  // Input files hold values for the shapes of --input_layer_shape only.
+  return PopulateInputLayerInfo(
+      params_.Get<std::string>("input_layer"),
+      params_.Get<std::string>("alternate_input_layer_shape"),
+      params_.Get<std::string>("input_layer_value_range"),
+      /*value_files_string=*/"", &alternate_inputs_);
 }
 
 uint64_t BenchmarkTfLiteModel::ComputeInputBytes() {
@@ -589,6 +962,10 @@ int64_t BenchmarkTfLiteModel::MayGetModelFileSize() {
   return in_file.tellg();
 }
 
+LoadTestResults BenchmarkTfLiteModel::MayGetLoadTestResults() {
+  return load_test_results_;
+}
+
 InputTensorData BenchmarkTfLiteModel::LoadInputTensorData(
     const TfLiteTensor& t, const std::string& input_file_path) {
   std::ifstream value_file(input_file_path, std::ios::binary);
@@ -688,11 +1065,20 @@ TfLiteStatus BenchmarkTfLiteModel::PrepareInputData() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
-  auto interpreter_inputs = interpreter_->inputs();
+  // With alternating input shapes, RunImpl() sets the non-string inputs once
+  // they are resized.
+  SetInputs(interpreter_.get(),
+            /*set_non_string_inputs=*/alternate_inputs_.empty());
+  return kTfLiteOk;
+}
+
+void BenchmarkTfLiteModel::SetInputs(Interpreter* interpreter,
+                                     bool set_non_string_inputs) {
+  auto interpreter_inputs = interpreter->inputs();
   // Set the values of the input tensors from inputs_data_.
   for (int j = 0; j < interpreter_inputs.size(); ++j) {
     int i = interpreter_inputs[j];
-    TfLiteTensor* t = interpreter_->tensor(i);
+    TfLiteTensor* t = interpreter->tensor(i);
     if (t->type == kTfLiteString) {
       if (inputs_data_[j].data) {
         static_cast<DynamicBuffer*>(inputs_data_[j].data.get())
@@ -705,19 +1091,20 @@ TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
         });
         buffer.WriteToTensor(t, /*new_shape=*/nullptr);
       }
-    } else {
+    } else if (set_non_string_inputs) {
       std::memcpy(t->data.raw, inputs_data_[j].data.get(),
                   inputs_data_[j].bytes);
     }
   }
-
-  return kTfLiteOk;
 }
 
 TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
   auto resolver = GetOpResolver();
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
   const bool use_caching = params_.Get<bool>("use_caching");
+  const bool use_inter_op_parallelism =
+      params_.Get<bool>("use_inter_op_parallelism");
+  const bool use_x86_int8_kernels = params_.Get<bool>("use_x86_int8_kernels");
 
   InterpreterOptions options;
   options.SetEnsureDynamicTensorsAreReleased(
@@ -726,6 +1113,12 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
       params_.Get<int32_t>("optimize_memory_for_large_tensors"));
   options.SetDisableDelegateClustering(
       params_.Get<bool>("disable_delegate_clustering"));
+  options.SetInterOpParallelism(use_inter_op_parallelism);
+  options.SetMemoryPlanCacheSize(
+      params_.Get<int32_t>("memory_plan_cache_size"));
+  options.SetIncrementalPreparation(
+      params_.Get<bool>("incremental_preparation"));
+  options.SetFuseActivations(params_.Get<bool>("fuse_activations"));
 
   tflite::InterpreterBuilder builder(*model_, *resolver, &options);
   if (builder.SetNumThreads(num_threads) != kTfLiteOk) {
@@ -738,13 +1131,16 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
     TFLITE_LOG(ERROR) << "Failed to initialize the interpreter";
     return kTfLiteError;
   }
-  // Manually enable caching behavior in TF Lite interpreter.
-  if (use_caching) {
+  // Manually enable caching behavior in TF Lite interpreter. Inter-op
+  // parallelism also needs the CPU backend context to exist from the first
+  // run, rather than being created by the first kernel using it.
+  if (use_caching || use_inter_op_parallelism || !use_x86_int8_kernels) {
     external_context_ = std::make_unique<tflite::ExternalCpuBackendContext>();
     std::unique_ptr<tflite::CpuBackendContext> cpu_backend_context(
         new tflite::CpuBackendContext());
-    cpu_backend_context->SetUseCaching(true);
+    cpu_backend_context->SetUseCaching(use_caching);
     cpu_backend_context->SetMaxNumThreads(num_threads);
+    cpu_backend_context->SetUseX86Int8Kernels(use_x86_int8_kernels);
     external_context_->set_internal_backend_context(
         std::move(cpu_backend_context));
     interpreter_->SetExternalContext(kTfLiteCpuBackendContext,
@@ -775,6 +1171,13 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   }
 
   AddOwnedListener(MayCreateProfilingListener());
+  // Added after the profiling listener, which replaces the profilers.
+  const std::string op_timeline_output_file =
+      params_.Get<std::string>("op_timeline_output_file");
+  if (!op_timeline_output_file.empty()) {
+    AddOwnedListener(std::unique_ptr<BenchmarkListener>(
+        new OpTimelineListener(interpreter_.get(), op_timeline_output_file)));
+  }
   AddOwnedListener(std::unique_ptr<BenchmarkListener>(
       new InterpreterStatePrinter(interpreter_.get())));
 
@@ -897,22 +1300,98 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
     }
   }
 
+  const std::string memory_plan_cache_file =
+      params_.Get<std::string>("memory_plan_cache_file");
+  if (!memory_plan_cache_file.empty()) {
+    std::ifstream cache(memory_plan_cache_file, std::ios::binary);
+    if (cache) {
+      std::stringstream plan;
+      plan << cache.rdbuf();
+      if (interpreter_->RestoreMemoryPlan(plan.str()) != kTfLiteOk) {
+        TFLITE_LOG(WARN) << "Ignoring the memory plan in "
+                         << memory_plan_cache_file
+                         << ", which doesn't match the model.";
+      }
+    }
+  }
+
   if (interpreter_->AllocateTensors() != kTfLiteOk) {
     TFLITE_LOG(ERROR) << "Failed to allocate tensors!";
     return kTfLiteError;
   }
 
+  if (!memory_plan_cache_file.empty()) {
+    if (interpreter_->primary_subgraph().HasRestoredMemoryPlan()) {
+      TFLITE_LOG(INFO) << "Allocated tensors from the memory plan in "
+                       << memory_plan_cache_file << ".";
+    } else {
+      std::string plan;
+      std::ofstream cache(memory_plan_cache_file,
+                          std::ios::binary | std::ios::trunc);
+      if (interpreter_->SerializeMemoryPlan(&plan) == kTfLiteOk &&
+          cache.write(plan.data(), plan.size())) {
+        TFLITE_LOG(INFO) << "Saved the memory plan to "
+                         << memory_plan_cache_file << ".";
+      } else {
+        TFLITE_LOG(WARN) << "Failed to save the memory plan to "
+                         << memory_plan_cache_file << ".";
+      }
+    }
+  }
+
   AddOwnedListener(
       std::unique_ptr<BenchmarkListener>(new RuyProfileListener()));
   AddOwnedListener(
       std::unique_ptr<BenchmarkListener>(new OutputSaver(interpreter_.get())));
 
+  if (params_.Get<int32_t>("load_test_num_instances") > 0) {
+    TF_LITE_ENSURE_STATUS(InitLoadTest());
+  }
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkTfLiteModel::InitLoadTest() {
+  const int32_t num_instances = params_.Get<int32_t>("load_test_num_instances");
+  const bool share_weights = params_.Get<bool>("load_test_share_weights");
+
+  InterpreterPool::Options options;
+  options.num_threads = params_.Get<int32_t>("num_threads");
+  options.use_xnnpack = !IsXnnpackExplicitlyDisabled(params_);
+  // The instances take the input shapes of the primary interpreter, except
+  // for string inputs whose shapes come from their values.
+  for (int input : interpreter_->inputs()) {
+    const TfLiteTensor* t = interpreter_->tensor(input);
+    if (t->type == kTfLiteString) {
+      options.input_shapes.emplace_back();
+    } else {
+      options.input_shapes.emplace_back(t->dims->data,
+                                        t->dims->data + t->dims->size);
+    }
+  }
+
+  load_test_instances_ = LoadTestInstances::Create(
+      *model_, GetOpResolver(), options, num_instances, share_weights);
+  if (load_test_instances_ == nullptr) {
+    TFLITE_LOG(ERROR) << "Failed to create the interpreter instances of the "
+                         "load test.";
+    return kTfLiteError;
+  }
+  TFLITE_LOG(INFO) << "Created " << num_instances
+                   << " interpreter instances for the load test"
+                   << (share_weights ? ", sharing their weights." : ".");
   return kTfLiteOk;
 }
 
 TfLiteStatus BenchmarkTfLiteModel::LoadModel() {
   std::string fd_or_graph_path = params_.Get<std::string>("graph");
-  model_loader_ = tools::CreateModelLoaderFromPath(fd_or_graph_path);
+  MMAPAllocation::Options mmap_options;
+  mmap_options.populate = params_.Get<bool>("mmap_populate");
+  mmap_options.use_huge_pages = params_.Get<bool>("mmap_huge_pages");
+  mmap_options.num_prefault_threads =
+      params_.Get<int32_t>("mmap_prefault_threads");
+  model_loader_ =
+      tools::CreateModelLoaderFromPath(fd_or_graph_path, mmap_options);
   if (!model_loader_) {
     TFLITE_LOG(ERROR) << "Failed to initialize model loader with path "
                       << fd_or_graph_path;
@@ -922,10 +1401,23 @@ TfLiteStatus BenchmarkTfLiteModel::LoadModel() {
     TFLITE_LOG(ERROR) << "Failed to load model " << fd_or_graph_path;
     return kTfLiteError;
   }
-  model_ = tflite::FlatBufferModel::BuildFromBuffer(
-      reinterpret_cast<const char*>(
-          model_loader_->GetModel()->allocation()->base()),
-      model_loader_->GetModel()->allocation()->bytes());
+  const int32_t numa_node = params_.Get<int32_t>("model_numa_node");
+  if (numa_node >= 0) {
+    auto replica = std::make_unique<NumaReplicaAllocation>(
+        *model_loader_->GetModel()->allocation(), numa_node,
+        mmap_options.use_huge_pages, DefaultErrorReporter());
+    if (!replica->valid()) {
+      TFLITE_LOG(ERROR) << "Failed to copy the model to NUMA node "
+                        << numa_node;
+      return kTfLiteError;
+    }
+    model_ = tflite::FlatBufferModel::BuildFromAllocation(std::move(replica));
+  } else {
+    model_ = tflite::FlatBufferModel::BuildFromBuffer(
+        reinterpret_cast<const char*>(
+            model_loader_->GetModel()->allocation()->base()),
+        model_loader_->GetModel()->allocation()->bytes());
+  }
   TFLITE_LOG(INFO) << "Loaded model " << fd_or_graph_path;
   return kTfLiteOk;
 }
@@ -936,9 +1428,7 @@ std::unique_ptr<tflite::OpResolver> BenchmarkTfLiteModel::GetOpResolver()
   // When --use_xnnpack is explicitly set to false, skip applying the default
   // XNNPACK delegate in TfLite runtime so that the original execution path
   // based on the unmodified model graph is still excercised.
-  if (params_.HasParam("use_xnnpack") &&
-      params_.HasValueSet<bool>("use_xnnpack") &&
-      !params_.Get<bool>("use_xnnpack")) {
+  if (IsXnnpackExplicitlyDisabled(params_)) {
     resolver =
         new tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates();
   } else {
@@ -952,15 +1442,181 @@ std::unique_ptr<BenchmarkListener>
 BenchmarkTfLiteModel::MayCreateProfilingListener() const {
   if (!params_.Get<bool>("enable_op_profiling")) return nullptr;
 
-  return std::unique_ptr<BenchmarkListener>(new ProfilingListener(
+  auto listener = std::make_unique<ProfilingListener>(
       interpreter_.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
       params_.Get<bool>("allow_dynamic_profiling_buffer_increase"),
       params_.Get<std::string>("profiling_output_csv_file"),
       CreateProfileSummaryFormatter(
-          !params_.Get<std::string>("profiling_output_csv_file").empty())));
+          !params_.Get<std::string>("profiling_output_csv_file").empty()),
+      params_.Get<bool>("enable_op_hardware_counters"));
+  if (params_.Get<bool>("enable_op_hardware_counters") &&
+      params_.Get<int32_t>("num_threads") != 1) {
+    TFLITE_LOG(WARN) << "Hardware counters only count the thread invoking the "
+                        "model. Use --num_threads=1 for complete counters.";
+  }
+  if (params_.Get<bool>("enable_roofline_report")) {
+    listener->EnableRooflineReport(
+        params_.Get<int32_t>("num_threads"),
+        params_.Get<std::string>("roofline_output_json_file"));
+  }
+  return listener;
 }
 
-TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
+TfLiteStatus BenchmarkTfLiteModel::ResizeInputsForNextRun() {
+  use_alternate_inputs_ = !use_alternate_inputs_;
+  const std::vector<InputLayerInfo>& inputs =
+      use_alternate_inputs_ ? alternate_inputs_ : inputs_;
+  std::vector<utils::InputTensorData>& inputs_data =
+      use_alternate_inputs_ ? alternate_inputs_data_ : inputs_data_;
+  auto interpreter_inputs = interpreter_->inputs();
+  for (int j = 0; j < inputs.size(); ++j) {
+    if (interpreter_->tensor(interpreter_inputs[j])->type == kTfLiteString) {
+      continue;
+    }
+    TF_LITE_ENSURE_STATUS(interpreter_->ResizeInputTensor(
+        interpreter_inputs[j], inputs[j].shape));
+  }
+  TF_LITE_ENSURE_STATUS(interpreter_->AllocateTensors());
+
+  // The values for the alternate shapes are made on their first run.
+  for (int j = inputs_data.size(); j < inputs.size(); ++j) {
+    inputs_data.push_back(CreateRandomTensorData(
+        *interpreter_->tensor(interpreter_inputs[j]), &inputs[j]));
+  }
+  for (int j = 0; j < inputs.size(); ++j) {
+    TfLiteTensor* t = interpreter_->tensor(interpreter_inputs[j]);
+    if (t->type == kTfLiteString) continue;
+    std::memcpy(t->data.raw, inputs_data[j].data.get(), inputs_data[j].bytes);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkTfLiteModel::RunImpl() {
+  if (!alternate_inputs_.empty()) {
+    TF_LITE_ENSURE_STATUS(ResizeInputsForNextRun());
+  }
+  return interpreter_->Invoke();
+}
+
+tensorflow::Stat<int64_t> BenchmarkTfLiteModel::Run(
+    int min_num_times, float min_secs, float max_secs, RunType run_type,
+    TfLiteStatus* invoke_status) {
+  if (run_type == REGULAR && load_test_instances_ != nullptr) {
+    return RunLoadTest(min_num_times, min_secs, max_secs, invoke_status);
+  }
+  return BenchmarkModel::Run(min_num_times, min_secs, max_secs, run_type,
+                             invoke_status);
+}
+
+tensorflow::Stat<int64_t> BenchmarkTfLiteModel::RunLoadTest(
+    int min_num_requests, float min_secs, float max_secs,
+    TfLiteStatus* invoke_status) {
+  const std::vector<Interpreter*>& instances =
+      load_test_instances_->interpreters();
+  const int num_instances = instances.size();
+  const float qps = std::max(params_.Get<float>("load_test_qps"), 0.0f);
+  TFLITE_LOG(INFO) << "Running load test on " << num_instances
+                   << " instances for at least " << min_num_requests
+                   << " requests and at least " << min_secs << " seconds but"
+                   << " terminate if exceeding " << max_secs << " seconds.";
+
+  *invoke_status = kTfLiteOk;
+  // Not timed, e.g. for XNNPACK to set up its operators.
+  for (Interpreter* instance : instances) {
+    SetInputs(instance, /*set_non_string_inputs=*/true);
+    if (instance->Invoke() != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to invoke an instance of the load test.";
+      *invoke_status = kTfLiteError;
+      return {};
+    }
+  }
+
+  struct InstanceStats {
+    std::vector<int64_t> latencies_us;
+    int64_t num_failed_requests = 0;
+    int64_t cpu_time_us = -1;
+  };
+  std::vector<InstanceStats> instance_stats(num_instances);
+  // Index of the next request, taken by the first free instance.
+  std::atomic<int64_t> next_request(0);
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t start_process_cpu_time_us = GetProcessCpuTimeMicros();
+  const int64_t min_finish_us = start_us + static_cast<int64_t>(min_secs * 1e6);
+  const int64_t max_finish_us = start_us + static_cast<int64_t>(max_secs * 1e6);
+
+  auto send_requests = [&](int i) {
+    Interpreter* instance = instances[i];
+    InstanceStats& stats = instance_stats[i];
+    const int64_t start_cpu_time_us = GetThreadCpuTimeMicros();
+    while (true) {
+      const int64_t request = next_request.fetch_add(1);
+      const int64_t now_us = profiling::time::NowMicros();
+      // In an open loop, the request arrives at its scheduled time even if
+      // all the instances are busy, and its latency counts from there.
+      const int64_t arrival_us =
+          qps > 0 ? start_us + static_cast<int64_t>(request * 1e6 / qps)
+                  : now_us;
+      if (arrival_us > max_finish_us ||
+          (request >= min_num_requests && arrival_us >= min_finish_us)) {
+        break;
+      }
+      // Returns immediately if the request is already late.
+      util::SleepForSeconds((arrival_us - now_us) * 1e-6);
+      SetInputs(instance, /*set_non_string_inputs=*/true);
+      const TfLiteStatus status = instance->Invoke();
+      stats.latencies_us.push_back(profiling::time::NowMicros() - arrival_us);
+      if (status != kTfLiteOk) ++stats.num_failed_requests;
+    }
+    if (start_cpu_time_us >= 0) {
+      stats.cpu_time_us = GetThreadCpuTimeMicros() - start_cpu_time_us;
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_instances);
+  for (int i = 0; i < num_instances; ++i) {
+    threads.emplace_back(send_requests, i);
+  }
+  for (std::thread& thread : threads) thread.join();
+  const int64_t duration_us =
+      std::max<int64_t>(profiling::time::NowMicros() - start_us, 1);
+  const int64_t end_process_cpu_time_us = GetProcessCpuTimeMicros();
+
+  tensorflow::Stat<int64_t> run_stats;
+  std::vector<int64_t> latencies_us;
+  load_test_results_ = LoadTestResults();
+  load_test_results_.num_instances = num_instances;
+  load_test_results_.target_qps = qps;
+  if (start_process_cpu_time_us >= 0 && end_process_cpu_time_us >= 0) {
+    load_test_results_.process_cpu_time_us =
+        end_process_cpu_time_us - start_process_cpu_time_us;
+  }
+  for (const InstanceStats& stats : instance_stats) {
+    for (int64_t latency_us : stats.latencies_us) {
+      run_stats.UpdateStat(latency_us);
+    }
+    latencies_us.insert(latencies_us.end(), stats.latencies_us.begin(),
+                        stats.latencies_us.end());
+    load_test_results_.num_failed_requests += stats.num_failed_requests;
+    load_test_results_.thread_cpu_time_us.push_back(stats.cpu_time_us);
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  load_test_results_.num_requests = latencies_us.size();
+  load_test_results_.throughput_qps = latencies_us.size() * 1e6 / duration_us;
+  load_test_results_.latency_p50_us = GetPercentile(latencies_us, 50);
+  load_test_results_.latency_p90_us = GetPercentile(latencies_us, 90);
+  load_test_results_.latency_p99_us = GetPercentile(latencies_us, 99);
+  load_test_results_.latency_max_us =
+      latencies_us.empty() ? 0 : latencies_us.back();
+  if (load_test_results_.num_failed_requests > 0) {
+    *invoke_status = kTfLiteError;
+  }
+
+  std::stringstream stream;
+  run_stats.OutputToStream(&stream);
+  TFLITE_LOG(INFO) << stream.str() << std::endl;
+
+  return run_stats;
+}
 
 }  // namespace benchmark
 }  // namespace tflite
@@ -77,6 +77,8 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   explicit BenchmarkTfLiteModel(BenchmarkParams params = DefaultParams());
   ~BenchmarkTfLiteModel() override;
 
+  using BenchmarkModel::Run;
+
   std::vector<Flag> GetFlags() override;
   void LogParams() override;
   TfLiteStatus ValidateParams() override;
@@ -90,6 +92,13 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   TfLiteStatus ResetInputsAndOutputs() override;
 
   int64_t MayGetModelFileSize() override;
+  LoadTestResults MayGetLoadTestResults() override;
+
+  // Runs the load test instead of the regular runs when
+  // --load_test_num_instances is set.
+  tensorflow::Stat<int64_t> Run(int min_num_times, float min_secs,
+                                float max_secs, RunType run_type,
+                                TfLiteStatus* invoke_status) override;
 
   virtual TfLiteStatus LoadModel();
 
@@ -115,21 +124,50 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   std::unique_ptr<tflite::ExternalCpuBackendContext> external_context_;
 
  private:
+  class LoadTestInstances;
+
   utils::InputTensorData CreateRandomTensorData(
       const TfLiteTensor& t, const InputLayerInfo* layer_info);
 
+  // Resizes the inputs to the shapes of the next run, when alternating
+  // between --input_layer_shape and --alternate_input_layer_shape, and sets
+  // their values.
+  TfLiteStatus ResizeInputsForNextRun();
+
+  // Sets the values of the string inputs of `interpreter`, and of the other
+  // inputs if `set_non_string_inputs`, from `inputs_data_`.
+  void SetInputs(Interpreter* interpreter, bool set_non_string_inputs);
+
+  // Creates the interpreter instances of the load test.
+  TfLiteStatus InitLoadTest();
+
+  // Sends requests to the instances of the load test from a thread per
+  // instance, either at --load_test_qps or as fast as they complete, and
+  // returns their latencies.
+  tensorflow::Stat<int64_t> RunLoadTest(int min_num_requests, float min_secs,
+                                        float max_secs,
+                                        TfLiteStatus* invoke_status);
+
   void AddOwnedListener(std::unique_ptr<BenchmarkListener> listener) {
     if (listener == nullptr) return;
     owned_listeners_.emplace_back(std::move(listener));
     AddListener(owned_listeners_.back().get());
   }
 
+  // Inputs with the shapes of --alternate_input_layer_shape, and their values.
+  std::vector<InputLayerInfo> alternate_inputs_;
+  std::vector<utils::InputTensorData> alternate_inputs_data_;
+  // True if the last run used `alternate_inputs_`.
+  bool use_alternate_inputs_ = false;
+
   std::vector<std::unique_ptr<BenchmarkListener>> owned_listeners_;
   std::mt19937 random_engine_;
   std::vector<Interpreter::TfLiteDelegatePtr> owned_delegates_;
   // Always TFLITE_LOG the benchmark result.
   BenchmarkLoggingListener log_output_;
   std::unique_ptr<tools::ModelLoader> model_loader_;
+  std::unique_ptr<LoadTestInstances> load_test_instances_;
+  LoadTestResults load_test_results_;
 };
 
 }  // namespace benchmark
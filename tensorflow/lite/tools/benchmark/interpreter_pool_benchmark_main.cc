@@ -0,0 +1,190 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the memory cost of each concurrent execution context of an
+// InterpreterPool, and the throughput of the pool under load, e.g.
+//
+//   interpreter_pool_benchmark --graph=model.tflite --num_contexts=16
+//
+// The memory is compared with as many independent interpreters, which do not
+// share their packed weights nor their memory plan. The throughput is
+// measured with one client thread per context, each running inferences back
+// to back for --duration_seconds.
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/core/model_builder.h"
+#include "tensorflow/lite/interpreter_pool.h"
+#include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+
+namespace tflite {
+namespace {
+
+using profiling::memory::GetMemoryUsage;
+using profiling::memory::MemoryUsage;
+
+// Returns the heap memory used to hold `num_contexts` contexts, either in one
+// pool or in independent pools.
+int64_t MeasureMemory(const FlatBufferModel& model, const OpResolver& resolver,
+                      InterpreterPool::Options options, int num_contexts,
+                      bool shared) {
+  const MemoryUsage start = GetMemoryUsage();
+  std::vector<std::unique_ptr<InterpreterPool>> pools;
+  if (shared) {
+    options.max_size = options.initial_size = num_contexts;
+    pools.push_back(InterpreterPool::Create(model, resolver, options));
+  } else {
+    options.max_size = options.initial_size = 1;
+    for (int i = 0; i < num_contexts; ++i) {
+      pools.push_back(InterpreterPool::Create(model, resolver, options));
+    }
+  }
+  for (const auto& pool : pools) {
+    if (pool == nullptr) return -1;
+  }
+  const MemoryUsage end = GetMemoryUsage();
+  return static_cast<int64_t>(end.in_use_allocated_bytes) -
+         static_cast<int64_t>(start.in_use_allocated_bytes);
+}
+
+// Returns the number of inferences per second of `num_clients` threads
+// sharing a pool of `num_contexts` contexts.
+double MeasureThroughput(const FlatBufferModel& model,
+                         const OpResolver& resolver,
+                         InterpreterPool::Options options, int num_contexts,
+                         int num_clients, double duration_seconds) {
+  options.max_size = options.initial_size = num_contexts;
+  auto pool = InterpreterPool::Create(model, resolver, options);
+  if (pool == nullptr) return -1;
+
+  std::atomic<bool> stop{false};
+  std::atomic<int64_t> num_inferences{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> clients;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_clients; ++i) {
+    clients.emplace_back([&] {
+      while (!stop.load(std::memory_order_relaxed)) {
+        InterpreterPool::Lease interpreter = pool->Acquire();
+        if (interpreter == nullptr) {
+          failed = true;
+          return;
+        }
+        for (int input : interpreter->inputs()) {
+          TfLiteTensor* tensor = interpreter->tensor(input);
+          if (tensor->data.raw != nullptr) {
+            std::memset(tensor->data.raw, 0, tensor->bytes);
+          }
+        }
+        if (interpreter->Invoke() != kTfLiteOk) {
+          failed = true;
+          return;
+        }
+        num_inferences.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration_seconds));
+  stop = true;
+  for (std::thread& client : clients) client.join();
+  const double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return failed ? -1 : num_inferences / elapsed;
+}
+
+int Run(int argc, char** argv) {
+  std::string graph;
+  int32_t num_contexts = 8;
+  int32_t num_clients = 0;
+  int32_t num_threads = 1;
+  bool use_xnnpack = true;
+  float duration_seconds = 10;
+  std::vector<Flag> flag_list = {
+      Flag::CreateFlag("graph", &graph, "Path to the .tflite model.",
+                       Flag::kRequired),
+      Flag::CreateFlag("num_contexts", &num_contexts,
+                       "Number of interpreters in the pool."),
+      Flag::CreateFlag("num_clients", &num_clients,
+                       "Number of threads sending requests to the pool. "
+                       "Defaults to --num_contexts."),
+      Flag::CreateFlag("num_threads", &num_threads,
+                       "Number of threads used by each interpreter."),
+      Flag::CreateFlag("use_xnnpack", &use_xnnpack,
+                       "Whether to use the XNNPACK delegate with a shared "
+                       "weights cache."),
+      Flag::CreateFlag("duration_seconds", &duration_seconds,
+                       "Duration of the throughput measurement."),
+  };
+  if (!Flags::Parse(&argc, const_cast<const char**>(argv), flag_list) ||
+      num_contexts < 1) {
+    std::cerr << Flags::Usage(argv[0], flag_list);
+    return 1;
+  }
+  if (num_clients <= 0) num_clients = num_contexts;
+
+  std::unique_ptr<FlatBufferModel> model =
+      FlatBufferModel::BuildFromFile(graph.c_str());
+  if (model == nullptr) {
+    std::cerr << "Failed to load " << graph << "\n";
+    return 1;
+  }
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+  InterpreterPool::Options options;
+  options.num_threads = num_threads;
+  options.use_xnnpack = use_xnnpack;
+
+  if (MemoryUsage::IsSupported()) {
+    const int64_t shared_bytes =
+        MeasureMemory(*model, resolver, options, num_contexts, true);
+    const int64_t independent_bytes =
+        MeasureMemory(*model, resolver, options, num_contexts, false);
+    if (shared_bytes < 0 || independent_bytes < 0) {
+      std::cerr << "Failed to create the interpreters.\n";
+      return 1;
+    }
+    std::cout << "Memory per context, pooled: " << shared_bytes / num_contexts
+              << " bytes, independent: " << independent_bytes / num_contexts
+              << " bytes\n";
+  }
+
+  const double throughput =
+      MeasureThroughput(*model, resolver, options, num_contexts, num_clients,
+                        duration_seconds);
+  if (throughput < 0) {
+    std::cerr << "Failed to run the model.\n";
+    return 1;
+  }
+  std::cout << "Throughput with " << num_contexts << " contexts and "
+            << num_clients << " clients: " << throughput
+            << " inferences/s\n";
+  return 0;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::Run(argc, argv); }
@@ -0,0 +1,313 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the tokens per second of a small autoregressive decoder, keeping
+// its KV caches either as model inputs and outputs that the caller feeds back
+// after every token, or as resource variables that the model updates in
+// place, e.g.
+//
+//   kv_cache_benchmark --num_layers=4 --dim=256 --max_tokens=2048
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/builtin_op_data.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+
+namespace tflite {
+namespace {
+
+struct DecoderConfig {
+  int num_layers;
+  int dim;
+  int max_tokens;
+};
+
+// A decoder with single-head attention, predicting one token per invocation.
+// Each layer computes
+//
+//   q, k, v = x * Wq, x * Wk, x * Wv
+//   k_cache = DYNAMIC_UPDATE_SLICE(k_cache, k, [position, 0])
+//   v_cache = DYNAMIC_UPDATE_SLICE(v_cache, v, [position, 0])
+//   x = x + SOFTMAX(q * k_cache^T) * v_cache
+//
+// The rows of the caches past `position` are zeros rather than masked, which
+// doesn't change the cost.
+class Decoder {
+ public:
+  Decoder(const DecoderConfig& config, bool use_variables, int num_threads)
+      : config_(config), use_variables_(use_variables) {
+    interpreter_ = std::make_unique<Interpreter>();
+    interpreter_->SetNumThreads(num_threads);
+  }
+
+  TfLiteStatus Build() {
+    const int dim = config_.dim;
+    const int max_tokens = config_.max_tokens;
+    const int x_input = AddTensor(kTfLiteFloat32, {1, dim});
+    position_input_ = AddTensor(kTfLiteInt32, {2});
+    inputs_ = {x_input, position_input_};
+
+    int x = x_input;
+    for (int layer = 0; layer < config_.num_layers; ++layer) {
+      int caches[2];
+      for (int i = 0; i < 2; ++i) {
+        const int projection = AddTensor(kTfLiteFloat32, {1, dim});
+        AddFullyConnected(x, projection);
+        caches[i] = AddCacheUpdate(layer, i, projection);
+      }
+      const int query = AddTensor(kTfLiteFloat32, {1, dim});
+      AddFullyConnected(x, query);
+
+      auto* scores_params = static_cast<TfLiteBatchMatMulParams*>(
+          calloc(1, sizeof(TfLiteBatchMatMulParams)));
+      scores_params->adj_y = true;
+      const int scores = AddTensor(kTfLiteFloat32, {1, max_tokens});
+      AddNode(BuiltinOperator_BATCH_MATMUL, {query, caches[0]}, {scores},
+              scores_params);
+
+      auto* softmax_params = static_cast<TfLiteSoftmaxParams*>(
+          calloc(1, sizeof(TfLiteSoftmaxParams)));
+      softmax_params->beta = 1.f;
+      const int probabilities = AddTensor(kTfLiteFloat32, {1, max_tokens});
+      AddNode(BuiltinOperator_SOFTMAX, {scores}, {probabilities},
+              softmax_params);
+
+      const int attention = AddTensor(kTfLiteFloat32, {1, dim});
+      AddNode(BuiltinOperator_BATCH_MATMUL, {probabilities, caches[1]},
+              {attention},
+              calloc(1, sizeof(TfLiteBatchMatMulParams)));
+
+      const int next_x = AddTensor(kTfLiteFloat32, {1, dim});
+      AddNode(BuiltinOperator_ADD, {x, attention}, {next_x},
+              calloc(1, sizeof(TfLiteAddParams)));
+      x = next_x;
+    }
+    outputs_.insert(outputs_.begin(), x);
+
+    TF_LITE_ENSURE_STATUS(interpreter_->SetInputs(inputs_));
+    TF_LITE_ENSURE_STATUS(interpreter_->SetOutputs(outputs_));
+    TF_LITE_ENSURE_STATUS(status_);
+    TF_LITE_ENSURE_STATUS(interpreter_->AllocateTensors());
+    return InitializeCaches();
+  }
+
+  // Predicts the token at `position`.
+  TfLiteStatus Step(int position) {
+    float* x = interpreter_->typed_input_tensor<float>(0);
+    for (int i = 0; i < config_.dim; ++i) x[i] = random_(engine_);
+    int32_t* start_indices = interpreter_->typed_tensor<int32_t>(
+        position_input_);
+    start_indices[0] = position % config_.max_tokens;
+    start_indices[1] = 0;
+    TF_LITE_ENSURE_STATUS(interpreter_->Invoke());
+
+    // Feed the updated caches back, as callers of models without state do.
+    for (const auto& [input, output] : cache_inputs_and_outputs_) {
+      const TfLiteTensor* updated = interpreter_->tensor(output);
+      std::memcpy(interpreter_->tensor(input)->data.raw, updated->data.raw,
+                  updated->bytes);
+    }
+    return kTfLiteOk;
+  }
+
+ private:
+  int AddTensor(TfLiteType type, const std::vector<int>& dims) {
+    int index;
+    Check(interpreter_->AddTensors(1, &index));
+    Check(interpreter_->SetTensorParametersReadWrite(index, type, "", dims,
+                                                     TfLiteQuantization()));
+    return index;
+  }
+
+  int AddWeights(const std::vector<int>& dims) {
+    int size = 1;
+    for (int dim : dims) size *= dim;
+    weights_.emplace_back(size);
+    std::vector<float>& weights = weights_.back();
+    for (float& weight : weights) weight = random_(engine_) / config_.dim;
+    int index;
+    Check(interpreter_->AddTensors(1, &index));
+    Check(interpreter_->SetTensorParametersReadOnly(
+        index, kTfLiteFloat32, "", dims, TfLiteQuantization(),
+        reinterpret_cast<const char*>(weights.data()),
+        weights.size() * sizeof(float)));
+    return index;
+  }
+
+  void AddNode(BuiltinOperator op, const std::vector<int>& inputs,
+               const std::vector<int>& outputs, void* builtin_data) {
+    const TfLiteRegistration* registration = resolver_.FindOp(op, 1);
+    if (registration == nullptr) {
+      status_ = kTfLiteError;
+      return;
+    }
+    Check(interpreter_->AddNodeWithParameters(
+        inputs, outputs, nullptr, 0, builtin_data, registration));
+  }
+
+  void AddFullyConnected(int input, int output) {
+    const int weights = AddWeights({config_.dim, config_.dim});
+    AddNode(BuiltinOperator_FULLY_CONNECTED, {input, weights, -1}, {output},
+            calloc(1, sizeof(TfLiteFullyConnectedParams)));
+  }
+
+  // Adds the update of the `cache`th cache of `layer` at the current position
+  // with `update`, and returns the updated cache.
+  int AddCacheUpdate(int layer, int cache, int update) {
+    const std::vector<int> dims = {config_.max_tokens, config_.dim};
+    const int updated = AddTensor(kTfLiteFloat32, dims);
+    if (!use_variables_) {
+      const int input = AddTensor(kTfLiteFloat32, dims);
+      inputs_.push_back(input);
+      outputs_.push_back(updated);
+      cache_inputs_and_outputs_.emplace_back(input, updated);
+      AddNode(BuiltinOperator_DYNAMIC_UPDATE_SLICE,
+              {input, update, position_input_}, {updated}, nullptr);
+      return updated;
+    }
+
+    variable_names_.push_back("cache_" + std::to_string(layer) + "_" +
+                              std::to_string(cache));
+    variable_tensors_.push_back(updated);
+    auto* params = static_cast<TfLiteVarHandleParams*>(
+        calloc(1, sizeof(TfLiteVarHandleParams)));
+    params->shared_name = variable_names_.back().c_str();
+    const int handle = AddTensor(kTfLiteResource, {});
+    AddNode(BuiltinOperator_VAR_HANDLE, {}, {handle}, params);
+    const int value = AddTensor(kTfLiteFloat32, dims);
+    AddNode(BuiltinOperator_READ_VARIABLE, {handle}, {value}, nullptr);
+    AddNode(BuiltinOperator_DYNAMIC_UPDATE_SLICE,
+            {value, update, position_input_}, {updated}, nullptr);
+    AddNode(BuiltinOperator_ASSIGN_VARIABLE, {handle, updated}, {}, nullptr);
+    return updated;
+  }
+
+  // Zeroes the caches.
+  TfLiteStatus InitializeCaches() {
+    for (const auto& [input, output] : cache_inputs_and_outputs_) {
+      TfLiteTensor* tensor = interpreter_->tensor(input);
+      std::memset(tensor->data.raw, 0, tensor->bytes);
+    }
+    Subgraph& subgraph = interpreter_->primary_subgraph();
+    for (size_t i = 0; i < variable_names_.size(); ++i) {
+      const int id = subgraph.resource_ids().at(
+          std::make_pair(std::string(), variable_names_[i]));
+      resource::CreateResourceVariableIfNotAvailable(&subgraph.resources(), id);
+      TfLiteTensor zeros = *interpreter_->tensor(variable_tensors_[i]);
+      std::vector<char> buffer(zeros.bytes, 0);
+      zeros.data.raw = buffer.data();
+      TF_LITE_ENSURE_STATUS(
+          resource::GetResourceVariable(&subgraph.resources(), id)
+              ->AssignFrom(&zeros));
+    }
+    return kTfLiteOk;
+  }
+
+  void Check(TfLiteStatus status) {
+    if (status != kTfLiteOk) status_ = status;
+  }
+
+  const DecoderConfig config_;
+  const bool use_variables_;
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver_;
+  std::vector<std::vector<float>> weights_;
+  // Referenced by the VAR_HANDLE nodes.
+  std::deque<std::string> variable_names_;
+  std::unique_ptr<Interpreter> interpreter_;
+  TfLiteStatus status_ = kTfLiteOk;
+  std::vector<int> inputs_;
+  std::vector<int> outputs_;
+  int position_input_;
+  std::vector<std::pair<int, int>> cache_inputs_and_outputs_;
+  std::vector<int> variable_tensors_;
+  std::mt19937 engine_{1234};
+  std::normal_distribution<float> random_{0.f, 1.f};
+};
+
+// Returns the tokens per second of a decoder generating `num_tokens` tokens,
+// or -1 on failure.
+double MeasureTokensPerSecond(const DecoderConfig& config, bool use_variables,
+                              int num_threads, int num_tokens) {
+  Decoder decoder(config, use_variables, num_threads);
+  if (decoder.Build() != kTfLiteOk) return -1;
+  if (decoder.Step(0) != kTfLiteOk) return -1;
+  const auto start = std::chrono::steady_clock::now();
+  for (int position = 1; position <= num_tokens; ++position) {
+    if (decoder.Step(position) != kTfLiteOk) return -1;
+  }
+  const double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return num_tokens / elapsed;
+}
+
+int Run(int argc, char** argv) {
+  DecoderConfig config = {/*num_layers=*/4, /*dim=*/256, /*max_tokens=*/2048};
+  int32_t num_tokens = 256;
+  int32_t num_threads = 1;
+  std::vector<Flag> flag_list = {
+      Flag::CreateFlag("num_layers", &config.num_layers,
+                       "Number of decoder layers."),
+      Flag::CreateFlag("dim", &config.dim, "Number of features per token."),
+      Flag::CreateFlag("max_tokens", &config.max_tokens,
+                       "Number of tokens held by the KV caches."),
+      Flag::CreateFlag("num_tokens", &num_tokens,
+                       "Number of tokens to generate."),
+      Flag::CreateFlag("num_threads", &num_threads,
+                       "Number of threads used by the interpreter."),
+  };
+  if (!Flags::Parse(&argc, const_cast<const char**>(argv), flag_list) ||
+      config.num_layers < 1 || config.dim < 1 || config.max_tokens < 1 ||
+      num_tokens < 1) {
+    std::cerr << Flags::Usage(argv[0], flag_list);
+    return 1;
+  }
+
+  const int64_t cache_bytes = int64_t{2} * config.num_layers *
+                              config.max_tokens * config.dim * sizeof(float);
+  std::cout << "KV caches: " << cache_bytes << " bytes\n";
+  for (const bool use_variables : {false, true}) {
+    const double tokens_per_second =
+        MeasureTokensPerSecond(config, use_variables, num_threads, num_tokens);
+    if (tokens_per_second < 0) {
+      std::cerr << "Failed to run the decoder.\n";
+      return 1;
+    }
+    std::cout << (use_variables ? "Caches in variables: "
+                                : "Caches as inputs and outputs: ")
+              << tokens_per_second << " tokens/s\n";
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::Run(argc, argv); }
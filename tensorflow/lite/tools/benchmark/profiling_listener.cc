@@ -16,8 +16,12 @@ limitations under the License.
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
 
 #include <fstream>
+#include <memory>
 #include <string>
+#include <utility>
 
+#include "tensorflow/lite/profiling/roofline.h"
+#include "tensorflow/lite/tools/benchmark/roofline_probe.h"
 #include "tensorflow/lite/tools/logging.h"
 
 namespace tflite {
@@ -26,42 +30,69 @@ namespace benchmark {
 ProfilingListener::ProfilingListener(
     Interpreter* interpreter, uint32_t max_num_initial_entries,
     bool allow_dynamic_buffer_increase, const std::string& csv_file_path,
-    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter)
+    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter,
+    bool enable_hw_counters)
     : run_summarizer_(summarizer_formatter),
       init_summarizer_(summarizer_formatter),
       csv_file_path_(csv_file_path),
-      interpreter_(interpreter),
-      profiler_(max_num_initial_entries, allow_dynamic_buffer_increase) {
+      interpreter_(interpreter) {
   TFLITE_TOOLS_CHECK(interpreter);
-  interpreter_->SetProfiler(&profiler_);
+  if (enable_hw_counters) {
+    auto perf_event_profiler = std::make_unique<profiling::PerfEventProfiler>(
+        max_num_initial_entries, allow_dynamic_buffer_increase);
+    perf_event_profiler_ = perf_event_profiler.get();
+    profiler_ = std::move(perf_event_profiler);
+    if (perf_event_profiler_->available_hw_counters() == 0) {
+      TFLITE_LOG(WARN) << "Hardware counters are unavailable, e.g. because "
+                          "perf events aren't supported or allowed. Only the "
+                          "time of the ops is profiled.";
+    }
+  } else {
+    profiler_ = std::make_unique<profiling::BufferedProfiler>(
+        max_num_initial_entries, allow_dynamic_buffer_increase);
+  }
+  interpreter_->SetProfiler(profiler_.get());
 
   // We start profiling here in order to catch events that are recorded during
   // the benchmark run preparation stage where TFLite interpreter is
   // initialized and model graph is prepared.
-  profiler_.Reset();
-  profiler_.StartProfiling();
+  profiler_->Reset();
+  profiler_->StartProfiling();
+}
+
+void ProfilingListener::EnableRooflineReport(
+    int num_threads, const std::string& json_file_path) {
+  roofline_report_enabled_ = true;
+  roofline_num_threads_ = num_threads;
+  roofline_json_file_path_ = json_file_path;
 }
 
 void ProfilingListener::OnBenchmarkStart(const BenchmarkParams& params) {
   // At this point, we have completed the preparation for benchmark runs
   // including TFLite interpreter initialization etc. So we are going to process
   // profiling events recorded during this stage.
-  profiler_.StopProfiling();
-  auto profile_events = profiler_.GetProfileEvents();
+  profiler_->StopProfiling();
+  auto profile_events = profiler_->GetProfileEvents();
   init_summarizer_.ProcessProfiles(profile_events, *interpreter_);
-  profiler_.Reset();
+  profiler_->Reset();
+
+  if (roofline_report_enabled_) {
+    roofline_ = MeasureRoofline(roofline_num_threads_);
+    TFLITE_LOG(INFO) << "Measured roofline: " << roofline_.peak_gflops
+                     << " GFLOP/s, " << roofline_.peak_gbps << " GB/s";
+  }
 }
 
 void ProfilingListener::OnSingleRunStart(RunType run_type) {
   if (run_type == REGULAR) {
-    profiler_.Reset();
-    profiler_.StartProfiling();
+    profiler_->Reset();
+    profiler_->StartProfiling();
   }
 }
 
 void ProfilingListener::OnSingleRunEnd() {
-  profiler_.StopProfiling();
-  auto profile_events = profiler_.GetProfileEvents();
+  profiler_->StopProfiling();
+  auto profile_events = profiler_->GetProfileEvents();
   run_summarizer_.ProcessProfiles(profile_events, *interpreter_);
 }
 
@@ -81,6 +112,29 @@ void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                 run_summarizer_.GetOutputString(),
                 output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
   }
+  if (roofline_report_enabled_ && run_summarizer_.HasProfiles()) {
+    WriteOutput("Roofline of the Operators for Regular Benchmark Runs:",
+                run_summarizer_.GetRooflineReport(roofline_),
+                output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
+    if (!roofline_json_file_path_.empty()) {
+      std::ofstream json_file(roofline_json_file_path_);
+      if (json_file.good()) {
+        json_file << profiling::FormatRooflineReport(
+            run_summarizer_.GetOpEfficiencies(roofline_), roofline_,
+            profiling::RooflineReportFormat::kJson);
+      } else {
+        TFLITE_LOG(ERROR) << "Failed to open " << roofline_json_file_path_;
+      }
+    }
+  }
+  if (perf_event_profiler_ != nullptr &&
+      perf_event_profiler_->available_hw_counters() != 0 &&
+      run_summarizer_.HasProfiles()) {
+    WriteOutput("Hardware Counters of the Operators for Regular Benchmark "
+                "Runs:",
+                run_summarizer_.GetHardwareCounterReport(),
+                output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
+  }
 }
 
 void ProfilingListener::WriteOutput(const std::string& header,
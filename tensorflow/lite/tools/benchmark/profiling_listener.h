@@ -20,8 +20,10 @@ limitations under the License.
 #include <string>
 
 #include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/roofline.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
 
 namespace tflite {
@@ -30,11 +32,19 @@ namespace benchmark {
 // Dumps profiling events if profiling is enabled.
 class ProfilingListener : public BenchmarkListener {
  public:
+  // If `enable_hw_counters`, the hardware counters of each op are also
+  // profiled with a PerfEventProfiler, where perf events are available.
   ProfilingListener(
       Interpreter* interpreter, uint32_t max_num_initial_entries,
       bool allow_dynamic_buffer_increase, const std::string& csv_file_path = "",
       std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter =
-          std::make_shared<profiling::ProfileSummaryDefaultFormatter>());
+          std::make_shared<profiling::ProfileSummaryDefaultFormatter>(),
+      bool enable_hw_counters = false);
+
+  // Also reports how close the ops run to the roofline of the machine, which
+  // is measured with `num_threads` threads when the benchmark starts. The
+  // report is additionally written as JSON to `json_file_path` if not empty.
+  void EnableRooflineReport(int num_threads, const std::string& json_file_path);
 
   void OnBenchmarkStart(const BenchmarkParams& params) override;
 
@@ -53,7 +63,13 @@ class ProfilingListener : public BenchmarkListener {
   void WriteOutput(const std::string& header, const string& data,
                    std::ostream* stream);
   Interpreter* interpreter_;
-  profiling::BufferedProfiler profiler_;
+  std::unique_ptr<profiling::BufferedProfiler> profiler_;
+  // The PerfEventProfiler of profiler_, if hardware counters are enabled.
+  profiling::PerfEventProfiler* perf_event_profiler_ = nullptr;
+  bool roofline_report_enabled_ = false;
+  int roofline_num_threads_ = 1;
+  std::string roofline_json_file_path_;
+  profiling::Roofline roofline_;
 };
 
 }  // namespace benchmark
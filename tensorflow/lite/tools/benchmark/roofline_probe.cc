@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/benchmark/roofline_probe.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
+#include "tensorflow/lite/profiling/roofline.h"
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// 3 MiB of operands.
+constexpr int kGemmSize = 512;
+// 96 MiB for the 3 arrays.
+constexpr size_t kTriadSize = 8 << 20;
+
+// Returns the shortest time in seconds of `fn`, run at least 3 times and for
+// at least 0.1 seconds.
+template <typename Fn>
+double GetBestSeconds(Fn fn) {
+  uint64_t best_us = std::numeric_limits<uint64_t>::max();
+  const uint64_t start_us = profiling::time::NowMicros();
+  for (int run = 0;
+       run < 3 || profiling::time::NowMicros() - start_us < 100000; ++run) {
+    const uint64_t run_start_us = profiling::time::NowMicros();
+    fn();
+    best_us = std::min(best_us, profiling::time::NowMicros() - run_start_us);
+  }
+  return std::max<uint64_t>(best_us, 1) * 1e-6;
+}
+
+double MeasureGemmGflops(int num_threads) {
+  CpuBackendContext context;
+  context.SetMaxNumThreads(num_threads);
+  const int n = kGemmSize;
+  std::vector<float> lhs(n * n, 1.0f);
+  std::vector<float> rhs(n * n, 1.0f);
+  std::vector<float> dst(n * n);
+  cpu_backend_gemm::MatrixParams<float> lhs_params;
+  lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = n;
+  lhs_params.cols = n;
+  cpu_backend_gemm::MatrixParams<float> rhs_params;
+  rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = n;
+  rhs_params.cols = n;
+  cpu_backend_gemm::MatrixParams<float> dst_params;
+  dst_params.order = cpu_backend_gemm::Order::kColMajor;
+  dst_params.rows = n;
+  dst_params.cols = n;
+  cpu_backend_gemm::GemmParams<float, float> gemm_params;
+  const double seconds = GetBestSeconds([&] {
+    cpu_backend_gemm::Gemm(lhs_params, lhs.data(), rhs_params, rhs.data(),
+                           dst_params, dst.data(), gemm_params, &context);
+  });
+  return 2.0 * n * n * n / seconds / 1e9;
+}
+
+double MeasureTriadGbps(int num_threads) {
+  std::vector<float> a(kTriadSize);
+  std::vector<float> b(kTriadSize, 1.0f);
+  std::vector<float> c(kTriadSize, 2.0f);
+  const float scalar = 3.0f;
+  auto triad = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) a[i] = b[i] + scalar * c[i];
+  };
+  const double seconds = GetBestSeconds([&] {
+    std::vector<std::thread> threads;
+    const size_t slice = (kTriadSize + num_threads - 1) / num_threads;
+    for (int i = 1; i < num_threads; ++i) {
+      threads.emplace_back(triad, std::min(i * slice, kTriadSize),
+                           std::min((i + 1) * slice, kTriadSize));
+    }
+    triad(0, std::min(slice, kTriadSize));
+    for (std::thread& thread : threads) thread.join();
+  });
+  return 3.0 * kTriadSize * sizeof(float) / seconds / 1e9;
+}
+
+}  // namespace
+
+profiling::Roofline MeasureRoofline(int num_threads) {
+  num_threads = std::max(num_threads, 1);
+  profiling::Roofline roofline;
+  roofline.peak_gflops = MeasureGemmGflops(num_threads);
+  roofline.peak_gbps = MeasureTriadGbps(num_threads);
+  return roofline;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,34 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_ROOFLINE_PROBE_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_ROOFLINE_PROBE_H_
+
+#include "tensorflow/lite/profiling/roofline.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Measures the roofline of the machine when using `num_threads` threads:
+// - the peak compute throughput is the one of a float GEMM whose operands fit
+//   in the caches, run by cpu_backend_gemm like the float CPU kernels,
+// - the peak memory bandwidth is the one of the STREAM triad
+//   a[i] = b[i] + s * c[i] on arrays much larger than the caches.
+// This takes a fraction of a second.
+profiling::Roofline MeasureRoofline(int num_threads);
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_ROOFLINE_PROBE_H_
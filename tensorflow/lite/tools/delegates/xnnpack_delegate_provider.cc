@@ -15,6 +15,7 @@ limitations under the License.
 #include <string>
 #include <utility>
 
+#include "tensorflow/lite/delegates/xnnpack/unpacked_weights_cache.h"
 #include "tensorflow/lite/tools/delegates/delegate_provider.h"
 #include "tensorflow/lite/tools/evaluation/utils.h"
 
@@ -25,6 +26,8 @@ class XnnpackDelegateProvider : public DelegateProvider {
  public:
   XnnpackDelegateProvider() {
     default_params_.AddParam("use_xnnpack", ToolParam::Create<bool>(false));
+    default_params_.AddParam("xnnpack_unpacked_weights_cache_dir",
+                             ToolParam::Create<std::string>(""));
   }
 
   std::vector<Flag> CreateFlags(ToolParams* params) const final;
@@ -41,23 +44,57 @@ REGISTER_DELEGATE_PROVIDER(XnnpackDelegateProvider);
 
 std::vector<Flag> XnnpackDelegateProvider::CreateFlags(
     ToolParams* params) const {
-  std::vector<Flag> flags = {CreateFlag<bool>(
-      "use_xnnpack", params,
-      "explicitly apply the XNNPACK delegate. Note the XNNPACK delegate could "
-      "be implicitly applied by the TF Lite runtime regardless the value of "
-      "this parameter. To disable this implicit application, set the value to "
-      "false explicitly.")};
+  std::vector<Flag> flags = {
+      CreateFlag<bool>(
+          "use_xnnpack", params,
+          "explicitly apply the XNNPACK delegate. Note the XNNPACK delegate "
+          "could be implicitly applied by the TF Lite runtime regardless the "
+          "value of this parameter. To disable this implicit application, set "
+          "the value to false explicitly."),
+      CreateFlag<std::string>(
+          "xnnpack_unpacked_weights_cache_dir", params,
+          "directory where the XNNPACK delegate caches the static weights it "
+          "unpacks, e.g. FP16 weights dequantized to FP32. The next runs map "
+          "the cached weights instead of unpacking them again. The cache is "
+          "keyed by the path, size and modification time of --graph.")};
   return flags;
 }
 
 void XnnpackDelegateProvider::LogParams(const ToolParams& params,
                                         bool verbose) const {
   LOG_TOOL_PARAM(params, bool, "use_xnnpack", "Use xnnpack", verbose);
+  LOG_TOOL_PARAM(params, std::string, "xnnpack_unpacked_weights_cache_dir",
+                 "XNNPACK unpacked weights cache directory", verbose);
 }
 
 TfLiteDelegatePtr XnnpackDelegateProvider::CreateTfLiteDelegate(
     const ToolParams& params) const {
   if (params.Get<bool>("use_xnnpack")) {
+#ifndef TFLITE_WITHOUT_XNNPACK
+    const std::string cache_dir =
+        params.Get<std::string>("xnnpack_unpacked_weights_cache_dir");
+    if (!cache_dir.empty()) {
+      const std::string model_token =
+          params.HasParam("graph")
+              ? xnnpack::UnpackedWeightsCache::GetModelFileToken(
+                    params.Get<std::string>("graph"))
+              : "";
+      if (model_token.empty()) {
+        TFLITE_LOG(WARN) << "Not using the XNNPACK unpacked weights cache, as "
+                            "the model file can't be identified.";
+      } else {
+        TfLiteXNNPackDelegateOptions options =
+            evaluation::XNNPackDelegateOptionsDefault();
+        const int num_threads = params.Get<int32_t>("num_threads");
+        // Note that we don't want to use the thread pool for num_threads == 1.
+        options.num_threads = num_threads > 1 ? num_threads : 0;
+        options.experimental_unpacked_weights_cache_dir = cache_dir.c_str();
+        options.experimental_unpacked_weights_cache_model_token =
+            model_token.c_str();
+        return evaluation::CreateXNNPACKDelegate(&options);
+      }
+    }
+#endif  // !defined(TFLITE_WITHOUT_XNNPACK)
     return evaluation::CreateXNNPACKDelegate(
         params.Get<int32_t>("num_threads"));
   }
@@ -212,6 +212,17 @@ TfLiteDelegatePtr CreateXNNPACKDelegate() {
 TfLiteDelegatePtr CreateXNNPACKDelegate(
     const TfLiteXNNPackDelegateOptions* xnnpack_options) {
   flatbuffers::FlatBufferBuilder flatbuffer_builder;
+  flatbuffers::Offset<flatbuffers::String> unpacked_weights_cache_dir;
+  if (xnnpack_options->experimental_unpacked_weights_cache_dir != nullptr) {
+    unpacked_weights_cache_dir = flatbuffer_builder.CreateString(
+        xnnpack_options->experimental_unpacked_weights_cache_dir);
+  }
+  flatbuffers::Offset<flatbuffers::String> unpacked_weights_cache_model_token;
+  if (xnnpack_options->experimental_unpacked_weights_cache_model_token !=
+      nullptr) {
+    unpacked_weights_cache_model_token = flatbuffer_builder.CreateString(
+        xnnpack_options->experimental_unpacked_weights_cache_model_token);
+  }
   tflite::XNNPackSettingsBuilder xnnpack_settings_builder(flatbuffer_builder);
   int num_threads = xnnpack_options->num_threads;
   if (num_threads >= 0) {
@@ -220,6 +231,10 @@ TfLiteDelegatePtr CreateXNNPACKDelegate(
   xnnpack_settings_builder.fbb_.AddElement<int32_t>(
       XNNPackSettings::VT_FLAGS, static_cast<int32_t>(xnnpack_options->flags),
       0);
+  xnnpack_settings_builder.add_unpacked_weights_cache_dir(
+      unpacked_weights_cache_dir);
+  xnnpack_settings_builder.add_unpacked_weights_cache_model_token(
+      unpacked_weights_cache_model_token);
   flatbuffers::Offset<tflite::XNNPackSettings> xnnpack_settings =
       xnnpack_settings_builder.Finish();
   tflite::TFLiteSettingsBuilder tflite_settings_builder(flatbuffer_builder);
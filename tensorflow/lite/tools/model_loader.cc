@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
+#include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/core/model_builder.h"
 #include "tensorflow/lite/minimal_logging.h"
 
@@ -48,7 +49,20 @@ bool PathModelLoader::InitInternal() {
     TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "model_path is empty.");
     return false;
   }
-  model_ = FlatBufferModel::VerifyAndBuildFromFile(model_path_.c_str());
+  if (!mmap_options_.has_value() || !MMAPAllocation::IsSupported()) {
+    model_ = FlatBufferModel::VerifyAndBuildFromFile(model_path_.c_str());
+    return true;
+  }
+  auto allocation = std::make_unique<MMAPAllocation>(
+      model_path_.c_str(), *mmap_options_, tflite::DefaultErrorReporter());
+  if (!allocation->valid()) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "MMAPAllocation is not valid.");
+    return false;
+  }
+  model_ = FlatBufferModel::VerifyAndBuildFromAllocation(std::move(allocation));
+#if FLATBUFFERS_LITTLEENDIAN == 0
+  model_ = FlatBufferModel::ByteConvertModel(std::move(model_));
+#endif
   return true;
 }
 
@@ -81,7 +95,8 @@ bool MmapModelLoader::InitInternal() {
     return false;
   }
   auto allocation = std::make_unique<MMAPAllocation>(
-      model_fd_, model_offset_, model_size_, tflite::DefaultErrorReporter());
+      model_fd_, model_offset_, model_size_, mmap_options_,
+      tflite::DefaultErrorReporter());
   if (!allocation->valid()) {
     TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "MMAPAllocation is not valid.");
     return false;
@@ -130,8 +145,11 @@ bool PipeModelLoader::InitInternal() {
 
 #endif  // !_WIN32
 
-std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(
-    const std::string& path) {
+namespace {
+
+// Passes `mmap_options` to the model loaders that mmap the model, if not null.
+std::unique_ptr<ModelLoader> CreateModelLoader(
+    const std::string& path, const MMAPAllocation::Options* mmap_options) {
   std::vector<absl::string_view> parts = absl::StrSplit(path, ':');
   if (parts.empty()) {
     return nullptr;
@@ -147,8 +165,9 @@ std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(
                       path.c_str());
       return nullptr;
     }
-    return std::make_unique<MmapModelLoader>(model_fd, model_offset,
-                                             model_size);
+    return std::make_unique<MmapModelLoader>(
+        model_fd, model_offset, model_size,
+        mmap_options ? *mmap_options : MMAPAllocation::Options());
   }
   if (parts[0] == "pipe") {
     int read_fd, write_fd;
@@ -179,8 +198,23 @@ std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(
     return std::make_unique<BufferModelLoader>(
         reinterpret_cast<const char*>(buffer_handle), model_size);
   }
+  if (mmap_options) {
+    return std::make_unique<PathModelLoader>(path, *mmap_options);
+  }
   return std::make_unique<PathModelLoader>(path);
 }
 
+}  // namespace
+
+std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(
+    const std::string& path) {
+  return CreateModelLoader(path, /*mmap_options=*/nullptr);
+}
+
+std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(
+    const std::string& path, const MMAPAllocation::Options& mmap_options) {
+  return CreateModelLoader(path, &mmap_options);
+}
+
 }  // namespace tools
 }  // namespace tflite
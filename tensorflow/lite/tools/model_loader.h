@@ -22,10 +22,12 @@ limitations under the License.
 #include <cstddef>
 #include <cstdlib>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/core/model_builder.h"
 
 namespace tflite {
@@ -65,6 +67,10 @@ class PathModelLoader : public ModelLoader {
  public:
   explicit PathModelLoader(absl::string_view model_path)
       : ModelLoader(), model_path_(model_path) {}
+  // Maps the model with `mmap_options` where mmap is supported.
+  PathModelLoader(absl::string_view model_path,
+                  const MMAPAllocation::Options& mmap_options)
+      : ModelLoader(), model_path_(model_path), mmap_options_(mmap_options) {}
 
   Type type() const override { return Type::kPathModelLoader; }
 
@@ -73,6 +79,7 @@ class PathModelLoader : public ModelLoader {
 
  private:
   const std::string model_path_;
+  const std::optional<MMAPAllocation::Options> mmap_options_;
 };
 
 // Load the Model from buffer. The buffer is owned by the caller.
@@ -105,10 +112,15 @@ class MmapModelLoader : public ModelLoader {
   // Create the model loader from file descriptor. The model_fd only has to be
   // valid for the duration of the constructor (it's dup'ed inside).
   MmapModelLoader(int model_fd, size_t model_offset, size_t model_size)
+      : MmapModelLoader(model_fd, model_offset, model_size,
+                        MMAPAllocation::Options()) {}
+  MmapModelLoader(int model_fd, size_t model_offset, size_t model_size,
+                  const MMAPAllocation::Options& mmap_options)
       : ModelLoader(),
         model_fd_(dup(model_fd)),
         model_offset_(model_offset),
-        model_size_(model_size) {}
+        model_size_(model_size),
+        mmap_options_(mmap_options) {}
 
   ~MmapModelLoader() override {
     if (model_fd_ >= 0) {
@@ -125,6 +137,7 @@ class MmapModelLoader : public ModelLoader {
   const int model_fd_ = -1;
   const size_t model_offset_ = 0;
   const size_t model_size_ = 0;
+  const MMAPAllocation::Options mmap_options_;
 };
 
 // Load the Model from a pipe file descriptor.
@@ -174,6 +187,11 @@ class PipeModelLoader : public ModelLoader {
 // model loader.
 std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(const std::string& path);
 
+// Same as above, but the model loaders of file paths and file descriptor paths
+// map the model with `mmap_options`.
+std::unique_ptr<ModelLoader> CreateModelLoaderFromPath(
+    const std::string& path, const MMAPAllocation::Options& mmap_options);
+
 }  // namespace tools
 }  // namespace tflite
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "absl/strings/str_format.h"
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/model_builder.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -49,6 +50,17 @@ TEST_F(ModelLoaderTest, CreateFromModelPath) {
   EXPECT_TRUE(model_loader->Init());
 }
 
+TEST_F(ModelLoaderTest, CreateFromModelPathWithMmapOptions) {
+  MMAPAllocation::Options mmap_options;
+  mmap_options.use_huge_pages = true;
+  mmap_options.num_prefault_threads = 2;
+  auto model_loader =
+      std::make_unique<PathModelLoader>(kModelPath, mmap_options);
+
+  ASSERT_NE(model_loader, nullptr);
+  EXPECT_TRUE(model_loader->Init());
+}
+
 TEST_F(ModelLoaderTest, CreateFromFdPath) {
   int fd = open(kModelPath, O_RDONLY);
   ASSERT_GE(fd, 0);
@@ -152,6 +164,13 @@ TEST_F(ModelLoaderTest, CreateModelLoaderFromValidPath) {
               WhenDynamicCastTo<PipeModelLoader*>(Not(IsNull())));
   EXPECT_THAT(CreateModelLoaderFromPath("buffer:1:2").get(),
               WhenDynamicCastTo<BufferModelLoader*>(Not(IsNull())));
+
+  MMAPAllocation::Options mmap_options;
+  mmap_options.populate = true;
+  EXPECT_THAT(CreateModelLoaderFromPath("a/b/c", mmap_options).get(),
+              WhenDynamicCastTo<PathModelLoader*>(Not(IsNull())));
+  EXPECT_THAT(CreateModelLoaderFromPath("fd:1:2:3", mmap_options).get(),
+              WhenDynamicCastTo<MmapModelLoader*>(Not(IsNull())));
 }
 
 TEST_F(ModelLoaderTest, CreateModelLoaderFromInvalidPath) {
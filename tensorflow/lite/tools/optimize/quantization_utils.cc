@@ -307,7 +307,8 @@ TfLiteStatus SymmetricPerChannelQuantization(TensorT* tensor,
                                              int32_t channel_dim_index,
                                              std::vector<float>* output_scales,
                                              std::vector<int8_t>* output_value,
-                                             ErrorReporter* error_reporter) {
+                                             ErrorReporter* error_reporter,
+                                             TfLiteType type) {
   if (tensor == nullptr) {
     TF_LITE_REPORT_ERROR(error_reporter, "Cannot quantize. Tensor is null.");
     return kTfLiteError;
@@ -325,7 +326,8 @@ TfLiteStatus SymmetricPerChannelQuantization(TensorT* tensor,
 
   // Calculate scales per channel using max and min values from tensor.
   std::vector<float> scale_invs(channel_dim_size);
-  const float half_scale = kMaxQuantizedValue8bit;
+  const float half_scale =
+      type == kTfLiteInt4 ? kMaxQuantizedValue4bit : kMaxQuantizedValue8bit;
   for (int channel_idx = 0; channel_idx < channel_dim_size; channel_idx++) {
     const float half_range =
         std::max(std::abs(tensor->quantization->min[channel_idx]),
@@ -340,7 +342,7 @@ TfLiteStatus SymmetricPerChannelQuantization(TensorT* tensor,
 
   // Quantize the input values.
   SymmetricPerChannelQuantizeValues(input, scale_invs, tensor->shape,
-                                    channel_dim_index, output_value);
+                                    channel_dim_index, output_value, type);
   return kTfLiteOk;
 }
 
@@ -620,6 +622,43 @@ TfLiteStatus SymmetricQuantizeTensorPerChannel(ModelT* model, TensorT* tensor,
                                model, tensor, error_reporter);
 }
 
+TfLiteStatus SymmetricQuantizeTensorPerChannelInt4(
+    ModelT* model, TensorT* tensor, int32_t channel_dim_index,
+    ErrorReporter* error_reporter) {
+  if (tensor->shape.size() > kPerChannelMaxDim) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter,
+        "SymmetricQuantizeTensorPerChannelInt4 requires tensor with less than "
+        "%d dimensions, but got %d dimension(s).",
+        kPerChannelMaxDim + 1, tensor->shape.size());
+    return kTfLiteError;
+  }
+
+  uint64_t num_elements;
+  TF_LITE_ENSURE_STATUS(NumElements(*tensor, &num_elements));
+  const int32_t channel_dim_size = tensor->shape[channel_dim_index];
+
+  const BufferT* buffer = model->buffers[tensor->buffer].get();
+  const float* float_input_data =
+      reinterpret_cast<const float*>(buffer->data.data());
+
+  std::vector<float> scales(channel_dim_size);
+  std::vector<int8_t> quantized_buffer(num_elements);
+  TF_LITE_ENSURE_STATUS(SymmetricPerChannelQuantization(
+      tensor, float_input_data, channel_dim_index, &scales, &quantized_buffer,
+      error_reporter, kTfLiteInt4));
+
+  // Int4 tensors are stored densely, with two values per byte.
+  std::vector<int8_t> final_buffer((num_elements + 1) / 2);
+  tensor_utils::PackInt8IntoDenseInt4(quantized_buffer.data(), num_elements,
+                                      final_buffer.data());
+  uint8_t* uint8_buffer = reinterpret_cast<uint8_t*>(final_buffer.data());
+  std::vector<int64_t> zero_point(scales.size(), 0);
+  return AddQuantizationParams(scales, zero_point, channel_dim_index,
+                               uint8_buffer, final_buffer.size(),
+                               TensorType_INT4, model, tensor, error_reporter);
+}
+
 template <class BiasType>
 std::vector<BiasType> SymmetricBiasQuantize(const float* data,
                                             uint64_t num_elements,
@@ -60,12 +60,15 @@ TfLiteStatus FillPerChannelMinMax(const float* const input,
 //   channels.
 // - output_value is the output data, the size of which equals the number of
 //   inputs.
+// - type selects the range of the quantized values, int4 ones are in [-7, 7]
+//   and still stored one per int8_t.
 TfLiteStatus SymmetricPerChannelQuantization(TensorT* tensor,
                                              const float* const input,
                                              int32_t channel_dim_index,
                                              std::vector<float>* output_scales,
                                              std::vector<int8_t>* output_value,
-                                             ErrorReporter* error_reporter);
+                                             ErrorReporter* error_reporter,
+                                             TfLiteType type = kTfLiteNoType);
 
 // Quantize the values given an array of scales.
 void SymmetricPerChannelQuantizeValues(const float* const input,
@@ -109,6 +112,11 @@ TfLiteStatus SymmetricQuantizeTensorPerChannel(ModelT* model, TensorT* tensor,
                                                int32_t channel_dim_index,
                                                ErrorReporter* error_reporter);
 
+// Quantizes tensor with per channel to int4, packed two values per byte.
+TfLiteStatus SymmetricQuantizeTensorPerChannelInt4(
+    ModelT* model, TensorT* tensor, int32_t channel_dim_index,
+    ErrorReporter* error_reporter);
+
 // Symmetrically quantizes float to 16bits.
 TfLiteStatus SymmetricQuantizeFloatsToInt16(ModelT* model, TensorT* tensor,
                                             float scaling_factor,
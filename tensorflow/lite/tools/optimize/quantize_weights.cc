@@ -595,6 +595,127 @@ TfLiteStatus QuantizeWeightsFloat16(flatbuffers::FlatBufferBuilder* builder,
   FinishModelBuffer(*builder, output_model_location);
   return kTfLiteOk;
 }
+
+// Returns the dimension of the output channels of the weights of `op` if the
+// op has a hybrid kernel for int4 weights, -1 otherwise. The weights must be
+// input 1 and their accumulation depth must be even, so that the rows of the
+// packed tensor are byte aligned.
+int GetInt4WeightsChannelDim(const ModelT* model, const SubGraphT* subgraph,
+                             const OperatorT* op) {
+  if (op->inputs.size() < 2 || op->inputs[1] < 0) {
+    return -1;
+  }
+  const TensorT* weights = subgraph->tensors[op->inputs[1]].get();
+  const std::vector<int32_t>& shape = weights->shape;
+  const int rank = shape.size();
+  const BuiltinOperator op_code =
+      GetBuiltinCode(model->operator_codes[op->opcode_index].get());
+  int channel_dim = -1;
+  int accum_depth = 0;
+  if (op_code == BuiltinOperator_FULLY_CONNECTED) {
+    const FullyConnectedOptionsT* options =
+        op->builtin_options.AsFullyConnectedOptions();
+    if (rank == 2 && (options == nullptr ||
+                      options->weights_format ==
+                          FullyConnectedOptionsWeightsFormat_DEFAULT)) {
+      channel_dim = 0;
+      accum_depth = shape[1];
+    }
+  } else if (op_code == BuiltinOperator_CONV_2D) {
+    if (rank == 4) {
+      channel_dim = 0;
+      accum_depth = shape[1] * shape[2] * shape[3];
+    }
+  } else if (op_code == BuiltinOperator_BATCH_MATMUL) {
+    const BatchMatMulOptionsT* options =
+        op->builtin_options.AsBatchMatMulOptions();
+    const bool adj_y = options != nullptr && options->adj_y;
+    if (rank >= 2 &&
+        std::all_of(shape.begin(), shape.end() - 2,
+                    [](int32_t dim) { return dim == 1; })) {
+      channel_dim = adj_y ? rank - 2 : rank - 1;
+      accum_depth = adj_y ? shape[rank - 1] : shape[rank - 2];
+    }
+  }
+  if (channel_dim < 0 || accum_depth % 2 != 0) {
+    return -1;
+  }
+  return channel_dim;
+}
+
+// Quantizes the weights of the ops that have int4 hybrid kernels to per-channel
+// int4. Weights that are consumed by any other op, or that are a subgraph
+// output, are left in float: there is no int4 Dequantize to feed those from.
+TfLiteStatus QuantizeWeightsInt4(flatbuffers::FlatBufferBuilder* builder,
+                                 const Model* input_model,
+                                 uint64_t weights_min_num_elements) {
+  std::unique_ptr<ModelT> model;
+  model.reset(input_model->UnPack());
+
+  for (int subgraph_index = 0, end = model->subgraphs.size();
+       subgraph_index < end; ++subgraph_index) {
+    SubGraphT* subgraph = model->subgraphs.at(subgraph_index).get();
+
+    absl::flat_hash_map<int32_t, TensorPerChannel> tensor_map;
+    for (int i = 0, sub_end = subgraph->operators.size(); i < sub_end; ++i) {
+      const OperatorT* op = subgraph->operators[i].get();
+      const int channel_dim =
+          GetInt4WeightsChannelDim(model.get(), subgraph, op);
+      if (channel_dim < 0) {
+        continue;
+      }
+      const int32_t tensor_idx = op->inputs[1];
+      TensorT* tensor = subgraph->tensors[tensor_idx].get();
+      if (tensor->type != TensorType_FLOAT32 || tensor->sparsity) {
+        continue;
+      }
+      uint64_t num_elements;
+      TF_LITE_ENSURE_STATUS(utils::NumElements(*tensor, &num_elements));
+      if (num_elements < weights_min_num_elements) {
+        LOG(INFO) << "Skipping quantization of tensor " << tensor->name
+                  << " because it has fewer than " << weights_min_num_elements
+                  << " elements (" << num_elements << ").";
+        continue;
+      }
+      if (model->buffers[tensor->buffer]->data.data() == nullptr) {
+        continue;
+      }
+      tensor_map.insert(
+          {tensor_idx, {tensor, /*is_per_channel=*/true, channel_dim}});
+    }
+
+    for (const auto& tensor_pair : tensor_map) {
+      const int32_t tensor_idx = tensor_pair.first;
+      const TensorPerChannel& weights = tensor_pair.second;
+      bool all_consumers_int4 =
+          std::find(subgraph->outputs.begin(), subgraph->outputs.end(),
+                    tensor_idx) == subgraph->outputs.end();
+      for (const ConsumerOpInfo& consumer :
+           GetTensorConsumers(model.get(), subgraph, tensor_idx)) {
+        if (consumer.op_input_idx != 1 ||
+            GetInt4WeightsChannelDim(model.get(), subgraph, consumer.op) !=
+                weights.channel_dim) {
+          all_consumers_int4 = false;
+        }
+      }
+      if (!all_consumers_int4) {
+        LOG(INFO) << "Skipping int4 quantization of tensor " << weights.t->name
+                  << " because it is used by an op without an int4 kernel.";
+        continue;
+      }
+      TF_LITE_ENSURE_STATUS(utils::SymmetricQuantizeTensorPerChannelInt4(
+          model.get(), weights.t, weights.channel_dim, nullptr));
+    }
+  }
+
+  // The int4 weights run on the same hybrid kernels as the int8 ones.
+  UpdateInt8OperatorVersions(model.get(), /*use_updated_hybrid_scheme=*/true);
+
+  flatbuffers::Offset<Model> output_model_location =
+      Model::Pack(*builder, model.get());
+  FinishModelBuffer(*builder, output_model_location);
+  return kTfLiteOk;
+}
 }  // namespace
 
 namespace internal {
@@ -636,7 +757,10 @@ TfLiteStatus QuantizeWeights(flatbuffers::FlatBufferBuilder* builder,
                              QuantizerType quantizer_type) {
   // By default we require that only weights with more than
   // kWeightsMinSizeDefault elements are quantized.
-  if (quantizer_type == QuantizerType::MLIR_QUANTIZER) {
+  // The MLIR quantizer has no int4 weights, those always go through the
+  // quantizer below.
+  if (quantizer_type == QuantizerType::MLIR_QUANTIZER &&
+      quant_type != BufferType::QUANTIZED_INT4) {
     return mlir::lite::QuantizeWeights(builder, input_model,
                                        (mlir::lite::BufferType)quant_type,
                                        use_updated_hybrid_scheme);
@@ -650,6 +774,9 @@ TfLiteStatus QuantizeWeights(flatbuffers::FlatBufferBuilder* builder,
     }
     case BufferType::QUANTIZED_FLOAT16:
       return QuantizeWeightsFloat16(builder, input_model);
+    case BufferType::QUANTIZED_INT4:
+      return QuantizeWeightsInt4(builder, input_model,
+                                 kWeightsMinNumElementsDefault);
   }
 }
 
@@ -30,8 +30,10 @@ namespace tflite {
 namespace optimize {
 using absl::flat_hash_set;
 
-// Supported resulting types from quantization process.
-enum class BufferType { QUANTIZED_INT8, QUANTIZED_FLOAT16 };
+// Supported resulting types from quantization process. QUANTIZED_INT4 only
+// quantizes the weights of FULLY_CONNECTED, CONV_2D and BATCH_MATMUL, per
+// output channel, and leaves all other tensors in float.
+enum class BufferType { QUANTIZED_INT8, QUANTIZED_FLOAT16, QUANTIZED_INT4 };
 enum class QuantizerType { OLD_QUANTIZER, MLIR_QUANTIZER };
 
 // Stores information about how to quantize a user-specified custom operation.
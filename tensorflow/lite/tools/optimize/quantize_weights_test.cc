@@ -17,6 +17,9 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -62,6 +65,57 @@ std::unique_ptr<FlatBufferModel> ReadCustomOpTestModel() {
   return FlatBufferModel::BuildFromFile(model_path.c_str());
 }
 
+// Serializes into `builder` a model with a single FULLY_CONNECTED op, whose
+// [units, depth] weights have a range of 7 * (row + 1) in each row.
+const Model* BuildFullyConnectedModel(int units, int depth,
+                                      flatbuffers::FlatBufferBuilder* builder) {
+  auto model = std::make_unique<ModelT>();
+  model->version = 3;
+  auto op_code = std::make_unique<OperatorCodeT>();
+  op_code->builtin_code = BuiltinOperator_FULLY_CONNECTED;
+  op_code->deprecated_builtin_code = BuiltinOperator_FULLY_CONNECTED;
+  op_code->version = 1;
+  model->operator_codes.push_back(std::move(op_code));
+
+  std::vector<float> weights(units * depth);
+  for (int i = 0; i < units * depth; ++i) {
+    weights[i] = static_cast<float>(((i * 7) % 15 - 7) * (i / depth + 1));
+  }
+  model->buffers.push_back(std::make_unique<BufferT>());
+  auto weights_buffer = std::make_unique<BufferT>();
+  const uint8_t* weights_bytes =
+      reinterpret_cast<const uint8_t*>(weights.data());
+  weights_buffer->data.assign(weights_bytes,
+                              weights_bytes + weights.size() * sizeof(float));
+  model->buffers.push_back(std::move(weights_buffer));
+
+  auto subgraph = std::make_unique<SubGraphT>();
+  const std::vector<std::pair<std::string, std::vector<int32_t>>> tensors = {
+      {"input", {1, depth}},
+      {"weights", {units, depth}},
+      {"output", {1, units}}};
+  for (const auto& name_and_shape : tensors) {
+    auto tensor = std::make_unique<TensorT>();
+    tensor->name = name_and_shape.first;
+    tensor->shape = name_and_shape.second;
+    tensor->type = TensorType_FLOAT32;
+    tensor->buffer = tensor->name == "weights" ? 1 : 0;
+    subgraph->tensors.push_back(std::move(tensor));
+  }
+  auto op = std::make_unique<OperatorT>();
+  op->opcode_index = 0;
+  op->inputs = {0, 1, -1};
+  op->outputs = {2};
+  op->builtin_options.Set(FullyConnectedOptionsT());
+  subgraph->operators.push_back(std::move(op));
+  subgraph->inputs = {0};
+  subgraph->outputs = {2};
+  model->subgraphs.push_back(std::move(subgraph));
+
+  FinishModelBuffer(*builder, Model::Pack(*builder, model.get()));
+  return GetModel(builder->GetBufferPointer());
+}
+
 template <typename T>
 std::vector<T> GetAsVector(const flatbuffers::Vector<T>* vec) {
   return std::vector<T>(vec->begin(), vec->end());
@@ -668,6 +722,70 @@ TEST_F(QuantizeWeightsTest, DequantizeConvBlocklisted) {
   }
 }
 
+TEST_F(QuantizeWeightsTest, Int4FullyConnected) {
+  const int units = 4;
+  const int depth = 512;
+  flatbuffers::FlatBufferBuilder float_builder;
+  model_ = BuildFullyConnectedModel(units, depth, &float_builder);
+  flatbuffers::FlatBufferBuilder builder;
+  auto status = QuantizeWeights(&builder, model_, BufferType::QUANTIZED_INT4,
+                                kUseUpdatedHybridSchemeDefault,
+                                QuantizerType::OLD_QUANTIZER);
+  EXPECT_EQ(status, kTfLiteOk);
+
+  const uint8_t* buffer = builder.GetBufferPointer();
+  const Model* output_model = GetModel(buffer);
+  ASSERT_TRUE(output_model);
+  const auto quantized_graph = output_model->subgraphs()->Get(0);
+  // The weights are consumed by the hybrid kernel, no dequantize is needed.
+  ASSERT_EQ(quantized_graph->operators()->size(), 1);
+  EXPECT_EQ(output_model->operator_codes()->Get(0)->version(), 9);
+
+  const auto weights = quantized_graph->tensors()->Get(1);
+  EXPECT_EQ(quantized_graph->tensors()->Get(0)->type(), TensorType_FLOAT32);
+  EXPECT_EQ(quantized_graph->tensors()->Get(2)->type(), TensorType_FLOAT32);
+  ASSERT_EQ(weights->type(), TensorType_INT4);
+  EXPECT_EQ(weights->quantization()->quantized_dimension(), 0);
+  ASSERT_EQ(weights->quantization()->scale()->size(), units);
+  for (int row = 0; row < units; ++row) {
+    EXPECT_FLOAT_EQ(weights->quantization()->scale()->Get(row), row + 1);
+    EXPECT_EQ(weights->quantization()->zero_point()->Get(row), 0);
+  }
+
+  // Two values per byte, the even one in the low nibble.
+  const auto data = output_model->buffers()->Get(weights->buffer())->data();
+  ASSERT_EQ(data->size(), units * depth / 2);
+  for (int i = 0; i < units * depth; ++i) {
+    const int8_t byte = static_cast<int8_t>(data->Get(i / 2));
+    const int8_t value = i % 2 == 0 ? static_cast<int8_t>(byte << 4) >> 4
+                                    : byte >> 4;
+    EXPECT_EQ(value, (i * 7) % 15 - 7) << i;
+  }
+}
+
+TEST_F(QuantizeWeightsTest, Int4ConvWithOddDepthStaysFloat) {
+  LoadBasicModel();
+  flatbuffers::FlatBufferBuilder builder;
+  auto status = QuantizeWeights(&builder, model_, BufferType::QUANTIZED_INT4,
+                                kUseUpdatedHybridSchemeDefault,
+                                QuantizerType::OLD_QUANTIZER);
+  EXPECT_EQ(status, kTfLiteOk);
+
+  const uint8_t* buffer = builder.GetBufferPointer();
+  const Model* output_model = GetModel(buffer);
+  ASSERT_TRUE(output_model);
+
+  // The [5, 3, 3, 3] filter is below the default size threshold and has an
+  // odd depth of 27, so the model is left unchanged.
+  const auto quantized_graph = output_model->subgraphs()->Get(0);
+  const auto float_graph = model_->subgraphs()->Get(0);
+  ASSERT_EQ(quantized_graph->operators()->size(), 1);
+  ASSERT_EQ(quantized_graph->tensors()->size(), float_graph->tensors()->size());
+  for (size_t i = 0; i < quantized_graph->tensors()->size(); i++) {
+    EXPECT_EQ(quantized_graph->tensors()->Get(i)->type(), TensorType_FLOAT32);
+  }
+}
+
 }  // namespace
 }  // namespace optimize
 }  // namespace tflite
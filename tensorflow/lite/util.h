@@ -24,6 +24,7 @@ limitations under the License.
 #include <stddef.h>
 #include <stdlib.h>
 
+#include <cstring>
 #include <initializer_list>
 #include <memory>
 #include <string>
@@ -97,6 +98,23 @@ bool IsValidationSubgraph(const char* name);
 // is not 8.
 TfLiteStatus MultiplyAndCheckOverflow(size_t a, size_t b, size_t* product);
 
+// Appends the in-memory representation of `value` to `buffer`. Used for
+// simple binary formats which are read back on the same platform.
+template <typename T>
+void AppendToBuffer(T value, std::string* buffer) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads a value written by `AppendToBuffer()` at `*pos` in `buffer`, and
+// advances `*pos` past it. Returns false if `buffer` is too short.
+template <typename T>
+bool ReadFromBuffer(const std::string& buffer, size_t* pos, T* value) {
+  if (*pos > buffer.size() || buffer.size() - *pos < sizeof(T)) return false;
+  std::memcpy(value, buffer.data() + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return true;
+}
+
 // Returns whether the TfLiteTensor is a resource or variant tensor.
 inline bool IsResourceOrVariant(const TfLiteTensor* tensor) {
   return tensor->type == kTfLiteResource || tensor->type == kTfLiteVariant;